@@ -6,6 +6,8 @@
 
 #include "DepthMapEstimator.hpp"
 
+#include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
@@ -14,6 +16,11 @@
 #include <aliceVision/depthMap/depthMapUtils.hpp>
 #include <aliceVision/depthMap/DepthMapParams.hpp>
 #include <aliceVision/depthMap/SgmDepthList.hpp>
+#include <aliceVision/depthMap/cpu/CpuMipmapImage.hpp>
+#include <aliceVision/depthMap/cpu/CpuSgm.hpp>
+#include <aliceVision/depthMap/cpu/CpuRefine.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
 #include <aliceVision/depthMap/Sgm.hpp>
 #include <aliceVision/depthMap/Refine.hpp>
 #include <aliceVision/depthMap/cuda/host/utils.hpp>
@@ -21,9 +28,15 @@
 #include <aliceVision/depthMap/cuda/host/DeviceCache.hpp>
 #include <aliceVision/depthMap/cuda/host/DeviceStreamManager.hpp>
 #include <aliceVision/depthMap/cuda/planeSweeping/deviceDepthSimilarityMap.hpp>
+#endif
 
 #include <boost/filesystem.hpp>
 
+#include <cmath>
+#include <map>
+#include <memory>
+#include <set>
+
 namespace fs = boost::filesystem;
 
 namespace aliceVision {
@@ -60,6 +73,75 @@ DepthMapEstimator::DepthMapEstimator(const mvsUtils::MultiViewParams& mp,
                          << "\t- stepXY: " <<_refineParams.stepXY);
 }
 
+void DepthMapEstimator::getTilesList(const std::vector<int>& cams, std::vector<Tile>& tiles) const
+{
+    const int nbTilesPerCamera = _tileRoiList.size();
+
+    // tiles list should be empty
+    assert(tiles.empty());
+
+    // reserve memory
+    tiles.reserve(cams.size() * nbTilesPerCamera);
+
+    for (int rc : cams)
+    {
+        // get R camera Tcs list
+        const std::vector<int> tCams = _mp.findNearestCamsFromLandmarks(rc, _depthMapParams.maxTCams).getDataWritable();
+
+        // get R camera ROI
+        const ROI rcImageRoi(Range(0, _mp.getWidth(rc)), Range(0, _mp.getHeight(rc)));
+
+        for (std::size_t i = 0;  i < nbTilesPerCamera; ++i)
+        {
+            Tile t;
+
+            t.id = i;
+            t.nbTiles = nbTilesPerCamera;
+            t.rc = rc;
+            t.roi = intersect(_tileRoiList.at(i), rcImageRoi);
+
+            if (t.roi.isEmpty())
+            {
+                // do nothing, this ROI cannot intersect the R camera ROI.
+            }
+            else if (_depthMapParams.chooseTCamsPerTile)
+            {
+                // find nearest T cameras per tile
+                t.sgmTCams = _mp.findTileNearestCams(rc, _sgmParams.maxTCamsPerTile, tCams, t.roi);
+
+                if (_depthMapParams.useRefine)
+                    t.refineTCams = _mp.findTileNearestCams(rc, _refineParams.maxTCamsPerTile, tCams, t.roi);
+            }
+            else
+            {
+                // use previously selected T cameras from the entire image
+                t.sgmTCams = tCams;
+                t.refineTCams = tCams;
+            }
+
+            tiles.push_back(t);
+        }
+    }
+}
+
+void DepthMapEstimator::compute(int cudaDeviceId, const std::vector<int>& cams)
+{
+    // computation on CPU requested
+    if (cudaDeviceId == ALICEVISION_DEPTHMAP_CPU_DEVICE_ID)
+    {
+        computeOnCpu(cams);
+        return;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    computeOnGpu(cudaDeviceId, cams);
+#else
+    ALICEVISION_THROW_ERROR("Cannot compute depth maps on CUDA device " << cudaDeviceId << ", AliceVision is built without CUDA.");
+#endif
+}
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+
 int DepthMapEstimator::getNbSimultaneousTiles() const
 {
     const int nbTilesPerCamera = _tileRoiList.size();
@@ -178,58 +260,7 @@ int DepthMapEstimator::getNbSimultaneousTiles() const
     return out_nbSimultaneousTiles;
 }
 
-void DepthMapEstimator::getTilesList(const std::vector<int>& cams, std::vector<Tile>& tiles) const
-{
-    const int nbTilesPerCamera = _tileRoiList.size();
-
-    // tiles list should be empty
-    assert(tiles.empty());
-
-    // reserve memory
-    tiles.reserve(cams.size() * nbTilesPerCamera);
-
-    for (int rc : cams)
-    {
-        // get R camera Tcs list
-        const std::vector<int> tCams = _mp.findNearestCamsFromLandmarks(rc, _depthMapParams.maxTCams).getDataWritable();
-
-        // get R camera ROI
-        const ROI rcImageRoi(Range(0, _mp.getWidth(rc)), Range(0, _mp.getHeight(rc)));
-
-        for (std::size_t i = 0;  i < nbTilesPerCamera; ++i)
-        {
-            Tile t;
-
-            t.id = i;
-            t.nbTiles = nbTilesPerCamera;
-            t.rc = rc;
-            t.roi = intersect(_tileRoiList.at(i), rcImageRoi);
-
-            if (t.roi.isEmpty())
-            {
-                // do nothing, this ROI cannot intersect the R camera ROI.
-            }
-            else if (_depthMapParams.chooseTCamsPerTile)
-            {
-                // find nearest T cameras per tile
-                t.sgmTCams = _mp.findTileNearestCams(rc, _sgmParams.maxTCamsPerTile, tCams, t.roi);
-
-                if (_depthMapParams.useRefine)
-                    t.refineTCams = _mp.findTileNearestCams(rc, _refineParams.maxTCamsPerTile, tCams, t.roi);
-            }
-            else
-            {
-                // use previously selected T cameras from the entire image
-                t.sgmTCams = tCams;
-                t.refineTCams = tCams;
-            }
-
-            tiles.push_back(t);
-        }
-    }
-}
-
-void DepthMapEstimator::compute(int cudaDeviceId, const std::vector<int>& cams)
+void DepthMapEstimator::computeOnGpu(int cudaDeviceId, const std::vector<int>& cams)
 {
     // set the device to use for GPU executions
     // the CUDA runtime API is thread-safe, it maintains per-thread state about the current device
@@ -519,6 +550,153 @@ void DepthMapEstimator::compute(int cudaDeviceId, const std::vector<int>& cams)
     sgmPerStream.clear();
     refinePerStream.clear();
 }
+#endif // ALICEVISION_HAVE_CUDA
+
+void DepthMapEstimator::computeOnCpu(const std::vector<int>& cams)
+{
+    ALICEVISION_LOG_INFO("Depth map estimation on CPU (" << omp_get_max_threads() << " threads).");
+
+    if (_sgmParams.useCustomPatchPattern || _refineParams.useCustomPatchPattern)
+        ALICEVISION_LOG_WARNING("Custom patch pattern is not supported on CPU, use the default patch.");
+
+    if (_refineParams.useSgmNormalMap)
+        ALICEVISION_LOG_WARNING("SGM normal map is not supported on CPU, it will be ignored.");
+
+    if (_sgmParams.exportIntermediateDepthSimMaps || _sgmParams.exportIntermediateNormalMaps ||
+        _sgmParams.exportIntermediateVolumes || _sgmParams.exportIntermediateCrossVolumes ||
+        _refineParams.exportIntermediateDepthSimMaps || _refineParams.exportIntermediateNormalMaps ||
+        _refineParams.exportIntermediateCrossVolumes || _refineParams.exportIntermediateVolume9pCsv)
+        ALICEVISION_LOG_WARNING("Intermediate results export is not supported on CPU, it will be ignored.");
+
+    // initialize RAM image cache
+    mvsUtils::ImagesCache<image::Image<image::RGBAfColor>> ic(_mp, image::EImageColorSpace::LINEAR);
+
+    // build tile list order by R camera
+    std::vector<Tile> tiles;
+    getTilesList(cams, tiles);
+
+    // single Sgm and Refine objects in host memory, tiles are computed sequentially
+    CpuSgm sgm(_mp, _tileParams, _sgmParams, !_depthMapParams.useRefine /* computeDepthSimMap */);
+    std::unique_ptr<CpuRefine> refinePtr;
+
+    if (_depthMapParams.useRefine)
+        refinePtr.reset(new CpuRefine(_mp, _tileParams, _refineParams));
+
+    ALICEVISION_LOG_INFO("Host memory per tile computation: "
+                         << (sgm.getMemoryConsumption() + (refinePtr ? refinePtr->getMemoryConsumption() : 0.0)) << " MB");
+
+    const int nbTilesPerCamera = static_cast<int>(_tileRoiList.size());
+    const int minMipmapDownscale = std::min(_refineParams.scale, _sgmParams.scale);
+    const int maxMipmapDownscale = std::max(_refineParams.scale, _sgmParams.scale)
+                                   * std::pow(2, 6);  // we add 6 downscale levels
+
+    for (std::size_t firstTileIndex = 0; firstTileIndex < tiles.size(); firstTileIndex += nbTilesPerCamera)
+    {
+        const int rc = tiles.at(firstTileIndex).rc;
+
+        // load R and all tiles T cameras mipmap images
+        std::map<int, CpuMipmapImage> mipmapImages;
+        {
+            std::set<int> camsToLoad = {rc};
+
+            for (int i = 0; i < nbTilesPerCamera; ++i)
+            {
+                const Tile& tile = tiles.at(firstTileIndex + i);
+                camsToLoad.insert(tile.sgmTCams.begin(), tile.sgmTCams.end());
+                camsToLoad.insert(tile.refineTCams.begin(), tile.refineTCams.end());
+            }
+
+            for (const int camId : camsToLoad)
+            {
+                mvsUtils::ImagesCache<image::Image<image::RGBAfColor>>::ImgSharedPtr img = ic.getImg_sync(camId);
+                mipmapImages[camId].fill(*img, minMipmapDownscale, maxMipmapDownscale);
+            }
+        }
+
+        // final depth/similarity map tile list and tile min/max depth
+        std::vector<CpuMap<Vec2f>> depthSimMapTiles(nbTilesPerCamera);
+        std::vector<std::pair<float, float>> depthMinMaxTiles(nbTilesPerCamera);
+
+        for (int i = 0; i < nbTilesPerCamera; ++i)
+        {
+            Tile& tile = tiles.at(firstTileIndex + i);
+            CpuMap<Vec2f>& tileDepthSimMap = depthSimMapTiles.at(tile.id);
+
+            // do not compute empty ROI
+            // some images in the dataset may be smaller than others
+            if (tile.roi.isEmpty())
+                continue;
+
+            // default depth/sim map: invalid depth
+            {
+                const int scaleStep = (_depthMapParams.useRefine) ? (_refineParams.scale * _refineParams.stepXY)
+                                                                  : (_sgmParams.scale * _sgmParams.stepXY);
+                const ROI downscaledRoi = downscaleROI(tile.roi, scaleStep);
+                tileDepthSimMap.allocate(int(downscaledRoi.width()), int(downscaledRoi.height()), Vec2f(-1.f, 1.f));
+            }
+
+            // check T cameras
+            if (tile.sgmTCams.empty() || (_depthMapParams.useRefine && tile.refineTCams.empty()))  // no T camera found
+                continue;
+
+            // build tile SGM depth list
+            SgmDepthList sgmDepthList(_mp, _sgmParams, tile);
+
+            // compute the R camera depth list
+            sgmDepthList.computeListRc();
+
+            // check number of depths
+            if (sgmDepthList.getDepths().empty())  // no depth found
+            {
+                depthMinMaxTiles.at(tile.id) = {0.f, 0.f};
+                continue;
+            }
+
+            // remove T cameras with no depth found.
+            sgmDepthList.removeTcWithNoDepth(tile);
+
+            // store min/max depth
+            depthMinMaxTiles.at(tile.id) = sgmDepthList.getMinMaxDepths();
+
+            // log debug camera / depth information
+            sgmDepthList.logRcTcDepthInformation();
+
+            // check if starting and stopping depth are valid
+            sgmDepthList.checkStartingAndStoppingDepth();
+
+            // compute Semi-Global Matching
+            sgm.sgmRc(tile, sgmDepthList, mipmapImages);
+
+            // get the final depth/similarity map of the tile
+            const CpuMap<Vec2f>* resultDepthSimMap = &sgm.getDepthSimMap();
+
+            if (_depthMapParams.useRefine)
+            {
+                // smooth SGM thickness map
+                // in order to be a proper Refine input parameter
+                sgm.smoothThicknessMap(tile, _refineParams);
+
+                // compute Refine
+                refinePtr->refineRc(tile, sgm.getDepthThicknessMap(), mipmapImages);
+                resultDepthSimMap = &refinePtr->getDepthSimMap();
+            }
+
+            // copy the tile ROI part of the result
+            for (int y = 0; y < tileDepthSimMap.getHeight(); ++y)
+                for (int x = 0; x < tileDepthSimMap.getWidth(); ++x)
+                    tileDepthSimMap(x, y) = (*resultDepthSimMap)(x, y);
+        }
+
+        // write depth/sim map result
+        if (_depthMapParams.useRefine)
+            writeDepthSimMapFromTileList(rc, _mp, _tileParams, _tileRoiList, depthSimMapTiles, _refineParams.scale, _refineParams.stepXY);
+        else
+            writeDepthSimMapFromTileList(rc, _mp, _tileParams, _tileRoiList, depthSimMapTiles, _sgmParams.scale, _sgmParams.stepXY);
+
+        if (_depthMapParams.exportTilePattern)
+            exportDepthSimMapTilePatternObj(rc, _mp, _tileRoiList, depthMinMaxTiles);
+    }
+}
 
 }  // namespace depthMap
 }  // namespace aliceVision
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <aliceVision/config.hpp>
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 #include <aliceVision/mvsUtils/TileParams.hpp>
 #include <aliceVision/depthMap/DepthMapParams.hpp>
@@ -53,7 +54,7 @@ public:
 
     /**
      * @brief Compute depth/similarity maps of the given cameras.
-     * @param[in] cudaDeviceId the CUDA device id
+     * @param[in] cudaDeviceId the CUDA device id (or ALICEVISION_DEPTHMAP_CPU_DEVICE_ID)
      * @param[in] cams the list of cameras
      */
     void compute(int cudaDeviceId, const std::vector<int>& cams) override;
@@ -62,6 +63,7 @@ private:
 
     // private methods
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     /**
      * @brief Compute the maximum number of tiles (volumes, buffer, images, ...)
      *        that fit in GPU memory and can be computed simultaneously.
@@ -69,6 +71,14 @@ private:
      */
     int getNbSimultaneousTiles() const;
 
+    /**
+     * @brief Compute depth/similarity maps of the given cameras on the given CUDA device.
+     * @param[in] cudaDeviceId the CUDA device id
+     * @param[in] cams the list of cameras
+     */
+    void computeOnGpu(int cudaDeviceId, const std::vector<int>& cams);
+#endif
+
     /**
      * @brief Build tile list from the given cameras.
      * @param[in] cams the list of cameras
@@ -76,6 +86,13 @@ private:
      */
     void getTilesList(const std::vector<int>& cams, std::vector<Tile>& tiles) const;
 
+    /**
+     * @brief Compute depth/similarity maps of the given cameras on CPU.
+     * @note Tiles are computed sequentially, each computation step is multithreaded.
+     * @param[in] cams the list of cameras
+     */
+    void computeOnCpu(const std::vector<int>& cams);
+
     // private members
 
     const mvsUtils::MultiViewParams& _mp;      //< multi-view parameters
@@ -28,6 +28,10 @@ NormalMapEstimator::NormalMapEstimator(const mvsUtils::MultiViewParams &mp)
 
 void NormalMapEstimator::compute(int cudaDeviceId, const std::vector<int>& cams)
 {
+    // normal map estimation is only available on GPU
+    if(cudaDeviceId == ALICEVISION_DEPTHMAP_CPU_DEVICE_ID)
+        ALICEVISION_THROW_ERROR("Normal map estimation is not available on CPU, a CUDA device is required.");
+
     // set the device to use for GPU executions
     // the CUDA runtime API is thread-safe, it maintains per-thread state about the current device 
     setCudaDeviceId(cudaDeviceId);
@@ -6,19 +6,43 @@
 
 #include "computeOnMultiGPUs.hpp"
 
+#include <aliceVision/config.hpp>
 #include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
 #include <aliceVision/depthMap/cuda/host/utils.hpp>
+#endif
 
 namespace aliceVision {
 namespace depthMap {
 
 void computeOnMultiGPUs(const std::vector<int>& cams, IGPUJob& gpujob, int nbGPUsToUse)
 {
-    const int nbGPUDevices = listCudaDevices();
     const int nbCPUThreads = omp_get_max_threads();
 
+    if(nbGPUsToUse < 0)
+    {
+        ALICEVISION_LOG_INFO("Computation on CPU requested, number of CPU threads: " << nbCPUThreads);
+        gpujob.compute(ALICEVISION_DEPTHMAP_CPU_DEVICE_ID, cams);
+        return;
+    }
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    const int nbGPUDevices = listCudaDevices();
+#else
+    const int nbGPUDevices = 0;  // built without CUDA
+#endif
+
     ALICEVISION_LOG_INFO("Number of GPU devices: " << nbGPUDevices << ", number of CPU threads: " << nbCPUThreads);
 
+    if(nbGPUDevices < 1)
+    {
+        ALICEVISION_LOG_WARNING("No CUDA device available, fall back to computation on CPU.");
+        gpujob.compute(ALICEVISION_DEPTHMAP_CPU_DEVICE_ID, cams);
+        return;
+    }
+
     int nbThreads = std::min(nbGPUDevices, nbCPUThreads);
 
     if (nbGPUsToUse > 0)
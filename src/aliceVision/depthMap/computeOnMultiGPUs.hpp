@@ -11,6 +11,11 @@
 namespace aliceVision {
 namespace depthMap {
 
+/*
+ * @note Device id used to request the computation on the CPU (host memory, OpenMP threads).
+ */
+#define ALICEVISION_DEPTHMAP_CPU_DEVICE_ID -1
+
 /**
  * @class IGPUJob
  * @brief Interface for multi-GPUs computation.
@@ -21,7 +26,7 @@ public:
 
     /**
      * @brief Perform computation from the given cameras.
-     * @param[in] cudaDeviceId the CUDA device id
+     * @param[in] cudaDeviceId the CUDA device id (or ALICEVISION_DEPTHMAP_CPU_DEVICE_ID)
      * @param[in] cams the list of cameras
      */
     virtual void compute(int cudaDeviceId, const std::vector<int>& cams) = 0;
@@ -29,9 +34,11 @@ public:
 
 /**
  * @brief Perform computation from the given cameras on multiple GPUs.
+ * @note Fall back to the CPU device if no CUDA device is available (or AliceVision is built without CUDA)
+ *       or if nbGPUsToUse is negative.
  * @param[in] cams the given list of cameras
  * @param[in,out] gpujob the object that wrap computation (should use IGPUJob interface)
- * @param[in] nbGPUsToUse the number of GPUs to use
+ * @param[in] nbGPUsToUse the number of GPUs to use (0: all, negative: CPU only)
  */
 void computeOnMultiGPUs(const std::vector<int>& cams, IGPUJob& gpujob, int nbGPUsToUse);
 
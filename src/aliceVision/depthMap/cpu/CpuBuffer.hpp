@@ -0,0 +1,97 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @class CpuMap
+ * @brief Contiguous 2d buffer in host memory (row-major, x is the fastest axis).
+ * @note CPU counterpart of CudaDeviceMemoryPitched<T, 2>.
+ */
+template <typename T>
+class CpuMap
+{
+public:
+
+    CpuMap() = default;
+
+    CpuMap(int width, int height, const T& value = T()) { allocate(width, height, value); }
+
+    void allocate(int width, int height, const T& value = T())
+    {
+        _width = width;
+        _height = height;
+        _data.assign(std::size_t(width) * std::size_t(height), value);
+    }
+
+    void fill(const T& value) { std::fill(_data.begin(), _data.end(), value); }
+
+    inline int getWidth() const { return _width; }
+    inline int getHeight() const { return _height; }
+    inline bool isEmpty() const { return _data.empty(); }
+    inline std::size_t getBytes() const { return _data.size() * sizeof(T); }
+
+    inline T& operator()(int x, int y) { return _data[std::size_t(y) * _width + x]; }
+    inline const T& operator()(int x, int y) const { return _data[std::size_t(y) * _width + x]; }
+
+private:
+
+    std::vector<T> _data;
+    int _width = 0;
+    int _height = 0;
+};
+
+/**
+ * @class CpuVolume
+ * @brief Contiguous 3d buffer in host memory.
+ * @note The depth (z) axis is the fastest axis: each pixel similarity column is contiguous,
+ *       so that per-pixel loops over depths (aggregation, best depth retrieval) are vectorizable.
+ */
+template <typename T>
+class CpuVolume
+{
+public:
+
+    CpuVolume() = default;
+
+    void allocate(int dimX, int dimY, int dimZ, const T& value = T())
+    {
+        _dimX = dimX;
+        _dimY = dimY;
+        _dimZ = dimZ;
+        _data.assign(std::size_t(dimX) * std::size_t(dimY) * std::size_t(dimZ), value);
+    }
+
+    void fill(const T& value) { std::fill(_data.begin(), _data.end(), value); }
+
+    inline int getDimX() const { return _dimX; }
+    inline int getDimY() const { return _dimY; }
+    inline int getDimZ() const { return _dimZ; }
+    inline std::size_t getBytes() const { return _data.size() * sizeof(T); }
+
+    inline T* getColumn(int x, int y) { return &_data[(std::size_t(y) * _dimX + x) * _dimZ]; }
+    inline const T* getColumn(int x, int y) const { return &_data[(std::size_t(y) * _dimX + x) * _dimZ]; }
+
+    inline T& operator()(int x, int y, int z) { return getColumn(x, y)[z]; }
+    inline const T& operator()(int x, int y, int z) const { return getColumn(x, y)[z]; }
+
+private:
+
+    std::vector<T> _data;
+    int _dimX = 0;
+    int _dimY = 0;
+    int _dimZ = 0;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,51 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CpuCameraParams.hpp"
+
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+void fillCpuCameraParams(CpuCameraParams& out_cameraParams, int camId, int downscale, const mvsUtils::MultiViewParams& mp)
+{
+    Matrix3x3 scaleM;
+    scaleM.m11 = 1.0 / double(downscale);
+    scaleM.m12 = 0.0;
+    scaleM.m13 = 0.0;
+    scaleM.m21 = 0.0;
+    scaleM.m22 = 1.0 / double(downscale);
+    scaleM.m23 = 0.0;
+    scaleM.m31 = 0.0;
+    scaleM.m32 = 0.0;
+    scaleM.m33 = 1.0;
+
+    const Matrix3x3 K = scaleM * mp.KArr[camId];
+    const Matrix3x3 iK = K.inverse();
+    const Matrix3x4 P = K * (mp.RArr[camId] | (Point3d(0.0, 0.0, 0.0) - mp.RArr[camId] * mp.CArr[camId]));
+    const Matrix3x3 iP = mp.iRArr[camId] * iK;
+    const Matrix3x3& iR = mp.iRArr[camId];
+
+    out_cameraParams.P << float(P.m11), float(P.m12), float(P.m13), float(P.m14),
+                          float(P.m21), float(P.m22), float(P.m23), float(P.m24),
+                          float(P.m31), float(P.m32), float(P.m33), float(P.m34);
+
+    out_cameraParams.iP << float(iP.m11), float(iP.m12), float(iP.m13),
+                           float(iP.m21), float(iP.m22), float(iP.m23),
+                           float(iP.m31), float(iP.m32), float(iP.m33);
+
+    out_cameraParams.C = Vec3f(float(mp.CArr[camId].x), float(mp.CArr[camId].y), float(mp.CArr[camId].z));
+
+    // camera axes in world coordinates (columns of the inverse rotation)
+    out_cameraParams.XVect = Vec3f(float(iR.m11), float(iR.m21), float(iR.m31)).normalized();
+    out_cameraParams.YVect = Vec3f(float(iR.m12), float(iR.m22), float(iR.m32)).normalized();
+    out_cameraParams.ZVect = Vec3f(float(iR.m13), float(iR.m23), float(iR.m33)).normalized();
+}
+
+} // namespace depthMap
+} // namespace aliceVision
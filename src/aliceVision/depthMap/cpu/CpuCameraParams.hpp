@@ -0,0 +1,40 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @struct CpuCameraParams
+ * @brief Support class to maintain useful camera parameters in host memory.
+ * @note CPU counterpart of DeviceCameraParams.
+ */
+struct CpuCameraParams
+{
+    Eigen::Matrix<float, 3, 4> P;
+    Eigen::Matrix3f iP;
+    Vec3f C;
+    Vec3f XVect;
+    Vec3f YVect;
+    Vec3f ZVect;
+};
+
+/**
+ * @brief Fill the given CPU camera parameters from the multi-view parameters.
+ * @param[out] out_cameraParams the output CPU camera parameters
+ * @param[in] camId the camera index in the multi-view parameters
+ * @param[in] downscale the camera downscale to apply
+ * @param[in] mp the multi-view parameters
+ */
+void fillCpuCameraParams(CpuCameraParams& out_cameraParams, int camId, int downscale, const mvsUtils::MultiViewParams& mp);
+
+} // namespace depthMap
+} // namespace aliceVision
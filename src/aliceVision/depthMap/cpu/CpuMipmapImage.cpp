@@ -0,0 +1,206 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CpuMipmapImage.hpp"
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <cmath>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+/**
+ * @brief Linear RGB (0, 1) to CIELAB (0, 255)
+ * @note same conversion as the CUDA rgb2lab kernel
+ */
+inline void rgb2lab(image::RGBAfColor& inout_color)
+{
+    const float r = inout_color.r();
+    const float g = inout_color.g();
+    const float b = inout_color.b();
+
+    // RGB to XYZ, normalized by whitepoint D65
+    const float x = (0.4124564f * r + 0.3575761f * g + 0.1804375f * b) / 0.95047f;
+    const float y = (0.2126729f * r + 0.7151522f * g + 0.0721750f * b);
+    const float z = (0.0193339f * r + 0.1191920f * g + 0.9503041f * b) / 1.08883f;
+
+    const auto f = [](float t) { return (t > 216.0f / 24389.0f) ? std::cbrt(t) : (24389.0f / 27.0f * t + 16.0f) / 116.0f; };
+
+    const float fx = f(x);
+    const float fy = f(y);
+    const float fz = f(z);
+
+    inout_color.r() = (116.0f * fy - 16.0f) * 2.55f;
+    inout_color.g() = (500.0f * (fx - fy)) * 2.55f;
+    inout_color.b() = (200.0f * (fy - fz)) * 2.55f;
+}
+
+/**
+ * @brief Bilinear sampling with clamp-to-edge addressing mode.
+ * @param[in] img the image to sample
+ * @param[in] x the texel x coordinate (pixel center at 0)
+ * @param[in] y the texel y coordinate (pixel center at 0)
+ */
+inline image::RGBAfColor sampleBilinear(const image::Image<image::RGBAfColor>& img, float x, float y)
+{
+    const int w = img.Width();
+    const int h = img.Height();
+
+    const float fx = std::floor(x);
+    const float fy = std::floor(y);
+    const float ax = x - fx;
+    const float ay = y - fy;
+
+    const int x0 = std::min(std::max(int(fx), 0), w - 1);
+    const int y0 = std::min(std::max(int(fy), 0), h - 1);
+    const int x1 = std::min(std::max(int(fx) + 1, 0), w - 1);
+    const int y1 = std::min(std::max(int(fy) + 1, 0), h - 1);
+
+    const image::RGBAfColor top = img(y0, x0) * (1.f - ax) + img(y0, x1) * ax;
+    const image::RGBAfColor bottom = img(y1, x0) * (1.f - ax) + img(y1, x1) * ax;
+
+    return top * (1.f - ay) + bottom * ay;
+}
+
+/**
+ * @brief Downscale the given image with a gaussian blur.
+ * @param[out] out_img the downscaled image
+ * @param[in] in_img the input image
+ * @param[in] downscale the downscale factor
+ * @param[in] radius the gaussian filter radius (in output pixels, sigma = 1)
+ */
+void downscaleWithGaussianBlur(image::Image<image::RGBAfColor>& out_img,
+                               const image::Image<image::RGBAfColor>& in_img,
+                               int downscale,
+                               int radius)
+{
+    const int outWidth  = divideRoundUp(in_img.Width(), downscale);
+    const int outHeight = divideRoundUp(in_img.Height(), downscale);
+
+    out_img.resize(outWidth, outHeight);
+
+    std::vector<float> gaussian(2 * radius + 1);
+    for(int i = -radius; i <= radius; ++i)
+        gaussian[i + radius] = std::exp(-float(i * i) / 2.f);
+
+#pragma omp parallel for
+    for(int y = 0; y < outHeight; ++y)
+    {
+        for(int x = 0; x < outWidth; ++x)
+        {
+            // output pixel center in input texel coordinates
+            const float cx = (float(x) + 0.5f) * float(downscale) - 0.5f;
+            const float cy = (float(y) + 0.5f) * float(downscale) - 0.5f;
+
+            image::RGBAfColor sumColor(0.f, 0.f, 0.f, 0.f);
+            float sumFactor = 0.f;
+
+            for(int i = -radius; i <= radius; ++i)
+            {
+                for(int j = -radius; j <= radius; ++j)
+                {
+                    const float factor = gaussian[i + radius] * gaussian[j + radius];
+                    sumColor += sampleBilinear(in_img, cx + float(j * downscale), cy + float(i * downscale)) * factor;
+                    sumFactor += factor;
+                }
+            }
+
+            out_img(y, x) = sumColor / sumFactor;
+        }
+    }
+}
+
+} // namespace
+
+void CpuMipmapImage::fill(const image::Image<image::RGBAfColor>& in_img, int minDownscale, int maxDownscale)
+{
+    // update private members
+    _minDownscale = minDownscale;
+    _maxDownscale = maxDownscale;
+    _width  = in_img.Width();
+    _height = in_img.Height();
+
+    const int nbLevels = int(std::log2(maxDownscale / minDownscale)) + 1;
+
+    _levels.clear();
+    _levels.resize(nbLevels);
+
+    // first level: downscale input image to min downscale
+    image::Image<image::RGBAfColor>& firstLevel = _levels.front();
+
+    if(minDownscale > 1)
+    {
+        downscaleWithGaussianBlur(firstLevel, in_img, minDownscale, 2);
+    }
+    else
+    {
+        firstLevel = in_img;
+    }
+
+    // color conversion into CIELAB (0, 255), alpha in range (0, 255)
+#pragma omp parallel for
+    for(int y = 0; y < firstLevel.Height(); ++y)
+    {
+        for(int x = 0; x < firstLevel.Width(); ++x)
+        {
+            image::RGBAfColor& color = firstLevel(y, x);
+            rgb2lab(color);
+            color.a() *= 255.f;
+        }
+    }
+
+    // other levels: gaussian filter (radius 2) of the previous level
+    for(int l = 1; l < nbLevels; ++l)
+    {
+        const image::Image<image::RGBAfColor>& previousLevel = _levels.at(l - 1);
+        downscaleWithGaussianBlur(_levels.at(l), previousLevel, 2, 2);
+    }
+}
+
+float CpuMipmapImage::getLevel(unsigned int downscale) const
+{
+    // check given downscale
+    if(downscale < _minDownscale || downscale > _maxDownscale)
+        ALICEVISION_THROW_ERROR("Cannot get host mipmap image level (downscale: " << downscale << ")");
+
+    return std::log2(float(downscale) / float(_minDownscale));
+}
+
+void CpuMipmapImage::getDimensions(unsigned int downscale, int& out_width, int& out_height) const
+{
+    // check given downscale
+    if(downscale < _minDownscale || downscale > _maxDownscale)
+        ALICEVISION_THROW_ERROR("Cannot get host mipmap image level dimensions (downscale: " << downscale << ")");
+
+    out_width  = divideRoundUp(_width,  int(downscale));
+    out_height = divideRoundUp(_height, int(downscale));
+}
+
+image::RGBAfColor CpuMipmapImage::sampleLevel(float u, float v, int level) const
+{
+    const image::Image<image::RGBAfColor>& img = _levels[level];
+    return sampleBilinear(img, u * float(img.Width()) - 0.5f, v * float(img.Height()) - 0.5f);
+}
+
+image::RGBAfColor CpuMipmapImage::sample(float u, float v, float level) const
+{
+    const float maxLevel = float(_levels.size() - 1);
+    const float clampedLevel = std::min(std::max(level, 0.f), maxLevel);
+    const int level0 = int(clampedLevel);
+    const float alpha = clampedLevel - float(level0);
+
+    if(alpha <= 0.f)
+        return sampleLevel(u, v, level0);
+
+    return sampleLevel(u, v, level0) * (1.f - alpha) + sampleLevel(u, v, level0 + 1) * alpha;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,85 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/pixelTypes.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @class CpuMipmapImage
+ * @brief Support class to maintain a mipmapped CIELAB image in host memory.
+ * @note CPU counterpart of DeviceMipmapImage: sampling mimics a CUDA texture
+ *       with normalized coordinates, bilinear filtering and linear mipmap filtering.
+ */
+class CpuMipmapImage
+{
+public:
+
+    CpuMipmapImage() = default;
+
+    // no copy constructor
+    CpuMipmapImage(CpuMipmapImage const&) = delete;
+
+    // no copy operator
+    void operator=(CpuMipmapImage const&) = delete;
+
+    // default destructor
+    ~CpuMipmapImage() = default;
+
+    /**
+     * @brief Fill the mipmap image from the given host-sided image buffer.
+     * @param[in] in_img the host-sided image buffer, RGBA in range (0, 1)
+     * @param[in] minDownscale the first level downscale factor (must be power of two)
+     * @param[in] maxDownscale the last level downscale factor (must be power of two)
+     */
+    void fill(const image::Image<image::RGBAfColor>& in_img, int minDownscale, int maxDownscale);
+
+    /**
+     * @brief Get the corresponding mipmap image level of the given downscale
+     * @note throw if the given downscale is not contained in the mipmap image
+     * @return corresponding mipmap image level
+     */
+    float getLevel(unsigned int downscale) const;
+
+    /**
+     * @brief Get the corresponding mipmap image level dimensions (width, height) of the given downscale
+     * @note throw if the given downscale is not contained in the mipmap image
+     * @param[out] out_width the level width
+     * @param[out] out_height the level height
+     */
+    void getDimensions(unsigned int downscale, int& out_width, int& out_height) const;
+
+    /**
+     * @brief Sample the mipmap image.
+     * @param[in] u the normalized x coordinate
+     * @param[in] v the normalized y coordinate
+     * @param[in] level the (fractional) mipmap level
+     * @return CIELAB color and alpha in range (0, 255)
+     */
+    image::RGBAfColor sample(float u, float v, float level) const;
+
+    // mipmap image number of levels getter
+    inline unsigned int getLevels() const { return _levels.size(); }
+
+private:
+
+    image::RGBAfColor sampleLevel(float u, float v, int level) const;
+
+    std::vector<image::Image<image::RGBAfColor>> _levels; //< mipmap image levels, first level at min downscale
+    unsigned int _minDownscale = 0;                       //< the min downscale factor
+    unsigned int _maxDownscale = 0;                       //< the max downscale factor
+    int _width = 0;                                       //< original image buffer width (no downscale)
+    int _height = 0;                                      //< original image buffer heigh (no downscale)
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,180 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CpuRefine.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/depthMap/cpu/CpuCameraParams.hpp>
+#include <aliceVision/depthMap/cpu/cpuDepthSimilarityMap.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+CpuRefine::CpuRefine(const mvsUtils::MultiViewParams& mp,
+                     const mvsUtils::TileParams& tileParams,
+                     const RefineParams& refineParams)
+    : _mp(mp)
+    , _tileParams(tileParams)
+    , _refineParams(refineParams)
+{
+    // get tile maximum dimensions
+    const int downscale = _refineParams.scale * _refineParams.stepXY;
+    const int maxTileWidth  = divideRoundUp(tileParams.bufferWidth , downscale);
+    const int maxTileHeight = divideRoundUp(tileParams.bufferHeight, downscale);
+
+    // allocate depth/sim maps in host memory
+    _sgmDepthPixSizeMap.allocate(maxTileWidth, maxTileHeight);
+    _refinedDepthSimMap.allocate(maxTileWidth, maxTileHeight);
+    _optimizedDepthSimMap.allocate(maxTileWidth, maxTileHeight);
+
+    // allocate refine volume in host memory
+    const int nbDepthsToRefine = _refineParams.halfNbDepths * 2 + 1;
+    _volumeRefineSim.allocate(maxTileWidth, maxTileHeight, nbDepthsToRefine);
+}
+
+double CpuRefine::getMemoryConsumption() const
+{
+    size_t bytes = 0;
+
+    bytes += _sgmDepthPixSizeMap.getBytes();
+    bytes += _refinedDepthSimMap.getBytes();
+    bytes += _optimizedDepthSimMap.getBytes();
+    bytes += _volumeRefineSim.getBytes();
+
+    return (double(bytes) / (1024.0 * 1024.0));
+}
+
+void CpuRefine::refineRc(const Tile& tile, const CpuMap<Vec2f>& in_sgmDepthThicknessMap, const std::map<int, CpuMipmapImage>& mipmapImages)
+{
+    const IndexT viewId = _mp.getViewId(tile.rc);
+
+    ALICEVISION_LOG_INFO(tile << "Refine (CPU) depth/sim map of view id: " << viewId << ", rc: " << tile.rc << " (" << (tile.rc + 1) << " / " << _mp.ncams << ").");
+
+    const CpuMipmapImage& rcMipmapImage = mipmapImages.at(tile.rc);
+
+    // compute upscaled SGM depth/pixSize map
+    // - upscale SGM depth/thickness map
+    // - filter masked pixels (alpha)
+    // - compute pixSize from SGM thickness
+    {
+        // downscale the region of interest
+        const ROI downscaledRoi = downscaleROI(tile.roi, _refineParams.scale * _refineParams.stepXY);
+
+        cpu_computeSgmUpscaledDepthPixSizeMap(_sgmDepthPixSizeMap,
+                                              in_sgmDepthThicknessMap,
+                                              rcMipmapImage,
+                                              _refineParams,
+                                              downscaledRoi);
+    }
+
+    // refine and fuse depth/sim map
+    if(_refineParams.useRefineFuse)
+    {
+        // refine and fuse with volume strategy
+        refineAndFuseDepthSimMap(tile, mipmapImages);
+    }
+    else
+    {
+        ALICEVISION_LOG_INFO(tile << "Refine and fuse depth/sim map volume disabled.");
+        cpu_depthSimMapCopyDepthOnly(_refinedDepthSimMap, _sgmDepthPixSizeMap, 1.0f);
+    }
+
+    // optimize depth/sim map
+    if(_refineParams.useColorOptimization && _refineParams.optimizationNbIterations > 0)
+    {
+        optimizeDepthSimMap(tile, rcMipmapImage);
+    }
+    else
+    {
+        ALICEVISION_LOG_INFO(tile << "Color optimize depth/sim map disabled.");
+        _optimizedDepthSimMap = _refinedDepthSimMap;
+    }
+
+    ALICEVISION_LOG_INFO(tile << "Refine (CPU) depth/sim map done.");
+}
+
+void CpuRefine::refineAndFuseDepthSimMap(const Tile& tile, const std::map<int, CpuMipmapImage>& mipmapImages)
+{
+    ALICEVISION_LOG_INFO(tile << "Refine (CPU) and fuse depth/sim map volume.");
+
+    // downscale the region of interest
+    const ROI downscaledRoi = downscaleROI(tile.roi, _refineParams.scale * _refineParams.stepXY);
+
+    // get the depth range
+    const Range depthRange(0, _volumeRefineSim.getDimZ());
+
+    // initialize the similarity volume at 0
+    // each tc filtered and inverted similarity value will be summed in this volume
+    _volumeRefineSim.fill(TSimRefineCpu(0.f));
+
+    // get R camera parameters and mipmap image
+    CpuCameraParams rcCamParams;
+    fillCpuCameraParams(rcCamParams, tile.rc, _refineParams.scale, _mp);
+    const CpuMipmapImage& rcMipmapImage = mipmapImages.at(tile.rc);
+
+    // compute for each RcTc each similarity value for each depth to refine
+    // sum the inverted / filtered similarity value, best value is the HIGHEST
+    for(std::size_t tci = 0; tci < tile.refineTCams.size(); ++tci)
+    {
+        const int tc = tile.refineTCams.at(tci);
+
+        // get T camera parameters and mipmap image
+        CpuCameraParams tcCamParams;
+        fillCpuCameraParams(tcCamParams, tc, _refineParams.scale, _mp);
+        const CpuMipmapImage& tcMipmapImage = mipmapImages.at(tc);
+
+        ALICEVISION_LOG_DEBUG(tile << "Refine similarity volume (CPU):" << std::endl
+                                   << "\t- rc: " << tile.rc << std::endl
+                                   << "\t- tc: " << tc << " (" << (tci + 1) << "/" << tile.refineTCams.size() << ")" << std::endl
+                                   << "\t- tile range x: [" << downscaledRoi.x.begin << " - " << downscaledRoi.x.end << "]" << std::endl
+                                   << "\t- tile range y: [" << downscaledRoi.y.begin << " - " << downscaledRoi.y.end << "]" << std::endl);
+
+        cpu_volumeRefineSimilarity(_volumeRefineSim,
+                                   _sgmDepthPixSizeMap,
+                                   rcCamParams,
+                                   tcCamParams,
+                                   rcMipmapImage,
+                                   tcMipmapImage,
+                                   _refineParams,
+                                   depthRange,
+                                   downscaledRoi);
+    }
+
+    // retrieve the best depth/sim in the volume
+    // compute sub-pixel sample using a sliding gaussian
+    cpu_volumeRefineBestDepth(_refinedDepthSimMap,
+                              _sgmDepthPixSizeMap,
+                              _volumeRefineSim,
+                              _refineParams,
+                              downscaledRoi);
+
+    ALICEVISION_LOG_INFO(tile << "Refine (CPU) and fuse depth/sim map volume done.");
+}
+
+void CpuRefine::optimizeDepthSimMap(const Tile& tile, const CpuMipmapImage& rcMipmapImage)
+{
+    ALICEVISION_LOG_INFO(tile << "Color optimize (CPU) depth/sim map.");
+
+    // downscale the region of interest
+    const ROI downscaledRoi = downscaleROI(tile.roi, _refineParams.scale * _refineParams.stepXY);
+
+    // get R camera parameters
+    CpuCameraParams rcCamParams;
+    fillCpuCameraParams(rcCamParams, tile.rc, _refineParams.scale, _mp);
+
+    cpu_depthSimMapOptimizeGradientDescent(_optimizedDepthSimMap, // output depth/sim map optimized
+                                           _sgmDepthPixSizeMap,   // input SGM upscaled depth/pixSize map
+                                           _refinedDepthSimMap,   // input refined and fused depth/sim map
+                                           rcCamParams,
+                                           rcMipmapImage,
+                                           _refineParams,
+                                           downscaledRoi);
+
+    ALICEVISION_LOG_INFO(tile << "Color optimize (CPU) depth/sim map done.");
+}
+
+} // namespace depthMap
+} // namespace aliceVision
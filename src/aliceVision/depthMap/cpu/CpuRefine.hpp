@@ -0,0 +1,97 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/TileParams.hpp>
+#include <aliceVision/depthMap/Tile.hpp>
+#include <aliceVision/depthMap/RefineParams.hpp>
+#include <aliceVision/depthMap/cpu/CpuBuffer.hpp>
+#include <aliceVision/depthMap/cpu/CpuMipmapImage.hpp>
+#include <aliceVision/depthMap/cpu/cpuSimilarityVolume.hpp>
+
+#include <map>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @class Depth map estimation Refine on CPU
+ * @brief Manages the calculation of the Refine step in host memory.
+ * @note CPU counterpart of Refine, SGM normal map and intermediate results export are not supported.
+ */
+class CpuRefine
+{
+public:
+
+    /**
+     * @brief CpuRefine constructor.
+     * @param[in] mp the multi-view parameters
+     * @param[in] tileParams tile workflow parameters
+     * @param[in] refineParams the Refine parameters
+     */
+    CpuRefine(const mvsUtils::MultiViewParams& mp,
+              const mvsUtils::TileParams& tileParams,
+              const RefineParams& refineParams);
+
+    // no default constructor
+    CpuRefine() = delete;
+
+    // default destructor
+    ~CpuRefine() = default;
+
+    // final depth/similarity map getter
+    inline const CpuMap<Vec2f>& getDepthSimMap() const { return _optimizedDepthSimMap; }
+
+    /**
+     * @brief Get memory consumption in host memory.
+     * @return memory consumption (in MB)
+     */
+    double getMemoryConsumption() const;
+
+    /**
+     * @brief Refine for a single R camera the Semi-Global Matching depth/sim map.
+     * @param[in] tile The given tile for Refine computation
+     * @param[in] in_sgmDepthThicknessMap the SGM depth/thickness map
+     * @param[in] mipmapImages the R and T cameras mipmap images (by camera index)
+     */
+    void refineRc(const Tile& tile, const CpuMap<Vec2f>& in_sgmDepthThicknessMap, const std::map<int, CpuMipmapImage>& mipmapImages);
+
+private:
+
+    // private methods
+
+    /**
+     * @brief Refine and fuse the given depth/sim map using volume strategy.
+     * @param[in] tile The given tile for Refine computation
+     * @param[in] mipmapImages the R and T cameras mipmap images (by camera index)
+     */
+    void refineAndFuseDepthSimMap(const Tile& tile, const std::map<int, CpuMipmapImage>& mipmapImages);
+
+    /**
+     * @brief Optimize the refined depth/sim maps.
+     * @param[in] tile The given tile for Refine computation
+     * @param[in] rcMipmapImage the R camera mipmap image
+     */
+    void optimizeDepthSimMap(const Tile& tile, const CpuMipmapImage& rcMipmapImage);
+
+    // private members
+
+    const mvsUtils::MultiViewParams& _mp;           //< Multi-view parameters
+    const mvsUtils::TileParams& _tileParams;        //< tile workflow parameters
+    const RefineParams& _refineParams;              //< Refine parameters
+
+    // host memory buffers
+    CpuMap<Vec2f> _sgmDepthPixSizeMap;              //< rc upscaled SGM depth/pixSize map
+    CpuMap<Vec2f> _refinedDepthSimMap;              //< rc refined and fused depth/sim map
+    CpuMap<Vec2f> _optimizedDepthSimMap;            //< rc optimized depth/sim map
+    CpuVolume<TSimRefineCpu> _volumeRefineSim;      //< rc refine similarity volume
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,202 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CpuSgm.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/depthMap/cpu/CpuCameraParams.hpp>
+#include <aliceVision/depthMap/cpu/cpuDepthSimilarityMap.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+CpuSgm::CpuSgm(const mvsUtils::MultiViewParams& mp,
+               const mvsUtils::TileParams& tileParams,
+               const SgmParams& sgmParams,
+               bool computeDepthSimMap)
+    : _mp(mp)
+    , _tileParams(tileParams)
+    , _sgmParams(sgmParams)
+    , _computeDepthSimMap(computeDepthSimMap)
+{
+    // get tile maximum dimensions
+    const int downscale = _sgmParams.scale * _sgmParams.stepXY;
+    const int maxTileWidth  = divideRoundUp(tileParams.bufferWidth , downscale);
+    const int maxTileHeight = divideRoundUp(tileParams.bufferHeight, downscale);
+
+    // allocate depth thickness map in host memory
+    _depthThicknessMap.allocate(maxTileWidth, maxTileHeight);
+
+    // allocate depth/sim map in host memory
+    if(_computeDepthSimMap)
+        _depthSimMap.allocate(maxTileWidth, maxTileHeight);
+
+    // allocate similarity volumes in host memory
+    _volumeBestSim.allocate(maxTileWidth, maxTileHeight, _sgmParams.maxDepths);
+    _volumeSecBestSim.allocate(maxTileWidth, maxTileHeight, _sgmParams.maxDepths);
+}
+
+double CpuSgm::getMemoryConsumption() const
+{
+    size_t bytes = 0;
+
+    bytes += _depthThicknessMap.getBytes();
+    bytes += _depthSimMap.getBytes();
+    bytes += _volumeBestSim.getBytes();
+    bytes += _volumeSecBestSim.getBytes();
+
+    return (double(bytes) / (1024.0 * 1024.0));
+}
+
+void CpuSgm::sgmRc(const Tile& tile, const SgmDepthList& tileDepthList, const std::map<int, CpuMipmapImage>& mipmapImages)
+{
+    const IndexT viewId = _mp.getViewId(tile.rc);
+
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) depth/thickness map of view id: " << viewId << ", rc: " << tile.rc << " (" << (tile.rc + 1) << " / " << _mp.ncams << ").");
+
+    // check SGM depth list and T cameras
+    if(tile.sgmTCams.empty() || tileDepthList.getDepths().empty())
+        ALICEVISION_THROW_ERROR(tile << "Cannot compute Semi-Global Matching, no depths or no T cameras (viewId: " << viewId << ").");
+
+    // compute best sim and second best sim volumes
+    computeSimilarityVolumes(tile, tileDepthList, mipmapImages);
+
+    if(_sgmParams.doSgmOptimizeVolume)
+    {
+        optimizeSimilarityVolume(tile, tileDepthList, mipmapImages.at(tile.rc));
+    }
+    else
+    {
+        // best sim volume is normally reuse to put optimized similarity
+        _volumeBestSim = _volumeSecBestSim;
+    }
+
+    // retrieve best depth
+    retrieveBestDepth(tile, tileDepthList);
+
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) depth/thickness map done.");
+}
+
+void CpuSgm::smoothThicknessMap(const Tile& tile, const RefineParams& refineParams)
+{
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) Smooth thickness map.");
+
+    // downscale the region of interest
+    const ROI downscaledRoi = downscaleROI(tile.roi, _sgmParams.scale * _sgmParams.stepXY);
+
+    // result thickness map smoothing with adjacent pixels
+    cpu_depthThicknessSmoothThickness(_depthThicknessMap, _sgmParams, refineParams, downscaledRoi);
+
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) Smooth thickness map done.");
+}
+
+void CpuSgm::computeSimilarityVolumes(const Tile& tile, const SgmDepthList& tileDepthList, const std::map<int, CpuMipmapImage>& mipmapImages)
+{
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) Compute similarity volume.");
+
+    // downscale the region of interest
+    const ROI downscaledRoi = downscaleROI(tile.roi, _sgmParams.scale * _sgmParams.stepXY);
+
+    // initialize the two similarity volumes at 255
+    _volumeBestSim.fill(TSimCpu(255));
+    _volumeSecBestSim.fill(TSimCpu(255));
+
+    // get R camera parameters and mipmap image
+    CpuCameraParams rcCamParams;
+    fillCpuCameraParams(rcCamParams, tile.rc, _sgmParams.scale, _mp);
+    const CpuMipmapImage& rcMipmapImage = mipmapImages.at(tile.rc);
+
+    // compute similarity volume per Rc Tc
+    for(std::size_t tci = 0; tci < tile.sgmTCams.size(); ++tci)
+    {
+        const int tc = tile.sgmTCams.at(tci);
+
+        const int firstDepth = tileDepthList.getDepthsTcLimits()[tci].x;
+        const int lastDepth  = firstDepth + tileDepthList.getDepthsTcLimits()[tci].y;
+
+        const Range tcDepthRange(firstDepth, lastDepth);
+
+        // get T camera parameters and mipmap image
+        CpuCameraParams tcCamParams;
+        fillCpuCameraParams(tcCamParams, tc, _sgmParams.scale, _mp);
+        const CpuMipmapImage& tcMipmapImage = mipmapImages.at(tc);
+
+        ALICEVISION_LOG_DEBUG(tile << "Compute similarity volume (CPU):" << std::endl
+                                   << "\t- rc: " << tile.rc << std::endl
+                                   << "\t- tc: " << tc << " (" << (tci + 1) << "/" << tile.sgmTCams.size() << ")" << std::endl
+                                   << "\t- tc first depth: " << firstDepth << std::endl
+                                   << "\t- tc last depth: " << lastDepth << std::endl
+                                   << "\t- tile range x: [" << downscaledRoi.x.begin << " - " << downscaledRoi.x.end << "]" << std::endl
+                                   << "\t- tile range y: [" << downscaledRoi.y.begin << " - " << downscaledRoi.y.end << "]" << std::endl);
+
+        cpu_volumeComputeSimilarity(_volumeBestSim,
+                                    _volumeSecBestSim,
+                                    tileDepthList.getDepths(),
+                                    rcCamParams,
+                                    tcCamParams,
+                                    rcMipmapImage,
+                                    tcMipmapImage,
+                                    _sgmParams,
+                                    tcDepthRange,
+                                    downscaledRoi);
+    }
+
+    // update second best uninitialized similarity volume values with first best similarity volume values
+    if(_sgmParams.updateUninitializedSim) // should always be true, false for debug purposes
+    {
+        ALICEVISION_LOG_DEBUG(tile << "SGM (CPU) Update uninitialized similarity volume values from best similarity volume.");
+
+        cpu_volumeUpdateUninitializedSimilarity(_volumeBestSim, _volumeSecBestSim);
+    }
+
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) Compute similarity volume done.");
+}
+
+void CpuSgm::optimizeSimilarityVolume(const Tile& tile, const SgmDepthList& tileDepthList, const CpuMipmapImage& rcMipmapImage)
+{
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) Optimizing volume (filtering axes: " << _sgmParams.filteringAxes << ").");
+
+    // downscale the region of interest
+    const ROI downscaledRoi = downscaleROI(tile.roi, _sgmParams.scale * _sgmParams.stepXY);
+
+    cpu_volumeOptimize(_volumeBestSim,    // output volume (reuse best sim to put optimized similarity)
+                       _volumeSecBestSim, // input volume
+                       rcMipmapImage,
+                       _sgmParams,
+                       int(tileDepthList.getDepths().size()),
+                       downscaledRoi);
+
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) Optimizing volume done.");
+}
+
+void CpuSgm::retrieveBestDepth(const Tile& tile, const SgmDepthList& tileDepthList)
+{
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) Retrieve best depth in volume.");
+
+    // downscale the region of interest
+    const ROI downscaledRoi = downscaleROI(tile.roi, _sgmParams.scale * _sgmParams.stepXY);
+
+    // get depth range
+    const Range depthRange(0, tileDepthList.getDepths().size());
+
+    // get R camera parameters at scale 1
+    CpuCameraParams rcCamParams;
+    fillCpuCameraParams(rcCamParams, tile.rc, 1, _mp);
+
+    cpu_volumeRetrieveBestDepth(_depthThicknessMap,                              // output depth thickness map
+                                _computeDepthSimMap ? &_depthSimMap : nullptr,   // output depth/sim map (or nullptr)
+                                tileDepthList.getDepths(),                       // rc depth
+                                _volumeBestSim,                                  // second best sim volume optimized in best sim volume
+                                rcCamParams,
+                                _sgmParams,
+                                depthRange,
+                                downscaledRoi);
+
+    ALICEVISION_LOG_INFO(tile << "SGM (CPU) Retrieve best depth in volume done.");
+}
+
+} // namespace depthMap
+} // namespace aliceVision
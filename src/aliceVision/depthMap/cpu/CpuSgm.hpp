@@ -0,0 +1,122 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/TileParams.hpp>
+#include <aliceVision/depthMap/Tile.hpp>
+#include <aliceVision/depthMap/RefineParams.hpp>
+#include <aliceVision/depthMap/SgmParams.hpp>
+#include <aliceVision/depthMap/SgmDepthList.hpp>
+#include <aliceVision/depthMap/cpu/CpuBuffer.hpp>
+#include <aliceVision/depthMap/cpu/CpuMipmapImage.hpp>
+#include <aliceVision/depthMap/cpu/cpuSimilarityVolume.hpp>
+
+#include <map>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @class Depth map estimation Semi-Global Matching on CPU
+ * @brief Manages the calculation of the Semi-Global Matching step in host memory.
+ * @note CPU counterpart of Sgm, intermediate results export is not supported.
+ */
+class CpuSgm
+{
+public:
+
+    /**
+     * @brief CpuSgm constructor.
+     * @param[in] mp the multi-view parameters
+     * @param[in] tileParams tile workflow parameters
+     * @param[in] sgmParams the Semi Global Matching parameters
+     * @param[in] computeDepthSimMap Enable final depth/sim map computation
+     */
+    CpuSgm(const mvsUtils::MultiViewParams& mp,
+           const mvsUtils::TileParams& tileParams,
+           const SgmParams& sgmParams,
+           bool computeDepthSimMap);
+
+    // no default constructor
+    CpuSgm() = delete;
+
+    // default destructor
+    ~CpuSgm() = default;
+
+    // final depth/thickness map getter
+    inline const CpuMap<Vec2f>& getDepthThicknessMap() const { return _depthThicknessMap; }
+
+    // final depth/similarity map getter (optional: could be empty)
+    inline const CpuMap<Vec2f>& getDepthSimMap() const { return _depthSimMap; }
+
+    /**
+     * @brief Get memory consumption in host memory.
+     * @return memory consumption (in MB)
+     */
+    double getMemoryConsumption() const;
+
+    /**
+     * @brief Compute for a single R camera the Semi-Global Matching.
+     * @param[in] tile The given tile for SGM computation
+     * @param[in] tileDepthList the tile SGM depth list
+     * @param[in] mipmapImages the R and T cameras mipmap images (by camera index)
+     */
+    void sgmRc(const Tile& tile, const SgmDepthList& tileDepthList, const std::map<int, CpuMipmapImage>& mipmapImages);
+
+    /**
+     * @brief Smooth SGM result thickness map.
+     * @note Entire R camera thickness map smoothing with adjacent pixels.
+     * @param[in] tile The given tile for SGM computation
+     * @param[in] refineParams the Refine parameters
+     */
+    void smoothThicknessMap(const Tile& tile, const RefineParams& refineParams);
+
+private:
+
+    // private methods
+
+    /**
+     * @brief Compute for each RcTc the best / second best similarity volumes.
+     * @param[in] tile The given tile for SGM computation
+     * @param[in] tileDepthList the tile SGM depth list
+     * @param[in] mipmapImages the R and T cameras mipmap images (by camera index)
+     */
+    void computeSimilarityVolumes(const Tile& tile, const SgmDepthList& tileDepthList, const std::map<int, CpuMipmapImage>& mipmapImages);
+
+    /**
+     * @brief Optimize a given similarity volume.
+     * @param[in] tile The given tile for SGM computation
+     * @param[in] tileDepthList the tile SGM depth list
+     * @param[in] rcMipmapImage the R camera mipmap image
+     */
+    void optimizeSimilarityVolume(const Tile& tile, const SgmDepthList& tileDepthList, const CpuMipmapImage& rcMipmapImage);
+
+    /**
+     * @brief Retrieve best depth/sim from a given similarity volume.
+     * @param[in] tile The given tile for SGM computation
+     * @param[in] tileDepthList the tile SGM depth list
+     */
+    void retrieveBestDepth(const Tile& tile, const SgmDepthList& tileDepthList);
+
+    // private members
+
+    const mvsUtils::MultiViewParams& _mp;       //< Multi-view parameters
+    const mvsUtils::TileParams& _tileParams;    //< tile workflow parameters
+    const SgmParams& _sgmParams;                //< SGM parameters
+    const bool _computeDepthSimMap;             //< needs to compute a final depth/sim map
+
+    // host memory buffers
+    CpuMap<Vec2f> _depthThicknessMap;           //< output depth/thickness map
+    CpuMap<Vec2f> _depthSimMap;                 //< output best depth/sim map (optional)
+    CpuVolume<TSimCpu> _volumeBestSim;          //< best similarity volume
+    CpuVolume<TSimCpu> _volumeSecBestSim;       //< second best similarity volume
+};
+
+} // namespace depthMap
+} // namespace aliceVision
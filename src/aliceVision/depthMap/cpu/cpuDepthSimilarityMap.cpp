@@ -0,0 +1,380 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "cpuDepthSimilarityMap.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/depthMap/cpu/patch.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+/**
+ * @brief Get the depth of the given cell, clamp-to-edge addressing mode.
+ */
+inline float getDepthClamped(const CpuMap<float>& depthMap, int x, int y, int width, int height)
+{
+    return depthMap(std::min(std::max(x, 0), width - 1), std::min(std::max(y, 0), height - 1));
+}
+
+/**
+ * @brief Compute the smoothing step and energy of the given cell.
+ * @note Host version of getCellSmoothStepEnergy.
+ * @return (smoothStep, energy)
+ */
+Vec2f getCellSmoothStepEnergy(const CpuCameraParams& rcCamParams,
+                              const CpuMap<float>& depthMap,
+                              int x, int y,
+                              int width, int height,
+                              const Vec2f& offsetRoi)
+{
+    Vec2f out(0.0f, 180.0f);
+
+    // get pixel depth
+    const float d0 = depthMap(x, y);
+
+    // early exit: depth is <= 0
+    if(d0 <= 0.0f)
+        return out;
+
+    // consider the neighbor pixels
+    // note: same neighbor convention as the CUDA kernel
+    const Vec2f cell0(static_cast<float>(x), static_cast<float>(y));
+    const Vec2f cellL = cell0 + Vec2f( 0.f, -1.f); // Left
+    const Vec2f cellR = cell0 + Vec2f( 0.f,  1.f); // Right
+    const Vec2f cellU = cell0 + Vec2f(-1.f,  0.f); // Up
+    const Vec2f cellB = cell0 + Vec2f( 1.f,  0.f); // Bottom
+
+    // get associated depths
+    const float dL = getDepthClamped(depthMap, x, y - 1, width, height);
+    const float dR = getDepthClamped(depthMap, x, y + 1, width, height);
+    const float dU = getDepthClamped(depthMap, x - 1, y, width, height);
+    const float dB = getDepthClamped(depthMap, x + 1, y, width, height);
+
+    // get associated 3D points
+    const Vec3f p0 = cpu::get3DPointForPixelAndDepthFromRC(rcCamParams, cell0 + offsetRoi, d0);
+    const Vec3f pL = cpu::get3DPointForPixelAndDepthFromRC(rcCamParams, cellL + offsetRoi, dL);
+    const Vec3f pR = cpu::get3DPointForPixelAndDepthFromRC(rcCamParams, cellR + offsetRoi, dR);
+    const Vec3f pU = cpu::get3DPointForPixelAndDepthFromRC(rcCamParams, cellU + offsetRoi, dU);
+    const Vec3f pB = cpu::get3DPointForPixelAndDepthFromRC(rcCamParams, cellB + offsetRoi, dB);
+
+    // compute the average point based on neighbors (cg)
+    Vec3f cg(0.0f, 0.0f, 0.0f);
+    float n = 0.0f;
+
+    if(dL > 0.0f) { cg += pL; n++; }
+    if(dR > 0.0f) { cg += pR; n++; }
+    if(dU > 0.0f) { cg += pU; n++; }
+    if(dB > 0.0f) { cg += pB; n++; }
+
+    // if we have at least one valid depth
+    if(n > 1.0f)
+    {
+        cg /= n; // average of x, y, depth
+        const Vec3f vcn = (rcCamParams.C - p0).normalized();
+        // pS: projection of cg on the line from p0 to camera
+        const Vec3f pS = cpu::closestPointToLine3D(cg, p0, vcn);
+        // keep the depth difference between pS and p0 as the smoothing step
+        out.x() = (rcCamParams.C - pS).norm() - d0;
+    }
+
+    float e = 0.0f;
+    n = 0.0f;
+
+    if(dL > 0.0f && dR > 0.0f)
+    {
+        // large angle between neighbors == flat area => low energy
+        // small angle between neighbors == non-flat area => high energy
+        e = std::max(e, (180.0f - cpu::angleBetwABandAC(p0, pL, pR)));
+        n++;
+    }
+    if(dU > 0.0f && dB > 0.0f)
+    {
+        e = std::max(e, (180.0f - cpu::angleBetwABandAC(p0, pU, pB)));
+        n++;
+    }
+    // the higher the energy, the less flat the area
+    if(n > 0.0f)
+        out.y() = e;
+
+    return out;
+}
+
+} // namespace
+
+void cpu_depthSimMapCopyDepthOnly(CpuMap<Vec2f>& out_depthSimMap,
+                                  const CpuMap<Vec2f>& in_depthSimMap,
+                                  float defaultSim)
+{
+    out_depthSimMap.allocate(in_depthSimMap.getWidth(), in_depthSimMap.getHeight());
+
+#pragma omp parallel for
+    for(int y = 0; y < in_depthSimMap.getHeight(); ++y)
+    {
+        for(int x = 0; x < in_depthSimMap.getWidth(); ++x)
+        {
+            out_depthSimMap(x, y) = Vec2f(in_depthSimMap(x, y).x(), defaultSim);
+        }
+    }
+}
+
+void cpu_depthThicknessSmoothThickness(CpuMap<Vec2f>& inout_depthThicknessMap,
+                                       const SgmParams& sgmParams,
+                                       const RefineParams& refineParams,
+                                       const ROI& roi)
+{
+    const int sgmScaleStep = sgmParams.scale * sgmParams.stepXY;
+    const int refineScaleStep = refineParams.scale * refineParams.stepXY;
+
+    // min/max number of Refine samples in SGM thickness area
+    const float minNbRefineSamples = 2.f;
+    const float maxNbRefineSamples = std::max(sgmScaleStep / float(refineScaleStep), minNbRefineSamples);
+
+    // min/max SGM thickness inflate factor
+    const float minThicknessInflate = refineParams.halfNbDepths / maxNbRefineSamples;
+    const float maxThicknessInflate = refineParams.halfNbDepths / minNbRefineSamples;
+
+    const int roiWidth = int(roi.width());
+    const int roiHeight = int(roi.height());
+
+    // read from a copy of the input map
+    // note: the CUDA kernel works in-place, we avoid the read / write race for deterministic results
+    const CpuMap<Vec2f> in_depthThicknessMap = inout_depthThicknessMap;
+
+#pragma omp parallel for
+    for(int roiY = 0; roiY < roiHeight; ++roiY)
+    {
+        for(int roiX = 0; roiX < roiWidth; ++roiX)
+        {
+            const Vec2f& in_depthThickness = in_depthThicknessMap(roiX, roiY);
+
+            // depth invalid or masked
+            if(in_depthThickness.x() <= 0.0f)
+                continue;
+
+            const float minThickness = minThicknessInflate * in_depthThickness.y();
+            const float maxThickness = maxThicknessInflate * in_depthThickness.y();
+
+            // compute average depth distance to the center pixel
+            float sumCenterDepthDist = 0.f;
+            int nbValidPatchPixels = 0;
+
+            // patch 3x3
+            for(int yp = -1; yp <= 1; ++yp)
+            {
+                for(int xp = -1; xp <= 1; ++xp)
+                {
+                    // compute patch coordinates
+                    const int roiXp = roiX + xp;
+                    const int roiYp = roiY + yp;
+
+                    if((xp == 0 && yp == 0) ||              // avoid pixel center
+                       roiXp < 0 || roiXp >= roiWidth ||    // avoid pixel outside the ROI
+                       roiYp < 0 || roiYp >= roiHeight)     // avoid pixel outside the ROI
+                    {
+                        continue;
+                    }
+
+                    // corresponding path depth/thickness
+                    const Vec2f& in_depthThicknessPatch = in_depthThicknessMap(roiXp, roiYp);
+
+                    // patch depth valid
+                    if(in_depthThicknessPatch.x() > 0.0f)
+                    {
+                        const float depthDistance = std::abs(in_depthThickness.x() - in_depthThicknessPatch.x());
+                        sumCenterDepthDist += std::max(minThickness, std::min(maxThickness, depthDistance)); // clamp (minThickness, maxThickness)
+                        ++nbValidPatchPixels;
+                    }
+                }
+            }
+
+            // we require at least 3 valid patch pixels (over 8)
+            if(nbValidPatchPixels < 3)
+                continue;
+
+            // write output smooth thickness
+            inout_depthThicknessMap(roiX, roiY).y() = sumCenterDepthDist / nbValidPatchPixels;
+        }
+    }
+}
+
+void cpu_computeSgmUpscaledDepthPixSizeMap(CpuMap<Vec2f>& out_upscaledDepthPixSizeMap,
+                                           const CpuMap<Vec2f>& in_sgmDepthThicknessMap,
+                                           const CpuMipmapImage& rcMipmapImage,
+                                           const RefineParams& refineParams,
+                                           const ROI& roi)
+{
+    // compute upscale ratio
+    const float ratio = float(in_sgmDepthThicknessMap.getWidth()) / float(out_upscaledDepthPixSizeMap.getWidth());
+
+    // get R mipmap image level and dimensions
+    const float rcMipmapLevel = rcMipmapImage.getLevel(refineParams.scale);
+
+    int rcLevelWidth, rcLevelHeight;
+    rcMipmapImage.getDimensions(refineParams.scale, rcLevelWidth, rcLevelHeight);
+
+    const int roiWidth = int(roi.width());
+    const int roiHeight = int(roi.height());
+    const int maxXp = int(roi.width() * ratio) - 1;
+    const int maxYp = int(roi.height() * ratio) - 1;
+
+#pragma omp parallel for
+    for(int roiY = 0; roiY < roiHeight; ++roiY)
+    {
+        for(int roiX = 0; roiX < roiWidth; ++roiX)
+        {
+            // corresponding image coordinates
+            const int x = (roi.x.begin + roiX) * refineParams.stepXY;
+            const int y = (roi.y.begin + roiY) * refineParams.stepXY;
+
+            // corresponding output upscaled depth/pixSize
+            Vec2f& out_depthPixSize = out_upscaledDepthPixSizeMap(roiX, roiY);
+
+            // filter masked pixels (alpha < 0.9f)
+            if(rcMipmapImage.sample((float(x) + 0.5f) / float(rcLevelWidth), (float(y) + 0.5f) / float(rcLevelHeight), rcMipmapLevel).a() < 0.9f)
+            {
+                out_depthPixSize = Vec2f(-2.f, 0.f);
+                continue;
+            }
+
+            // find corresponding depth/thickness
+            // nearest neighbor, no interpolation
+            const float ox = (float(roiX) - 0.5f) * ratio;
+            const float oy = (float(roiY) - 0.5f) * ratio;
+
+            const int xp = std::max(0, std::min(int(std::floor(ox + 0.5f)), maxXp));
+            const int yp = std::max(0, std::min(int(std::floor(oy + 0.5f)), maxYp));
+
+            const Vec2f& in_depthThickness = in_sgmDepthThicknessMap(xp, yp);
+
+            // compute pixSize from depth thickness
+            out_depthPixSize = Vec2f(in_depthThickness.x(), in_depthThickness.y() / refineParams.halfNbDepths);
+        }
+    }
+}
+
+void cpu_depthSimMapOptimizeGradientDescent(CpuMap<Vec2f>& out_optimizeDepthSimMap,
+                                            const CpuMap<Vec2f>& in_sgmDepthPixSizeMap,
+                                            const CpuMap<Vec2f>& in_refineDepthSimMap,
+                                            const CpuCameraParams& rcCamParams,
+                                            const CpuMipmapImage& rcMipmapImage,
+                                            const RefineParams& refineParams,
+                                            const ROI& roi)
+{
+    // get R mipmap image level and dimensions
+    const float rcMipmapLevel = rcMipmapImage.getLevel(refineParams.scale);
+
+    int rcLevelWidth, rcLevelHeight;
+    rcMipmapImage.getDimensions(refineParams.scale, rcLevelWidth, rcLevelHeight);
+
+    const int roiWidth = int(roi.width());
+    const int roiHeight = int(roi.height());
+    const Vec2f offsetRoi(float(roi.x.begin), float(roi.y.begin));
+
+    // compute inverse width / height
+    // note: useful to compute p1 / m1 normalized coordinates
+    const float invLevelWidth  = 1.f / float(rcLevelWidth);
+    const float invLevelHeight = 1.f / float(rcLevelHeight);
+
+    // compute image variance map (gradient size of L)
+    CpuMap<float> imgVarianceMap(roiWidth, roiHeight);
+
+#pragma omp parallel for
+    for(int roiY = 0; roiY < roiHeight; ++roiY)
+    {
+        for(int roiX = 0; roiX < roiWidth; ++roiX)
+        {
+            // corresponding image coordinates
+            const float x = float(roi.x.begin + roiX) * float(refineParams.stepXY);
+            const float y = float(roi.y.begin + roiY) * float(refineParams.stepXY);
+
+            const float xM1 = rcMipmapImage.sample(((x - 1.f) + 0.5f) * invLevelWidth, ((y + 0.f) + 0.5f) * invLevelHeight, rcMipmapLevel).r();
+            const float xP1 = rcMipmapImage.sample(((x + 1.f) + 0.5f) * invLevelWidth, ((y + 0.f) + 0.5f) * invLevelHeight, rcMipmapLevel).r();
+            const float yM1 = rcMipmapImage.sample(((x + 0.f) + 0.5f) * invLevelWidth, ((y - 1.f) + 0.5f) * invLevelHeight, rcMipmapLevel).r();
+            const float yP1 = rcMipmapImage.sample(((x + 0.f) + 0.5f) * invLevelWidth, ((y + 1.f) + 0.5f) * invLevelHeight, rcMipmapLevel).r();
+
+            imgVarianceMap(roiX, roiY) = Vec2f(xM1 - xP1, yM1 - yP1).norm();
+        }
+    }
+
+    // initialize depth/sim map optimized with SGM depth/pixSize map
+    out_optimizeDepthSimMap = in_sgmDepthPixSizeMap;
+
+    // temporary depth map of the previous iteration
+    CpuMap<float> tmpOptDepthMap(roiWidth, roiHeight);
+
+    for(int iter = 0; iter < refineParams.optimizationNbIterations; ++iter) // default nb iterations is 100
+    {
+        // copy depths values from out_optimizeDepthSimMap to tmpOptDepthMap
+#pragma omp parallel for
+        for(int roiY = 0; roiY < roiHeight; ++roiY)
+            for(int roiX = 0; roiX < roiWidth; ++roiX)
+                tmpOptDepthMap(roiX, roiY) = out_optimizeDepthSimMap(roiX, roiY).x();
+
+        // adjust depth/sim by using previously computed depths
+#pragma omp parallel for
+        for(int roiY = 0; roiY < roiHeight; ++roiY)
+        {
+            for(int roiX = 0; roiX < roiWidth; ++roiX)
+            {
+                // SGM upscale (rough) depth/pixSize
+                const Vec2f& sgmDepthPixSize = in_sgmDepthPixSizeMap(roiX, roiY);
+                const float sgmDepth = sgmDepthPixSize.x();
+                const float sgmPixSize = sgmDepthPixSize.y();
+
+                // refined and fused (fine) depth/sim
+                const Vec2f& refineDepthSim = in_refineDepthSimMap(roiX, roiY);
+                const float refineDepth = refineDepthSim.x();
+                const float refineSim = refineDepthSim.y();
+
+                // output optimized depth/sim
+                Vec2f& out_optDepthSimRef = out_optimizeDepthSimMap(roiX, roiY);
+                Vec2f out_optDepthSim = (iter == 0) ? Vec2f(sgmDepth, refineSim) : out_optDepthSimRef;
+                const float depthOpt = out_optDepthSim.x();
+
+                if(depthOpt > 0.0f)
+                {
+                    const Vec2f depthSmoothStepEnergy = getCellSmoothStepEnergy(rcCamParams, tmpOptDepthMap, roiX, roiY, roiWidth, roiHeight, offsetRoi); // (smoothStep, energy)
+                    float stepToSmoothDepth = depthSmoothStepEnergy.x();
+                    stepToSmoothDepth = std::copysign(std::min(std::abs(stepToSmoothDepth), sgmPixSize / 10.0f), stepToSmoothDepth);
+                    const float depthEnergy = depthSmoothStepEnergy.y(); // max angle with neighbors
+                    float stepToFineDM = refineDepth - depthOpt; // distance to refined/noisy input depth map
+                    stepToFineDM = std::copysign(std::min(std::abs(stepToFineDM), sgmPixSize / 10.0f), stepToFineDM);
+
+                    const float stepToRoughDM = sgmDepth - depthOpt; // distance to smooth/robust input depth map
+                    const float imgColorVariance = imgVarianceMap(roiX, roiY);
+                    const float colorVarianceThresholdForSmoothing = 20.0f;
+                    const float angleThresholdForSmoothing = 30.0f;
+
+                    const float weightedColorVariance = cpu::sigmoid2(5.0f, angleThresholdForSmoothing, 40.0f, colorVarianceThresholdForSmoothing, imgColorVariance);
+                    const float fineSimWeight = cpu::sigmoid(0.0f, 1.0f, 0.7f, -0.7f, refineSim);
+
+                    // if geometry variation is bigger than color variation => the fineDM is considered noisy
+                    const float energyLowerThanVarianceWeight = cpu::sigmoid(0.0f, 1.0f, 30.0f, weightedColorVariance, depthEnergy);
+                    const float closeToRoughWeight = 1.0f - cpu::sigmoid(0.0f, 1.0f, 10.0f, 17.0f, std::abs(stepToRoughDM / sgmPixSize));
+
+                    // f(z) = c1 * s1(z_rought - z)^2 + c2 * s2(z-z_fused)^2 + coeff3 * s3*(z-z_smooth)^2
+                    const float depthOptStep = closeToRoughWeight * stepToRoughDM + // distance to smooth/robust input depth map
+                                               (1.0f - closeToRoughWeight) * (energyLowerThanVarianceWeight * fineSimWeight * stepToFineDM + // distance to refined/noisy
+                                                                             (1.0f - energyLowerThanVarianceWeight) * stepToSmoothDepth); // max angle in current depthMap
+
+                    out_optDepthSim.x() = depthOpt + depthOptStep;
+                    out_optDepthSim.y() = (1.0f - closeToRoughWeight) * (energyLowerThanVarianceWeight * fineSimWeight * refineSim + (1.0f - energyLowerThanVarianceWeight) * (depthEnergy / 20.0f));
+                }
+
+                out_optDepthSimRef = out_optDepthSim;
+            }
+        }
+    }
+}
+
+} // namespace depthMap
+} // namespace aliceVision
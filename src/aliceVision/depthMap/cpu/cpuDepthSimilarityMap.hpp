@@ -0,0 +1,79 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/mvsData/ROI.hpp>
+#include <aliceVision/depthMap/SgmParams.hpp>
+#include <aliceVision/depthMap/RefineParams.hpp>
+#include <aliceVision/depthMap/cpu/CpuBuffer.hpp>
+#include <aliceVision/depthMap/cpu/CpuCameraParams.hpp>
+#include <aliceVision/depthMap/cpu/CpuMipmapImage.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Copy depth and default from input depth/sim map to another depth/sim map.
+ * @note Host version of cuda_depthSimMapCopyDepthOnly.
+ * @param[out] out_depthSimMap the output depth/sim map
+ * @param[in] in_depthSimMap the input depth/sim map to copy
+ * @param[in] defaultSim the default similarity value to copy
+ */
+void cpu_depthSimMapCopyDepthOnly(CpuMap<Vec2f>& out_depthSimMap,
+                                  const CpuMap<Vec2f>& in_depthSimMap,
+                                  float defaultSim);
+
+/**
+ * @brief Smooth thickness map with adjacent pixels.
+ * @note Host version of cuda_depthThicknessSmoothThickness.
+ * @param[in,out] inout_depthThicknessMap the depth/thickness map
+ * @param[in] sgmParams the SGM parameters
+ * @param[in] refineParams the Refine parameters
+ * @param[in] roi the 2d region of interest
+ */
+void cpu_depthThicknessSmoothThickness(CpuMap<Vec2f>& inout_depthThicknessMap,
+                                       const SgmParams& sgmParams,
+                                       const RefineParams& refineParams,
+                                       const ROI& roi);
+
+/**
+ * @brief Upscale the given SGM depth/thickness map, filter masked pixels and compute pixSize from thickness.
+ * @note Host version of cuda_computeSgmUpscaledDepthPixSizeMap (nearest neighbor interpolation only).
+ * @param[out] out_upscaledDepthPixSizeMap the output upscaled depth/pixSize map
+ * @param[in] in_sgmDepthThicknessMap the input SGM depth/thickness map
+ * @param[in] rcMipmapImage the R mipmap image
+ * @param[in] refineParams the Refine parameters
+ * @param[in] roi the 2d region of interest
+ */
+void cpu_computeSgmUpscaledDepthPixSizeMap(CpuMap<Vec2f>& out_upscaledDepthPixSizeMap,
+                                           const CpuMap<Vec2f>& in_sgmDepthThicknessMap,
+                                           const CpuMipmapImage& rcMipmapImage,
+                                           const RefineParams& refineParams,
+                                           const ROI& roi);
+
+/**
+ * @brief Optimize a depth/sim map with the refineFused depth/sim map and the SGM depth/pixSize map.
+ * @note Host version of cuda_depthSimMapOptimizeGradientDescent.
+ * @param[out] out_optimizeDepthSimMap the output optimized depth/sim map
+ * @param[in] in_sgmDepthPixSizeMap the input SGM upscaled depth/pixSize map
+ * @param[in] in_refineDepthSimMap the input refined and fused depth/sim map
+ * @param[in] rcCamParams the R camera parameters at Refine scale
+ * @param[in] rcMipmapImage the R mipmap image
+ * @param[in] refineParams the Refine parameters
+ * @param[in] roi the 2d region of interest
+ */
+void cpu_depthSimMapOptimizeGradientDescent(CpuMap<Vec2f>& out_optimizeDepthSimMap,
+                                            const CpuMap<Vec2f>& in_sgmDepthPixSizeMap,
+                                            const CpuMap<Vec2f>& in_refineDepthSimMap,
+                                            const CpuCameraParams& rcCamParams,
+                                            const CpuMipmapImage& rcMipmapImage,
+                                            const RefineParams& refineParams,
+                                            const ROI& roi);
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,492 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "cpuSimilarityVolume.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/depthMap/cpu/patch.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace aliceVision {
+namespace depthMap {
+
+void cpu_volumeComputeSimilarity(CpuVolume<TSimCpu>& out_volBestSim,
+                                 CpuVolume<TSimCpu>& out_volSecBestSim,
+                                 const std::vector<float>& in_depths,
+                                 const CpuCameraParams& rcCamParams,
+                                 const CpuCameraParams& tcCamParams,
+                                 const CpuMipmapImage& rcMipmapImage,
+                                 const CpuMipmapImage& tcMipmapImage,
+                                 const SgmParams& sgmParams,
+                                 const Range& depthRange,
+                                 const ROI& roi)
+{
+    // get R and T mipmap image level and dimensions
+    const float rcMipmapLevel = rcMipmapImage.getLevel(sgmParams.scale);
+
+    int rcLevelWidth, rcLevelHeight, tcLevelWidth, tcLevelHeight;
+    rcMipmapImage.getDimensions(sgmParams.scale, rcLevelWidth, rcLevelHeight);
+    tcMipmapImage.getDimensions(sgmParams.scale, tcLevelWidth, tcLevelHeight);
+
+    const float invGammaC = 1.f / float(sgmParams.gammaC);
+    const float invGammaP = 1.f / float(sgmParams.gammaP);
+
+    const int roiWidth = int(roi.width());
+    const int roiHeight = int(roi.height());
+
+#pragma omp parallel for schedule(dynamic)
+    for(int vy = 0; vy < roiHeight; ++vy)
+    {
+        for(int vx = 0; vx < roiWidth; ++vx)
+        {
+            // corresponding image coordinates
+            const Vec2f pix(float(roi.x.begin + vx) * float(sgmParams.stepXY),
+                            float(roi.y.begin + vy) * float(sgmParams.stepXY));
+
+            TSimCpu* volBestSimColumn = out_volBestSim.getColumn(vx, vy);
+            TSimCpu* volSecBestSimColumn = out_volSecBestSim.getColumn(vx, vy);
+
+            for(unsigned int vz = depthRange.begin; vz < depthRange.end; ++vz)
+            {
+                // compute patch
+                cpu::Patch patch;
+                patch.p = cpu::get3DPointForPixelAndFrontoParellePlaneRC(rcCamParams, pix, in_depths[vz]);
+                patch.d = cpu::computePixSize(rcCamParams, patch.p);
+                cpu::computeRotCSEpip(patch, rcCamParams, tcCamParams);
+
+                // we do not need positive and filtered similarity values
+                float fsim = cpu::compNCCby3DptsYK<false>(rcCamParams,
+                                                          tcCamParams,
+                                                          rcMipmapImage,
+                                                          tcMipmapImage,
+                                                          rcLevelWidth,
+                                                          rcLevelHeight,
+                                                          tcLevelWidth,
+                                                          tcLevelHeight,
+                                                          rcMipmapLevel,
+                                                          sgmParams.wsh,
+                                                          invGammaC,
+                                                          invGammaP,
+                                                          sgmParams.useConsistentScale,
+                                                          patch);
+
+                if(fsim == cpu::invalidSim) // invalid similarity
+                {
+                    fsim = 255.0f; // 255 is the invalid similarity value
+                }
+                else
+                {
+                    // remap similarity value from (-1, 1) to (0, 254)
+                    // 255 is reserved for the similarity initialization, i.e. undefined values
+                    fsim = std::min(1.0f, std::max(0.0f, (fsim + 1.0f) * 0.5f)) * 254.0f;
+                }
+
+                TSimCpu& fsim1st = volBestSimColumn[vz];
+                TSimCpu& fsim2nd = volSecBestSimColumn[vz];
+
+                if(fsim < fsim1st)
+                {
+                    fsim2nd = fsim1st;
+                    fsim1st = TSimCpu(fsim);
+                }
+                else if(fsim < fsim2nd)
+                {
+                    fsim2nd = TSimCpu(fsim);
+                }
+            }
+        }
+    }
+}
+
+void cpu_volumeUpdateUninitializedSimilarity(const CpuVolume<TSimCpu>& in_volBestSim,
+                                             CpuVolume<TSimCpu>& inout_volSecBestSim)
+{
+    const int dimX = inout_volSecBestSim.getDimX();
+    const int dimZ = inout_volSecBestSim.getDimZ();
+
+#pragma omp parallel for
+    for(int y = 0; y < inout_volSecBestSim.getDimY(); ++y)
+    {
+        for(int x = 0; x < dimX; ++x)
+        {
+            const TSimCpu* bestColumn = in_volBestSim.getColumn(x, y);
+            TSimCpu* secBestColumn = inout_volSecBestSim.getColumn(x, y);
+
+            for(int z = 0; z < dimZ; ++z)
+            {
+                // invalid or uninitialized similarity value
+                if(secBestColumn[z] >= 255)
+                    secBestColumn[z] = bestColumn[z];
+            }
+        }
+    }
+}
+
+void cpu_volumeOptimize(CpuVolume<TSimCpu>& out_volSimFiltered,
+                        const CpuVolume<TSimCpu>& in_volSim,
+                        const CpuMipmapImage& rcMipmapImage,
+                        const SgmParams& sgmParams,
+                        int lastDepthIndex,
+                        const ROI& roi)
+{
+    // get R mipmap image level and dimensions
+    const float rcMipmapLevel = rcMipmapImage.getLevel(sgmParams.scale);
+
+    int rcLevelWidth, rcLevelHeight;
+    rcMipmapImage.getDimensions(sgmParams.scale, rcLevelWidth, rcLevelHeight);
+
+    const int dimX = in_volSim.getDimX();
+    const int dimY = in_volSim.getDimY();
+    const int dimZ = lastDepthIndex;
+    const int step = sgmParams.stepXY;
+    const float P1 = float(sgmParams.p1);
+    const float P2Weighting = float(sgmParams.p2Weighting);
+
+    // aggregate one path direction
+    // filtering along the given axis ('X' or 'Y'), forward or backward
+    const auto aggregatePath = [&](bool alongX, bool invert, int filteringIndex)
+    {
+        const int nbLines  = alongX ? dimY : dimX;
+        const int lineSize = alongX ? dimX : dimY;
+        const int dirSign  = invert ? -1 : 1;
+
+#pragma omp parallel
+        {
+            // per-thread path cost buffers
+            std::vector<TSimAccCpu> pathCostPrev(dimZ);
+            std::vector<TSimAccCpu> pathCostCurr(dimZ);
+
+#pragma omp for schedule(static)
+            for(int line = 0; line < nbLines; ++line)
+            {
+                const auto getVoxelXY = [&](int i, int& x, int& y)
+                {
+                    const int pos = invert ? (lineSize - 1 - i) : i;
+                    x = alongX ? pos : line;
+                    y = alongX ? line : pos;
+                };
+
+                // first voxel of the path: copy input similarity, set output at 255
+                {
+                    int x, y;
+                    getVoxelXY(0, x, y);
+
+                    const TSimCpu* inColumn = in_volSim.getColumn(x, y);
+                    TSimCpu* outColumn = out_volSimFiltered.getColumn(x, y);
+
+                    for(int z = 0; z < dimZ; ++z)
+                    {
+                        pathCostPrev[z] = TSimAccCpu(inColumn[z]);
+                        outColumn[z] = TSimCpu(255);
+                    }
+                }
+
+                for(int i = 1; i < lineSize; ++i)
+                {
+                    int x, y;
+                    getVoxelXY(i, x, y);
+
+                    // best cost of the previous voxel column
+                    const TSimAccCpu bestCostPrev = *std::min_element(pathCostPrev.begin(), pathCostPrev.end());
+
+                    // compute P2
+                    float P2 = 0.f;
+
+                    if(P2Weighting < 0.f)
+                    {
+                        // P2 convention: use negative value to skip the use of deltaC.
+                        P2 = std::abs(P2Weighting);
+                    }
+                    else
+                    {
+                        const int imX0 = (roi.x.begin + x) * step; // current
+                        const int imY0 = (roi.y.begin + y) * step;
+                        const int imX1 = imX0 - dirSign * step * int(alongX); // previous on the path
+                        const int imY1 = imY0 - dirSign * step * int(!alongX);
+
+                        const image::RGBAfColor gcr0 = rcMipmapImage.sample((float(imX0) + 0.5f) / float(rcLevelWidth), (float(imY0) + 0.5f) / float(rcLevelHeight), rcMipmapLevel);
+                        const image::RGBAfColor gcr1 = rcMipmapImage.sample((float(imX1) + 0.5f) / float(rcLevelWidth), (float(imY1) + 0.5f) / float(rcLevelHeight), rcMipmapLevel);
+                        const float deltaC = cpu::euclideanDist3(gcr0, gcr1);
+
+                        // sigmoid f(x) = i + (a - i) * (1 / ( 1 + e^(10 * (x - P2) / w)))
+                        // best values found from tests: i = 80, a = 255, w = 80, P2 = 100
+                        P2 = cpu::sigmoid(80.f, 255.f, 80.f, P2Weighting, deltaC);
+                    }
+
+                    const TSimCpu* inColumn = in_volSim.getColumn(x, y);
+                    TSimCpu* outColumn = out_volSimFiltered.getColumn(x, y);
+
+                    for(int z = 0; z < dimZ; ++z)
+                    {
+                        float pathCost = 255.0f;
+
+                        if((z >= 1) && (z < dimZ - 1))
+                        {
+                            const float minCost = std::min(std::min(float(pathCostPrev[z]), float(pathCostPrev[z - 1]) + P1),
+                                                           std::min(float(pathCostPrev[z + 1]) + P1, float(bestCostPrev) + P2));
+
+                            pathCost = float(inColumn[z]) + minCost - float(bestCostPrev);
+                        }
+
+                        pathCostCurr[z] = TSimAccCpu(pathCost);
+
+                        // clamp (TSimCpu = uchar)
+                        pathCost = std::min(255.0f, std::max(0.0f, pathCost));
+
+                        // aggregate into the final output
+                        const float val = (float(outColumn[z]) * float(filteringIndex) + pathCost) / float(filteringIndex + 1);
+                        outColumn[z] = TSimCpu(val);
+                    }
+
+                    std::swap(pathCostPrev, pathCostCurr);
+                }
+            }
+        }
+    };
+
+    int npaths = 0;
+
+    for(char axis : sgmParams.filteringAxes)
+    {
+        const bool alongX = (axis == 'X');
+        aggregatePath(alongX, false, npaths++); // without transpose
+        aggregatePath(alongX, true,  npaths++); // with transpose of the last axis
+    }
+}
+
+void cpu_volumeRetrieveBestDepth(CpuMap<Vec2f>& out_sgmDepthThicknessMap,
+                                 CpuMap<Vec2f>* out_sgmDepthSimMap,
+                                 const std::vector<float>& in_depths,
+                                 const CpuVolume<TSimCpu>& in_volSim,
+                                 const CpuCameraParams& rcCamParams,
+                                 const SgmParams& sgmParams,
+                                 const Range& depthRange,
+                                 const ROI& roi)
+{
+    const int scaleStep = sgmParams.scale * sgmParams.stepXY;
+    const float thicknessMultFactor = 1.f + float(sgmParams.depthThicknessInflate);
+    const float maxSimilarity = float(sgmParams.maxSimilarity) * 254.f; // convert from (0, 1) to (0, 254)
+    const int volDimZ = int(in_depths.size());
+
+    const int roiWidth = int(roi.width());
+    const int roiHeight = int(roi.height());
+
+#pragma omp parallel for
+    for(int vy = 0; vy < roiHeight; ++vy)
+    {
+        for(int vx = 0; vx < roiWidth; ++vx)
+        {
+            const Vec2f pix(float((roi.x.begin + vx) * scaleStep), float((roi.y.begin + vy) * scaleStep));
+            const TSimCpu* column = in_volSim.getColumn(vx, vy);
+
+            // find the best depth plane index for the current pixel
+            float bestSim = 255.f;
+            int bestZIdx = -1;
+
+            for(int vz = int(depthRange.begin); vz < int(depthRange.end); ++vz)
+            {
+                const float simAtZ = float(column[vz]);
+
+                if(simAtZ < bestSim)
+                {
+                    bestSim = simAtZ;
+                    bestZIdx = vz;
+                }
+            }
+
+            // filtering out invalid values and values with a too bad score
+            if((bestZIdx == -1) || (bestSim > maxSimilarity))
+            {
+                out_sgmDepthThicknessMap(vx, vy) = Vec2f(-1.f, -1.f);
+
+                if(out_sgmDepthSimMap != nullptr)
+                    (*out_sgmDepthSimMap)(vx, vy) = Vec2f(-1.f, 1.f);
+
+                continue;
+            }
+
+            // find best depth plane previous and next indexes
+            const int bestZIdx_m1 = std::max(0, bestZIdx - 1);
+            const int bestZIdx_p1 = std::min(volDimZ - 1, bestZIdx + 1);
+
+            const float bestDepth    = cpu::depthPlaneToDepth(rcCamParams, in_depths[bestZIdx], pix);
+            const float bestDepth_m1 = cpu::depthPlaneToDepth(rcCamParams, in_depths[bestZIdx_m1], pix);
+            const float bestDepth_p1 = cpu::depthPlaneToDepth(rcCamParams, in_depths[bestZIdx_p1], pix);
+
+            const float out_bestSim = (bestSim / 255.0f) * 2.0f - 1.0f; // convert from (0, 255) to (-1, +1)
+            const float out_bestDepthThickness = std::max(bestDepth_p1 - bestDepth, bestDepth - bestDepth_m1) * thicknessMultFactor;
+
+            out_sgmDepthThicknessMap(vx, vy) = Vec2f(bestDepth, out_bestDepthThickness);
+
+            if(out_sgmDepthSimMap != nullptr)
+                (*out_sgmDepthSimMap)(vx, vy) = Vec2f(bestDepth, out_bestSim);
+        }
+    }
+}
+
+void cpu_volumeRefineSimilarity(CpuVolume<TSimRefineCpu>& inout_volSim,
+                                const CpuMap<Vec2f>& in_sgmDepthPixSizeMap,
+                                const CpuCameraParams& rcCamParams,
+                                const CpuCameraParams& tcCamParams,
+                                const CpuMipmapImage& rcMipmapImage,
+                                const CpuMipmapImage& tcMipmapImage,
+                                const RefineParams& refineParams,
+                                const Range& depthRange,
+                                const ROI& roi)
+{
+    // get R and T mipmap image level and dimensions
+    const float rcMipmapLevel = rcMipmapImage.getLevel(refineParams.scale);
+
+    int rcLevelWidth, rcLevelHeight, tcLevelWidth, tcLevelHeight;
+    rcMipmapImage.getDimensions(refineParams.scale, rcLevelWidth, rcLevelHeight);
+    tcMipmapImage.getDimensions(refineParams.scale, tcLevelWidth, tcLevelHeight);
+
+    const float invGammaC = 1.f / float(refineParams.gammaC);
+    const float invGammaP = 1.f / float(refineParams.gammaP);
+    const int volDimZ = inout_volSim.getDimZ();
+
+    const int roiWidth = int(roi.width());
+    const int roiHeight = int(roi.height());
+
+#pragma omp parallel for schedule(dynamic)
+    for(int vy = 0; vy < roiHeight; ++vy)
+    {
+        for(int vx = 0; vx < roiWidth; ++vx)
+        {
+            // corresponding input sgm depth/pixSize (middle depth)
+            const Vec2f& sgmDepthPixSize = in_sgmDepthPixSizeMap(vx, vy);
+
+            // sgm depth (middle depth) invalid or masked
+            if(sgmDepthPixSize.x() <= 0.0f)
+                continue;
+
+            // corresponding image coordinates
+            const Vec2f pix(float(roi.x.begin + vx) * float(refineParams.stepXY),
+                            float(roi.y.begin + vy) * float(refineParams.stepXY));
+
+            TSimRefineCpu* column = inout_volSim.getColumn(vx, vy);
+
+            for(unsigned int vz = depthRange.begin; vz < depthRange.end; ++vz)
+            {
+                // initialize rc 3d point at sgm depth (middle depth)
+                Vec3f p = cpu::get3DPointForPixelAndDepthFromRC(rcCamParams, pix, sgmDepthPixSize.x());
+
+                // move rc 3d point by relative depth index offset * sgm pixSize
+                const int relativeDepthIndexOffset = int(vz) - ((volDimZ - 1) / 2);
+
+                if(relativeDepthIndexOffset != 0)
+                    cpu::move3DPointByRcPixSize(p, rcCamParams, relativeDepthIndexOffset * sgmDepthPixSize.y());
+
+                // compute patch
+                cpu::Patch patch;
+                patch.p = p;
+                patch.d = cpu::computePixSize(rcCamParams, p);
+                cpu::computeRotCSEpip(patch, rcCamParams, tcCamParams);
+
+                // we need positive and filtered similarity values
+                const float fsimInvertedFiltered = cpu::compNCCby3DptsYK<true>(rcCamParams,
+                                                                               tcCamParams,
+                                                                               rcMipmapImage,
+                                                                               tcMipmapImage,
+                                                                               rcLevelWidth,
+                                                                               rcLevelHeight,
+                                                                               tcLevelWidth,
+                                                                               tcLevelHeight,
+                                                                               rcMipmapLevel,
+                                                                               refineParams.wsh,
+                                                                               invGammaC,
+                                                                               invGammaP,
+                                                                               refineParams.useConsistentScale,
+                                                                               patch);
+
+                if(fsimInvertedFiltered == cpu::invalidSim) // invalid similarity
+                    continue;
+
+                column[vz] += TSimRefineCpu(fsimInvertedFiltered);
+            }
+        }
+    }
+}
+
+void cpu_volumeRefineBestDepth(CpuMap<Vec2f>& out_refineDepthSimMap,
+                               const CpuMap<Vec2f>& in_sgmDepthPixSizeMap,
+                               const CpuVolume<TSimRefineCpu>& in_volSim,
+                               const RefineParams& refineParams,
+                               const ROI& roi)
+{
+    const int volDimZ = in_volSim.getDimZ();
+    const int samplesPerPixSize = refineParams.nbSubsamples;
+    const int halfNbDepths = refineParams.halfNbDepths;
+    const int halfNbSamples = refineParams.nbSubsamples * refineParams.halfNbDepths;
+    const float twoTimesSigmaPowerTwo = float(2.0 * refineParams.sigma * refineParams.sigma);
+
+    // precompute the sliding gaussian window weights
+    // weights[(sample + halfNbSamples) * volDimZ + vz]
+    std::vector<float> weights((2 * halfNbSamples + 1) * volDimZ);
+
+    for(int sample = -halfNbSamples; sample <= halfNbSamples; ++sample)
+    {
+        for(int vz = 0; vz < volDimZ; ++vz)
+        {
+            const int zs = (vz - halfNbDepths) * samplesPerPixSize; // relative sample offset
+            weights[(sample + halfNbSamples) * volDimZ + vz] = std::exp(-float((zs - sample) * (zs - sample)) / twoTimesSigmaPowerTwo);
+        }
+    }
+
+    const int roiWidth = int(roi.width());
+    const int roiHeight = int(roi.height());
+
+#pragma omp parallel for
+    for(int vy = 0; vy < roiHeight; ++vy)
+    {
+        for(int vx = 0; vx < roiWidth; ++vx)
+        {
+            const Vec2f& sgmDepthPixSize = in_sgmDepthPixSizeMap(vx, vy);
+
+            // sgm depth (middle depth) invalid or masked
+            if(sgmDepthPixSize.x() <= 0.0f)
+            {
+                out_refineDepthSimMap(vx, vy) = Vec2f(sgmDepthPixSize.x(), 1.0f);  // -1 (invalid) or -2 (masked)
+                continue;
+            }
+
+            const TSimRefineCpu* column = in_volSim.getColumn(vx, vy);
+
+            // find best z sample per pixel
+            float bestSampleSim = 0.f;      // all sample sim <= 0.f
+            int bestSampleOffsetIndex = 0;  // default is middle depth (SGM)
+
+            // sliding gaussian window
+            for(int sample = -halfNbSamples; sample <= halfNbSamples; ++sample)
+            {
+                const float* sampleWeights = &weights[(sample + halfNbSamples) * volDimZ];
+                float sampleSim = 0.f;
+
+                // the inverted similarity sum best value is the HIGHEST, reverse it
+                for(int vz = 0; vz < volDimZ; ++vz)
+                    sampleSim -= column[vz] * sampleWeights[vz];
+
+                if(sampleSim < bestSampleSim)
+                {
+                    bestSampleOffsetIndex = sample;
+                    bestSampleSim = sampleSim;
+                }
+            }
+
+            // compute best depth
+            // input sgm depth (middle depth) + sample size offset from z center
+            const float sampleSize = sgmDepthPixSize.y() / samplesPerPixSize;
+            const float bestDepth = sgmDepthPixSize.x() + bestSampleOffsetIndex * sampleSize;
+
+            out_refineDepthSimMap(vx, vy) = Vec2f(bestDepth, bestSampleSim);
+        }
+    }
+}
+
+} // namespace depthMap
+} // namespace aliceVision
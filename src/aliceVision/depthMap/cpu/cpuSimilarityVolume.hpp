@@ -0,0 +1,141 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/mvsData/ROI.hpp>
+#include <aliceVision/depthMap/SgmParams.hpp>
+#include <aliceVision/depthMap/RefineParams.hpp>
+#include <aliceVision/depthMap/cpu/CpuBuffer.hpp>
+#include <aliceVision/depthMap/cpu/CpuCameraParams.hpp>
+#include <aliceVision/depthMap/cpu/CpuMipmapImage.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/*
+ * @note TSimCpu is the similarity type for volume in host memory (same as default TSim).
+ * @note TSimAccCpu is the similarity accumulation type for volume in host memory.
+ * @note TSimRefineCpu is the similarity type for volume refinement in host memory.
+ */
+using TSimCpu = unsigned char;
+using TSimAccCpu = unsigned int;
+using TSimRefineCpu = float;
+
+/**
+ * @brief Compute the best / second best similarity volume for the given RcTc.
+ * @note Host version of cuda_volumeComputeSimilarity.
+ * @param[in,out] out_volBestSim the best similarity volume
+ * @param[in,out] out_volSecBestSim the second best similarity volume
+ * @param[in] in_depths the R camera depth list
+ * @param[in] rcCamParams the R camera parameters at SGM scale
+ * @param[in] tcCamParams the T camera parameters at SGM scale
+ * @param[in] rcMipmapImage the R mipmap image
+ * @param[in] tcMipmapImage the T mipmap image
+ * @param[in] sgmParams the Semi Global Matching parameters
+ * @param[in] depthRange the volume depth range to compute
+ * @param[in] roi the 2d region of interest
+ */
+void cpu_volumeComputeSimilarity(CpuVolume<TSimCpu>& out_volBestSim,
+                                 CpuVolume<TSimCpu>& out_volSecBestSim,
+                                 const std::vector<float>& in_depths,
+                                 const CpuCameraParams& rcCamParams,
+                                 const CpuCameraParams& tcCamParams,
+                                 const CpuMipmapImage& rcMipmapImage,
+                                 const CpuMipmapImage& tcMipmapImage,
+                                 const SgmParams& sgmParams,
+                                 const Range& depthRange,
+                                 const ROI& roi);
+
+/**
+ * @brief Update second best uninitialized similarity volume values with first best similarity volume values.
+ * @param[in] in_volBestSim the best similarity volume
+ * @param[in,out] inout_volSecBestSim the second best similarity volume
+ */
+void cpu_volumeUpdateUninitializedSimilarity(const CpuVolume<TSimCpu>& in_volBestSim,
+                                             CpuVolume<TSimCpu>& inout_volSecBestSim);
+
+/**
+ * @brief Filter / Optimize the given similarity volume (Semi-Global Matching aggregation).
+ * @note Host version of cuda_volumeOptimize, each path line is processed independently.
+ * @param[out] out_volSimFiltered the output similarity volume
+ * @param[in] in_volSim the input similarity volume
+ * @param[in] rcMipmapImage the R mipmap image
+ * @param[in] sgmParams the Semi Global Matching parameters
+ * @param[in] lastDepthIndex the R camera last depth index
+ * @param[in] roi the 2d region of interest
+ */
+void cpu_volumeOptimize(CpuVolume<TSimCpu>& out_volSimFiltered,
+                        const CpuVolume<TSimCpu>& in_volSim,
+                        const CpuMipmapImage& rcMipmapImage,
+                        const SgmParams& sgmParams,
+                        int lastDepthIndex,
+                        const ROI& roi);
+
+/**
+ * @brief Retrieve the best depth/sim in the given similarity volume.
+ * @note Host version of cuda_volumeRetrieveBestDepth.
+ * @param[out] out_sgmDepthThicknessMap the output depth/thickness map
+ * @param[out] out_sgmDepthSimMap the output best depth/sim map (or nullptr)
+ * @param[in] in_depths the R camera depth list
+ * @param[in] in_volSim the input similarity volume
+ * @param[in] rcCamParams the R camera parameters at full scale
+ * @param[in] sgmParams the Semi Global Matching parameters
+ * @param[in] depthRange the volume depth range to consider
+ * @param[in] roi the 2d region of interest
+ */
+void cpu_volumeRetrieveBestDepth(CpuMap<Vec2f>& out_sgmDepthThicknessMap,
+                                 CpuMap<Vec2f>* out_sgmDepthSimMap,
+                                 const std::vector<float>& in_depths,
+                                 const CpuVolume<TSimCpu>& in_volSim,
+                                 const CpuCameraParams& rcCamParams,
+                                 const SgmParams& sgmParams,
+                                 const Range& depthRange,
+                                 const ROI& roi);
+
+/**
+ * @brief Refine the best similarity volume for the given RcTc.
+ * @note Host version of cuda_volumeRefineSimilarity.
+ * @param[in,out] inout_volSim the similarity volume in host memory
+ * @param[in] in_sgmDepthPixSizeMap the SGM upscaled depth/pixSize map
+ * @param[in] rcCamParams the R camera parameters at Refine scale
+ * @param[in] tcCamParams the T camera parameters at Refine scale
+ * @param[in] rcMipmapImage the R mipmap image
+ * @param[in] tcMipmapImage the T mipmap image
+ * @param[in] refineParams the Refine parameters
+ * @param[in] depthRange the volume depth range to compute
+ * @param[in] roi the 2d region of interest
+ */
+void cpu_volumeRefineSimilarity(CpuVolume<TSimRefineCpu>& inout_volSim,
+                                const CpuMap<Vec2f>& in_sgmDepthPixSizeMap,
+                                const CpuCameraParams& rcCamParams,
+                                const CpuCameraParams& tcCamParams,
+                                const CpuMipmapImage& rcMipmapImage,
+                                const CpuMipmapImage& tcMipmapImage,
+                                const RefineParams& refineParams,
+                                const Range& depthRange,
+                                const ROI& roi);
+
+/**
+ * @brief Retrieve the best depth/sim in the given refined similarity volume.
+ * @note Host version of cuda_volumeRefineBestDepth.
+ * @param[out] out_refineDepthSimMap the output refined and fused depth/sim map
+ * @param[in] in_sgmDepthPixSizeMap the SGM upscaled depth/pixSize map
+ * @param[in] in_volSim the similarity volume
+ * @param[in] refineParams the Refine parameters
+ * @param[in] roi the 2d region of interest
+ */
+void cpu_volumeRefineBestDepth(CpuMap<Vec2f>& out_refineDepthSimMap,
+                               const CpuMap<Vec2f>& in_sgmDepthPixSizeMap,
+                               const CpuVolume<TSimRefineCpu>& in_volSim,
+                               const RefineParams& refineParams,
+                               const ROI& roi);
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,327 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/depthMap/cpu/CpuCameraParams.hpp>
+#include <aliceVision/depthMap/cpu/CpuMipmapImage.hpp>
+
+#include <cmath>
+#include <limits>
+
+// host counterparts of the CUDA alpha thresholds (texture range (0, 255))
+#define ALICEVISION_DEPTHMAP_CPU_RC_MIN_ALPHA (255.f * 0.9f)
+#define ALICEVISION_DEPTHMAP_CPU_TC_MIN_ALPHA (255.f * 0.4f)
+
+namespace aliceVision {
+namespace depthMap {
+namespace cpu {
+
+/*
+ * @note Host versions of the device functions in cuda/device/Patch.cuh, matrix.cuh and SimStat.cuh.
+ *       They are kept numerically equivalent in order to produce depth/sim maps
+ *       matching the GPU output within tolerance.
+ */
+
+constexpr float invalidSim = std::numeric_limits<float>::infinity();
+
+struct Patch
+{
+    Vec3f p; //< 3d point
+    Vec3f n; //< normal
+    Vec3f x; //< x axis
+    Vec3f y; //< y axis
+    float d; //< pixel size
+};
+
+inline Vec2f project3DPoint(const CpuCameraParams& camParams, const Vec3f& p)
+{
+    const Vec3f hp = camParams.P.leftCols<3>() * p + camParams.P.col(3);
+    const float pzInv = 1.f / hp.z();
+    return Vec2f(hp.x() * pzInv, hp.y() * pzInv);
+}
+
+inline Vec3f pixelToRay(const CpuCameraParams& camParams, const Vec2f& pix)
+{
+    return (camParams.iP * Vec3f(pix.x(), pix.y(), 1.f)).normalized();
+}
+
+inline Vec3f linePlaneIntersect(const Vec3f& linePoint, const Vec3f& lineVect, const Vec3f& planePoint, const Vec3f& planeNormal)
+{
+    const float k = (planePoint.dot(planeNormal) - planeNormal.dot(linePoint)) / planeNormal.dot(lineVect);
+    return linePoint + lineVect * k;
+}
+
+inline Vec3f closestPointToLine3D(const Vec3f& point, const Vec3f& linePoint, const Vec3f& lineVectNormalized)
+{
+    return linePoint + lineVectNormalized * lineVectNormalized.dot(point - linePoint);
+}
+
+inline float pointLineDistance3D(const Vec3f& point, const Vec3f& linePoint, const Vec3f& lineVectNormalized)
+{
+    return lineVectNormalized.cross(linePoint - point).norm();
+}
+
+inline float angleBetwABandAC(const Vec3f& A, const Vec3f& B, const Vec3f& C)
+{
+    const Vec3f V1 = (B - A).normalized();
+    const Vec3f V2 = (C - A).normalized();
+
+    double a = std::acos(double(V1.dot(V2)));
+    a = std::isinf(a) ? 0.0 : a;
+    return float(std::abs(a) / (M_PI / 180.0));
+}
+
+inline float sigmoid(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((xval - sigMid) / sigwidth))));
+}
+
+inline float sigmoid2(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((sigMid - xval) / sigwidth))));
+}
+
+inline Vec3f get3DPointForPixelAndFrontoParellePlaneRC(const CpuCameraParams& camParams, const Vec2f& pix, float fpPlaneDepth)
+{
+    const Vec3f planep = camParams.C + camParams.ZVect * fpPlaneDepth;
+    return linePlaneIntersect(camParams.C, pixelToRay(camParams, pix), planep, camParams.ZVect);
+}
+
+inline Vec3f get3DPointForPixelAndDepthFromRC(const CpuCameraParams& camParams, const Vec2f& pix, float depth)
+{
+    return camParams.C + pixelToRay(camParams, pix) * depth;
+}
+
+inline float depthPlaneToDepth(const CpuCameraParams& camParams, float fpPlaneDepth, const Vec2f& pix)
+{
+    return (camParams.C - get3DPointForPixelAndFrontoParellePlaneRC(camParams, pix, fpPlaneDepth)).norm();
+}
+
+inline void move3DPointByRcPixSize(Vec3f& p, const CpuCameraParams& rcCamParams, float rcPixSize)
+{
+    const Vec3f rpv = (p - rcCamParams.C).normalized();
+    p = p + rpv * rcPixSize;
+}
+
+inline float computePixSize(const CpuCameraParams& camParams, const Vec3f& p)
+{
+    const Vec2f rp1 = project3DPoint(camParams, p) + Vec2f(1.f, 0.f);
+    return pointLineDistance3D(p, camParams.C, pixelToRay(camParams, rp1));
+}
+
+inline void computeRotCSEpip(Patch& patch, const CpuCameraParams& rcCamParams, const CpuCameraParams& tcCamParams)
+{
+    // vector from the reference camera to the 3d point
+    const Vec3f v1 = (rcCamParams.C - patch.p).normalized();
+    // vector from the target camera to the 3d point
+    const Vec3f v2 = (tcCamParams.C - patch.p).normalized();
+
+    // y has to be ortogonal to the epipolar plane
+    // n has to be on the epipolar plane
+    // x has to be on the epipolar plane
+    patch.y = v1.cross(v2).normalized();
+    patch.n = ((v1 + v2) / 2.0f).normalized();
+    patch.x = patch.y.cross(patch.n).normalized();
+}
+
+inline void computeRcTcMipmapLevels(float& out_rcMipmapLevel,
+                                    float& out_tcMipmapLevel,
+                                    float mipmapLevel,
+                                    const CpuCameraParams& rcCamParams,
+                                    const CpuCameraParams& tcCamParams,
+                                    const Vec2f& rp0,
+                                    const Vec2f& tp0,
+                                    const Vec3f& p0)
+{
+    // get p0 depth from the R and T cameras
+    const float rcDepth = (rcCamParams.C - p0).norm();
+    const float tcDepth = (tcCamParams.C - p0).norm();
+
+    // get R and T p0 corresponding pixel + 1x 3d points
+    const Vec3f prp1 = rcCamParams.C + pixelToRay(rcCamParams, rp0 + Vec2f(1.f, 0.f)) * rcDepth;
+    const Vec3f ptp1 = tcCamParams.C + pixelToRay(tcCamParams, tp0 + Vec2f(1.f, 0.f)) * tcDepth;
+
+    // compute Rc/Tc distance factor
+    const float distFactor = (p0 - prp1).norm() / (p0 - ptp1).norm();
+
+    if(distFactor < 1.f)
+    {
+        // T camera has a lower resolution (1 Rc pixSize < 1 Tc pixSize)
+        out_tcMipmapLevel = mipmapLevel - std::log2(1.f / distFactor);
+
+        if(out_tcMipmapLevel < 0.f)
+        {
+            out_rcMipmapLevel = mipmapLevel + std::abs(out_tcMipmapLevel);
+            out_tcMipmapLevel = 0.f;
+        }
+    }
+    else
+    {
+        // T camera has a higher resolution (1 Rc pixSize > 1 Tc pixSize)
+        out_rcMipmapLevel = mipmapLevel;
+        out_tcMipmapLevel = mipmapLevel + std::log2(distFactor);
+    }
+}
+
+inline float euclideanDist3(const image::RGBAfColor& c1, const image::RGBAfColor& c2)
+{
+    const float dx = c1.r() - c2.r();
+    const float dy = c1.g() - c2.g();
+    const float dz = c1.b() - c2.b();
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/**
+ * @brief Yoon & Kweon adaptive support weight from CIELAB colors and pixel distance.
+ */
+inline float costYKfromLab(int dx, int dy, const image::RGBAfColor& c1, const image::RGBAfColor& c2, float invGammaC, float invGammaP)
+{
+    const float deltaC = euclideanDist3(c1, c2) * invGammaC;
+    const float deltaP = std::sqrt(float(dx * dx + dy * dy)) * invGammaP;
+    return std::exp(-(deltaC + deltaP));
+}
+
+/**
+ * @brief Weighted similarity statistics (host version of simStat).
+ */
+struct SimStat
+{
+    float xsum = 0.f;
+    float ysum = 0.f;
+    float xxsum = 0.f;
+    float yysum = 0.f;
+    float xysum = 0.f;
+    float wsum = 0.f;
+
+    inline void update(float gx, float gy, float w)
+    {
+        wsum += w;
+        xsum += w * gx;
+        ysum += w * gy;
+        xxsum += w * gx * gx;
+        yysum += w * gy * gy;
+        xysum += w * gx * gy;
+    }
+
+    /**
+     * @brief Compute Normalized Cross-Correlation.
+     * @return similarity value in range (-1, 0) or 1 if infinity
+     */
+    inline float computeWSim() const
+    {
+        const float varX  = (xxsum - xsum * xsum / wsum) / wsum;
+        const float varY  = (yysum - ysum * ysum / wsum) / wsum;
+        const float varXY = (xysum - xsum * ysum / wsum) / wsum;
+        const float rawSim = varXY / std::sqrt(varX * varY);
+        return std::isfinite(rawSim) ? -rawSim : 1.0f;
+    }
+};
+
+/**
+ * @brief Compute Normalized Cross-Correlation of a full square patch at given half-width.
+ * @note Host version of compNCCby3DptsYK, see cuda/device/Patch.cuh.
+ * @tparam TInvertAndFilter invert and filter output similarity value
+ * @return similarity value in range (-1.f, 0.f) or (0.f, 1.f) if TinvertAndFilter enabled
+ *         or cpu::invalidSim if invalid/uninitialized/masked
+ */
+template<bool TInvertAndFilter>
+inline float compNCCby3DptsYK(const CpuCameraParams& rcCamParams,
+                              const CpuCameraParams& tcCamParams,
+                              const CpuMipmapImage& rcMipmapImage,
+                              const CpuMipmapImage& tcMipmapImage,
+                              int rcLevelWidth,
+                              int rcLevelHeight,
+                              int tcLevelWidth,
+                              int tcLevelHeight,
+                              float mipmapLevel,
+                              int wsh,
+                              float invGammaC,
+                              float invGammaP,
+                              bool useConsistentScale,
+                              const Patch& patch)
+{
+    // get R and T image 2d coordinates from patch center 3d point
+    const Vec2f rp = project3DPoint(rcCamParams, patch.p);
+    const Vec2f tp = project3DPoint(tcCamParams, patch.p);
+
+    // image 2d coordinates margin
+    const float dd = wsh + 2.0f;
+
+    // check R and T image 2d coordinates
+    if((rp.x() < dd) || (rp.x() > float(rcLevelWidth  - 1) - dd) ||
+       (tp.x() < dd) || (tp.x() > float(tcLevelWidth  - 1) - dd) ||
+       (rp.y() < dd) || (rp.y() > float(rcLevelHeight - 1) - dd) ||
+       (tp.y() < dd) || (tp.y() > float(tcLevelHeight - 1) - dd))
+    {
+        return invalidSim; // uninitialized
+    }
+
+    // compute inverse width / height (normalized coordinates)
+    const float rcInvLevelWidth  = 1.f / float(rcLevelWidth);
+    const float rcInvLevelHeight = 1.f / float(rcLevelHeight);
+    const float tcInvLevelWidth  = 1.f / float(tcLevelWidth);
+    const float tcInvLevelHeight = 1.f / float(tcLevelHeight);
+
+    // initialize R and T mipmap image level at the given mipmap image level
+    float rcMipmapLevel = mipmapLevel;
+    float tcMipmapLevel = mipmapLevel;
+
+    // update R and T mipmap image level in order to get consistent scale patch comparison
+    if(useConsistentScale)
+        computeRcTcMipmapLevels(rcMipmapLevel, tcMipmapLevel, mipmapLevel, rcCamParams, tcCamParams, rp, tp, patch.p);
+
+    // compute patch center color (CIELAB) at R and T mipmap image level
+    const image::RGBAfColor rcCenterColor = rcMipmapImage.sample((rp.x() + 0.5f) * rcInvLevelWidth, (rp.y() + 0.5f) * rcInvLevelHeight, rcMipmapLevel);
+    const image::RGBAfColor tcCenterColor = tcMipmapImage.sample((tp.x() + 0.5f) * tcInvLevelWidth, (tp.y() + 0.5f) * tcInvLevelHeight, tcMipmapLevel);
+
+    // check the alpha values of the patch pixel center of the R and T cameras
+    if(rcCenterColor.a() < ALICEVISION_DEPTHMAP_CPU_RC_MIN_ALPHA || tcCenterColor.a() < ALICEVISION_DEPTHMAP_CPU_TC_MIN_ALPHA)
+        return invalidSim; // masked
+
+    SimStat sst;
+
+    // compute patch (wsh*2+1)x(wsh*2+1)
+    for(int yp = -wsh; yp <= wsh; ++yp)
+    {
+        for(int xp = -wsh; xp <= wsh; ++xp)
+        {
+            // get 3d point
+            const Vec3f p = patch.p + patch.x * (patch.d * float(xp)) + patch.y * (patch.d * float(yp));
+
+            // get R and T image 2d coordinates from 3d point
+            const Vec2f rpc = project3DPoint(rcCamParams, p);
+            const Vec2f tpc = project3DPoint(tcCamParams, p);
+
+            // get R and T image color (CIELAB) from 2d coordinates
+            const image::RGBAfColor rcPatchCoordColor = rcMipmapImage.sample((rpc.x() + 0.5f) * rcInvLevelWidth, (rpc.y() + 0.5f) * rcInvLevelHeight, rcMipmapLevel);
+            const image::RGBAfColor tcPatchCoordColor = tcMipmapImage.sample((tpc.x() + 0.5f) * tcInvLevelWidth, (tpc.y() + 0.5f) * tcInvLevelHeight, tcMipmapLevel);
+
+            // compute weighting based on color difference and distance to the patch center
+            const float w = costYKfromLab(xp, yp, rcCenterColor, rcPatchCoordColor, invGammaC, invGammaP) *
+                            costYKfromLab(xp, yp, tcCenterColor, tcPatchCoordColor, invGammaC, invGammaP);
+
+            // update simStat
+            sst.update(rcPatchCoordColor.r(), tcPatchCoordColor.r(), w);
+        }
+    }
+
+    if(TInvertAndFilter)
+    {
+        // invert and filter similarity
+        // best similarity value was -1, worst was 0
+        // best similarity value is 1, worst is still 0
+        return sigmoid(0.0f, 1.0f, 0.7f, -0.7f, sst.computeWSim());
+    }
+
+    // compute output patch similarity
+    return sst.computeWSim();
+}
+
+} // namespace cpu
+} // namespace depthMap
+} // namespace aliceVision
@@ -19,10 +19,11 @@ int listCudaDevices()
 
     // determine the number of CUDA capable GPUs
     cudaError_t err = cudaGetDeviceCount(&nbDevices);
-    CHECK_CUDA_ERROR();
     if(err != cudaSuccess)
     {
-        ALICEVISION_LOG_ERROR("Cannot get CUDA device count.");
+        // reset the last error, no CUDA device is not fatal (CPU fallback)
+        cudaGetLastError();
+        ALICEVISION_LOG_ERROR("Cannot get CUDA device count: " << cudaGetErrorString(err));
         return 0;
     }
 
@@ -0,0 +1,590 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/depthMap/BufPtr.hpp>
+#include <aliceVision/depthMap/DepthMapEstimator.hpp>
+#include <aliceVision/depthMap/cpu/CpuBuffer.hpp>
+#include <aliceVision/depthMap/cpu/CpuCameraParams.hpp>
+#include <aliceVision/depthMap/cpu/CpuMipmapImage.hpp>
+#include <aliceVision/depthMap/cpu/cpuSimilarityVolume.hpp>
+#include <aliceVision/depthMap/cuda/host/memory.hpp>
+#include <aliceVision/depthMap/cuda/host/DeviceCache.hpp>
+#include <aliceVision/depthMap/cuda/host/DeviceMipmapImage.hpp>
+#include <aliceVision/depthMap/cuda/planeSweeping/deviceSimilarityVolume.hpp>
+#include <aliceVision/camera/Pinhole.hpp>
+#include <aliceVision/image/io.hpp>
+#include <aliceVision/mvsUtils/mapIO.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE depthMapCpuCuda
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::depthMap;
+
+namespace fs = boost::filesystem;
+
+/*
+ * The kernels that do not depend on the cameras are compared on random inputs.
+ * The similarity volume and the whole depth map estimation are compared on a synthetic textured plane.
+ */
+
+namespace {
+
+// synthetic scene: a textured fronto-parallel plane seen by cameras translated along X
+const int sceneImageWidth = 256;
+const int sceneImageHeight = 192;
+const double sceneFocal = 240.0;
+const double scenePlaneDepth = 10.0;
+const std::vector<double> sceneCamerasX = {-1.0, 0.0, 1.0};
+
+bool hasCudaDevice()
+{
+    int nbDevices = 0;
+    return (cudaGetDeviceCount(&nbDevices) == cudaSuccess) && (nbDevices > 0);
+}
+
+/**
+ * @brief Fill the CPU and CUDA mipmap images with the same random image (values multiple of 1/255).
+ */
+void fillRandomMipmapImages(CpuMipmapImage& out_cpuMipmapImage, DeviceMipmapImage& out_deviceMipmapImage, int width, int height, std::mt19937& generator)
+{
+    std::uniform_int_distribution<int> distribution(0, 255);
+
+    image::Image<image::RGBAfColor> img(width, height);
+    CudaHostMemoryHeap<CudaRGBA, 2> img_hmh(CudaSize<2>(width, height));
+
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const float value = float(distribution(generator));
+            img(y, x) = image::RGBAfColor(value / 255.f, value / 255.f, value / 255.f, 1.f);
+
+            CudaRGBA& cudaRGBA = img_hmh(x, y);
+#ifdef ALICEVISION_DEPTHMAP_TEXTURE_USE_HALF
+            cudaRGBA.x = __float2half(value);
+            cudaRGBA.y = __float2half(value);
+            cudaRGBA.z = __float2half(value);
+            cudaRGBA.w = __float2half(255.f);
+#else
+            cudaRGBA.x = value;
+            cudaRGBA.y = value;
+            cudaRGBA.z = value;
+            cudaRGBA.w = 255.f;
+#endif
+        }
+    }
+
+    out_cpuMipmapImage.fill(img, 1, 1);
+    out_deviceMipmapImage.fill(img_hmh, 1, 1);
+}
+
+/**
+ * @brief Value noise texture of the plane (bilinear interpolation of a hashed grid), multiple of 1/255.
+ */
+float planeTexture(double X, double Y)
+{
+    const double cellSize = 0.1;
+    const double gx = X / cellSize;
+    const double gy = Y / cellSize;
+    const int ix = int(std::floor(gx));
+    const int iy = int(std::floor(gy));
+    const double ax = gx - double(ix);
+    const double ay = gy - double(iy);
+
+    const auto hash = [](int x, int y)
+    {
+        std::uint32_t h = std::uint32_t(x) * 374761393u + std::uint32_t(y) * 668265263u;
+        h = (h ^ (h >> 13)) * 1274126177u;
+        return double((h ^ (h >> 16)) & 0xffff) / 65535.0;
+    };
+
+    const double top = hash(ix, iy) * (1.0 - ax) + hash(ix + 1, iy) * ax;
+    const double bottom = hash(ix, iy + 1) * (1.0 - ax) + hash(ix + 1, iy + 1) * ax;
+    const double value = 0.1 + 0.8 * (top * (1.0 - ay) + bottom * ay);
+    return std::round(value * 255.0) / 255.f;
+}
+
+/**
+ * @brief Build the SfMData of the plane scene, with landmarks on the plane seen by all the cameras.
+ * @param[in] imagesFolder the folder of the view images (may be empty)
+ * @return the scene SfMData
+ */
+sfmData::SfMData buildPlaneSfMData(const std::string& imagesFolder)
+{
+    sfmData::SfMData sfmData;
+    sfmData.getIntrinsics().emplace(0, std::make_shared<camera::Pinhole>(sceneImageWidth, sceneImageHeight, sceneFocal, sceneFocal, 0.0, 0.0));
+
+    for(IndexT viewId = 0; viewId < sceneCamerasX.size(); ++viewId)
+    {
+        const std::string imagePath = imagesFolder.empty() ? "" : (fs::path(imagesFolder) / (std::to_string(viewId) + ".exr")).string();
+        sfmData.getViews().emplace(viewId, std::make_shared<sfmData::View>(imagePath, viewId, 0, viewId, sceneImageWidth, sceneImageHeight));
+        sfmData.setPose(*sfmData.getViews().at(viewId), sfmData::CameraPose(geometry::Pose3(Mat3::Identity(), Vec3(sceneCamerasX.at(viewId), 0.0, 0.0))));
+    }
+
+    IndexT landmarkId = 0;
+    for(double Y = -2.0; Y <= 2.0; Y += 0.5)
+    {
+        for(double X = -2.5; X <= 2.5; X += 0.5)
+        {
+            sfmData::Landmark landmark(Vec3(X, Y, scenePlaneDepth), feature::EImageDescriberType::SIFT);
+            bool isVisible = true;
+
+            for(IndexT viewId = 0; viewId < sceneCamerasX.size(); ++viewId)
+            {
+                const Vec2 pt(sceneFocal * (X - sceneCamerasX.at(viewId)) / scenePlaneDepth + sceneImageWidth * 0.5,
+                              sceneFocal * Y / scenePlaneDepth + sceneImageHeight * 0.5);
+
+                isVisible &= (pt.x() >= 0.0 && pt.x() < sceneImageWidth && pt.y() >= 0.0 && pt.y() < sceneImageHeight);
+                landmark.observations[viewId] = sfmData::Observation(pt, landmarkId, 0.0);
+            }
+
+            if(isVisible)
+                sfmData.getLandmarks()[landmarkId++] = landmark;
+        }
+    }
+    return sfmData;
+}
+
+/**
+ * @brief Render the textured plane in the given camera of the multi-view parameters.
+ */
+void renderPlane(image::Image<image::RGBAfColor>& out_img, int camId, const mvsUtils::MultiViewParams& mp)
+{
+    CpuCameraParams camParams;
+    fillCpuCameraParams(camParams, camId, 1, mp);
+
+    out_img.resize(mp.getWidth(camId), mp.getHeight(camId));
+
+    for(int y = 0; y < out_img.Height(); ++y)
+    {
+        for(int x = 0; x < out_img.Width(); ++x)
+        {
+            const Vec3f ray = camParams.iP * Vec3f(float(x), float(y), 1.f);
+            const Vec3f p = camParams.C + ray * ((float(scenePlaneDepth) - camParams.C.z()) / ray.z());
+            const float value = planeTexture(p.x(), p.y());
+            out_img(y, x) = image::RGBAfColor(value, value, value, 1.f);
+        }
+    }
+}
+
+/**
+ * @brief Fill the CPU and CUDA mipmap images with the same image.
+ */
+void fillMipmapImages(CpuMipmapImage& out_cpuMipmapImage, DeviceMipmapImage& out_deviceMipmapImage, const image::Image<image::RGBAfColor>& img)
+{
+    CudaHostMemoryHeap<CudaRGBA, 2> img_hmh(CudaSize<2>(img.Width(), img.Height()));
+
+    for(int y = 0; y < img.Height(); ++y)
+    {
+        for(int x = 0; x < img.Width(); ++x)
+        {
+            const float value = img(y, x).r() * 255.f;
+            CudaRGBA& cudaRGBA = img_hmh(x, y);
+#ifdef ALICEVISION_DEPTHMAP_TEXTURE_USE_HALF
+            cudaRGBA.x = __float2half(value);
+            cudaRGBA.y = __float2half(value);
+            cudaRGBA.z = __float2half(value);
+            cudaRGBA.w = __float2half(255.f);
+#else
+            cudaRGBA.x = value;
+            cudaRGBA.y = value;
+            cudaRGBA.z = value;
+            cudaRGBA.w = 255.f;
+#endif
+        }
+    }
+
+    out_cpuMipmapImage.fill(img, 1, 1);
+    out_deviceMipmapImage.fill(img_hmh, 1, 1);
+}
+
+/**
+ * @brief Run the SGM aggregation on the CPU and on the GPU and return the ratio of voxels within the given tolerance.
+ */
+double compareVolumeOptimize(const SgmParams& sgmParams, int dimX, int dimY, int dimZ, int tolerance, std::mt19937& generator)
+{
+    CpuMipmapImage cpuMipmapImage;
+    DeviceMipmapImage deviceMipmapImage;
+    fillRandomMipmapImages(cpuMipmapImage, deviceMipmapImage, dimX, dimY, generator);
+
+    std::uniform_int_distribution<int> distribution(0, 254);
+
+    CpuVolume<TSimCpu> cpuVolSim, cpuVolSimFiltered;
+    cpuVolSim.allocate(dimX, dimY, dimZ);
+    cpuVolSimFiltered.allocate(dimX, dimY, dimZ);
+
+    const CudaSize<3> volDim(dimX, dimY, dimZ);
+    CudaHostMemoryHeap<TSim, 3> volSim_hmh(volDim);
+    const size_t spitch = volSim_hmh.getBytesPaddedUpToDim(1);
+    const size_t pitch = volSim_hmh.getBytesPaddedUpToDim(0);
+
+    for(int z = 0; z < dimZ; ++z)
+    {
+        for(int y = 0; y < dimY; ++y)
+        {
+            for(int x = 0; x < dimX; ++x)
+            {
+                const int value = distribution(generator);
+                cpuVolSim(x, y, z) = TSimCpu(value);
+                *get3DBufferAt_h<TSim>(volSim_hmh.getBuffer(), spitch, pitch, x, y, z) = TSim(value);
+            }
+        }
+    }
+
+    const ROI roi(0, dimX, 0, dimY);
+
+    cpu_volumeOptimize(cpuVolSimFiltered, cpuVolSim, cpuMipmapImage, sgmParams, dimZ, roi);
+
+    CudaDeviceMemoryPitched<TSim, 3> volSim_dmp(volDim);
+    CudaDeviceMemoryPitched<TSim, 3> volSimFiltered_dmp(volDim);
+    CudaDeviceMemoryPitched<TSimAcc, 2> volSliceAccA_dmp(CudaSize<2>(std::max(dimX, dimY), dimZ));
+    CudaDeviceMemoryPitched<TSimAcc, 2> volSliceAccB_dmp(CudaSize<2>(std::max(dimX, dimY), dimZ));
+    CudaDeviceMemoryPitched<TSimAcc, 2> volAxisAcc_dmp(CudaSize<2>(std::max(dimX, dimY), 1));
+
+    volSim_dmp.copyFrom(volSim_hmh);
+    cuda_volumeOptimize(volSimFiltered_dmp, volSliceAccA_dmp, volSliceAccB_dmp, volAxisAcc_dmp,
+                        volSim_dmp, deviceMipmapImage, sgmParams, dimZ, roi, 0 /*stream*/);
+
+    CudaHostMemoryHeap<TSim, 3> volSimFiltered_hmh(volDim);
+    volSimFiltered_hmh.copyFrom(volSimFiltered_dmp);
+
+    std::size_t nbEqualVoxels = 0;
+    for(int z = 0; z < dimZ; ++z)
+    {
+        for(int y = 0; y < dimY; ++y)
+        {
+            for(int x = 0; x < dimX; ++x)
+            {
+                const float deviceValue = float(*get3DBufferAt_h<TSim>(volSimFiltered_hmh.getBuffer(), spitch, pitch, x, y, z));
+                if(std::abs(deviceValue - float(cpuVolSimFiltered(x, y, z))) <= float(tolerance))
+                    ++nbEqualVoxels;
+            }
+        }
+    }
+    return double(nbEqualVoxels) / double(dimX * dimY * dimZ);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(depthMapCpuCuda_volumeOptimize)
+{
+    if(!hasCudaDevice())
+    {
+        BOOST_TEST_MESSAGE("No CUDA device, the comparison with the CUDA kernels is skipped.");
+        return;
+    }
+
+    std::mt19937 generator(42);
+
+    SgmParams sgmParams;
+    sgmParams.scale = 1;
+    sgmParams.stepXY = 1;
+
+    // constant P2: same arithmetic (1 for the rounding of float similarities)
+    sgmParams.p2Weighting = -100.0;
+    BOOST_CHECK_EQUAL(compareVolumeOptimize(sgmParams, 40, 30, 24, 1, generator), 1.0);
+
+    // P2 weighted by the color differences: the texture sampling may differ slightly
+    sgmParams.p2Weighting = 100.0;
+    BOOST_CHECK_GT(compareVolumeOptimize(sgmParams, 40, 30, 24, 2, generator), 0.99);
+}
+
+BOOST_AUTO_TEST_CASE(depthMapCpuCuda_volumeRefineBestDepth)
+{
+    if(!hasCudaDevice())
+    {
+        BOOST_TEST_MESSAGE("No CUDA device, the comparison with the CUDA kernels is skipped.");
+        return;
+    }
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 64);
+
+    RefineParams refineParams;
+    refineParams.halfNbDepths = 7;
+    refineParams.nbSubsamples = 4;
+    refineParams.sigma = 6.0;
+
+    const int dimX = 32;
+    const int dimY = 24;
+    const int dimZ = 2 * refineParams.halfNbDepths + 1;
+    const ROI roi(0, dimX, 0, dimY);
+
+    // random similarities (multiple of 1/16, exact in half precision)
+    CpuVolume<TSimRefineCpu> cpuVolSim;
+    cpuVolSim.allocate(dimX, dimY, dimZ);
+
+    const CudaSize<3> volDim(dimX, dimY, dimZ);
+    CudaHostMemoryHeap<TSimRefine, 3> volSim_hmh(volDim);
+    const size_t spitch = volSim_hmh.getBytesPaddedUpToDim(1);
+    const size_t pitch = volSim_hmh.getBytesPaddedUpToDim(0);
+
+    CpuMap<Vec2f> cpuSgmDepthPixSizeMap(dimX, dimY);
+    CudaHostMemoryHeap<float2, 2> sgmDepthPixSizeMap_hmh(CudaSize<2>(dimX, dimY));
+
+    for(int y = 0; y < dimY; ++y)
+    {
+        for(int x = 0; x < dimX; ++x)
+        {
+            // some masked pixels
+            const float depth = ((x + y) % 7 == 0) ? -2.f : 10.f + 0.1f * float(x);
+            cpuSgmDepthPixSizeMap(x, y) = Vec2f(depth, 0.05f);
+            sgmDepthPixSizeMap_hmh(x, y) = make_float2(depth, 0.05f);
+
+            for(int z = 0; z < dimZ; ++z)
+            {
+                const float value = float(distribution(generator)) / 16.f;
+                cpuVolSim(x, y, z) = value;
+#ifdef TSIM_REFINE_USE_HALF
+                *get3DBufferAt_h<TSimRefine>(volSim_hmh.getBuffer(), spitch, pitch, x, y, z) = __float2half(value);
+#else
+                *get3DBufferAt_h<TSimRefine>(volSim_hmh.getBuffer(), spitch, pitch, x, y, z) = value;
+#endif
+            }
+        }
+    }
+
+    CpuMap<Vec2f> cpuRefineDepthSimMap(dimX, dimY);
+    cpu_volumeRefineBestDepth(cpuRefineDepthSimMap, cpuSgmDepthPixSizeMap, cpuVolSim, refineParams, roi);
+
+    CudaDeviceMemoryPitched<TSimRefine, 3> volSim_dmp(volDim);
+    CudaDeviceMemoryPitched<float2, 2> sgmDepthPixSizeMap_dmp(CudaSize<2>(dimX, dimY));
+    CudaDeviceMemoryPitched<float2, 2> refineDepthSimMap_dmp(CudaSize<2>(dimX, dimY));
+
+    volSim_dmp.copyFrom(volSim_hmh);
+    sgmDepthPixSizeMap_dmp.copyFrom(sgmDepthPixSizeMap_hmh);
+    cuda_volumeRefineBestDepth(refineDepthSimMap_dmp, sgmDepthPixSizeMap_dmp, volSim_dmp, refineParams, roi, 0 /*stream*/);
+
+    CudaHostMemoryHeap<float2, 2> refineDepthSimMap_hmh(CudaSize<2>(dimX, dimY));
+    refineDepthSimMap_hmh.copyFrom(refineDepthSimMap_dmp);
+
+    for(int y = 0; y < dimY; ++y)
+    {
+        for(int x = 0; x < dimX; ++x)
+        {
+            const float2& deviceDepthSim = refineDepthSimMap_hmh(x, y);
+            BOOST_CHECK_CLOSE(deviceDepthSim.x, cpuRefineDepthSimMap(x, y).x(), 1e-3f);
+            BOOST_CHECK_SMALL(deviceDepthSim.y - cpuRefineDepthSimMap(x, y).y(), 1e-2f);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(depthMapCpuCuda_volumeComputeSimilarity)
+{
+    if(!hasCudaDevice())
+    {
+        BOOST_TEST_MESSAGE("No CUDA device, the comparison with the CUDA kernels is skipped.");
+        return;
+    }
+
+    const sfmData::SfMData sfmData = buildPlaneSfMData("");
+    const mvsUtils::MultiViewParams mp(sfmData, "", "", "", false);
+
+    const int rc = 1;
+    const int tc = 2;
+
+    image::Image<image::RGBAfColor> rcImage, tcImage;
+    renderPlane(rcImage, rc, mp);
+    renderPlane(tcImage, tc, mp);
+
+    CpuMipmapImage rcCpuMipmapImage, tcCpuMipmapImage;
+    DeviceMipmapImage rcDeviceMipmapImage, tcDeviceMipmapImage;
+    fillMipmapImages(rcCpuMipmapImage, rcDeviceMipmapImage, rcImage);
+    fillMipmapImages(tcCpuMipmapImage, tcDeviceMipmapImage, tcImage);
+
+    CpuCameraParams rcCpuCameraParams, tcCpuCameraParams;
+    fillCpuCameraParams(rcCpuCameraParams, rc, 1, mp);
+    fillCpuCameraParams(tcCpuCameraParams, tc, 1, mp);
+
+    DeviceCache& deviceCache = DeviceCache::getInstance();
+    deviceCache.build(0, 2);
+    deviceCache.addCameraParams(rc, 1, mp);
+    deviceCache.addCameraParams(tc, 1, mp);
+    const int rcDeviceCameraParamsId = deviceCache.requestCameraParamsId(rc, 1, mp);
+    const int tcDeviceCameraParamsId = deviceCache.requestCameraParamsId(tc, 1, mp);
+
+    SgmParams sgmParams;
+    sgmParams.scale = 1;
+    sgmParams.stepXY = 1;
+
+    // fronto-parallel planes around the true plane
+    std::vector<float> depths;
+    for(int i = -10; i <= 10; ++i)
+        depths.push_back(float(scenePlaneDepth) * (1.f + 0.05f * float(i)));
+
+    const int dimX = sceneImageWidth;
+    const int dimY = sceneImageHeight;
+    const int dimZ = int(depths.size());
+    const ROI roi(0, dimX, 0, dimY);
+    const Range depthRange(0, dimZ);
+
+    CpuVolume<TSimCpu> cpuVolBestSim, cpuVolSecBestSim;
+    cpuVolBestSim.allocate(dimX, dimY, dimZ, TSimCpu(255));
+    cpuVolSecBestSim.allocate(dimX, dimY, dimZ, TSimCpu(255));
+
+    cpu_volumeComputeSimilarity(cpuVolBestSim, cpuVolSecBestSim, depths,
+                                rcCpuCameraParams, tcCpuCameraParams,
+                                rcCpuMipmapImage, tcCpuMipmapImage,
+                                sgmParams, depthRange, roi);
+
+    const CudaSize<3> volDim(dimX, dimY, dimZ);
+    CudaDeviceMemoryPitched<TSim, 3> volBestSim_dmp(volDim);
+    CudaDeviceMemoryPitched<TSim, 3> volSecBestSim_dmp(volDim);
+    cuda_volumeInitialize(volBestSim_dmp, 255.f, 0 /*stream*/);
+    cuda_volumeInitialize(volSecBestSim_dmp, 255.f, 0 /*stream*/);
+
+    CudaHostMemoryHeap<float, 2> depths_hmh(CudaSize<2>(dimZ, 1));
+    for(int z = 0; z < dimZ; ++z)
+        depths_hmh(z, 0) = depths[z];
+
+    CudaDeviceMemoryPitched<float, 2> depths_dmp(CudaSize<2>(dimZ, 1));
+    depths_dmp.copyFrom(depths_hmh);
+
+    cuda_volumeComputeSimilarity(volBestSim_dmp, volSecBestSim_dmp, depths_dmp,
+                                 rcDeviceCameraParamsId, tcDeviceCameraParamsId,
+                                 rcDeviceMipmapImage, tcDeviceMipmapImage,
+                                 sgmParams, depthRange, roi, 0 /*stream*/);
+
+    CudaHostMemoryHeap<TSim, 3> volBestSim_hmh(volDim);
+    volBestSim_hmh.copyFrom(volBestSim_dmp);
+    const size_t spitch = volBestSim_hmh.getBytesPaddedUpToDim(1);
+    const size_t pitch = volBestSim_hmh.getBytesPaddedUpToDim(0);
+
+    // the texture sampling and the patch weights may differ slightly
+    std::size_t nbEqualVoxels = 0;
+    for(int z = 0; z < dimZ; ++z)
+    {
+        for(int y = 0; y < dimY; ++y)
+        {
+            for(int x = 0; x < dimX; ++x)
+            {
+                const float deviceValue = float(*get3DBufferAt_h<TSim>(volBestSim_hmh.getBuffer(), spitch, pitch, x, y, z));
+                if(std::abs(deviceValue - float(cpuVolBestSim(x, y, z))) <= 2.f)
+                    ++nbEqualVoxels;
+            }
+        }
+    }
+    BOOST_CHECK_GT(double(nbEqualVoxels) / double(dimX * dimY * dimZ), 0.98);
+}
+
+BOOST_AUTO_TEST_CASE(depthMapCpuCuda_depthMapEstimator)
+{
+    if(!hasCudaDevice())
+    {
+        BOOST_TEST_MESSAGE("No CUDA device, the comparison with the CUDA kernels is skipped.");
+        return;
+    }
+
+    const fs::path folder = fs::temp_directory_path() / fs::unique_path();
+    const fs::path imagesFolder = folder / "images";
+    const fs::path cpuDepthMapsFolder = folder / "cpu";
+    const fs::path cudaDepthMapsFolder = folder / "cuda";
+    fs::create_directories(imagesFolder);
+    fs::create_directories(cpuDepthMapsFolder);
+    fs::create_directories(cudaDepthMapsFolder);
+
+    const sfmData::SfMData sfmData = buildPlaneSfMData(imagesFolder.string());
+
+    // render and write the images
+    {
+        const mvsUtils::MultiViewParams mp(sfmData, "", "", "", false);
+        for(int camId = 0; camId < mp.getNbCameras(); ++camId)
+        {
+            image::Image<image::RGBAfColor> img;
+            renderPlane(img, camId, mp);
+            image::writeImage(mp.getImagePath(camId), img,
+                              image::ImageWriteOptions().toColorSpace(image::EImageColorSpace::NO_CONVERSION).storageDataType(image::EStorageDataType::Float));
+        }
+    }
+
+    // a single tile per image
+    mvsUtils::TileParams tileParams;
+    tileParams.bufferWidth = sceneImageWidth;
+    tileParams.bufferHeight = sceneImageHeight;
+    tileParams.padding = 0;
+
+    DepthMapParams depthMapParams;
+    SgmParams sgmParams;
+    sgmParams.scale = 1;
+    sgmParams.stepXY = 2;
+
+    RefineParams refineParams;
+    refineParams.optimizationNbIterations = 10;
+
+    const mvsUtils::MultiViewParams cpuMp(sfmData, "", cpuDepthMapsFolder.string(), "", false);
+    const mvsUtils::MultiViewParams cudaMp(sfmData, "", cudaDepthMapsFolder.string(), "", false);
+
+    std::vector<int> cams(cpuMp.getNbCameras());
+    for(int camId = 0; camId < cpuMp.getNbCameras(); ++camId)
+        cams.at(camId) = camId;
+
+    {
+        DepthMapEstimator cpuDepthMapEstimator(cpuMp, tileParams, depthMapParams, sgmParams, refineParams);
+        cpuDepthMapEstimator.compute(ALICEVISION_DEPTHMAP_CPU_DEVICE_ID, cams);
+    }
+    {
+        DepthMapEstimator cudaDepthMapEstimator(cudaMp, tileParams, depthMapParams, sgmParams, refineParams);
+        cudaDepthMapEstimator.compute(0, cams);
+    }
+
+    for(const int rc : cams)
+    {
+        image::Image<float> cpuDepthMap, cpuSimMap, cudaDepthMap, cudaSimMap;
+        mvsUtils::readMap(rc, cpuMp, mvsUtils::EFileType::depthMap, cpuDepthMap);
+        mvsUtils::readMap(rc, cpuMp, mvsUtils::EFileType::simMap, cpuSimMap);
+        mvsUtils::readMap(rc, cudaMp, mvsUtils::EFileType::depthMap, cudaDepthMap);
+        mvsUtils::readMap(rc, cudaMp, mvsUtils::EFileType::simMap, cudaSimMap);
+
+        BOOST_REQUIRE_EQUAL(cpuDepthMap.Width(), cudaDepthMap.Width());
+        BOOST_REQUIRE_EQUAL(cpuDepthMap.Height(), cudaDepthMap.Height());
+
+        int nbCudaValidPixels = 0;
+        int nbEqualDepthPixels = 0;
+        int nbEqualSimPixels = 0;
+
+        for(int y = 0; y < cudaDepthMap.Height(); ++y)
+        {
+            for(int x = 0; x < cudaDepthMap.Width(); ++x)
+            {
+                const float cudaDepth = cudaDepthMap(y, x);
+                if(cudaDepth <= 0.f)
+                    continue;
+
+                ++nbCudaValidPixels;
+
+                const float cpuDepth = cpuDepthMap(y, x);
+                if(cpuDepth > 0.f && std::abs(cpuDepth - cudaDepth) < 0.01f * cudaDepth)
+                    ++nbEqualDepthPixels;
+
+                if(std::abs(cpuSimMap(y, x) - cudaSimMap(y, x)) < 0.1f)
+                    ++nbEqualSimPixels;
+            }
+        }
+
+        BOOST_TEST_MESSAGE("Camera " << rc << ": " << nbCudaValidPixels << " valid CUDA pixels, "
+                           << nbEqualDepthPixels << " equal depths, " << nbEqualSimPixels << " equal similarities.");
+
+        BOOST_CHECK_GT(nbCudaValidPixels, cudaDepthMap.Width() * cudaDepthMap.Height() / 2);
+        BOOST_CHECK_GT(nbEqualDepthPixels, 0.95 * nbCudaValidPixels);
+        BOOST_CHECK_GT(nbEqualSimPixels, 0.9 * nbCudaValidPixels);
+    }
+
+    fs::remove_all(folder);
+}
@@ -0,0 +1,406 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/depthMap/cpu/CpuBuffer.hpp>
+#include <aliceVision/depthMap/cpu/CpuCameraParams.hpp>
+#include <aliceVision/depthMap/cpu/CpuMipmapImage.hpp>
+#include <aliceVision/depthMap/cpu/cpuSimilarityVolume.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#define BOOST_TEST_MODULE depthMapCpu
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::depthMap;
+
+namespace {
+
+// synthetic scene: a textured fronto-parallel plane seen by two cameras translated along X
+const int imageWidth = 128;
+const int imageHeight = 96;
+const float focal = 120.f;
+const float planeDepth = 10.f;
+const float baseline = 1.f;
+
+/**
+ * @brief Camera parameters of a camera with the given rotation and center (see fillCpuCameraParams).
+ */
+CpuCameraParams makeCameraParams(float f, float cx, float cy, const Eigen::Matrix3f& R, const Vec3f& C)
+{
+    Eigen::Matrix3f K;
+    K << f, 0.f, cx,
+         0.f, f, cy,
+         0.f, 0.f, 1.f;
+
+    CpuCameraParams camParams;
+    camParams.P.leftCols<3>() = K * R;
+    camParams.P.col(3) = -K * R * C;
+    camParams.iP = R.transpose() * K.inverse();
+    camParams.C = C;
+    camParams.XVect = R.row(0).transpose();
+    camParams.YVect = R.row(1).transpose();
+    camParams.ZVect = R.row(2).transpose();
+    return camParams;
+}
+
+CpuCameraParams makeSceneCameraParams(float cameraX)
+{
+    return makeCameraParams(focal, imageWidth * 0.5f, imageHeight * 0.5f, Eigen::Matrix3f::Identity(), Vec3f(cameraX, 0.f, 0.f));
+}
+
+/**
+ * @brief Value noise texture of the plane (bilinear interpolation of a hashed grid).
+ */
+float planeTexture(float X, float Y)
+{
+    const float cellSize = 0.15f;
+    const float gx = X / cellSize;
+    const float gy = Y / cellSize;
+    const int ix = int(std::floor(gx));
+    const int iy = int(std::floor(gy));
+    const float ax = gx - float(ix);
+    const float ay = gy - float(iy);
+
+    const auto hash = [](int x, int y)
+    {
+        std::uint32_t h = std::uint32_t(x) * 374761393u + std::uint32_t(y) * 668265263u;
+        h = (h ^ (h >> 13)) * 1274126177u;
+        return float((h ^ (h >> 16)) & 0xffff) / 65535.f;
+    };
+
+    const float top = hash(ix, iy) * (1.f - ax) + hash(ix + 1, iy) * ax;
+    const float bottom = hash(ix, iy + 1) * (1.f - ax) + hash(ix + 1, iy + 1) * ax;
+    return 0.1f + 0.8f * (top * (1.f - ay) + bottom * ay);
+}
+
+/**
+ * @brief Render the textured plane in the given camera (pixel centers at integer coordinates).
+ */
+void renderPlane(image::Image<image::RGBAfColor>& out_img, const CpuCameraParams& camParams)
+{
+    out_img.resize(imageWidth, imageHeight);
+
+    for(int y = 0; y < imageHeight; ++y)
+    {
+        for(int x = 0; x < imageWidth; ++x)
+        {
+            const Vec3f ray = camParams.iP * Vec3f(float(x), float(y), 1.f);
+            const Vec3f p = camParams.C + ray * ((planeDepth - camParams.C.z()) / ray.z());
+            const float value = planeTexture(p.x(), p.y());
+            out_img(y, x) = image::RGBAfColor(value, value, value, 1.f);
+        }
+    }
+}
+
+/**
+ * @brief Depth along the R camera ray of the plane at the given pixel.
+ */
+float planeDepthAlongRay(const CpuCameraParams& camParams, int x, int y)
+{
+    const Vec3f ray = camParams.iP * Vec3f(float(x), float(y), 1.f);
+    return planeDepth * ray.norm() / ray.z();
+}
+
+struct PlaneScene
+{
+    PlaneScene()
+    {
+        rcCamParams = makeSceneCameraParams(0.f);
+        tcCamParams = makeSceneCameraParams(baseline);
+
+        image::Image<image::RGBAfColor> rcImage, tcImage;
+        renderPlane(rcImage, rcCamParams);
+        renderPlane(tcImage, tcCamParams);
+
+        rcMipmapImage.fill(rcImage, 1, 1);
+        tcMipmapImage.fill(tcImage, 1, 1);
+    }
+
+    CpuCameraParams rcCamParams;
+    CpuCameraParams tcCamParams;
+    CpuMipmapImage rcMipmapImage;
+    CpuMipmapImage tcMipmapImage;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(depthMapCpu_volumeComputeSimilarity_plane)
+{
+    const PlaneScene scene;
+
+    SgmParams sgmParams;
+    sgmParams.scale = 1;
+    sgmParams.stepXY = 1;
+
+    // fronto-parallel planes around the true plane (index 10)
+    const int trueDepthIndex = 10;
+    std::vector<float> depths;
+    for(int i = 0; i <= 2 * trueDepthIndex; ++i)
+        depths.push_back(planeDepth * (1.f + 0.05f * float(i - trueDepthIndex)));
+
+    const ROI roi(0, imageWidth, 0, imageHeight);
+
+    CpuVolume<TSimCpu> volBestSim, volSecBestSim;
+    volBestSim.allocate(imageWidth, imageHeight, int(depths.size()), TSimCpu(255));
+    volSecBestSim.allocate(imageWidth, imageHeight, int(depths.size()), TSimCpu(255));
+
+    cpu_volumeComputeSimilarity(volBestSim, volSecBestSim, depths,
+                                scene.rcCamParams, scene.tcCamParams,
+                                scene.rcMipmapImage, scene.tcMipmapImage,
+                                sgmParams, Range(0, depths.size()), roi);
+
+    int nbValidPixels = 0;
+    int nbTrueDepthPixels = 0;
+    int nbWellMatchedPixels = 0;
+
+    for(int y = 0; y < imageHeight; ++y)
+    {
+        for(int x = 0; x < imageWidth; ++x)
+        {
+            const TSimCpu* column = volBestSim.getColumn(x, y);
+            const TSimCpu* secColumn = volSecBestSim.getColumn(x, y);
+
+            // a single T camera: no second best similarity
+            for(std::size_t z = 0; z < depths.size(); ++z)
+                BOOST_CHECK_EQUAL(int(secColumn[z]), 255);
+
+            // the plane is only seen by both cameras in a part of the R image
+            if(column[trueDepthIndex] == 255)
+                continue;
+
+            ++nbValidPixels;
+
+            int bestZ = 0;
+            for(std::size_t z = 1; z < depths.size(); ++z)
+            {
+                if(column[z] < column[bestZ])
+                    bestZ = int(z);
+            }
+
+            if(bestZ == trueDepthIndex)
+                ++nbTrueDepthPixels;
+
+            // NCC close to -1 at the true depth
+            if(column[trueDepthIndex] < 25)
+                ++nbWellMatchedPixels;
+        }
+    }
+
+    BOOST_CHECK_GT(nbValidPixels, imageWidth * imageHeight / 2);
+    BOOST_CHECK_GT(nbTrueDepthPixels, 0.95 * nbValidPixels);
+    BOOST_CHECK_GT(nbWellMatchedPixels, 0.95 * nbValidPixels);
+
+    // uninitialized second best similarities take the best similarity
+    cpu_volumeUpdateUninitializedSimilarity(volBestSim, volSecBestSim);
+
+    for(int y = 0; y < imageHeight; ++y)
+        for(int x = 0; x < imageWidth; ++x)
+            for(std::size_t z = 0; z < depths.size(); ++z)
+                BOOST_CHECK_EQUAL(int(volSecBestSim(x, y, int(z))), int(volBestSim(x, y, int(z))));
+}
+
+BOOST_AUTO_TEST_CASE(depthMapCpu_volumeOptimize_reference)
+{
+    // mipmap image only used for its dimensions (constant P2)
+    image::Image<image::RGBAfColor> image(3, 1, true, image::RGBAfColor(0.5f, 0.5f, 0.5f, 1.f));
+    CpuMipmapImage mipmapImage;
+    mipmapImage.fill(image, 1, 1);
+
+    SgmParams sgmParams;
+    sgmParams.scale = 1;
+    sgmParams.stepXY = 1;
+    sgmParams.p1 = 10;
+    sgmParams.p2Weighting = -100; // constant P2 = 100
+    sgmParams.filteringAxes = "X";
+
+    const int dimZ = 4;
+    const TSimCpu input[3][dimZ] = {{50, 20, 80, 90},
+                                    {60, 70, 30, 90},
+                                    {40, 40, 40, 40}};
+
+    CpuVolume<TSimCpu> volSim, volSimFiltered;
+    volSim.allocate(3, 1, dimZ);
+    volSimFiltered.allocate(3, 1, dimZ);
+
+    for(int x = 0; x < 3; ++x)
+        for(int z = 0; z < dimZ; ++z)
+            volSim(x, 0, z) = input[x][z];
+
+    cpu_volumeOptimize(volSimFiltered, volSim, mipmapImage, sgmParams, dimZ, ROI(0, 3, 0, 1));
+
+    // forward path:  x0 (255, 255, 255, 255) x1 (255, 70, 40, 255) x2 (255, 50, 40, 255)
+    // backward path: x2 (255, 255, 255, 255) x1 (255, 70, 30, 255) x0 (255, 30, 80, 255)
+    // the first voxel of each path is reset at 255, then the path costs are averaged
+    const int expected[3][dimZ] = {{255, 142, 167, 255},
+                                   {255, 70, 35, 255},
+                                   {255, 255, 255, 255}};
+
+    for(int x = 0; x < 3; ++x)
+        for(int z = 0; z < dimZ; ++z)
+            BOOST_CHECK_EQUAL(int(volSimFiltered(x, 0, z)), expected[x][z]);
+}
+
+BOOST_AUTO_TEST_CASE(depthMapCpu_volumeRetrieveBestDepth_reference)
+{
+    // optical center at pixel (0, 0)
+    const CpuCameraParams rcCamParams = makeCameraParams(100.f, 0.f, 0.f, Eigen::Matrix3f::Identity(), Vec3f(0.f, 0.f, 0.f));
+
+    SgmParams sgmParams;
+    sgmParams.scale = 1;
+    sgmParams.stepXY = 1;
+    sgmParams.depthThicknessInflate = 0.5;
+    sgmParams.maxSimilarity = 0.9; // 228.6 in the volume
+
+    const std::vector<float> depths = {1.f, 2.f, 3.f, 4.5f, 6.f};
+    const int dimZ = int(depths.size());
+    const TSimCpu input[4][5] = {{200, 100, 50, 120, 250}, // best in the middle
+                                 {10, 100, 50, 120, 250},  // best at the first depth
+                                 {255, 255, 255, 255, 255},// uninitialized
+                                 {240, 250, 230, 245, 250}};// too bad similarity
+
+    CpuVolume<TSimCpu> volSim;
+    volSim.allocate(4, 1, dimZ);
+    for(int x = 0; x < 4; ++x)
+        for(int z = 0; z < dimZ; ++z)
+            volSim(x, 0, z) = input[x][z];
+
+    CpuMap<Vec2f> depthThicknessMap(4, 1);
+    CpuMap<Vec2f> depthSimMap(4, 1);
+
+    cpu_volumeRetrieveBestDepth(depthThicknessMap, &depthSimMap, depths, volSim, rcCamParams, sgmParams, Range(0, dimZ), ROI(0, 4, 0, 1));
+
+    const float tolerance = 1e-4f;
+
+    // on the optical axis, the depth is the plane depth
+    BOOST_CHECK_CLOSE(depthThicknessMap(0, 0).x(), 3.f, tolerance);
+    BOOST_CHECK_CLOSE(depthThicknessMap(0, 0).y(), 1.5f * 1.5f, tolerance);
+    BOOST_CHECK_CLOSE(depthSimMap(0, 0).x(), 3.f, tolerance);
+    BOOST_CHECK_CLOSE(depthSimMap(0, 0).y(), 50.f / 255.f * 2.f - 1.f, tolerance);
+
+    // one pixel aside, the depth is measured along the ray
+    const float rayFactor = std::sqrt(1.f + 0.01f * 0.01f);
+    BOOST_CHECK_CLOSE(depthThicknessMap(1, 0).x(), 1.f * rayFactor, tolerance);
+    BOOST_CHECK_CLOSE(depthThicknessMap(1, 0).y(), 1.f * rayFactor * 1.5f, tolerance);
+    BOOST_CHECK_CLOSE(depthSimMap(1, 0).y(), 10.f / 255.f * 2.f - 1.f, tolerance);
+
+    // invalid pixels
+    for(int x = 2; x < 4; ++x)
+    {
+        BOOST_CHECK_EQUAL(depthThicknessMap(x, 0).x(), -1.f);
+        BOOST_CHECK_EQUAL(depthThicknessMap(x, 0).y(), -1.f);
+        BOOST_CHECK_EQUAL(depthSimMap(x, 0).x(), -1.f);
+        BOOST_CHECK_EQUAL(depthSimMap(x, 0).y(), 1.f);
+    }
+
+    // restricted depth range
+    cpu_volumeRetrieveBestDepth(depthThicknessMap, nullptr, depths, volSim, rcCamParams, sgmParams, Range(3, dimZ), ROI(0, 4, 0, 1));
+    BOOST_CHECK_CLOSE(depthThicknessMap(0, 0).x(), 4.5f, tolerance);
+    BOOST_CHECK_CLOSE(depthThicknessMap(0, 0).y(), 1.5f * 1.5f, tolerance);
+}
+
+BOOST_AUTO_TEST_CASE(depthMapCpu_volumeRefineBestDepth_reference)
+{
+    RefineParams refineParams;
+    refineParams.halfNbDepths = 3;
+    refineParams.nbSubsamples = 4;
+    refineParams.sigma = 2.0;
+
+    const int dimZ = 2 * refineParams.halfNbDepths + 1;
+    const float sgmDepth = 5.f;
+    const float pixSize = 0.2f;
+
+    // pixel 0: peak at the middle depth, pixel 1: peak one depth after, pixel 2: masked
+    CpuVolume<TSimRefineCpu> volSim;
+    volSim.allocate(3, 1, dimZ, 0.f);
+    volSim(0, 0, refineParams.halfNbDepths) = 1.f;
+    volSim(1, 0, refineParams.halfNbDepths + 1) = 1.f;
+
+    CpuMap<Vec2f> sgmDepthPixSizeMap(3, 1, Vec2f(sgmDepth, pixSize));
+    sgmDepthPixSizeMap(2, 0) = Vec2f(-2.f, -1.f);
+
+    CpuMap<Vec2f> refineDepthSimMap(3, 1);
+    cpu_volumeRefineBestDepth(refineDepthSimMap, sgmDepthPixSizeMap, volSim, refineParams, ROI(0, 3, 0, 1));
+
+    const float tolerance = 1e-4f;
+
+    BOOST_CHECK_CLOSE(refineDepthSimMap(0, 0).x(), sgmDepth, tolerance);
+    BOOST_CHECK_CLOSE(refineDepthSimMap(0, 0).y(), -1.f, tolerance);
+    BOOST_CHECK_CLOSE(refineDepthSimMap(1, 0).x(), sgmDepth + pixSize, tolerance);
+    BOOST_CHECK_CLOSE(refineDepthSimMap(1, 0).y(), -1.f, tolerance);
+    BOOST_CHECK_EQUAL(refineDepthSimMap(2, 0).x(), -2.f);
+    BOOST_CHECK_EQUAL(refineDepthSimMap(2, 0).y(), 1.f);
+}
+
+BOOST_AUTO_TEST_CASE(depthMapCpu_refine_plane)
+{
+    const PlaneScene scene;
+
+    RefineParams refineParams;
+    refineParams.scale = 1;
+    refineParams.stepXY = 1;
+    refineParams.halfNbDepths = 5;
+    refineParams.nbSubsamples = 4;
+    refineParams.sigma = 4.0;
+
+    const int dimZ = 2 * refineParams.halfNbDepths + 1;
+    const ROI roi(0, imageWidth, 0, imageHeight);
+
+    // SGM depths 1.5 pixel size away from the plane
+    CpuMap<Vec2f> sgmDepthPixSizeMap(imageWidth, imageHeight);
+    for(int y = 0; y < imageHeight; ++y)
+    {
+        for(int x = 0; x < imageWidth; ++x)
+        {
+            const float depth = planeDepthAlongRay(scene.rcCamParams, x, y);
+            const float pixSize = depth / focal;
+            sgmDepthPixSizeMap(x, y) = Vec2f(depth + 1.5f * pixSize, pixSize);
+        }
+    }
+
+    CpuVolume<TSimRefineCpu> volSim;
+    volSim.allocate(imageWidth, imageHeight, dimZ, 0.f);
+
+    cpu_volumeRefineSimilarity(volSim, sgmDepthPixSizeMap,
+                               scene.rcCamParams, scene.tcCamParams,
+                               scene.rcMipmapImage, scene.tcMipmapImage,
+                               refineParams, Range(0, dimZ), roi);
+
+    CpuMap<Vec2f> refineDepthSimMap(imageWidth, imageHeight);
+    cpu_volumeRefineBestDepth(refineDepthSimMap, sgmDepthPixSizeMap, volSim, refineParams, roi);
+
+    // refined depth errors in pixel size
+    std::vector<float> errors;
+
+    for(int y = 0; y < imageHeight; ++y)
+    {
+        for(int x = 0; x < imageWidth; ++x)
+        {
+            // pixels without any similarity keep the SGM depth
+            if(refineDepthSimMap(x, y).y() >= 0.f)
+                continue;
+
+            const float depth = planeDepthAlongRay(scene.rcCamParams, x, y);
+            const float pixSize = sgmDepthPixSizeMap(x, y).y();
+            errors.push_back(std::abs(refineDepthSimMap(x, y).x() - depth) / pixSize);
+        }
+    }
+
+    BOOST_REQUIRE_GT(errors.size(), imageWidth * imageHeight / 2);
+
+    // the SGM depths are 1.5 pixel size away
+    const std::size_t nbRefinedPixels = std::count_if(errors.begin(), errors.end(), [](float error) { return error <= 1.f; });
+    BOOST_CHECK_GT(nbRefinedPixels, 0.9 * errors.size());
+
+    // median error within a subsample
+    std::nth_element(errors.begin(), errors.begin() + errors.size() / 2, errors.end());
+    BOOST_CHECK_LE(errors[errors.size() / 2], 1.f / float(refineParams.nbSubsamples));
+}
@@ -6,6 +6,7 @@
 
 #include "depthMapUtils.hpp"
 
+#include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/image/io.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
@@ -20,6 +21,8 @@
 namespace aliceVision {
 namespace depthMap {
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+
 void copyFloat2Map(image::Image<float>& out_mapX, image::Image<float>& out_mapY, const CudaHostMemoryHeap<float2, 2>& in_map_hmh, const ROI& roi, int downscale)
 {
     const ROI downscaledROI = downscaleROI(roi, downscale);
@@ -292,6 +295,66 @@ void resetDepthSimMap(CudaHostMemoryHeap<float2, 2>& inout_depthSimMap_hmh, floa
   }
 }
 
+#endif // ALICEVISION_HAVE_CUDA
+
+void writeDepthSimMapFromTileList(int rc,
+                                  const mvsUtils::MultiViewParams& mp,
+                                  const mvsUtils::TileParams& tileParams,
+                                  const std::vector<ROI>& tileRoiList,
+                                  const std::vector<CpuMap<Vec2f>>& in_depthSimMapTiles,
+                                  int scale,
+                                  int step,
+                                  const std::string& name)
+{
+  ALICEVISION_LOG_TRACE("Merge and write depth/similarity map tiles (rc: " << rc << ", view id: " << mp.getViewId(rc) << ").");
+
+  const std::string customSuffix = (name.empty()) ? "" : "_" + name;
+
+  const ROI imageRoi(Range(0, mp.getWidth(rc)), Range(0, mp.getHeight(rc)));
+
+  const int scaleStep = scale * step;
+  const int width  = divideRoundUp(mp.getWidth(rc),  scaleStep);
+  const int height = divideRoundUp(mp.getHeight(rc), scaleStep);
+
+  image::Image<float> depthMap(width, height, true, 0.0f); // map should be initialize, additive process
+  image::Image<float> simMap(width, height, true, 0.0f);   // map should be initialize, additive process
+
+  for(size_t i = 0; i < tileRoiList.size(); ++i)
+  {
+    const ROI roi = intersect(tileRoiList.at(i), imageRoi);
+
+    if(roi.isEmpty())
+        continue;
+
+    const CpuMap<Vec2f>& tileDepthSimMap = in_depthSimMapTiles.at(i);
+    const ROI downscaledROI = downscaleROI(roi, scaleStep);
+    const int tileWidth  = int(downscaledROI.width());
+    const int tileHeight = int(downscaledROI.height());
+
+    image::Image<float> tileDepthMap(tileWidth, tileHeight);
+    image::Image<float> tileSimMap(tileWidth, tileHeight);
+
+    // copy tile depth/sim map from host memory
+    for(int y = 0; y < tileHeight; ++y)
+    {
+        for(int x = 0; x < tileWidth; ++x)
+        {
+            const Vec2f& value = tileDepthSimMap(x, y);
+            tileDepthMap(y, x) = value.x();
+            tileSimMap(y, x) = value.y();
+        }
+    }
+
+    // add tile maps to the full-size maps with weighting
+    mvsUtils::addTileMapWeighted(rc, mp, tileParams, roi, scaleStep, tileDepthMap, depthMap);
+    mvsUtils::addTileMapWeighted(rc, mp, tileParams, roi, scaleStep, tileSimMap,   simMap);
+  }
+
+  // write fullsize maps on disk
+  mvsUtils::writeMap(rc, mp, mvsUtils::EFileType::depthMap, depthMap, scale, step, customSuffix); // write the merged depth map
+  mvsUtils::writeMap(rc, mp, mvsUtils::EFileType::simMap,   simMap,   scale, step, customSuffix); // write the merged similarity map
+}
+
 void mergeNormalMapTiles(int rc,
                          const mvsUtils::MultiViewParams& mp,
                          int scale,
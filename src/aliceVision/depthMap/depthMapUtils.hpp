@@ -6,12 +6,18 @@
 
 #pragma once
 
+#include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/mvsData/ROI.hpp>
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 #include <aliceVision/mvsUtils/TileParams.hpp>
 #include <aliceVision/depthMap/Tile.hpp>
+#include <aliceVision/depthMap/cpu/CpuBuffer.hpp>
+#include <aliceVision/config.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
 #include <aliceVision/depthMap/cuda/host/memory.hpp>
+#endif
 
 #include <vector>
 #include <string>
@@ -19,6 +25,8 @@
 namespace aliceVision {
 namespace depthMap {
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+
 /**
  * @brief Copy an image from device memory to host memory and write on disk.
  * @note  This function can be useful for code analysis and debugging. 
@@ -155,6 +163,28 @@ void writeDepthSimMapFromTileList(int rc,
  */
 void resetDepthSimMap(CudaHostMemoryHeap<float2, 2>& inout_depthSimMap_hmh, float depth = -1.f, float sim = 1.f);
 
+#endif // ALICEVISION_HAVE_CUDA
+
+/**
+ * @brief Write a depth/similarity map on disk from a tile list in host memory (CPU backend).
+ * @param[in] rc the related R camera index
+ * @param[in] mp the multi-view parameters
+ * @param[in] tileParams tile workflow parameters
+ * @param[in] tileRoiList the 2d region of interest of each tile
+ * @param[in] in_depthSimMapTiles the depth/similarity map tile list in host memory
+ * @param[in] scale the depth/similarity map downscale factor
+ * @param[in] step the depth/similarity map step factor
+ * @param[in] name the export filename suffix
+ */
+void writeDepthSimMapFromTileList(int rc,
+                                  const mvsUtils::MultiViewParams& mp,
+                                  const mvsUtils::TileParams& tileParams,
+                                  const std::vector<ROI>& tileRoiList,
+                                  const std::vector<CpuMap<Vec2f>>& in_depthSimMapTiles,
+                                  int scale,
+                                  int step,
+                                  const std::string& name = "");
+
 /**
  * @brief Merge normal map tiles on disk.
  * @param[in] rc the related R camera index
@@ -8,8 +8,10 @@
 #pragma once
 
 #include "metric.hpp"
+#include "distanceKernels.hpp"
 
 #include <bitset>
+#include <type_traits>
 
 #ifdef _MSC_VER
 typedef unsigned __int32 uint32_t;
@@ -26,7 +28,8 @@ typedef unsigned __int64 uint64_t;
 // Brief:
 // Hamming distance count the number of bits in common between descriptors
 //  by using a XOR operation + a count.
-// For maximal performance SSE4 must be enable for builtin popcount activation.
+// On raw unsigned char memory, the SIMD kernel is selected at runtime (see distanceKernels.hpp).
+// Otherwise, for maximal performance SSE4 must be enable for builtin popcount activation.
 
 namespace aliceVision {
 namespace feature {
@@ -111,6 +114,10 @@ struct Hamming
   template <typename Iterator1, typename Iterator2>
   inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
   {
+    // raw memory of size bytes: SIMD kernel (instruction set selected at runtime)
+    if constexpr(std::is_same<ElementType, unsigned char>::value)
+      return hammingDistance(reinterpret_cast<const unsigned char*>(a), reinterpret_cast<const unsigned char*>(b), size);
+
     ResultType result = 0;
 // Windows & generic platforms:
 
@@ -167,6 +174,15 @@ struct Hamming
 };
 
 
+template<>
+struct MetricBlock<Hamming<unsigned char>>
+{
+  static void compute(const unsigned char* queries, std::size_t nbQueries, const unsigned char* dataset, std::size_t nbRows, std::size_t size, unsigned int* distances)
+  {
+    hammingDistancesBlock(queries, nbQueries, dataset, nbRows, size, distances);
+  }
+};
+
 template<typename T>
 struct SquaredHamming
 {
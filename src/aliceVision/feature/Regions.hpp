@@ -12,9 +12,11 @@
 #include <aliceVision/feature/PointFeature.hpp>
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/feature/metric.hpp>
+#include <aliceVision/feature/regionsBinaryIO.hpp>
 
 #include <string>
 #include <cstddef>
+#include <cstring>
 #include <typeinfo>
 #include <memory>
 
@@ -62,6 +64,16 @@ public:
     loadFeatsFromFile(sfileNameFeats, _vec_feats);
   }
 
+  /**
+   * @brief Load only the region features from a binary regions file.
+   * @param[in] sfileNameRegions the binary regions file path
+   */
+  void LoadFeaturesBinary(const std::string& sfileNameRegions)
+  {
+    const MappedRegionsFile regionsFile(sfileNameRegions);
+    regionsFile.getFeatures(_vec_feats);
+  }
+
   PointFeatures GetRegionsPositions() const
   {
     return PointFeatures(_vec_feats.begin(), _vec_feats.end());
@@ -93,6 +105,24 @@ public:
 
   virtual void SaveDesc(const std::string& sfileNameDescs) const = 0;
 
+  //--
+  // IO - one memory-mapped binary file for region features and descriptors
+  //--
+
+  /**
+   * @brief Load regions from a binary regions file.
+   * @param[in] sfileNameRegions the binary regions file path
+   * @param[in] loadDescriptors if false, only the region features are loaded
+   */
+  virtual void LoadBinary(const std::string& sfileNameRegions, bool loadDescriptors = true) = 0;
+
+  /**
+   * @brief Save regions into a binary regions file.
+   * @param[in] sfileNameRegions the binary regions file path
+   * @param[in] sortByScale sort regions by decreasing scale (changes the regions order)
+   */
+  virtual void SaveBinary(const std::string& sfileNameRegions, bool sortByScale = false) const = 0;
+
   //--
   //- Basic description of a descriptor [Type, Length]
   //--
@@ -117,6 +147,9 @@ public:
    */
   virtual const void * DescriptorRawData() const = 0;
 
+  /// Return the memory used by the features and the descriptors (in bytes)
+  virtual std::size_t MemorySize() const = 0;
+
   virtual void clearDescriptors() = 0;
 
   /// Return the squared distance between two descriptors
@@ -210,6 +243,35 @@ public:
     saveDescsToBinFile(sfileNameDescs, _vec_descs);
   }
 
+  /// Read the regions and their corresponding descriptors from a memory-mapped binary file.
+  void LoadBinary(const std::string& sfileNameRegions, bool loadDescriptors = true) override
+  {
+    static_assert(sizeof(DescriptorT) == sizeof(T) * L, "Descriptor type should not be padded.");
+
+    const MappedRegionsFile regionsFile(sfileNameRegions);
+    regionsFile.getFeatures(this->_vec_feats);
+
+    if(!loadDescriptors)
+    {
+      _vec_descs.clear();
+      return;
+    }
+
+    regionsFile.checkDescriptorType(L, sizeof(T), IsBinary());
+
+    // descriptors are stored contiguously with the same layout, single bulk copy
+    _vec_descs.resize(regionsFile.getNbRegions());
+    if(!_vec_descs.empty())
+      std::memcpy(_vec_descs.data(), regionsFile.getDescriptors(), _vec_descs.size() * sizeof(DescriptorT));
+  }
+
+  /// Export the regions and their corresponding descriptors in a single binary file.
+  void SaveBinary(const std::string& sfileNameRegions, bool sortByScale = false) const override
+  {
+    const void* descriptors = _vec_descs.empty() ? nullptr : _vec_descs.data();
+    writeRegionsBinaryFile(sfileNameRegions, this->_vec_feats, descriptors, L, sizeof(T), IsBinary(), sortByScale);
+  }
+
   /// Mutable and non-mutable DescriptorT getters.
   inline std::vector<DescriptorT> & Descriptors() { return _vec_descs; }
   inline const std::vector<DescriptorT> & Descriptors() const { return _vec_descs; }
@@ -220,6 +282,11 @@ public:
 
   inline void clearDescriptors() override { _vec_descs.clear(); }
 
+  std::size_t MemorySize() const override
+  {
+    return this->_vec_feats.capacity() * sizeof(PointFeature) + _vec_descs.capacity() * sizeof(DescriptorT);
+  }
+
   inline void swap(This& other)
   {
     this->_vec_feats.swap(other._vec_feats);
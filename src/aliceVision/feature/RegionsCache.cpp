@@ -0,0 +1,114 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "RegionsCache.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+RegionsCache::RegionsCache(const RegionsLoader& loader, std::size_t maxMemory)
+  : _loader(loader)
+  , _maxMemory(maxMemory)
+{}
+
+bool RegionsCache::acquire(const std::set<IndexT>& viewIds)
+{
+  std::vector<IndexT> missingViewIds;
+
+  for(const IndexT viewId : viewIds)
+  {
+    const auto it = _entries.find(viewId);
+    if(it == _entries.end())
+    {
+      missingViewIds.push_back(viewId);
+      continue;
+    }
+    // move to the front of the lru list
+    _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+    ++_nbHits;
+  }
+
+  if(missingViewIds.empty())
+    return true;
+
+  // make room for the estimated size of the missing views before loading them
+  evict(viewIds, missingViewIds.size() * getAverageViewMemorySize());
+
+  std::vector<MapRegionsPerDesc> loadedRegions(missingViewIds.size());
+  std::atomic_bool success(true);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < (int)missingViewIds.size(); ++i)
+  {
+    if(!success)
+      continue;
+    if(!_loader(missingViewIds[i], loadedRegions[i]))
+      success = false;
+  }
+
+  if(!success)
+  {
+    ALICEVISION_LOG_ERROR("Regions cache: cannot load the regions of the requested views.");
+    return false;
+  }
+
+  for(std::size_t i = 0; i < missingViewIds.size(); ++i)
+  {
+    const IndexT viewId = missingViewIds[i];
+    const std::size_t memorySize = loadedRegions[i].getMemorySize();
+
+    _regionsPerView.getData()[viewId] = std::move(loadedRegions[i]);
+    _lru.push_front(viewId);
+    _entries[viewId] = {_lru.begin(), memorySize};
+
+    _memorySize += memorySize;
+    _loadedMemorySize += memorySize;
+    ++_nbLoads;
+  }
+
+  // the estimation may be wrong, respect the budget with the actual size
+  evict(viewIds, 0);
+
+  if(_memorySize > _maxMemory)
+  {
+    ALICEVISION_LOG_WARNING("Regions cache: the requested views use " << _memorySize / (1024 * 1024)
+                            << " MB, more than the memory budget (" << _maxMemory / (1024 * 1024) << " MB).");
+  }
+  return true;
+}
+
+void RegionsCache::evict(const std::set<IndexT>& keptViewIds, std::size_t requiredMemorySize)
+{
+  auto it = _lru.end();
+  while(it != _lru.begin() && _memorySize + requiredMemorySize > _maxMemory)
+  {
+    --it;
+    const IndexT viewId = *it;
+    if(keptViewIds.count(viewId))
+      continue;
+
+    const auto entryIt = _entries.find(viewId);
+    _memorySize -= entryIt->second.memorySize;
+    _entries.erase(entryIt);
+    _regionsPerView.removeRegions(viewId);
+    it = _lru.erase(it);
+  }
+}
+
+void RegionsCache::clear()
+{
+  _regionsPerView = RegionsPerView();
+  _lru.clear();
+  _entries.clear();
+  _memorySize = 0;
+}
+
+}  // namespace feature
+}  // namespace aliceVision
@@ -0,0 +1,100 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/RegionsPerView.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <set>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Least recently used cache of the regions of the views.
+ *
+ * The regions are loaded on demand and the least recently used views are released
+ * when the memory used by the cached regions exceeds the memory budget.
+ * The requested views are always loaded, even if they do not fit in the budget.
+ */
+class RegionsCache
+{
+public:
+  /**
+   * @brief Function loading the regions of all the describer types of a view.
+   * @return false if the regions cannot be loaded
+   */
+  using RegionsLoader = std::function<bool(IndexT viewId, MapRegionsPerDesc& out_regions)>;
+
+  /**
+   * @param[in] loader the function used to load the regions of a view
+   * @param[in] maxMemory the memory budget of the cached regions (in bytes)
+   */
+  RegionsCache(const RegionsLoader& loader, std::size_t maxMemory);
+
+  /**
+   * @brief Make the regions of the given views available in the cache.
+   * @param[in] viewIds the requested views
+   * @return false if the regions of a view cannot be loaded
+   */
+  bool acquire(const std::set<IndexT>& viewIds);
+
+  /**
+   * @brief Get the cached regions.
+   * @note only the views given to the last acquire call are guaranteed to be available
+   */
+  const RegionsPerView& getRegionsPerView() const { return _regionsPerView; }
+
+  /// Memory used by the cached regions (in bytes)
+  std::size_t getMemorySize() const { return _memorySize; }
+
+  /// Memory budget of the cached regions (in bytes)
+  std::size_t getMaxMemory() const { return _maxMemory; }
+
+  /// Average memory of the regions of a view (in bytes), 0 if no view has been loaded yet
+  std::size_t getAverageViewMemorySize() const { return (_nbLoads == 0) ? 0 : _loadedMemorySize / _nbLoads; }
+
+  /// Number of requested views already in the cache
+  std::size_t getNbHits() const { return _nbHits; }
+
+  /// Number of loaded views
+  std::size_t getNbLoads() const { return _nbLoads; }
+
+  /// Release all the cached regions
+  void clear();
+
+private:
+  /**
+   * @brief Release the least recently used views (except the given ones)
+   *        until the cache can store the given memory size.
+   */
+  void evict(const std::set<IndexT>& keptViewIds, std::size_t requiredMemorySize);
+
+  struct Entry
+  {
+    std::list<IndexT>::iterator lruIt;
+    std::size_t memorySize;
+  };
+
+  RegionsLoader _loader;
+  std::size_t _maxMemory;
+  RegionsPerView _regionsPerView;
+  /// views from the most to the least recently used
+  std::list<IndexT> _lru;
+  std::map<IndexT, Entry> _entries;
+  std::size_t _memorySize = 0;
+  std::size_t _loadedMemorySize = 0;
+  std::size_t _nbLoads = 0;
+  std::size_t _nbHits = 0;
+};
+
+}  // namespace feature
+}  // namespace aliceVision
@@ -29,6 +29,14 @@ public:
     return nb;
   }
 
+  std::size_t getMemorySize() const
+  {
+    std::size_t size = 0;
+    for(const auto& it: *this)
+      size += it.second->MemorySize();
+    return size;
+  }
+
   template<class T>
   T getRegions(feature::EImageDescriberType descType) { return dynamic_cast<T&>(*this->at(descType)); }
 
@@ -112,6 +120,11 @@ public:
     _data[viewId][descType].reset(regionsPtr);
   }
 
+  void removeRegions(IndexT viewId)
+  {
+    _data.erase(viewId);
+  }
+
   std::vector<feature::EImageDescriberType> getCommonDescTypes(const Pair& pair) const
   {
     const auto& regionsA = getAllRegions(pair.first);
@@ -0,0 +1,598 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "distanceKernels.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ALICEVISION_DISTANCE_KERNELS_X86_64
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC allows intrinsics of any instruction set without specific compilation flags
+#define ALICEVISION_TARGET(instructionSets)
+#else
+#include <cpuid.h>
+// compile the kernels for a specific instruction set, whatever the architecture flags are
+#define ALICEVISION_TARGET(instructionSets) __attribute__((target(instructionSets)))
+#endif
+#define ALICEVISION_TARGET_AVX2 ALICEVISION_TARGET("avx2,fma,popcnt")
+#define ALICEVISION_TARGET_AVX512 ALICEVISION_TARGET("avx2,fma,popcnt,avx512f,avx512bw")
+#define ALICEVISION_TARGET_AVX512_VPOPCNTDQ ALICEVISION_TARGET("avx2,fma,popcnt,avx512f,avx512bw,avx512vpopcntdq")
+#define ALICEVISION_TARGET_AVX512_VNNI ALICEVISION_TARGET("avx2,fma,popcnt,avx512f,avx512bw,avx512vnni")
+#endif
+
+namespace aliceVision {
+namespace feature {
+
+std::string ESimdInstructionSet_enumToString(ESimdInstructionSet instructionSet)
+{
+  switch(instructionSet)
+  {
+    case ESimdInstructionSet::SCALAR:      return "scalar";
+    case ESimdInstructionSet::AVX2:        return "avx2";
+    case ESimdInstructionSet::AVX512:      return "avx512";
+    case ESimdInstructionSet::AVX512_VNNI: return "avx512_vnni";
+  }
+  throw std::out_of_range("Invalid SIMD instruction set enum: " + std::to_string(int(instructionSet)));
+}
+
+std::ostream& operator<<(std::ostream& os, ESimdInstructionSet instructionSet)
+{
+  return os << ESimdInstructionSet_enumToString(instructionSet);
+}
+
+namespace {
+
+using L2U8Kernel = float (*)(const unsigned char*, const unsigned char*, std::size_t);
+using L2F32Kernel = float (*)(const float*, const float*, std::size_t);
+using HammingKernel = unsigned int (*)(const unsigned char*, const unsigned char*, std::size_t);
+
+using L2U8BatchKernel = void (*)(const unsigned char*, const unsigned char*, std::size_t, std::size_t, float*);
+using L2F32BatchKernel = void (*)(const float*, const float*, std::size_t, std::size_t, float*);
+using HammingBatchKernel = void (*)(const unsigned char*, const unsigned char*, std::size_t, std::size_t, unsigned int*);
+
+/// set of kernels for one instruction set
+struct DistanceKernels
+{
+  ESimdInstructionSet instructionSet;
+  L2U8Kernel l2U8;
+  L2F32Kernel l2F32;
+  HammingKernel hamming;
+  L2U8BatchKernel l2U8Batch;
+  L2F32BatchKernel l2F32Batch;
+  HammingBatchKernel hammingBatch;
+};
+
+/// available CPU features
+struct CpuFeatures
+{
+  bool avx2 = false;
+  bool avx512 = false;
+  bool avx512Vnni = false;
+  bool avx512Vpopcntdq = false;
+};
+
+CpuFeatures detectCpuFeatures()
+{
+  CpuFeatures features;
+
+#ifdef ALICEVISION_DISTANCE_KERNELS_X86_64
+  const auto cpuid = [](unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for(int i = 0; i < 4; ++i)
+      regs[i] = static_cast<unsigned int>(info[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+  };
+
+  unsigned int regs[4];
+  cpuid(0, 0, regs);
+  const unsigned int maxLeaf = regs[0];
+  if(maxLeaf < 7)
+    return features;
+
+  cpuid(1, 0, regs);
+  const bool fma = (regs[2] >> 12) & 1;
+  const bool popcnt = (regs[2] >> 23) & 1;
+  const bool osxsave = (regs[2] >> 27) & 1;
+  const bool avx = (regs[2] >> 28) & 1;
+  if(!osxsave || !avx)
+    return features;
+
+  // check that the OS saves the YMM / ZMM registers
+#if defined(_MSC_VER)
+  const std::uint64_t xcr0 = _xgetbv(0);
+#else
+  unsigned int xcr0Low, xcr0High;
+  __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+  const std::uint64_t xcr0 = (static_cast<std::uint64_t>(xcr0High) << 32) | xcr0Low;
+#endif
+  const bool ymmState = (xcr0 & 0x6) == 0x6;
+  const bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+  cpuid(7, 0, regs);
+  const bool avx2 = (regs[1] >> 5) & 1;
+  const bool avx512f = (regs[1] >> 16) & 1;
+  const bool avx512bw = (regs[1] >> 30) & 1;
+  const bool avx512vnni = (regs[2] >> 11) & 1;
+  const bool avx512vpopcntdq = (regs[2] >> 14) & 1;
+
+  features.avx2 = ymmState && avx2 && fma && popcnt;
+  features.avx512 = features.avx2 && zmmState && avx512f && avx512bw;
+  features.avx512Vnni = features.avx512 && avx512vnni;
+  features.avx512Vpopcntdq = features.avx512 && avx512vpopcntdq;
+#endif
+
+  return features;
+}
+
+const CpuFeatures& getCpuFeatures()
+{
+  static const CpuFeatures features = detectCpuFeatures();
+  return features;
+}
+
+// Generate the 1 vs N kernel of a single distance kernel.
+// The distance kernel is inlined as both functions share the same target.
+#define ALICEVISION_DEFINE_BATCH_KERNEL(kernel, Scalar, ResultType, TARGET)                                              \
+  TARGET void kernel##Batch(const Scalar* query, const Scalar* dataset, std::size_t nbRows, std::size_t size, ResultType* distances) \
+  {                                                                                                                     \
+    for(std::size_t i = 0; i < nbRows; ++i)                                                                             \
+      distances[i] = kernel(query, dataset + i * size, size);                                                           \
+  }
+
+//
+// Scalar kernels
+//
+
+inline float l2U8Scalar(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  std::uint32_t result = 0;
+  for(std::size_t i = 0; i < size; ++i)
+  {
+    const int diff = int(a[i]) - int(b[i]);
+    result += static_cast<std::uint32_t>(diff * diff);
+  }
+  return static_cast<float>(result);
+}
+
+inline float l2F32Scalar(const float* a, const float* b, std::size_t size)
+{
+  // 4 accumulators to allow the compiler auto-vectorization
+  float result[4] = {0.f, 0.f, 0.f, 0.f};
+  std::size_t i = 0;
+  for(; i + 4 <= size; i += 4)
+  {
+    for(int j = 0; j < 4; ++j)
+    {
+      const float diff = a[i + j] - b[i + j];
+      result[j] += diff * diff;
+    }
+  }
+  for(; i < size; ++i)
+  {
+    const float diff = a[i] - b[i];
+    result[0] += diff * diff;
+  }
+  return (result[0] + result[1]) + (result[2] + result[3]);
+}
+
+inline unsigned int popcount8(unsigned char value)
+{
+  unsigned int count = 0;
+  for(; value; value &= value - 1)
+    ++count;
+  return count;
+}
+
+inline unsigned int popcount64Scalar(std::uint64_t n)
+{
+  n -= ((n >> 1) & 0x5555555555555555ULL);
+  n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+  return static_cast<unsigned int>((((n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fULL) * 0x0101010101010101ULL) >> 56);
+}
+
+inline unsigned int hammingScalar(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  unsigned int result = 0;
+  std::size_t i = 0;
+  for(; i + 8 <= size; i += 8)
+  {
+    std::uint64_t wa, wb;
+    std::copy(a + i, a + i + 8, reinterpret_cast<unsigned char*>(&wa));
+    std::copy(b + i, b + i + 8, reinterpret_cast<unsigned char*>(&wb));
+    result += popcount64Scalar(wa ^ wb);
+  }
+  for(; i < size; ++i)
+    result += popcount8(a[i] ^ b[i]);
+  return result;
+}
+
+ALICEVISION_DEFINE_BATCH_KERNEL(l2U8Scalar, unsigned char, float, )
+ALICEVISION_DEFINE_BATCH_KERNEL(l2F32Scalar, float, float, )
+ALICEVISION_DEFINE_BATCH_KERNEL(hammingScalar, unsigned char, unsigned int, )
+
+const DistanceKernels scalarKernels = {
+  ESimdInstructionSet::SCALAR,
+  l2U8Scalar, l2F32Scalar, hammingScalar,
+  l2U8ScalarBatch, l2F32ScalarBatch, hammingScalarBatch
+};
+
+#ifdef ALICEVISION_DISTANCE_KERNELS_X86_64
+
+//
+// AVX2 kernels
+//
+
+ALICEVISION_TARGET_AVX2 inline std::uint32_t horizontalSumAvx2(__m256i v)
+{
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return static_cast<std::uint32_t>(_mm_cvtsi128_si32(sum));
+}
+
+ALICEVISION_TARGET_AVX2 inline float l2U8Avx2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    // widen to 16 bits: the squared differences are summed by pairs in 32 bits
+    const __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+    const __m256i vb = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+    const __m256i diff = _mm256_sub_epi16(va, vb);
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(diff, diff));
+  }
+  std::uint32_t result = horizontalSumAvx2(acc);
+  for(; i < size; ++i)
+  {
+    const int diff = int(a[i]) - int(b[i]);
+    result += static_cast<std::uint32_t>(diff * diff);
+  }
+  return static_cast<float>(result);
+}
+
+ALICEVISION_TARGET_AVX2 inline float l2F32Avx2(const float* a, const float* b, std::size_t size)
+{
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m256 diff0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    const __m256 diff1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    acc0 = _mm256_fmadd_ps(diff0, diff0, acc0);
+    acc1 = _mm256_fmadd_ps(diff1, diff1, acc1);
+  }
+  for(; i + 8 <= size; i += 8)
+  {
+    const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    acc0 = _mm256_fmadd_ps(diff, diff, acc0);
+  }
+  acc0 = _mm256_add_ps(acc0, acc1);
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+  float result = _mm_cvtss_f32(sum);
+  for(; i < size; ++i)
+  {
+    const float diff = a[i] - b[i];
+    result += diff * diff;
+  }
+  return result;
+}
+
+ALICEVISION_TARGET_AVX2 inline unsigned int hammingTailPopcnt(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  unsigned int result = 0;
+  std::size_t i = 0;
+  for(; i + 8 <= size; i += 8)
+  {
+    std::uint64_t wa, wb;
+    std::copy(a + i, a + i + 8, reinterpret_cast<unsigned char*>(&wa));
+    std::copy(b + i, b + i + 8, reinterpret_cast<unsigned char*>(&wb));
+    result += static_cast<unsigned int>(_mm_popcnt_u64(wa ^ wb));
+  }
+  for(; i < size; ++i)
+    result += static_cast<unsigned int>(_mm_popcnt_u32(a[i] ^ b[i]));
+  return result;
+}
+
+ALICEVISION_TARGET_AVX2 inline unsigned int hammingAvx2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  // vectorized popcount with a nibble lookup table [Mula et al. 2018]
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i lowMask = _mm256_set1_epi8(0x0f);
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m256i lo = _mm256_and_si256(x, lowMask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), lowMask);
+    const __m256i count = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(count, _mm256_setzero_si256()));
+  }
+  // 64 bits lanes sum (each lane is small enough to be summed as 32 bits)
+  const unsigned int result = horizontalSumAvx2(acc);
+  return result + hammingTailPopcnt(a + i, b + i, size - i);
+}
+
+ALICEVISION_DEFINE_BATCH_KERNEL(l2U8Avx2, unsigned char, float, ALICEVISION_TARGET_AVX2)
+ALICEVISION_DEFINE_BATCH_KERNEL(l2F32Avx2, float, float, ALICEVISION_TARGET_AVX2)
+ALICEVISION_DEFINE_BATCH_KERNEL(hammingAvx2, unsigned char, unsigned int, ALICEVISION_TARGET_AVX2)
+
+const DistanceKernels avx2Kernels = {
+  ESimdInstructionSet::AVX2,
+  l2U8Avx2, l2F32Avx2, hammingAvx2,
+  l2U8Avx2Batch, l2F32Avx2Batch, hammingAvx2Batch
+};
+
+//
+// AVX-512 kernels
+//
+
+ALICEVISION_TARGET_AVX512 inline float l2U8Avx512(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m512i acc = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m512i va = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+    const __m512i vb = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m512i diff = _mm512_sub_epi16(va, vb);
+    acc = _mm512_add_epi32(acc, _mm512_madd_epi16(diff, diff));
+  }
+  std::uint32_t result = static_cast<std::uint32_t>(_mm512_reduce_add_epi32(acc));
+  for(; i < size; ++i)
+  {
+    const int diff = int(a[i]) - int(b[i]);
+    result += static_cast<std::uint32_t>(diff * diff);
+  }
+  return static_cast<float>(result);
+}
+
+ALICEVISION_TARGET_AVX512_VNNI inline float l2U8Avx512Vnni(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m512i acc = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+  {
+    const __m512i va = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+    const __m512i vb = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m512i diff = _mm512_sub_epi16(va, vb);
+    // fused multiply of 16 bits pairs and 32 bits accumulation
+    acc = _mm512_dpwssd_epi32(acc, diff, diff);
+  }
+  std::uint32_t result = static_cast<std::uint32_t>(_mm512_reduce_add_epi32(acc));
+  for(; i < size; ++i)
+  {
+    const int diff = int(a[i]) - int(b[i]);
+    result += static_cast<std::uint32_t>(diff * diff);
+  }
+  return static_cast<float>(result);
+}
+
+ALICEVISION_TARGET_AVX512 inline float l2F32Avx512(const float* a, const float* b, std::size_t size)
+{
+  __m512 acc = _mm512_setzero_ps();
+  std::size_t i = 0;
+  for(; i + 16 <= size; i += 16)
+  {
+    const __m512 diff = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    acc = _mm512_fmadd_ps(diff, diff, acc);
+  }
+  if(i < size)
+  {
+    // masked loads for the remaining elements
+    const __mmask16 mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+    const __m512 diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+    acc = _mm512_fmadd_ps(diff, diff, acc);
+  }
+  return _mm512_reduce_add_ps(acc);
+}
+
+ALICEVISION_TARGET_AVX512 inline unsigned int hammingAvx512(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  const __m512i lookup = _mm512_set4_epi32(0x04030302, 0x03020201, 0x03020201, 0x02010100);
+  const __m512i lowMask = _mm512_set1_epi8(0x0f);
+  __m512i acc = _mm512_setzero_si512();
+  std::size_t i = 0;
+  while(i < size)
+  {
+    const std::size_t remaining = size - i;
+    const __mmask64 mask = (remaining >= 64) ? ~__mmask64(0) : ((__mmask64(1) << remaining) - 1);
+    const __m512i x = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, a + i), _mm512_maskz_loadu_epi8(mask, b + i));
+    const __m512i lo = _mm512_and_si512(x, lowMask);
+    const __m512i hi = _mm512_and_si512(_mm512_srli_epi16(x, 4), lowMask);
+    const __m512i count = _mm512_add_epi8(_mm512_shuffle_epi8(lookup, lo), _mm512_shuffle_epi8(lookup, hi));
+    acc = _mm512_add_epi64(acc, _mm512_sad_epu8(count, _mm512_setzero_si512()));
+    i += 64;
+  }
+  return static_cast<unsigned int>(_mm512_reduce_add_epi64(acc));
+}
+
+ALICEVISION_TARGET_AVX512_VPOPCNTDQ inline unsigned int hammingAvx512Vpopcntdq(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m512i acc = _mm512_setzero_si512();
+  std::size_t i = 0;
+  while(i < size)
+  {
+    const std::size_t remaining = size - i;
+    const __mmask64 mask = (remaining >= 64) ? ~__mmask64(0) : ((__mmask64(1) << remaining) - 1);
+    const __m512i x = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, a + i), _mm512_maskz_loadu_epi8(mask, b + i));
+    acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(x));
+    i += 64;
+  }
+  return static_cast<unsigned int>(_mm512_reduce_add_epi64(acc));
+}
+
+ALICEVISION_DEFINE_BATCH_KERNEL(l2U8Avx512, unsigned char, float, ALICEVISION_TARGET_AVX512)
+ALICEVISION_DEFINE_BATCH_KERNEL(l2U8Avx512Vnni, unsigned char, float, ALICEVISION_TARGET_AVX512_VNNI)
+ALICEVISION_DEFINE_BATCH_KERNEL(l2F32Avx512, float, float, ALICEVISION_TARGET_AVX512)
+ALICEVISION_DEFINE_BATCH_KERNEL(hammingAvx512, unsigned char, unsigned int, ALICEVISION_TARGET_AVX512)
+ALICEVISION_DEFINE_BATCH_KERNEL(hammingAvx512Vpopcntdq, unsigned char, unsigned int, ALICEVISION_TARGET_AVX512_VPOPCNTDQ)
+
+#endif // ALICEVISION_DISTANCE_KERNELS_X86_64
+
+DistanceKernels makeKernels(ESimdInstructionSet instructionSet)
+{
+#ifdef ALICEVISION_DISTANCE_KERNELS_X86_64
+  const CpuFeatures& features = getCpuFeatures();
+
+  if(instructionSet >= ESimdInstructionSet::AVX512)
+  {
+    DistanceKernels kernels = {
+      ESimdInstructionSet::AVX512,
+      l2U8Avx512, l2F32Avx512, hammingAvx512,
+      l2U8Avx512Batch, l2F32Avx512Batch, hammingAvx512Batch
+    };
+    if(features.avx512Vpopcntdq)
+    {
+      kernels.hamming = hammingAvx512Vpopcntdq;
+      kernels.hammingBatch = hammingAvx512VpopcntdqBatch;
+    }
+    if(instructionSet == ESimdInstructionSet::AVX512_VNNI)
+    {
+      kernels.instructionSet = ESimdInstructionSet::AVX512_VNNI;
+      kernels.l2U8 = l2U8Avx512Vnni;
+      kernels.l2U8Batch = l2U8Avx512VnniBatch;
+    }
+    return kernels;
+  }
+  if(instructionSet == ESimdInstructionSet::AVX2)
+    return avx2Kernels;
+#endif
+  return scalarKernels;
+}
+
+/// kernels for each instruction set, indexed by ESimdInstructionSet
+const DistanceKernels& getKernels(ESimdInstructionSet instructionSet)
+{
+  static const DistanceKernels kernels[] = {
+    makeKernels(ESimdInstructionSet::SCALAR),
+    makeKernels(ESimdInstructionSet::AVX2),
+    makeKernels(ESimdInstructionSet::AVX512),
+    makeKernels(ESimdInstructionSet::AVX512_VNNI)
+  };
+  return kernels[static_cast<int>(instructionSet)];
+}
+
+std::atomic<const DistanceKernels*>& currentKernels()
+{
+  static std::atomic<const DistanceKernels*> kernels(&getKernels(getSupportedSimdInstructionSet()));
+  return kernels;
+}
+
+inline const DistanceKernels& kernels()
+{
+  return *currentKernels().load(std::memory_order_relaxed);
+}
+
+/// number of dataset rows processed for all the queries of a block (fit in L2 cache)
+template<typename Scalar>
+inline std::size_t rowBlockSize(std::size_t size)
+{
+  constexpr std::size_t cacheSize = 128 * 1024;
+  return std::max<std::size_t>(1, cacheSize / std::max<std::size_t>(1, size * sizeof(Scalar)));
+}
+
+template<typename Scalar, typename ResultType, typename BatchKernel>
+void computeBlock(BatchKernel batchKernel, const Scalar* queries, std::size_t nbQueries, const Scalar* dataset, std::size_t nbRows, std::size_t size, ResultType* distances)
+{
+  const std::size_t blockSize = rowBlockSize<Scalar>(size);
+  for(std::size_t firstRow = 0; firstRow < nbRows; firstRow += blockSize)
+  {
+    const std::size_t nbBlockRows = std::min(blockSize, nbRows - firstRow);
+    for(std::size_t q = 0; q < nbQueries; ++q)
+      batchKernel(queries + q * size, dataset + firstRow * size, nbBlockRows, size, distances + q * nbRows + firstRow);
+  }
+}
+
+} // namespace
+
+ESimdInstructionSet getSupportedSimdInstructionSet()
+{
+  const CpuFeatures& features = getCpuFeatures();
+  if(features.avx512Vnni)
+    return ESimdInstructionSet::AVX512_VNNI;
+  if(features.avx512)
+    return ESimdInstructionSet::AVX512;
+  if(features.avx2)
+    return ESimdInstructionSet::AVX2;
+  return ESimdInstructionSet::SCALAR;
+}
+
+ESimdInstructionSet getSimdInstructionSet()
+{
+  return kernels().instructionSet;
+}
+
+ESimdInstructionSet setSimdInstructionSet(ESimdInstructionSet instructionSet)
+{
+  const ESimdInstructionSet applied = std::min(instructionSet, getSupportedSimdInstructionSet());
+  currentKernels().store(&getKernels(applied));
+  return applied;
+}
+
+float squaredL2Distance(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  return kernels().l2U8(a, b, size);
+}
+
+float squaredL2Distance(const float* a, const float* b, std::size_t size)
+{
+  return kernels().l2F32(a, b, size);
+}
+
+unsigned int hammingDistance(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  return kernels().hamming(a, b, size);
+}
+
+void squaredL2Distances(const unsigned char* query, const unsigned char* dataset, std::size_t nbRows, std::size_t size, float* distances)
+{
+  kernels().l2U8Batch(query, dataset, nbRows, size, distances);
+}
+
+void squaredL2Distances(const float* query, const float* dataset, std::size_t nbRows, std::size_t size, float* distances)
+{
+  kernels().l2F32Batch(query, dataset, nbRows, size, distances);
+}
+
+void hammingDistances(const unsigned char* query, const unsigned char* dataset, std::size_t nbRows, std::size_t size, unsigned int* distances)
+{
+  kernels().hammingBatch(query, dataset, nbRows, size, distances);
+}
+
+void squaredL2DistancesBlock(const unsigned char* queries, std::size_t nbQueries, const unsigned char* dataset, std::size_t nbRows, std::size_t size, float* distances)
+{
+  computeBlock(kernels().l2U8Batch, queries, nbQueries, dataset, nbRows, size, distances);
+}
+
+void squaredL2DistancesBlock(const float* queries, std::size_t nbQueries, const float* dataset, std::size_t nbRows, std::size_t size, float* distances)
+{
+  computeBlock(kernels().l2F32Batch, queries, nbQueries, dataset, nbRows, size, distances);
+}
+
+void hammingDistancesBlock(const unsigned char* queries, std::size_t nbQueries, const unsigned char* dataset, std::size_t nbRows, std::size_t size, unsigned int* distances)
+{
+  computeBlock(kernels().hammingBatch, queries, nbQueries, dataset, nbRows, size, distances);
+}
+
+}  // namespace feature
+}  // namespace aliceVision
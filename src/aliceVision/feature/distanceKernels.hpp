@@ -0,0 +1,123 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief SIMD instruction set used by the descriptor distance kernels.
+ *
+ * The best instruction set supported by the CPU is selected at runtime,
+ * so the binaries do not need to be compiled for a specific architecture.
+ */
+enum class ESimdInstructionSet
+{
+  SCALAR = 0,
+  AVX2,        //< AVX2 + FMA + POPCNT
+  AVX512,      //< AVX-512 F + BW
+  AVX512_VNNI  //< AVX-512 F + BW + VNNI
+};
+
+std::string ESimdInstructionSet_enumToString(ESimdInstructionSet instructionSet);
+std::ostream& operator<<(std::ostream& os, ESimdInstructionSet instructionSet);
+
+/**
+ * @brief Get the best instruction set supported by the CPU.
+ */
+ESimdInstructionSet getSupportedSimdInstructionSet();
+
+/**
+ * @brief Get the instruction set currently used by the distance kernels.
+ */
+ESimdInstructionSet getSimdInstructionSet();
+
+/**
+ * @brief Force the instruction set used by the distance kernels (for debug and benchmarks).
+ * @param[in] instructionSet the requested instruction set (limited to the one supported by the CPU)
+ * @return the instruction set in use
+ */
+ESimdInstructionSet setSimdInstructionSet(ESimdInstructionSet instructionSet);
+
+/**
+ * @brief Squared euclidean distance between two unsigned char descriptors.
+ * @param[in] a first descriptor
+ * @param[in] b second descriptor
+ * @param[in] size number of elements
+ */
+float squaredL2Distance(const unsigned char* a, const unsigned char* b, std::size_t size);
+
+/**
+ * @brief Squared euclidean distance between two float descriptors.
+ * @param[in] a first descriptor
+ * @param[in] b second descriptor
+ * @param[in] size number of elements
+ */
+float squaredL2Distance(const float* a, const float* b, std::size_t size);
+
+/**
+ * @brief Hamming distance between two binary descriptors.
+ * @param[in] a first descriptor
+ * @param[in] b second descriptor
+ * @param[in] size number of bytes
+ */
+unsigned int hammingDistance(const unsigned char* a, const unsigned char* b, std::size_t size);
+
+/**
+ * @brief Squared euclidean distances between one query and N contiguous descriptors.
+ * @param[in] query the query descriptor
+ * @param[in] dataset the descriptors (row-major, nbRows x size)
+ * @param[in] nbRows number of descriptors in the dataset
+ * @param[in] size number of elements per descriptor
+ * @param[out] distances the nbRows distances
+ */
+void squaredL2Distances(const unsigned char* query, const unsigned char* dataset, std::size_t nbRows, std::size_t size, float* distances);
+void squaredL2Distances(const float* query, const float* dataset, std::size_t nbRows, std::size_t size, float* distances);
+void hammingDistances(const unsigned char* query, const unsigned char* dataset, std::size_t nbRows, std::size_t size, unsigned int* distances);
+
+/**
+ * @brief Distances between N queries and M contiguous descriptors.
+ *        The dataset is processed by blocks of rows to be reused from the cache by all the queries.
+ * @param[in] queries the query descriptors (row-major, nbQueries x size)
+ * @param[in] nbQueries number of queries
+ * @param[in] dataset the descriptors (row-major, nbRows x size)
+ * @param[in] nbRows number of descriptors in the dataset
+ * @param[in] size number of elements per descriptor
+ * @param[out] distances the distances (row-major, nbQueries x nbRows)
+ */
+void squaredL2DistancesBlock(const unsigned char* queries, std::size_t nbQueries, const unsigned char* dataset, std::size_t nbRows, std::size_t size, float* distances);
+void squaredL2DistancesBlock(const float* queries, std::size_t nbQueries, const float* dataset, std::size_t nbRows, std::size_t size, float* distances);
+void hammingDistancesBlock(const unsigned char* queries, std::size_t nbQueries, const unsigned char* dataset, std::size_t nbRows, std::size_t size, unsigned int* distances);
+
+/**
+ * @brief Distances between N queries and M contiguous descriptors for a given metric.
+ *
+ * Generic version evaluating the metric for each pair.
+ * Specialized for the metrics with a SIMD block kernel.
+ */
+template<class Metric>
+struct MetricBlock
+{
+  template<typename Scalar, typename ResultType>
+  static void compute(const Scalar* queries, std::size_t nbQueries, const Scalar* dataset, std::size_t nbRows, std::size_t size, ResultType* distances)
+  {
+    Metric metric;
+    for(std::size_t q = 0; q < nbQueries; ++q)
+    {
+      const Scalar* query = queries + q * size;
+      for(std::size_t i = 0; i < nbRows; ++i)
+        distances[q * nbRows + i] = metric(query, dataset + i * size, size);
+    }
+  }
+};
+
+}  // namespace feature
+}  // namespace aliceVision
@@ -6,6 +6,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/feature/feature.hpp"
+#include "aliceVision/feature/RegionsCache.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -121,3 +122,120 @@ BOOST_AUTO_TEST_CASE(descriptorIO_BINARY) {
       BOOST_CHECK_EQUAL(vec_descs[i][j], vec_descs_read[i][j]);
   }
 }
+
+//Test memory-mapped binary regions export
+BOOST_AUTO_TEST_CASE(regionsIO_BINARY) {
+  SIFT_Float_Regions regions;
+  for(int i = 0; i < CARD; ++i)
+  {
+    regions.Features().push_back(Feature_T(i, i*2, i%5, i*4));
+    Desc_T desc;
+    for (int j = 0; j < DESC_LENGTH; ++j)
+      desc[j] = i*DESC_LENGTH+j;
+    regions.Descriptors().push_back(desc);
+  }
+
+  //Save them to a file
+  BOOST_CHECK_NO_THROW(regions.SaveBinary("tempRegions.regions"));
+
+  //Read the saved data and compare to input (to check write/read IO)
+  SIFT_Float_Regions regions_read;
+  BOOST_CHECK_NO_THROW(regions_read.LoadBinary("tempRegions.regions"));
+  BOOST_CHECK_EQUAL(CARD, regions_read.RegionCount());
+
+  for(int i = 0; i < CARD; ++i) {
+    BOOST_CHECK_EQUAL(regions.Features()[i], regions_read.Features()[i]);
+    BOOST_CHECK_EQUAL(regions.Features()[i].scale(), regions_read.Features()[i].scale());
+    BOOST_CHECK_EQUAL(regions.Features()[i].orientation(), regions_read.Features()[i].orientation());
+    for (int j = 0; j < DESC_LENGTH; ++j)
+      BOOST_CHECK_EQUAL(regions.Descriptors()[i][j], regions_read.Descriptors()[i][j]);
+  }
+
+  //Read only the features
+  SIFT_Float_Regions features_read;
+  BOOST_CHECK_NO_THROW(features_read.LoadFeaturesBinary("tempRegions.regions"));
+  BOOST_CHECK_EQUAL(CARD, features_read.RegionCount());
+
+  //Read with an incompatible descriptor type
+  SIFT_Regions regions_uchar;
+  BOOST_CHECK_THROW(regions_uchar.LoadBinary("tempRegions.regions"), std::exception);
+  BOOST_CHECK_THROW(regions_uchar.LoadBinary("x.regions"), std::exception);
+}
+
+//Test memory-mapped binary regions export sorted by scale
+BOOST_AUTO_TEST_CASE(regionsIO_BINARY_SORTED_BY_SCALE) {
+  SIFT_Float_Regions regions;
+  for(int i = 0; i < CARD; ++i)
+  {
+    regions.Features().push_back(Feature_T(i, i*2, i%5, i*4));
+    Desc_T desc;
+    for (int j = 0; j < DESC_LENGTH; ++j)
+      desc[j] = i;
+    regions.Descriptors().push_back(desc);
+  }
+
+  BOOST_CHECK_NO_THROW(regions.SaveBinary("tempRegionsSorted.regions", true));
+
+  SIFT_Float_Regions regions_read;
+  BOOST_CHECK_NO_THROW(regions_read.LoadBinary("tempRegionsSorted.regions"));
+  BOOST_CHECK_EQUAL(CARD, regions_read.RegionCount());
+
+  for(int i = 0; i < CARD; ++i) {
+    // descriptors follow their features
+    const int originalIndex = static_cast<int>(regions_read.Features()[i].x());
+    BOOST_CHECK_EQUAL(regions_read.Descriptors()[i][0], originalIndex);
+    if(i > 0)
+      BOOST_CHECK_GE(regions_read.Features()[i-1].scale(), regions_read.Features()[i].scale());
+  }
+}
+
+//Test the least recently used regions cache
+BOOST_AUTO_TEST_CASE(regionsCache_LRU) {
+  std::vector<IndexT> loadedViews;
+  const RegionsCache::RegionsLoader loader = [&](IndexT viewId, MapRegionsPerDesc& out_regions)
+  {
+    if(viewId == UndefinedIndexT)
+      return false;
+    #pragma omp critical
+    loadedViews.push_back(viewId);
+    std::unique_ptr<SIFT_Float_Regions> regions(new SIFT_Float_Regions());
+    regions->Features().resize(CARD);
+    regions->Descriptors().resize(CARD);
+    out_regions[EImageDescriberType::SIFT_FLOAT] = std::move(regions);
+    return true;
+  };
+
+  SIFT_Float_Regions viewRegions;
+  viewRegions.Features().resize(CARD);
+  viewRegions.Descriptors().resize(CARD);
+  const std::size_t viewMemorySize = viewRegions.MemorySize();
+
+  // budget of 3 views
+  RegionsCache cache(loader, 3 * viewMemorySize);
+
+  BOOST_CHECK(cache.acquire({0, 1}));
+  BOOST_CHECK_EQUAL(cache.getNbLoads(), 2);
+  BOOST_CHECK_EQUAL(cache.getAverageViewMemorySize(), viewMemorySize);
+  BOOST_CHECK_EQUAL(cache.getRegionsPerView().getRegions(0, EImageDescriberType::SIFT_FLOAT).RegionCount(), CARD);
+
+  // view 0 is used again, so view 1 is the least recently used
+  BOOST_CHECK(cache.acquire({0, 2}));
+  BOOST_CHECK_EQUAL(cache.getNbHits(), 1);
+  BOOST_CHECK(cache.acquire({0, 3}));
+  BOOST_CHECK_EQUAL(cache.getMemorySize(), 3 * viewMemorySize);
+  BOOST_CHECK(cache.getRegionsPerView().viewExist(0));
+  BOOST_CHECK(!cache.getRegionsPerView().viewExist(1));
+  BOOST_CHECK(cache.getRegionsPerView().viewExist(2));
+  BOOST_CHECK(cache.getRegionsPerView().viewExist(3));
+
+  // requested views are always loaded, even over the budget
+  BOOST_CHECK(cache.acquire({4, 5, 6, 7}));
+  BOOST_CHECK_EQUAL(cache.getMemorySize(), 4 * viewMemorySize);
+  BOOST_CHECK_EQUAL(loadedViews.size(), 8);
+
+  BOOST_CHECK(!cache.acquire({UndefinedIndexT}));
+
+  cache.clear();
+  BOOST_CHECK_EQUAL(cache.getMemorySize(), 0);
+  BOOST_CHECK(cache.getRegionsPerView().isEmpty());
+}
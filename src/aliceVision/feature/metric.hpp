@@ -8,15 +8,11 @@
 #pragma once
 
 #include "Hamming.hpp"
+#include "distanceKernels.hpp"
 
 #include <aliceVision/numeric/Accumulator.hpp>
 #include <aliceVision/config.hpp>
 
-#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
-#include <aliceVision/system/Logger.hpp>
-#include <xmmintrin.h>
-#endif
-
 #include <cstddef>
 
 
@@ -77,52 +73,23 @@ struct L2_Vectorized
   }
 };
 
-#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
-
-namespace optim_ss2{
-
-  /// Union to switch between SSE and float array
-  union sseRegisterHelper
-  {
-      __m128 m;
-      float f[4];
-  };
+// Template specialization to run the SIMD L2 squared distance
+//  (instruction set selected at runtime) on unsigned char vector
+template<>
+struct L2_Vectorized<unsigned char>
+{
+  typedef unsigned char ElementType;
+  typedef Accumulator<unsigned char>::Type ResultType;
 
-  // Euclidean distance (SSE method) (squared result)
-  inline float l2_sse(const float * b1, const float * b2, int size)
+  template <typename Iterator1, typename Iterator2>
+  inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
   {
-    float* b1Pt = (float*)b1;
-    float* b2Pt = (float*)b2;
-    if(size%4 == 0)
-    {
-      __m128 srcA, srcB, temp, cumSum;
-      float zeros[4] = {0.f,0.f,0.f,0.f};
-      cumSum = _mm_load_ps( zeros );
-      for(int i = 0 ; i < size; i+=4)
-      {
-        srcA = _mm_load_ps(b1Pt+i);
-        srcB = _mm_load_ps(b2Pt+i);
-        //-- Subtract
-        temp = _mm_sub_ps( srcA, srcB );
-        //-- Multiply
-        temp =  _mm_mul_ps( temp, temp );
-        //-- sum
-        cumSum = _mm_add_ps( cumSum, temp );
-      }
-      sseRegisterHelper res;
-      res.m = cumSum;
-      return (res.f[0]+res.f[1]+res.f[2]+res.f[3]);
-    }
-    else
-    {
-      ALICEVISION_LOG_WARNING("/!\\ size is not modulus 4, distance cannot be performed in SSE");
-      return 0.0f;
-    }
+    return squaredL2Distance(&*a, &*b, size);
   }
-} // namespace optim_ss2
+};
 
-// Template specification to run SSE L2 squared distance
-//  on float vector
+// Template specialization to run the SIMD L2 squared distance
+//  (instruction set selected at runtime) on float vector
 template<>
 struct L2_Vectorized<float>
 {
@@ -132,11 +99,27 @@ struct L2_Vectorized<float>
   template <typename Iterator1, typename Iterator2>
   inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
   {
-    return optim_ss2::l2_sse(a,b,size);
+    return squaredL2Distance(&*a, &*b, size);
   }
 };
 
-#endif // ALICEVISION_HAVE_SSE
+template<>
+struct MetricBlock<L2_Vectorized<unsigned char>>
+{
+  static void compute(const unsigned char* queries, std::size_t nbQueries, const unsigned char* dataset, std::size_t nbRows, std::size_t size, float* distances)
+  {
+    squaredL2DistancesBlock(queries, nbQueries, dataset, nbRows, size, distances);
+  }
+};
+
+template<>
+struct MetricBlock<L2_Vectorized<float>>
+{
+  static void compute(const float* queries, std::size_t nbQueries, const float* dataset, std::size_t nbRows, std::size_t size, float* distances)
+  {
+    squaredL2DistancesBlock(queries, nbQueries, dataset, nbRows, size, distances);
+  }
+};
 
 }  // namespace feature
 }  // namespace aliceVision
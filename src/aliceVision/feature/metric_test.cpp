@@ -6,9 +6,12 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/feature/metric.hpp>
+#include <aliceVision/feature/distanceKernels.hpp>
 
 #include <iostream>
+#include <random>
 #include <string>
+#include <vector>
 
 #define BOOST_TEST_MODULE matchingMetric
 
@@ -134,3 +137,69 @@ BOOST_AUTO_TEST_CASE(Metric_HAMMING_BITSET_RAW_MEMORY_32BITS)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(Metric_SIMD_Kernels)
+{
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<int> byteDistribution(0, 255);
+  std::uniform_real_distribution<float> floatDistribution(0.f, 1.f);
+
+  const ESimdInstructionSet supported = getSupportedSimdInstructionSet();
+  BOOST_TEST_MESSAGE("Supported SIMD instruction set: " << supported);
+
+  const std::size_t nbRows = 37;
+  const std::size_t nbQueries = 5;
+
+  // various descriptor sizes (including non multiple of the vector sizes)
+  for(const std::size_t size : {1, 7, 16, 31, 32, 61, 64, 100, 128, 130})
+  {
+    std::vector<unsigned char> datasetU8(nbRows * size);
+    std::vector<float> datasetF32(nbRows * size);
+    for(std::size_t i = 0; i < datasetU8.size(); ++i)
+    {
+      datasetU8[i] = static_cast<unsigned char>(byteDistribution(randomNumberGenerator));
+      datasetF32[i] = floatDistribution(randomNumberGenerator);
+    }
+
+    for(int instructionSet = 0; instructionSet <= static_cast<int>(supported); ++instructionSet)
+    {
+      BOOST_CHECK(setSimdInstructionSet(static_cast<ESimdInstructionSet>(instructionSet)) == static_cast<ESimdInstructionSet>(instructionSet));
+
+      std::vector<float> distancesU8(nbQueries * nbRows);
+      std::vector<float> distancesF32(nbQueries * nbRows);
+      std::vector<unsigned int> distancesHamming(nbQueries * nbRows);
+
+      // the first rows are used as queries
+      squaredL2DistancesBlock(datasetU8.data(), nbQueries, datasetU8.data(), nbRows, size, distancesU8.data());
+      squaredL2DistancesBlock(datasetF32.data(), nbQueries, datasetF32.data(), nbRows, size, distancesF32.data());
+      hammingDistancesBlock(datasetU8.data(), nbQueries, datasetU8.data(), nbRows, size, distancesHamming.data());
+
+      for(std::size_t q = 0; q < nbQueries; ++q)
+      {
+        for(std::size_t i = 0; i < nbRows; ++i)
+        {
+          const unsigned char* queryU8 = &datasetU8[q * size];
+          const unsigned char* rowU8 = &datasetU8[i * size];
+          const float* queryF32 = &datasetF32[q * size];
+          const float* rowF32 = &datasetF32[i * size];
+
+          const float gtL2U8 = L2_Simple<unsigned char>()(queryU8, rowU8, size);
+          const float gtL2F32 = L2_Simple<float>()(queryF32, rowF32, size);
+          unsigned int gtHamming = 0;
+          for(std::size_t k = 0; k < size; ++k)
+            gtHamming += std::bitset<8>(queryU8[k] ^ rowU8[k]).count();
+
+          BOOST_CHECK_EQUAL(gtL2U8, squaredL2Distance(queryU8, rowU8, size));
+          BOOST_CHECK_EQUAL(gtL2U8, distancesU8[q * nbRows + i]);
+          BOOST_CHECK_CLOSE(gtL2F32 + 1.f, squaredL2Distance(queryF32, rowF32, size) + 1.f, 1e-3);
+          BOOST_CHECK_CLOSE(gtL2F32 + 1.f, distancesF32[q * nbRows + i] + 1.f, 1e-3);
+          BOOST_CHECK_EQUAL(gtHamming, hammingDistance(queryU8, rowU8, size));
+          BOOST_CHECK_EQUAL(gtHamming, distancesHamming[q * nbRows + i]);
+          BOOST_CHECK_EQUAL(gtHamming, Hamming<unsigned char>()(queryU8, rowU8, size));
+        }
+      }
+    }
+  }
+
+  setSimdInstructionSet(supported);
+}
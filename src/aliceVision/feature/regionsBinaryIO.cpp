@@ -0,0 +1,206 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "regionsBinaryIO.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+const char regionsBinaryMagic[8] = {'A', 'V', 'R', 'E', 'G', 'I', 'O', 'N'};
+
+inline std::uint64_t alignOffset(std::uint64_t offset)
+{
+  return (offset + regionsBinaryArrayAlignment - 1) / regionsBinaryArrayAlignment * regionsBinaryArrayAlignment;
+}
+
+inline void writePadding(std::ofstream& file, std::uint64_t currentOffset, std::uint64_t targetOffset)
+{
+  static const char zeros[regionsBinaryArrayAlignment] = {0};
+  file.write(zeros, static_cast<std::streamsize>(targetOffset - currentOffset));
+}
+
+} // namespace
+
+struct MappedRegionsFile::MappingImpl
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+MappedRegionsFile::MappedRegionsFile(const std::string& filename)
+  : _filename(filename)
+{
+  try
+  {
+    _mapping.reset(new MappingImpl);
+    _mapping->file = boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+    _mapping->region = boost::interprocess::mapped_region(_mapping->file, boost::interprocess::read_only);
+  }
+  catch(const boost::interprocess::interprocess_exception& e)
+  {
+    throw std::runtime_error("Can't load binary regions file, can't open '" + filename + "' (" + e.what() + ")!");
+  }
+
+  const std::size_t fileSize = _mapping->region.get_size();
+  _data = static_cast<const char*>(_mapping->region.get_address());
+
+  if(fileSize < sizeof(RegionsBinaryHeader))
+    throw std::runtime_error("Can't load binary regions file, '" + filename + "' is too small!");
+
+  _header = reinterpret_cast<const RegionsBinaryHeader*>(_data);
+
+  if(std::memcmp(_header->magic, regionsBinaryMagic, sizeof(regionsBinaryMagic)) != 0)
+    throw std::runtime_error("Can't load binary regions file, '" + filename + "' is not a binary regions file!");
+
+  if(_header->version != regionsBinaryFormatVersion)
+    throw std::runtime_error("Can't load binary regions file, '" + filename + "' has an unsupported version (" +
+                             std::to_string(_header->version) + ")!");
+
+  // check that all arrays are inside the file
+  const std::uint64_t nbRegions = _header->nbRegions;
+  const std::uint64_t featArraySize = nbRegions * sizeof(float);
+  const std::uint64_t descArraySize = (_header->hasDescriptors) ? nbRegions * _header->descriptorLength * _header->descriptorElementSize : 0;
+
+  const bool isValid = (_header->xOffset + featArraySize <= fileSize) &&
+                       (_header->yOffset + featArraySize <= fileSize) &&
+                       (_header->scaleOffset + featArraySize <= fileSize) &&
+                       (_header->orientationOffset + featArraySize <= fileSize) &&
+                       (_header->descriptorsOffset + descArraySize <= fileSize);
+
+  if(!isValid)
+    throw std::runtime_error("Can't load binary regions file, '" + filename + "' is truncated!");
+}
+
+MappedRegionsFile::~MappedRegionsFile() = default;
+
+void MappedRegionsFile::checkDescriptorType(std::size_t descriptorLength, std::size_t descriptorElementSize, bool descriptorIsBinary) const
+{
+  if(!hasDescriptors())
+    throw std::runtime_error("Binary regions file '" + _filename + "' does not contain descriptors!");
+
+  if(_header->descriptorLength != descriptorLength ||
+     _header->descriptorElementSize != descriptorElementSize ||
+     (_header->descriptorIsBinary != 0) != descriptorIsBinary)
+  {
+    throw std::runtime_error("Binary regions file '" + _filename + "' descriptor type mismatch (length: " +
+                             std::to_string(_header->descriptorLength) + ", element size: " +
+                             std::to_string(_header->descriptorElementSize) + ")!");
+  }
+}
+
+void MappedRegionsFile::getFeatures(std::vector<PointFeature>& out_features) const
+{
+  const std::size_t nbRegions = getNbRegions();
+  const float* x = getX();
+  const float* y = getY();
+  const float* scale = getScale();
+  const float* orientation = getOrientation();
+
+  out_features.resize(nbRegions);
+
+  for(std::size_t i = 0; i < nbRegions; ++i)
+    out_features[i] = PointFeature(x[i], y[i], scale[i], orientation[i]);
+}
+
+void writeRegionsBinaryFile(const std::string& filename,
+                            const std::vector<PointFeature>& features,
+                            const void* descriptors,
+                            std::size_t descriptorLength,
+                            std::size_t descriptorElementSize,
+                            bool descriptorIsBinary,
+                            bool sortByScale)
+{
+  const std::size_t nbRegions = features.size();
+  const std::size_t descriptorSize = descriptorLength * descriptorElementSize;
+
+  // regions order
+  std::vector<std::size_t> order(nbRegions);
+  std::iota(order.begin(), order.end(), 0);
+
+  if(sortByScale)
+  {
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return features[a].scale() > features[b].scale();
+    });
+  }
+
+  // build header
+  RegionsBinaryHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, regionsBinaryMagic, sizeof(regionsBinaryMagic));
+  header.version = regionsBinaryFormatVersion;
+  header.flags = sortByScale ? REGIONS_BINARY_SORTED_BY_SCALE : REGIONS_BINARY_NONE;
+  header.nbRegions = nbRegions;
+  header.descriptorLength = static_cast<std::uint32_t>(descriptorLength);
+  header.descriptorElementSize = static_cast<std::uint32_t>(descriptorElementSize);
+  header.descriptorIsBinary = descriptorIsBinary ? 1 : 0;
+  header.hasDescriptors = (descriptors != nullptr) ? 1 : 0;
+
+  const std::uint64_t featArraySize = nbRegions * sizeof(float);
+  header.xOffset = alignOffset(sizeof(RegionsBinaryHeader));
+  header.yOffset = alignOffset(header.xOffset + featArraySize);
+  header.scaleOffset = alignOffset(header.yOffset + featArraySize);
+  header.orientationOffset = alignOffset(header.scaleOffset + featArraySize);
+  header.descriptorsOffset = alignOffset(header.orientationOffset + featArraySize);
+
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+
+  if(!file.is_open())
+    throw std::runtime_error("Can't save binary regions file, can't open '" + filename + "' !");
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  std::uint64_t offset = sizeof(header);
+
+  // write a feature attribute SoA array
+  const auto writeFeatureArray = [&](std::uint64_t arrayOffset, float (*getter)(const PointFeature&)) {
+    writePadding(file, offset, arrayOffset);
+    std::vector<float> values(nbRegions);
+    for(std::size_t i = 0; i < nbRegions; ++i)
+      values[i] = getter(features[order[i]]);
+    file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(featArraySize));
+    offset = arrayOffset + featArraySize;
+  };
+
+  writeFeatureArray(header.xOffset, [](const PointFeature& f) { return f.x(); });
+  writeFeatureArray(header.yOffset, [](const PointFeature& f) { return f.y(); });
+  writeFeatureArray(header.scaleOffset, [](const PointFeature& f) { return f.scale(); });
+  writeFeatureArray(header.orientationOffset, [](const PointFeature& f) { return f.orientation(); });
+
+  if(descriptors != nullptr)
+  {
+    writePadding(file, offset, header.descriptorsOffset);
+    const char* descData = static_cast<const char*>(descriptors);
+
+    if(sortByScale)
+    {
+      for(std::size_t i = 0; i < nbRegions; ++i)
+        file.write(descData + order[i] * descriptorSize, static_cast<std::streamsize>(descriptorSize));
+    }
+    else
+    {
+      file.write(descData, static_cast<std::streamsize>(nbRegions * descriptorSize));
+    }
+  }
+
+  if(!file.good())
+    throw std::runtime_error("Can't save binary regions file, '" + filename + "' is incorrect !");
+
+  file.close();
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,138 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/PointFeature.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/// Binary regions file extension
+const std::string regionsBinaryFileExtension = ".regions";
+
+/// Binary regions file format version
+constexpr std::uint32_t regionsBinaryFormatVersion = 1;
+
+/// Alignment (in bytes) of each array in the binary regions file
+constexpr std::size_t regionsBinaryArrayAlignment = 64;
+
+/**
+ * @brief Binary regions file flags
+ */
+enum ERegionsBinaryFlags : std::uint32_t
+{
+  REGIONS_BINARY_NONE = 0,
+  /// regions are sorted by decreasing scale
+  REGIONS_BINARY_SORTED_BY_SCALE = 1 << 0
+};
+
+/**
+ * @brief Binary regions file header.
+ *
+ * The header is followed by aligned SoA arrays:
+ * x[n], y[n], scale[n], orientation[n] (float32) and descriptors[n * descriptorLength].
+ * Values are stored in the native byte order (little-endian on all supported platforms).
+ */
+struct RegionsBinaryHeader
+{
+  char magic[8];                          //< "AVREGION"
+  std::uint32_t version;                  //< file format version
+  std::uint32_t flags;                    //< ERegionsBinaryFlags
+  std::uint64_t nbRegions;                //< number of regions
+  std::uint32_t descriptorLength;         //< number of elements per descriptor
+  std::uint32_t descriptorElementSize;    //< size in bytes of a descriptor element
+  std::uint8_t descriptorIsBinary;        //< 1 for binary descriptors, 0 for scalar descriptors
+  std::uint8_t hasDescriptors;            //< 0 if the file contains features only
+  std::uint8_t reserved[6];
+  std::uint64_t xOffset;                  //< byte offset of the x array
+  std::uint64_t yOffset;                  //< byte offset of the y array
+  std::uint64_t scaleOffset;              //< byte offset of the scale array
+  std::uint64_t orientationOffset;        //< byte offset of the orientation array
+  std::uint64_t descriptorsOffset;        //< byte offset of the descriptors array
+};
+
+static_assert(sizeof(RegionsBinaryHeader) == 80, "Unexpected binary regions header size.");
+
+/**
+ * @brief Read-only memory-mapped binary regions file.
+ * @note Arrays are accessed in place, without any parsing or copy.
+ */
+class MappedRegionsFile
+{
+public:
+
+  /**
+   * @brief Map the given binary regions file in memory.
+   * @param[in] filename the binary regions file path
+   * @note throw if the file cannot be opened or is invalid
+   */
+  explicit MappedRegionsFile(const std::string& filename);
+
+  ~MappedRegionsFile();
+
+  // no copy
+  MappedRegionsFile(const MappedRegionsFile&) = delete;
+  MappedRegionsFile& operator=(const MappedRegionsFile&) = delete;
+
+  inline const RegionsBinaryHeader& getHeader() const { return *_header; }
+  inline std::size_t getNbRegions() const { return static_cast<std::size_t>(_header->nbRegions); }
+  inline bool hasDescriptors() const { return _header->hasDescriptors != 0; }
+  inline bool isSortedByScale() const { return (_header->flags & REGIONS_BINARY_SORTED_BY_SCALE) != 0; }
+
+  inline const float* getX() const { return reinterpret_cast<const float*>(_data + _header->xOffset); }
+  inline const float* getY() const { return reinterpret_cast<const float*>(_data + _header->yOffset); }
+  inline const float* getScale() const { return reinterpret_cast<const float*>(_data + _header->scaleOffset); }
+  inline const float* getOrientation() const { return reinterpret_cast<const float*>(_data + _header->orientationOffset); }
+  inline const void* getDescriptors() const { return _data + _header->descriptorsOffset; }
+
+  /**
+   * @brief Check that the file descriptors match the given descriptor type.
+   * @note throw if the descriptor type is not compatible
+   */
+  void checkDescriptorType(std::size_t descriptorLength, std::size_t descriptorElementSize, bool descriptorIsBinary) const;
+
+  /**
+   * @brief Copy the features into the given PointFeature vector.
+   * @param[out] out_features the output features
+   */
+  void getFeatures(std::vector<PointFeature>& out_features) const;
+
+private:
+  struct MappingImpl;
+  std::unique_ptr<MappingImpl> _mapping;
+  const char* _data = nullptr;
+  const RegionsBinaryHeader* _header = nullptr;
+  std::string _filename;
+};
+
+/**
+ * @brief Write a binary regions file.
+ * @param[in] filename the output file path
+ * @param[in] features the region features
+ * @param[in] descriptors pointer to the contiguous descriptors array (or nullptr to write features only)
+ * @param[in] descriptorLength number of elements per descriptor
+ * @param[in] descriptorElementSize size in bytes of a descriptor element
+ * @param[in] descriptorIsBinary true for binary descriptors
+ * @param[in] sortByScale sort regions by decreasing scale
+ *            (changes the regions order, should not be used if matches refer to the original order)
+ */
+void writeRegionsBinaryFile(const std::string& filename,
+                            const std::vector<PointFeature>& features,
+                            const void* descriptors,
+                            std::size_t descriptorLength,
+                            std::size_t descriptorElementSize,
+                            bool descriptorIsBinary,
+                            bool sortByScale = false);
+
+} // namespace feature
+} // namespace aliceVision
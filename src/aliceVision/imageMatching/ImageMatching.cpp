@@ -6,6 +6,12 @@
 
 #include "ImageMatching.hpp"
 #include <aliceVision/voctree/databaseIO.hpp>
+#include <aliceVision/stl/hash.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
 
 namespace aliceVision {
 namespace imageMatching {
@@ -257,58 +263,262 @@ void generateFromVoctree(PairList& allMatches,
             allMatches[descriptorPair.first] = {};
     }
 
-    // query each document
-#pragma omp parallel for
-    for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFiles.size()); ++i)
+    // query the documents by chunks, to bound the memory used by the histograms of mode AB
+    const std::size_t chunkSize = 1024;
+    std::vector<IndexT> viewIds;
+    std::vector<std::string> featuresPaths;
+    for (const auto& descriptorPair : descriptorsFiles)
+    {
+        viewIds.push_back(descriptorPair.first);
+        featuresPaths.push_back(descriptorPair.second);
+    }
+
+    for (std::size_t chunkStart = 0; chunkStart < viewIds.size(); chunkStart += chunkSize)
     {
-        auto itA = descriptorsFiles.cbegin();
-        std::advance(itA, i);
-        const IndexT viewIdA = itA->first;
-        const std::string featuresPathA = itA->second;
+        const std::size_t chunkEnd = std::min(chunkStart + chunkSize, viewIds.size());
 
-        aliceVision::voctree::SparseHistogram imageSH;
+        std::vector<aliceVision::voctree::SparseHistogram> chunkHistograms;
+        std::vector<const aliceVision::voctree::SparseHistogram*> queries(chunkEnd - chunkStart);
 
         if (modeMultiSfM != EImageMatchingMode::A_B)
         {
             // sparse histogram of A is already computed in the DB
-            imageSH = db.getSparseHistogramPerImage().at(viewIdA);
+            for (std::size_t i = chunkStart; i < chunkEnd; ++i)
+                queries[i - chunkStart] = &db.getSparseHistogramPerImage().at(viewIds[i]);
         }
         else // mode AB
         {
             // compute the sparse histogram of each image A
-            std::vector<DescriptorUChar> descriptors;
-            // read the descriptors
-            loadDescsFromBinFile(featuresPathA, descriptors, false, nbMaxDescriptors);
-            imageSH = tree.quantizeToSparse(descriptors);
+            chunkHistograms.resize(chunkEnd - chunkStart);
+#pragma omp parallel for
+            for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(chunkHistograms.size()); ++i)
+            {
+                std::vector<DescriptorUChar> descriptors;
+                // read the descriptors
+                loadDescsFromBinFile(featuresPaths[chunkStart + i], descriptors, false, nbMaxDescriptors);
+                chunkHistograms[i] = tree.quantizeToSparse(descriptors);
+            }
+            for (std::size_t i = 0; i < chunkHistograms.size(); ++i)
+                queries[i] = &chunkHistograms[i];
         }
 
-        std::vector<aliceVision::voctree::DocMatch> matches;
+        // query each document of the chunk in parallel
+        std::vector<aliceVision::voctree::DocMatches> chunkMatches;
+        db.find(queries, numImageQuery, chunkMatches);
 
-        db.find(imageSH, numImageQuery, matches);
-
-        ListOfImageID& imgMatches = allMatches.at(viewIdA);
-        imgMatches.reserve(imgMatches.size() + matches.size());
-
-        for (const aliceVision::voctree::DocMatch& m : matches)
+        for (std::size_t i = chunkStart; i < chunkEnd; ++i)
         {
-            imgMatches.push_back(m.id);
+            ListOfImageID& imgMatches = allMatches.at(viewIds[i]);
+            const aliceVision::voctree::DocMatches& matches = chunkMatches[i - chunkStart];
+            imgMatches.reserve(imgMatches.size() + matches.size());
+
+            for (const aliceVision::voctree::DocMatch& m : matches)
+            {
+                imgMatches.push_back(m.id);
+            }
         }
     }
 }
 
-void conditionVocTree(const std::string& treeName, bool withWeights,
-                      const std::string& weightsName,
-                      const EImageMatchingMode matchingMode,
-                      const std::vector<std::string>& featuresFolders,
-                      const sfmData::SfMData& sfmDataA,
-                      std::size_t nbMaxDescriptors,
-                      const std::string& sfmDataFilenameA,
-                      const sfmData::SfMData& sfmDataB,
-                      const std::string& sfmDataFilenameB,
-                      bool useMultiSfM,
-                      const std::map<IndexT, std::string>& descriptorsFilesA,
-                      std::size_t numImageQuery,
-                      OrderedPairList& selectedPairs)
+namespace {
+
+/// vocabulary tree databases file signature
+const char databasesFileSignature[] = "AVVOCDB2";
+
+void writeViewIds(std::ostream& out, const std::set<IndexT>& viewIds)
+{
+    const std::uint64_t nbViewIds = viewIds.size();
+    out.write(reinterpret_cast<const char*>(&nbViewIds), sizeof(nbViewIds));
+    for (const IndexT viewId : viewIds)
+    {
+        const std::uint32_t id = viewId;
+        out.write(reinterpret_cast<const char*>(&id), sizeof(id));
+    }
+}
+
+void readViewIds(std::istream& in, std::set<IndexT>& viewIds)
+{
+    std::uint64_t nbViewIds = 0;
+    in.read(reinterpret_cast<char*>(&nbViewIds), sizeof(nbViewIds));
+    for (std::uint64_t i = 0; i < nbViewIds; ++i)
+    {
+        std::uint32_t id = 0;
+        in.read(reinterpret_cast<char*>(&id), sizeof(id));
+        viewIds.insert(id);
+    }
+}
+
+} // namespace
+
+VocTreeDatabasesFingerprint computeVocTreeDatabasesFingerprint(EImageMatchingMode matchingMode,
+                                                               std::size_t nbWords,
+                                                               const std::string& weightsName,
+                                                               std::size_t nbMaxDescriptors,
+                                                               const sfmData::SfMData& sfmDataA,
+                                                               const sfmData::SfMData& sfmDataB)
+{
+    VocTreeDatabasesFingerprint fingerprint;
+    fingerprint.matchingMode = matchingMode;
+    fingerprint.nbWords = nbWords;
+    fingerprint.weightsHash = weightsName.empty() ? 0 : stl::hashFile(weightsName);
+    fingerprint.nbMaxDescriptors = nbMaxDescriptors;
+    for (const auto& viewPair : sfmDataA.getViews())
+        fingerprint.viewIdsA.insert(viewPair.first);
+    for (const auto& viewPair : sfmDataB.getViews())
+        fingerprint.viewIdsB.insert(viewPair.first);
+    return fingerprint;
+}
+
+void saveVocTreeDatabases(const std::string& filename, const VocTreeDatabasesFingerprint& fingerprint,
+                          const voctree::Database& db, const voctree::Database& db2)
+{
+    namespace fs = boost::filesystem;
+
+    // write in a temporary file, renamed when complete
+    const fs::path tmpPath = fs::path(filename).parent_path() / fs::unique_path(fs::path(filename).filename().string() + ".%%%%%%.tmp");
+    {
+        std::ofstream out(tmpPath.string(), std::ios_base::binary);
+        if (!out.is_open())
+            throw std::runtime_error("Unable to write the vocabulary tree databases file: " + tmpPath.string());
+
+        const int32_t mode = static_cast<int32_t>(fingerprint.matchingMode);
+        out.write(databasesFileSignature, sizeof(databasesFileSignature));
+        out.write(reinterpret_cast<const char*>(&mode), sizeof(mode));
+        out.write(reinterpret_cast<const char*>(&fingerprint.nbWords), sizeof(fingerprint.nbWords));
+        out.write(reinterpret_cast<const char*>(&fingerprint.weightsHash), sizeof(fingerprint.weightsHash));
+        out.write(reinterpret_cast<const char*>(&fingerprint.nbMaxDescriptors), sizeof(fingerprint.nbMaxDescriptors));
+        writeViewIds(out, fingerprint.viewIdsA);
+        writeViewIds(out, fingerprint.viewIdsB);
+
+        db.save(out);
+        if (fingerprint.matchingMode == EImageMatchingMode::A_A_AND_A_B)
+            db2.save(out);
+
+        if (!out.good())
+            throw std::runtime_error("Unable to write the vocabulary tree databases file: " + tmpPath.string());
+    }
+    fs::rename(tmpPath, filename);
+}
+
+void loadVocTreeDatabases(const std::string& filename, const VocTreeDatabasesFingerprint& fingerprint,
+                          voctree::Database& db, voctree::Database& db2)
+{
+    std::ifstream in;
+    in.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
+
+    try
+    {
+        in.open(filename, std::ios_base::binary);
+
+        char signature[sizeof(databasesFileSignature)];
+        int32_t mode = -1;
+        in.read(signature, sizeof(signature));
+
+        if (!std::equal(signature, signature + sizeof(signature), databasesFileSignature))
+            throw std::runtime_error("Invalid vocabulary tree databases file: " + filename);
+
+        VocTreeDatabasesFingerprint savedFingerprint;
+        in.read(reinterpret_cast<char*>(&mode), sizeof(mode));
+        in.read(reinterpret_cast<char*>(&savedFingerprint.nbWords), sizeof(savedFingerprint.nbWords));
+        in.read(reinterpret_cast<char*>(&savedFingerprint.weightsHash), sizeof(savedFingerprint.weightsHash));
+        in.read(reinterpret_cast<char*>(&savedFingerprint.nbMaxDescriptors), sizeof(savedFingerprint.nbMaxDescriptors));
+        readViewIds(in, savedFingerprint.viewIdsA);
+        readViewIds(in, savedFingerprint.viewIdsB);
+
+        const std::string error = "The vocabulary tree databases file '" + filename + "' was built ";
+
+        if (mode != static_cast<int32_t>(fingerprint.matchingMode))
+            throw std::runtime_error(error + "in mode " +
+                                     EImageMatchingMode_enumToString(static_cast<EImageMatchingMode>(mode)) + ", not in mode " +
+                                     EImageMatchingMode_enumToString(fingerprint.matchingMode) + ".");
+
+        if (savedFingerprint.nbWords != fingerprint.nbWords)
+            throw std::runtime_error(error + "with a vocabulary tree of " + std::to_string(savedFingerprint.nbWords) +
+                                     " words, not " + std::to_string(fingerprint.nbWords) + ".");
+
+        if (savedFingerprint.weightsHash != fingerprint.weightsHash)
+            throw std::runtime_error(error + "with other vocabulary tree weights.");
+
+        if (savedFingerprint.nbMaxDescriptors != fingerprint.nbMaxDescriptors)
+            throw std::runtime_error(error + "with at most " + std::to_string(savedFingerprint.nbMaxDescriptors) +
+                                     " descriptors per image, not " + std::to_string(fingerprint.nbMaxDescriptors) + ".");
+
+        if (savedFingerprint.viewIdsA != fingerprint.viewIdsA || savedFingerprint.viewIdsB != fingerprint.viewIdsB)
+            throw std::runtime_error(error + "from other images.");
+
+        db.load(in);
+        if (fingerprint.matchingMode == EImageMatchingMode::A_A_AND_A_B)
+            db2.load(in);
+    }
+    catch (std::ifstream::failure& e)
+    {
+        throw std::runtime_error("Unable to read the vocabulary tree databases file: " + filename);
+    }
+}
+
+void savePairList(const std::string& filename, const PairList& pairList)
+{
+    std::ofstream out(filename);
+    if (!out.is_open())
+        throw std::runtime_error("Unable to write the pair list file: " + filename);
+
+    out << pairList;
+
+    if (!out.good())
+        throw std::runtime_error("Unable to write the pair list file: " + filename);
+}
+
+void loadPairList(const std::string& filename, PairList& pairList)
+{
+    std::ifstream in(filename);
+    if (!in.is_open())
+        throw std::runtime_error("Unable to read the pair list file: " + filename);
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream lineStream(line);
+        ImageID imageId;
+        if (!(lineStream >> imageId))
+            continue;
+
+        ListOfImageID& matches = pairList[imageId];
+        ImageID matchId;
+        while (lineStream >> matchId)
+            matches.push_back(matchId);
+
+        if (!lineStream.eof())
+            throw std::runtime_error("Invalid line in the pair list file '" + filename + "': " + line);
+    }
+}
+
+void mergePartialPairLists(const std::vector<std::string>& filenames, std::size_t numImageQuery,
+                           OrderedPairList& selectedPairs)
+{
+    // the ranges are disjoint, the order of the files does not change the merged matches
+    PairList allMatches;
+    for (const std::string& filename : filenames)
+        loadPairList(filename, allMatches);
+
+    ALICEVISION_LOG_INFO("Merged the matches of " << allMatches.size() << " images from " << filenames.size() << " files");
+
+    convertAllMatchesToPairList(allMatches, numImageQuery, selectedPairs);
+}
+
+void queryVocTree(PairList& allMatches,
+                  const std::string& treeName, bool withWeights,
+                  const std::string& weightsName,
+                  const EImageMatchingMode matchingMode,
+                  const std::vector<std::string>& featuresFolders,
+                  const sfmData::SfMData& sfmDataA,
+                  std::size_t nbMaxDescriptors,
+                  const std::string& sfmDataFilenameA,
+                  const sfmData::SfMData& sfmDataB,
+                  const std::string& sfmDataFilenameB,
+                  bool useMultiSfM,
+                  const std::map<IndexT, std::string>& descriptorsFilesA,
+                  std::size_t numImageQuery,
+                  const std::string& databaseFilepath)
 {
     if (treeName.empty())
     {
@@ -330,127 +540,163 @@ void conditionVocTree(const std::string& treeName, bool withWeights,
         ALICEVISION_LOG_INFO(ss.str());
     }
 
-    // create the databases
-    ALICEVISION_LOG_INFO("Creating the databases...");
-
-    // add each object (document) to the database
     aliceVision::voctree::Database db(tree.words());
     aliceVision::voctree::Database db2;
 
-    if(withWeights)
+    const VocTreeDatabasesFingerprint fingerprint = computeVocTreeDatabasesFingerprint(
+                matchingMode, tree.words(), withWeights ? weightsName : "", nbMaxDescriptors, sfmDataA, sfmDataB);
+
+    if (!databaseFilepath.empty() && boost::filesystem::exists(databaseFilepath))
     {
-        ALICEVISION_LOG_INFO("Loading weights...");
-        db.loadWeights(weightsName);
+        // reuse the databases built by another job
+        ALICEVISION_LOG_INFO("Loading the databases from: " << databaseFilepath);
+        loadVocTreeDatabases(databaseFilepath, fingerprint, db, db2);
     }
     else
     {
-        ALICEVISION_LOG_INFO("No weights specified, skipping...");
-    }
+        // create the databases
+        ALICEVISION_LOG_INFO("Creating the databases...");
 
-    if (matchingMode == EImageMatchingMode::A_A_AND_A_B)
-        db2 = db; // initialize database2 with database1 initialization
+        // add each object (document) to the database
+        if(withWeights)
+        {
+            ALICEVISION_LOG_INFO("Loading weights...");
+            db.loadWeights(weightsName);
+        }
+        else
+        {
+            ALICEVISION_LOG_INFO("No weights specified, skipping...");
+        }
 
-    // read the descriptors and populate the databases
-    {
-        std::stringstream ss;
+        if (matchingMode == EImageMatchingMode::A_A_AND_A_B)
+            db2 = db; // initialize database2 with database1 initialization
 
-        for (const std::string& featuresFolder : featuresFolders)
-          ss << "\t- " << featuresFolder << std::endl;
+        // read the descriptors and populate the databases
+        {
+            std::stringstream ss;
 
-        ALICEVISION_LOG_INFO("Reading descriptors from: " << std::endl << ss.str());
+            for (const std::string& featuresFolder : featuresFolders)
+              ss << "\t- " << featuresFolder << std::endl;
 
-        std::size_t nbFeaturesLoadedInputA = 0;
-        std::size_t nbFeaturesLoadedInputB = 0;
-        std::size_t nbSetDescriptors = 0;
+            ALICEVISION_LOG_INFO("Reading descriptors from: " << std::endl << ss.str());
 
-        auto detect_start = std::chrono::steady_clock::now();
-        {
-            if ((matchingMode == EImageMatchingMode::A_A_AND_A_B) ||
-                (matchingMode == EImageMatchingMode::A_AB) ||
-                (matchingMode == EImageMatchingMode::A_A))
+            std::size_t nbFeaturesLoadedInputA = 0;
+            std::size_t nbFeaturesLoadedInputB = 0;
+            std::size_t nbSetDescriptors = 0;
+
+            auto detect_start = std::chrono::steady_clock::now();
             {
-                nbFeaturesLoadedInputA = voctree::populateDatabase<DescriptorUChar>(
-                            sfmDataA, featuresFolders, tree, db, nbMaxDescriptors);
-                nbSetDescriptors = db.getSparseHistogramPerImage().size();
+                if ((matchingMode == EImageMatchingMode::A_A_AND_A_B) ||
+                    (matchingMode == EImageMatchingMode::A_AB) ||
+                    (matchingMode == EImageMatchingMode::A_A))
+                {
+                    nbFeaturesLoadedInputA = voctree::populateDatabase<DescriptorUChar>(
+                                sfmDataA, featuresFolders, tree, db, nbMaxDescriptors);
+                    nbSetDescriptors = db.getSparseHistogramPerImage().size();
+
+                    if(nbFeaturesLoadedInputA == 0)
+                    {
+                      throw std::runtime_error("No descriptors loaded in '" + sfmDataFilenameA + "'");
+                    }
+                }
 
-                if(nbFeaturesLoadedInputA == 0)
+                if ((matchingMode == EImageMatchingMode::A_AB) ||
+                    (matchingMode == EImageMatchingMode::A_B))
                 {
-                  throw std::runtime_error("No descriptors loaded in '" + sfmDataFilenameA + "'");
+                    nbFeaturesLoadedInputB = voctree::populateDatabase<DescriptorUChar>(
+                                sfmDataB, featuresFolders, tree, db, nbMaxDescriptors);
+                    nbSetDescriptors = db.getSparseHistogramPerImage().size();
                 }
-            }
 
-            if ((matchingMode == EImageMatchingMode::A_AB) ||
-                (matchingMode == EImageMatchingMode::A_B))
-            {
-                nbFeaturesLoadedInputB = voctree::populateDatabase<DescriptorUChar>(
-                            sfmDataB, featuresFolders, tree, db, nbMaxDescriptors);
-                nbSetDescriptors = db.getSparseHistogramPerImage().size();
-            }
+                if (matchingMode == EImageMatchingMode::A_A_AND_A_B)
+                {
+                    nbFeaturesLoadedInputB = voctree::populateDatabase<DescriptorUChar>(
+                                sfmDataB, featuresFolders, tree, db2, nbMaxDescriptors);
+                    nbSetDescriptors += db2.getSparseHistogramPerImage().size();
+                }
 
-            if (matchingMode == EImageMatchingMode::A_A_AND_A_B)
-            {
-                nbFeaturesLoadedInputB = voctree::populateDatabase<DescriptorUChar>(
-                            sfmDataB, featuresFolders, tree, db2, nbMaxDescriptors);
-                nbSetDescriptors += db2.getSparseHistogramPerImage().size();
+                if (useMultiSfM && (nbFeaturesLoadedInputB == 0))
+                {
+                    throw std::runtime_error("No descriptors loaded in '" + sfmDataFilenameB + "'");
+                }
             }
+            auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::steady_clock::now() - detect_start);
 
-            if (useMultiSfM && (nbFeaturesLoadedInputB == 0))
-            {
-                throw std::runtime_error("No descriptors loaded in '" + sfmDataFilenameB + "'");
-            }
+            ALICEVISION_LOG_INFO("Read " << nbSetDescriptors << " sets of descriptors for a total of "
+                                 << (nbFeaturesLoadedInputA + nbFeaturesLoadedInputB) << " features");
+            ALICEVISION_LOG_INFO("Reading took " << detect_elapsed.count() << " sec.");
         }
-        auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::steady_clock::now() - detect_start);
 
-        ALICEVISION_LOG_INFO("Read " << nbSetDescriptors << " sets of descriptors for a total of "
-                             << (nbFeaturesLoadedInputA + nbFeaturesLoadedInputB) << " features");
-        ALICEVISION_LOG_INFO("Reading took " << detect_elapsed.count() << " sec.");
-    }
+        if (!withWeights)
+        {
+            // compute and save the word weights
+            ALICEVISION_LOG_INFO("Computing weights...");
 
-    if (!withWeights)
-    {
-        // compute and save the word weights
-        ALICEVISION_LOG_INFO("Computing weights...");
+            db.computeTfIdfWeights();
 
-        db.computeTfIdfWeights();
+            if (matchingMode == EImageMatchingMode::A_A_AND_A_B)
+                db2.computeTfIdfWeights();
+        }
 
-        if (matchingMode == EImageMatchingMode::A_A_AND_A_B)
-            db2.computeTfIdfWeights();
+        if (!databaseFilepath.empty())
+        {
+            ALICEVISION_LOG_INFO("Saving the databases in: " << databaseFilepath);
+            saveVocTreeDatabases(databaseFilepath, fingerprint, db, db2);
+        }
     }
 
-    {
-        PairList allMatches;
+    ALICEVISION_LOG_INFO("Query " << descriptorsFilesA.size() << " documents");
 
-        ALICEVISION_LOG_INFO("Query all documents");
+    auto detect_start = std::chrono::steady_clock::now();
 
-        auto detect_start = std::chrono::steady_clock::now();
+    if (matchingMode == EImageMatchingMode::A_A_AND_A_B)
+    {
+        generateFromVoctree(allMatches, descriptorsFilesA, db,  tree, EImageMatchingMode::A_A,
+                            nbMaxDescriptors, numImageQuery);
+        generateFromVoctree(allMatches, descriptorsFilesA, db2, tree, EImageMatchingMode::A_B,
+                            nbMaxDescriptors, numImageQuery);
+    }
+    else
+    {
+        generateFromVoctree(allMatches, descriptorsFilesA, db, tree, matchingMode,
+                            nbMaxDescriptors, numImageQuery);
+    }
 
-        if (matchingMode == EImageMatchingMode::A_A_AND_A_B)
-        {
-            generateFromVoctree(allMatches, descriptorsFilesA, db,  tree, EImageMatchingMode::A_A,
-                                nbMaxDescriptors, numImageQuery);
-            generateFromVoctree(allMatches, descriptorsFilesA, db2, tree, EImageMatchingMode::A_B,
-                                nbMaxDescriptors, numImageQuery);
-        }
-        else
-        {
-            generateFromVoctree(allMatches, descriptorsFilesA, db, tree, matchingMode,
-                                nbMaxDescriptors, numImageQuery);
-        }
+    auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now() - detect_start);
+    ALICEVISION_LOG_INFO("Query documents took " << detect_elapsed.count() << " sec.");
+}
+
+void conditionVocTree(const std::string& treeName, bool withWeights,
+                      const std::string& weightsName,
+                      const EImageMatchingMode matchingMode,
+                      const std::vector<std::string>& featuresFolders,
+                      const sfmData::SfMData& sfmDataA,
+                      std::size_t nbMaxDescriptors,
+                      const std::string& sfmDataFilenameA,
+                      const sfmData::SfMData& sfmDataB,
+                      const std::string& sfmDataFilenameB,
+                      bool useMultiSfM,
+                      const std::map<IndexT, std::string>& descriptorsFilesA,
+                      std::size_t numImageQuery,
+                      OrderedPairList& selectedPairs,
+                      const std::string& databaseFilepath)
+{
+    PairList allMatches;
 
-        auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::steady_clock::now() - detect_start);
-        ALICEVISION_LOG_INFO("Query all documents took " << detect_elapsed.count() << " sec.");
+    queryVocTree(allMatches, treeName, withWeights, weightsName, matchingMode, featuresFolders, sfmDataA,
+                 nbMaxDescriptors, sfmDataFilenameA, sfmDataB, sfmDataFilenameB, useMultiSfM, descriptorsFilesA,
+                 numImageQuery, databaseFilepath);
 
-        // process pair list
-        detect_start = std::chrono::steady_clock::now();
+    // process pair list
+    auto detect_start = std::chrono::steady_clock::now();
 
-        ALICEVISION_LOG_INFO("Convert all matches to pairList");
-        convertAllMatchesToPairList(allMatches, numImageQuery, selectedPairs);
-        detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::steady_clock::now() - detect_start);
-        ALICEVISION_LOG_INFO("Convert all matches to pairList took " << detect_elapsed.count() << " sec.");
-    }
+    ALICEVISION_LOG_INFO("Convert all matches to pairList");
+    convertAllMatchesToPairList(allMatches, numImageQuery, selectedPairs);
+    auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now() - detect_start);
+    ALICEVISION_LOG_INFO("Convert all matches to pairList took " << detect_elapsed.count() << " sec.");
 }
 
 EImageMatchingMethod selectImageMatchingMethod(EImageMatchingMethod method,
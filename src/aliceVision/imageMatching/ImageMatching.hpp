@@ -10,6 +10,7 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/voctree/Database.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
+#include <cstdint>
 #include <map>
 #include <set>
 #include <vector>
@@ -132,6 +133,109 @@ void generateFromVoctree(PairList& allMatches,
                          std::size_t nbMaxDescriptors,
                          std::size_t numImageQuery);
 
+/**
+ * @brief Identification of the inputs of the vocabulary tree databases.
+ *        It is saved with the databases and checked when they are loaded.
+ */
+struct VocTreeDatabasesFingerprint
+{
+    EImageMatchingMode matchingMode = EImageMatchingMode::A_A;
+    /// number of words of the vocabulary tree
+    std::uint64_t nbWords = 0;
+    /// hash of the weights file (0 if the weights are computed from the documents)
+    std::uint64_t weightsHash = 0;
+    /// maximum number of descriptors per document
+    std::uint64_t nbMaxDescriptors = 0;
+    /// view ids of the documents of the inputs A and B
+    std::set<IndexT> viewIdsA;
+    std::set<IndexT> viewIdsB;
+};
+
+/**
+ * @brief Compute the fingerprint of the inputs of the vocabulary tree databases.
+ * @param[in] matchingMode The matching mode of the databases
+ * @param[in] nbWords The number of words of the vocabulary tree
+ * @param[in] weightsName The weights file (empty if the weights are computed from the documents)
+ * @param[in] nbMaxDescriptors The maximum number of descriptors per document
+ * @param[in] sfmDataA The input A
+ * @param[in] sfmDataB The input B
+ */
+VocTreeDatabasesFingerprint computeVocTreeDatabasesFingerprint(EImageMatchingMode matchingMode,
+                                                               std::size_t nbWords,
+                                                               const std::string& weightsName,
+                                                               std::size_t nbMaxDescriptors,
+                                                               const sfmData::SfMData& sfmDataA,
+                                                               const sfmData::SfMData& sfmDataB);
+
+/**
+ * @brief Save the vocabulary tree databases of a matching mode to a binary file.
+ *        The file is written under a temporary name and then renamed, so concurrent jobs never read a partial file.
+ * @param[in] filename The output file path
+ * @param[in] fingerprint The fingerprint of the inputs of the databases
+ * @param[in] db The database of the matching mode
+ * @param[in] db2 The database of the images B, only saved in mode A_A_AND_A_B
+ */
+void saveVocTreeDatabases(const std::string& filename, const VocTreeDatabasesFingerprint& fingerprint,
+                          const voctree::Database& db, const voctree::Database& db2);
+
+/**
+ * @brief Load the vocabulary tree databases saved with saveVocTreeDatabases.
+ * @param[in] filename The input file path
+ * @param[in] fingerprint The fingerprint of the current inputs, compared to the saved one
+ * @param[out] db The database of the matching mode
+ * @param[out] db2 The database of the images B, only loaded in mode A_A_AND_A_B
+ * @note throw if the file cannot be read or if it was saved for other inputs
+ */
+void loadVocTreeDatabases(const std::string& filename, const VocTreeDatabasesFingerprint& fingerprint,
+                          voctree::Database& db, voctree::Database& db2);
+
+/**
+ * @brief Save the raw matches of each image (in query order), as written by operator<<.
+ *        Used to merge the results of jobs querying different ranges of images.
+ */
+void savePairList(const std::string& filename, const PairList& pairList);
+
+/**
+ * @brief Load the raw matches of each image saved with savePairList and merge them into pairList.
+ *        The matches of an image already in pairList are appended to its list.
+ */
+void loadPairList(const std::string& filename, PairList& pairList);
+
+/**
+ * @brief Merge the raw matches of several range jobs (saved with savePairList) and convert them to a pair list.
+ *        As the matches of each image are independent of the ranges, the result is the same as querying all
+ *        the images at once (see conditionVocTree).
+ * @param[in] filenames The partial pair list files
+ * @param[in] numImageQuery The maximum number of matching images to consider for each image (if 0, consider all matches)
+ * @param[out] selectedPairs The merged pair list
+ */
+void mergePartialPairLists(const std::vector<std::string>& filenames, std::size_t numImageQuery,
+                           OrderedPairList& selectedPairs);
+
+/**
+ * @brief Query the vocabulary tree databases with the images of descriptorsFilesA.
+ *
+ * If databaseFilepath exists, the databases are loaded from it, otherwise they are built
+ * from the descriptors of all the images and saved to databaseFilepath (if not empty).
+ * So descriptorsFilesA can be a range of the images, queried in parallel jobs sharing the same database.
+ *
+ * @param[out] allMatches The raw matches of each queried image
+ */
+void queryVocTree(PairList& allMatches,
+                  const std::string& treeName, bool withWeights,
+                  const std::string& weightsName,
+                  const EImageMatchingMode matchingMode,
+                  const std::vector<std::string>& featuresFolders,
+                  const sfmData::SfMData& sfmDataA,
+                  std::size_t nbMaxDescriptors,
+                  const std::string& sfmDataFilenameA,
+                  const sfmData::SfMData& sfmDataB,
+                  const std::string& sfmDataFilenameB,
+                  bool useMultiSfM,
+                  const std::map<IndexT, std::string>& descriptorsFilesA,
+                  std::size_t numImageQuery,
+                  const std::string& databaseFilepath = "");
+
 void conditionVocTree(const std::string& treeName, bool withWeights,
                       const std::string& weightsName,
                       const EImageMatchingMode matchingMode,
@@ -144,7 +248,8 @@ void conditionVocTree(const std::string& treeName, bool withWeights,
                       bool useMultiSfM,
                       const std::map<IndexT, std::string>& descriptorsFilesA,
                       std::size_t numImageQuery,
-                      OrderedPairList& selectedPairs);
+                      OrderedPairList& selectedPairs,
+                      const std::string& databaseFilepath = "");
 
 EImageMatchingMethod selectImageMatchingMethod(EImageMatchingMethod method,
                                                const sfmData::SfMData& sfmDataA,
@@ -0,0 +1,184 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/imageMatching/ImageMatching.hpp>
+#include <aliceVision/voctree/TreeBuilder.hpp>
+#include <aliceVision/voctree/descriptorLoader.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE imageMatching
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::imageMatching;
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+/**
+ * @brief Create a vocabulary tree and the descriptors of nbViews views, each one seeing a few of the clusters.
+ * @param[in] folder the output folder of the tree and of the .desc files
+ * @param[in] nbViews the number of views
+ * @param[out] sfmData the views
+ * @return the vocabulary tree file path
+ */
+std::string createScene(const fs::path& folder, std::size_t nbViews, sfmData::SfMData& sfmData)
+{
+    const std::size_t nbClusters = 8;
+    const std::size_t nbDescriptorsPerCluster = 20;
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> centerDistribution(20, 235);
+    std::uniform_int_distribution<int> noiseDistribution(-10, 10);
+
+    std::vector<DescriptorUChar> centers(nbClusters);
+    for (DescriptorUChar& center : centers)
+        for (std::size_t d = 0; d < DIMENSION; ++d)
+            center[d] = static_cast<unsigned char>(centerDistribution(generator));
+
+    std::vector<DescriptorFloat> trainingDescriptors;
+
+    for (IndexT viewId = 0; viewId < nbViews; ++viewId)
+    {
+        // each view sees 3 consecutive clusters
+        std::vector<DescriptorUChar> descriptors;
+        for (std::size_t c = 0; c < 3; ++c)
+        {
+            const DescriptorUChar& center = centers[(viewId + c) % nbClusters];
+            for (std::size_t i = 0; i < nbDescriptorsPerCluster; ++i)
+            {
+                DescriptorUChar descriptor;
+                DescriptorFloat trainingDescriptor;
+                for (std::size_t d = 0; d < DIMENSION; ++d)
+                {
+                    descriptor[d] = static_cast<unsigned char>(center[d] + noiseDistribution(generator));
+                    trainingDescriptor[d] = descriptor[d];
+                }
+                descriptors.push_back(descriptor);
+                trainingDescriptors.push_back(trainingDescriptor);
+            }
+        }
+
+        feature::saveDescsToBinFile((folder / (std::to_string(viewId) + ".sift.desc")).string(), descriptors);
+        sfmData.getViews().emplace(viewId, std::make_shared<sfmData::View>("", viewId));
+    }
+
+    voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
+    builder.build(trainingDescriptors, 4, 2);
+
+    const std::string treeFilepath = (folder / "test.tree").string();
+    builder.tree().save(treeFilepath);
+    return treeFilepath;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(imageMatching_pairListIO)
+{
+    PairList pairList;
+    pairList[0] = {3, 1, 2};
+    pairList[1] = {};
+    pairList[7] = {0, 1, 12, 5};
+
+    const fs::path filename = fs::temp_directory_path() / fs::unique_path("pairList_%%%%%%.txt");
+    savePairList(filename.string(), pairList);
+
+    PairList loadedPairList;
+    loadPairList(filename.string(), loadedPairList);
+    BOOST_CHECK(loadedPairList == pairList);
+
+    // the matches of an image already in the pair list are appended
+    loadPairList(filename.string(), loadedPairList);
+    BOOST_CHECK_EQUAL(loadedPairList.at(0).size(), 6);
+    BOOST_CHECK(loadedPairList.at(1).empty());
+
+    fs::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(imageMatching_queryVocTree_ranges)
+{
+    const fs::path folder = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directory(folder);
+
+    const std::size_t nbViews = 12;
+    const std::size_t numImageQuery = 4;
+    const std::vector<std::string> featuresFolders = {folder.string()};
+
+    sfmData::SfMData sfmDataA;
+    const sfmData::SfMData sfmDataB;
+    const std::string treeFilepath = createScene(folder, nbViews, sfmDataA);
+
+    std::map<IndexT, std::string> descriptorsFilesA;
+    voctree::getListOfDescriptorFiles(sfmDataA, featuresFolders, descriptorsFilesA);
+    BOOST_CHECK_EQUAL(descriptorsFilesA.size(), nbViews);
+
+    // all the images in a single process
+    OrderedPairList selectedPairs;
+    conditionVocTree(treeFilepath, false, "", EImageMatchingMode::A_A, featuresFolders, sfmDataA, 0, "A",
+                     sfmDataB, "B", false, descriptorsFilesA, numImageQuery, selectedPairs);
+    BOOST_CHECK(!selectedPairs.empty());
+
+    // two ranges sharing the same database file, then merged
+    const std::string databaseFilepath = (folder / "database.bin").string();
+    std::vector<std::string> partialPairLists;
+
+    const std::size_t rangeSize = 5;
+    for (std::size_t rangeStart = 0; rangeStart < nbViews; rangeStart += rangeSize)
+    {
+        auto itBegin = std::next(descriptorsFilesA.begin(), rangeStart);
+        auto itEnd = std::next(itBegin, std::min(rangeSize, nbViews - rangeStart));
+        const std::map<IndexT, std::string> rangeDescriptorsFiles(itBegin, itEnd);
+
+        PairList allMatches;
+        queryVocTree(allMatches, treeFilepath, false, "", EImageMatchingMode::A_A, featuresFolders, sfmDataA, 0, "A",
+                     sfmDataB, "B", false, rangeDescriptorsFiles, numImageQuery, databaseFilepath);
+        BOOST_CHECK_EQUAL(allMatches.size(), rangeDescriptorsFiles.size());
+
+        partialPairLists.push_back((folder / ("pairList_" + std::to_string(rangeStart) + ".txt")).string());
+        savePairList(partialPairLists.back(), allMatches);
+    }
+    BOOST_CHECK(fs::exists(databaseFilepath));
+
+    OrderedPairList mergedPairs;
+    mergePartialPairLists(partialPairLists, numImageQuery, mergedPairs);
+    BOOST_CHECK(mergedPairs == selectedPairs);
+
+    // the database cannot be reused with other inputs
+    const std::size_t nbWords = voctree::VocabularyTree<DescriptorFloat>(treeFilepath).words();
+    VocTreeDatabasesFingerprint fingerprint = computeVocTreeDatabasesFingerprint(EImageMatchingMode::A_A, nbWords, "", 0, sfmDataA, sfmDataB);
+    voctree::Database db, db2;
+    BOOST_CHECK_NO_THROW(loadVocTreeDatabases(databaseFilepath, fingerprint, db, db2));
+    BOOST_CHECK_EQUAL(db.size(), nbViews);
+
+    fingerprint.matchingMode = EImageMatchingMode::A_AB;
+    BOOST_CHECK_THROW(loadVocTreeDatabases(databaseFilepath, fingerprint, db, db2), std::runtime_error);
+
+    fingerprint = computeVocTreeDatabasesFingerprint(EImageMatchingMode::A_A, nbWords + 1, "", 0, sfmDataA, sfmDataB);
+    BOOST_CHECK_THROW(loadVocTreeDatabases(databaseFilepath, fingerprint, db, db2), std::runtime_error);
+
+    // any file stands for the weights
+    fingerprint = computeVocTreeDatabasesFingerprint(EImageMatchingMode::A_A, nbWords, treeFilepath, 0, sfmDataA, sfmDataB);
+    BOOST_CHECK_THROW(loadVocTreeDatabases(databaseFilepath, fingerprint, db, db2), std::runtime_error);
+
+    fingerprint = computeVocTreeDatabasesFingerprint(EImageMatchingMode::A_A, nbWords, "", 100, sfmDataA, sfmDataB);
+    BOOST_CHECK_THROW(loadVocTreeDatabases(databaseFilepath, fingerprint, db, db2), std::runtime_error);
+
+    sfmDataA.getViews().erase(0);
+    fingerprint = computeVocTreeDatabasesFingerprint(EImageMatchingMode::A_A, nbWords, "", 0, sfmDataA, sfmDataB);
+    BOOST_CHECK_THROW(loadVocTreeDatabases(databaseFilepath, fingerprint, db, db2), std::runtime_error);
+
+    fs::remove_all(folder);
+}
@@ -0,0 +1,270 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationMap.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/stl/hash.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace localization {
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+/// landmarks file signature
+const char landmarksFileSignature[] = "AVLOCMP2";
+
+struct LandmarksFileEntry
+{
+  std::uint32_t viewId;
+  std::int32_t descType;
+  std::uint64_t nbRegions;
+};
+
+static_assert(sizeof(LandmarksFileEntry) == 16, "Unexpected landmarks file entry size.");
+static_assert(sizeof(LocalizationMap::Fingerprint) == 24, "Unexpected landmarks file fingerprint size.");
+
+std::string databaseFilename(const std::string& folder)
+{
+  return (bfs::path(folder) / "database.bin").string();
+}
+
+std::string landmarksFilename(const std::string& folder)
+{
+  return (bfs::path(folder) / "landmarks.bin").string();
+}
+
+std::string regionsFilename(const std::string& folder, IndexT viewId, feature::EImageDescriberType descType)
+{
+  return (bfs::path(folder) / (std::to_string(viewId) + "." + feature::EImageDescriberType_enumToString(descType) + ".regions")).string();
+}
+
+} // namespace
+
+struct LocalizationMap::MappingImpl
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+LocalizationMap::Fingerprint LocalizationMap::computeFingerprint(const sfmData::SfMData& sfmData)
+{
+  std::vector<IndexT> landmarkIds;
+  landmarkIds.reserve(sfmData.getLandmarks().size());
+  for(const auto& landmarkIt : sfmData.getLandmarks())
+    landmarkIds.push_back(landmarkIt.first);
+  std::sort(landmarkIds.begin(), landmarkIds.end());
+
+  Fingerprint fingerprint;
+  fingerprint.nbViews = sfmData.getViews().size();
+  fingerprint.nbLandmarks = landmarkIds.size();
+
+  // the landmarks in ascending id order, each one with its observations in ascending view id order
+  std::uint64_t hash = stl::fnv1aOffsetBasis;
+  for(const IndexT landmarkId : landmarkIds)
+  {
+    const sfmData::Observations& observations = sfmData.getLandmarks().at(landmarkId).observations;
+    const std::uint64_t nbObservations = observations.size();
+    hash = stl::hashBytes(&landmarkId, sizeof(landmarkId), hash);
+    hash = stl::hashBytes(&nbObservations, sizeof(nbObservations), hash);
+
+    for(const auto& observationPair : observations)
+    {
+      const IndexT observation[2] = {observationPair.first, observationPair.second.id_feat};
+      hash = stl::hashBytes(observation, sizeof(observation), hash);
+    }
+  }
+  fingerprint.landmarksHash = hash;
+  return fingerprint;
+}
+
+void LocalizationMap::save(const std::string& folder,
+                           const Fingerprint& fingerprint,
+                           const voctree::Database& database,
+                           const feature::RegionsPerView& regionsPerView,
+                           const ReconstructedRegionsMappingPerView& mappingPerView)
+{
+  if(!bfs::exists(folder))
+    bfs::create_directories(folder);
+
+  // an incomplete map is not reused
+  bfs::remove(landmarksFilename(folder));
+
+  database.save(databaseFilename(folder));
+
+  std::vector<LandmarksFileEntry> entries;
+  std::vector<const std::vector<IndexT>*> landmarkIds;
+
+  for(const auto& regionsPerViewIt : regionsPerView.getData())
+  {
+    const IndexT viewId = regionsPerViewIt.first;
+    for(const auto& regionsPerDescIt : regionsPerViewIt.second)
+    {
+      const feature::EImageDescriberType descType = regionsPerDescIt.first;
+      const feature::Regions& regions = *regionsPerDescIt.second;
+      if(regions.RegionCount() == 0)
+        continue;
+
+      const std::vector<IndexT>& associated3dPoint = mappingPerView.at(viewId).at(descType)._associated3dPoint;
+      if(associated3dPoint.size() != regions.RegionCount())
+        throw std::runtime_error("Cannot save the localization map: invalid reconstructed regions of view " + std::to_string(viewId) + ".");
+
+      // the regions order must be kept, the landmark ids refer to it
+      regions.SaveBinary(regionsFilename(folder, viewId, descType), false);
+
+      entries.push_back({viewId, static_cast<std::int32_t>(descType), regions.RegionCount()});
+      landmarkIds.push_back(&associated3dPoint);
+    }
+  }
+
+  // written under a temporary name, an existing landmarks file is always complete
+  const std::string filename = landmarksFilename(folder);
+  const std::string tmpFilename = filename + ".tmp";
+  {
+    std::ofstream out(tmpFilename, std::ios::binary);
+    if(!out.is_open())
+      throw std::runtime_error("Cannot save the localization map, cannot open '" + tmpFilename + "'.");
+
+    const std::uint64_t nbEntries = entries.size();
+    out.write(landmarksFileSignature, sizeof(landmarksFileSignature) - 1);
+    out.write(reinterpret_cast<const char*>(&fingerprint), sizeof(Fingerprint));
+    out.write(reinterpret_cast<const char*>(&nbEntries), sizeof(nbEntries));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(LandmarksFileEntry));
+    for(const std::vector<IndexT>* ids : landmarkIds)
+      out.write(reinterpret_cast<const char*>(ids->data()), ids->size() * sizeof(IndexT));
+
+    if(!out.good())
+      throw std::runtime_error("Cannot save the localization map, cannot write '" + tmpFilename + "'.");
+  }
+  bfs::rename(tmpFilename, filename);
+
+  ALICEVISION_LOG_INFO("Localization map saved in '" << folder << "': " << regionsPerView.getData().size() << " views.");
+}
+
+bool LocalizationMap::exists(const std::string& folder)
+{
+  return bfs::exists(landmarksFilename(folder)) && bfs::exists(databaseFilename(folder));
+}
+
+LocalizationMap::LocalizationMap(const std::string& folder,
+                                 const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                                 std::size_t maxMemory)
+  : _folder(folder)
+  , _regionsCache([this, &imageDescribers](IndexT viewId, feature::MapRegionsPerDesc& out_regions)
+      {
+        try
+        {
+          // all the describer types always exist, empty if the view has no reconstructed regions of this type
+          for(const auto& imageDescriber : imageDescribers)
+          {
+            const feature::EImageDescriberType descType = imageDescriber->getDescriberType();
+            std::unique_ptr<feature::Regions>& regions = out_regions[descType];
+            imageDescriber->allocate(regions);
+            if(_landmarksRanges.count(std::make_pair(viewId, descType)))
+              regions->LoadBinary(regionsFilename(_folder, viewId, descType));
+          }
+        }
+        catch(const std::exception& e)
+        {
+          ALICEVISION_LOG_ERROR("Cannot load the reconstructed regions of view " << viewId << ": " << e.what());
+          return false;
+        }
+        return true;
+      }, maxMemory)
+{
+  const std::string filename = landmarksFilename(folder);
+  try
+  {
+    _mapping.reset(new MappingImpl);
+    _mapping->file = boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+    _mapping->region = boost::interprocess::mapped_region(_mapping->file, boost::interprocess::read_only);
+  }
+  catch(const boost::interprocess::interprocess_exception& e)
+  {
+    throw std::runtime_error("Cannot load the localization map, cannot open '" + filename + "' (" + e.what() + ").");
+  }
+
+  const std::size_t fileSize = _mapping->region.get_size();
+  const char* data = static_cast<const char*>(_mapping->region.get_address());
+  const std::size_t signatureSize = sizeof(landmarksFileSignature) - 1;
+  const std::size_t headerSize = signatureSize + sizeof(Fingerprint) + sizeof(std::uint64_t);
+
+  if(fileSize < headerSize || !std::equal(landmarksFileSignature, landmarksFileSignature + signatureSize, data))
+    throw std::runtime_error("Cannot load the localization map, '" + filename + "' is not a landmarks file.");
+
+  std::copy(data + signatureSize, data + signatureSize + sizeof(Fingerprint), reinterpret_cast<char*>(&_fingerprint));
+
+  std::uint64_t nbEntries = 0;
+  std::copy(data + signatureSize + sizeof(Fingerprint), data + headerSize, reinterpret_cast<char*>(&nbEntries));
+
+  const std::size_t landmarksOffset = headerSize + nbEntries * sizeof(LandmarksFileEntry);
+  if(fileSize < landmarksOffset)
+    throw std::runtime_error("Cannot load the localization map, '" + filename + "' is truncated.");
+
+  // the entries are small, they are indexed in memory
+  std::size_t nbLandmarkIds = 0;
+  for(std::size_t i = 0; i < nbEntries; ++i)
+  {
+    LandmarksFileEntry entry;
+    const char* entryData = data + headerSize + i * sizeof(LandmarksFileEntry);
+    std::copy(entryData, entryData + sizeof(LandmarksFileEntry), reinterpret_cast<char*>(&entry));
+
+    _landmarksRanges[std::make_pair(entry.viewId, static_cast<feature::EImageDescriberType>(entry.descType))] = {nbLandmarkIds, entry.nbRegions};
+    _viewIds.insert(entry.viewId);
+    nbLandmarkIds += entry.nbRegions;
+  }
+
+  if(fileSize != landmarksOffset + nbLandmarkIds * sizeof(IndexT))
+    throw std::runtime_error("Cannot load the localization map, '" + filename + "' is truncated.");
+
+  // the landmark ids are accessed in place
+  _landmarkIds = reinterpret_cast<const IndexT*>(data + landmarksOffset);
+
+  ALICEVISION_LOG_INFO("Localization map opened from '" << folder << "': " << _viewIds.size() << " views, " << nbLandmarkIds << " reconstructed regions.");
+}
+
+LocalizationMap::~LocalizationMap() = default;
+
+void LocalizationMap::loadDatabase(voctree::Database& out_database) const
+{
+  out_database.load(databaseFilename(_folder));
+}
+
+bool LocalizationMap::acquire(const std::set<IndexT>& viewIds)
+{
+  return _regionsCache.acquire(viewIds);
+}
+
+const feature::MapRegionsPerDesc& LocalizationMap::getRegionsPerDesc(IndexT viewId) const
+{
+  return _regionsCache.getRegionsPerView().getRegionsPerDesc(viewId);
+}
+
+IndexT LocalizationMap::getLandmarkId(IndexT viewId, feature::EImageDescriberType descType, std::size_t regionIndex) const
+{
+  const LandmarksRange& range = _landmarksRanges.at(std::make_pair(viewId, descType));
+  if(regionIndex >= range.size)
+    throw std::out_of_range("Invalid reconstructed region " + std::to_string(regionIndex) + " of view " + std::to_string(viewId) + ".");
+  return _landmarkIds[range.offset + regionIndex];
+}
+
+std::size_t LocalizationMap::getNbViews() const
+{
+  return _viewIds.size();
+}
+
+} // namespace localization
+} // namespace aliceVision
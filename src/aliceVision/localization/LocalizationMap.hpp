@@ -0,0 +1,166 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/RegionsCache.hpp>
+#include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/localization/reconstructed_regions.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief On-disk localization map: the data of a reconstruction needed by the VoctreeLocalizer.
+ *
+ * Layout of the map folder:
+ *  - database.bin: the vocabulary tree database of the reconstructed views (see voctree::Database::save)
+ *  - <viewId>.<describerType>.regions: the reconstructed regions of each view (binary regions files)
+ *  - landmarks.bin: the fingerprint of the reconstruction and the landmark id of each reconstructed region, memory-mapped
+ *
+ * The landmarks file is written last, a map folder containing it is complete.
+ * The fingerprint identifies the reconstruction the map has been created from,
+ * a map must not be used with another reconstruction.
+ * The regions are loaded on demand in a least recently used cache (see feature::RegionsCache),
+ * so the memory used by the localizer is bounded whatever the size of the map.
+ */
+class LocalizationMap
+{
+public:
+
+  /**
+   * @brief Identification of a reconstruction.
+   */
+  struct Fingerprint
+  {
+    std::uint64_t nbViews = 0;
+    std::uint64_t nbLandmarks = 0;
+    /// hash of the sorted landmark ids and of their observations (view id, feature id)
+    std::uint64_t landmarksHash = 0;
+
+    bool operator==(const Fingerprint& other) const
+    {
+      return nbViews == other.nbViews && nbLandmarks == other.nbLandmarks && landmarksHash == other.landmarksHash;
+    }
+
+    bool operator!=(const Fingerprint& other) const { return !(*this == other); }
+  };
+
+  /**
+   * @brief Compute the fingerprint of a reconstruction.
+   * @param[in] sfmData the reconstruction
+   */
+  static Fingerprint computeFingerprint(const sfmData::SfMData& sfmData);
+
+  /**
+   * @brief Write a localization map.
+   * @param[in] folder the map folder
+   * @param[in] fingerprint the fingerprint of the reconstruction
+   * @param[in] database the vocabulary tree database of the reconstructed views
+   * @param[in] regionsPerView the reconstructed regions of each view
+   * @param[in] mappingPerView the landmark associated to each reconstructed region
+   */
+  static void save(const std::string& folder,
+                   const Fingerprint& fingerprint,
+                   const voctree::Database& database,
+                   const feature::RegionsPerView& regionsPerView,
+                   const ReconstructedRegionsMappingPerView& mappingPerView);
+
+  /**
+   * @brief Check if a folder contains a complete localization map.
+   */
+  static bool exists(const std::string& folder);
+
+  /**
+   * @brief Open a localization map.
+   * @param[in] folder the map folder
+   * @param[in] imageDescribers the image describers used to allocate the regions (must outlive the map)
+   * @param[in] maxMemory the memory budget of the cached regions (in bytes)
+   * @note throw if the map cannot be read
+   */
+  LocalizationMap(const std::string& folder,
+                  const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                  std::size_t maxMemory);
+
+  ~LocalizationMap();
+
+  // no copy
+  LocalizationMap(const LocalizationMap&) = delete;
+  LocalizationMap& operator=(const LocalizationMap&) = delete;
+
+  /**
+   * @brief Load the vocabulary tree database of the map.
+   * @param[out] out_database the database
+   */
+  void loadDatabase(voctree::Database& out_database) const;
+
+  /**
+   * @brief Make the reconstructed regions of the given views available.
+   * @param[in] viewIds the requested views
+   * @return false if the regions of a view cannot be loaded
+   * @note only the views given to the last call are guaranteed to be available
+   */
+  bool acquire(const std::set<IndexT>& viewIds);
+
+  /**
+   * @brief Get the reconstructed regions of an acquired view.
+   * @param[in] viewId the view id
+   */
+  const feature::MapRegionsPerDesc& getRegionsPerDesc(IndexT viewId) const;
+
+  /**
+   * @brief Get the landmark associated to a reconstructed region.
+   * @param[in] viewId the view id
+   * @param[in] descType the describer type of the region
+   * @param[in] regionIndex the index of the region in the reconstructed regions of the view
+   */
+  IndexT getLandmarkId(IndexT viewId, feature::EImageDescriberType descType, std::size_t regionIndex) const;
+
+  /// The fingerprint of the reconstruction the map has been created from
+  const Fingerprint& getFingerprint() const { return _fingerprint; }
+
+  /// The number of views with reconstructed regions
+  std::size_t getNbViews() const;
+
+  /// The cache of the reconstructed regions
+  const feature::RegionsCache& getRegionsCache() const { return _regionsCache; }
+
+private:
+
+  struct MappingImpl;
+
+  struct LandmarksRange
+  {
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  std::string _folder;
+  std::unique_ptr<MappingImpl> _mapping;
+  Fingerprint _fingerprint;
+  /// landmark ids of all the reconstructed regions
+  const IndexT* _landmarkIds = nullptr;
+  /// range of the landmark ids of each view and describer type
+  std::map<std::pair<IndexT, feature::EImageDescriberType>, LandmarksRange> _landmarksRanges;
+  std::set<IndexT> _viewIds;
+  feature::RegionsCache _regionsCache;
+};
+
+} // namespace localization
+} // namespace aliceVision
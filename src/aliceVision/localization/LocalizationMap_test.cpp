@@ -0,0 +1,140 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationMap.hpp"
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE LocalizationMap
+
+#include <boost/test/unit_test.hpp>
+
+namespace fs = boost::filesystem;
+using namespace aliceVision;
+
+BOOST_AUTO_TEST_CASE(LocalizationMap_saveLoad)
+{
+  const feature::EImageDescriberType descType = feature::EImageDescriberType::SIFT;
+  const std::size_t nbViews = 6;
+
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> distribution(0, 255);
+
+  // reconstructed regions of each view, the view 2 has no reconstructed regions
+  feature::RegionsPerView regionsPerView;
+  localization::ReconstructedRegionsMappingPerView mappingPerView;
+  voctree::Database database(16);
+
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    const std::size_t nbRegions = (viewId == 2) ? 0 : 10 + viewId;
+    std::unique_ptr<feature::SIFT_Regions> regions(new feature::SIFT_Regions);
+    localization::ReconstructedRegionsMapping& mapping = mappingPerView[viewId][descType];
+    voctree::SparseHistogram histogram;
+
+    for(std::size_t i = 0; i < nbRegions; ++i)
+    {
+      regions->Features().emplace_back(float(i), float(viewId), 1.f, 0.f);
+      feature::SIFT_Regions::DescriptorT descriptor;
+      for(std::size_t d = 0; d < feature::SIFT_Regions::DescriptorT::static_size; ++d)
+        descriptor[d] = static_cast<unsigned char>(distribution(generator));
+      regions->Descriptors().push_back(descriptor);
+      mapping._associated3dPoint.push_back(static_cast<IndexT>(1000 * viewId + 3 * i));
+      histogram[static_cast<voctree::Word>(i % 16)].push_back(static_cast<IndexT>(i));
+    }
+    regionsPerView.getData()[viewId][descType] = std::move(regions);
+    database.insert(viewId, histogram);
+  }
+  database.computeTfIdfWeights();
+
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path();
+  BOOST_CHECK(!localization::LocalizationMap::exists(folder.string()));
+  localization::LocalizationMap::Fingerprint fingerprint;
+  fingerprint.nbViews = nbViews;
+  fingerprint.nbLandmarks = 42;
+  fingerprint.landmarksHash = 123456789;
+  localization::LocalizationMap::save(folder.string(), fingerprint, database, regionsPerView, mappingPerView);
+  BOOST_CHECK(localization::LocalizationMap::exists(folder.string()));
+
+  std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+  imageDescribers.push_back(feature::createImageDescriber(descType));
+
+  // a budget of a single view
+  localization::LocalizationMap map(folder.string(), imageDescribers, 1);
+  BOOST_CHECK_EQUAL(map.getNbViews(), nbViews - 1);
+  BOOST_CHECK(map.getFingerprint() == fingerprint);
+
+  voctree::Database loadedDatabase;
+  map.loadDatabase(loadedDatabase);
+  BOOST_CHECK_EQUAL(loadedDatabase.size(), database.size());
+  BOOST_CHECK(loadedDatabase.getWeights() == database.getWeights());
+
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    BOOST_CHECK(map.acquire({viewId}));
+
+    const feature::Regions& expected = regionsPerView.getRegions(viewId, descType);
+    const feature::Regions& loaded = *map.getRegionsPerDesc(viewId).at(descType);
+    BOOST_CHECK_EQUAL(loaded.RegionCount(), expected.RegionCount());
+
+    const auto& expectedDescriptors = static_cast<const feature::SIFT_Regions&>(expected).Descriptors();
+    const auto& loadedDescriptors = static_cast<const feature::SIFT_Regions&>(loaded).Descriptors();
+    for(std::size_t i = 0; i < expected.RegionCount(); ++i)
+    {
+      BOOST_CHECK_EQUAL(loaded.GetRegionPosition(i), expected.GetRegionPosition(i));
+      BOOST_CHECK(std::equal(loadedDescriptors[i].getData(), loadedDescriptors[i].getData() + 128, expectedDescriptors[i].getData()));
+      BOOST_CHECK_EQUAL(map.getLandmarkId(viewId, descType, i), mappingPerView.at(viewId).at(descType)._associated3dPoint[i]);
+    }
+  }
+
+  // the least recently used views have been released
+  BOOST_CHECK_LT(map.getRegionsCache().getRegionsPerView().getData().size(), nbViews);
+  BOOST_CHECK_THROW(map.getLandmarkId(2, descType, 0), std::out_of_range);
+
+  fs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(LocalizationMap_fingerprint)
+{
+  sfmData::SfMData sfmData;
+  for(IndexT viewId = 0; viewId < 3; ++viewId)
+    sfmData.getViews().emplace(viewId, std::make_shared<sfmData::View>("", viewId));
+  for(IndexT landmarkId = 0; landmarkId < 10; ++landmarkId)
+    sfmData.getLandmarks()[10 * landmarkId] = sfmData::Landmark(Vec3::Zero(), feature::EImageDescriberType::SIFT);
+
+  const localization::LocalizationMap::Fingerprint fingerprint = localization::LocalizationMap::computeFingerprint(sfmData);
+  BOOST_CHECK_EQUAL(fingerprint.nbViews, 3);
+  BOOST_CHECK_EQUAL(fingerprint.nbLandmarks, 10);
+
+  // the same reconstruction
+  BOOST_CHECK(localization::LocalizationMap::computeFingerprint(sfmData) == fingerprint);
+
+  // the same number of landmarks with other ids
+  sfmData.getLandmarks().erase(0);
+  sfmData.getLandmarks()[1] = sfmData::Landmark(Vec3::Zero(), feature::EImageDescriberType::SIFT);
+  const localization::LocalizationMap::Fingerprint otherFingerprint = localization::LocalizationMap::computeFingerprint(sfmData);
+  BOOST_CHECK_EQUAL(otherFingerprint.nbLandmarks, 10);
+  BOOST_CHECK(otherFingerprint != fingerprint);
+
+  // the same landmarks with another observation
+  sfmData.getLandmarks().at(10).observations[0] = sfmData::Observation(Vec2::Zero(), 5, 1.0);
+  const localization::LocalizationMap::Fingerprint observationFingerprint = localization::LocalizationMap::computeFingerprint(sfmData);
+  BOOST_CHECK(observationFingerprint != otherFingerprint);
+
+  // the same observation of another feature
+  sfmData.getLandmarks().at(10).observations[0].id_feat = 6;
+  BOOST_CHECK(localization::LocalizationMap::computeFingerprint(sfmData) != observationFingerprint);
+
+  // the same observation in another view
+  sfmData.getLandmarks().at(10).observations.clear();
+  sfmData.getLandmarks().at(10).observations[1] = sfmData::Observation(Vec2::Zero(), 5, 1.0);
+  BOOST_CHECK(localization::LocalizationMap::computeFingerprint(sfmData) != observationFingerprint);
+}
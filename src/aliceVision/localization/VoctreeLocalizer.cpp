@@ -114,7 +114,9 @@ VoctreeLocalizer::VoctreeLocalizer(const sfmData::SfMData &sfmData,
                                    const std::string &descriptorsFolder,
                                    const std::string &vocTreeFilepath,
                                    const std::string &weightsFilepath,
-                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes)
+                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                                   const std::string &mapFolder,
+                                   std::size_t mapCacheMemory)
   : ILocalizer()
   , _frameBuffer(5)
 {
@@ -134,7 +136,27 @@ VoctreeLocalizer::VoctreeLocalizer(const sfmData::SfMData &sfmData,
   // then we can store only those associated to 3D points
   //? can we use Feature_Provider to load the features and filter them later?
 
+  if(!mapFolder.empty() && LocalizationMap::exists(mapFolder))
+  {
+    _isInit = initDatabaseFromMap(vocTreeFilepath, mapFolder, mapCacheMemory);
+    if(_isInit)
+      return;
+
+    // the map has been created from another reconstruction or vocabulary tree
+    ALICEVISION_LOG_WARNING("The localization map " << mapFolder << " does not match the inputs, it is rebuilt.");
+    _localizationMap.reset();
+  }
+
   _isInit = initDatabase(vocTreeFilepath, weightsFilepath, descriptorsFolder);
+
+  if(_isInit && !mapFolder.empty())
+  {
+    // write the map, then release the reconstructed regions: they are now loaded on demand
+    LocalizationMap::save(mapFolder, LocalizationMap::computeFingerprint(_sfm_data), _database, _regionsPerView, _reconstructedRegionsMappingPerView);
+    _localizationMap.reset(new LocalizationMap(mapFolder, _imageDescribers, mapCacheMemory));
+    _regionsPerView.getData().clear();
+    _reconstructedRegionsMappingPerView.clear();
+  }
 }
 
 bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
@@ -381,6 +403,63 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
   return true;
 }
 
+bool VoctreeLocalizer::initDatabaseFromMap(const std::string & vocTreeFilepath,
+                                           const std::string & mapFolder,
+                                           std::size_t mapCacheMemory)
+{
+  ALICEVISION_LOG_DEBUG("Loading vocabulary tree...");
+
+  voctree::load(_voctree, _voctreeDescType, vocTreeFilepath);
+
+  ALICEVISION_LOG_DEBUG("tree loaded with " << _voctree->levels() << " levels and "
+          << _voctree->splits() << " branching factors");
+
+  ALICEVISION_LOG_DEBUG("Opening the localization map " << mapFolder);
+  _localizationMap.reset(new LocalizationMap(mapFolder, _imageDescribers, mapCacheMemory));
+
+  const LocalizationMap::Fingerprint& mapFingerprint = _localizationMap->getFingerprint();
+  const LocalizationMap::Fingerprint sfmFingerprint = LocalizationMap::computeFingerprint(_sfm_data);
+  if(mapFingerprint != sfmFingerprint)
+  {
+    ALICEVISION_LOG_ERROR("The localization map " << mapFolder << " has not been created with the input reconstruction:" << std::endl
+                          << "\t- map: " << mapFingerprint.nbViews << " views, " << mapFingerprint.nbLandmarks << " landmarks (hash " << mapFingerprint.landmarksHash << ")" << std::endl
+                          << "\t- reconstruction: " << sfmFingerprint.nbViews << " views, " << sfmFingerprint.nbLandmarks << " landmarks (hash " << sfmFingerprint.landmarksHash << ")");
+    return false;
+  }
+
+  _localizationMap->loadDatabase(_database);
+
+  if(_database.getWeights().size() != _voctree->words())
+  {
+    ALICEVISION_LOG_ERROR("The localization map " << mapFolder << " has not been created with the vocabulary tree " << vocTreeFilepath);
+    return false;
+  }
+  return true;
+}
+
+void VoctreeLocalizer::acquireReconstructedRegions(IndexT viewId)
+{
+  if(!_localizationMap)
+    return;
+
+  if(!_localizationMap->acquire({viewId}))
+    throw std::runtime_error("Cannot load the reconstructed regions of view " + std::to_string(viewId) + " from the localization map.");
+}
+
+const feature::MapRegionsPerDesc& VoctreeLocalizer::getReconstructedRegions(IndexT viewId) const
+{
+  if(_localizationMap)
+    return _localizationMap->getRegionsPerDesc(viewId);
+  return _regionsPerView.getRegionsPerDesc(viewId);
+}
+
+IndexT VoctreeLocalizer::getAssociated3dPoint(IndexT viewId, feature::EImageDescriberType descType, std::size_t regionIndex) const
+{
+  if(_localizationMap)
+    return _localizationMap->getLandmarkId(viewId, descType, regionIndex);
+  return _reconstructedRegionsMappingPerView.at(viewId).at(descType)._associated3dPoint[regionIndex];
+}
+
 bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc &queryRegions,
                                                const std::pair<std::size_t, std::size_t> &queryImageSize,
                                                const Parameters &param,
@@ -433,13 +512,16 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
     const IndexT matchedViewId = matchedImage.id;
     // the handler to the current view
     const std::shared_ptr<sfmData::View> matchedView = _sfm_data.getViews().at(matchedViewId);
+    // its associated reconstructed regions
+    acquireReconstructedRegions(matchedViewId);
+    const feature::MapRegionsPerDesc& matchedReconstructedRegions = getReconstructedRegions(matchedViewId);
 
     // safeguard: we should match the query image with an image that has at least
     // some 3D points visible --> if it has 0 3d points it is likely that it is an
     // image of the dataset that was not reconstructed
-    if(_regionsPerView.getRegionsPerDesc(matchedViewId).getNbAllRegions() < minNum3DPoints)
+    if(matchedReconstructedRegions.getNbAllRegions() < minNum3DPoints)
     {
-      ALICEVISION_LOG_DEBUG("[matching]\tSkipping matching with " << matchedView->getImage().getImagePath() << " as it has too few visible 3D points (" << _regionsPerView.getRegionsPerDesc(matchedViewId).getNbAllRegions() << ")");
+      ALICEVISION_LOG_DEBUG("[matching]\tSkipping matching with " << matchedView->getImage().getImagePath() << " as it has too few visible 3D points (" << matchedReconstructedRegions.getNbAllRegions() << ")");
       continue;
     }
     ALICEVISION_LOG_DEBUG("[matching]\tTrying to match the query image with " << matchedView->getImage().getImagePath());
@@ -455,7 +537,7 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
     bool matchWorked = robustMatching(matchers,
                                       // pass the input intrinsic if they are valid, null otherwise
                                       (useInputIntrinsics) ? &queryIntrinsics : nullptr,
-                                      _regionsPerView.getRegionsPerDesc(matchedViewId),
+                                      matchedReconstructedRegions,
                                       matchedIntrinsics,
                                       param._fDistRatio,
                                       param._matchingError,
@@ -489,7 +571,7 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
                       queryRegions,
                       matchedPath,
                       std::make_pair(mview->getImage().getWidth(), mview->getImage().getHeight()),
-                      _regionsPerView.getRegionsPerDesc(matchedViewId),
+                      matchedReconstructedRegions,
                       featureMatches,
                       param._visualDebug + "/" + queryimage + "_" + matchedImage + ".svg"); 
     }
@@ -509,12 +591,11 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
     for(const auto& featureMatchesIt : featureMatches)
     {
       const feature::EImageDescriberType descType = featureMatchesIt.first;
-      const auto& matchedRegions = _reconstructedRegionsMappingPerView.at(matchedViewId).at(descType);
 
       for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
       {
         // the ID of the 3D point
-        const IndexT trackId3D = matchedRegions._associated3dPoint[featureMatch._j];
+        const IndexT trackId3D = getAssociated3dPoint(matchedViewId, descType, featureMatch._j);
 
         // prepare data for resectioning
         resectionData.pt3D.col(index) = _sfm_data.getLandmarks().at(trackId3D).X;
@@ -752,7 +833,7 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
                                           Mat &out_pt3D,
                                           std::vector<feature::EImageDescriberType>& out_descTypes,
                                           std::vector<voctree::DocMatch>& out_matchedImages,
-                                          const std::string& imagePath) const
+                                          const std::string& imagePath)
 {
   assert(out_descTypes.empty());
 
@@ -801,7 +882,8 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
     // the handler to the current view
     const std::shared_ptr<sfmData::View> matchedView = _sfm_data.getViews().at(matchedViewId);
     // its associated reconstructed regions
-    const feature::MapRegionsPerDesc& matchedRegions = _regionsPerView.getRegionsPerDesc(matchedViewId);
+    acquireReconstructedRegions(matchedViewId);
+    const feature::MapRegionsPerDesc& matchedRegions = getReconstructedRegions(matchedViewId);
     
     // safeguard: we should match the query image with an image that has at least
     // some 3D points visible --> if this is not true it is likely that it is an
@@ -886,23 +968,20 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
                                 queryRegions,
                                 matchedPath,
                                 std::make_pair(mview->getImage().getWidth(), mview->getImage().getHeight()),
-                                _regionsPerView.getRegionsPerDesc(matchedViewId),
+                                matchedRegions,
                                 featureMatches,
                                 outputName.string()); 
     }
 
-    const auto& matchedRegionsMapping = _reconstructedRegionsMappingPerView.at(matchedViewId);
-
     // C. recover the 2D-3D associations from the matches 
     // Each matched feature in the current similar image is associated to a 3D point
     for(const auto& featureMatchesIt : featureMatches)
     {
       feature::EImageDescriberType descType = featureMatchesIt.first;
-      const auto& matchedRegionsMappingType = matchedRegionsMapping.at(descType);
       for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
       {
         // the ID of the 3D point
-        const IndexT pt3D_id = matchedRegionsMappingType._associated3dPoint[featureMatch._j];
+        const IndexT pt3D_id = getAssociated3dPoint(matchedViewId, descType, featureMatch._j);
         const IndexT pt2D_id = featureMatch._i;
 
         const OccurenceKey key(pt3D_id, descType, pt2D_id);
@@ -15,6 +15,7 @@
 #include <aliceVision/voctree/Database.hpp>
 #include <aliceVision/matching/RegionsMatcher.hpp>
 #include <aliceVision/localization/reconstructed_regions.hpp>
+#include <aliceVision/localization/LocalizationMap.hpp>
 #include <aliceVision/localization/LocalizationResult.hpp>
 #include <aliceVision/localization/ILocalizer.hpp>
 #include <aliceVision/localization/BoundedBuffer.hpp>
@@ -89,6 +90,11 @@ public:
    * when all the documents are added.
    * @param[in] matchingDescTypes List of descriptor types to use for feature matching.
    * @param[in] voctreeDescType Descriptor type used for image matching with voctree.
+   * @param[in] mapFolder Optional path to a localization map (see LocalizationMap).
+   * If the map exists, the database and the reconstructed regions are read from it
+   * on demand instead of being loaded from the features at startup.
+   * Otherwise, the map is written once the database is initialized.
+   * @param[in] mapCacheMemory The memory budget of the reconstructed regions loaded from the map (in bytes).
    *
    * It enable the use of combined SIFT and CCTAG features.
    */
@@ -96,7 +102,9 @@ public:
                    const std::string &descriptorsFolder,
                    const std::string &vocTreeFilepath,
                    const std::string &weightsFilepath,
-                   const std::vector<feature::EImageDescriberType>& matchingDescTypes
+                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                   const std::string &mapFolder = std::string(),
+                   std::size_t mapCacheMemory = 2ul * 1024 * 1024 * 1024
                   );
   
   void setCudaPipe( int i ) override
@@ -260,6 +268,7 @@ public:
    * @param[out] out_descTypes output vector of describerType
    * @param[out] out_matchedImages image matches output
    * @param[in] imagePath
+   * @note not const: the reconstructed regions of the matched views are acquired from the localization map
    */
   void getAllAssociations(const feature::MapRegionsPerDesc & queryRegions,
                           const std::pair<std::size_t, std::size_t> &imageSize,
@@ -272,7 +281,7 @@ public:
                           Mat &out_pt3D,
                           std::vector<feature::EImageDescriberType>& out_descTypes,
                           std::vector<voctree::DocMatch>& out_matchedImages,
-                          const std::string& imagePath = std::string()) const;
+                          const std::string& imagePath = std::string());
 
 private:
   /**
@@ -291,6 +300,37 @@ private:
                     const std::string & weightsFilepath,
                     const std::string & featFolder);
 
+  /**
+   * @brief Load the vocabulary tree and open a localization map: the database is
+   * read from the map and the reconstructed regions are loaded on demand.
+   *
+   * @param[in] vocTreeFilepath The path to the vocabulary tree (usually a .tree file).
+   * @param[in] mapFolder The path to the localization map.
+   * @param[in] mapCacheMemory The memory budget of the reconstructed regions (in bytes).
+   * @return true if everything went ok
+   */
+  bool initDatabaseFromMap(const std::string & vocTreeFilepath,
+                           const std::string & mapFolder,
+                           std::size_t mapCacheMemory);
+
+  /**
+   * @brief Make the reconstructed regions of a view available, they are loaded
+   * from the localization map if needed.
+   * @note with the localization map, only the last acquired view is guaranteed to be available
+   * @note it updates the cache of the localization map, the localizer must not be shared between threads
+   */
+  void acquireReconstructedRegions(IndexT viewId);
+
+  /**
+   * @brief Get the reconstructed regions of a view (acquired if the localization map is used).
+   */
+  const feature::MapRegionsPerDesc& getReconstructedRegions(IndexT viewId) const;
+
+  /**
+   * @brief Get the 3D point associated to a reconstructed region of a view.
+   */
+  IndexT getAssociated3dPoint(IndexT viewId, feature::EImageDescriberType descType, std::size_t regionIndex) const;
+
   /**
    * @brief robustMatching
    *
@@ -343,9 +383,12 @@ private:
 public:
   
   /// for each view index, it contains the features and descriptors that have an
-  /// associated 3D point
+  /// associated 3D point (empty if the localization map is used)
   feature::RegionsPerView _regionsPerView;
   ReconstructedRegionsMappingPerView _reconstructedRegionsMappingPerView;
+
+  /// the localization map, if the reconstructed regions are loaded on demand
+  std::unique_ptr<LocalizationMap> _localizationMap;
   
   /// the feature extractor
   std::vector<std::unique_ptr<feature::ImageDescriber>> _imageDescribers;
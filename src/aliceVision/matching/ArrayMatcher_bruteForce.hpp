@@ -14,6 +14,7 @@
 
 #include <aliceVision/config.hpp>
 
+#include <algorithm>
 #include <memory>
 #include <iostream>
 
@@ -67,15 +68,9 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
     if (memMapping.get() == nullptr)
       return false;
 
-      //matrix representation of the input data;
-      Eigen::Map<BaseMat> mat_query((Scalar*)query, 1, (*memMapping).cols() );
-      Metric metric;
+      // Compute Distance Metric to all the rows
       std::vector<DistanceType> vec_dist((*memMapping).rows(), 0.0);
-    for (int i = 0; i < (*memMapping).rows(); ++i)
-    {
-        // Compute Distance Metric
-        vec_dist[i] = metric( (Scalar*)query, (*memMapping).row(i).data(), (*memMapping).cols() );
-      }
+      feature::MetricBlock<Metric>::compute(query, 1, (*memMapping).data(), (*memMapping).rows(), (*memMapping).cols(), vec_dist.data());
       if (!vec_dist.empty())
       {
         // Find the minimum distance :
@@ -117,36 +112,42 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
       return false;
     }
 
-    //matrix representation of the input data;
-    Eigen::Map<BaseMat> mat_query((Scalar*)query, nbQuery, (*memMapping).cols());
-    Metric metric;
+    const int nbRows = (*memMapping).rows();
+    const int dimension = (*memMapping).cols();
 
     pvec_distances->resize(nbQuery * NN);
     pvec_indices->resize(nbQuery * NN);
 
+    // Queries are processed by blocks: the dataset rows are loaded once in cache for all the queries of a block
+    const int queryBlockSize = 16;
+    const int nbQueryBlocks = (nbQuery + queryBlockSize - 1) / queryBlockSize;
+
     #pragma omp parallel for schedule(dynamic)
-    for (int queryIndex=0; queryIndex < nbQuery; ++queryIndex) 
+    for (int blockIndex = 0; blockIndex < nbQueryBlocks; ++blockIndex)
     {
-      std::vector<DistanceType> vec_distance((*memMapping).rows(), 0.0);
-      const Scalar * queryPtr = mat_query.row(queryIndex).data();
-      const Scalar * rowPtr = (*memMapping).data();
-      for (int i = 0; i < (*memMapping).rows(); ++i)
-      {
-        vec_distance[i] = metric( queryPtr,
-          rowPtr, (*memMapping).cols() );
-        rowPtr += (*memMapping).cols();
-      }
+      const int firstQuery = blockIndex * queryBlockSize;
+      const int nbBlockQueries = std::min(queryBlockSize, nbQuery - firstQuery);
 
-      // Find the N minimum distances:
-      const int maxMinFound = (int) std::min( size_t(NN), vec_distance.size());
-      using namespace stl::indexed_sort;
-      std::vector< sort_index_packet_ascend< DistanceType, int> > packet_vec(vec_distance.size());
-      sort_index_helper(packet_vec, &vec_distance[0], maxMinFound);
+      std::vector<DistanceType> vec_distances(nbBlockQueries * nbRows, 0.0);
+      feature::MetricBlock<Metric>::compute(query + firstQuery * dimension, nbBlockQueries,
+                                            (*memMapping).data(), nbRows, dimension, vec_distances.data());
 
-      for (int i = 0; i < maxMinFound; ++i)
+      for (int blockQueryIndex = 0; blockQueryIndex < nbBlockQueries; ++blockQueryIndex)
       {
-        (*pvec_distances)[queryIndex*NN+i] = packet_vec[i].val;
-        (*pvec_indices)[queryIndex*NN+i] = IndMatch(queryIndex, packet_vec[i].index);
+        const int queryIndex = firstQuery + blockQueryIndex;
+        const DistanceType * queryDistances = &vec_distances[blockQueryIndex * nbRows];
+
+        // Find the N minimum distances:
+        const int maxMinFound = (int) std::min( size_t(NN), size_t(nbRows));
+        using namespace stl::indexed_sort;
+        std::vector< sort_index_packet_ascend< DistanceType, int> > packet_vec(nbRows);
+        sort_index_helper(packet_vec, queryDistances, maxMinFound);
+
+        for (int i = 0; i < maxMinFound; ++i)
+        {
+          (*pvec_distances)[queryIndex*NN+i] = packet_vec[i].val;
+          (*pvec_indices)[queryIndex*NN+i] = IndMatch(queryIndex, packet_vec[i].index);
+        }
       }
     }
     return true;
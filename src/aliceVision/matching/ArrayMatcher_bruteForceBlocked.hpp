@@ -0,0 +1,199 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/matching/ArrayMatcher.hpp>
+#include <aliceVision/feature/metric.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Brute force matcher computing the squared L2 distance matrix by tiles.
+ *
+ * The squared distances are computed as ||a||^2 + ||b||^2 - 2 a.b,
+ * where the dot products of a tile of queries and a tile of dataset rows
+ * are computed with a blocked matrix product (GEMM).
+ * The N nearest neighbours of each query are updated after each tile,
+ * so the full distance matrix is never stored.
+ *
+ * Unsigned char descriptors are converted to float: the distances are exact
+ * as long as they fit in the float mantissa (e.g. 128-dimensional SIFT).
+ *
+ * Efficient for many-to-many matching (e.g. exhaustive matching of small image sets
+ * or localization against a few images).
+ */
+template < typename Scalar = float, typename Metric = feature::L2_Vectorized<Scalar> >
+class ArrayMatcher_bruteForceBlocked : public ArrayMatcher<Scalar, Metric>
+{
+public:
+  typedef typename Metric::ResultType DistanceType;
+  /// type used for the matrix products
+  typedef typename std::conditional<std::is_same<Scalar, double>::value, double, float>::type ComputeT;
+
+  /// number of queries per tile
+  static const int queryBlockSize = 64;
+  /// number of dataset rows per tile
+  static const int datasetBlockSize = 256;
+
+  ArrayMatcher_bruteForceBlocked() {}
+  virtual ~ArrayMatcher_bruteForceBlocked() {}
+
+  /**
+   * Build the matching structure
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build(std::mt19937 & randomNumberGenerator, const Scalar * dataset, int nbRows, int dimension)
+  {
+    if (nbRows < 1)
+    {
+      _dataset.resize(0, 0);
+      _squaredNorms.resize(0);
+      return false;
+    }
+    _dataset = Eigen::Map<const ScalarMat>(dataset, nbRows, dimension).template cast<ComputeT>();
+    _squaredNorms = _dataset.rowwise().squaredNorm();
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour(const Scalar * query, int * indice, DistanceType * distance)
+  {
+    IndMatches vec_indices;
+    std::vector<DistanceType> vec_distances;
+    if (!SearchNeighbours(query, 1, &vec_indices, &vec_distances, 1))
+      return false;
+
+    *indice = vec_indices.front()._j;
+    *distance = vec_distances.front();
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[out]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours(const Scalar * query, int nbQuery,
+                        IndMatches * pvec_indices,
+                        std::vector<DistanceType> * pvec_distances,
+                        size_t NN)
+  {
+    const int nbRows = _dataset.rows();
+    const int dimension = _dataset.cols();
+
+    if (nbRows == 0 || NN < 1 || NN > size_t(nbRows) || nbQuery < 1)
+      return false;
+
+    pvec_distances->resize(nbQuery * NN);
+    pvec_indices->resize(nbQuery * NN);
+
+    const Eigen::Map<const ScalarMat> queries(query, nbQuery, dimension);
+    const int nbQueryBlocks = (nbQuery + queryBlockSize - 1) / queryBlockSize;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int blockIndex = 0; blockIndex < nbQueryBlocks; ++blockIndex)
+    {
+      const int firstQuery = blockIndex * queryBlockSize;
+      const int nbBlockQueries = std::min(queryBlockSize, nbQuery - firstQuery);
+
+      const ComputeMat queryBlock = queries.middleRows(firstQuery, nbBlockQueries).template cast<ComputeT>();
+      const ComputeVec queryNorms = queryBlock.rowwise().squaredNorm();
+
+      // sorted N nearest neighbours per query: (squared distance, dataset index)
+      std::vector<std::pair<ComputeT, int>> nearest(nbBlockQueries * NN, {std::numeric_limits<ComputeT>::max(), -1});
+
+      ComputeMat products(nbBlockQueries, datasetBlockSize);
+
+      for (int firstRow = 0; firstRow < nbRows; firstRow += datasetBlockSize)
+      {
+        const int nbBlockRows = std::min(datasetBlockSize, nbRows - firstRow);
+
+        // dot products between the queries and the dataset rows of the tile
+        products.leftCols(nbBlockRows).noalias() = queryBlock * _dataset.middleRows(firstRow, nbBlockRows).transpose();
+
+        for (int q = 0; q < nbBlockQueries; ++q)
+        {
+          std::pair<ComputeT, int>* queryNearest = &nearest[q * NN];
+          const ComputeT queryNorm = queryNorms(q);
+          const ComputeT* queryProducts = products.row(q).data();
+          ComputeT worstDistance = queryNearest[NN - 1].first;
+
+          for (int r = 0; r < nbBlockRows; ++r)
+          {
+            const ComputeT distance = queryNorm + _squaredNorms(firstRow + r) - ComputeT(2) * queryProducts[r];
+            if (distance >= worstDistance)
+              continue;
+
+            // insert in the sorted list of nearest neighbours
+            size_t k = NN - 1;
+            while (k > 0 && queryNearest[k - 1].first > distance)
+            {
+              queryNearest[k] = queryNearest[k - 1];
+              --k;
+            }
+            queryNearest[k] = {distance, firstRow + r};
+            worstDistance = queryNearest[NN - 1].first;
+          }
+        }
+      }
+
+      for (int q = 0; q < nbBlockQueries; ++q)
+      {
+        const int queryIndex = firstQuery + q;
+        for (size_t i = 0; i < NN; ++i)
+        {
+          const std::pair<ComputeT, int>& neighbour = nearest[q * NN + i];
+          // rounding errors of the expansion can produce small negative values
+          (*pvec_distances)[queryIndex * NN + i] = static_cast<DistanceType>(std::max(ComputeT(0), neighbour.first));
+          (*pvec_indices)[queryIndex * NN + i] = IndMatch(queryIndex, neighbour.second);
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> ScalarMat;
+  typedef Eigen::Matrix<ComputeT, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> ComputeMat;
+  typedef Eigen::Matrix<ComputeT, Eigen::Dynamic, 1> ComputeVec;
+
+  /// dataset converted to the computation type
+  ComputeMat _dataset;
+  /// squared norm of each dataset row
+  ComputeVec _squaredNorms;
+};
+
+}  // namespace matching
+}  // namespace aliceVision
@@ -11,10 +11,12 @@
 #include <aliceVision/feature/metric.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/stl/DynamicBitset.hpp>
+#include <aliceVision/stl/hash.hpp>
 
 #include <iostream>
 #include <random>
 #include <cmath>
+#include <cstdint>
 
 namespace aliceVision {
 namespace matching {
@@ -198,21 +200,51 @@ public:
       }
     }
     // Build the Buckets
+    BuildBuckets(hashed_descriptions);
+    return hashed_descriptions;
+  }
+
+  // Fill the buckets of hashed descriptions from their bucket ids
+  // (e.g. for hashed descriptions loaded from a cache).
+  void BuildBuckets
+  (
+    HashedDescriptions & hashed_descriptions
+  ) const
+  {
+    hashed_descriptions.buckets.clear();
+    hashed_descriptions.buckets.resize(nb_bucket_groups_);
+    for (int i = 0; i < nb_bucket_groups_; ++i)
     {
-      hashed_descriptions.buckets.resize(nb_bucket_groups_);
-      for (int i = 0; i < nb_bucket_groups_; ++i)
-      {
-        hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
+      hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
 
-        // Add the descriptor ID to the proper bucket group and id.
-        for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
-        {
-          const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
-          hashed_descriptions.buckets[i][bucket_id].push_back(j);
-        }
+      // Add the descriptor ID to the proper bucket group and id.
+      for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
+      {
+        const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
+        hashed_descriptions.buckets[i][bucket_id].push_back(j);
       }
     }
-    return hashed_descriptions;
+  }
+
+  int getNbHashCode() const { return nb_hash_code_; }
+  int getNbBucketGroups() const { return nb_bucket_groups_; }
+
+  // Returns a hash of the hashing parameters and projections:
+  // two hashers with the same fingerprint produce the same hashed descriptions.
+  std::uint64_t getFingerprint() const
+  {
+    std::uint64_t hash = stl::fnv1aOffsetBasis;
+    const auto combine = [&hash](const void* data, std::size_t size)
+    {
+      hash = stl::hashBytes(data, size, hash);
+    };
+    combine(&nb_hash_code_, sizeof(nb_hash_code_));
+    combine(&nb_bucket_groups_, sizeof(nb_bucket_groups_));
+    combine(&nb_bits_per_bucket_, sizeof(nb_bits_per_bucket_));
+    combine(primary_hash_projection_.data(), primary_hash_projection_.size() * sizeof(float));
+    for (const Eigen::MatrixXf& projection : secondary_hash_projection_)
+      combine(projection.data(), projection.size() * sizeof(float));
+    return hash;
   }
 
   // Matches two collection of hashed descriptions with a fast matching scheme
@@ -254,8 +286,7 @@ public:
     // feature for matching (i.e., prevents duplicates).
     std::vector<bool> used_descriptor(hashed_descriptions2.hashed_desc.size());
 
-    typedef feature::Hamming<stl::dynamic_bitset::BlockType> HammingMetricType;
-    static const HammingMetricType metricH = {};
+    static_assert(sizeof(stl::dynamic_bitset::BlockType) == 1, "The hash codes are compared as raw bytes");
     for (int i = 0; i < hashed_descriptions1.hashed_desc.size(); ++i)
     {
       candidate_descriptors.clear();
@@ -291,7 +322,8 @@ public:
         {
           used_descriptor[candidate_id] = true;
 
-          const HammingMetricType::ResultType hamming_distance = metricH(
+          // SIMD Hamming distance kernel (instruction set selected at runtime)
+          const unsigned int hamming_distance = feature::hammingDistance(
             hashed_desc.hash_code.data(),
             hashed_descriptions2.hashed_desc[candidate_id].hash_code.data(),
             hashed_desc.hash_code.num_blocks());
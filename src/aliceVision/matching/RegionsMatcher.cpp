@@ -8,6 +8,7 @@
 #include "aliceVision/matching/matcherType.hpp"
 #include "aliceVision/matching/RegionsMatcher.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceBlocked.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
 
@@ -83,6 +84,13 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(std::mt19937 & randomNumbe
           out.reset(new matching::RegionsMatcher<MatcherT>(randomNumberGenerator, regions, true));
         }
         break;
+        case BRUTE_FORCE_BLOCKED_L2:
+        {
+          typedef feature::L2_Vectorized<unsigned char> MetricT;
+          typedef ArrayMatcher_bruteForceBlocked<unsigned char, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(randomNumberGenerator, regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<unsigned char> MatcherT;
@@ -112,6 +120,13 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(std::mt19937 & randomNumbe
           out.reset(new matching::RegionsMatcher<MatcherT>(randomNumberGenerator, regions, true));
         }
         break;
+        case BRUTE_FORCE_BLOCKED_L2:
+        {
+          typedef feature::L2_Vectorized<float> MetricT;
+          typedef ArrayMatcher_bruteForceBlocked<float, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(randomNumberGenerator, regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<float> MatcherT;
@@ -141,6 +156,13 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(std::mt19937 & randomNumbe
           out.reset(new matching::RegionsMatcher<MatcherT>(randomNumberGenerator, regions, true));
         }
         break;
+        case BRUTE_FORCE_BLOCKED_L2:
+        {
+          typedef feature::L2_Vectorized<double> MetricT;
+          typedef ArrayMatcher_bruteForceBlocked<double, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(randomNumberGenerator, regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<double> MatcherT;
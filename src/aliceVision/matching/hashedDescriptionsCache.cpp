@@ -0,0 +1,246 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "hashedDescriptionsCache.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/stl/hash.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace matching {
+
+namespace {
+
+const char hashedDescriptionsMagic[8] = {'A', 'V', 'C', 'H', 'A', 'S', 'H', '\0'};
+const char zeroMeanMagic[8] = {'A', 'V', 'Z', 'M', 'E', 'A', 'N', '\0'};
+
+struct HashedDescriptionsHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t nbHashBits;
+  std::uint32_t nbBucketGroups;
+  std::uint32_t reserved;
+  std::uint64_t nbDescriptions;
+  std::uint64_t descriptorsHash;
+};
+
+struct ZeroMeanHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t dimension;
+};
+
+static_assert(sizeof(HashedDescriptionsHeader) == 40, "Unexpected hashed descriptions header size.");
+static_assert(sizeof(ZeroMeanHeader) == 16, "Unexpected zero mean header size.");
+
+std::string toHex(std::uint64_t value)
+{
+  std::ostringstream os;
+  os << std::hex << std::setw(16) << std::setfill('0') << value;
+  return os.str();
+}
+
+bool readFile(const std::string& filepath, std::vector<char>& out_buffer)
+{
+  std::ifstream stream(filepath, std::ios::in | std::ios::binary | std::ios::ate);
+  if(!stream.is_open())
+    return false;
+  const std::streamsize size = stream.tellg();
+  if(size <= 0)
+    return false;
+  out_buffer.resize(static_cast<std::size_t>(size));
+  stream.seekg(0);
+  return bool(stream.read(out_buffer.data(), size));
+}
+
+/**
+ * @brief Write a file in a temporary file and rename it,
+ *        so that concurrent readers never see a partial file.
+ */
+void writeFile(const std::string& filepath, const std::vector<char>& buffer)
+{
+  const fs::path tmpPath = fs::path(filepath).parent_path() / fs::unique_path("%%%%%%%%%%%%.tmp");
+  {
+    std::ofstream stream(tmpPath.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!stream.is_open() || !stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size())))
+    {
+      ALICEVISION_LOG_WARNING("Can't write cache file '" << tmpPath.string() << "'.");
+      return;
+    }
+  }
+  boost::system::error_code ec;
+  fs::rename(tmpPath, filepath, ec);
+  if(ec)
+  {
+    ALICEVISION_LOG_WARNING("Can't write cache file '" << filepath << "' (" << ec.message() << ").");
+    fs::remove(tmpPath, ec);
+  }
+}
+
+} // namespace
+
+HashedDescriptionsCache::HashedDescriptionsCache(const std::string& cacheFolder,
+                                                 feature::EImageDescriberType descType,
+                                                 const CascadeHasher& hasher)
+  : _hasher(hasher)
+  , _cacheFolder(cacheFolder)
+{
+  _keyPrefix = feature::EImageDescriberType_enumToString(descType) + "_" + toHex(hasher.getFingerprint());
+
+  boost::system::error_code ec;
+  fs::create_directories(_cacheFolder, ec);
+  if(ec)
+    ALICEVISION_LOG_WARNING("Can't create hashed descriptions cache folder '" << _cacheFolder << "' (" << ec.message() << ").");
+}
+
+bool HashedDescriptionsCache::loadZeroMeanDescriptor(Eigen::VectorXf& out_zeroMeanDescriptor) const
+{
+  std::vector<char> buffer;
+  if(!readFile((fs::path(_cacheFolder) / (_keyPrefix + ".zeroMean")).string(), buffer) ||
+     buffer.size() < sizeof(ZeroMeanHeader))
+    return false;
+
+  ZeroMeanHeader header;
+  std::memcpy(&header, buffer.data(), sizeof(header));
+  if(std::memcmp(header.magic, zeroMeanMagic, sizeof(zeroMeanMagic)) != 0 ||
+     header.version != hashedDescriptionsCacheVersion ||
+     buffer.size() != sizeof(header) + header.dimension * sizeof(float))
+    return false;
+
+  out_zeroMeanDescriptor.resize(header.dimension);
+  std::memcpy(out_zeroMeanDescriptor.data(), buffer.data() + sizeof(header), header.dimension * sizeof(float));
+  return true;
+}
+
+void HashedDescriptionsCache::saveZeroMeanDescriptor(const Eigen::VectorXf& zeroMeanDescriptor) const
+{
+  ZeroMeanHeader header;
+  std::memcpy(header.magic, zeroMeanMagic, sizeof(zeroMeanMagic));
+  header.version = hashedDescriptionsCacheVersion;
+  header.dimension = static_cast<std::uint32_t>(zeroMeanDescriptor.size());
+
+  std::vector<char> buffer(sizeof(header) + zeroMeanDescriptor.size() * sizeof(float));
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  std::memcpy(buffer.data() + sizeof(header), zeroMeanDescriptor.data(), zeroMeanDescriptor.size() * sizeof(float));
+
+  writeFile((fs::path(_cacheFolder) / (_keyPrefix + ".zeroMean")).string(), buffer);
+}
+
+void HashedDescriptionsCache::setZeroMeanDescriptor(const Eigen::VectorXf& zeroMeanDescriptor)
+{
+  const std::uint64_t zeroMeanHash = stl::hashBytes(zeroMeanDescriptor.data(), zeroMeanDescriptor.size() * sizeof(float));
+  _hashedDescriptionsFolder = (fs::path(_cacheFolder) / (_keyPrefix + "_" + toHex(zeroMeanHash))).string();
+
+  boost::system::error_code ec;
+  fs::create_directories(_hashedDescriptionsFolder, ec);
+  if(ec)
+    ALICEVISION_LOG_WARNING("Can't create hashed descriptions cache folder '" << _hashedDescriptionsFolder << "' (" << ec.message() << ").");
+}
+
+std::string HashedDescriptionsCache::getHashedDescriptionsPath(IndexT viewId) const
+{
+  return (fs::path(_hashedDescriptionsFolder) / (std::to_string(viewId) + ".hash")).string();
+}
+
+bool HashedDescriptionsCache::load(IndexT viewId,
+                                   const void* descriptors,
+                                   std::size_t nbDescriptors,
+                                   std::size_t descriptorsByteSize,
+                                   HashedDescriptions& out_hashedDescriptions) const
+{
+  assert(!_hashedDescriptionsFolder.empty());
+
+  std::vector<char> buffer;
+  if(!readFile(getHashedDescriptionsPath(viewId), buffer) || buffer.size() < sizeof(HashedDescriptionsHeader))
+    return false;
+
+  HashedDescriptionsHeader header;
+  std::memcpy(&header, buffer.data(), sizeof(header));
+
+  const std::size_t nbHashBlocks = stl::dynamic_bitset(header.nbHashBits).num_blocks();
+  const std::size_t expectedSize = sizeof(header) +
+                                   header.nbDescriptions * (nbHashBlocks + header.nbBucketGroups * sizeof(std::uint16_t));
+
+  if(std::memcmp(header.magic, hashedDescriptionsMagic, sizeof(hashedDescriptionsMagic)) != 0 ||
+     header.version != hashedDescriptionsCacheVersion ||
+     header.nbBucketGroups != static_cast<std::uint32_t>(_hasher.getNbBucketGroups()) ||
+     header.nbDescriptions != nbDescriptors ||
+     buffer.size() != expectedSize)
+    return false;
+
+  // outdated entry: the image descriptors have changed
+  if(header.descriptorsHash != stl::hashBytes(descriptors, descriptorsByteSize))
+    return false;
+
+  const char* hashCodes = buffer.data() + sizeof(header);
+  const char* bucketIds = hashCodes + header.nbDescriptions * nbHashBlocks;
+
+  out_hashedDescriptions.hashed_desc.resize(header.nbDescriptions);
+  for(std::size_t i = 0; i < header.nbDescriptions; ++i)
+  {
+    HashedDescription& hashedDesc = out_hashedDescriptions.hashed_desc[i];
+    hashedDesc.hash_code = stl::dynamic_bitset(header.nbHashBits);
+    std::memcpy(hashedDesc.hash_code.data(), hashCodes + i * nbHashBlocks, nbHashBlocks);
+    hashedDesc.bucket_ids.resize(header.nbBucketGroups);
+    std::memcpy(hashedDesc.bucket_ids.data(), bucketIds + i * header.nbBucketGroups * sizeof(std::uint16_t),
+                header.nbBucketGroups * sizeof(std::uint16_t));
+  }
+
+  _hasher.BuildBuckets(out_hashedDescriptions);
+  return true;
+}
+
+void HashedDescriptionsCache::save(IndexT viewId,
+                                   const void* descriptors,
+                                   std::size_t descriptorsByteSize,
+                                   const HashedDescriptions& hashedDescriptions) const
+{
+  assert(!_hashedDescriptionsFolder.empty());
+
+  if(hashedDescriptions.hashed_desc.empty())
+    return;
+
+  HashedDescriptionsHeader header;
+  std::memcpy(header.magic, hashedDescriptionsMagic, sizeof(hashedDescriptionsMagic));
+  header.version = hashedDescriptionsCacheVersion;
+  header.nbHashBits = static_cast<std::uint32_t>(hashedDescriptions.hashed_desc.front().hash_code.size());
+  header.nbBucketGroups = static_cast<std::uint32_t>(_hasher.getNbBucketGroups());
+  header.reserved = 0;
+  header.nbDescriptions = hashedDescriptions.hashed_desc.size();
+  header.descriptorsHash = stl::hashBytes(descriptors, descriptorsByteSize);
+
+  const std::size_t nbHashBlocks = hashedDescriptions.hashed_desc.front().hash_code.num_blocks();
+  const std::size_t bucketIdsSize = header.nbBucketGroups * sizeof(std::uint16_t);
+
+  std::vector<char> buffer(sizeof(header) + header.nbDescriptions * (nbHashBlocks + bucketIdsSize));
+  std::memcpy(buffer.data(), &header, sizeof(header));
+
+  char* hashCodes = buffer.data() + sizeof(header);
+  char* bucketIds = hashCodes + header.nbDescriptions * nbHashBlocks;
+  for(std::size_t i = 0; i < header.nbDescriptions; ++i)
+  {
+    const HashedDescription& hashedDesc = hashedDescriptions.hashed_desc[i];
+    std::memcpy(hashCodes + i * nbHashBlocks, hashedDesc.hash_code.data(), nbHashBlocks);
+    std::memcpy(bucketIds + i * bucketIdsSize, hashedDesc.bucket_ids.data(), bucketIdsSize);
+  }
+
+  writeFile(getHashedDescriptionsPath(viewId), buffer);
+}
+
+}  // namespace matching
+}  // namespace aliceVision
@@ -0,0 +1,109 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/matching/CascadeHasher.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace aliceVision {
+namespace matching {
+
+/// Hashed descriptions cache file format version
+constexpr std::uint32_t hashedDescriptionsCacheVersion = 1;
+
+/**
+ * @brief Persistent on-disk cache of the cascade hashing descriptions.
+ *
+ * The hashed descriptions (hash codes and bucket ids) of each image only depend on
+ * the hasher projections, the zero mean descriptor and the image descriptors.
+ * They are stored per image in a folder keyed by the hasher fingerprint and the zero mean descriptor:
+ *   <cacheFolder>/<describerType>_<hasherFingerprint>.zeroMean
+ *   <cacheFolder>/<describerType>_<hasherFingerprint>_<zeroMeanHash>/<viewId>.hash
+ *
+ * The zero mean descriptor is shared through the cache: the first process computes and saves it,
+ * the following ones (e.g. the other featureMatching chunks) reuse it, so they share the hashed descriptions.
+ * Each hashed descriptions file stores a hash of the image descriptors to detect outdated entries.
+ * Files are written in a temporary file and renamed, so several processes can share the same cache.
+ */
+class HashedDescriptionsCache
+{
+public:
+
+  /**
+   * @brief Initialize a cache for the given hasher.
+   * @param[in] cacheFolder the cache folder (created if needed)
+   * @param[in] descType the describer type of the hashed descriptions
+   * @param[in] hasher the initialized cascade hasher
+   */
+  HashedDescriptionsCache(const std::string& cacheFolder,
+                          feature::EImageDescriberType descType,
+                          const CascadeHasher& hasher);
+
+  /**
+   * @brief Load the shared zero mean descriptor.
+   * @param[out] out_zeroMeanDescriptor the zero mean descriptor
+   * @return false if it is not cached yet or invalid
+   */
+  bool loadZeroMeanDescriptor(Eigen::VectorXf& out_zeroMeanDescriptor) const;
+
+  /**
+   * @brief Save the shared zero mean descriptor.
+   * @param[in] zeroMeanDescriptor the zero mean descriptor
+   */
+  void saveZeroMeanDescriptor(const Eigen::VectorXf& zeroMeanDescriptor) const;
+
+  /**
+   * @brief Select the zero mean descriptor used to compute the hashed descriptions.
+   * @note Must be called before load/save of hashed descriptions.
+   * @param[in] zeroMeanDescriptor the zero mean descriptor
+   */
+  void setZeroMeanDescriptor(const Eigen::VectorXf& zeroMeanDescriptor);
+
+  /**
+   * @brief Load the hashed descriptions of an image.
+   * @param[in] viewId the image view id
+   * @param[in] descriptors the image descriptors raw data
+   * @param[in] nbDescriptors the number of image descriptors
+   * @param[in] descriptorsByteSize the byte size of the image descriptors
+   * @param[out] out_hashedDescriptions the hashed descriptions (buckets included)
+   * @return false if not cached or outdated
+   */
+  bool load(IndexT viewId,
+            const void* descriptors,
+            std::size_t nbDescriptors,
+            std::size_t descriptorsByteSize,
+            HashedDescriptions& out_hashedDescriptions) const;
+
+  /**
+   * @brief Save the hashed descriptions of an image.
+   * @param[in] viewId the image view id
+   * @param[in] descriptors the image descriptors raw data
+   * @param[in] descriptorsByteSize the byte size of the image descriptors
+   * @param[in] hashedDescriptions the hashed descriptions of the image descriptors
+   */
+  void save(IndexT viewId,
+            const void* descriptors,
+            std::size_t descriptorsByteSize,
+            const HashedDescriptions& hashedDescriptions) const;
+
+private:
+  std::string getHashedDescriptionsPath(IndexT viewId) const;
+
+  const CascadeHasher& _hasher;
+  std::string _cacheFolder;
+  std::string _keyPrefix;
+  std::string _hashedDescriptionsFolder;
+};
+
+}  // namespace matching
+}  // namespace aliceVision
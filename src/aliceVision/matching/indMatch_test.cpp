@@ -7,6 +7,7 @@
 
 #include "aliceVision/matching/IndMatch.hpp"
 #include "aliceVision/matching/io.hpp"
+#include "aliceVision/matching/matchesBinaryIO.hpp"
 
 #include <boost/filesystem/operations.hpp>
 
@@ -15,6 +16,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/range/iterator_range.hpp>
 
 using namespace aliceVision;
 using namespace aliceVision::matching;
@@ -108,6 +110,146 @@ BOOST_AUTO_TEST_CASE(IndMatch_IO)
   boost::filesystem::remove_all(testFolder);
 }
 
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary)
+{
+  const std::string testFolder = "matchingBinaryTest";
+  boost::filesystem::remove_all(testFolder);
+  boost::filesystem::create_directory(testFolder);
+  {
+    std::set<IndexT> viewsKeys = {0, 1, 2};
+    PairwiseMatches matches;
+    // unsorted matches and large indexes (delta encoding must preserve order and values)
+    matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{5,0},{1,100000},{70000,3}};
+    matches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1},{2,2}};
+    matches[std::make_pair(1,2)][EImageDescriberType::SIFT] = {{4,4}};
+
+    BOOST_CHECK(Save(matches, testFolder, "bin", false));
+
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(Load(loadedMatches, viewsKeys, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(2, loadedMatches.size());
+    BOOST_CHECK(matches.at(std::make_pair(0,1)).at(EImageDescriberType::UNKNOWN) == loadedMatches.at(std::make_pair(0,1)).at(EImageDescriberType::UNKNOWN));
+    BOOST_CHECK(matches.at(std::make_pair(1,2)).at(EImageDescriberType::SIFT) == loadedMatches.at(std::make_pair(1,2)).at(EImageDescriberType::SIFT));
+
+    // views and describer types filtering
+    loadedMatches.clear();
+    BOOST_CHECK(Load(loadedMatches, {1, 2}, {testFolder}, {EImageDescriberType::SIFT}));
+    BOOST_CHECK_EQUAL(1, loadedMatches.size());
+    BOOST_CHECK_EQUAL(1, loadedMatches.at(std::make_pair(1,2)).size());
+    BOOST_CHECK_EQUAL(1, loadedMatches.at(std::make_pair(1,2)).at(EImageDescriberType::SIFT).size());
+  }
+  {
+    // append a new block in the same file, the stored pair is replaced
+    PairwiseMatches matches;
+    matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{7,7}};
+    matches[std::make_pair(0,2)][EImageDescriberType::UNKNOWN] = {{3,3},{4,4}};
+    BOOST_CHECK(Save(matches, testFolder, "bin", false, "", true));
+
+    // random access to a single pair
+    const MatchesBinaryFile file((fs::path(testFolder) / "matches.bin").string());
+    BOOST_CHECK_EQUAL(3, file.getNbPairs());
+    BOOST_CHECK_EQUAL(1, file.getNbMatches(std::make_pair(0,1), EImageDescriberType::UNKNOWN));
+    BOOST_CHECK_EQUAL(0, file.getNbMatches(std::make_pair(0,1), EImageDescriberType::SIFT));
+
+    MatchesPerDescType pairMatches;
+    BOOST_CHECK(file.loadPair(std::make_pair(0,2), pairMatches));
+    BOOST_CHECK(matches.at(std::make_pair(0,2)).at(EImageDescriberType::UNKNOWN) == pairMatches.at(EImageDescriberType::UNKNOWN));
+    BOOST_CHECK(!file.loadPair(std::make_pair(5,6), pairMatches));
+  }
+  boost::filesystem::remove_all(testFolder);
+}
+
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary_Rerun)
+{
+  const std::string testFolder = "matchingBinaryRerunTest";
+  boost::filesystem::remove_all(testFolder);
+  boost::filesystem::create_directory(testFolder);
+
+  PairwiseMatches matches;
+  matches[std::make_pair(0,1)][EImageDescriberType::SIFT] = {{0,0},{1,1},{2,2}};
+  matches[std::make_pair(0,2)][EImageDescriberType::SIFT] = {{3,3}};
+  matches[std::make_pair(1,2)][EImageDescriberType::SIFT] = {{4,4},{5,5}};
+
+  for(bool matchFilePerImage : {false, true})
+  {
+    // the second run replaces the files of the first one
+    BOOST_CHECK(Save(matches, testFolder, "bin", matchFilePerImage));
+    BOOST_CHECK(Save(matches, testFolder, "bin", matchFilePerImage));
+
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(Load(loadedMatches, {0, 1, 2}, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(3, loadedMatches.size());
+    for(const auto& pairMatches : matches)
+      BOOST_CHECK(pairMatches.second.at(EImageDescriberType::SIFT) == loadedMatches.at(pairMatches.first).at(EImageDescriberType::SIFT));
+
+    // a single lock file in the folder
+    std::size_t nbLockFiles = 0;
+    for(const auto& entry : boost::make_iterator_range(fs::directory_iterator(testFolder), {}))
+    {
+      if(entry.path().extension() == ".lock")
+        ++nbLockFiles;
+    }
+    BOOST_CHECK_EQUAL(1, nbLockFiles);
+
+    if(!matchFilePerImage)
+    {
+      const MatchesBinaryFile file((fs::path(testFolder) / "matches.bin").string());
+      BOOST_CHECK_EQUAL(3, file.getNbPairs());
+    }
+
+    // a run without the view 1 removes its previous matches file
+    PairwiseMatches partialMatches;
+    partialMatches[std::make_pair(0,2)] = matches.at(std::make_pair(0,2));
+    BOOST_CHECK(Save(partialMatches, testFolder, "bin", matchFilePerImage));
+
+    loadedMatches.clear();
+    BOOST_CHECK(Load(loadedMatches, {0, 1, 2}, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(1, loadedMatches.size());
+    BOOST_CHECK_EQUAL(1, loadedMatches.at(std::make_pair(0,2)).at(EImageDescriberType::SIFT).size());
+
+    boost::filesystem::remove_all(testFolder);
+    boost::filesystem::create_directory(testFolder);
+  }
+  boost::filesystem::remove_all(testFolder);
+}
+
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary_RangeRerun)
+{
+  const std::string testFolder = "matchingBinaryRangeRerunTest";
+  boost::filesystem::remove_all(testFolder);
+  boost::filesystem::create_directory(testFolder);
+
+  PairwiseMatches matches;
+  matches[std::make_pair(0,1)][EImageDescriberType::SIFT] = {{0,0},{1,1},{2,2}};
+  matches[std::make_pair(1,2)][EImageDescriberType::SIFT] = {{4,4},{5,5}};
+
+  for(bool matchFilePerImage : {false, true})
+  {
+    // a previous run
+    BOOST_CHECK(Save(matches, testFolder, "bin", matchFilePerImage));
+
+    // a new run in two range chunks: the first chunk removes the files of the previous run
+    PairwiseMatches firstChunkMatches, secondChunkMatches;
+    firstChunkMatches[std::make_pair(0,2)][EImageDescriberType::SIFT] = {{3,3}};
+    secondChunkMatches[std::make_pair(1,2)] = matches.at(std::make_pair(1,2));
+
+    removeMatchesFiles(testFolder, "matches.bin", matchFilePerImage);
+    BOOST_CHECK(Save(firstChunkMatches, testFolder, "bin", matchFilePerImage, "", true));
+    BOOST_CHECK(Save(secondChunkMatches, testFolder, "bin", matchFilePerImage, "", true));
+
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK(Load(loadedMatches, {0, 1, 2}, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(2, loadedMatches.size());
+    BOOST_CHECK(loadedMatches.count(std::make_pair(0,1)) == 0);
+    BOOST_CHECK_EQUAL(1, loadedMatches.at(std::make_pair(0,2)).at(EImageDescriberType::SIFT).size());
+    BOOST_CHECK_EQUAL(2, loadedMatches.at(std::make_pair(1,2)).at(EImageDescriberType::SIFT).size());
+
+    boost::filesystem::remove_all(testFolder);
+    boost::filesystem::create_directory(testFolder);
+  }
+  boost::filesystem::remove_all(testFolder);
+}
+
 BOOST_AUTO_TEST_CASE(IndMatch_DuplicateRemoval_NoRemoval)
 {
   std::vector<IndMatch> vec_indMatch;
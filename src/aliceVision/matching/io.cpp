@@ -7,12 +7,15 @@
 
 #include "io.hpp"
 #include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/matching/matchesBinaryIO.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/range/iterator_range.hpp>
 
+#include <algorithm>
+#include <cctype>
 #include <map>
 #include <fstream>
 #include <iterator>
@@ -71,6 +74,20 @@ bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
     stream.close();
     return true;
   }
+  else if(ext == ".bin")
+  {
+    try
+    {
+      const MatchesBinaryFile file(filepath);
+      file.loadAll(matches);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING(e.what());
+      return false;
+    }
+    return true;
+  }
   else
   {
     ALICEVISION_LOG_WARNING("Unknown matching file format: " << ext);
@@ -170,18 +187,25 @@ std::size_t LoadMatchFilePerImage(PairwiseMatches& matches,
  * Load and add pair-wise matches to \p matches from all files in \p folder matching \p pattern.
  * @param[out] matches PairwiseMatches to add loaded matches to
  * @param[in] folder Folder to load matches files from
- * @param[in] pattern Pattern that files must respect to be loaded
+ * @param[in] pattern Pattern that files must end with to be loaded
+ * @param[in] viewsKeysFilter Restrict the matches decoded from binary files to these views
+ * @param[in] descTypesFilter Restrict the matches decoded from binary files to these types of descriptors
  */
-std::size_t loadMatchesFromFolder(PairwiseMatches& matches, const std::string& folder, const std::string& pattern)
+std::size_t loadMatchesFromFolder(PairwiseMatches& matches,
+                                  const std::string& folder,
+                                  const std::string& pattern,
+                                  const std::set<IndexT>& viewsKeysFilter,
+                                  const std::vector<feature::EImageDescriberType>& descTypesFilter)
 {
   std::size_t nbLoadedMatchFiles = 0;
   std::vector<std::string> matchFiles;
-  // list all matches files in 'folder' matching (i.e containing) 'pattern'
+  // list all matches files in 'folder' matching (i.e ending with) 'pattern'
   for(const auto& entry : boost::make_iterator_range(fs::directory_iterator(folder), {}))
   {
-    if(entry.path().string().find(pattern) != std::string::npos)
+    const std::string path = entry.path().string();
+    if(path.size() >= pattern.size() && path.compare(path.size() - pattern.size(), pattern.size(), pattern) == 0)
     {
-      matchFiles.push_back(entry.path().string());
+      matchFiles.push_back(path);
     }
   }
 
@@ -191,7 +215,22 @@ std::size_t loadMatchesFromFolder(PairwiseMatches& matches, const std::string& f
     const std::string& matchFile = matchFiles[i];
     PairwiseMatches fileMatches;
     ALICEVISION_LOG_DEBUG("Loading match file: " << matchFile);
-    if(!LoadMatchFile(fileMatches, matchFile))
+
+    if(fs::extension(matchFile) == ".bin")
+    {
+      // binary matches are indexed, only decode the requested pairs
+      try
+      {
+        const MatchesBinaryFile file(matchFile);
+        file.loadAll(fileMatches, viewsKeysFilter, descTypesFilter);
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_WARNING("Unable to load match file: " << matchFile << " (" << e.what() << ")");
+        continue;
+      }
+    }
+    else if(!LoadMatchFile(fileMatches, matchFile))
     {
       ALICEVISION_LOG_WARNING("Unable to load match file: " << matchFile);
       continue;
@@ -217,8 +256,6 @@ std::size_t loadMatchesFromFolder(PairwiseMatches& matches, const std::string& f
     ++nbLoadedMatchFiles;
     }   
   }
-  if(!nbLoadedMatchFiles)
-    ALICEVISION_LOG_WARNING("No matches file loaded in: " << folder);
   return nbLoadedMatchFiles;
 }
 
@@ -230,7 +267,7 @@ bool Load(PairwiseMatches& matches,
           int minNbMatches)
 {
   std::size_t nbLoadedMatchFiles = 0;
-  const std::string pattern = "matches.txt";
+  const std::vector<std::string> patterns = {"matches.txt", "matches.bin"};
 
   // build up a set with normalized paths to remove duplicates
   std::set<std::string> foldersSet;
@@ -244,7 +281,14 @@ bool Load(PairwiseMatches& matches,
 
   for(const auto& folder : foldersSet)
   {
-    nbLoadedMatchFiles += loadMatchesFromFolder(matches, folder, pattern);
+    std::size_t nbLoadedFolderMatchFiles = 0;
+    for(const auto& pattern : patterns)
+      nbLoadedFolderMatchFiles += loadMatchesFromFolder(matches, folder, pattern, viewsKeysFilter, descTypesFilter);
+
+    if(!nbLoadedFolderMatchFiles)
+      ALICEVISION_LOG_WARNING("No matches file loaded in: " << folder);
+
+    nbLoadedMatchFiles += nbLoadedFolderMatchFiles;
   }
 
   if(!nbLoadedMatchFiles)
@@ -280,6 +324,31 @@ bool Load(PairwiseMatches& matches,
 }
 
 
+void removeMatchesFiles(const std::string& folder, const std::string& filename, bool matchFilePerImage)
+{
+  if(!fs::is_directory(folder))
+    return;
+
+  if(!matchFilePerImage)
+  {
+    fs::remove(fs::path(folder) / filename);
+    return;
+  }
+
+  const std::string suffix = "." + filename;
+  std::vector<fs::path> previousFiles;
+  for(const auto& entry : boost::make_iterator_range(fs::directory_iterator(folder), {}))
+  {
+    const std::string name = entry.path().filename().string();
+    if(name.size() > suffix.size() &&
+       name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0 &&
+       std::all_of(name.begin(), name.end() - suffix.size(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }))
+      previousFiles.push_back(entry.path());
+  }
+  for(const fs::path& path : previousFiles)
+    fs::remove(path);
+}
+
 class MatchExporter
 {
 private:
@@ -319,11 +388,13 @@ public:
   MatchExporter(
     const PairwiseMatches& matches,
     const std::string& folder,
-    const std::string& filename)
+    const std::string& filename,
+    bool append)
     : m_matches(matches)
     , m_directory(folder)
     , m_filename(filename)
     , m_ext(fs::extension(filename))
+    , m_append(append)
   {}
 
   ~MatchExporter() = default;
@@ -334,6 +405,13 @@ public:
 
     if(m_ext == ".txt")
       saveTxt(filepath, m_matches.begin(), m_matches.end());
+    else if(m_ext == ".bin")
+    {
+      // a new run replaces the matches of a previous run
+      if(!m_append)
+        removeMatchesFiles(m_directory, m_filename, false);
+      appendMatchesBinaryFile(filepath, m_matches.begin(), m_matches.end());
+    }
     else
       throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
   }
@@ -347,6 +425,10 @@ public:
         std::inserter(keys, keys.begin()),
         [](const PairwiseMatches::value_type &v) { return v.first.first; });
 
+    // a new run replaces the matches files of a previous run, including the files of the views without matches
+    if(m_ext == ".bin" && !m_append)
+      removeMatchesFiles(m_directory, m_filename, true);
+
     PairwiseMatches::const_iterator matchBegin = m_matches.begin();
     PairwiseMatches::const_iterator matchEnd = m_matches.end();
     for(IndexT key: keys)
@@ -359,6 +441,8 @@ public:
       
       if(m_ext == ".txt")
         saveTxt(filepath, matchBegin, match);
+      else if(m_ext == ".bin")
+        appendMatchesBinaryFile(filepath, matchBegin, match);
       else
         throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
 
@@ -371,16 +455,19 @@ public:
   const std::string m_ext;
   std::string m_directory;
   std::string m_filename;
+  /// append to the existing binary matches files instead of replacing them
+  const bool m_append;
 };
 
 bool Save(const PairwiseMatches& matches,
           const std::string& folder,
           const std::string& extension,
           bool matchFilePerImage,
-          const std::string& prefix)
+          const std::string& prefix,
+          bool append)
 {
   const std::string filename = prefix + "matches." + extension;
-  MatchExporter exporter(matches, folder, filename);
+  MatchExporter exporter(matches, folder, filename, append);
 
   if(matchFilePerImage)
     exporter.saveOneFilePerImage();
@@ -16,7 +16,7 @@ namespace matching {
 
 
 /**
- * @brief Load a match file.
+ * @brief Load a match file (txt or indexed binary format).
  *
  * @param[out] matches container for the output matches
  * @param[in] filepath the match file to load
@@ -72,21 +72,35 @@ void filterMatchesByViews(PairwiseMatches& matches, const std::set<IndexT>& view
  */
 void filterTopMatches(PairwiseMatches& allMatches, int maxNum, int minNum);
 
+/**
+ * @brief Remove the match file(s) of a previous run.
+ *
+ * @param[in] folder: folder containing the match files
+ * @param[in] filename: name of the match file (e.g. "matches.bin")
+ * @param[in] matchFilePerImage: remove the global match file
+ *            or the match files of all the images ("<viewId>.<filename>")
+ */
+void removeMatchesFiles(const std::string& folder, const std::string& filename, bool matchFilePerImage);
+
 /**
  * @brief Save match files.
  *
  * @param[in] matches: container for the output matches
  * @param[in] folder: folder containing the match files
- * @param[in] extension: txt or bin file format
+ * @param[in] extension: txt or bin file format (bin files are indexed binary matches files)
  * @param[in] matchFilePerImage: do we store a global match file
  *            or one match file per image
  * @param[in] prefix: optional prefix for the output file(s)
+ * @param[in] append: append the matches to the existing bin files instead of replacing them
+ *            (used by the range chunks of a run, see removeMatchesFiles), when a pair is written
+ *            several times in a file, the last entry replaces the previous ones on load
  */
 bool Save(const PairwiseMatches& matches,
           const std::string& folder,
           const std::string& extension,
           bool matchFilePerImage,
-          const std::string& prefix = "");
+          const std::string& prefix = "",
+          bool append = false);
 
 }  // namespace matching
 }  // namespace aliceVision
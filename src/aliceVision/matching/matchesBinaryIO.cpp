@@ -0,0 +1,360 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "matchesBinaryIO.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace matching {
+
+namespace {
+
+const char matchesBinaryMagic[8] = {'A', 'V', 'M', 'A', 'T', 'C', 'H', '\0'};
+constexpr std::uint32_t matchesBlockMagic = 0x4B4C424D; // "MBLK"
+
+struct FileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t reserved;
+};
+
+struct BlockHeader
+{
+  std::uint32_t magic;
+  std::uint32_t nbEntries;
+  std::uint64_t payloadSize;
+};
+
+struct IndexEntry
+{
+  std::uint32_t I;
+  std::uint32_t J;
+  std::uint32_t descType;
+  std::uint32_t nbMatches;
+  std::uint64_t payloadOffset;
+  std::uint64_t byteSize;
+};
+
+static_assert(sizeof(FileHeader) == 16, "Unexpected binary matches header size.");
+static_assert(sizeof(BlockHeader) == 16, "Unexpected binary matches block header size.");
+static_assert(sizeof(IndexEntry) == 32, "Unexpected binary matches index entry size.");
+
+// lock file of the binary matches files of a folder
+const std::string matchesBinaryLockFilename = "matches.lock";
+
+// serialize appends in the same process (file locks are per-process)
+std::mutex appendMutex;
+
+inline std::uint64_t zigzagEncode(std::int64_t value)
+{
+  return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t zigzagDecode(std::uint64_t value)
+{
+  return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+inline void writeVarint(std::vector<unsigned char>& buffer, std::uint64_t value)
+{
+  while(value >= 0x80)
+  {
+    buffer.push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<unsigned char>(value));
+}
+
+inline bool readVarint(const unsigned char*& ptr, const unsigned char* end, std::uint64_t& value)
+{
+  value = 0;
+  for(int shift = 0; shift < 64 && ptr < end; shift += 7)
+  {
+    const unsigned char byte = *ptr++;
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if(!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Encode matches as zigzag deltas (matches order is preserved).
+ */
+void encodeMatches(const IndMatches& matches, std::vector<unsigned char>& buffer)
+{
+  std::int64_t prevI = 0;
+  std::int64_t prevJ = 0;
+  for(const IndMatch& match : matches)
+  {
+    writeVarint(buffer, zigzagEncode(static_cast<std::int64_t>(match._i) - prevI));
+    writeVarint(buffer, zigzagEncode(static_cast<std::int64_t>(match._j) - prevJ));
+    prevI = match._i;
+    prevJ = match._j;
+  }
+}
+
+} // namespace
+
+struct MatchesBinaryFile::MappingImpl
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+MatchesBinaryFile::MatchesBinaryFile(const std::string& filepath)
+  : _filepath(filepath)
+{
+  if(!fs::exists(filepath) || fs::file_size(filepath) < sizeof(FileHeader))
+    throw std::runtime_error("Can't load binary matches file, '" + filepath + "' does not exist or is too small!");
+
+  try
+  {
+    _mapping.reset(new MappingImpl);
+    _mapping->file = boost::interprocess::file_mapping(filepath.c_str(), boost::interprocess::read_only);
+    _mapping->region = boost::interprocess::mapped_region(_mapping->file, boost::interprocess::read_only);
+  }
+  catch(const boost::interprocess::interprocess_exception& e)
+  {
+    throw std::runtime_error("Can't load binary matches file, can't open '" + filepath + "' (" + e.what() + ")!");
+  }
+
+  _data = static_cast<const unsigned char*>(_mapping->region.get_address());
+  _size = _mapping->region.get_size();
+
+  FileHeader header;
+  std::memcpy(&header, _data, sizeof(header));
+
+  if(std::memcmp(header.magic, matchesBinaryMagic, sizeof(matchesBinaryMagic)) != 0)
+    throw std::runtime_error("Can't load binary matches file, '" + filepath + "' is not a binary matches file!");
+
+  if(header.version != matchesBinaryFormatVersion)
+    throw std::runtime_error("Can't load binary matches file, '" + filepath + "' has an unsupported version (" +
+                             std::to_string(header.version) + ")!");
+
+  // read all block indexes, later blocks override previous entries
+  std::uint64_t offset = sizeof(FileHeader);
+  while(offset < _size)
+  {
+    BlockHeader block;
+    if(offset + sizeof(BlockHeader) > _size)
+    {
+      ALICEVISION_LOG_WARNING("Binary matches file '" << filepath << "' has an incomplete block, ignored.");
+      break;
+    }
+    std::memcpy(&block, _data + offset, sizeof(block));
+
+    const std::uint64_t indexOffset = offset + sizeof(BlockHeader);
+    const std::uint64_t payloadOffset = indexOffset + block.nbEntries * sizeof(IndexEntry);
+    const std::uint64_t blockEnd = payloadOffset + block.payloadSize;
+
+    if(block.magic != matchesBlockMagic || blockEnd > _size)
+    {
+      ALICEVISION_LOG_WARNING("Binary matches file '" << filepath << "' has an invalid or incomplete block, ignored.");
+      break;
+    }
+
+    for(std::uint32_t i = 0; i < block.nbEntries; ++i)
+    {
+      IndexEntry indexEntry;
+      std::memcpy(&indexEntry, _data + indexOffset + i * sizeof(IndexEntry), sizeof(indexEntry));
+
+      if(indexEntry.payloadOffset + indexEntry.byteSize > block.payloadSize)
+        throw std::runtime_error("Can't load binary matches file, '" + filepath + "' has an invalid index!");
+
+      Entry& entry = _index[Pair(indexEntry.I, indexEntry.J)][static_cast<feature::EImageDescriberType>(indexEntry.descType)];
+      entry.offset = payloadOffset + indexEntry.payloadOffset;
+      entry.byteSize = indexEntry.byteSize;
+      entry.nbMatches = indexEntry.nbMatches;
+    }
+
+    offset = blockEnd;
+  }
+}
+
+MatchesBinaryFile::~MatchesBinaryFile() = default;
+
+PairSet MatchesBinaryFile::getPairs() const
+{
+  PairSet pairs;
+  for(const auto& pairIt : _index)
+    pairs.insert(pairs.end(), pairIt.first);
+  return pairs;
+}
+
+std::size_t MatchesBinaryFile::getNbMatches(const Pair& pair, feature::EImageDescriberType descType) const
+{
+  const auto pairIt = _index.find(pair);
+  if(pairIt == _index.end())
+    return 0;
+
+  const auto descIt = pairIt->second.find(descType);
+  if(descIt == pairIt->second.end())
+    return 0;
+
+  return descIt->second.nbMatches;
+}
+
+void MatchesBinaryFile::decode(const Entry& entry, IndMatches& out_matches) const
+{
+  const unsigned char* ptr = _data + entry.offset;
+  const unsigned char* end = ptr + entry.byteSize;
+
+  out_matches.resize(entry.nbMatches);
+
+  std::int64_t prevI = 0;
+  std::int64_t prevJ = 0;
+  for(IndMatch& match : out_matches)
+  {
+    std::uint64_t deltaI = 0;
+    std::uint64_t deltaJ = 0;
+    if(!readVarint(ptr, end, deltaI) || !readVarint(ptr, end, deltaJ))
+      throw std::runtime_error("Can't load binary matches file, '" + _filepath + "' has corrupted matches!");
+
+    prevI += zigzagDecode(deltaI);
+    prevJ += zigzagDecode(deltaJ);
+    match._i = static_cast<IndexT>(prevI);
+    match._j = static_cast<IndexT>(prevJ);
+  }
+}
+
+bool MatchesBinaryFile::loadPair(const Pair& pair,
+                                 MatchesPerDescType& out_matches,
+                                 const std::vector<feature::EImageDescriberType>& descTypesFilter) const
+{
+  const auto pairIt = _index.find(pair);
+  if(pairIt == _index.end())
+    return false;
+
+  for(const auto& descIt : pairIt->second)
+  {
+    if(!descTypesFilter.empty() &&
+       std::find(descTypesFilter.begin(), descTypesFilter.end(), descIt.first) == descTypesFilter.end())
+      continue;
+
+    decode(descIt.second, out_matches[descIt.first]);
+  }
+  return true;
+}
+
+std::size_t MatchesBinaryFile::loadAll(PairwiseMatches& matches,
+                                       const std::set<IndexT>& viewsKeysFilter,
+                                       const std::vector<feature::EImageDescriberType>& descTypesFilter) const
+{
+  std::size_t nbLoadedPairs = 0;
+  IndMatches pairMatches;
+
+  for(const auto& pairIt : _index)
+  {
+    const Pair& pair = pairIt.first;
+
+    if(!viewsKeysFilter.empty() &&
+       (viewsKeysFilter.find(pair.first) == viewsKeysFilter.end() ||
+        viewsKeysFilter.find(pair.second) == viewsKeysFilter.end()))
+      continue;
+
+    for(const auto& descIt : pairIt.second)
+    {
+      if(!descTypesFilter.empty() &&
+         std::find(descTypesFilter.begin(), descTypesFilter.end(), descIt.first) == descTypesFilter.end())
+        continue;
+
+      decode(descIt.second, pairMatches);
+
+      // merge in global map
+      IndMatches& outMatches = matches[pair][descIt.first];
+      outMatches.insert(outMatches.end(), pairMatches.begin(), pairMatches.end());
+    }
+    ++nbLoadedPairs;
+  }
+  return nbLoadedPairs;
+}
+
+void appendMatchesBinaryFile(const std::string& filepath,
+                             const PairwiseMatches::const_iterator& matchBegin,
+                             const PairwiseMatches::const_iterator& matchEnd)
+{
+  // encode the block in memory
+  std::vector<IndexEntry> index;
+  std::vector<unsigned char> payload;
+
+  for(PairwiseMatches::const_iterator match = matchBegin; match != matchEnd; ++match)
+  {
+    for(const auto& matchesPerDesc : match->second)
+    {
+      IndexEntry entry;
+      entry.I = match->first.first;
+      entry.J = match->first.second;
+      entry.descType = static_cast<std::uint32_t>(matchesPerDesc.first);
+      entry.nbMatches = static_cast<std::uint32_t>(matchesPerDesc.second.size());
+      entry.payloadOffset = payload.size();
+      encodeMatches(matchesPerDesc.second, payload);
+      entry.byteSize = payload.size() - entry.payloadOffset;
+      index.push_back(entry);
+    }
+  }
+
+  BlockHeader block;
+  block.magic = matchesBlockMagic;
+  block.nbEntries = static_cast<std::uint32_t>(index.size());
+  block.payloadSize = payload.size();
+
+  // append the block under an inter-process lock
+  std::lock_guard<std::mutex> guard(appendMutex);
+
+  // a single lock file per folder, shared by all the matches files of the folder
+  const fs::path folder = fs::path(filepath).parent_path();
+  const std::string lockPath = (folder.empty() ? fs::path(matchesBinaryLockFilename) : folder / matchesBinaryLockFilename).string();
+  {
+    std::ofstream lockFile(lockPath, std::ios::app);
+    if(!lockFile.is_open())
+      throw std::runtime_error("Can't save binary matches file, can't create lock file '" + lockPath + "'!");
+  }
+
+  boost::interprocess::file_lock fileLock(lockPath.c_str());
+  boost::interprocess::scoped_lock<boost::interprocess::file_lock> lock(fileLock);
+
+  const bool isNewFile = !fs::exists(filepath) || fs::file_size(filepath) == 0;
+
+  std::ofstream stream(filepath, std::ios::out | std::ios::binary | std::ios::app);
+  if(!stream.is_open())
+    throw std::runtime_error("Can't save binary matches file, can't open '" + filepath + "'!");
+
+  if(isNewFile)
+  {
+    FileHeader header;
+    std::memcpy(header.magic, matchesBinaryMagic, sizeof(matchesBinaryMagic));
+    header.version = matchesBinaryFormatVersion;
+    header.reserved = 0;
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+
+  stream.write(reinterpret_cast<const char*>(&block), sizeof(block));
+  stream.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(IndexEntry)));
+  stream.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+  stream.flush();
+
+  if(!stream.good())
+    throw std::runtime_error("Can't save binary matches file, error while writing '" + filepath + "'!");
+}
+
+}  // namespace matching
+}  // namespace aliceVision
@@ -0,0 +1,130 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/matching/IndMatch.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/// Binary matches file format version
+constexpr std::uint32_t matchesBinaryFormatVersion = 1;
+
+/**
+ * @brief Indexed binary matches file.
+ *
+ * The file is a header followed by a list of independent blocks, each block is:
+ * - a block header (number of entries, payload size)
+ * - an index: one entry per (pair, describer type) with the number of matches and the payload location
+ * - a payload: the IndMatch arrays, zigzag delta encoded and stored as varints
+ *
+ * Blocks are appended atomically (under an inter-process file lock), so several
+ * processes (e.g. featureMatching chunks) can append into the same file.
+ * If a (pair, describer type) is stored in several blocks, the last appended one is used.
+ *
+ * Only the index is read when the file is opened, matches are decoded on demand.
+ */
+class MatchesBinaryFile
+{
+public:
+
+  /**
+   * @brief Open and index the given binary matches file.
+   * @param[in] filepath the binary matches file path
+   * @note throw if the file cannot be opened or is invalid
+   */
+  explicit MatchesBinaryFile(const std::string& filepath);
+
+  ~MatchesBinaryFile();
+
+  // no copy
+  MatchesBinaryFile(const MatchesBinaryFile&) = delete;
+  MatchesBinaryFile& operator=(const MatchesBinaryFile&) = delete;
+
+  /**
+   * @brief Get the image pairs stored in the file.
+   * @return set of image pairs
+   */
+  PairSet getPairs() const;
+
+  /**
+   * @brief Get the number of stored image pairs.
+   */
+  inline std::size_t getNbPairs() const { return _index.size(); }
+
+  /**
+   * @brief Get the number of matches of a given pair and describer type without decoding them.
+   * @param[in] pair the image pair
+   * @param[in] descType the describer type
+   * @return number of matches (0 if not stored)
+   */
+  std::size_t getNbMatches(const Pair& pair, feature::EImageDescriberType descType) const;
+
+  /**
+   * @brief Decode the matches of a single image pair.
+   * @param[in] pair the image pair
+   * @param[out] out_matches the matches per describer type
+   * @param[in] descTypesFilter restrict to these describer types (empty for all)
+   * @return false if the pair is not stored in the file
+   */
+  bool loadPair(const Pair& pair,
+                MatchesPerDescType& out_matches,
+                const std::vector<feature::EImageDescriberType>& descTypesFilter = {}) const;
+
+  /**
+   * @brief Decode and add the matches of all the pairs to the given container.
+   * @param[in,out] matches the output pairwise matches (loaded matches are appended)
+   * @param[in] viewsKeysFilter restrict to pairs of these views (empty for all)
+   * @param[in] descTypesFilter restrict to these describer types (empty for all)
+   * @return the number of loaded pairs
+   */
+  std::size_t loadAll(PairwiseMatches& matches,
+                      const std::set<IndexT>& viewsKeysFilter = {},
+                      const std::vector<feature::EImageDescriberType>& descTypesFilter = {}) const;
+
+private:
+
+  struct Entry
+  {
+    std::uint64_t offset;
+    std::uint64_t byteSize;
+    std::uint32_t nbMatches;
+  };
+
+  void decode(const Entry& entry, IndMatches& out_matches) const;
+
+  struct MappingImpl;
+  std::unique_ptr<MappingImpl> _mapping;
+  const unsigned char* _data = nullptr;
+  std::size_t _size = 0;
+  std::string _filepath;
+  std::map<Pair, std::map<feature::EImageDescriberType, Entry>> _index;
+};
+
+/**
+ * @brief Append the given pairwise matches as a new block of a binary matches file.
+ * @note The file is created if needed, concurrent appends are serialized with a single lock file
+ *       per folder ("matches.lock"), shared by all the binary matches files of the folder.
+ * @param[in] filepath the binary matches file path
+ * @param[in] matchBegin the first pairwise matches to write
+ * @param[in] matchEnd the end of the pairwise matches to write
+ */
+void appendMatchesBinaryFile(const std::string& filepath,
+                             const PairwiseMatches::const_iterator& matchBegin,
+                             const PairwiseMatches::const_iterator& matchEnd);
+
+}  // namespace matching
+}  // namespace aliceVision
@@ -7,9 +7,15 @@
 
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceBlocked.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
+#include "aliceVision/matching/hashedDescriptionsCache.hpp"
+
+#include <boost/filesystem.hpp>
+
 #include <iostream>
+#include <random>
 
 #define BOOST_TEST_MODULE matching
 
@@ -169,3 +175,130 @@ BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_Simple_EmptyArrays)
   float fDistance = -1.0f;
   BOOST_CHECK(! matcher.SearchNeighbour( &array[0], &nIndice, &fDistance) );
 }
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_Simple_Dim1)
+{
+  std::random_device rd;
+  std::mt19937 gen(rd());
+
+  const float array[] = {0, 1, 2, 3, 4};
+  ArrayMatcher_bruteForceBlocked<float> matcher;
+  BOOST_CHECK( matcher.Build(gen, array, 5, 1) );
+
+  const float query[] = {2};
+  int nIndice = -1;
+  float fDistance = -1.0f;
+  BOOST_CHECK( matcher.SearchNeighbour( query, &nIndice, &fDistance) );
+
+  BOOST_CHECK_EQUAL( 2, nIndice); // index of the found nearest neighbor
+  BOOST_CHECK_SMALL(static_cast<double>(fDistance), 1e-8); //distance
+
+  std::vector<float> emptyArray;
+  ArrayMatcher_bruteForceBlocked<float> emptyMatcher;
+  BOOST_CHECK(! emptyMatcher.Build(gen, &emptyArray[0], 0, 4) );
+  BOOST_CHECK(! emptyMatcher.SearchNeighbour( query, &nIndice, &fDistance) );
+}
+
+template<typename Scalar, typename Distribution>
+void checkBlockedSameAsBruteForce(Distribution distribution)
+{
+  std::mt19937 gen(0);
+
+  // several query and dataset tiles
+  const int nbRows = 700;
+  const int nbQueries = 150;
+  const int dimension = 128;
+
+  std::vector<Scalar> dataset(nbRows * dimension);
+  std::vector<Scalar> queries(nbQueries * dimension);
+  for(Scalar& value : dataset)
+    value = static_cast<Scalar>(distribution(gen));
+  for(Scalar& value : queries)
+    value = static_cast<Scalar>(distribution(gen));
+
+  typedef feature::L2_Vectorized<Scalar> MetricT;
+  ArrayMatcher_bruteForce<Scalar, MetricT> matcher;
+  ArrayMatcher_bruteForceBlocked<Scalar, MetricT> blockedMatcher;
+  BOOST_CHECK( matcher.Build(gen, dataset.data(), nbRows, dimension) );
+  BOOST_CHECK( blockedMatcher.Build(gen, dataset.data(), nbRows, dimension) );
+
+  const size_t NN = 2;
+  IndMatches vec_indices, vec_blockedIndices;
+  std::vector<typename MetricT::ResultType> vec_distances, vec_blockedDistances;
+  BOOST_CHECK( matcher.SearchNeighbours(queries.data(), nbQueries, &vec_indices, &vec_distances, NN) );
+  BOOST_CHECK( blockedMatcher.SearchNeighbours(queries.data(), nbQueries, &vec_blockedIndices, &vec_blockedDistances, NN) );
+
+  BOOST_CHECK_EQUAL(vec_indices.size(), vec_blockedIndices.size());
+  BOOST_CHECK_EQUAL(vec_distances.size(), vec_blockedDistances.size());
+
+  for(size_t i = 0; i < vec_distances.size(); ++i)
+  {
+    BOOST_CHECK_CLOSE(vec_distances[i], vec_blockedDistances[i], 1e-3);
+    BOOST_CHECK_EQUAL(vec_indices[i]._i, vec_blockedIndices[i]._i);
+    // nearest neighbours with the same distance can be swapped
+    if(vec_distances[i] != vec_distances[i - (i % NN) + (NN - 1 - (i % NN))])
+      BOOST_CHECK_EQUAL(vec_indices[i]._j, vec_blockedIndices[i]._j);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceBlocked_SameAsBruteForce)
+{
+  checkBlockedSameAsBruteForce<unsigned char>(std::uniform_int_distribution<int>(0, 255));
+  checkBlockedSameAsBruteForce<float>(std::uniform_real_distribution<float>(0.f, 1.f));
+}
+
+BOOST_AUTO_TEST_CASE(Matching_CascadeHasher_HashedDescriptionsCache)
+{
+  namespace fs = boost::filesystem;
+
+  const int dimension = 128;
+  const int nbDescriptors = 500;
+
+  std::mt19937 randomNumberGenerator(42);
+  std::uniform_int_distribution<int> distribution(0, 255);
+  Eigen::Matrix<unsigned char, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> descriptors(nbDescriptors, dimension);
+  for(int i = 0; i < descriptors.size(); ++i)
+    descriptors.data()[i] = static_cast<unsigned char>(distribution(randomNumberGenerator));
+
+  CascadeHasher hasher;
+  hasher.Init(randomNumberGenerator, dimension);
+  const Eigen::VectorXf zeroMean = CascadeHasher::GetZeroMeanDescriptor(descriptors);
+  const HashedDescriptions hashed = hasher.CreateHashedDescriptions(descriptors, zeroMean);
+
+  const fs::path cacheFolder = fs::temp_directory_path() / fs::unique_path();
+  const std::size_t byteSize = descriptors.size() * sizeof(unsigned char);
+  {
+    HashedDescriptionsCache cache(cacheFolder.string(), feature::EImageDescriberType::SIFT, hasher);
+    Eigen::VectorXf cachedZeroMean;
+    BOOST_CHECK(!cache.loadZeroMeanDescriptor(cachedZeroMean));
+    cache.saveZeroMeanDescriptor(zeroMean);
+    cache.setZeroMeanDescriptor(zeroMean);
+    cache.save(0, descriptors.data(), byteSize, hashed);
+  }
+
+  // another process with the same hasher reuses the cached data
+  HashedDescriptionsCache cache(cacheFolder.string(), feature::EImageDescriberType::SIFT, hasher);
+  Eigen::VectorXf cachedZeroMean;
+  BOOST_CHECK(cache.loadZeroMeanDescriptor(cachedZeroMean));
+  BOOST_CHECK(cachedZeroMean == zeroMean);
+  cache.setZeroMeanDescriptor(cachedZeroMean);
+
+  HashedDescriptions loaded;
+  BOOST_CHECK(!cache.load(1, descriptors.data(), nbDescriptors, byteSize, loaded));
+  BOOST_CHECK(cache.load(0, descriptors.data(), nbDescriptors, byteSize, loaded));
+  BOOST_CHECK_EQUAL(loaded.hashed_desc.size(), hashed.hashed_desc.size());
+  for(std::size_t i = 0; i < hashed.hashed_desc.size(); ++i)
+  {
+    const stl::dynamic_bitset& hashCode = hashed.hashed_desc[i].hash_code;
+    BOOST_CHECK_EQUAL(loaded.hashed_desc[i].hash_code.size(), hashCode.size());
+    BOOST_CHECK(std::equal(hashCode.data(), hashCode.data() + hashCode.num_blocks(), loaded.hashed_desc[i].hash_code.data()));
+    BOOST_CHECK(loaded.hashed_desc[i].bucket_ids == hashed.hashed_desc[i].bucket_ids);
+  }
+  BOOST_CHECK(loaded.buckets == hashed.buckets);
+
+  // outdated entry
+  descriptors(0, 0) += 1;
+  BOOST_CHECK(!cache.load(0, descriptors.data(), nbDescriptors, byteSize, loaded));
+
+  fs::remove_all(cacheFolder);
+}
@@ -9,6 +9,37 @@
 namespace aliceVision {
 namespace matchingImageCollection {
 
+std::vector<PairSet> computeViewLocalityBatches(const PairSet& pairs, std::size_t maxViewsPerBatch)
+{
+    // rank of each view in the sorted list of views
+    std::map<IndexT, std::size_t> viewRanks;
+    for (const Pair& pair : pairs)
+    {
+        viewRanks.emplace(pair.first, 0);
+        viewRanks.emplace(pair.second, 0);
+    }
+    std::size_t rank = 0;
+    for (auto& viewRank : viewRanks)
+        viewRank.second = rank++;
+
+    // a batch contains the views of two blocks
+    const std::size_t blockSize = std::max<std::size_t>(1, maxViewsPerBatch / 2);
+
+    std::map<std::pair<std::size_t, std::size_t>, PairSet> tiles;
+    for (const Pair& pair : pairs)
+    {
+        const std::size_t blockA = viewRanks.at(pair.first) / blockSize;
+        const std::size_t blockB = viewRanks.at(pair.second) / blockSize;
+        tiles[std::minmax(blockA, blockB)].insert(pair);
+    }
+
+    std::vector<PairSet> batches;
+    batches.reserve(tiles.size());
+    for (auto& tile : tiles)
+        batches.push_back(std::move(tile.second));
+    return batches;
+}
+
 void removePoorlyOverlappingImagePairs(PairwiseMatches& geometricMatches,
                                        const PairwiseMatches& putativeMatches,
                                        float minimumRatio,
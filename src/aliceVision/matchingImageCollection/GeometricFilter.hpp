@@ -10,12 +10,17 @@
 #include <aliceVision/config.hpp>
 #include <aliceVision/feature/PointFeature.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/feature/RegionsCache.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilterMatrix.hpp>
+#include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/ProgressDisplay.hpp>
 
+#include <algorithm>
+#include <functional>
 #include <map>
 #include <random>
+#include <set>
 #include <vector>
 
 namespace aliceVision {
@@ -91,6 +96,90 @@ void robustModelEstimation(
   }
 }
 
+/**
+ * @brief Split image pairs in batches with a bounded number of views, in view-locality order.
+ * The views are split in blocks of consecutive ids and each batch contains the pairs
+ * between two blocks (tiles of the pairs adjacency matrix), so a block stays in use
+ * during consecutive batches.
+ * @param[in] pairs the image pairs
+ * @param[in] maxViewsPerBatch the maximum number of views of a batch
+ * @return the batches of image pairs
+ */
+std::vector<PairSet> computeViewLocalityBatches(const PairSet& pairs, std::size_t maxViewsPerBatch);
+
+/**
+ * @brief Perform robust model estimation (with optional guided_matching) as robustModelEstimation,
+ * but with the regions loaded on demand in a regions cache with a bounded memory.
+ * The pairs are processed by batches in view-locality order (see computeViewLocalityBatches)
+ * and the geometric matches of each batch are given to a callback, to be written incrementally.
+ * @param[in,out] regionsCache the regions cache
+ * @param[in] sfmData
+ * @param[in] functor
+ * @param[in] putativeMatches
+ * @param[in] randomNumberGenerator
+ * @param[in] processBatch called with the geometric matches of each batch and the regions of its views
+ * @param[in] guidedMatching
+ * @param[in] distanceRatio
+ * @return false if some regions cannot be loaded
+ */
+template<typename GeometryFunctor>
+bool robustModelEstimationStreaming(
+  feature::RegionsCache& regionsCache,
+  const sfmData::SfMData* sfmData,
+  const GeometryFunctor& functor,
+  const PairwiseMatches& putativeMatches,
+  std::mt19937 & randomNumberGenerator,
+  const std::function<void(PairwiseMatches& batchGeometricMatches, const feature::RegionsPerView& regionsPerView)>& processBatch,
+  const bool guidedMatching = false,
+  const double distanceRatio = 0.6
+  )
+{
+  if (putativeMatches.empty())
+    return true;
+
+  // load the views of the first pair to estimate the memory size of the regions of a view
+  const Pair& firstPair = putativeMatches.begin()->first;
+  if (!regionsCache.acquire({firstPair.first, firstPair.second}))
+    return false;
+
+  const std::size_t viewMemorySize = std::max<std::size_t>(1, regionsCache.getAverageViewMemorySize());
+  const std::size_t maxViewsPerBatch = std::max<std::size_t>(2, regionsCache.getMaxMemory() / viewMemorySize);
+
+  PairSet pairs;
+  for (const auto& putativeMatch : putativeMatches)
+    pairs.insert(putativeMatch.first);
+
+  const std::vector<PairSet> batches = computeViewLocalityBatches(pairs, maxViewsPerBatch);
+
+  ALICEVISION_LOG_INFO("Streaming robust model estimation: " << pairs.size() << " image pairs in " << batches.size() << " batches "
+                       << "(at most " << maxViewsPerBatch << " views per batch).");
+
+  for (const PairSet& batch : batches)
+  {
+    std::set<IndexT> viewIds;
+    PairwiseMatches batchPutativeMatches;
+    for (const Pair& pair : batch)
+    {
+      viewIds.insert(pair.first);
+      viewIds.insert(pair.second);
+      batchPutativeMatches.emplace(pair, putativeMatches.at(pair));
+    }
+
+    if (!regionsCache.acquire(viewIds))
+      return false;
+
+    PairwiseMatches batchGeometricMatches;
+    robustModelEstimation(batchGeometricMatches, sfmData, regionsCache.getRegionsPerView(), functor,
+                          batchPutativeMatches, randomNumberGenerator, guidedMatching, distanceRatio);
+
+    processBatch(batchGeometricMatches, regionsCache.getRegionsPerView());
+  }
+
+  ALICEVISION_LOG_INFO("Streaming robust model estimation: " << regionsCache.getNbLoads() << " views loaded, "
+                       << regionsCache.getNbHits() << " cache hits.");
+  return true;
+}
+
 /**
  * @brief removePoorlyOverlappingImagePairs Removes image pairs from the given list of geometric
  *  matches that have poor overlap according to the supplied criteria.
@@ -7,11 +7,15 @@
 
 #include <aliceVision/matchingImageCollection/ImageCollectionMatcher_cascadeHashing.hpp>
 #include <aliceVision/matching/ArrayMatcher_cascadeHashing.hpp>
+#include <aliceVision/matching/hashedDescriptionsCache.hpp>
 #include <aliceVision/matching/IndMatchDecorator.hpp>
 #include <aliceVision/matching/filters.hpp>
 #include <aliceVision/system/ProgressDisplay.hpp>
 #include <aliceVision/config.hpp>
 
+#include <atomic>
+#include <memory>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -21,8 +25,9 @@ using namespace aliceVision::feature;
 ImageCollectionMatcher_cascadeHashing
 ::ImageCollectionMatcher_cascadeHashing
 (
-  float distRatio
-):IImageCollectionMatcher(), f_dist_ratio_(distRatio)
+  float distRatio,
+  const std::string& hashedDescriptionsCacheFolder
+):IImageCollectionMatcher(), f_dist_ratio_(distRatio), _hashedDescriptionsCacheFolder(hashedDescriptionsCacheFolder)
 {
 }
 
@@ -36,6 +41,7 @@ void Match
   const PairSet & pairs,
   EImageDescriberType descType,
   float fDistRatio,
+  const std::string& hashedDescriptionsCacheFolder,
   PairwiseMatches & map_PutativesMatches // the pairwise photometric corresponding points
 )
 {
@@ -67,8 +73,16 @@ void Match
 
   std::map<IndexT, HashedDescriptions> hashed_base_;
 
+  // Persistent cache of the hashed descriptions (shared between runs and featureMatching chunks)
+  std::unique_ptr<HashedDescriptionsCache> hashedDescriptionsCache;
+  if (!hashedDescriptionsCacheFolder.empty() && !used_index.empty())
+    hashedDescriptionsCache.reset(new HashedDescriptionsCache(hashedDescriptionsCacheFolder, descType, cascade_hasher));
+
   // Compute the zero mean descriptor that will be used for hashing (one for all the image regions)
+  // or reuse the one of the cache
   Eigen::VectorXf zero_mean_descriptor;
+  if (hashedDescriptionsCache == nullptr || !hashedDescriptionsCache->loadZeroMeanDescriptor(zero_mean_descriptor) ||
+      zero_mean_descriptor.size() != regionsPerView.getRegions(*used_index.begin(), descType).DescriptorLength())
   {
     Eigen::MatrixXf matForZeroMean;
     for (int i =0; i < used_index.size(); ++i)
@@ -92,8 +106,16 @@ void Match
       }
     }
     zero_mean_descriptor = CascadeHasher::GetZeroMeanDescriptor(matForZeroMean);
+
+    if (hashedDescriptionsCache)
+      hashedDescriptionsCache->saveZeroMeanDescriptor(zero_mean_descriptor);
   }
 
+  if (hashedDescriptionsCache)
+    hashedDescriptionsCache->setZeroMeanDescriptor(zero_mean_descriptor);
+
+  std::atomic<int> nbCachedHashedDescriptions(0);
+
   // Index the input regions
   #pragma omp parallel for schedule(dynamic)
   for (int i =0; i < used_index.size(); ++i)
@@ -106,15 +128,35 @@ void Match
       reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
     const size_t dimension = regionsI.DescriptorLength();
 
-    Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
-    HashedDescriptions hashed_description = cascade_hasher.CreateHashedDescriptions(mat_I,
-      zero_mean_descriptor);
+    const std::size_t descriptorsByteSize = regionsI.RegionCount() * dimension * sizeof(ScalarT);
+
+    HashedDescriptions hashed_description;
+    if (hashedDescriptionsCache != nullptr &&
+        hashedDescriptionsCache->load(I, tabI, regionsI.RegionCount(), descriptorsByteSize, hashed_description))
+    {
+      ++nbCachedHashedDescriptions;
+    }
+    else
+    {
+      Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
+      hashed_description = cascade_hasher.CreateHashedDescriptions(mat_I,
+        zero_mean_descriptor);
+
+      if (hashedDescriptionsCache != nullptr)
+        hashedDescriptionsCache->save(I, tabI, descriptorsByteSize, hashed_description);
+    }
     #pragma omp critical
     {
       hashed_base_[I] = std::move(hashed_description);
     }
   }
 
+  if (hashedDescriptionsCache)
+  {
+    ALICEVISION_LOG_INFO("Hashed descriptions loaded from the cache: "
+                         << nbCachedHashedDescriptions << " / " << used_index.size() << " images.");
+  }
+
   // Perform matching between all the pairs
   for (Map_vectorT::const_iterator iter = map_Pairs.begin();
     iter != map_Pairs.end(); ++iter)
@@ -236,6 +278,7 @@ void ImageCollectionMatcher_cascadeHashing::Match
       pairs,
       descType,
       f_dist_ratio_,
+      _hashedDescriptionsCacheFolder,
       map_PutativesMatches);
   }
   else
@@ -247,6 +290,7 @@ void ImageCollectionMatcher_cascadeHashing::Match
       pairs,
       descType,
       f_dist_ratio_,
+      _hashedDescriptionsCacheFolder,
       map_PutativesMatches);
   }
   else
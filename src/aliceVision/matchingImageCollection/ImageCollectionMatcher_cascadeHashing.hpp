@@ -9,6 +9,8 @@
 
 #include "aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp"
 
+#include <string>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -19,14 +21,21 @@ namespace matchingImageCollection {
  * a threshold over the distance ratio of the 2 nearest neighbours.
  *
  * @note: Cascade hashing tables are computed once and used for all the regions.
+ *        They can be stored in a persistent cache folder to be reused by other runs
+ *        (e.g. the other featureMatching chunks using the same random seed).
  * @warning: all descriptors are loaded in memory. You need to ensure that it can fit in RAM.
  */
 class ImageCollectionMatcher_cascadeHashing : public IImageCollectionMatcher
 {
   public:
+  /**
+   * @param[in] dist_ratio The distance ratio used to discard spurious correspondence
+   * @param[in] hashedDescriptionsCacheFolder Folder of the hashed descriptions cache (empty to disable it)
+   */
   ImageCollectionMatcher_cascadeHashing
   (
-    float dist_ratio
+    float dist_ratio,
+    const std::string& hashedDescriptionsCacheFolder = ""
   );
 
   /// Find corresponding points between some pair of view Ids
@@ -41,6 +50,8 @@ class ImageCollectionMatcher_cascadeHashing : public IImageCollectionMatcher
   private:
   // Distance ratio used to discard spurious correspondence
   float f_dist_ratio_;
+  // Folder of the persistent hashed descriptions cache (empty if disabled)
+  std::string _hashedDescriptionsCacheFolder;
 };
 
 } // namespace aliceVision
@@ -13,6 +13,11 @@
 #include <aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp>
 #include <aliceVision/system/ProgressDisplay.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace aliceVision {
 namespace matchingImageCollection {
@@ -39,8 +44,6 @@ void ImageCollectionMatcher_generic::Match(
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENMP)
   ALICEVISION_LOG_DEBUG("Using the OPENMP thread interface");
 #endif
-  const bool b_multithreaded_pair_search = (_matcherType == CASCADE_HASHING_L2);
-  // -> set to true for CASCADE_HASHING_L2, since OpenMP instructions are not used in this matcher
 
   auto progressDisplay = system::createConsoleProgressDisplay(pairs.size(), std::cout);
 
@@ -52,27 +55,82 @@ void ImageCollectionMatcher_generic::Match(
     map_Pairs[iter->first].push_back(iter->second);
   }
 
-  // Perform matching between all the pairs
-  for (Map_vectorT::const_iterator iter = map_Pairs.begin();
-    iter != map_Pairs.end(); ++iter)
+  // The matching database of an image I is built on demand by the first task that needs it,
+  // shared with the other threads and released once all the pairs with I are matched.
+  // As the tasks are distributed in the order of I, only a few databases are alive at the same time.
+  struct DatabaseMatcher
+  {
+    size_t I;
+    std::mt19937::result_type seed;
+    std::once_flag buildFlag;
+    std::unique_ptr<matching::RegionsDatabaseMatcher> matcher;
+    std::atomic<size_t> remainingTasks{0};
+  };
+
+  // Chunk of pairs (I, J) sharing the same database image I
+  struct MatchingTask
+  {
+    DatabaseMatcher* database;
+    const size_t* firstJ;
+    const size_t* lastJ;
+  };
+
+  // Number of pairs per task: small enough to balance the load if there are a few images I
+  const size_t pairsPerTask = 4;
+
+  std::vector<std::unique_ptr<DatabaseMatcher>> databases;
+  std::vector<MatchingTask> tasks;
+  databases.reserve(map_Pairs.size());
+
+  for (Map_vectorT::const_iterator iter = map_Pairs.begin(); iter != map_Pairs.end(); ++iter)
   {
     const size_t I = iter->first;
     const std::vector<size_t> & indexToCompare = iter->second;
 
-    const feature::Regions & regionsI = regionsPerView.getRegions(I, descType);
-    if (regionsI.RegionCount() == 0)
+    if (regionsPerView.getRegions(I, descType).RegionCount() == 0)
     {
       progressDisplay += indexToCompare.size();
       continue;
     }
 
+    databases.emplace_back(new DatabaseMatcher());
+    DatabaseMatcher& database = *databases.back();
+    database.I = I;
+    // draw the seeds sequentially for reproducible results whatever the number of threads
+    database.seed = randomNumberGenerator();
+
+    for (size_t j = 0; j < indexToCompare.size(); j += pairsPerTask)
+    {
+      const size_t* first = indexToCompare.data() + j;
+      tasks.push_back({&database, first, first + std::min(pairsPerTask, indexToCompare.size() - j)});
+      ++database.remainingTasks;
+    }
+  }
+
+  // Per thread results, merged at the end
+  std::vector<matching::PairwiseMatches> threadsPutativesMatches(omp_get_max_threads());
+
+  // Perform matching between all the pairs (dynamic scheduling of the tasks between the threads)
+  #pragma omp parallel for schedule(dynamic) if(tasks.size() > 1)
+  for (int t = 0; t < (int)tasks.size(); ++t)
+  {
+    const MatchingTask& task = tasks[t];
+    DatabaseMatcher& database = *task.database;
+    const size_t I = database.I;
+    const feature::Regions & regionsI = regionsPerView.getRegions(I, descType);
+
     // Initialize the matching interface
-    matching::RegionsDatabaseMatcher matcher(randomNumberGenerator, _matcherType, regionsI);
+    std::call_once(database.buildFlag, [&]() {
+      std::mt19937 databaseRandomNumberGenerator(database.seed);
+      database.matcher.reset(new matching::RegionsDatabaseMatcher(databaseRandomNumberGenerator, _matcherType, regionsI));
+    });
+    const matching::RegionsDatabaseMatcher& matcher = *database.matcher;
+
+    matching::PairwiseMatches& putativesMatches = threadsPutativesMatches[omp_get_thread_num()];
 
-    #pragma omp parallel for schedule(dynamic) if(b_multithreaded_pair_search)
-    for (int j = 0; j < (int)indexToCompare.size(); ++j)
+    for (const size_t* itJ = task.firstJ; itJ != task.lastJ; ++itJ)
     {
-      const size_t J = indexToCompare[j];
+      const size_t J = *itJ;
 
       const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
       if (regionsJ.RegionCount() == 0
@@ -88,7 +146,9 @@ void ImageCollectionMatcher_generic::Match(
       if (_useCrossMatching)
       {
         // Initialize the matching interface
-        matching::RegionsDatabaseMatcher matcherCross(randomNumberGenerator, _matcherType, regionsJ);  
+        std::seed_seq crossSeed{database.seed, static_cast<std::mt19937::result_type>(J)};
+        std::mt19937 crossRandomNumberGenerator(crossSeed);
+        matching::RegionsDatabaseMatcher matcherCross(crossRandomNumberGenerator, _matcherType, regionsJ);
 
         IndMatches vec_putatives_matches_cross;
         matcherCross.Match(_f_dist_ratio, regionsI, vec_putatives_matches_cross);
@@ -115,15 +175,26 @@ void ImageCollectionMatcher_generic::Match(
         std::swap(vec_putatives_matches, vec_putatives_matches_checked);
       }
 
-      #pragma omp critical
+      ++progressDisplay;
+      if (!vec_putatives_matches.empty())
       {
-        ++progressDisplay;
-        if (!vec_putatives_matches.empty())
-        {
-          map_PutativesMatches[std::make_pair(I,J)].emplace(descType, std::move(vec_putatives_matches));
-        }
+        putativesMatches[std::make_pair(I,J)].emplace(descType, std::move(vec_putatives_matches));
       }
     }
+
+    // Release the database once all the pairs with I are matched
+    if (--database.remainingTasks == 0)
+      database.matcher.reset();
+  }
+
+  // Merge the per thread results
+  for (matching::PairwiseMatches& putativesMatches : threadsPutativesMatches)
+  {
+    for (auto& pairMatches : putativesMatches)
+    {
+      for (auto& descMatches : pairMatches.second)
+        map_PutativesMatches[pairMatches.first].emplace(descMatches.first, std::move(descMatches.second));
+    }
   }
 }
 
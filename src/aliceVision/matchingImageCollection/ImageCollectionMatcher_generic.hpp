@@ -18,6 +18,10 @@ namespace matchingImageCollection {
  * Spurious correspondences are discarded by using the
  * a threshold over the distance ratio of the 2 nearest neighbours.
  *
+ * All the pairs are matched in parallel, whatever the matcher type:
+ * the pairs are split in small tasks sharing the matching database of their first image.
+ * A database is built once, when first needed, and released when all its pairs are matched.
+ *
  * @warning: all descriptors are loaded in memory. You need to ensure that it can fit in RAM.
  */
 class ImageCollectionMatcher_generic : public IImageCollectionMatcher
@@ -10,15 +10,22 @@
 #include "aliceVision/matching/matcherType.hpp"
 #include "aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp"
 
+#include <memory>
+#include <string>
+
 namespace aliceVision {
 namespace matchingImageCollection {
   
 /**
  * 
  * @param matcherType
+ * @param distRatio
+ * @param crossMatching
+ * @param hashedDescriptionsCacheFolder folder of the cascade hashing cache (FAST_CASCADE_HASHING_L2 only, empty to disable it)
  * @return 
  */
-std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio, bool crossMatching);
+std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio, bool crossMatching,
+                                                                      const std::string& hashedDescriptionsCacheFolder = "");
 
 
 } // namespace matching
@@ -0,0 +1,351 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "BatchTriangulation.hpp"
+#include <aliceVision/multiview/triangulation/triangulationDLT.hpp>
+#include <aliceVision/camera/IntrinsicBase.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <limits>
+
+namespace aliceVision {
+namespace sfm {
+
+BatchTriangulation::BatchTriangulation(const sfmData::SfMData& sfmData, const Params& params)
+  : _sfmData(sfmData)
+  , _params(params)
+{}
+
+void BatchTriangulation::reserve(std::size_t nbTracks, std::size_t nbObservations)
+{
+  _trackIds.reserve(nbTracks);
+  _descTypes.reserve(nbTracks);
+  _trackOffsets.reserve(nbTracks + 1);
+
+  _observationViews.reserve(nbObservations);
+  _observationPixels.reserve(nbObservations);
+  _observationFeatureIds.reserve(nbObservations);
+  _observationScales.reserve(nbObservations);
+}
+
+void BatchTriangulation::addTrack(IndexT trackId, feature::EImageDescriberType descType)
+{
+  _trackIds.push_back(trackId);
+  _descTypes.push_back(descType);
+  _trackOffsets.push_back(_trackOffsets.back());
+}
+
+bool BatchTriangulation::addObservation(IndexT viewId, const Vec2& x, IndexT featureId, double scale)
+{
+  if(_trackIds.empty())
+    throw std::runtime_error("BatchTriangulation: cannot add an observation without track.");
+
+  const IndexT viewIndex = getViewIndex(viewId);
+
+  if(viewIndex == UndefinedIndexT)
+    return false;
+
+  _observationViews.push_back(viewIndex);
+  _observationPixels.push_back(x);
+  _observationFeatureIds.push_back(featureId);
+  _observationScales.push_back(scale);
+  ++_trackOffsets.back();
+  return true;
+}
+
+void BatchTriangulation::setViewMaxResidualError(IndexT viewId, double maxResidualError)
+{
+  const IndexT viewIndex = getViewIndex(viewId);
+
+  if(viewIndex != UndefinedIndexT)
+    _viewsMaxResidualError.at(viewIndex) = maxResidualError;
+}
+
+IndexT BatchTriangulation::getViewIndex(IndexT viewId)
+{
+  const auto it = _viewIndexes.find(viewId);
+
+  if(it != _viewIndexes.end())
+    return it->second;
+
+  const sfmData::View& view = _sfmData.getView(viewId);
+  const camera::Pinhole* intrinsic = dynamic_cast<const camera::Pinhole*>(_sfmData.getIntrinsicPtr(view.getIntrinsicId()));
+
+  IndexT viewIndex = UndefinedIndexT;
+
+  if(intrinsic != nullptr && _sfmData.isPoseAndIntrinsicDefined(&view))
+  {
+    const geometry::Pose3 pose = _sfmData.getPose(view).getTransform();
+
+    viewIndex = static_cast<IndexT>(_viewIds.size());
+    _viewIds.push_back(viewId);
+    _projections.push_back(intrinsic->getProjectiveEquivalent(pose));
+    _poses.push_back(pose);
+    _intrinsics.push_back(intrinsic);
+    _viewsMaxResidualError.push_back(_params.maxResidualError);
+  }
+
+  _viewIndexes.emplace(viewId, viewIndex);
+  return viewIndex;
+}
+
+void BatchTriangulation::triangulate(std::mt19937& randomNumberGenerator)
+{
+  const std::size_t nbTracks = _trackIds.size();
+  const std::size_t nbObservations = _observationViews.size();
+
+  _points.assign(nbTracks, Vec3::Zero());
+  _valid.assign(nbTracks, 0);
+  _observationUndistortedPixels.resize(nbObservations);
+  _observationBearings.resize(nbObservations);
+  _observationInliers.assign(nbObservations, 0);
+
+  // undistorted pixels and bearing vectors, once per observation
+
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(nbObservations); ++i)
+  {
+    const IndexT viewIndex = _observationViews[i];
+    const camera::Pinhole* intrinsic = _intrinsics[viewIndex];
+    const Vec2& x = _observationPixels[i];
+
+    _observationUndistortedPixels[i] = intrinsic->get_ud_pixel(x);
+    _observationBearings[i] = camera::applyIntrinsicExtrinsic(_poses[viewIndex], intrinsic, x);
+  }
+
+  // each track has its own random number generator, seeded from a single draw of the given one,
+  // so the result does not depend on the threads scheduling
+
+  const std::uint32_t seed = randomNumberGenerator();
+
+  #pragma omp parallel for schedule(dynamic, 64)
+  for(int i = 0; i < static_cast<int>(nbTracks); ++i)
+  {
+    std::minstd_rand trackRandomNumberGenerator(seed + static_cast<std::uint32_t>(i));
+    _valid[i] = triangulateTrack(i, trackRandomNumberGenerator);
+  }
+}
+
+bool BatchTriangulation::triangulateTrack(std::size_t trackIndex, std::minstd_rand& randomNumberGenerator)
+{
+  const std::size_t begin = _trackOffsets[trackIndex];
+  const std::size_t end = _trackOffsets[trackIndex + 1];
+  const std::size_t nbObservations = end - begin;
+
+  if(nbObservations < std::max<std::size_t>(2, _params.minNbObservations))
+    return false;
+
+  char* inliers = _observationInliers.data() + begin;
+  std::size_t nbInliers = 0;
+  Vec3& X = _points[trackIndex];
+
+  if(nbObservations == 2)
+  {
+    multiview::TriangulateDLT(_projections[_observationViews[begin]], _observationUndistortedPixels[begin],
+                              _projections[_observationViews[begin + 1]], _observationUndistortedPixels[begin + 1], X);
+
+    // both observations must be consistent with the per-view thresholds
+    for(std::size_t i = begin; i < end; ++i)
+    {
+      const IndexT viewIndex = _observationViews[i];
+      const geometry::Pose3& pose = _poses[viewIndex];
+
+      if(pose.depth(X) <= 0.0 ||
+         _intrinsics[viewIndex]->residual(pose, X.homogeneous(), _observationPixels[i]).norm() > _viewsMaxResidualError[viewIndex])
+        return false;
+
+      inliers[i - begin] = 1;
+    }
+    nbInliers = 2;
+  }
+  else if(!_params.robust)
+  {
+    std::fill(inliers, inliers + nbObservations, 1);
+
+    if(!triangulateInliers(begin, end, X))
+      return false;
+
+    classify(begin, end, X, inliers, nbInliers);
+  }
+  else
+  {
+    // MSAC on the 2-view hypotheses: all the pairs if there are not too many, random pairs otherwise
+
+    const std::size_t nbPairs = nbObservations * (nbObservations - 1) / 2;
+    const bool exhaustive = (nbPairs <= _params.maxIterations);
+    const std::size_t nbIterations = exhaustive ? nbPairs : _params.maxIterations;
+
+    std::uniform_int_distribution<std::size_t> distribution(0, nbObservations - 1);
+    double bestScore = std::numeric_limits<double>::max();
+    std::size_t a = 0;
+    std::size_t b = 0;
+
+    for(std::size_t iteration = 0; iteration < nbIterations; ++iteration)
+    {
+      if(exhaustive)
+      {
+        if(++b >= nbObservations)
+        {
+          ++a;
+          b = a + 1;
+        }
+      }
+      else
+      {
+        a = distribution(randomNumberGenerator);
+        do
+        {
+          b = distribution(randomNumberGenerator);
+        } while(b == a);
+      }
+
+      Vec3 hypothesis;
+      multiview::TriangulateDLT(_projections[_observationViews[begin + a]], _observationUndistortedPixels[begin + a],
+                                _projections[_observationViews[begin + b]], _observationUndistortedPixels[begin + b], hypothesis);
+
+      std::size_t nbHypothesisInliers = 0;
+      const double score = classify(begin, end, hypothesis, nullptr, nbHypothesisInliers);
+
+      if(nbHypothesisInliers >= 2 && score < bestScore)
+      {
+        bestScore = score;
+        X = hypothesis;
+      }
+    }
+
+    if(bestScore == std::numeric_limits<double>::max())
+      return false;
+
+    // refine the best hypothesis on its inliers
+    classify(begin, end, X, inliers, nbInliers);
+
+    Vec3 refined;
+    if(triangulateInliers(begin, end, refined))
+    {
+      std::size_t nbRefinedInliers = 0;
+      classify(begin, end, refined, nullptr, nbRefinedInliers);
+
+      if(nbRefinedInliers >= nbInliers)
+      {
+        X = refined;
+        classify(begin, end, X, inliers, nbInliers);
+      }
+    }
+  }
+
+  if(nbInliers < std::max<std::size_t>(2, _params.minNbObservations))
+    return false;
+
+  // the inlier rays must have a sufficient triangulation angle
+
+  if(_params.minAngle > 0.0)
+  {
+    bool validAngle = false;
+
+    for(std::size_t i = begin; i < end && !validAngle; ++i)
+    {
+      if(!inliers[i - begin])
+        continue;
+
+      for(std::size_t j = i + 1; j < end; ++j)
+      {
+        if(inliers[j - begin] && camera::angleBetweenRays(_observationBearings[i], _observationBearings[j]) >= _params.minAngle)
+        {
+          validAngle = true;
+          break;
+        }
+      }
+    }
+
+    if(!validAngle)
+      return false;
+  }
+
+  return true;
+}
+
+bool BatchTriangulation::triangulateInliers(std::size_t begin, std::size_t end, Vec3& X) const
+{
+  // accumulate the normal matrix of the DLT system, with normalized rows
+  Mat4 AtA = Mat4::Zero();
+
+  for(std::size_t i = begin; i < end; ++i)
+  {
+    if(!_observationInliers[i])
+      continue;
+
+    const Mat34& P = _projections[_observationViews[i]];
+    const Vec2& x = _observationUndistortedPixels[i];
+
+    for(int r = 0; r < 2; ++r)
+    {
+      const Vec4 row = (x(r) * P.row(2) - P.row(r)).transpose();
+      const double norm = row.norm();
+
+      if(norm > 0.0)
+        AtA.noalias() += (row * row.transpose()) / (norm * norm);
+    }
+  }
+
+  // the solution is the eigen vector of the smallest eigen value
+  const Eigen::SelfAdjointEigenSolver<Mat4> solver(AtA);
+  const Vec4 Xh = solver.eigenvectors().col(0);
+
+  if(std::abs(Xh(3)) < std::numeric_limits<double>::epsilon())
+    return false;
+
+  X = Xh.hnormalized();
+  return true;
+}
+
+double BatchTriangulation::classify(std::size_t begin, std::size_t end, const Vec3& X, char* inliers, std::size_t& nbInliers) const
+{
+  const double maxSquaredError = _params.maxResidualError * _params.maxResidualError;
+  const Vec4 Xh = X.homogeneous();
+  double score = 0.0;
+
+  nbInliers = 0;
+
+  for(std::size_t i = begin; i < end; ++i)
+  {
+    const Vec3 x = _projections[_observationViews[i]] * Xh;
+
+    // the point must be in front of the camera
+    const double squaredError = (x(2) > 0.0) ? (x.head<2>() / x(2) - _observationUndistortedPixels[i]).squaredNorm()
+                                             : std::numeric_limits<double>::max();
+    const bool inlier = (squaredError < maxSquaredError);
+
+    if(inliers != nullptr)
+      inliers[i - begin] = inlier;
+
+    nbInliers += inlier;
+    score += std::min(squaredError, maxSquaredError);
+  }
+
+  return score;
+}
+
+void BatchTriangulation::getLandmark(std::size_t trackIndex, sfmData::Landmark& out_landmark) const
+{
+  const std::size_t begin = _trackOffsets.at(trackIndex);
+  const std::size_t end = _trackOffsets.at(trackIndex + 1);
+
+  out_landmark.X = _points.at(trackIndex);
+  out_landmark.descType = _descTypes.at(trackIndex);
+  out_landmark.observations.clear();
+
+  for(std::size_t i = begin; i < end; ++i)
+  {
+    if(_observationInliers[i])
+      out_landmark.observations[_viewIds[_observationViews[i]]] = sfmData::Observation(_observationPixels[i], _observationFeatureIds[i], _observationScales[i]);
+  }
+}
+
+} // namespace sfm
+} // namespace aliceVision
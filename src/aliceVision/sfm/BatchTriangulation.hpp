@@ -0,0 +1,204 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/camera/Pinhole.hpp>
+
+#include <random>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Batched multi-view triangulation of tracks with known camera poses.
+ *
+ * All the tracks are gathered first, in structure of arrays buffers:
+ *  - per view: projection matrix, rotation, center and intrinsic, computed once per view,
+ *  - per observation: view index, pixel, undistorted pixel and bearing vector.
+ * Then all the tracks are solved in parallel with fixed-size Eigen blocks:
+ *  - 2 observations: linear triangulation (DLT),
+ *  - N observations: RANSAC on pairs of observations and DLT refinement on the inliers (robust mode)
+ *    or DLT on all the observations,
+ * and validated with cheirality, triangulation angle and residual checks.
+ * Only pinhole cameras are supported, observations of other cameras are ignored.
+ */
+class BatchTriangulation
+{
+public:
+
+  struct Params
+  {
+    /// minimum number of (inlier) observations of a valid track
+    std::size_t minNbObservations = 2;
+    /// minimum angle (in degree) between the rays of two observations of a valid track
+    double minAngle = 0.0;
+    /// maximum residual error (in pixels) of the inlier observations
+    double maxResidualError = 4.0;
+    /// robust estimation of the tracks with more than 2 observations
+    bool robust = true;
+    /// maximum number of RANSAC iterations per track
+    std::size_t maxIterations = 64;
+  };
+
+  /**
+   * @brief BatchTriangulation constructor
+   * @param[in] sfmData The scene with the poses and intrinsics of the observations
+   * @param[in] params The triangulation parameters
+   */
+  BatchTriangulation(const sfmData::SfMData& sfmData, const Params& params);
+
+  /**
+   * @brief Reserve the buffers
+   * @param[in] nbTracks The expected number of tracks
+   * @param[in] nbObservations The expected total number of observations
+   */
+  void reserve(std::size_t nbTracks, std::size_t nbObservations);
+
+  /**
+   * @brief Add a track, the next observations are added to this track
+   * @param[in] trackId The track id
+   * @param[in] descType The describer type of the track
+   */
+  void addTrack(IndexT trackId, feature::EImageDescriberType descType);
+
+  /**
+   * @brief Add an observation to the last track
+   * @param[in] viewId The view id, its pose and intrinsic must be defined
+   * @param[in] x The (distorted) pixel
+   * @param[in] featureId The feature id
+   * @param[in] scale The feature scale
+   * @return false if the observation is ignored (not a pinhole camera)
+   */
+  bool addObservation(IndexT viewId, const Vec2& x, IndexT featureId, double scale = 0.0);
+
+  /**
+   * @brief Set the maximum residual error of the observations of a view
+   * for the validation of the tracks with 2 observations
+   * @param[in] viewId The view id
+   * @param[in] maxResidualError The maximum residual error (in pixels)
+   */
+  void setViewMaxResidualError(IndexT viewId, double maxResidualError);
+
+  /**
+   * @brief Triangulate all the tracks
+   * @param[in] randomNumberGenerator The random number generator of the robust estimation
+   */
+  void triangulate(std::mt19937& randomNumberGenerator);
+
+  /**
+   * @brief Get the number of tracks
+   */
+  std::size_t size() const
+  {
+    return _trackIds.size();
+  }
+
+  /**
+   * @brief Get the id of a track
+   */
+  IndexT getTrackId(std::size_t trackIndex) const
+  {
+    return _trackIds.at(trackIndex);
+  }
+
+  /**
+   * @brief Return true if the track has been triangulated and validated
+   */
+  bool isValid(std::size_t trackIndex) const
+  {
+    return _valid.at(trackIndex);
+  }
+
+  /**
+   * @brief Get the triangulated point of a track
+   */
+  const Vec3& getPoint(std::size_t trackIndex) const
+  {
+    return _points.at(trackIndex);
+  }
+
+  /**
+   * @brief Get the landmark of a valid track, with its inlier observations
+   * @param[in] trackIndex The track index
+   * @param[out] out_landmark The landmark
+   */
+  void getLandmark(std::size_t trackIndex, sfmData::Landmark& out_landmark) const;
+
+private:
+
+  /**
+   * @brief Get the index of a view in the view buffers, add the view if needed
+   * @return the view index or UndefinedIndexT if the view is not supported
+   */
+  IndexT getViewIndex(IndexT viewId);
+
+  /**
+   * @brief Triangulate and validate a track
+   * @param[in] trackIndex The track index
+   * @param[in] randomNumberGenerator The random number generator of the track
+   * @return true if the track is valid
+   */
+  bool triangulateTrack(std::size_t trackIndex, std::minstd_rand& randomNumberGenerator);
+
+  /**
+   * @brief DLT triangulation of the inlier observations of a track, with a fixed-size normal matrix
+   * @param[in] begin The first observation of the track
+   * @param[in] end The end of the observations of the track
+   * @param[out] X The triangulated point
+   * @return false if the point is at infinity
+   */
+  bool triangulateInliers(std::size_t begin, std::size_t end, Vec3& X) const;
+
+  /**
+   * @brief Classify the observations of a track as inliers or outliers of a point
+   * @param[in] begin The first observation of the track
+   * @param[in] end The end of the observations of the track
+   * @param[in] X The point
+   * @param[out] inliers The inlier flag of each observation (optional)
+   * @param[out] nbInliers The number of inliers
+   * @return the truncated sum of the residual errors
+   */
+  double classify(std::size_t begin, std::size_t end, const Vec3& X, char* inliers, std::size_t& nbInliers) const;
+
+  const sfmData::SfMData& _sfmData;
+  Params _params;
+
+  // views
+
+  HashMap<IndexT, IndexT> _viewIndexes;
+  std::vector<IndexT> _viewIds;
+  std::vector<Mat34> _projections;
+  std::vector<geometry::Pose3> _poses;
+  std::vector<const camera::Pinhole*> _intrinsics;
+  std::vector<double> _viewsMaxResidualError;
+
+  // tracks
+
+  std::vector<IndexT> _trackIds;
+  std::vector<feature::EImageDescriberType> _descTypes;
+  /// first observation of each track, the last element is the total number of observations
+  std::vector<std::size_t> _trackOffsets = {0};
+  std::vector<Vec3> _points;
+  std::vector<char> _valid;
+
+  // observations
+
+  std::vector<IndexT> _observationViews;
+  std::vector<Vec2> _observationPixels;
+  std::vector<IndexT> _observationFeatureIds;
+  std::vector<double> _observationScales;
+  std::vector<Vec2> _observationUndistortedPixels;
+  std::vector<Vec3> _observationBearings;
+  std::vector<char> _observationInliers;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,594 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/sfmData/Landmark.hpp>
+
+#include <ceres/ceres.h>
+
+#include <cmath>
+#include <limits>
+
+/**
+ * Reprojection cost functions with hand-derived jacobians.
+ *
+ * They compute exactly the same residuals as the ResidualErrorFunctor_* ceres functors
+ * (same parameter blocks, same layout), without the overhead of the automatic differentiation.
+ * The distortion models only provide the distortion and its derivatives,
+ * the pose and projection parts are shared by all the camera models.
+ */
+
+namespace aliceVision {
+namespace sfm {
+namespace analytic {
+
+inline Mat3 skew(const Vec3& v)
+{
+  Mat3 m;
+  m << 0.0, -v(2), v(1),
+       v(2), 0.0, -v(0),
+       -v(1), v(0), 0.0;
+  return m;
+}
+
+/**
+ * @brief Rotate a point with an angle axis rotation (same computation as ceres::AngleAxisRotatePoint).
+ * @param[in] angleAxis the angle axis rotation
+ * @param[in] pt the point to rotate
+ * @param[out] out_pt the rotated point
+ * @param[out] out_dPt_dAngleAxis the derivative of the rotated point wrt. the angle axis (may be nullptr)
+ * @param[out] out_dPt_dPt the derivative of the rotated point wrt. the point (may be nullptr)
+ */
+inline void angleAxisRotatePoint(const double* angleAxis,
+                                 const Vec3& pt,
+                                 Vec3& out_pt,
+                                 Mat3* out_dPt_dAngleAxis,
+                                 Mat3* out_dPt_dPt)
+{
+  const Eigen::Map<const Vec3> w(angleAxis);
+  const double theta2 = w.squaredNorm();
+
+  if(theta2 > std::numeric_limits<double>::epsilon())
+  {
+    const double theta = std::sqrt(theta2);
+    const double cosTheta = std::cos(theta);
+    const double sinTheta = std::sin(theta);
+    const Mat3 W = skew(w);
+
+    // Rodrigues formula
+    const Mat3 R = Mat3::Identity() + (sinTheta / theta) * W + ((1.0 - cosTheta) / theta2) * W * W;
+    out_pt = R * pt;
+
+    if(out_dPt_dAngleAxis)
+    {
+      // d(R.pt)/dw = -R [pt]x Jr(w), with Jr the right jacobian of SO(3)
+      const Mat3 Jr = Mat3::Identity() - ((1.0 - cosTheta) / theta2) * W + ((theta - sinTheta) / (theta2 * theta)) * W * W;
+      *out_dPt_dAngleAxis = -R * skew(pt) * Jr;
+    }
+    if(out_dPt_dPt)
+      *out_dPt_dPt = R;
+  }
+  else
+  {
+    // near zero, ceres uses the first order approximation R = I + [w]x
+    out_pt = pt + w.cross(pt);
+
+    if(out_dPt_dAngleAxis)
+      *out_dPt_dAngleAxis = -skew(pt);
+    if(out_dPt_dPt)
+      *out_dPt_dPt = Mat3::Identity() + skew(w);
+  }
+}
+
+/**
+ * @brief Derivative of the perspective division (x/z, y/z) wrt. the camera point.
+ */
+inline Eigen::Matrix<double, 2, 3> perspectiveDivisionJacobian(const Vec3& pt)
+{
+  const double invZ = 1.0 / pt(2);
+  const double invZ2 = invZ * invZ;
+
+  Eigen::Matrix<double, 2, 3> J;
+  J << invZ, 0.0, -pt(0) * invZ2,
+       0.0, invZ, -pt(1) * invZ2;
+  return J;
+}
+
+/**
+ * @brief No distortion.
+ */
+struct DistortionNone
+{
+  static constexpr int nbParams = 0;
+  using ParamsJacobian = Eigen::Matrix<double, 2, nbParams>;
+
+  static Vec2 distort(const double* /*params*/, const Vec2& pt, Eigen::Matrix2d& out_dPt, ParamsJacobian& /*out_dParams*/)
+  {
+    out_dPt.setIdentity();
+    return pt;
+  }
+};
+
+/**
+ * @brief Radial distortion with one coefficient [k1].
+ */
+struct DistortionRadialK1
+{
+  static constexpr int nbParams = 1;
+  using ParamsJacobian = Eigen::Matrix<double, 2, nbParams>;
+
+  static Vec2 distort(const double* params, const Vec2& pt, Eigen::Matrix2d& out_dPt, ParamsJacobian& out_dParams)
+  {
+    const double k1 = params[0];
+    const double r2 = pt.squaredNorm();
+    const double rCoeff = 1.0 + k1 * r2;
+
+    out_dPt = rCoeff * Eigen::Matrix2d::Identity() + (2.0 * k1) * pt * pt.transpose();
+    out_dParams.col(0) = pt * r2;
+    return pt * rCoeff;
+  }
+};
+
+/**
+ * @brief Radial distortion with three coefficients [k1, k2, k3].
+ */
+struct DistortionRadialK3
+{
+  static constexpr int nbParams = 3;
+  using ParamsJacobian = Eigen::Matrix<double, 2, nbParams>;
+
+  static Vec2 distort(const double* params, const Vec2& pt, Eigen::Matrix2d& out_dPt, ParamsJacobian& out_dParams)
+  {
+    const double k1 = params[0];
+    const double k2 = params[1];
+    const double k3 = params[2];
+    const double r2 = pt.squaredNorm();
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double rCoeff = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+    const double dRCoeff_dR2 = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+
+    out_dPt = rCoeff * Eigen::Matrix2d::Identity() + (2.0 * dRCoeff_dR2) * pt * pt.transpose();
+    out_dParams.col(0) = pt * r2;
+    out_dParams.col(1) = pt * r4;
+    out_dParams.col(2) = pt * r6;
+    return pt * rCoeff;
+  }
+};
+
+/**
+ * @brief Brown distortion: radial [k1, k2, k3] and tangential [t1, t2].
+ */
+struct DistortionBrownT2
+{
+  static constexpr int nbParams = 5;
+  using ParamsJacobian = Eigen::Matrix<double, 2, nbParams>;
+
+  static Vec2 distort(const double* params, const Vec2& pt, Eigen::Matrix2d& out_dPt, ParamsJacobian& out_dParams)
+  {
+    const double k1 = params[0];
+    const double k2 = params[1];
+    const double k3 = params[2];
+    const double t1 = params[3];
+    const double t2 = params[4];
+    const double x = pt(0);
+    const double y = pt(1);
+    const double r2 = x * x + y * y;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double rCoeff = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+    const double dRCoeff_dR2 = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+
+    const double tX = t2 * (r2 + 2.0 * x * x) + 2.0 * t1 * x * y;
+    const double tY = t1 * (r2 + 2.0 * y * y) + 2.0 * t2 * x * y;
+
+    out_dPt = rCoeff * Eigen::Matrix2d::Identity() + (2.0 * dRCoeff_dR2) * pt * pt.transpose();
+    out_dPt(0, 0) += 6.0 * t2 * x + 2.0 * t1 * y;
+    out_dPt(0, 1) += 2.0 * t2 * y + 2.0 * t1 * x;
+    out_dPt(1, 0) += 2.0 * t1 * x + 2.0 * t2 * y;
+    out_dPt(1, 1) += 6.0 * t1 * y + 2.0 * t2 * x;
+
+    out_dParams.col(0) = pt * r2;
+    out_dParams.col(1) = pt * r4;
+    out_dParams.col(2) = pt * r6;
+    out_dParams.col(3) << 2.0 * x * y, r2 + 2.0 * y * y;
+    out_dParams.col(4) << r2 + 2.0 * x * x, 2.0 * x * y;
+
+    return Vec2(x * rCoeff + tX, y * rCoeff + tY);
+  }
+};
+
+/**
+ * @brief Fisheye distortion [k1, k2, k3, k4].
+ */
+struct DistortionFisheye
+{
+  static constexpr int nbParams = 4;
+  using ParamsJacobian = Eigen::Matrix<double, 2, nbParams>;
+
+  static Vec2 distort(const double* params, const Vec2& pt, Eigen::Matrix2d& out_dPt, ParamsJacobian& out_dParams)
+  {
+    const double k1 = params[0];
+    const double k2 = params[1];
+    const double k3 = params[2];
+    const double k4 = params[3];
+    const double r = pt.norm();
+
+    if(r <= 1e-8)
+    {
+      out_dPt.setIdentity();
+      out_dParams.setZero();
+      return pt;
+    }
+
+    const double theta = std::atan(r);
+    const double theta2 = theta * theta;
+    const double theta3 = theta2 * theta;
+    const double theta4 = theta2 * theta2;
+    const double theta5 = theta4 * theta;
+    const double theta6 = theta3 * theta3;
+    const double theta7 = theta6 * theta;
+    const double theta8 = theta4 * theta4;
+    const double theta9 = theta8 * theta;
+    const double thetaDist = theta + k1 * theta3 + k2 * theta5 + k3 * theta7 + k4 * theta9;
+    const double dThetaDist_dTheta = 1.0 + 3.0 * k1 * theta2 + 5.0 * k2 * theta4 + 7.0 * k3 * theta6 + 9.0 * k4 * theta8;
+    const double invR = 1.0 / r;
+    const double cdist = thetaDist * invR;
+
+    // d(cdist)/dr, with dtheta/dr = 1 / (1 + r^2)
+    const double dCdist_dR = (dThetaDist_dTheta / (1.0 + r * r) - cdist) * invR;
+
+    out_dPt = cdist * Eigen::Matrix2d::Identity() + (dCdist_dR * invR) * pt * pt.transpose();
+    out_dParams.col(0) = pt * (theta3 * invR);
+    out_dParams.col(1) = pt * (theta5 * invR);
+    out_dParams.col(2) = pt * (theta7 * invR);
+    out_dParams.col(3) = pt * (theta9 * invR);
+    return pt * cdist;
+  }
+};
+
+/**
+ * @brief Fisheye distortion with one coefficient [k1] (field of view model).
+ */
+struct DistortionFisheye1
+{
+  static constexpr int nbParams = 1;
+  using ParamsJacobian = Eigen::Matrix<double, 2, nbParams>;
+
+  static Vec2 distort(const double* params, const Vec2& pt, Eigen::Matrix2d& out_dPt, ParamsJacobian& out_dParams)
+  {
+    const double k1 = params[0];
+    const double r = pt.norm();
+    const double tanHalfK1 = std::tan(0.5 * k1);
+    const double a = 2.0 * tanHalfK1;
+    const double ar = a * r;
+    const double atanAr = std::atan(ar);
+    const double invOnePlusAr2 = 1.0 / (1.0 + ar * ar);
+    const double rCoeff = atanAr / (k1 * r);
+
+    const double dRCoeff_dR = (ar * invOnePlusAr2 - atanAr) / (k1 * r * r);
+    const double dA_dK1 = 1.0 + tanHalfK1 * tanHalfK1;
+    const double dRCoeff_dK1 = dA_dK1 * invOnePlusAr2 / k1 - rCoeff / k1;
+
+    out_dPt = rCoeff * Eigen::Matrix2d::Identity() + (dRCoeff_dR / r) * pt * pt.transpose();
+    out_dParams.col(0) = pt * dRCoeff_dK1;
+    return pt * rCoeff;
+  }
+};
+
+/**
+ * @brief 3DEqualizer classic LD distortion [delta, inverse epsilon, mux, muy, q].
+ */
+struct Distortion3DEClassicLD
+{
+  static constexpr int nbParams = 5;
+  using ParamsJacobian = Eigen::Matrix<double, 2, nbParams>;
+
+  static Vec2 distort(const double* params, const Vec2& pt, Eigen::Matrix2d& out_dPt, ParamsJacobian& out_dParams)
+  {
+    const double delta = params[0];
+    const double invEpsilon = params[1];
+    const double mux = params[2];
+    const double muy = params[3];
+    const double q = params[4];
+    const double eps = 1.0 + std::cos(invEpsilon);
+
+    const double x = pt(0);
+    const double y = pt(1);
+    const double xx = x * x;
+    const double yy = y * y;
+    const double r2 = xx + yy;
+    const double r4 = r2 * r2;
+
+    // x_d = x * (1 + eps * ax), y_d = y * (1 + ay)
+    const double ax = delta * xx + (delta + mux) * yy + q * r4;
+    const double ay = (delta + muy) * xx + delta * yy + q * r4;
+    const double dAx_dx = 2.0 * delta * x + 4.0 * q * r2 * x;
+    const double dAx_dy = 2.0 * (delta + mux) * y + 4.0 * q * r2 * y;
+    const double dAy_dx = 2.0 * (delta + muy) * x + 4.0 * q * r2 * x;
+    const double dAy_dy = 2.0 * delta * y + 4.0 * q * r2 * y;
+
+    out_dPt << 1.0 + eps * (ax + x * dAx_dx), eps * x * dAx_dy,
+               y * dAy_dx, 1.0 + ay + y * dAy_dy;
+
+    out_dParams.col(0) << x * eps * r2, y * r2;
+    out_dParams.col(1) << -x * ax * std::sin(invEpsilon), 0.0;
+    out_dParams.col(2) << x * eps * yy, 0.0;
+    out_dParams.col(3) << 0.0, y * xx;
+    out_dParams.col(4) << x * eps * r4, y * r4;
+
+    return Vec2(x * (1.0 + eps * ax), y * (1.0 + ay));
+  }
+};
+
+/**
+ * @brief 3DEqualizer radial 4 distortion [c2, c4, u1, v1, u3, v3].
+ */
+struct Distortion3DERadial4
+{
+  static constexpr int nbParams = 6;
+  using ParamsJacobian = Eigen::Matrix<double, 2, nbParams>;
+
+  static Vec2 distort(const double* params, const Vec2& pt, Eigen::Matrix2d& out_dPt, ParamsJacobian& out_dParams)
+  {
+    const double c2 = params[0];
+    const double c4 = params[1];
+    const double u1 = params[2];
+    const double v1 = params[3];
+    const double u3 = params[4];
+    const double v3 = params[5];
+
+    const double x = pt(0);
+    const double y = pt(1);
+    const double xx = x * x;
+    const double yy = y * y;
+    const double xy = x * y;
+    const double r2 = xx + yy;
+    const double r4 = r2 * r2;
+
+    const double p1 = 1.0 + c2 * r2 + c4 * r4;
+    const double p2 = r2 + 2.0 * xx;
+    const double p3 = r2 + 2.0 * yy;
+    const double p4 = u1 + u3 * r2;
+    const double p5 = v1 + v3 * r2;
+    const double p6 = 2.0 * xy;
+
+    // d(p1)/dx = g * x, d(p1)/dy = g * y
+    const double g = 2.0 * c2 + 4.0 * c4 * r2;
+
+    out_dPt(0, 0) = p1 + g * xx + 6.0 * x * p4 + 2.0 * u3 * x * p2 + 2.0 * y * p5 + 2.0 * v3 * x * p6;
+    out_dPt(0, 1) = g * xy + 2.0 * y * p4 + 2.0 * u3 * y * p2 + 2.0 * x * p5 + 2.0 * v3 * y * p6;
+    out_dPt(1, 0) = g * xy + 2.0 * x * p5 + 2.0 * v3 * x * p3 + 2.0 * y * p4 + 2.0 * u3 * x * p6;
+    out_dPt(1, 1) = p1 + g * yy + 6.0 * y * p5 + 2.0 * v3 * y * p3 + 2.0 * x * p4 + 2.0 * u3 * y * p6;
+
+    out_dParams.col(0) << x * r2, y * r2;
+    out_dParams.col(1) << x * r4, y * r4;
+    out_dParams.col(2) << p2, p6;
+    out_dParams.col(3) << p6, p3;
+    out_dParams.col(4) << p2 * r2, p6 * r2;
+    out_dParams.col(5) << p6 * r2, p3 * r2;
+
+    return Vec2(x * p1 + p2 * p4 + p6 * p5, y * p1 + p3 * p5 + p6 * p4);
+  }
+};
+
+/**
+ * @brief Apply the intrinsic parameters [focal x, focal y, principal point offset x, principal point offset y, distortion...]
+ *        to an undistorted point and compute the residual and its derivatives.
+ */
+template <typename DistortionT>
+class IntrinsicsResidual
+{
+public:
+  static constexpr int nbParams = 4 + DistortionT::nbParams;
+  using ParamsJacobian = Eigen::Matrix<double, 2, nbParams, Eigen::RowMajor>;
+
+  IntrinsicsResidual(int w, int h, const sfmData::Observation& obs)
+    : _center(double(w) * 0.5, double(h) * 0.5)
+    , _obs(obs)
+    , _invScale(obs.scale > 0.0 ? 1.0 / obs.scale : 1.0)
+  {}
+
+  /**
+   * @param[in] cam_K the intrinsics parameter block
+   * @param[in] pt the undistorted point
+   * @param[out] out_residuals the 2 residuals
+   * @param[out] out_dParams the derivative of the residuals wrt. the intrinsics parameters
+   * @param[out] out_dPt the derivative of the residuals wrt. the undistorted point
+   */
+  void evaluate(const double* cam_K, const Vec2& pt, double* out_residuals, ParamsJacobian& out_dParams, Eigen::Matrix2d& out_dPt) const
+  {
+    const double focalX = cam_K[0];
+    const double focalY = cam_K[1];
+
+    Eigen::Matrix2d dDist_dPt;
+    typename DistortionT::ParamsJacobian dDist_dParams;
+    const Vec2 ptDist = DistortionT::distort(cam_K + 4, pt, dDist_dPt, dDist_dParams);
+
+    out_residuals[0] = (cam_K[2] + _center(0) + focalX * ptDist(0) - _obs.x(0)) * _invScale;
+    out_residuals[1] = (cam_K[3] + _center(1) + focalY * ptDist(1) - _obs.x(1)) * _invScale;
+
+    out_dParams.template leftCols<4>() << ptDist(0) * _invScale, 0.0, _invScale, 0.0,
+                                          0.0, ptDist(1) * _invScale, 0.0, _invScale;
+    out_dParams.template rightCols<DistortionT::nbParams>().row(0) = (focalX * _invScale) * dDist_dParams.row(0);
+    out_dParams.template rightCols<DistortionT::nbParams>().row(1) = (focalY * _invScale) * dDist_dParams.row(1);
+
+    out_dPt.row(0) = (focalX * _invScale) * dDist_dPt.row(0);
+    out_dPt.row(1) = (focalY * _invScale) * dDist_dPt.row(1);
+  }
+
+private:
+  const Vec2 _center;
+  const sfmData::Observation _obs;
+  const double _invScale;
+};
+
+} // namespace analytic
+
+/**
+ * @brief Reprojection cost function with analytic jacobians.
+ *
+ *  Data parameter blocks are the same as the ResidualErrorFunctor_* <2, K, 6, 3>
+ *  - 2 => dimension of the residuals,
+ *  - K => the intrinsic data block [focal x, focal y, principal point x, principal point y, distortion...],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ */
+template <typename DistortionT>
+class ResidualErrorAnalyticCostFunction
+  : public ceres::SizedCostFunction<2, analytic::IntrinsicsResidual<DistortionT>::nbParams, 6, 3>
+{
+public:
+  using IntrinsicsResidual = analytic::IntrinsicsResidual<DistortionT>;
+
+  ResidualErrorAnalyticCostFunction(int w, int h, const sfmData::Observation& obs)
+    : _intrinsicsResidual(w, h, obs)
+  {}
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_Rt = parameters[1];
+    const Eigen::Map<const Vec3> pt3D(parameters[2]);
+
+    const bool computeJacobians = (jacobians != nullptr);
+
+    Vec3 ptCam;
+    Mat3 dPtCam_dR;
+    Mat3 dPtCam_dPt3D;
+    analytic::angleAxisRotatePoint(cam_Rt, pt3D, ptCam,
+                                   computeJacobians ? &dPtCam_dR : nullptr,
+                                   computeJacobians ? &dPtCam_dPt3D : nullptr);
+    ptCam += Eigen::Map<const Vec3>(cam_Rt + 3);
+
+    const Vec2 ptUndist(ptCam(0) / ptCam(2), ptCam(1) / ptCam(2));
+
+    typename IntrinsicsResidual::ParamsJacobian dRes_dK;
+    Eigen::Matrix2d dRes_dPtUndist;
+    _intrinsicsResidual.evaluate(cam_K, ptUndist, residuals, dRes_dK, dRes_dPtUndist);
+
+    if(!computeJacobians)
+      return true;
+
+    const Eigen::Matrix<double, 2, 3> dRes_dPtCam = dRes_dPtUndist * analytic::perspectiveDivisionJacobian(ptCam);
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<typename IntrinsicsResidual::ParamsJacobian> J(jacobians[0]);
+      J = dRes_dK;
+    }
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.leftCols<3>() = dRes_dPtCam * dPtCam_dR;
+      J.rightCols<3>() = dRes_dPtCam;
+    }
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[2]);
+      J = dRes_dPtCam * dPtCam_dPt3D;
+    }
+    return true;
+  }
+
+private:
+  const IntrinsicsResidual _intrinsicsResidual;
+};
+
+/**
+ * @brief Rig reprojection cost function with analytic jacobians.
+ *
+ *  Data parameter blocks are the same as the ResidualErrorFunctor_* <2, K, 6, 6, 3>
+ *  - 2 => dimension of the residuals,
+ *  - K => the intrinsic data block [focal x, focal y, principal point x, principal point y, distortion...],
+ *  - 6 => the rig pose data block [R;t],
+ *  - 6 => the rig sub-pose data block [R;t],
+ *  - 3 => a 3D point data block.
+ */
+template <typename DistortionT>
+class ResidualErrorRigAnalyticCostFunction
+  : public ceres::SizedCostFunction<2, analytic::IntrinsicsResidual<DistortionT>::nbParams, 6, 6, 3>
+{
+public:
+  using IntrinsicsResidual = analytic::IntrinsicsResidual<DistortionT>;
+
+  ResidualErrorRigAnalyticCostFunction(int w, int h, const sfmData::Observation& obs)
+    : _intrinsicsResidual(w, h, obs)
+  {}
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_Rt = parameters[1];
+    const double* subpose_Rt = parameters[2];
+    const Eigen::Map<const Vec3> pt3D(parameters[3]);
+
+    const bool computeJacobians = (jacobians != nullptr);
+
+    // apply the rig pose
+    Vec3 ptRig;
+    Mat3 dPtRig_dR;
+    Mat3 dPtRig_dPt3D;
+    analytic::angleAxisRotatePoint(cam_Rt, pt3D, ptRig,
+                                   computeJacobians ? &dPtRig_dR : nullptr,
+                                   computeJacobians ? &dPtRig_dPt3D : nullptr);
+    ptRig += Eigen::Map<const Vec3>(cam_Rt + 3);
+
+    // apply the rig sub-pose
+    Vec3 ptCam;
+    Mat3 dPtCam_dSubposeR;
+    Mat3 dPtCam_dPtRig;
+    analytic::angleAxisRotatePoint(subpose_Rt, ptRig, ptCam,
+                                   computeJacobians ? &dPtCam_dSubposeR : nullptr,
+                                   computeJacobians ? &dPtCam_dPtRig : nullptr);
+    ptCam += Eigen::Map<const Vec3>(subpose_Rt + 3);
+
+    const Vec2 ptUndist(ptCam(0) / ptCam(2), ptCam(1) / ptCam(2));
+
+    typename IntrinsicsResidual::ParamsJacobian dRes_dK;
+    Eigen::Matrix2d dRes_dPtUndist;
+    _intrinsicsResidual.evaluate(cam_K, ptUndist, residuals, dRes_dK, dRes_dPtUndist);
+
+    if(!computeJacobians)
+      return true;
+
+    const Eigen::Matrix<double, 2, 3> dRes_dPtCam = dRes_dPtUndist * analytic::perspectiveDivisionJacobian(ptCam);
+    const Eigen::Matrix<double, 2, 3> dRes_dPtRig = dRes_dPtCam * dPtCam_dPtRig;
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<typename IntrinsicsResidual::ParamsJacobian> J(jacobians[0]);
+      J = dRes_dK;
+    }
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.leftCols<3>() = dRes_dPtRig * dPtRig_dR;
+      J.rightCols<3>() = dRes_dPtRig;
+    }
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[2]);
+      J.leftCols<3>() = dRes_dPtCam * dPtCam_dSubposeR;
+      J.rightCols<3>() = dRes_dPtCam;
+    }
+    if(jacobians[3] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[3]);
+      J = dRes_dPtRig * dPtRig_dPt3D;
+    }
+    return true;
+  }
+
+private:
+  const IntrinsicsResidual _intrinsicsResidual;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,169 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/BatchTriangulation.hpp>
+#include <aliceVision/sfm/sfmTriangulation.hpp>
+#include <aliceVision/camera/cameraCommon.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+
+#include <random>
+
+#define BOOST_TEST_MODULE batchTriangulation
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+using namespace aliceVision::geometry;
+using namespace aliceVision::sfm;
+using namespace aliceVision::sfmData;
+
+SfMData getInputScene(const NViewDataSet& d, const NViewDatasetConfigurator& config)
+{
+  SfMData sfmData;
+
+  const int nviews = d._C.size();
+  const int npoints = d._X.cols();
+
+  for(int i = 0; i < nviews; ++i)
+  {
+    sfmData.getViews().emplace(i, std::make_shared<View>("", i, 0, i, config._cx * 2, config._cy * 2));
+    sfmData.setPose(*sfmData.getViews().at(i), CameraPose(Pose3(d._R[i], d._C[i])));
+  }
+
+  sfmData.getIntrinsics().emplace(0, createIntrinsic(EINTRINSIC::PINHOLE_CAMERA, config._cx * 2, config._cy * 2, config._fx, config._fx, 0, 0));
+
+  // landmarks without 3D position
+  for(int i = 0; i < npoints; ++i)
+  {
+    Landmark landmark;
+    for(int j = 0; j < nviews; ++j)
+      landmark.observations[j] = Observation(d._x[j].col(i), i, 0.0);
+    sfmData.getLandmarks()[i] = landmark;
+  }
+
+  return sfmData;
+}
+
+BOOST_AUTO_TEST_CASE(BATCH_TRIANGULATION_RobustWithOutliers)
+{
+  const int nviews = 6;
+  const int npoints = 32;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  const SfMData sfmData = getInputScene(d, config);
+
+  BatchTriangulation::Params params;
+  params.minNbObservations = 3;
+  BatchTriangulation batch(sfmData, params);
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    batch.addTrack(landmarkPair.first, landmarkPair.second.descType);
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      Vec2 x = observationPair.second.x;
+
+      // one outlier observation per track
+      if(observationPair.first == landmarkPair.first % nviews)
+        x += Vec2(50.0, -30.0);
+
+      BOOST_CHECK(batch.addObservation(observationPair.first, x, observationPair.second.id_feat));
+    }
+  }
+
+  std::mt19937 randomNumberGenerator(42);
+  batch.triangulate(randomNumberGenerator);
+
+  BOOST_CHECK_EQUAL(batch.size(), npoints);
+
+  for(std::size_t i = 0; i < batch.size(); ++i)
+  {
+    const IndexT trackId = batch.getTrackId(i);
+
+    BOOST_CHECK(batch.isValid(i));
+    BOOST_CHECK_SMALL((batch.getPoint(i) - d._X.col(trackId)).norm(), 1e-6);
+
+    Landmark landmark;
+    batch.getLandmark(i, landmark);
+    BOOST_CHECK_EQUAL(landmark.observations.size(), nviews - 1);
+    BOOST_CHECK(landmark.observations.find(trackId % nviews) == landmark.observations.end());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BATCH_TRIANGULATION_TwoViews)
+{
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(2, 8, config);
+
+  const SfMData sfmData = getInputScene(d, config);
+
+  BatchTriangulation::Params params;
+  params.minAngle = 180.0;
+  BatchTriangulation batch(sfmData, params);
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    batch.addTrack(landmarkPair.first, landmarkPair.second.descType);
+    for(const auto& observationPair : landmarkPair.second.observations)
+      batch.addObservation(observationPair.first, observationPair.second.x, observationPair.second.id_feat);
+  }
+
+  std::mt19937 randomNumberGenerator(42);
+  batch.triangulate(randomNumberGenerator);
+
+  // no pair of rays can reach the minimum angle
+  for(std::size_t i = 0; i < batch.size(); ++i)
+  {
+    BOOST_CHECK(!batch.isValid(i));
+    BOOST_CHECK_SMALL((batch.getPoint(i) - d._X.col(batch.getTrackId(i))).norm(), 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BATCH_TRIANGULATION_StructureComputationRobust)
+{
+  const int npoints = 16;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(4, npoints, config);
+
+  SfMData sfmData = getInputScene(d, config);
+
+  // a track seen only by 2 views is rejected
+  sfmData.getLandmarks().at(0).observations.erase(0);
+  sfmData.getLandmarks().at(0).observations.erase(1);
+
+  std::mt19937 randomNumberGenerator(42);
+  StructureComputation_robust structureEstimator;
+  structureEstimator.triangulate(sfmData, randomNumberGenerator);
+
+  BOOST_CHECK_EQUAL(sfmData.getLandmarks().size(), npoints - 1);
+  BOOST_CHECK(sfmData.getLandmarks().find(0) == sfmData.getLandmarks().end());
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+    BOOST_CHECK_SMALL((landmarkPair.second.X - d._X.col(landmarkPair.first)).norm(), 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(BATCH_TRIANGULATION_StructureComputationRobust_minNbObservations)
+{
+  const int npoints = 16;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(4, npoints, config);
+
+  SfMData sfmData = getInputScene(d, config);
+
+  // a track seen only by 2 views is kept with a minimum of 2 observations
+  sfmData.getLandmarks().at(0).observations.erase(0);
+  sfmData.getLandmarks().at(0).observations.erase(1);
+
+  std::mt19937 randomNumberGenerator(42);
+  StructureComputation_robust structureEstimator(false, 2, 4.0);
+  structureEstimator.triangulate(sfmData, randomNumberGenerator);
+
+  BOOST_CHECK_EQUAL(sfmData.getLandmarks().size(), npoints);
+  BOOST_CHECK_SMALL((sfmData.getLandmarks().at(0).X - d._X.col(0)).norm(), 1e-6);
+}
@@ -72,6 +72,71 @@ inline std::istream& operator>>(std::istream& in, EFeatureConstraint& m)
     return in;
 }
 
+/**
+ * @brief Defines the bundle adjustment engines.
+ */
+enum class EBundleAdjustmentSolver
+{
+  CERES = 0, //< generic Ceres problem (BundleAdjustmentCeres)
+  SCHUR = 1  //< dedicated Schur complement solver (BundleAdjustmentSchur)
+};
+
+/**
+ * @brief Get informations about each bundle adjustment solver
+ * @return String
+ */
+inline std::string EBundleAdjustmentSolver_informations()
+{
+  return "Bundle adjustment solver:\n"
+         "* ceres: generic Ceres problem\n"
+         "* schur: dedicated solver with an explicit Schur complement of the landmarks "
+         "(2D constraints and rotation priors are not supported)";
+}
+
+/**
+ * @brief convert an enum EBundleAdjustmentSolver to its corresponding string
+ * @param EBundleAdjustmentSolver
+ * @return String
+ */
+inline std::string EBundleAdjustmentSolver_enumToString(EBundleAdjustmentSolver solver)
+{
+  switch(solver)
+  {
+    case EBundleAdjustmentSolver::CERES: return "ceres";
+    case EBundleAdjustmentSolver::SCHUR: return "schur";
+  }
+  throw std::out_of_range("Invalid EBundleAdjustmentSolver enum: " + std::to_string(int(solver)));
+}
+
+/**
+ * @brief convert a string bundle adjustment solver to its corresponding enum EBundleAdjustmentSolver
+ * @param String
+ * @return EBundleAdjustmentSolver
+ */
+inline EBundleAdjustmentSolver EBundleAdjustmentSolver_stringToEnum(const std::string& solver)
+{
+  std::string s = solver;
+  std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+
+  if(s == "ceres") return EBundleAdjustmentSolver::CERES;
+  if(s == "schur") return EBundleAdjustmentSolver::SCHUR;
+
+  throw std::out_of_range("Invalid EBundleAdjustmentSolver: " + solver);
+}
+
+inline std::ostream& operator<<(std::ostream& os, EBundleAdjustmentSolver solver)
+{
+    return os << EBundleAdjustmentSolver_enumToString(solver);
+}
+
+inline std::istream& operator>>(std::istream& in, EBundleAdjustmentSolver& solver)
+{
+    std::string token;
+    in >> token;
+    solver = EBundleAdjustmentSolver_stringToEnum(token);
+    return in;
+}
+
 class BundleAdjustment
 {
 public:
@@ -7,6 +7,7 @@
 
 #include <aliceVision/sfm/bundle/BundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorAnalyticCostFunction.hpp>
 #include <aliceVision/sfm/ResidualErrorConstraintFunctor.hpp>
 #include <aliceVision/sfm/ResidualErrorRotationPriorFunctor.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
@@ -19,6 +20,7 @@
 #include <ceres/rotation.h>
 
 #include <fstream>
+#include <limits>
 #include <memory>
 
 
@@ -30,6 +32,28 @@ namespace sfm {
 using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
 
+/**
+ * @brief Count the number of reconstructed views per intrinsic
+ * @param[in] sfmData The input SfMData
+ * @return the number of reconstructed views per intrinsic referenced by a view
+ */
+std::map<IndexT, std::size_t> computeIntrinsicsUsage(const sfmData::SfMData& sfmData)
+{
+  std::map<IndexT, std::size_t> intrinsicsUsage;
+
+  for(const auto& viewPair: sfmData.getViews())
+  {
+    const sfmData::View& view = *(viewPair.second);
+
+    if(intrinsicsUsage.find(view.getIntrinsicId()) == intrinsicsUsage.end())
+      intrinsicsUsage[view.getIntrinsicId()] = 0;
+
+    if(sfmData.isPoseAndIntrinsicDefined(&view))
+      ++intrinsicsUsage.at(view.getIntrinsicId());
+  }
+  return intrinsicsUsage;
+}
+
 class IntrinsicsManifold : public ceres::Manifold {
  public:
   explicit IntrinsicsManifold(size_t parametersSize, double focalRatio, bool lockFocal, bool lockFocalRatio, bool lockCenter, bool lockDistortion)
@@ -189,13 +213,50 @@ class IntrinsicsManifold : public ceres::Manifold {
   bool _lockDistortion;
 };
 
+/**
+ * @brief Create the cost function with analytic jacobians according the provided camera intrinsic model
+ * @param[in] type The intrinsic type
+ * @param[in] w The intrinsic image width
+ * @param[in] h The intrinsic image height
+ * @param[in] observation The corresponding undistorted observation
+ * @return cost function
+ */
+template <template <typename> class CostFunctionT>
+ceres::CostFunction* createAnalyticCostFunction(EINTRINSIC type, int w, int h, const sfmData::Observation& observation)
+{
+  switch(type)
+  {
+    case EINTRINSIC::PINHOLE_CAMERA:
+      return new CostFunctionT<analytic::DistortionNone>(w, h, observation);
+    case EINTRINSIC::PINHOLE_CAMERA_RADIAL1:
+      return new CostFunctionT<analytic::DistortionRadialK1>(w, h, observation);
+    case EINTRINSIC::PINHOLE_CAMERA_RADIAL3:
+      return new CostFunctionT<analytic::DistortionRadialK3>(w, h, observation);
+    case EINTRINSIC::PINHOLE_CAMERA_3DERADIAL4:
+      return new CostFunctionT<analytic::Distortion3DERadial4>(w, h, observation);
+    case EINTRINSIC::PINHOLE_CAMERA_3DECLASSICLD:
+      return new CostFunctionT<analytic::Distortion3DEClassicLD>(w, h, observation);
+    case EINTRINSIC::PINHOLE_CAMERA_3DEANAMORPHIC4:
+      return new CostFunctionT<analytic::DistortionNone>(w, h, observation);
+    case EINTRINSIC::PINHOLE_CAMERA_BROWN:
+      return new CostFunctionT<analytic::DistortionBrownT2>(w, h, observation);
+    case EINTRINSIC::PINHOLE_CAMERA_FISHEYE:
+      return new CostFunctionT<analytic::DistortionFisheye>(w, h, observation);
+    case EINTRINSIC::PINHOLE_CAMERA_FISHEYE1:
+      return new CostFunctionT<analytic::DistortionFisheye1>(w, h, observation);
+    default:
+      throw std::logic_error("Cannot create cost function, unrecognized intrinsic type in BA.");
+  }
+}
+
 /**
  * @brief Create the appropriate cost functor according the provided input camera intrinsic model
  * @param[in] intrinsicPtr The intrinsic pointer
  * @param[in] observation The corresponding observation
+ * @param[in] useAnalyticJacobians Use the cost function with analytic jacobians instead of automatic differentiation
  * @return cost functor
  */
-ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation)
+ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation, bool useAnalyticJacobians)
 {
   int w = intrinsicPtr->w();
   int h = intrinsicPtr->h();
@@ -213,6 +274,9 @@ ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intri
     }
   }
 
+  if(useAnalyticJacobians)
+    return createAnalyticCostFunction<ResidualErrorAnalyticCostFunction>(intrinsicPtr->getType(), w, h, obsUndistorted);
+
   switch(intrinsicPtr->getType())
   {
     case EINTRINSIC::PINHOLE_CAMERA:
@@ -251,9 +315,10 @@ ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intri
  * @brief Create the appropriate cost functor according the provided input rig camera intrinsic model
  * @param[in] intrinsicPtr The intrinsic pointer
  * @param[in] observation The corresponding observation
+ * @param[in] useAnalyticJacobians Use the cost function with analytic jacobians instead of automatic differentiation
  * @return cost functor
  */
-ceres::CostFunction* createRigCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation)
+ceres::CostFunction* createRigCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation, bool useAnalyticJacobians)
 {
   int w = intrinsicPtr->w();
   int h = intrinsicPtr->h();
@@ -271,6 +336,9 @@ ceres::CostFunction* createRigCostFunctionFromIntrinsics(const IntrinsicBase* in
     }
   }
 
+  if(useAnalyticJacobians)
+    return createAnalyticCostFunction<ResidualErrorRigAnalyticCostFunction>(intrinsicPtr->getType(), w, h, obsUndistorted);
+
   switch(intrinsicPtr->getType())
   {
     case EINTRINSIC::PINHOLE_CAMERA:
@@ -561,30 +629,27 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
       return;
     }
 
-    // constant parameters
-    std::vector<int> constantExtrinsic;
+    // the block can be constant from a previous adjustment of the persistent problem
+    problem.SetParameterBlockVariable(poseBlockPtr);
 
-    // don't refine rotations
+    // subset parametrization
     if(!refineRotation)
     {
-      constantExtrinsic.push_back(0);
-      constantExtrinsic.push_back(1);
-      constantExtrinsic.push_back(2);
+      // don't refine rotations
+      if(_translationOnlyManifold == nullptr)
+        _translationOnlyManifold.reset(new ceres::SubsetManifold(6, {0, 1, 2}));
+      problem.SetManifold(poseBlockPtr, _translationOnlyManifold.get());
     }
-
-    // don't refine translations
-    if(!refineTranslation)
+    else if(!refineTranslation)
     {
-      constantExtrinsic.push_back(3);
-      constantExtrinsic.push_back(4);
-      constantExtrinsic.push_back(5);
+      // don't refine translations
+      if(_rotationOnlyManifold == nullptr)
+        _rotationOnlyManifold.reset(new ceres::SubsetManifold(6, {3, 4, 5}));
+      problem.SetManifold(poseBlockPtr, _rotationOnlyManifold.get());
     }
-
-    // subset parametrization
-    if(!constantExtrinsic.empty())
+    else if(problem.HasManifold(poseBlockPtr))
     {
-      auto* subsetManifold = new ceres::SubsetManifold(6, constantExtrinsic);
-      problem.SetManifold(poseBlockPtr, subsetManifold);
+      problem.SetManifold(poseBlockPtr, nullptr);
     }
 
     _statistics.addState(EParameter::POSE, EParameterState::REFINED);
@@ -636,19 +701,8 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
   const bool refineIntrinsicsDistortion = refineOptions & REFINE_INTRINSICS_DISTORTION;
   const bool refineIntrinsics = refineIntrinsicsDistortion || refineIntrinsicsFocalLength || refineIntrinsicsOpticalCenter;
 
-  std::map<IndexT, std::size_t> intrinsicsUsage;
-
   // count the number of reconstructed views per intrinsic
-  for(const auto& viewPair: sfmData.getViews())
-  {
-    const sfmData::View& view = *(viewPair.second);
-
-    if(intrinsicsUsage.find(view.getIntrinsicId()) == intrinsicsUsage.end())
-      intrinsicsUsage[view.getIntrinsicId()] = 0;
-
-    if(sfmData.isPoseAndIntrinsicDefined(&view))
-      ++intrinsicsUsage.at(view.getIntrinsicId());
-  }
+  const std::map<IndexT, std::size_t> intrinsicsUsage = computeIntrinsicsUsage(sfmData);
 
   for(const auto& intrinsicPair: sfmData.getIntrinsics())
   {
@@ -669,8 +723,14 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
 
     assert(isValid(intrinsicPtr->getType()));
 
+    const std::vector<double> params = intrinsicPtr->getParams();
     std::vector<double>& intrinsicBlock = _intrinsicsBlocks[intrinsicId];
-    intrinsicBlock = intrinsicPtr->getParams();
+
+    // keep the block memory used by the persistent problem
+    if(intrinsicBlock.size() == params.size())
+      std::copy(params.begin(), params.end(), intrinsicBlock.begin());
+    else
+      intrinsicBlock = params;
 
     double* intrinsicBlockPtr = intrinsicBlock.data();
 
@@ -679,6 +739,16 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
     // add intrinsic parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(intrinsicBlockPtr);
 
+    if(isPersistentProblem(problem))
+    {
+      // remove the bounds of a previous adjustment
+      for(int i = 0; i < std::min(4, static_cast<int>(intrinsicBlock.size())); ++i)
+      {
+        problem.SetParameterLowerBound(intrinsicBlockPtr, i, -std::numeric_limits<double>::max());
+        problem.SetParameterUpperBound(intrinsicBlockPtr, i, std::numeric_limits<double>::max());
+      }
+    }
+
     // keep the camera intrinsic constant
     if(intrinsicPtr->isLocked() || !refineIntrinsics || getIntrinsicState(intrinsicId) == EParameterState::CONSTANT)
     {
@@ -688,6 +758,9 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
       continue;
     }
 
+    // the block can be constant from a previous adjustment of the persistent problem
+    problem.SetParameterBlockVariable(intrinsicBlockPtr);
+
     // constant parameters
     bool lockCenter = false;
     bool lockFocal = false;
@@ -761,9 +834,12 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
     }
 
     
-    IntrinsicsManifold* subsetManifold = new IntrinsicsManifold(intrinsicBlock.size(), focalRatio,
-                                                                lockFocal, lockRatio, lockCenter, lockDistortion);
-    problem.SetManifold(intrinsicBlockPtr, subsetManifold);
+    std::unique_ptr<ceres::Manifold> subsetManifold(new IntrinsicsManifold(intrinsicBlock.size(), focalRatio,
+                                                                           lockFocal, lockRatio, lockCenter, lockDistortion));
+    problem.SetManifold(intrinsicBlockPtr, subsetManifold.get());
+
+    // the previous manifold of this intrinsic is no longer used by the problem
+    _intrinsicsManifolds[intrinsicId] = std::move(subsetManifold);
 
     _statistics.addState(EParameter::INTRINSIC, EParameterState::REFINED);
   }
@@ -825,29 +901,45 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
         _linearSolverOrdering.AddElementToGroup(intrinsicBlockPtr, 2);
       }
 
-      if(view.isPartOfRig() && !view.isPoseIndependant())
-      {
-        ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation);
+      const bool isRig = view.isPartOfRig() && !view.isPoseIndependant();
 
-        double* rigBlockPtr = _rigBlocks.at(view.getRigId()).at(view.getSubPoseId()).data();
-        _linearSolverOrdering.AddElementToGroup(rigBlockPtr, 1);
+      if(isRig)
+        _linearSolverOrdering.AddElementToGroup(_rigBlocks.at(view.getRigId()).at(view.getSubPoseId()).data(), 1);
 
-        problem.AddResidualBlock(costFunction,
-            lossFunction,
-            intrinsicBlockPtr,
-            poseBlockPtr,
-            rigBlockPtr, // subpose of the cameras rig
-            landmarkBlockPtr); // do we need to copy 3D point to avoid false motion, if failure ?
-      }
-      else
-      {
-        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation);
+      // the residual block of the observation is already in the persistent problem
+      const bool hasResidualBlock = isPersistentProblem(problem) &&
+                                    (_observationsResidualBlocks[landmarkId].count(observationPair.first) > 0);
 
-        problem.AddResidualBlock(costFunction,
-            lossFunction,
-            intrinsicBlockPtr,
-            poseBlockPtr,
-            landmarkBlockPtr); //do we need to copy 3D point to avoid false motion, if failure ?
+      if(!hasResidualBlock)
+      {
+        ceres::ResidualBlockId residualBlockId;
+
+        if(isRig)
+        {
+          ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation, _ceresOptions.useAnalyticJacobians);
+
+          double* rigBlockPtr = _rigBlocks.at(view.getRigId()).at(view.getSubPoseId()).data();
+
+          residualBlockId = problem.AddResidualBlock(costFunction,
+              lossFunction,
+              intrinsicBlockPtr,
+              poseBlockPtr,
+              rigBlockPtr, // subpose of the cameras rig
+              landmarkBlockPtr); // do we need to copy 3D point to avoid false motion, if failure ?
+        }
+        else
+        {
+          ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation, _ceresOptions.useAnalyticJacobians);
+
+          residualBlockId = problem.AddResidualBlock(costFunction,
+              lossFunction,
+              intrinsicBlockPtr,
+              poseBlockPtr,
+              landmarkBlockPtr); //do we need to copy 3D point to avoid false motion, if failure ?
+        }
+
+        if(isPersistentProblem(problem))
+          _observationsResidualBlocks[landmarkId][observationPair.first] = {residualBlockId, observation.x, isRig ? view.getSubPoseId() : UndefinedIndexT};
       }
 
       if(!refineStructure || getLandmarkState(landmarkId) == EParameterState::CONSTANT)
@@ -859,6 +951,7 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
       else
       {
         _statistics.addState(EParameter::LANDMARK, EParameterState::REFINED);
+        problem.SetParameterBlockVariable(landmarkBlockPtr);
       }
     }
   }
@@ -890,7 +983,10 @@ void BundleAdjustmentCeres::addConstraints2DToProblem(const sfmData::SfMData& sf
 
 
     ceres::CostFunction* costFunction = createConstraintsCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view_1.getIntrinsicId()), constraint.ObservationFirst.x, constraint.ObservationSecond.x);
-    problem.AddResidualBlock(costFunction, lossFunction, intrinsicBlockPtr_1, poseBlockPtr_1, poseBlockPtr_2);
+    const ceres::ResidualBlockId residualBlockId = problem.AddResidualBlock(costFunction, lossFunction, intrinsicBlockPtr_1, poseBlockPtr_1, poseBlockPtr_2);
+
+    if(isPersistentProblem(problem))
+      _constraintsResidualBlocks.push_back(residualBlockId);
   }
 }
 
@@ -912,7 +1008,10 @@ void BundleAdjustmentCeres::addRotationPriorsToProblem(const sfmData::SfMData& s
 
 
     ceres::CostFunction* costFunction = new ceres::AutoDiffCostFunction<ResidualErrorRotationPriorFunctor, 3, 6, 6>(new ResidualErrorRotationPriorFunctor(prior._second_R_first));
-    problem.AddResidualBlock(costFunction, lossFunction, poseBlockPtr_1, poseBlockPtr_2);
+    const ceres::ResidualBlockId residualBlockId = problem.AddResidualBlock(costFunction, lossFunction, poseBlockPtr_1, poseBlockPtr_2);
+
+    if(isPersistentProblem(problem))
+      _constraintsResidualBlocks.push_back(residualBlockId);
   }
 }
 
@@ -945,6 +1044,9 @@ void BundleAdjustmentCeres::createProblem(const sfmData::SfMData& sfmData,
 
  void BundleAdjustmentCeres::resetProblem()
 {
+  // the persistent problem uses the parameters blocks
+  resetPersistentProblem();
+
   _statistics = Statistics();
 
   _allParametersBlocks.clear();
@@ -952,8 +1054,180 @@ void BundleAdjustmentCeres::createProblem(const sfmData::SfMData& sfmData,
   _intrinsicsBlocks.clear();
   _landmarksBlocks.clear();
   _rigBlocks.clear();
+  _intrinsicsManifolds.clear();
+
+  _linearSolverOrdering.Clear();
+}
+
+void BundleAdjustmentCeres::resetPersistentProblem()
+{
+  _problem.reset();
+  _problemLossFunction.reset();
+  _observationsResidualBlocks.clear();
+  _constraintsResidualBlocks.clear();
+}
+
+void BundleAdjustmentCeres::removeOutdatedBlocks(const sfmData::SfMData& sfmData, ceres::Problem& problem)
+{
+  // residual blocks of the 2D constraints and the rotation priors are always rebuilt
+  for(const ceres::ResidualBlockId residualBlockId : _constraintsResidualBlocks)
+    problem.RemoveResidualBlock(residualBlockId);
+  _constraintsResidualBlocks.clear();
+
+  const std::map<IndexT, std::size_t> intrinsicsUsage = computeIntrinsicsUsage(sfmData);
+
+  const auto isPoseUsed = [&](IndexT poseId) {
+    return sfmData.getPoses().count(poseId) && (getPoseState(poseId) != EParameterState::IGNORED);
+  };
+
+  const auto isSubPoseUsed = [&](IndexT rigId, IndexT subPoseId) {
+    const auto rigIt = sfmData.getRigs().find(rigId);
+    return (rigIt != sfmData.getRigs().end()) &&
+           (subPoseId < rigIt->second.getNbSubPoses()) &&
+           (rigIt->second.getSubPose(subPoseId).status != sfmData::ERigSubPoseStatus::UNINITIALIZED);
+  };
+
+  const auto isIntrinsicUsed = [&](IndexT intrinsicId) {
+    const auto usageIt = intrinsicsUsage.find(intrinsicId);
+    return (usageIt != intrinsicsUsage.end()) && (usageIt->second > 0) &&
+           sfmData.getIntrinsics().count(intrinsicId) && (getIntrinsicState(intrinsicId) != EParameterState::IGNORED);
+  };
 
+  // observations residual blocks
+  for(auto landmarkIt = _observationsResidualBlocks.begin(); landmarkIt != _observationsResidualBlocks.end();)
+  {
+    const auto sfmLandmarkIt = sfmData.getLandmarks().find(landmarkIt->first);
+    const bool isLandmarkUsed = (sfmLandmarkIt != sfmData.getLandmarks().end()) && (getLandmarkState(landmarkIt->first) != EParameterState::IGNORED);
+    auto& residualBlocks = landmarkIt->second;
+
+    for(auto residualIt = residualBlocks.begin(); residualIt != residualBlocks.end();)
+    {
+      bool isValid = isLandmarkUsed;
+
+      if(isValid)
+      {
+        const auto observationIt = sfmLandmarkIt->second.observations.find(residualIt->first);
+        isValid = (observationIt != sfmLandmarkIt->second.observations.end()) && (observationIt->second.x == residualIt->second.x);
+      }
+
+      if(isValid)
+      {
+        const sfmData::View& view = sfmData.getView(residualIt->first);
+        isValid = isPoseUsed(view.getPoseId()) && isIntrinsicUsed(view.getIntrinsicId()) &&
+                  (residualIt->second.subPoseId == UndefinedIndexT || isSubPoseUsed(view.getRigId(), residualIt->second.subPoseId));
+      }
+
+      if(isValid)
+      {
+        ++residualIt;
+        continue;
+      }
+
+      problem.RemoveResidualBlock(residualIt->second.residualBlockId);
+      residualIt = residualBlocks.erase(residualIt);
+    }
+
+    if(residualBlocks.empty())
+    {
+      // the landmark is not observed anymore in the problem
+      const auto blockIt = _landmarksBlocks.find(landmarkIt->first);
+      if(blockIt != _landmarksBlocks.end())
+      {
+        if(problem.HasParameterBlock(blockIt->second.data()))
+          problem.RemoveParameterBlock(blockIt->second.data());
+        _landmarksBlocks.erase(blockIt);
+      }
+      landmarkIt = _observationsResidualBlocks.erase(landmarkIt);
+    }
+    else
+    {
+      ++landmarkIt;
+    }
+  }
+
+  // parameters blocks, their residual blocks have been removed
+  for(auto it = _posesBlocks.begin(); it != _posesBlocks.end();)
+  {
+    if(isPoseUsed(it->first))
+    {
+      ++it;
+      continue;
+    }
+    if(problem.HasParameterBlock(it->second.data()))
+      problem.RemoveParameterBlock(it->second.data());
+    it = _posesBlocks.erase(it);
+  }
+
+  for(auto& rigIt : _rigBlocks)
+  {
+    for(auto it = rigIt.second.begin(); it != rigIt.second.end();)
+    {
+      if(isSubPoseUsed(rigIt.first, it->first))
+      {
+        ++it;
+        continue;
+      }
+      if(problem.HasParameterBlock(it->second.data()))
+        problem.RemoveParameterBlock(it->second.data());
+      it = rigIt.second.erase(it);
+    }
+  }
+
+  for(auto it = _intrinsicsBlocks.begin(); it != _intrinsicsBlocks.end();)
+  {
+    if(isIntrinsicUsed(it->first))
+    {
+      ++it;
+      continue;
+    }
+    if(problem.HasParameterBlock(it->second.data()))
+      problem.RemoveParameterBlock(it->second.data());
+    _intrinsicsManifolds.erase(it->first);
+    it = _intrinsicsBlocks.erase(it);
+  }
+
+  for(auto it = _landmarksBlocks.begin(); it != _landmarksBlocks.end();)
+  {
+    if(sfmData.getLandmarks().count(it->first) && (getLandmarkState(it->first) != EParameterState::IGNORED))
+    {
+      ++it;
+      continue;
+    }
+    if(problem.HasParameterBlock(it->second.data()))
+      problem.RemoveParameterBlock(it->second.data());
+    it = _landmarksBlocks.erase(it);
+  }
+}
+
+void BundleAdjustmentCeres::updateProblem(const sfmData::SfMData& sfmData,
+                                          ERefineOptions refineOptions,
+                                          ceres::Problem& problem)
+{
+  // clear the data of the previous adjustment, the parameters blocks are kept
+  _statistics = Statistics();
+  _allParametersBlocks.clear();
   _linearSolverOrdering.Clear();
+
+  // ensure we are not using incompatible options
+  assert(!((refineOptions & REFINE_INTRINSICS_OPTICALOFFSET_ALWAYS) && (refineOptions & REFINE_INTRINSICS_OPTICALOFFSET_IF_ENOUGH_DATA)));
+
+  // remove the blocks of the removed or ignored parameters
+  removeOutdatedBlocks(sfmData, problem);
+
+  // update the SfM extrincics, the parameters values are the starting point of the solver
+  addExtrinsicsToProblem(sfmData, refineOptions, problem);
+
+  // update the SfM intrinsics
+  addIntrinsicsToProblem(sfmData, refineOptions, problem);
+
+  // update the SfM landmarks, only the new observations are added
+  addLandmarksToProblem(sfmData, refineOptions, problem);
+
+  // add 2D constraints to the Ceres problem
+  addConstraints2DToProblem(sfmData, refineOptions, problem);
+
+  // add rotation priors to the Ceres problem
+  addRotationPriorsToProblem(sfmData, refineOptions, problem);
 }
 
 void BundleAdjustmentCeres::updateFromSolution(sfmData::SfMData& sfmData, ERefineOptions refineOptions) const
@@ -1045,6 +1319,7 @@ void BundleAdjustmentCeres::createJacobian(const sfmData::SfMData& sfmData,
   // create problem
   ceres::Problem::Options problemOptions;
   problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+  problemOptions.manifold_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
   ceres::Problem problem(problemOptions);
   createProblem(sfmData, refineOptions, problem);
 
@@ -1064,8 +1339,37 @@ bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions ref
   // create problem
   ceres::Problem::Options problemOptions;
   problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
-  ceres::Problem problem(problemOptions);
-  createProblem(sfmData, refineOptions, problem);
+  problemOptions.manifold_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+
+  std::unique_ptr<ceres::Problem> localProblem;
+  ceres::Problem* problemPtr = nullptr;
+
+  if(_ceresOptions.persistentProblem)
+  {
+    // the residual blocks of the persistent problem use the loss function given at its creation
+    if(_problem != nullptr && _problemLossFunction != _ceresOptions.lossFunction)
+      resetPersistentProblem();
+
+    if(_problem == nullptr)
+    {
+      resetProblem();
+      problemOptions.enable_fast_removal = true;
+      _problem.reset(new ceres::Problem(problemOptions));
+      _problemLossFunction = _ceresOptions.lossFunction;
+    }
+
+    // only update the changed blocks, the solver starts from the current sfmData values
+    updateProblem(sfmData, refineOptions, *_problem);
+    problemPtr = _problem.get();
+  }
+  else
+  {
+    localProblem.reset(new ceres::Problem(problemOptions));
+    createProblem(sfmData, refineOptions, *localProblem);
+    problemPtr = localProblem.get();
+  }
+
+  ceres::Problem& problem = *problemPtr;
 
   // configure a Bundle Adjustment engine and run it
   // make Ceres automatically detect the bundle structure.
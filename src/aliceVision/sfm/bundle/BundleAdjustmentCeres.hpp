@@ -54,6 +54,10 @@ public:
     unsigned int nbThreads;
     unsigned int maxNumIterations;
     bool useParametersOrdering = true;
+    /// use the reprojection cost functions with analytic jacobians instead of automatic differentiation
+    bool useAnalyticJacobians = true;
+    /// keep the ceres problem between two adjustments and only update the changed parameter and residual blocks
+    bool persistentProblem = false;
     bool summary = false;
     bool verbose = true;
   };
@@ -122,6 +126,30 @@ public:
     , _minNbImagesToRefineOpticalCenter(minNbImagesToRefineOpticalCenter)
   {}
 
+  /**
+   * @brief Get the user Ceres options
+   * @return the Ceres options
+   */
+  inline const CeresOptions& getCeresOptions() const
+  {
+    return _ceresOptions;
+  }
+
+  /**
+   * @brief Set the user Ceres options
+   *  The persistent problem is kept if the loss function is the same.
+   * @param[in] options The user Ceres options
+   */
+  inline void setCeresOptions(const CeresOptions& options)
+  {
+    _ceresOptions = options;
+  }
+
+  /**
+   * @brief Release the persistent problem, the next adjustment will create it from scratch
+   */
+  void resetPersistentProblem();
+
   /**
    * @brief Create a jacobian CRSMatrix
    * @param[in] sfmData The input SfMData contains all the information about the reconstruction
@@ -221,6 +249,33 @@ private:
    */
   void addRotationPriorsToProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
 
+  /**
+   * @brief Remove the parameter and residual blocks of the persistent problem
+   *        that are no longer part of the adjustment (removed or ignored by the local strategy)
+   * @param[in] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in,out] problem The persistent Ceres bundle adjustement problem
+   */
+  void removeOutdatedBlocks(const sfmData::SfMData& sfmData, ceres::Problem& problem);
+
+  /**
+   * @brief Update the persistent Ceres bundle adjustement problem:
+   *  - remove the outdated parameters and residuals blocks.
+   *  - update the values and the states of the parameters blocks.
+   *  - add the residual blocks of the new observations.
+   * @param[in] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in] refineOptions The chosen refine flag
+   * @param[in,out] problem The persistent Ceres bundle adjustement problem
+   */
+  void updateProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
+
+  /**
+   * @brief Return true if the given problem is the persistent problem
+   */
+  inline bool isPersistentProblem(const ceres::Problem& problem) const
+  {
+    return (_problem != nullptr && &problem == _problem.get());
+  }
+
   /**
    * @brief Create the Ceres bundle adjustement problem with:
    *  - extrincics and intrinsics parameters blocks.
@@ -300,6 +355,34 @@ private:
   /// block: ceres angleAxis(3) + translation(3)
   HashMap<IndexT, HashMap<IndexT, std::array<double,6>>> _rigBlocks;
 
+  /// manifolds of the parameters blocks (not owned by the ceres problems)
+  std::unique_ptr<ceres::Manifold> _rotationOnlyManifold;
+  std::unique_ptr<ceres::Manifold> _translationOnlyManifold;
+  HashMap<IndexT, std::unique_ptr<ceres::Manifold>> _intrinsicsManifolds;
+
+  // persistent problem data
+
+  /**
+   * @brief Residual block of an observation in the persistent problem
+   */
+  struct ObservationResidualBlock
+  {
+    ceres::ResidualBlockId residualBlockId;
+    /// observation used to create the residual block
+    Vec2 x;
+    /// rig sub-pose used by the residual block, UndefinedIndexT if none
+    IndexT subPoseId;
+  };
+
+  /// persistent Ceres problem, kept between two adjustments if CeresOptions::persistentProblem
+  std::unique_ptr<ceres::Problem> _problem;
+  /// loss function used by the residual blocks of the persistent problem
+  std::shared_ptr<ceres::LossFunction> _problemLossFunction;
+  /// residual blocks of the persistent problem per landmark and per view
+  HashMap<IndexT, HashMap<IndexT, ObservationResidualBlock>> _observationsResidualBlocks;
+  /// residual blocks of the 2D constraints and the rotation priors in the persistent problem
+  std::vector<ceres::ResidualBlockId> _constraintsResidualBlocks;
+
   /// hinted order for ceres to eliminate blocks when solving.
   /// note: this ceres parameter is built internally and must be reset on each call to the solver.
   ceres::ParameterBlockOrdering _linearSolverOrdering;
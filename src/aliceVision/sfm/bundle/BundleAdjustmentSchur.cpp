@@ -0,0 +1,1338 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "BundleAdjustmentSchur.hpp"
+#include <aliceVision/sfm/LocalBundleAdjustmentGraph.hpp>
+#include <aliceVision/sfm/ResidualErrorAnalyticCostFunction.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+using namespace aliceVision::camera;
+
+namespace {
+
+/// largest camera side parameter block (3DE radial 4 intrinsics)
+constexpr int maxBlockSize = 10;
+
+using CameraJacobian = Eigen::Matrix<double, 2, Eigen::Dynamic, Eigen::RowMajor, 2, maxBlockSize>;
+using PointJacobian = Eigen::Matrix<double, 2, 3, Eigen::RowMajor>;
+using CameraPointBlock = Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor, maxBlockSize, 3>;
+using CameraBlockMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor, maxBlockSize, maxBlockSize>;
+
+/// minimum / maximum values of the Levenberg-Marquardt diagonal (same as ceres)
+constexpr double minDiagonal = 1e-6;
+constexpr double maxDiagonal = 1e32;
+
+/// slots of the camera blocks in an observation
+enum EObservationBlock
+{
+  OBS_INTRINSIC = 0,
+  OBS_POSE = 1,
+  OBS_SUBPOSE = 2,
+  OBS_NB_BLOCKS = 3
+};
+
+/**
+ * @brief Camera side parameter block: pose, rig sub-pose or intrinsic.
+ */
+struct CameraBlock
+{
+  bool isPose = false;
+  int size = 0;
+  /// offset of the parameters in the camera values
+  std::size_t valuesOffset = 0;
+  /// offset in the reduced camera system, -1 if the block is constant
+  int systemOffset = -1;
+  /// parameters kept constant in a refined block
+  std::array<bool, maxBlockSize> locked{};
+  std::array<double, maxBlockSize> lowerBound;
+  std::array<double, maxBlockSize> upperBound;
+  /// intrinsics only: the focal length y is updated with the focal length x (fx = focalRatio * fy)
+  bool lockFocalRatio = false;
+  double focalRatio = 1.0;
+  /// intrinsics only: camera model
+  EINTRINSIC type = EINTRINSIC::UNKNOWN;
+  int width = 0;
+  int height = 0;
+
+  CameraBlock()
+  {
+    lowerBound.fill(-std::numeric_limits<double>::max());
+    upperBound.fill(std::numeric_limits<double>::max());
+  }
+};
+
+/**
+ * @brief Block of the reduced camera system (upper triangular part).
+ */
+struct SystemSlot
+{
+  int row;
+  int col;
+  std::size_t valuesOffset;
+  /// offset in the per-thread buffers of the slots not linked to a pose, -1 for the pose slots
+  int threadOffset;
+};
+
+template <typename DistortionT>
+void evaluateObservation(const CameraBlock& intrinsic,
+                         const sfmData::Observation& observation,
+                         const double* const* parameters,
+                         bool isRig,
+                         double* residuals,
+                         double** jacobians)
+{
+  if(isRig)
+  {
+    const ResidualErrorRigAnalyticCostFunction<DistortionT> costFunction(intrinsic.width, intrinsic.height, observation);
+    costFunction.Evaluate(parameters, residuals, jacobians);
+  }
+  else
+  {
+    const double* singleParameters[3] = {parameters[0], parameters[1], parameters[3]};
+    double* singleJacobians[3] = {nullptr, nullptr, nullptr};
+    if(jacobians != nullptr)
+    {
+      singleJacobians[0] = jacobians[0];
+      singleJacobians[1] = jacobians[1];
+      singleJacobians[2] = jacobians[3];
+    }
+    const ResidualErrorAnalyticCostFunction<DistortionT> costFunction(intrinsic.width, intrinsic.height, observation);
+    costFunction.Evaluate(singleParameters, residuals, (jacobians != nullptr) ? singleJacobians : nullptr);
+  }
+}
+
+/**
+ * @brief Evaluate the reprojection residual of an observation (same models as BundleAdjustmentCeres).
+ * @param[in] parameters intrinsic, pose, sub-pose (unused if not rig) and landmark parameters
+ * @param[out] jacobians jacobians (row major) wrt. the parameters, nullptr if not needed
+ */
+void evaluateObservation(const CameraBlock& intrinsic,
+                         const sfmData::Observation& observation,
+                         const double* const* parameters,
+                         bool isRig,
+                         double* residuals,
+                         double** jacobians)
+{
+  switch(intrinsic.type)
+  {
+    case EINTRINSIC::PINHOLE_CAMERA:
+    case EINTRINSIC::PINHOLE_CAMERA_3DEANAMORPHIC4:
+      return evaluateObservation<analytic::DistortionNone>(intrinsic, observation, parameters, isRig, residuals, jacobians);
+    case EINTRINSIC::PINHOLE_CAMERA_RADIAL1:
+      return evaluateObservation<analytic::DistortionRadialK1>(intrinsic, observation, parameters, isRig, residuals, jacobians);
+    case EINTRINSIC::PINHOLE_CAMERA_RADIAL3:
+      return evaluateObservation<analytic::DistortionRadialK3>(intrinsic, observation, parameters, isRig, residuals, jacobians);
+    case EINTRINSIC::PINHOLE_CAMERA_3DERADIAL4:
+      return evaluateObservation<analytic::Distortion3DERadial4>(intrinsic, observation, parameters, isRig, residuals, jacobians);
+    case EINTRINSIC::PINHOLE_CAMERA_3DECLASSICLD:
+      return evaluateObservation<analytic::Distortion3DEClassicLD>(intrinsic, observation, parameters, isRig, residuals, jacobians);
+    case EINTRINSIC::PINHOLE_CAMERA_BROWN:
+      return evaluateObservation<analytic::DistortionBrownT2>(intrinsic, observation, parameters, isRig, residuals, jacobians);
+    case EINTRINSIC::PINHOLE_CAMERA_FISHEYE:
+      return evaluateObservation<analytic::DistortionFisheye>(intrinsic, observation, parameters, isRig, residuals, jacobians);
+    case EINTRINSIC::PINHOLE_CAMERA_FISHEYE1:
+      return evaluateObservation<analytic::DistortionFisheye1>(intrinsic, observation, parameters, isRig, residuals, jacobians);
+    default:
+      throw std::logic_error("Cannot evaluate the residual, unrecognized intrinsic type in BA.");
+  }
+}
+
+/// number of parameters of the intrinsics used by the reprojection residual
+int getNbResidualIntrinsicParams(EINTRINSIC type)
+{
+  switch(type)
+  {
+    case EINTRINSIC::PINHOLE_CAMERA:
+    case EINTRINSIC::PINHOLE_CAMERA_3DEANAMORPHIC4: return 4;
+    case EINTRINSIC::PINHOLE_CAMERA_RADIAL1: return 5;
+    case EINTRINSIC::PINHOLE_CAMERA_RADIAL3: return 7;
+    case EINTRINSIC::PINHOLE_CAMERA_3DERADIAL4: return 10;
+    case EINTRINSIC::PINHOLE_CAMERA_3DECLASSICLD: return 9;
+    case EINTRINSIC::PINHOLE_CAMERA_BROWN: return 9;
+    case EINTRINSIC::PINHOLE_CAMERA_FISHEYE: return 8;
+    case EINTRINSIC::PINHOLE_CAMERA_FISHEYE1: return 5;
+    default:
+      throw std::logic_error("Unsupported intrinsic type in BA: " + EINTRINSIC_enumToString(type) + ".");
+  }
+}
+
+Vec3 rotationToAngleAxis(const Mat3& R)
+{
+  const Eigen::AngleAxisd angleAxis(R);
+  return angleAxis.angle() * angleAxis.axis();
+}
+
+Mat3 angleAxisToRotation(const double* angleAxis)
+{
+  const Eigen::Map<const Vec3> w(angleAxis);
+  const double theta2 = w.squaredNorm();
+  if(theta2 > std::numeric_limits<double>::epsilon())
+  {
+    const double theta = std::sqrt(theta2);
+    return Eigen::AngleAxisd(theta, w / theta).toRotationMatrix();
+  }
+  // same first order approximation as ceres near zero
+  return Mat3::Identity() + analytic::skew(w);
+}
+
+/**
+ * @brief Levenberg-Marquardt bundle adjustment with explicit Schur elimination of the landmarks.
+ */
+class SchurSolver
+{
+public:
+  SchurSolver(const BundleAdjustmentSchur::SchurOptions& options)
+    : _options(options)
+    , _nbThreads(std::max(1, static_cast<int>(options.nbThreads)))
+  {}
+
+  /// add a camera side parameter block, return its index
+  int addCameraBlock(const CameraBlock& block, const double* values)
+  {
+    CameraBlock b = block;
+    b.valuesOffset = _cameraValues.size();
+    _cameraValues.insert(_cameraValues.end(), values, values + b.size);
+    _cameraBlocks.push_back(b);
+    return static_cast<int>(_cameraBlocks.size()) - 1;
+  }
+
+  const double* getCameraValues(int blockIndex) const { return _cameraValues.data() + _cameraBlocks.at(blockIndex).valuesOffset; }
+
+  /// add a landmark, its observations must be added right after
+  void addLandmark(const Vec3& X, bool refined)
+  {
+    if(_landmarkObsBegin.empty())
+      _landmarkObsBegin.push_back(0);
+    _landmarkValues.insert(_landmarkValues.end(), X.data(), X.data() + 3);
+    _landmarkRefined.push_back(refined);
+    _landmarkObsBegin.push_back(_landmarkObsBegin.back());
+  }
+
+  const double* getLandmarkValues(std::size_t landmarkIndex) const { return _landmarkValues.data() + 3 * landmarkIndex; }
+
+  /// add an observation of the last landmark
+  void addObservation(const Vec2& pt, double scale, int intrinsicBlock, int poseBlock, int subposeBlock)
+  {
+    _obsX.push_back(pt(0));
+    _obsY.push_back(pt(1));
+    _obsScale.push_back(scale);
+    _obsBlocks.push_back({intrinsicBlock, poseBlock, subposeBlock});
+    ++_landmarkObsBegin.back();
+  }
+
+  std::size_t getNbObservations() const { return _obsX.size(); }
+  std::size_t getReducedSystemSize() const { return _reducedSize; }
+
+  /**
+   * @brief Run the Levenberg-Marquardt iterations.
+   * @return false if the solution is not usable
+   */
+  bool solve(BundleAdjustmentSchur::Statistics& statistics);
+
+private:
+  std::size_t getNbLandmarks() const { return _landmarkRefined.size(); }
+
+  void setupSystem();
+  double evaluate(const std::vector<double>& cameraValues, const std::vector<double>& landmarkValues, bool withJacobians);
+  void buildReducedSystem(double lambda);
+  bool solveReducedSystem(Eigen::VectorXd& out_dx) const;
+  bool solveCholesky(Eigen::VectorXd& out_dx) const;
+  bool solveConjugateGradient(Eigen::VectorXd& out_dx) const;
+  void multiplyReducedSystem(const Eigen::VectorXd& x, Eigen::VectorXd& out_y) const;
+  void computeLandmarksStep(const Eigen::VectorXd& cameraStep, std::vector<double>& out_landmarksStep) const;
+  void applyStep(const Eigen::VectorXd& cameraStep, const std::vector<double>& landmarksStep,
+                 std::vector<double>& out_cameraValues, std::vector<double>& out_landmarkValues) const;
+
+  /// add a block to a slot of the reduced system
+  template <typename MatrixT>
+  void addToSlot(int slotIndex, const MatrixT& block, bool transposed, double* threadBuffer)
+  {
+    const SystemSlot& slot = _slots[slotIndex];
+    const int rows = _cameraBlocks[slot.row].size;
+    const int cols = _cameraBlocks[slot.col].size;
+
+    if(slot.threadOffset >= 0)
+    {
+      Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> values(threadBuffer + slot.threadOffset, rows, cols);
+      if(transposed)
+        values += block.transpose();
+      else
+        values += block;
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(_slotMutexes[slotIndex]);
+    Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> values(_slotValues.data() + slot.valuesOffset, rows, cols);
+    if(transposed)
+      values += block.transpose();
+    else
+      values += block;
+  }
+
+  /// add a vector to the right hand side of a camera block
+  template <typename VectorT>
+  void addToRhs(int blockIndex, const VectorT& v, double* threadBuffer)
+  {
+    const CameraBlock& block = _cameraBlocks[blockIndex];
+    if(!block.isPose)
+    {
+      Eigen::Map<Eigen::VectorXd>(threadBuffer + _threadRhsOffset + block.systemOffset, block.size) += v;
+      return;
+    }
+    std::lock_guard<std::mutex> lock(_cameraMutexes[blockIndex]);
+    _rhs.segment(block.systemOffset, block.size) += v;
+  }
+
+  const BundleAdjustmentSchur::SchurOptions& _options;
+  const int _nbThreads;
+
+  // camera side parameters
+  std::vector<CameraBlock> _cameraBlocks;
+  std::vector<double> _cameraValues;
+  std::size_t _reducedSize = 0;
+
+  // landmarks
+  std::vector<double> _landmarkValues;
+  std::vector<char> _landmarkRefined;
+  std::vector<std::size_t> _landmarkObsBegin;
+
+  // observations, sorted by landmark
+  std::vector<double> _obsX;
+  std::vector<double> _obsY;
+  std::vector<double> _obsScale;
+  std::vector<std::array<int, OBS_NB_BLOCKS>> _obsBlocks;
+
+  // refined camera blocks seen by each landmark (sorted) and the reduced system slots of each pair
+  std::vector<std::size_t> _landmarkCamBegin;
+  std::vector<int> _landmarkCams;
+  std::vector<std::size_t> _landmarkPairBegin;
+  std::vector<int> _landmarkPairSlots;
+  /// index of the observation camera blocks in the landmark cameras, -1 if constant
+  std::vector<std::array<int, OBS_NB_BLOCKS>> _obsLocalCams;
+
+  // reduced camera system
+  std::vector<SystemSlot> _slots;
+  std::vector<double> _slotValues;
+  std::unique_ptr<std::mutex[]> _slotMutexes;
+  std::unique_ptr<std::mutex[]> _cameraMutexes;
+  /// slot index of the diagonal block of each refined camera block
+  std::vector<int> _diagonalSlots;
+  /// jacobians of each refined camera block
+  std::vector<std::vector<std::size_t>> _blockJacobians;
+  /// slots of each block row (row or column of the slot)
+  std::vector<std::vector<int>> _rowSlots;
+  /// per-thread accumulation of the slots and right hand side not linked to a pose
+  std::vector<std::vector<double>> _threadBuffers;
+  std::size_t _threadRhsOffset = 0;
+  Eigen::VectorXd _rhs;
+  Eigen::VectorXd _cameraGradient;
+  Eigen::VectorXd _cameraDiagonal;
+
+  // linearization at the current estimate
+  std::vector<Vec2> _residuals;
+  std::vector<CameraJacobian> _cameraJacobians;
+  std::vector<PointJacobian> _pointJacobians;
+  std::vector<double> _landmarkGradient;
+  std::vector<double> _landmarkDiagonal;
+  /// inverse of the damped landmark hessian blocks
+  std::vector<Mat3> _landmarkHessianInv;
+};
+
+void SchurSolver::setupSystem()
+{
+  // offsets of the refined camera blocks in the reduced system
+  _reducedSize = 0;
+  for(CameraBlock& block : _cameraBlocks)
+  {
+    if(block.systemOffset < 0)
+      continue;
+    block.systemOffset = static_cast<int>(_reducedSize);
+    _reducedSize += block.size;
+  }
+
+  std::unordered_map<std::uint64_t, int> slotIndices;
+  auto getSlot = [&](int a, int b) {
+    if(a > b)
+      std::swap(a, b);
+    const std::uint64_t key = (static_cast<std::uint64_t>(a) << 32) | static_cast<std::uint32_t>(b);
+    const auto it = slotIndices.find(key);
+    if(it != slotIndices.end())
+      return it->second;
+    const int slotIndex = static_cast<int>(_slots.size());
+    _slots.push_back({a, b, 0, -1});
+    slotIndices.emplace(key, slotIndex);
+    return slotIndex;
+  };
+
+  // diagonal blocks
+  _diagonalSlots.assign(_cameraBlocks.size(), -1);
+  for(int c = 0; c < static_cast<int>(_cameraBlocks.size()); ++c)
+  {
+    if(_cameraBlocks[c].systemOffset >= 0)
+      _diagonalSlots[c] = getSlot(c, c);
+  }
+
+  // landmark cameras and pairs
+  const std::size_t nbLandmarks = getNbLandmarks();
+  _landmarkCamBegin.assign(1, 0);
+  _landmarkPairBegin.assign(1, 0);
+  _landmarkCams.clear();
+  _landmarkPairSlots.clear();
+  _obsLocalCams.resize(getNbObservations());
+
+  for(std::size_t l = 0; l < nbLandmarks; ++l)
+  {
+    const std::size_t camBegin = _landmarkCams.size();
+    for(std::size_t o = _landmarkObsBegin[l]; o < _landmarkObsBegin[l + 1]; ++o)
+    {
+      for(int k = 0; k < OBS_NB_BLOCKS; ++k)
+      {
+        const int c = _obsBlocks[o][k];
+        if(c >= 0 && _cameraBlocks[c].systemOffset >= 0)
+          _landmarkCams.push_back(c);
+      }
+    }
+    std::sort(_landmarkCams.begin() + camBegin, _landmarkCams.end());
+    _landmarkCams.erase(std::unique(_landmarkCams.begin() + camBegin, _landmarkCams.end()), _landmarkCams.end());
+    _landmarkCamBegin.push_back(_landmarkCams.size());
+
+    const auto camsBegin = _landmarkCams.begin() + camBegin;
+    const int m = static_cast<int>(_landmarkCams.size() - camBegin);
+
+    for(std::size_t o = _landmarkObsBegin[l]; o < _landmarkObsBegin[l + 1]; ++o)
+    {
+      for(int k = 0; k < OBS_NB_BLOCKS; ++k)
+      {
+        const int c = _obsBlocks[o][k];
+        _obsLocalCams[o][k] = (c >= 0 && _cameraBlocks[c].systemOffset >= 0) ? static_cast<int>(std::lower_bound(camsBegin, _landmarkCams.end(), c) - camsBegin) : -1;
+      }
+    }
+
+    // upper triangular pairs of the landmark cameras
+    const std::size_t pairBegin = _landmarkPairSlots.size();
+    _landmarkPairSlots.resize(pairBegin + m * (m + 1) / 2, -1);
+    const auto pairIndex = [&](int a, int b) { return pairBegin + a * m - a * (a - 1) / 2 + (b - a); };
+
+    if(_landmarkRefined[l])
+    {
+      // the landmark elimination links all its cameras
+      for(int a = 0; a < m; ++a)
+        for(int b = a; b < m; ++b)
+          _landmarkPairSlots[pairIndex(a, b)] = getSlot(*(camsBegin + a), *(camsBegin + b));
+    }
+    else
+    {
+      // only the cameras of the same observation are linked
+      for(std::size_t o = _landmarkObsBegin[l]; o < _landmarkObsBegin[l + 1]; ++o)
+      {
+        for(int i = 0; i < OBS_NB_BLOCKS; ++i)
+          for(int j = 0; j < OBS_NB_BLOCKS; ++j)
+          {
+            const int a = _obsLocalCams[o][i];
+            const int b = _obsLocalCams[o][j];
+            if(a >= 0 && b >= a)
+              _landmarkPairSlots[pairIndex(a, b)] = getSlot(*(camsBegin + a), *(camsBegin + b));
+          }
+      }
+    }
+    _landmarkPairBegin.push_back(_landmarkPairSlots.size());
+  }
+
+  // slots storage: the slots linked to a pose are locked, the others are accumulated per thread
+  std::size_t valuesSize = 0;
+  std::size_t threadSize = 0;
+  for(SystemSlot& slot : _slots)
+  {
+    const std::size_t size = _cameraBlocks[slot.row].size * _cameraBlocks[slot.col].size;
+    slot.valuesOffset = valuesSize;
+    valuesSize += size;
+    if(!_cameraBlocks[slot.row].isPose && !_cameraBlocks[slot.col].isPose)
+    {
+      slot.threadOffset = static_cast<int>(threadSize);
+      threadSize += size;
+    }
+  }
+  _threadRhsOffset = threadSize;
+  _slotValues.assign(valuesSize, 0.0);
+  _slotMutexes.reset(new std::mutex[_slots.size()]);
+  _cameraMutexes.reset(new std::mutex[_cameraBlocks.size()]);
+  _threadBuffers.assign(_nbThreads, std::vector<double>(threadSize + _reducedSize, 0.0));
+
+  _rowSlots.assign(_cameraBlocks.size(), {});
+  for(int s = 0; s < static_cast<int>(_slots.size()); ++s)
+  {
+    _rowSlots[_slots[s].row].push_back(s);
+    if(_slots[s].row != _slots[s].col)
+      _rowSlots[_slots[s].col].push_back(s);
+  }
+
+  const std::size_t nbObservations = getNbObservations();
+  _blockJacobians.assign(_cameraBlocks.size(), {});
+  for(std::size_t o = 0; o < nbObservations; ++o)
+    for(int k = 0; k < OBS_NB_BLOCKS; ++k)
+      if(_obsLocalCams[o][k] >= 0)
+        _blockJacobians[_obsBlocks[o][k]].push_back(OBS_NB_BLOCKS * o + k);
+
+  _residuals.resize(nbObservations);
+  _cameraJacobians.resize(OBS_NB_BLOCKS * nbObservations);
+  _pointJacobians.resize(nbObservations);
+  _landmarkGradient.resize(3 * nbLandmarks);
+  _landmarkDiagonal.resize(3 * nbLandmarks);
+  _landmarkHessianInv.resize(nbLandmarks);
+}
+
+double SchurSolver::evaluate(const std::vector<double>& cameraValues, const std::vector<double>& landmarkValues, bool withJacobians)
+{
+  const double a = _options.lossScale;
+  const double b = a * a;
+  const std::int64_t nbObservations = static_cast<std::int64_t>(getNbObservations());
+  const std::int64_t nbLandmarks = static_cast<std::int64_t>(getNbLandmarks());
+  double cost = 0.0;
+
+  #pragma omp parallel for num_threads(_nbThreads) schedule(dynamic, 64) reduction(+:cost)
+  for(std::int64_t l = 0; l < nbLandmarks; ++l)
+  {
+    for(std::size_t o = _landmarkObsBegin[l]; o < _landmarkObsBegin[l + 1]; ++o)
+    {
+      const std::array<int, OBS_NB_BLOCKS>& blocks = _obsBlocks[o];
+      const CameraBlock& intrinsic = _cameraBlocks[blocks[OBS_INTRINSIC]];
+      const bool isRig = (blocks[OBS_SUBPOSE] >= 0);
+
+      const double* parameters[4] = {
+        cameraValues.data() + intrinsic.valuesOffset,
+        cameraValues.data() + _cameraBlocks[blocks[OBS_POSE]].valuesOffset,
+        isRig ? cameraValues.data() + _cameraBlocks[blocks[OBS_SUBPOSE]].valuesOffset : nullptr,
+        landmarkValues.data() + 3 * l};
+
+      const sfmData::Observation observation(Vec2(_obsX[o], _obsY[o]), UndefinedIndexT, _obsScale[o]);
+      double residuals[2];
+
+      if(!withJacobians)
+      {
+        evaluateObservation(intrinsic, observation, parameters, isRig, residuals, nullptr);
+      }
+      else
+      {
+        double jacobianBuffers[OBS_NB_BLOCKS][2 * maxBlockSize];
+        double pointJacobianBuffer[6];
+        double* jacobians[4] = {nullptr, nullptr, nullptr, nullptr};
+        for(int k = 0; k < OBS_NB_BLOCKS; ++k)
+          if(_obsLocalCams[o][k] >= 0)
+            jacobians[k] = jacobianBuffers[k];
+        if(_landmarkRefined[l])
+          jacobians[3] = pointJacobianBuffer;
+
+        evaluateObservation(intrinsic, observation, parameters, isRig, residuals, jacobians);
+
+        // robust loss: residuals and jacobians are scaled by sqrt(rho'(s)) (same as ceres for the Huber loss)
+        const double s = residuals[0] * residuals[0] + residuals[1] * residuals[1];
+        const double weight = (a > 0.0 && s > b) ? std::sqrt(a / std::sqrt(s)) : 1.0;
+
+        _residuals[o] = Vec2(residuals[0], residuals[1]) * weight;
+
+        for(int k = 0; k < OBS_NB_BLOCKS; ++k)
+        {
+          if(jacobians[k] == nullptr)
+            continue;
+          const CameraBlock& block = _cameraBlocks[blocks[k]];
+          CameraJacobian& J = _cameraJacobians[OBS_NB_BLOCKS * o + k];
+          J = Eigen::Map<const Eigen::Matrix<double, 2, Eigen::Dynamic, Eigen::RowMajor>>(jacobians[k], 2, block.size) * weight;
+
+          if(block.lockFocalRatio)
+          {
+            // fx = fx0 + focalRatio * d, fy = fy0 + d
+            J.col(1) += block.focalRatio * J.col(0);
+            J.col(0).setZero();
+          }
+          for(int i = 0; i < block.size; ++i)
+            if(block.locked[i])
+              J.col(i).setZero();
+        }
+        if(jacobians[3] != nullptr)
+          _pointJacobians[o] = Eigen::Map<const PointJacobian>(pointJacobianBuffer) * weight;
+      }
+
+      const double s = residuals[0] * residuals[0] + residuals[1] * residuals[1];
+      cost += 0.5 * ((a > 0.0 && s > b) ? 2.0 * a * std::sqrt(s) - b : s);
+    }
+  }
+  return cost;
+}
+
+void SchurSolver::buildReducedSystem(double lambda)
+{
+  std::fill(_slotValues.begin(), _slotValues.end(), 0.0);
+  for(std::vector<double>& buffer : _threadBuffers)
+    std::fill(buffer.begin(), buffer.end(), 0.0);
+  _rhs.setZero(_reducedSize);
+  _cameraGradient.setZero(_reducedSize);
+  _cameraDiagonal.setZero(_reducedSize);
+
+  // gradient and diagonal of J^t.J of the camera blocks (parallel over the camera blocks, no concurrent write)
+  #pragma omp parallel for num_threads(_nbThreads) schedule(dynamic)
+  for(int c = 0; c < static_cast<int>(_cameraBlocks.size()); ++c)
+  {
+    const CameraBlock& block = _cameraBlocks[c];
+    if(block.systemOffset < 0)
+      continue;
+    for(const std::size_t j : _blockJacobians[c])
+    {
+      const CameraJacobian& J = _cameraJacobians[j];
+      _cameraGradient.segment(block.systemOffset, block.size) += J.transpose() * _residuals[j / OBS_NB_BLOCKS];
+      _cameraDiagonal.segment(block.systemOffset, block.size) += J.colwise().squaredNorm().transpose();
+    }
+  }
+
+  // landmarks elimination (parallel over the landmarks)
+  const std::int64_t nbLandmarks = static_cast<std::int64_t>(getNbLandmarks());
+
+  #pragma omp parallel num_threads(_nbThreads)
+  {
+    double* threadBuffer = _threadBuffers[omp_get_thread_num()].data();
+    std::vector<CameraPointBlock> W;
+    std::vector<CameraPointBlock> WVinv;
+
+    #pragma omp for schedule(dynamic, 16)
+    for(std::int64_t l = 0; l < nbLandmarks; ++l)
+    {
+      const std::size_t camBegin = _landmarkCamBegin[l];
+      const int m = static_cast<int>(_landmarkCamBegin[l + 1] - camBegin);
+      const std::size_t pairBegin = _landmarkPairBegin[l];
+      const auto pairSlot = [&](int a, int b) { return _landmarkPairSlots[pairBegin + a * m - a * (a - 1) / 2 + (b - a)]; };
+      const bool refined = _landmarkRefined[l];
+
+      W.resize(m);
+      for(int a = 0; a < m; ++a)
+        W[a].setZero(_cameraBlocks[_landmarkCams[camBegin + a]].size, 3);
+
+      Mat3 V = Mat3::Zero();
+      Vec3 gX = Vec3::Zero();
+
+      for(std::size_t o = _landmarkObsBegin[l]; o < _landmarkObsBegin[l + 1]; ++o)
+      {
+        const Vec2& r = _residuals[o];
+        const std::array<int, OBS_NB_BLOCKS>& localCams = _obsLocalCams[o];
+
+        for(int i = 0; i < OBS_NB_BLOCKS; ++i)
+        {
+          const int a = localCams[i];
+          if(a < 0)
+            continue;
+          const CameraJacobian& Ja = _cameraJacobians[OBS_NB_BLOCKS * o + i];
+
+          // camera hessian blocks of the observation
+          for(int j = 0; j < OBS_NB_BLOCKS; ++j)
+          {
+            const int b = localCams[j];
+            if(b < a)
+              continue;
+            const CameraJacobian& Jb = _cameraJacobians[OBS_NB_BLOCKS * o + j];
+            const CameraBlockMatrix U = Ja.transpose() * Jb;
+            addToSlot(pairSlot(a, b), U, false, threadBuffer);
+          }
+          addToRhs(_landmarkCams[camBegin + a], -Ja.transpose() * r, threadBuffer);
+
+          if(refined)
+            W[a].noalias() += Ja.transpose() * _pointJacobians[o];
+        }
+
+        if(refined)
+        {
+          V.noalias() += _pointJacobians[o].transpose() * _pointJacobians[o];
+          gX.noalias() += _pointJacobians[o].transpose() * r;
+        }
+      }
+
+      if(!refined)
+        continue;
+
+      // damped landmark hessian block
+      Vec3 D = V.diagonal().cwiseMax(minDiagonal).cwiseMin(maxDiagonal);
+      Mat3 Vd = V;
+      Vd.diagonal() += lambda * D;
+      const Mat3 Vinv = Vd.inverse();
+
+      _landmarkHessianInv[l] = Vinv;
+      Eigen::Map<Vec3>(_landmarkGradient.data() + 3 * l) = gX;
+      Eigen::Map<Vec3>(_landmarkDiagonal.data() + 3 * l) = D;
+
+      // Schur complement: S -= W.Vinv.W^t, rhs += W.Vinv.gX
+      WVinv.resize(m);
+      for(int a = 0; a < m; ++a)
+      {
+        WVinv[a] = W[a] * Vinv;
+        addToRhs(_landmarkCams[camBegin + a], WVinv[a] * gX, threadBuffer);
+      }
+      for(int a = 0; a < m; ++a)
+        for(int b = a; b < m; ++b)
+        {
+          const CameraBlockMatrix T = -WVinv[a] * W[b].transpose();
+          addToSlot(pairSlot(a, b), T, false, threadBuffer);
+        }
+    }
+  }
+
+  // reduce the per-thread accumulations
+  const std::int64_t threadSize = static_cast<std::int64_t>(_threadRhsOffset);
+  #pragma omp parallel for num_threads(_nbThreads)
+  for(int s = 0; s < static_cast<int>(_slots.size()); ++s)
+  {
+    const SystemSlot& slot = _slots[s];
+    if(slot.threadOffset < 0)
+      continue;
+    const std::size_t size = _cameraBlocks[slot.row].size * _cameraBlocks[slot.col].size;
+    for(const std::vector<double>& buffer : _threadBuffers)
+      for(std::size_t i = 0; i < size; ++i)
+        _slotValues[slot.valuesOffset + i] += buffer[slot.threadOffset + i];
+  }
+  for(const std::vector<double>& buffer : _threadBuffers)
+    _rhs += Eigen::Map<const Eigen::VectorXd>(buffer.data() + threadSize, _reducedSize);
+
+  // camera damping
+  for(int c = 0; c < static_cast<int>(_cameraBlocks.size()); ++c)
+  {
+    const CameraBlock& block = _cameraBlocks[c];
+    if(block.systemOffset < 0)
+      continue;
+    Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> S(_slotValues.data() + _slots[_diagonalSlots[c]].valuesOffset, block.size, block.size);
+    for(int i = 0; i < block.size; ++i)
+    {
+      const bool isConstant = block.locked[i] || (block.lockFocalRatio && i == 0);
+      double& d = _cameraDiagonal(block.systemOffset + i);
+      if(isConstant)
+      {
+        // decoupled parameter: null step
+        S(i, i) = 1.0;
+        d = 0.0;
+        continue;
+      }
+      d = std::min(std::max(d, minDiagonal), maxDiagonal);
+      S(i, i) += lambda * d;
+    }
+  }
+}
+
+void SchurSolver::multiplyReducedSystem(const Eigen::VectorXd& x, Eigen::VectorXd& out_y) const
+{
+  out_y.setZero(_reducedSize);
+
+  #pragma omp parallel for num_threads(_nbThreads) schedule(dynamic)
+  for(int c = 0; c < static_cast<int>(_cameraBlocks.size()); ++c)
+  {
+    const CameraBlock& block = _cameraBlocks[c];
+    if(block.systemOffset < 0)
+      continue;
+    for(const int s : _rowSlots[c])
+    {
+      const SystemSlot& slot = _slots[s];
+      const CameraBlock& rowBlock = _cameraBlocks[slot.row];
+      const CameraBlock& colBlock = _cameraBlocks[slot.col];
+      const Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> S(_slotValues.data() + slot.valuesOffset, rowBlock.size, colBlock.size);
+      if(slot.row == c)
+        out_y.segment(block.systemOffset, block.size) += S * x.segment(colBlock.systemOffset, colBlock.size);
+      else
+        out_y.segment(block.systemOffset, block.size) += S.transpose() * x.segment(rowBlock.systemOffset, rowBlock.size);
+    }
+  }
+}
+
+bool SchurSolver::solveCholesky(Eigen::VectorXd& out_dx) const
+{
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(_slotValues.size());
+
+  for(const SystemSlot& slot : _slots)
+  {
+    const CameraBlock& rowBlock = _cameraBlocks[slot.row];
+    const CameraBlock& colBlock = _cameraBlocks[slot.col];
+    for(int i = 0; i < rowBlock.size; ++i)
+      for(int j = 0; j < colBlock.size; ++j)
+      {
+        const int row = rowBlock.systemOffset + i;
+        const int col = colBlock.systemOffset + j;
+        // lower triangular part
+        if(slot.row != slot.col)
+          triplets.emplace_back(col, row, _slotValues[slot.valuesOffset + i * colBlock.size + j]);
+        else if(row >= col)
+          triplets.emplace_back(row, col, _slotValues[slot.valuesOffset + i * colBlock.size + j]);
+      }
+  }
+
+  Eigen::SparseMatrix<double> S(_reducedSize, _reducedSize);
+  S.setFromTriplets(triplets.begin(), triplets.end());
+
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>, Eigen::Lower> ldlt(S);
+  if(ldlt.info() != Eigen::Success)
+    return false;
+
+  out_dx = ldlt.solve(_rhs);
+  return (ldlt.info() == Eigen::Success) && out_dx.allFinite();
+}
+
+bool SchurSolver::solveConjugateGradient(Eigen::VectorXd& out_dx) const
+{
+  // block Jacobi preconditioner
+  std::vector<CameraBlockMatrix> preconditioner(_cameraBlocks.size());
+  for(int c = 0; c < static_cast<int>(_cameraBlocks.size()); ++c)
+  {
+    const CameraBlock& block = _cameraBlocks[c];
+    if(block.systemOffset < 0)
+      continue;
+    const Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> S(_slotValues.data() + _slots[_diagonalSlots[c]].valuesOffset, block.size, block.size);
+    preconditioner[c] = S.ldlt().solve(CameraBlockMatrix::Identity(block.size, block.size));
+  }
+  const auto applyPreconditioner = [&](const Eigen::VectorXd& r, Eigen::VectorXd& z) {
+    z.resize(_reducedSize);
+    for(int c = 0; c < static_cast<int>(_cameraBlocks.size()); ++c)
+    {
+      const CameraBlock& block = _cameraBlocks[c];
+      if(block.systemOffset >= 0)
+        z.segment(block.systemOffset, block.size) = preconditioner[c] * r.segment(block.systemOffset, block.size);
+    }
+  };
+
+  out_dx.setZero(_reducedSize);
+  Eigen::VectorXd r = _rhs;
+  Eigen::VectorXd z;
+  Eigen::VectorXd q;
+  applyPreconditioner(r, z);
+  Eigen::VectorXd p = z;
+  double rz = r.dot(z);
+  const double rhsNorm = _rhs.norm();
+
+  if(rhsNorm == 0.0)
+    return true;
+
+  for(unsigned int i = 0; i < _options.maxNumLinearSolverIterations; ++i)
+  {
+    multiplyReducedSystem(p, q);
+    const double pq = p.dot(q);
+    if(pq <= 0.0)
+      break;
+    const double alpha = rz / pq;
+    out_dx += alpha * p;
+    r -= alpha * q;
+    if(r.norm() <= _options.linearSolverTolerance * rhsNorm)
+      break;
+    applyPreconditioner(r, z);
+    const double rzNew = r.dot(z);
+    p = z + (rzNew / rz) * p;
+    rz = rzNew;
+  }
+  return out_dx.allFinite();
+}
+
+bool SchurSolver::solveReducedSystem(Eigen::VectorXd& out_dx) const
+{
+  if(_reducedSize == 0)
+  {
+    out_dx.resize(0);
+    return true;
+  }
+  if(_options.linearSolver == BundleAdjustmentSchur::ELinearSolver::CONJUGATE_GRADIENT)
+    return solveConjugateGradient(out_dx);
+  return solveCholesky(out_dx);
+}
+
+void SchurSolver::computeLandmarksStep(const Eigen::VectorXd& cameraStep, std::vector<double>& out_landmarksStep) const
+{
+  const std::int64_t nbLandmarks = static_cast<std::int64_t>(getNbLandmarks());
+  out_landmarksStep.assign(3 * nbLandmarks, 0.0);
+
+  #pragma omp parallel for num_threads(_nbThreads) schedule(dynamic, 64)
+  for(std::int64_t l = 0; l < nbLandmarks; ++l)
+  {
+    if(!_landmarkRefined[l])
+      continue;
+
+    // dX = Vinv.(-gX - W^t.dc)
+    Vec3 b = -Eigen::Map<const Vec3>(_landmarkGradient.data() + 3 * l);
+    for(std::size_t o = _landmarkObsBegin[l]; o < _landmarkObsBegin[l + 1]; ++o)
+    {
+      Eigen::Vector2d Jdc = Eigen::Vector2d::Zero();
+      for(int k = 0; k < OBS_NB_BLOCKS; ++k)
+      {
+        if(_obsLocalCams[o][k] < 0)
+          continue;
+        const CameraBlock& block = _cameraBlocks[_obsBlocks[o][k]];
+        Jdc += _cameraJacobians[OBS_NB_BLOCKS * o + k] * cameraStep.segment(block.systemOffset, block.size);
+      }
+      b -= _pointJacobians[o].transpose() * Jdc;
+    }
+    Eigen::Map<Vec3>(out_landmarksStep.data() + 3 * l) = _landmarkHessianInv[l] * b;
+  }
+}
+
+void SchurSolver::applyStep(const Eigen::VectorXd& cameraStep, const std::vector<double>& landmarksStep,
+                            std::vector<double>& out_cameraValues, std::vector<double>& out_landmarkValues) const
+{
+  out_cameraValues = _cameraValues;
+  for(const CameraBlock& block : _cameraBlocks)
+  {
+    if(block.systemOffset < 0)
+      continue;
+    double* values = out_cameraValues.data() + block.valuesOffset;
+    for(int i = 0; i < block.size; ++i)
+      values[i] += cameraStep(block.systemOffset + i);
+    if(block.lockFocalRatio)
+      values[0] += block.focalRatio * cameraStep(block.systemOffset + 1);
+    for(int i = 0; i < block.size; ++i)
+      values[i] = std::min(std::max(values[i], block.lowerBound[i]), block.upperBound[i]);
+  }
+
+  out_landmarkValues.resize(_landmarkValues.size());
+  for(std::size_t i = 0; i < _landmarkValues.size(); ++i)
+    out_landmarkValues[i] = _landmarkValues[i] + landmarksStep[i];
+}
+
+bool SchurSolver::solve(BundleAdjustmentSchur::Statistics& statistics)
+{
+  setupSystem();
+
+  const std::size_t nbResiduals = 2 * getNbObservations();
+  statistics.nbResidualBlocks = getNbObservations();
+  statistics.reducedSystemSize = _reducedSize;
+
+  double cost = evaluate(_cameraValues, _landmarkValues, true);
+  statistics.RMSEinitial = (nbResiduals > 0) ? std::sqrt(cost / nbResiduals) : 0.0;
+
+  if(!std::isfinite(cost))
+  {
+    ALICEVISION_LOG_WARNING("Bundle Adjustment[Schur]: the initial cost is not finite.");
+    return false;
+  }
+
+  // same initial trust region radius as ceres (lambda = 1 / radius)
+  double lambda = 1e-4;
+  double nu = 2.0;
+
+  Eigen::VectorXd cameraStep;
+  std::vector<double> landmarksStep;
+  std::vector<double> candidateCameraValues;
+  std::vector<double> candidateLandmarkValues;
+
+  for(unsigned int iteration = 0; iteration < _options.maxNumIterations && nbResiduals > 0; ++iteration)
+  {
+    buildReducedSystem(lambda);
+
+    // gradient convergence
+    double maxGradient = _cameraGradient.size() > 0 ? _cameraGradient.lpNorm<Eigen::Infinity>() : 0.0;
+    for(std::size_t l = 0; l < getNbLandmarks(); ++l)
+      if(_landmarkRefined[l])
+        maxGradient = std::max(maxGradient, Eigen::Map<const Vec3>(_landmarkGradient.data() + 3 * l).lpNorm<Eigen::Infinity>());
+    if(maxGradient <= _options.gradientTolerance)
+      break;
+
+    if(!solveReducedSystem(cameraStep))
+    {
+      ++statistics.nbUnsuccessfullIterations;
+      lambda *= nu;
+      nu *= 2.0;
+      continue;
+    }
+    computeLandmarksStep(cameraStep, landmarksStep);
+
+    // predicted decrease of the linear model: 0.5 * dx^t.(lambda.D.dx - g)
+    double predictedDecrease = 0.0;
+    for(int i = 0; i < cameraStep.size(); ++i)
+      predictedDecrease += cameraStep(i) * (lambda * _cameraDiagonal(i) * cameraStep(i) - _cameraGradient(i));
+    for(std::size_t i = 0; i < landmarksStep.size(); ++i)
+      predictedDecrease += landmarksStep[i] * (lambda * _landmarkDiagonal[i] * landmarksStep[i] - _landmarkGradient[i]);
+    predictedDecrease *= 0.5;
+
+    // parameters convergence
+    double stepNorm2 = cameraStep.squaredNorm();
+    double paramNorm2 = Eigen::Map<const Eigen::VectorXd>(_cameraValues.data(), _cameraValues.size()).squaredNorm();
+    for(std::size_t l = 0; l < getNbLandmarks(); ++l)
+    {
+      if(!_landmarkRefined[l])
+        continue;
+      stepNorm2 += Eigen::Map<const Vec3>(landmarksStep.data() + 3 * l).squaredNorm();
+      paramNorm2 += Eigen::Map<const Vec3>(_landmarkValues.data() + 3 * l).squaredNorm();
+    }
+    if(std::sqrt(stepNorm2) <= _options.parameterTolerance * (std::sqrt(paramNorm2) + _options.parameterTolerance))
+      break;
+
+    applyStep(cameraStep, landmarksStep, candidateCameraValues, candidateLandmarkValues);
+    const double candidateCost = evaluate(candidateCameraValues, candidateLandmarkValues, false);
+    const double rho = (predictedDecrease > 0.0 && std::isfinite(candidateCost)) ? (cost - candidateCost) / predictedDecrease : -1.0;
+
+    if(_options.verbose)
+      ALICEVISION_LOG_DEBUG("Bundle Adjustment[Schur]: iteration " << iteration << ", cost: " << cost
+                            << ", candidate cost: " << candidateCost << ", lambda: " << lambda);
+
+    if(rho <= 0.0)
+    {
+      // reject the step and increase the damping
+      ++statistics.nbUnsuccessfullIterations;
+      lambda *= nu;
+      nu *= 2.0;
+      continue;
+    }
+
+    ++statistics.nbSuccessfullIterations;
+    const double costDecrease = cost - candidateCost;
+    _cameraValues.swap(candidateCameraValues);
+    _landmarkValues.swap(candidateLandmarkValues);
+    cost = evaluate(_cameraValues, _landmarkValues, true);
+    lambda *= std::max(1.0 / 3.0, 1.0 - std::pow(2.0 * rho - 1.0, 3));
+    nu = 2.0;
+
+    if(costDecrease <= _options.functionTolerance * cost)
+      break;
+  }
+
+  statistics.RMSEfinal = (nbResiduals > 0) ? std::sqrt(cost / nbResiduals) : 0.0;
+  return std::isfinite(cost);
+}
+
+} // namespace
+
+void BundleAdjustmentSchur::Statistics::show() const
+{
+  std::map<EParameter, std::map<EParameterState, std::size_t>> states = parametersStates;
+
+  ALICEVISION_LOG_INFO("Bundle Adjustment[Schur] Statistics:\n"
+                        << "\t- local strategy enabled: " << (nbCamerasPerDistance.empty() ? "no" : "yes") << "\n"
+                        << "\t- adjustment duration: " << time << " s\n"
+                        << "\t- poses:\n"
+                        << "\t    - # refined:  " << states[EParameter::POSE][EParameterState::REFINED]  << "\n"
+                        << "\t    - # constant: " << states[EParameter::POSE][EParameterState::CONSTANT] << "\n"
+                        << "\t    - # ignored:  " << states[EParameter::POSE][EParameterState::IGNORED]  << "\n"
+                        << "\t- landmarks:\n"
+                        << "\t    - # refined:  " << states[EParameter::LANDMARK][EParameterState::REFINED]  << "\n"
+                        << "\t    - # constant: " << states[EParameter::LANDMARK][EParameterState::CONSTANT] << "\n"
+                        << "\t    - # ignored:  " << states[EParameter::LANDMARK][EParameterState::IGNORED]  << "\n"
+                        << "\t- intrinsics:\n"
+                        << "\t    - # refined:  " << states[EParameter::INTRINSIC][EParameterState::REFINED]  << "\n"
+                        << "\t    - # constant: " << states[EParameter::INTRINSIC][EParameterState::CONSTANT] << "\n"
+                        << "\t    - # ignored:  " << states[EParameter::INTRINSIC][EParameterState::IGNORED]  << "\n"
+                        << "\t- # residual blocks: " << nbResidualBlocks << "\n"
+                        << "\t- reduced camera system size: " << reducedSystemSize << "\n"
+                        << "\t- # successful iterations: " << nbSuccessfullIterations   << "\n"
+                        << "\t- # unsuccessful iterations: " << nbUnsuccessfullIterations << "\n"
+                        << "\t- initial RMSE: " << RMSEinitial << "\n"
+                        << "\t- final   RMSE: " << RMSEfinal);
+}
+
+bool BundleAdjustmentSchur::adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions)
+{
+  // ensure we are not using incompatible options
+  assert(!((refineOptions & REFINE_INTRINSICS_OPTICALOFFSET_ALWAYS) && (refineOptions & REFINE_INTRINSICS_OPTICALOFFSET_IF_ENOUGH_DATA)));
+
+  const system::Timer timer;
+  _statistics = Statistics();
+
+  const auto getPoseState = [&](IndexT poseId) {
+    return (_localGraph != nullptr ? _localGraph->getPoseState(poseId) : EParameterState::REFINED);
+  };
+  const auto getIntrinsicState = [&](IndexT intrinsicId) {
+    return (_localGraph != nullptr ? _localGraph->getIntrinsicState(intrinsicId) : EParameterState::REFINED);
+  };
+  const auto getLandmarkState = [&](IndexT landmarkId) {
+    return (_localGraph != nullptr ? _localGraph->getLandmarkState(landmarkId) : EParameterState::REFINED);
+  };
+
+  if(!sfmData.getConstraints2D().empty() || !sfmData.getRotationPriors().empty())
+    ALICEVISION_LOG_WARNING("Bundle Adjustment[Schur]: 2D constraints and rotation priors are not supported, they are ignored.");
+
+  SchurSolver solver(_options);
+
+  // extrinsics
+  const bool refineTranslation = refineOptions & REFINE_TRANSLATION;
+  const bool refineRotation = refineOptions & REFINE_ROTATION;
+
+  const auto addPose = [&](const geometry::Pose3& pose, bool isConstant) {
+    CameraBlock block;
+    block.isPose = true;
+    block.size = 6;
+
+    std::array<double, 6> values;
+    const Vec3 angleAxis = rotationToAngleAxis(pose.rotation());
+    const Vec3& t = pose.translation();
+    for(int i = 0; i < 3; ++i)
+    {
+      values[i] = angleAxis(i);
+      values[3 + i] = t(i);
+    }
+
+    if(isConstant || (!refineTranslation && !refineRotation))
+    {
+      _statistics.addState(EParameter::POSE, EParameterState::CONSTANT);
+    }
+    else
+    {
+      block.systemOffset = 0;
+      for(int i = 0; i < 3; ++i)
+      {
+        block.locked[i] = !refineRotation;
+        block.locked[3 + i] = !refineTranslation;
+      }
+      _statistics.addState(EParameter::POSE, EParameterState::REFINED);
+    }
+    return solver.addCameraBlock(block, values.data());
+  };
+
+  std::map<IndexT, int> poseBlocks;
+  for(const auto& posePair : sfmData.getPoses())
+  {
+    const IndexT poseId = posePair.first;
+    const sfmData::CameraPose& pose = posePair.second;
+
+    if(getPoseState(poseId) == EParameterState::IGNORED)
+    {
+      _statistics.addState(EParameter::POSE, EParameterState::IGNORED);
+      continue;
+    }
+    poseBlocks[poseId] = addPose(pose.getTransform(), pose.isLocked() || getPoseState(poseId) == EParameterState::CONSTANT);
+  }
+
+  std::map<IndexT, std::map<IndexT, int>> subPoseBlocks;
+  for(const auto& rigPair : sfmData.getRigs())
+  {
+    const sfmData::Rig& rig = rigPair.second;
+    for(std::size_t subPoseId = 0; subPoseId < rig.getNbSubPoses(); ++subPoseId)
+    {
+      const sfmData::RigSubPose& rigSubPose = rig.getSubPose(subPoseId);
+      if(rigSubPose.status == sfmData::ERigSubPoseStatus::UNINITIALIZED)
+        continue;
+      subPoseBlocks[rigPair.first][subPoseId] = addPose(rigSubPose.pose, rigSubPose.status == sfmData::ERigSubPoseStatus::CONSTANT);
+    }
+  }
+
+  // intrinsics
+  const bool refineIntrinsicsOpticalCenter = (refineOptions & REFINE_INTRINSICS_OPTICALOFFSET_ALWAYS) || (refineOptions & REFINE_INTRINSICS_OPTICALOFFSET_IF_ENOUGH_DATA);
+  const bool refineIntrinsicsFocalLength = refineOptions & REFINE_INTRINSICS_FOCAL;
+  const bool refineIntrinsicsDistortion = refineOptions & REFINE_INTRINSICS_DISTORTION;
+  const bool refineIntrinsics = refineIntrinsicsDistortion || refineIntrinsicsFocalLength || refineIntrinsicsOpticalCenter;
+
+  std::map<IndexT, std::size_t> intrinsicsUsage;
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    const sfmData::View& view = *(viewPair.second);
+    std::size_t& usage = intrinsicsUsage[view.getIntrinsicId()];
+    if(sfmData.isPoseAndIntrinsicDefined(&view))
+      ++usage;
+  }
+
+  std::map<IndexT, int> intrinsicBlocks;
+  for(const auto& intrinsicPair : sfmData.getIntrinsics())
+  {
+    const IndexT intrinsicId = intrinsicPair.first;
+    const auto& intrinsicPtr = intrinsicPair.second;
+    const auto usageIt = intrinsicsUsage.find(intrinsicId);
+    if(usageIt == intrinsicsUsage.end())
+      continue;
+    const std::size_t usageCount = usageIt->second;
+
+    if(usageCount <= 0 || getIntrinsicState(intrinsicId) == EParameterState::IGNORED)
+    {
+      _statistics.addState(EParameter::INTRINSIC, EParameterState::IGNORED);
+      continue;
+    }
+
+    const std::vector<double> params = intrinsicPtr->getParams();
+
+    // only the parameters used by the reprojection residual are stored, the others are not observable
+    CameraBlock block;
+    block.type = intrinsicPtr->getType();
+    block.size = getNbResidualIntrinsicParams(block.type);
+    block.width = static_cast<int>(intrinsicPtr->w());
+    block.height = static_cast<int>(intrinsicPtr->h());
+
+    if(intrinsicPtr->isLocked() || !refineIntrinsics || getIntrinsicState(intrinsicId) == EParameterState::CONSTANT)
+    {
+      _statistics.addState(EParameter::INTRINSIC, EParameterState::CONSTANT);
+      intrinsicBlocks[intrinsicId] = solver.addCameraBlock(block, params.data());
+      continue;
+    }
+
+    block.systemOffset = 0;
+
+    // focal length
+    if(refineIntrinsicsFocalLength)
+    {
+      const std::shared_ptr<camera::IntrinsicScaleOffset> intrinsicScaleOffset = std::dynamic_pointer_cast<camera::IntrinsicScaleOffset>(intrinsicPtr);
+      if(intrinsicScaleOffset->getInitialScale().x() > 0 && intrinsicScaleOffset->getInitialScale().y() > 0)
+      {
+        // if we have an initial guess, we only authorize a margin around this value.
+        const unsigned int maxFocalError = 0.2 * std::max(intrinsicPtr->w(), intrinsicPtr->h());
+        block.lowerBound[0] = static_cast<double>(intrinsicScaleOffset->getInitialScale().x() - maxFocalError);
+        block.upperBound[0] = static_cast<double>(intrinsicScaleOffset->getInitialScale().x() + maxFocalError);
+        block.lowerBound[1] = static_cast<double>(intrinsicScaleOffset->getInitialScale().y() - maxFocalError);
+        block.upperBound[1] = static_cast<double>(intrinsicScaleOffset->getInitialScale().y() + maxFocalError);
+      }
+      else
+      {
+        // converging lens: the focal length should be positive.
+        block.lowerBound[0] = 0.0;
+        block.lowerBound[1] = 0.0;
+      }
+      block.lockFocalRatio = intrinsicScaleOffset->isRatioLocked();
+      block.focalRatio = params[0] / params[1];
+    }
+    else
+    {
+      block.locked[0] = true;
+      block.locked[1] = true;
+    }
+
+    // optical center
+    if((refineOptions & REFINE_INTRINSICS_OPTICALOFFSET_ALWAYS) ||
+       ((refineOptions & REFINE_INTRINSICS_OPTICALOFFSET_IF_ENOUGH_DATA) && _minNbImagesToRefineOpticalCenter > 0 && usageCount >= _minNbImagesToRefineOpticalCenter))
+    {
+      // refine optical center within 10% of the image size.
+      block.lowerBound[2] = -0.05 * intrinsicPtr->w();
+      block.upperBound[2] = 0.05 * intrinsicPtr->w();
+      block.lowerBound[3] = -0.05 * intrinsicPtr->h();
+      block.upperBound[3] = 0.05 * intrinsicPtr->h();
+    }
+    else
+    {
+      block.locked[2] = true;
+      block.locked[3] = true;
+    }
+
+    // lens distortion
+    if(!refineIntrinsicsDistortion || intrinsicPtr->getDistortionInitializationMode() == camera::EInitMode::CALIBRATED)
+    {
+      for(int i = 4; i < block.size; ++i)
+        block.locked[i] = true;
+    }
+
+    _statistics.addState(EParameter::INTRINSIC, EParameterState::REFINED);
+    intrinsicBlocks[intrinsicId] = solver.addCameraBlock(block, params.data());
+  }
+
+  // landmarks and observations
+  const bool refineStructure = refineOptions & REFINE_STRUCTURE;
+  std::vector<IndexT> landmarkIds;
+  landmarkIds.reserve(sfmData.getLandmarks().size());
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    const IndexT landmarkId = landmarkPair.first;
+    const sfmData::Landmark& landmark = landmarkPair.second;
+
+    if(getLandmarkState(landmarkId) == EParameterState::IGNORED)
+    {
+      _statistics.addState(EParameter::LANDMARK, EParameterState::IGNORED);
+      continue;
+    }
+
+    const bool refined = refineStructure && getLandmarkState(landmarkId) != EParameterState::CONSTANT;
+    _statistics.addState(EParameter::LANDMARK, refined ? EParameterState::REFINED : EParameterState::CONSTANT);
+
+    solver.addLandmark(landmark.X, refined);
+    landmarkIds.push_back(landmarkId);
+
+    for(const auto& observationPair : landmark.observations)
+    {
+      const sfmData::View& view = sfmData.getView(observationPair.first);
+      const sfmData::Observation& observation = observationPair.second;
+      const IntrinsicBase* intrinsicPtr = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+
+      // apply undistortion to observation
+      Vec2 pt = observation.x;
+      const camera::IntrinsicScaleOffsetDisto* intrinsicDistortionPtr = dynamic_cast<const camera::IntrinsicScaleOffsetDisto*>(intrinsicPtr);
+      if(intrinsicDistortionPtr && intrinsicDistortionPtr->getUndistortion())
+        pt = intrinsicDistortionPtr->getUndistortion()->undistort(observation.x);
+
+      const bool isRig = view.isPartOfRig() && !view.isPoseIndependant();
+      solver.addObservation(pt, observation.scale,
+                            intrinsicBlocks.at(view.getIntrinsicId()),
+                            poseBlocks.at(view.getPoseId()),
+                            isRig ? subPoseBlocks.at(view.getRigId()).at(view.getSubPoseId()) : -1);
+    }
+  }
+
+  // solve
+  const bool success = solver.solve(_statistics);
+
+  if(!success)
+  {
+    ALICEVISION_LOG_WARNING("Bundle Adjustment[Schur] failed, the solution is not usable.");
+    return false;
+  }
+
+  // update the sfmData with the solution
+  const bool refinePoses = refineRotation || refineTranslation;
+  if(refinePoses)
+  {
+    for(const auto& posePair : poseBlocks)
+    {
+      if(getPoseState(posePair.first) != EParameterState::REFINED)
+        continue;
+      const double* values = solver.getCameraValues(posePair.second);
+      sfmData.getPoses().at(posePair.first).setTransform(geometry::poseFromRT(angleAxisToRotation(values), Vec3(values[3], values[4], values[5])));
+    }
+    for(const auto& rigPair : subPoseBlocks)
+    {
+      sfmData::Rig& rig = sfmData.getRigs().at(rigPair.first);
+      for(const auto& subPosePair : rigPair.second)
+      {
+        const double* values = solver.getCameraValues(subPosePair.second);
+        rig.getSubPose(subPosePair.first).pose = geometry::poseFromRT(angleAxisToRotation(values), Vec3(values[3], values[4], values[5]));
+      }
+    }
+  }
+
+  if(refineIntrinsics)
+  {
+    for(const auto& intrinsicPair : intrinsicBlocks)
+    {
+      if(getIntrinsicState(intrinsicPair.first) != EParameterState::REFINED)
+        continue;
+      std::shared_ptr<IntrinsicBase> intrinsicPtr = sfmData.getIntrinsics().at(intrinsicPair.first);
+      const double* values = solver.getCameraValues(intrinsicPair.second);
+      std::vector<double> params = intrinsicPtr->getParams();
+      std::copy(values, values + getNbResidualIntrinsicParams(intrinsicPtr->getType()), params.begin());
+      intrinsicPtr->updateFromParams(params);
+    }
+  }
+
+  if(refineStructure)
+  {
+    for(std::size_t i = 0; i < landmarkIds.size(); ++i)
+    {
+      if(getLandmarkState(landmarkIds[i]) != EParameterState::REFINED)
+        continue;
+      const double* values = solver.getLandmarkValues(i);
+      sfmData.getLandmarks().at(landmarkIds[i]).X = Vec3(values[0], values[1], values[2]);
+    }
+  }
+
+  _statistics.time = timer.elapsed();
+  if(useLocalStrategy())
+    _statistics.nbCamerasPerDistance = _localGraph->getDistancesHistogram();
+
+  if(_options.verbose)
+    _statistics.show();
+
+  return true;
+}
+
+} // namespace sfm
+} // namespace aliceVision
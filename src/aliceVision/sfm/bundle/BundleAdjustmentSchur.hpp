@@ -0,0 +1,183 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/sfm/bundle/BundleAdjustment.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace aliceVision {
+
+namespace sfmData {
+class SfMData;
+} // namespace sfmData
+
+namespace sfm {
+
+class LocalBundleAdjustmentGraph;
+
+/**
+ * @brief Bundle adjustment specialized for the camera / landmark structure of the SfMData.
+ *
+ * Levenberg-Marquardt solver without any generic problem:
+ *  - observations are stored per landmark in structure of arrays with fixed-size jacobian blocks,
+ *  - landmarks are eliminated with an explicit Schur complement, computed in parallel per landmark,
+ *  - the reduced camera system (poses, rig sub-poses and intrinsics) is solved with a sparse Cholesky
+ *    factorization or a block Jacobi preconditioned conjugate gradient.
+ *
+ * It uses the same parameterization, refine options, parameter bounds and local strategy states
+ * as BundleAdjustmentCeres, with a Huber loss on the reprojection errors.
+ * 2D constraints and rotation priors are not supported.
+ */
+class BundleAdjustmentSchur : public BundleAdjustment
+{
+public:
+
+  /**
+   * @brief Linear solver of the reduced camera system.
+   */
+  enum class ELinearSolver
+  {
+    SPARSE_CHOLESKY = 0,
+    CONJUGATE_GRADIENT
+  };
+
+  /**
+   * @brief Contains all solver parameters.
+   */
+  struct SchurOptions
+  {
+    SchurOptions(bool verbose = true, bool multithreaded = true, unsigned int maxIterations = 50)
+      : verbose(verbose)
+      , nbThreads(multithreaded ? omp_get_max_threads() : 1) // set number of threads, 1 if OpenMP is not enabled
+      , maxNumIterations(maxIterations)
+    {}
+
+    bool verbose = true;
+    unsigned int nbThreads;
+    unsigned int maxNumIterations;
+    ELinearSolver linearSolver = ELinearSolver::SPARSE_CHOLESKY;
+    /// Huber loss parameter on the reprojection error (same as the BundleAdjustmentCeres loss), 0 to disable the robust loss
+    double lossScale = Square(4.0);
+    /// stop when the relative decrease of the cost is below this threshold
+    double functionTolerance = 1e-6;
+    /// stop when the max norm of the gradient is below this threshold
+    double gradientTolerance = 1e-10;
+    /// stop when the relative norm of the step is below this threshold
+    double parameterTolerance = 1e-8;
+    /// maximum number of conjugate gradient iterations per step
+    unsigned int maxNumLinearSolverIterations = 500;
+    /// relative residual norm of the conjugate gradient solution
+    double linearSolverTolerance = 1e-6;
+  };
+
+  /**
+   * @brief Contains all informations related to the performed bundle adjustment.
+   */
+  struct Statistics
+  {
+    /**
+     * @brief Add a parameter state
+     * @param[in] parameter A bundle adjustment parameter
+     * @param[in] state A bundle adjustment state
+     */
+    inline void addState(EParameter parameter, EParameterState state)
+    {
+      ++parametersStates[parameter][state];
+    }
+
+    /**
+     * @brief Display statistics about bundle adjustment in the terminal
+     *  Logger need to accept <info> log level
+     */
+    void show() const;
+
+    /// number of successful iterations
+    std::size_t nbSuccessfullIterations = 0;
+    /// number of unsuccessful iterations
+    std::size_t nbUnsuccessfullIterations = 0;
+    /// number of reprojection residual blocks
+    std::size_t nbResidualBlocks = 0;
+    /// size of the reduced camera system
+    std::size_t reducedSystemSize = 0;
+    /// RMSEinitial: sqrt(initial_cost / num_residuals)
+    double RMSEinitial = 0.0;
+    /// RMSEfinal: sqrt(final_cost / num_residuals)
+    double RMSEfinal = 0.0;
+    /// time spent to solve the BA (s)
+    double time = 0.0;
+    /// number of states per parameter
+    std::map<EParameter, std::map<EParameterState, std::size_t>> parametersStates;
+    /// The distribution of the cameras for each graph distance <distance, numOfCam>
+    std::map<int, std::size_t> nbCamerasPerDistance;
+  };
+
+  /**
+   * @brief Bundle adjustment constructor
+   * @param[in] options The solver options
+   * @param[in] minNbImagesToRefineOpticalCenter The minimum number of images to refine the optical center
+   *            with REFINE_INTRINSICS_OPTICALOFFSET_IF_ENOUGH_DATA
+   */
+  BundleAdjustmentSchur(const SchurOptions& options = SchurOptions(), int minNbImagesToRefineOpticalCenter = 3)
+    : _options(options)
+    , _minNbImagesToRefineOpticalCenter(minNbImagesToRefineOpticalCenter)
+  {}
+
+  /**
+   * @brief Perform a Bundle Adjustment on the SfM scene with refinement of the requested parameters
+   * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in] refineOptions The chosen refine flag
+   * @return false if the bundle adjustment failed else true
+   * @see BundleAdjustment::Adjust
+   */
+  bool adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions = REFINE_ALL) override;
+
+  /**
+   * @brief Ajust parameters according to the local reconstruction graph
+   * @param[in] localGraph The Local bundle adjustment graph pointer or nullptr (will refine everything)
+   */
+  inline void useLocalStrategyGraph(const std::shared_ptr<const LocalBundleAdjustmentGraph>& localGraph)
+  {
+    _localGraph = localGraph;
+  }
+
+  /**
+   * @brief Return true if the bundle adjustment use an external local graph
+   */
+  inline bool useLocalStrategy() const
+  {
+    return (_localGraph != nullptr);
+  }
+
+  /**
+   * @brief Get bundle adjustment statistics structure
+   */
+  inline const Statistics& getStatistics() const
+  {
+    return _statistics;
+  }
+
+private:
+
+  /// use or not the local budle adjustment strategy
+  std::shared_ptr<const LocalBundleAdjustmentGraph> _localGraph = nullptr;
+
+  /// user solver options
+  SchurOptions _options;
+  int _minNbImagesToRefineOpticalCenter = 3;
+
+  /// last adjustment statisics
+  Statistics _statistics;
+};
+
+} // namespace sfm
+} // namespace aliceVision
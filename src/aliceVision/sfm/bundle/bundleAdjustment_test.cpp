@@ -6,12 +6,15 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorAnalyticCostFunction.hpp>
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/multiview/NViewDataSet.hpp>
 
 #include <cmath>
 #include <cstdio>
 #include <iostream>
+#include <random>
 
 #define BOOST_TEST_MODULE bundleAdjustment
 
@@ -28,6 +31,48 @@ double RMSE(const SfMData& sfmData);
 
 SfMData getInputScene(const NViewDataSet& d, const NViewDatasetConfigurator& config, EINTRINSIC eintrinsic);
 
+void checkAnalyticCostFunction(ceres::CostFunction& analyticCostFunction,
+                               ceres::CostFunction& autoDiffCostFunction,
+                               const std::vector<std::vector<double>>& parameterBlocks);
+
+template <typename FunctorT, typename DistortionT, int IntrinsicsSize>
+void checkAnalyticCostFunctions(const std::vector<double>& intrinsics)
+{
+  const Observation observation(Vec2(1010.0, 730.0), 0, 2.0);
+  const int w = 2000;
+  const int h = 1500;
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(-0.3, 0.3);
+
+  for(int i = 0; i < 10; ++i)
+  {
+    std::vector<double> pose(6);
+    std::vector<double> subpose(6);
+    for(double& v : pose)
+      v = distribution(generator);
+    for(double& v : subpose)
+      v = distribution(generator);
+    pose[5] += 2.0;
+    const std::vector<double> point = {distribution(generator), distribution(generator), 1.0 + distribution(generator)};
+
+    // also check the small angle rotation approximation
+    if(i == 0)
+      std::fill(pose.begin(), pose.begin() + 3, 0.0);
+
+    {
+      ResidualErrorAnalyticCostFunction<DistortionT> analyticCostFunction(w, h, observation);
+      ceres::AutoDiffCostFunction<FunctorT, 2, IntrinsicsSize, 6, 3> autoDiffCostFunction(new FunctorT(w, h, observation));
+      checkAnalyticCostFunction(analyticCostFunction, autoDiffCostFunction, {intrinsics, pose, point});
+    }
+    {
+      ResidualErrorRigAnalyticCostFunction<DistortionT> analyticCostFunction(w, h, observation);
+      ceres::AutoDiffCostFunction<FunctorT, 2, IntrinsicsSize, 6, 6, 3> autoDiffCostFunction(new FunctorT(w, h, observation));
+      checkAnalyticCostFunction(analyticCostFunction, autoDiffCostFunction, {intrinsics, pose, subpose, point});
+    }
+  }
+}
+
 // Test summary:
 // - Create a SfMData scene from a synthetic dataset
 //   - since random noise have been added on 2d data point (initial residual is not small)
@@ -135,6 +180,143 @@ BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_EffectiveMinimization_PinholeFisheye)
   BOOST_CHECK_LT(dResidual_after, dResidual_before);
 }
 
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_EffectiveMinimization_PinholeRadialK3_AutoDiff)
+{
+  const int nviews = 3;
+  const int npoints = 6;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  const double dResidual_before = RMSE(sfmData);
+
+  // Call the BA interface with the automatic differentiation cost functions
+  BundleAdjustmentCeres::CeresOptions options;
+  options.useAnalyticJacobians = false;
+  std::shared_ptr<BundleAdjustment> ba_object = std::make_shared<BundleAdjustmentCeres>(options);
+  BOOST_CHECK( ba_object->adjust(sfmData) );
+
+  const double dResidual_after = RMSE(sfmData);
+  BOOST_CHECK_LT(dResidual_after, dResidual_before);
+}
+
+// Test summary:
+// - Adjust a scene with a persistent ceres problem
+// - Remove a landmark and some observations, then adjust again with the same problem
+// - Check that the residual decreases and that the problem only contains the remaining observations
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_PersistentProblem)
+{
+  const int nviews = 6;
+  const int npoints = 32;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  BundleAdjustmentCeres::CeresOptions options;
+  options.persistentProblem = true;
+  BundleAdjustmentCeres ba(options);
+
+  const double dResidual_before = RMSE(sfmData);
+  BOOST_CHECK( ba.adjust(sfmData) );
+  const double dResidual_after = RMSE(sfmData);
+  BOOST_CHECK_LT(dResidual_after, dResidual_before);
+
+  // remove a landmark and the observations of the first view on some other landmarks
+  sfmData.getLandmarks().erase(sfmData.getLandmarks().begin());
+  int nbRemovedObservations = 0;
+  for(auto& landmarkPair : sfmData.getLandmarks())
+  {
+    if(nbRemovedObservations < 5 && landmarkPair.second.observations.erase(0))
+      ++nbRemovedObservations;
+    landmarkPair.second.X += Vec3(0.01, -0.02, 0.01);
+  }
+
+  std::size_t nbObservations = 0;
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+    nbObservations += landmarkPair.second.observations.size();
+
+  const double dResidual_beforeUpdate = RMSE(sfmData);
+  BOOST_CHECK( ba.adjust(sfmData) );
+  BOOST_CHECK_LT(RMSE(sfmData), dResidual_beforeUpdate);
+  BOOST_CHECK_EQUAL(ba.getStatistics().nbResidualBlocks, 2 * nbObservations);
+}
+
+// Test summary:
+// - Same as the effective minimization tests with the Schur complement bundle adjustment engine
+// - Check both linear solvers of the reduced camera system
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Schur_EffectiveMinimization_PinholeRadialK3)
+{
+  const int nviews = 3;
+  const int npoints = 6;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  const double dResidual_before = RMSE(sfmData);
+
+  // Call the BA interface and let it make the optimization
+  std::shared_ptr<BundleAdjustment> ba_object = std::make_shared<BundleAdjustmentSchur>();
+  BOOST_CHECK( ba_object->adjust(sfmData) );
+
+  const double dResidual_after = RMSE(sfmData);
+  BOOST_CHECK_LT(dResidual_after, dResidual_before);
+}
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Schur_EffectiveMinimization_PinholeBrownT2_ConjugateGradient)
+{
+  const int nviews = 12;
+  const int npoints = 30;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_BROWN);
+
+  const double dResidual_before = RMSE(sfmData);
+
+  // Call the BA interface with the iterative linear solver
+  BundleAdjustmentSchur::SchurOptions options;
+  options.linearSolver = BundleAdjustmentSchur::ELinearSolver::CONJUGATE_GRADIENT;
+  BundleAdjustmentSchur ba(options);
+  BOOST_CHECK( ba.adjust(sfmData) );
+
+  const double dResidual_after = RMSE(sfmData);
+  BOOST_CHECK_LT(dResidual_after, dResidual_before);
+  BOOST_CHECK_EQUAL(ba.getStatistics().nbResidualBlocks, nviews * npoints);
+}
+
+// Test summary:
+// - Evaluate the analytic cost functions and the automatic differentiation cost functions
+//   for random poses and 3D points
+// - Check that residuals and jacobians are the same for all the camera models (single camera and rig)
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_AnalyticJacobians)
+{
+  const std::vector<double> pinhole = {1900.0, 1950.0, 3.0, -4.0};
+  auto withDistortion = [&](const std::vector<double>& distortion) {
+    std::vector<double> params = pinhole;
+    params.insert(params.end(), distortion.begin(), distortion.end());
+    return params;
+  };
+
+  checkAnalyticCostFunctions<ResidualErrorFunctor_Pinhole, analytic::DistortionNone, 4>(pinhole);
+  checkAnalyticCostFunctions<ResidualErrorFunctor_PinholeRadialK1, analytic::DistortionRadialK1, 5>(withDistortion({0.05}));
+  checkAnalyticCostFunctions<ResidualErrorFunctor_PinholeRadialK3, analytic::DistortionRadialK3, 7>(withDistortion({0.05, -0.02, 0.01}));
+  checkAnalyticCostFunctions<ResidualErrorFunctor_PinholeBrownT2, analytic::DistortionBrownT2, 9>(withDistortion({0.05, -0.02, 0.01, 0.001, -0.002}));
+  checkAnalyticCostFunctions<ResidualErrorFunctor_PinholeFisheye, analytic::DistortionFisheye, 8>(withDistortion({0.05, -0.02, 0.01, 0.003}));
+  checkAnalyticCostFunctions<ResidualErrorFunctor_PinholeFisheye1, analytic::DistortionFisheye1, 5>(withDistortion({0.9}));
+  checkAnalyticCostFunctions<ResidualErrorFunctor_Pinhole3DEClassicLD, analytic::Distortion3DEClassicLD, 9>(withDistortion({0.05, 0.3, 0.01, -0.02, 0.004}));
+  checkAnalyticCostFunctions<ResidualErrorFunctor_Pinhole3DERadial4, analytic::Distortion3DERadial4, 10>(withDistortion({0.05, -0.02, 0.001, 0.002, -0.003, 0.004}));
+}
+
 BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_CamerasRing)
 {
   const int nviews = 4;
@@ -240,6 +422,41 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   BOOST_CHECK_LT(dResidual_after, dResidual_before);
 }
 
+void checkAnalyticCostFunction(ceres::CostFunction& analyticCostFunction,
+                               ceres::CostFunction& autoDiffCostFunction,
+                               const std::vector<std::vector<double>>& parameterBlocks)
+{
+  std::vector<const double*> parameters;
+  std::vector<std::vector<double>> analyticJacobians;
+  std::vector<std::vector<double>> autoDiffJacobians;
+  for(const std::vector<double>& block : parameterBlocks)
+  {
+    parameters.push_back(block.data());
+    analyticJacobians.emplace_back(2 * block.size());
+    autoDiffJacobians.emplace_back(2 * block.size());
+  }
+
+  std::vector<double*> analyticJacobiansPtr;
+  std::vector<double*> autoDiffJacobiansPtr;
+  for(std::size_t i = 0; i < parameterBlocks.size(); ++i)
+  {
+    analyticJacobiansPtr.push_back(analyticJacobians[i].data());
+    autoDiffJacobiansPtr.push_back(autoDiffJacobians[i].data());
+  }
+
+  double analyticResiduals[2];
+  double autoDiffResiduals[2];
+  BOOST_CHECK(analyticCostFunction.Evaluate(parameters.data(), analyticResiduals, analyticJacobiansPtr.data()));
+  BOOST_CHECK(autoDiffCostFunction.Evaluate(parameters.data(), autoDiffResiduals, autoDiffJacobiansPtr.data()));
+
+  BOOST_CHECK_SMALL(analyticResiduals[0] - autoDiffResiduals[0], 1e-9);
+  BOOST_CHECK_SMALL(analyticResiduals[1] - autoDiffResiduals[1], 1e-9);
+
+  for(std::size_t i = 0; i < parameterBlocks.size(); ++i)
+    for(std::size_t j = 0; j < analyticJacobians[i].size(); ++j)
+      BOOST_CHECK_SMALL(analyticJacobians[i][j] - autoDiffJacobians[i][j], 1e-6 * std::max(1.0, std::abs(autoDiffJacobians[i][j])));
+}
+
 /// Compute the Root Mean Square Error of the residuals
 double RMSE(const SfMData & sfm_data)
 {
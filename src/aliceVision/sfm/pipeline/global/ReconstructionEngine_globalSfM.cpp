@@ -6,6 +6,8 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "ReconstructionEngine_globalSfM.hpp"
+#include <aliceVision/sfm/bundle/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/bundle/BundleAdjustmentSchur.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/multiview/triangulation/triangulationDLT.hpp>
@@ -365,19 +367,28 @@ bool ReconstructionEngine_globalSfM::Compute_Initial_Structure(matching::Pairwis
 bool ReconstructionEngine_globalSfM::Adjust()
 {
   // refine sfm  scene (in a 3 iteration process (free the parameters regarding their incertainty order)):
-  BundleAdjustmentCeres::CeresOptions options; 
-  options.useParametersOrdering = false; // disable parameters ordering
+  std::unique_ptr<BundleAdjustment> BA;
+
+  if(_bundleAdjustmentSolver == EBundleAdjustmentSolver::SCHUR)
+  {
+    BA.reset(new BundleAdjustmentSchur());
+  }
+  else
+  {
+    BundleAdjustmentCeres::CeresOptions options;
+    options.useParametersOrdering = false; // disable parameters ordering
+    BA.reset(new BundleAdjustmentCeres(options));
+  }
 
-  BundleAdjustmentCeres BA(options);
   // - refine only Structure and translations
-  bool success = BA.adjust(_sfmData, BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE);
+  bool success = BA->adjust(_sfmData, BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE);
   if(success)
   {
     if(!_loggingFile.empty())
       sfmDataIO::Save(_sfmData, (fs::path(_loggingFile).parent_path() / "structure_00_refine_T_Xi.ply").string(), sfmDataIO::ESfMData(sfmDataIO::EXTRINSICS | sfmDataIO::STRUCTURE));
 
     // refine only structure and rotations & translations
-    success = BA.adjust(_sfmData, BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE);
+    success = BA->adjust(_sfmData, BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE);
 
     if(success && !_loggingFile.empty())
       sfmDataIO::Save(_sfmData, (fs::path(_loggingFile).parent_path() / "structure_01_refine_RT_Xi.ply").string(), sfmDataIO::ESfMData(sfmDataIO::EXTRINSICS | sfmDataIO::STRUCTURE));
@@ -386,7 +397,7 @@ bool ReconstructionEngine_globalSfM::Adjust()
   if(success && !_lockAllIntrinsics)
   {
     // refine all: Structure, motion:{rotations, translations} and optics:{intrinsics}
-    success = BA.adjust(_sfmData, BundleAdjustment::REFINE_ALL);
+    success = BA->adjust(_sfmData, BundleAdjustment::REFINE_ALL);
     if(success && !_loggingFile.empty())
       sfmDataIO::Save(_sfmData, (fs::path(_loggingFile).parent_path() / "structure_02_refine_KRT_Xi.ply").string(), sfmDataIO::ESfMData(sfmDataIO::EXTRINSICS | sfmDataIO::STRUCTURE));
   }
@@ -420,7 +431,7 @@ bool ReconstructionEngine_globalSfM::Adjust()
   BundleAdjustment::ERefineOptions refineOptions = BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE;
   if(!_lockAllIntrinsics)
     refineOptions |= BundleAdjustment::REFINE_INTRINSICS_ALL;
-  success = BA.adjust(_sfmData, refineOptions);
+  success = BA->adjust(_sfmData, refineOptions);
 
   if(success && !_loggingFile.empty())
     sfmDataIO::Save(_sfmData, (fs::path(_loggingFile).parent_path() / "structure_04_outlier_removed.ply").string(), sfmDataIO::ESfMData(sfmDataIO::EXTRINSICS | sfmDataIO::STRUCTURE));
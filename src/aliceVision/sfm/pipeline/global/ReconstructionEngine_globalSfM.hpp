@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/sfm/pipeline/ReconstructionEngine.hpp>
+#include <aliceVision/sfm/bundle/BundleAdjustment.hpp>
 #include <aliceVision/sfm/pipeline/global/GlobalSfMRotationAveragingSolver.hpp>
 #include <aliceVision/sfm/pipeline/global/GlobalSfMTranslationAveragingSolver.hpp>
 
@@ -35,6 +36,7 @@ public:
   void SetTranslationAveragingMethod(ETranslationAveragingMethod eTranslationAveragingMethod);
 
   void setLockAllIntrinsics(bool v) { _lockAllIntrinsics = v; }
+  void setBundleAdjustmentSolver(EBundleAdjustmentSolver solver) { _bundleAdjustmentSolver = solver; }
 
   virtual bool process();
 
@@ -65,6 +67,7 @@ private:
   ERotationAveragingMethod _eRotationAveragingMethod;
   ETranslationAveragingMethod _eTranslationAveragingMethod;
   bool _lockAllIntrinsics = false;
+  EBundleAdjustmentSolver _bundleAdjustmentSolver = EBundleAdjustmentSolver::CERES;
   EFeatureConstraint _featureConstraint = EFeatureConstraint::BASIC;
 
   // Data provider
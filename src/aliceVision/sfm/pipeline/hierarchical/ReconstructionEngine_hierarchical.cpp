@@ -0,0 +1,526 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ReconstructionEngine_hierarchical.hpp"
+#include <aliceVision/sfm/bundle/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/sfmFilters.hpp>
+#include <aliceVision/sfm/utils/alignment.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
+#include <tuple>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace fs = boost::filesystem;
+
+using namespace aliceVision::sfmData;
+
+namespace {
+
+/// weighted view graph: <viewId, <connected viewId, number of matches>>
+using ViewGraph = std::map<IndexT, std::map<IndexT, std::size_t>>;
+
+/// observation identifier: <viewId, featureId, describer type>
+using ObservationKey = std::tuple<IndexT, IndexT, feature::EImageDescriberType>;
+
+/**
+ * @brief Get the views of the connected component of a view in a subset of the view graph,
+ * in breadth first order.
+ * @param[in] graph The view graph
+ * @param[in] subset The views of the subgraph
+ * @param[in] startViewId The first view of the traversal
+ * @return the views of the connected component
+ */
+std::vector<IndexT> breadthFirstOrder(const ViewGraph& graph, const std::set<IndexT>& subset, IndexT startViewId)
+{
+  std::vector<IndexT> order;
+  std::set<IndexT> visited;
+  std::deque<IndexT> queue;
+
+  queue.push_back(startViewId);
+  visited.insert(startViewId);
+
+  while(!queue.empty())
+  {
+    const IndexT viewId = queue.front();
+    queue.pop_front();
+    order.push_back(viewId);
+
+    const auto it = graph.find(viewId);
+    if(it == graph.end())
+      continue;
+
+    for(const auto& edge : it->second)
+    {
+      if(subset.count(edge.first) && visited.insert(edge.first).second)
+        queue.push_back(edge.first);
+    }
+  }
+  return order;
+}
+
+/**
+ * @brief Recursive bisection of the view graph, until each cluster is connected and has at most maxClusterSize views.
+ * Each connected component is split in two halves of its breadth first order from a pseudo-peripheral view,
+ * which keeps the clusters compact (e.g. consecutive parts of a video sequence).
+ * @param[in] graph The view graph
+ * @param[in] viewIds The views to partition
+ * @param[in] maxClusterSize The maximum number of views per cluster
+ * @param[out] out_clusters The clusters
+ */
+void bisect(const ViewGraph& graph, const std::set<IndexT>& viewIds, std::size_t maxClusterSize, std::vector<std::set<IndexT>>& out_clusters)
+{
+  std::vector<std::set<IndexT>> subsets = {viewIds};
+
+  while(!subsets.empty())
+  {
+    std::set<IndexT> remaining = std::move(subsets.back());
+    subsets.pop_back();
+
+    while(!remaining.empty())
+    {
+      const std::vector<IndexT> component = breadthFirstOrder(graph, remaining, *remaining.begin());
+      const std::set<IndexT> componentViewIds(component.begin(), component.end());
+
+      for(const IndexT viewId : component)
+        remaining.erase(viewId);
+
+      if(component.size() <= maxClusterSize)
+      {
+        out_clusters.push_back(componentViewIds);
+        continue;
+      }
+
+      // the last view of a breadth first traversal is a pseudo-peripheral view
+      const std::vector<IndexT> order = breadthFirstOrder(graph, componentViewIds, component.back());
+      const std::size_t half = order.size() / 2;
+
+      subsets.emplace_back(order.begin(), order.begin() + half);
+      subsets.emplace_back(order.begin() + half, order.end());
+    }
+  }
+}
+
+} // namespace
+
+bool reconstructCluster(const sfmData::SfMData& clusterSfMData,
+                        feature::FeaturesPerView& featuresPerView,
+                        const matching::PairwiseMatches& pairwiseMatches,
+                        const ReconstructionEngine_sequentialSfM::Params& params,
+                        const std::string& outputFolder,
+                        int randomSeed,
+                        sfmData::SfMData& out_sfmData)
+{
+  const std::set<IndexT> viewIds = clusterSfMData.getViewsKeys();
+
+  // keep only the matches inside the cluster
+  matching::PairwiseMatches clusterMatches;
+  for(const auto& matchesPair : pairwiseMatches)
+  {
+    if(viewIds.count(matchesPair.first.first) && viewIds.count(matchesPair.first.second))
+      clusterMatches.insert(matchesPair);
+  }
+
+  if(clusterMatches.empty())
+  {
+    ALICEVISION_LOG_WARNING("Cannot reconstruct a cluster of " << viewIds.size() << " views without matches.");
+    return false;
+  }
+
+  // the user initial pair is only used by the cluster that contains it
+  ReconstructionEngine_sequentialSfM::Params clusterParams = params;
+  if(!viewIds.count(clusterParams.userInitialImagePair.first) || !viewIds.count(clusterParams.userInitialImagePair.second))
+    clusterParams.userInitialImagePair = {UndefinedIndexT, UndefinedIndexT};
+
+  if(!fs::exists(outputFolder))
+    fs::create_directories(outputFolder);
+
+  ReconstructionEngine_sequentialSfM sfmEngine(clusterSfMData,
+                                               clusterParams,
+                                               outputFolder,
+                                               (fs::path(outputFolder) / "sfm_log.html").string());
+
+  sfmEngine.initRandomSeed(randomSeed);
+  sfmEngine.setFeatures(&featuresPerView);
+  sfmEngine.setMatches(&clusterMatches);
+
+  if(!sfmEngine.process())
+    return false;
+
+  out_sfmData = sfmEngine.getSfMData();
+  return true;
+}
+
+ReconstructionEngine_hierarchical::ReconstructionEngine_hierarchical(const SfMData& sfmData,
+                                                                     const Params& params,
+                                                                     const std::string& outputFolder)
+  : ReconstructionEngine(sfmData, outputFolder)
+  , _params(params)
+{}
+
+bool ReconstructionEngine_hierarchical::process()
+{
+  if(_featuresPerView == nullptr || _pairwiseMatches == nullptr)
+  {
+    ALICEVISION_LOG_ERROR("Hierarchical SfM: features and matches are required.");
+    return false;
+  }
+
+  // drawn first, like the separate reconstruction jobs of the clusters
+  const std::uint32_t baseSeed = _randomNumberGenerator();
+
+  if(partition() == 0)
+    return false;
+
+  // the seeds are computed before the parallel reconstructions to keep the results reproducible
+  std::vector<int> randomSeeds(_clusters.size());
+  for(std::size_t i = 0; i < randomSeeds.size(); ++i)
+    randomSeeds[i] = getClusterRandomSeed(baseSeed, i);
+
+  std::vector<SfMData> clustersSfMData(_clusters.size());
+  std::vector<char> isReconstructed(_clusters.size(), 0);
+
+  #pragma omp parallel for schedule(dynamic) num_threads(std::max(1, _params.nbParallelClusters))
+  for(int i = 0; i < _clusters.size(); ++i)
+  {
+    SfMData clusterSfMData;
+    getClusterSfMData(i, clusterSfMData);
+
+    const std::string clusterFolder = (fs::path(_outputFolder) / getClusterName(i)).string();
+
+    ALICEVISION_LOG_INFO("Hierarchical SfM: reconstruction of the cluster " << i << " (" << _clusters.at(i).size() << " views).");
+
+    isReconstructed[i] = reconstructCluster(clusterSfMData, *_featuresPerView, *_pairwiseMatches, _params.sequentialParams,
+                                            clusterFolder, randomSeeds.at(i), clustersSfMData.at(i));
+
+    if(!isReconstructed[i])
+      ALICEVISION_LOG_WARNING("Hierarchical SfM: the reconstruction of the cluster " << i << " failed.");
+  }
+
+  std::vector<SfMData> reconstructedClusters;
+  for(std::size_t i = 0; i < _clusters.size(); ++i)
+  {
+    if(isReconstructed[i])
+      reconstructedClusters.push_back(std::move(clustersSfMData[i]));
+  }
+
+  return mergeClusters(reconstructedClusters);
+}
+
+std::size_t ReconstructionEngine_hierarchical::partition()
+{
+  _clusters.clear();
+
+  const std::set<IndexT> viewIds = _sfmData.getViewsKeys();
+
+  // build the view graph
+  ViewGraph graph;
+  for(const auto& matchesPair : *_pairwiseMatches)
+  {
+    const Pair& pair = matchesPair.first;
+    const std::size_t nbMatches = matchesPair.second.getNbAllMatches();
+
+    if(nbMatches == 0 || nbMatches < _params.minNbMatches || !viewIds.count(pair.first) || !viewIds.count(pair.second))
+      continue;
+
+    graph[pair.first][pair.second] += nbMatches;
+    graph[pair.second][pair.first] += nbMatches;
+  }
+
+  // views without any connection cannot be reconstructed
+  std::set<IndexT> connectedViewIds;
+  for(const auto& node : graph)
+    connectedViewIds.insert(node.first);
+
+  std::vector<std::set<IndexT>> clusters;
+  bisect(graph, connectedViewIds, std::max<std::size_t>(_params.maxClusterSize, 2), clusters);
+
+  // extend each cluster with the views of the other clusters the most connected to it
+  for(const std::set<IndexT>& cluster : clusters)
+  {
+    if(cluster.size() < 2)
+      continue;
+
+    std::map<IndexT, std::size_t> neighbourWeights;
+    for(const IndexT viewId : cluster)
+    {
+      for(const auto& edge : graph.at(viewId))
+      {
+        if(!cluster.count(edge.first))
+          neighbourWeights[edge.first] += edge.second;
+      }
+    }
+
+    std::vector<std::pair<std::size_t, IndexT>> neighbours;
+    neighbours.reserve(neighbourWeights.size());
+    for(const auto& neighbour : neighbourWeights)
+      neighbours.emplace_back(neighbour.second, neighbour.first);
+
+    std::sort(neighbours.begin(), neighbours.end(), std::greater<std::pair<std::size_t, IndexT>>());
+
+    const std::size_t nbOverlapViews = std::min(neighbours.size(), static_cast<std::size_t>(std::ceil(_params.clusterOverlap * cluster.size())));
+
+    std::set<IndexT> extendedCluster = cluster;
+    for(std::size_t i = 0; i < nbOverlapViews; ++i)
+      extendedCluster.insert(neighbours.at(i).second);
+
+    _clusters.push_back(std::move(extendedCluster));
+  }
+
+  ALICEVISION_LOG_INFO("Hierarchical SfM: view graph partition:" << std::endl
+                       << "\t- # views: " << viewIds.size() << std::endl
+                       << "\t- # connected views: " << connectedViewIds.size() << std::endl
+                       << "\t- # clusters: " << _clusters.size());
+
+  return _clusters.size();
+}
+
+void ReconstructionEngine_hierarchical::getClusterSfMData(std::size_t clusterIndex, SfMData& out_clusterSfMData) const
+{
+  out_clusterSfMData.clear();
+
+  for(const IndexT viewId : _clusters.at(clusterIndex))
+  {
+    const View& view = _sfmData.getView(viewId);
+
+    // deep copy, the views are modified by the reconstruction of the cluster
+    out_clusterSfMData.getViews().emplace(viewId, std::make_shared<View>(view));
+
+    if(!out_clusterSfMData.getIntrinsics().count(view.getIntrinsicId()))
+    {
+      const camera::IntrinsicBase* intrinsic = _sfmData.getIntrinsicPtr(view.getIntrinsicId());
+      if(intrinsic != nullptr)
+        out_clusterSfMData.getIntrinsics().emplace(view.getIntrinsicId(), std::shared_ptr<camera::IntrinsicBase>(intrinsic->clone()));
+    }
+
+    if(view.isPartOfRig() && !out_clusterSfMData.getRigs().count(view.getRigId()))
+      out_clusterSfMData.getRigs().emplace(view.getRigId(), _sfmData.getRigs().at(view.getRigId()));
+  }
+}
+
+bool ReconstructionEngine_hierarchical::mergeClusters(std::vector<SfMData>& clustersSfMData)
+{
+  _sfmData.getPoses().clear();
+  _sfmData.getLandmarks().clear();
+  _sfmData.resetRigs();
+
+  if(clustersSfMData.empty())
+  {
+    ALICEVISION_LOG_ERROR("Hierarchical SfM: no cluster reconstruction to merge.");
+    return false;
+  }
+
+  // start from the largest reconstruction
+  std::size_t referenceIndex = 0;
+  for(std::size_t i = 1; i < clustersSfMData.size(); ++i)
+  {
+    if(clustersSfMData[i].getPoses().size() > clustersSfMData[referenceIndex].getPoses().size())
+      referenceIndex = i;
+  }
+
+  std::vector<char> isMerged(clustersSfMData.size(), 0);
+  mergeCluster(clustersSfMData.at(referenceIndex));
+  isMerged[referenceIndex] = 1;
+
+  std::size_t nbMergedClusters = 1;
+
+  // merge the reconstruction with the most common cameras with the current scene
+  while(true)
+  {
+    std::size_t bestIndex = 0;
+    std::size_t bestNbCommonViews = 0;
+
+    for(std::size_t i = 0; i < clustersSfMData.size(); ++i)
+    {
+      if(isMerged[i])
+        continue;
+
+      std::vector<IndexT> commonViewIds;
+      getCommonViewsWithPoses(clustersSfMData[i], _sfmData, commonViewIds);
+
+      if(commonViewIds.size() > bestNbCommonViews)
+      {
+        bestIndex = i;
+        bestNbCommonViews = commonViewIds.size();
+      }
+    }
+
+    if(bestNbCommonViews == 0 || bestNbCommonViews < _params.minNbCommonViews)
+      break;
+
+    isMerged[bestIndex] = 1;
+
+    double S = 1.0;
+    Mat3 R = Mat3::Identity();
+    Vec3 t = Vec3::Zero();
+
+    if(!computeSimilarityFromCommonCameras_viewId(clustersSfMData[bestIndex], _sfmData, _randomNumberGenerator, &S, &R, &t))
+    {
+      ALICEVISION_LOG_WARNING("Hierarchical SfM: cannot align a cluster reconstruction with " << bestNbCommonViews << " common views.");
+      continue;
+    }
+
+    applyTransform(clustersSfMData[bestIndex], S, R, t);
+    mergeCluster(clustersSfMData[bestIndex]);
+    ++nbMergedClusters;
+  }
+
+  ALICEVISION_LOG_INFO("Hierarchical SfM: merge of the cluster reconstructions:" << std::endl
+                       << "\t- # merged clusters: " << nbMergedClusters << " / " << clustersSfMData.size() << std::endl
+                       << "\t- # poses: " << _sfmData.getPoses().size() << std::endl
+                       << "\t- # landmarks: " << _sfmData.getLandmarks().size());
+
+  return bundleAdjustment();
+}
+
+void ReconstructionEngine_hierarchical::mergeCluster(const SfMData& clusterSfMData)
+{
+  // intrinsics reconstructed for the first time
+  {
+    const std::set<IndexT> reconstructedIntrinsics = _sfmData.getReconstructedIntrinsics();
+    for(const IndexT intrinsicId : clusterSfMData.getReconstructedIntrinsics())
+    {
+      if(!reconstructedIntrinsics.count(intrinsicId))
+        _sfmData.getIntrinsics().at(intrinsicId)->updateFromParams(clusterSfMData.getIntrinsics().at(intrinsicId)->getParams());
+    }
+  }
+
+  // rig sub-poses calibrated for the first time
+  for(const auto& rigPair : clusterSfMData.getRigs())
+  {
+    Rig& rig = _sfmData.getRigs().at(rigPair.first);
+    for(std::size_t i = 0; i < rig.getSubPoses().size(); ++i)
+    {
+      if(rig.getSubPose(i).status == ERigSubPoseStatus::UNINITIALIZED)
+        rig.getSubPose(i) = rigPair.second.getSubPose(i);
+    }
+  }
+
+  // poses of the new views
+  for(const auto& viewPair : clusterSfMData.getViews())
+  {
+    const IndexT viewId = viewPair.first;
+    if(clusterSfMData.isPoseAndIntrinsicDefined(viewId) && !_sfmData.isPoseAndIntrinsicDefined(viewId))
+      _sfmData.setPose(_sfmData.getView(viewId), clusterSfMData.getPose(*viewPair.second));
+  }
+
+  // landmarks, fused with the existing landmarks sharing an observation
+  Landmarks& landmarks = _sfmData.getLandmarks();
+
+  std::map<ObservationKey, IndexT> landmarkPerObservation;
+  IndexT nextLandmarkId = 0;
+  for(const auto& landmarkPair : landmarks)
+  {
+    for(const auto& observationPair : landmarkPair.second.observations)
+      landmarkPerObservation.emplace(ObservationKey(observationPair.first, observationPair.second.id_feat, landmarkPair.second.descType), landmarkPair.first);
+    nextLandmarkId = std::max(nextLandmarkId, landmarkPair.first + 1);
+  }
+
+  std::size_t nbFusedLandmarks = 0;
+  for(const auto& landmarkPair : clusterSfMData.getLandmarks())
+  {
+    const Landmark& clusterLandmark = landmarkPair.second;
+
+    IndexT landmarkId = UndefinedIndexT;
+    for(const auto& observationPair : clusterLandmark.observations)
+    {
+      const auto it = landmarkPerObservation.find(ObservationKey(observationPair.first, observationPair.second.id_feat, clusterLandmark.descType));
+      if(it != landmarkPerObservation.end())
+      {
+        landmarkId = it->second;
+        break;
+      }
+    }
+
+    if(landmarkId == UndefinedIndexT)
+    {
+      landmarkId = nextLandmarkId++;
+      landmarks.emplace(landmarkId, clusterLandmark);
+    }
+    else
+    {
+      Observations& observations = landmarks.at(landmarkId).observations;
+      for(const auto& observationPair : clusterLandmark.observations)
+        observations.emplace(observationPair.first, observationPair.second);
+      ++nbFusedLandmarks;
+    }
+
+    for(const auto& observationPair : landmarks.at(landmarkId).observations)
+      landmarkPerObservation.emplace(ObservationKey(observationPair.first, observationPair.second.id_feat, clusterLandmark.descType), landmarkId);
+  }
+
+  ALICEVISION_LOG_DEBUG("Hierarchical SfM: cluster merged:" << std::endl
+                        << "\t- # cluster poses: " << clusterSfMData.getPoses().size() << std::endl
+                        << "\t- # cluster landmarks: " << clusterSfMData.getLandmarks().size() << std::endl
+                        << "\t- # fused landmarks: " << nbFusedLandmarks);
+}
+
+bool ReconstructionEngine_hierarchical::bundleAdjustment()
+{
+  const ReconstructionEngine_sequentialSfM::Params& params = _params.sequentialParams;
+
+  BundleAdjustmentCeres::CeresOptions options;
+  options.setSparseBA();
+
+  BundleAdjustment::ERefineOptions refineOptions = BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE;
+  if(!params.lockAllIntrinsics)
+    refineOptions |= BundleAdjustment::REFINE_INTRINSICS_ALL;
+
+  BundleAdjustmentCeres BA(options, params.minNbCamerasToRefinePrincipalPoint);
+
+  std::size_t iteration = 0;
+  std::size_t nbOutliers = 0;
+
+  // perform BA until all point are under the given precision
+  do
+  {
+    ALICEVISION_LOG_INFO("Hierarchical SfM: global bundle adjustment iteration: " << iteration);
+
+    if(!BA.adjust(_sfmData, refineOptions))
+      return false;
+
+    BA.getStatistics().show();
+
+    nbOutliers = RemoveOutliers_PixelResidualError(_sfmData, params.featureConstraint, params.maxReprojectionError, 2) +
+                 RemoveOutliers_AngleError(_sfmData, params.minAngleForLandmark);
+
+    eraseUnstablePosesAndObservations(_sfmData, params.minPointsPerPose, params.minTrackLength);
+
+    ALICEVISION_LOG_INFO("Hierarchical SfM: " << nbOutliers << " outliers removed.");
+    ++iteration;
+  }
+  while(params.bundleAdjustmentMaxOutliers >= 0 && nbOutliers > params.bundleAdjustmentMaxOutliers);
+
+  return true;
+}
+
+std::string getClusterName(std::size_t clusterIndex)
+{
+  std::ostringstream os;
+  os << "cluster_" << std::setw(4) << std::setfill('0') << clusterIndex;
+  return os.str();
+}
+
+int getClusterRandomSeed(std::uint32_t baseSeed, std::size_t clusterIndex)
+{
+  std::seed_seq seedSequence{baseSeed, static_cast<std::uint32_t>(clusterIndex), static_cast<std::uint32_t>(std::uint64_t(clusterIndex) >> 32)};
+  std::mt19937 generator(seedSequence);
+  return static_cast<int>(generator() & 0x7fffffff);
+}
+
+} // namespace sfm
+} // namespace aliceVision
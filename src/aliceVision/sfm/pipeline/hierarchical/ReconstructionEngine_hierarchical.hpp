@@ -0,0 +1,175 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfm/pipeline/ReconstructionEngine.hpp>
+#include <aliceVision/sfm/pipeline/sequential/ReconstructionEngine_sequentialSfM.hpp>
+#include <aliceVision/feature/FeaturesPerView.hpp>
+#include <aliceVision/matching/IndMatch.hpp>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Get the name of a cluster, used for its files and folders
+ * @param[in] clusterIndex The cluster index
+ * @return the cluster name (cluster_XXXX)
+ */
+std::string getClusterName(std::size_t clusterIndex);
+
+/**
+ * @brief Get the random seed of the reconstruction of a cluster.
+ * It only depends on the cluster index, so the clusters reconstructed by process()
+ * or by separate jobs (whatever their range) get the same seeds.
+ * @param[in] baseSeed The first number drawn by the random generator of the hierarchical SfM
+ * @param[in] clusterIndex The cluster index
+ * @return the random seed of the cluster (non-negative)
+ */
+int getClusterRandomSeed(std::uint32_t baseSeed, std::size_t clusterIndex);
+
+/**
+ * @brief Reconstruct the views of a cluster with the incremental SfM.
+ * This is a standalone job: it only needs the views and intrinsics of the cluster,
+ * so the clusters of a scene can be reconstructed in different processes or on different nodes.
+ * @param[in] clusterSfMData The views and intrinsics of the cluster
+ * @param[in] featuresPerView The features of (at least) the views of the cluster
+ * @param[in] pairwiseMatches The matches of the scene, only the pairs inside the cluster are used
+ * @param[in] params The incremental SfM parameters
+ * @param[in] outputFolder The folder of the incremental SfM intermediate outputs
+ * @param[in] randomSeed The random seed of the incremental SfM
+ * @param[out] out_sfmData The reconstructed cluster
+ * @return true if the cluster is reconstructed
+ */
+bool reconstructCluster(const sfmData::SfMData& clusterSfMData,
+                        feature::FeaturesPerView& featuresPerView,
+                        const matching::PairwiseMatches& pairwiseMatches,
+                        const ReconstructionEngine_sequentialSfM::Params& params,
+                        const std::string& outputFolder,
+                        int randomSeed,
+                        sfmData::SfMData& out_sfmData);
+
+/**
+ * @brief Hierarchical (divide and conquer) SfM Pipeline Reconstruction Engine.
+ * - The view graph (views connected by their matches) is partitioned in clusters by recursive bisection,
+ *   each cluster is extended with the views of the neighbour clusters the most connected to it.
+ * - Each cluster is reconstructed independently with the incremental SfM (see reconstructCluster).
+ * - The cluster reconstructions are merged one by one, from the largest one, with a similarity
+ *   estimated on their common cameras, then the whole scene is refined with a global bundle adjustment.
+ *
+ * The 3 steps can be run separately to distribute the reconstruction of the clusters.
+ */
+class ReconstructionEngine_hierarchical : public ReconstructionEngine
+{
+public:
+
+  struct Params
+  {
+    /// Incremental SfM parameters of the reconstruction of the clusters and of the final bundle adjustment
+    ReconstructionEngine_sequentialSfM::Params sequentialParams;
+    /// Maximum number of views of a cluster before its extension with the overlapping views
+    std::size_t maxClusterSize = 1000;
+    /// Ratio of views added to each cluster from its neighbour clusters
+    double clusterOverlap = 0.25;
+    /// Minimum number of matches to connect two views in the view graph
+    std::size_t minNbMatches = 0;
+    /// Minimum number of common reconstructed views to merge a cluster reconstruction
+    std::size_t minNbCommonViews = 4;
+    /// Number of clusters reconstructed at the same time by process()
+    int nbParallelClusters = 1;
+  };
+
+  /**
+   * @brief ReconstructionEngine_hierarchical Constructor
+   * @param[in] sfmData The input SfMData of the scene
+   * @param[in] params The hierarchical SfM parameters
+   * @param[in] outputFolder The folder of the cluster reconstructions
+   */
+  ReconstructionEngine_hierarchical(const sfmData::SfMData& sfmData,
+                                    const Params& params,
+                                    const std::string& outputFolder);
+
+  void setFeatures(feature::FeaturesPerView* featuresPerView)
+  {
+    _featuresPerView = featuresPerView;
+  }
+
+  void setMatches(matching::PairwiseMatches* pairwiseMatches)
+  {
+    _pairwiseMatches = pairwiseMatches;
+  }
+
+  /**
+   * @brief Process the entire hierarchical reconstruction:
+   * partition, reconstruction of the clusters and merge
+   * @return true if done
+   */
+  virtual bool process();
+
+  /**
+   * @brief Partition the view graph in overlapping clusters
+   * @return the number of clusters
+   */
+  std::size_t partition();
+
+  /**
+   * @brief Get the clusters of views computed by partition()
+   */
+  const std::vector<std::set<IndexT>>& getClusters() const
+  {
+    return _clusters;
+  }
+
+  /**
+   * @brief Get the SfMData of a cluster: its views (without poses) and their intrinsics and rigs
+   * @param[in] clusterIndex The cluster index
+   * @param[out] out_clusterSfMData The cluster SfMData
+   */
+  void getClusterSfMData(std::size_t clusterIndex, sfmData::SfMData& out_clusterSfMData) const;
+
+  /**
+   * @brief Merge the cluster reconstructions into the scene and run the final bundle adjustment.
+   * Clusters without enough common views with the merged reconstruction are ignored.
+   * @param[in,out] clustersSfMData The cluster reconstructions (aligned in place)
+   * @return true if at least one cluster has been merged and the bundle adjustment succeed
+   */
+  bool mergeClusters(std::vector<sfmData::SfMData>& clustersSfMData);
+
+private:
+
+  /**
+   * @brief Merge an aligned cluster reconstruction into the scene:
+   * new poses, intrinsics of the new views, rig sub-poses and landmarks
+   * (fused with the existing landmarks sharing an observation).
+   * @param[in] clusterSfMData The aligned cluster reconstruction
+   */
+  void mergeCluster(const sfmData::SfMData& clusterSfMData);
+
+  /**
+   * @brief Global bundle adjustment with outliers removal
+   * @return false if the bundle adjustment failed
+   */
+  bool bundleAdjustment();
+
+  /// Parameters
+  Params _params;
+
+  // Data providers
+
+  feature::FeaturesPerView* _featuresPerView = nullptr;
+  matching::PairwiseMatches* _pairwiseMatches = nullptr;
+
+  /// Clusters of views (with their overlap)
+  std::vector<std::set<IndexT>> _clusters;
+};
+
+} // namespace sfm
+} // namespace aliceVision
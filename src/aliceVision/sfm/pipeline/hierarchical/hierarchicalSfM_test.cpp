@@ -0,0 +1,105 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/sfm/utils/statistics.hpp>
+#include <aliceVision/sfm/utils/syntheticScene.hpp>
+#include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/pipeline/hierarchical/ReconstructionEngine_hierarchical.hpp>
+
+#define BOOST_TEST_MODULE HIERARCHICAL_SFM
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+using namespace aliceVision::geometry;
+using namespace aliceVision::sfm;
+using namespace aliceVision::sfmData;
+
+// Test summary:
+// - Partition a synthetic ring in clusters, check the cluster sizes and the coverage of the views
+// - Perform the hierarchical SfM on a synthetic ring and assert that:
+//   - mean residual error is below the gaussian noise added to observation
+//   - all the poses are found.
+
+BOOST_AUTO_TEST_CASE(HIERARCHICAL_SFM_Partition)
+{
+  const int nviews = 40;
+  const int npoints = 32;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  const SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  ReconstructionEngine_hierarchical::Params params;
+  params.maxClusterSize = 10;
+  params.clusterOverlap = 0.2;
+
+  ReconstructionEngine_hierarchical sfmEngine(sfmData, params, "./");
+  sfmEngine.setMatches(&pairwiseMatches);
+
+  BOOST_CHECK_GE(sfmEngine.partition(), nviews / params.maxClusterSize);
+
+  std::set<IndexT> clusteredViews;
+  for(const std::set<IndexT>& cluster : sfmEngine.getClusters())
+  {
+    // core views and overlapping views
+    BOOST_CHECK_LE(cluster.size(), params.maxClusterSize + 2);
+    BOOST_CHECK_GT(cluster.size(), params.maxClusterSize / 2);
+    clusteredViews.insert(cluster.begin(), cluster.end());
+  }
+  BOOST_CHECK_EQUAL(clusteredViews.size(), nviews);
+}
+
+BOOST_AUTO_TEST_CASE(HIERARCHICAL_SFM_Known_Intrinsics)
+{
+  const int nviews = 12;
+  const int npoints = 128;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  const SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+  // Remove poses and structure
+  SfMData sfmData2 = sfmData;
+  sfmData2.getPoses().clear();
+  sfmData2.getLandmarks().clear();
+
+  ReconstructionEngine_hierarchical::Params params;
+  params.sequentialParams.lockAllIntrinsics = true;
+  params.maxClusterSize = 6;
+  params.clusterOverlap = 0.5;
+
+  ReconstructionEngine_hierarchical sfmEngine(sfmData2, params, "./hierarchicalSfM_test");
+
+  // Add a tiny noise in 2D observations to make data more realistic
+  std::normal_distribution<double> distribution(0.0,0.5);
+
+  // Configure the featuresPerView & the matches_provider from the synthetic dataset
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, distribution);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  // Configure data provider (Features and Matches)
+  sfmEngine.setFeatures(&featuresPerView);
+  sfmEngine.setMatches(&pairwiseMatches);
+
+  BOOST_CHECK(sfmEngine.process());
+  BOOST_CHECK_EQUAL(sfmEngine.getClusters().size(), 2);
+
+  const double residual = RMSE(sfmEngine.getSfMData());
+  ALICEVISION_LOG_DEBUG("RMSE residual: " << residual);
+  BOOST_CHECK_LT(residual, 0.5);
+  BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getPoses().size(), nviews);
+}
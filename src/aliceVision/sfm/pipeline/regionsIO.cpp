@@ -8,10 +8,12 @@
 #include "regionsIO.hpp"
 
 #include <aliceVision/system/ProgressDisplay.hpp>
+#include <aliceVision/feature/regionsBinaryIO.hpp>
 #include <boost/filesystem.hpp>
 
 #include <atomic>
 #include <cassert>
+#include <ctime>
 
 namespace fs = boost::filesystem;
 
@@ -20,6 +22,51 @@ namespace sfm {
 
 using namespace sfmData;
 
+namespace {
+
+/**
+ * @brief Check if the binary regions file should be used instead of the features / descriptors files of the same folder.
+ * @note The binary regions file is only used if it is not older than the features / descriptors files,
+ *       a stale binary file (e.g. features extracted again after a conversion) is ignored.
+ * @param[in] regionsPath the binary regions file path
+ * @param[in] featDescPaths the features / descriptors files paths
+ * @return true if the binary regions file should be used
+ */
+bool useRegionsBinaryFile(const fs::path& regionsPath, const std::vector<fs::path>& featDescPaths)
+{
+  if(!fs::exists(regionsPath))
+    return false;
+
+  const std::time_t regionsTime = fs::last_write_time(regionsPath);
+
+  for(const fs::path& path : featDescPaths)
+  {
+    if(fs::exists(path) && fs::last_write_time(path) > regionsTime)
+    {
+      ALICEVISION_LOG_WARNING("The binary regions file '" << regionsPath.string() << "' is older than '" << path.string() << "', it is ignored.");
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Check that the binary regions file keeps the regions order of the features files.
+ * @note Matches and landmarks observations refer to the regions indexes,
+ *       a binary regions file sorted by scale cannot be used for matching / SfM.
+ * @param[in] regionsFilename the binary regions file path
+ */
+void checkRegionsBinaryFileOrder(const std::string& regionsFilename)
+{
+  const feature::MappedRegionsFile regionsFile(regionsFilename);
+
+  if(regionsFile.isSortedByScale())
+    throw std::runtime_error("The binary regions file '" + regionsFilename + "' is sorted by scale, "
+                             "its regions indexes do not match the features files. Convert the regions without 'sortByScale'.");
+}
+
+} // namespace
+
 std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
                                               IndexT viewId,
                                               const feature::ImageDescriber& imageDescriber)
@@ -31,38 +78,68 @@ std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& fo
 
   std::string featFilename;
   std::string descFilename;
+  std::string regionsFilename;
 
   for(const std::string& folder : folders)
   {
+    const fs::path regionsPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + feature::regionsBinaryFileExtension);
     const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
     const fs::path descPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".desc");
 
-    if(fs::exists(featPath) && fs::exists(descPath))
+    // binary regions file is preferred over up-to-date features / descriptors files
+    if(useRegionsBinaryFile(regionsPath, {featPath, descPath}))
+    {
+      regionsFilename = regionsPath.string();
+      featFilename.clear();
+      descFilename.clear();
+    }
+    else if(fs::exists(featPath) && fs::exists(descPath))
     {
       featFilename = featPath.string();
       descFilename = descPath.string();
+      regionsFilename.clear();
     }
   }
 
-  if(featFilename.empty() || descFilename.empty())
+  if(regionsFilename.empty() && (featFilename.empty() || descFilename.empty()))
     throw std::runtime_error("Can't find view " + basename + " region files");
 
-  ALICEVISION_LOG_TRACE("Features filename: "    << featFilename);
-  ALICEVISION_LOG_TRACE("Descriptors filename: " << descFilename);
+  if(!regionsFilename.empty())
+  {
+    ALICEVISION_LOG_TRACE("Regions filename: " << regionsFilename);
+  }
+  else
+  {
+    ALICEVISION_LOG_TRACE("Features filename: "    << featFilename);
+    ALICEVISION_LOG_TRACE("Descriptors filename: " << descFilename);
+  }
 
   std::unique_ptr<feature::Regions> regionsPtr;
   imageDescriber.allocate(regionsPtr);
 
   try
   {
-    regionsPtr->Load(featFilename, descFilename);
+    if(!regionsFilename.empty())
+    {
+      checkRegionsBinaryFileOrder(regionsFilename);
+      regionsPtr->LoadBinary(regionsFilename);
+    }
+    else
+      regionsPtr->Load(featFilename, descFilename);
   }
   catch(const std::exception& e)
   {
     std::stringstream ss;
     ss << "Invalid " << imageDescriberTypeName << " regions files for the view " << basename << " : \n";
-    ss << "\t- Features file : " << featFilename << "\n";
-    ss << "\t- Descriptors file: " << descFilename << "\n";
+    if(!regionsFilename.empty())
+    {
+      ss << "\t- Regions file : " << regionsFilename << "\n";
+    }
+    else
+    {
+      ss << "\t- Features file : " << featFilename << "\n";
+      ss << "\t- Descriptors file: " << descFilename << "\n";
+    }
     ss << "\t  " << e.what() << "\n";
     ALICEVISION_LOG_ERROR(ss.str());
 
@@ -94,11 +171,24 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
     }
   }
 
+  bool isBinary = false;
+
   for(const auto& folder : foldersSet)
   {
+    const fs::path regionsPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + feature::regionsBinaryFileExtension);
     const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
-    if(fs::exists(featPath))
+
+    // binary regions file is preferred over an up-to-date features file
+    if(useRegionsBinaryFile(regionsPath, {featPath}))
+    {
+      featFilename = regionsPath.string();
+      isBinary = true;
+    }
+    else if(fs::exists(featPath))
+    {
       featFilename = featPath.string();
+      isBinary = false;
+    }
   }
 
   if(featFilename.empty())
@@ -111,7 +201,13 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
 
   try
   {
-    regionsPtr->LoadFeatures(featFilename);
+    if(isBinary)
+    {
+      checkRegionsBinaryFileOrder(featFilename);
+      regionsPtr->LoadFeaturesBinary(featFilename);
+    }
+    else
+      regionsPtr->LoadFeatures(featFilename);
   }
   catch(const std::exception& e)
   {
@@ -235,6 +331,35 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
 }
 
 
+feature::RegionsCache::RegionsLoader createRegionsLoader(const SfMData& sfmData,
+                                                         const std::vector<std::string>& folders,
+                                                         const std::vector<feature::EImageDescriberType>& imageDescriberTypes)
+{
+  std::vector<std::string> featuresFolders = sfmData.getFeaturesFolders(); // add sfm features folders
+  featuresFolders.insert(featuresFolders.end(), folders.begin(), folders.end()); // add user features folders
+  auto last = std::unique(featuresFolders.begin(), featuresFolders.end());
+  featuresFolders.erase(last, featuresFolders.end());
+
+  std::vector<std::shared_ptr<feature::ImageDescriber>> imageDescribers;
+  for(const feature::EImageDescriberType descType : imageDescriberTypes)
+    imageDescribers.emplace_back(createImageDescriber(descType));
+
+  return [featuresFolders, imageDescribers](IndexT viewId, feature::MapRegionsPerDesc& out_regions)
+  {
+    try
+    {
+      for(const auto& imageDescriber : imageDescribers)
+        out_regions[imageDescriber->getDescriberType()] = loadRegions(featuresFolders, viewId, *imageDescriber);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Cannot load the regions of the view " << viewId << ": " << e.what());
+      return false;
+    }
+    return true;
+  };
+}
+
 bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
                       const SfMData& sfmData,
                       const std::vector<std::string>& folders,
@@ -12,6 +12,7 @@
 #include <aliceVision/feature/ImageDescriber.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/feature/RegionsCache.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
 
 #include <memory>
@@ -21,6 +22,8 @@ namespace sfm {
 
 /**
  * @brief Load Regions (Features & Descriptors) for one view.
+ * @note A binary regions file is preferred over the features / descriptors files of the same folder,
+ *       unless it is older than them. A binary regions file sorted by scale is refused.
  * @param[in] folders The list of featureFolders
  * @param[in] viewId The view id
  * @param[in] imageDescriber The imageDescriber type
@@ -30,6 +33,8 @@ std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& fo
 
 /**
  * @brief Load Features for one view.
+ * @note A binary regions file is preferred over the features file of the same folder,
+ *       unless it is older than it. A binary regions file sorted by scale is refused.
  * @param[in] folders The list of featureFolders
  * @param[in] viewId The view id
  * @param[in] imageDescriber The imageDescriber type
@@ -64,6 +69,18 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
                         const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
                         const std::set<IndexT>& filter = std::set<IndexT>());
 
+/**
+ * @brief Create a function loading the Regions (Features & Descriptors) of a view on demand,
+ *        to be used by a RegionsCache.
+ * @param[in] sfmData The provided SfMData container
+ * @param[in] folders The feature Folders
+ * @param[in] imageDescriberTypes The imageDescriber types
+ * @return the regions loader
+ */
+feature::RegionsCache::RegionsLoader createRegionsLoader(const sfmData::SfMData& sfmData,
+                                                         const std::vector<std::string>& folders,
+                                                         const std::vector<feature::EImageDescriberType>& imageDescriberTypes);
+
 /**
  * @brief Load Features for each view of the provided SfMData container.
  * @param[in,out] featuresPerView
@@ -0,0 +1,279 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "NextBestViewScoring.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace aliceVision {
+namespace sfm {
+
+void NextBestViewScoring::initialize(const track::TracksMap& tracks,
+                                     const track::TracksPyramidPerView& tracksPyramidPerView,
+                                     std::size_t pyramidBase,
+                                     const std::vector<int>& pyramidWeights)
+{
+  clear();
+
+  _tracks = &tracks;
+  _pyramidWeights = pyramidWeights;
+  _pyramidDepth = pyramidWeights.size();
+  _nbCells = 0;
+
+  std::size_t width = 1;
+  for(std::size_t level = 0; level < _pyramidDepth; ++level)
+  {
+    width *= pyramidBase;
+    _nbCells += width * width;
+  }
+
+  // flat_map keys are sorted, so the views are sorted by view id
+  _views.resize(tracksPyramidPerView.size());
+  std::size_t i = 0;
+  for(const auto& viewPyramid : tracksPyramidPerView)
+  {
+    ViewScore& view = _views[i++];
+    view.viewId = static_cast<IndexT>(viewPyramid.first);
+    view.tracksPyramid = &viewPyramid.second;
+  }
+
+  _addedTracksPerView.resize(_views.size());
+  _removedTracksPerView.resize(_views.size());
+}
+
+void NextBestViewScoring::clear()
+{
+  _tracks = nullptr;
+  _views.clear();
+  _addedTracksPerView.clear();
+  _removedTracksPerView.clear();
+  _reconstructedTracks = track::TrackIdBitset();
+  _queue = std::priority_queue<QueueEntry>();
+  _nbQueuedViews = 0;
+}
+
+std::size_t NextBestViewScoring::update(const track::TrackIdBitset& reconstructedTracks)
+{
+  if(_tracks == nullptr)
+    return 0;
+
+  // previous reconstructed tracks with the size of the new set
+  if(_reconstructedTracks.size() != reconstructedTracks.size())
+  {
+    track::TrackIdBitset previousTracks(reconstructedTracks.size());
+    for(std::size_t w = 0; w < _reconstructedTracks.getWords().size(); ++w)
+    {
+      std::uint64_t word = _reconstructedTracks.getWords()[w];
+      while(word != 0)
+      {
+        const std::size_t trackId = w * 64 + track::TrackIdBitset::lowestBit(word);
+        word &= word - 1;
+        if(trackId < previousTracks.size())
+          previousTracks.set(trackId);
+      }
+    }
+    _reconstructedTracks = std::move(previousTracks);
+  }
+
+  // dispatch the changed tracks to the views that see them
+  const std::vector<std::uint64_t>& previousWords = _reconstructedTracks.getWords();
+  const std::vector<std::uint64_t>& currentWords = reconstructedTracks.getWords();
+  std::vector<std::size_t> changedViews;
+  std::size_t nbChangedTracks = 0;
+
+  for(std::size_t w = 0; w < currentWords.size(); ++w)
+  {
+    std::uint64_t diff = previousWords[w] ^ currentWords[w];
+    while(diff != 0)
+    {
+      const int bit = track::TrackIdBitset::lowestBit(diff);
+      diff &= diff - 1;
+
+      const std::size_t trackId = w * 64 + bit;
+      const bool isAdded = (currentWords[w] >> bit) & 1;
+      const auto trackIt = _tracks->find(trackId);
+      if(trackIt == _tracks->end())
+        continue;
+
+      ++nbChangedTracks;
+      for(const auto& featPerView : trackIt->second.featPerView)
+      {
+        const std::size_t viewIndex = getViewIndex(static_cast<IndexT>(featPerView.first));
+        if(viewIndex == _views.size())
+          continue;
+
+        if(_addedTracksPerView[viewIndex].empty() && _removedTracksPerView[viewIndex].empty())
+          changedViews.push_back(viewIndex);
+
+        if(isAdded)
+          _addedTracksPerView[viewIndex].push_back(trackId);
+        else
+          _removedTracksPerView[viewIndex].push_back(trackId);
+      }
+    }
+  }
+
+  // update the pyramid occupancy of the changed views
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < changedViews.size(); ++i)
+  {
+    const std::size_t viewIndex = changedViews[i];
+    ViewScore& view = _views[viewIndex];
+    std::vector<std::size_t>& addedTracks = _addedTracksPerView[viewIndex];
+    std::vector<std::size_t>& removedTracks = _removedTracksPerView[viewIndex];
+
+    if(_pyramidDepth == 0)
+    {
+      view.nbTracks += addedTracks.size();
+      view.nbTracks -= removedTracks.size();
+      view.score = view.nbTracks;
+    }
+    else
+    {
+      if(view.cellCounts.empty())
+        view.cellCounts.assign(_nbCells, 0);
+
+      for(const std::size_t trackId : removedTracks)
+      {
+        for(std::size_t level = 0; level < _pyramidDepth; ++level)
+        {
+          const std::size_t cell = view.tracksPyramid->at(trackId * _pyramidDepth + level);
+          assert(view.cellCounts[cell] > 0);
+          if(--view.cellCounts[cell] == 0)
+            view.score -= _pyramidWeights[level];
+        }
+      }
+      for(const std::size_t trackId : addedTracks)
+      {
+        for(std::size_t level = 0; level < _pyramidDepth; ++level)
+        {
+          const std::size_t cell = view.tracksPyramid->at(trackId * _pyramidDepth + level);
+          if(view.cellCounts[cell]++ == 0)
+            view.score += _pyramidWeights[level];
+        }
+      }
+      view.nbTracks += addedTracks.size();
+      view.nbTracks -= removedTracks.size();
+
+      // release the pyramid of the views without any reconstructed track
+      if(view.nbTracks == 0)
+        std::vector<std::uint32_t>().swap(view.cellCounts);
+    }
+
+    addedTracks.clear();
+    removedTracks.clear();
+  }
+
+  // move the queued views to their new place in the queue
+  for(const std::size_t viewIndex : changedViews)
+  {
+    ViewScore& view = _views[viewIndex];
+    ++view.version;
+
+    if(!view.isQueued)
+      continue;
+
+    if(view.nbTracks == 0)
+    {
+      view.isQueued = false;
+      --_nbQueuedViews;
+    }
+    else
+    {
+      _queue.push({view.score, view.viewId, view.version, viewIndex});
+    }
+  }
+
+  if(_queue.size() > 2 * _nbQueuedViews + 1024)
+    compactQueue();
+
+  _reconstructedTracks = reconstructedTracks;
+
+  return nbChangedTracks;
+}
+
+NextBestViewScoring::Candidate NextBestViewScoring::getCandidate(IndexT viewId) const
+{
+  Candidate candidate;
+  candidate.viewId = viewId;
+
+  const std::size_t viewIndex = getViewIndex(viewId);
+  if(viewIndex != _views.size())
+  {
+    candidate.nbTracks = _views[viewIndex].nbTracks;
+    candidate.score = _views[viewIndex].score;
+  }
+  return candidate;
+}
+
+void NextBestViewScoring::pushView(IndexT viewId)
+{
+  const std::size_t viewIndex = getViewIndex(viewId);
+  if(viewIndex == _views.size())
+    return;
+
+  ViewScore& view = _views[viewIndex];
+  if(view.isQueued || view.nbTracks == 0)
+    return;
+
+  view.isQueued = true;
+  ++_nbQueuedViews;
+  _queue.push({view.score, view.viewId, view.version, viewIndex});
+}
+
+bool NextBestViewScoring::popBestView(Candidate& out_candidate)
+{
+  while(!_queue.empty())
+  {
+    const QueueEntry entry = _queue.top();
+    _queue.pop();
+
+    ViewScore& view = _views[entry.viewIndex];
+
+    // outdated entry
+    if(!view.isQueued || view.version != entry.version)
+      continue;
+
+    view.isQueued = false;
+    --_nbQueuedViews;
+
+    out_candidate.viewId = view.viewId;
+    out_candidate.nbTracks = view.nbTracks;
+    out_candidate.score = view.score;
+    return true;
+  }
+  return false;
+}
+
+std::size_t NextBestViewScoring::getViewIndex(IndexT viewId) const
+{
+  const auto it = std::lower_bound(_views.begin(), _views.end(), viewId,
+                                   [](const ViewScore& view, IndexT id) { return view.viewId < id; });
+
+  if(it == _views.end() || it->viewId != viewId)
+    return _views.size();
+
+  return static_cast<std::size_t>(it - _views.begin());
+}
+
+void NextBestViewScoring::compactQueue()
+{
+  std::vector<QueueEntry> entries;
+  entries.reserve(_nbQueuedViews);
+
+  for(std::size_t viewIndex = 0; viewIndex < _views.size(); ++viewIndex)
+  {
+    const ViewScore& view = _views[viewIndex];
+    if(view.isQueued)
+      entries.push_back({view.score, view.viewId, view.version, viewIndex});
+  }
+
+  _queue = std::priority_queue<QueueEntry>(std::less<QueueEntry>(), std::move(entries));
+}
+
+} // namespace sfm
+} // namespace aliceVision
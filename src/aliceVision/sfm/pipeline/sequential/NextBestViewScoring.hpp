@@ -0,0 +1,157 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/track/Track.hpp>
+#include <aliceVision/track/TracksPerViewIndex.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Incremental next best view scores of the candidate views.
+ *
+ * The score of a view is based on the repartition in the image of its tracks already
+ * reconstructed (see ReconstructionEngine_sequentialSfM::computeCandidateImageScore):
+ * each occupied cell of the pyramid adds the weight of its level to the score.
+ *
+ * The pyramid occupancy of each view is kept between the iterations and only updated
+ * with the tracks that have been reconstructed (or removed) since the last update,
+ * the views are then retrieved by decreasing score from a priority queue.
+ * The cost of an iteration depends on the number of changed tracks instead of
+ * the number of tracks of all the remaining views.
+ */
+class NextBestViewScoring
+{
+public:
+
+  struct Candidate
+  {
+    IndexT viewId = UndefinedIndexT;
+    /// number of reconstructed tracks visible in the view
+    std::size_t nbTracks = 0;
+    /// pyramid score
+    std::size_t score = 0;
+  };
+
+  NextBestViewScoring() = default;
+
+  /**
+   * @brief Initialize the scoring, without any reconstructed track.
+   * @param[in] tracks All putative tracks
+   * @param[in] tracksPyramidPerView Precomputed pyramid cell of each track in each view
+   * @param[in] pyramidBase Base of the pyramid
+   * @param[in] pyramidWeights Weight of each pyramid level, if empty the score is the number of reconstructed tracks
+   */
+  void initialize(const track::TracksMap& tracks,
+                  const track::TracksPyramidPerView& tracksPyramidPerView,
+                  std::size_t pyramidBase,
+                  const std::vector<int>& pyramidWeights);
+
+  /**
+   * @brief Clear all the scores and the queue.
+   */
+  void clear();
+
+  /**
+   * @brief Update the scores with the current set of reconstructed tracks.
+   *        Only the tracks that changed since the last update are processed (in parallel per view).
+   * @param[in] reconstructedTracks The ids of the reconstructed tracks
+   * @return the number of changed tracks
+   */
+  std::size_t update(const track::TrackIdBitset& reconstructedTracks);
+
+  /**
+   * @brief Get the current candidate data of a view.
+   * @param[in] viewId The view id
+   * @return the candidate (nbTracks and score are 0 for unknown views)
+   */
+  Candidate getCandidate(IndexT viewId) const;
+
+  /**
+   * @brief Add a view to the queue of candidates, if it is not already in and if it sees reconstructed tracks.
+   *        Views keep their place in the queue when their score is updated.
+   * @param[in] viewId The view id
+   */
+  void pushView(IndexT viewId);
+
+  /**
+   * @brief Remove the view with the best score from the queue of candidates.
+   *        Ties are broken by the lowest view id.
+   * @param[out] out_candidate The best candidate
+   * @return false if the queue is empty
+   */
+  bool popBestView(Candidate& out_candidate);
+
+  /**
+   * @brief Get the number of views in the queue of candidates.
+   */
+  inline std::size_t nbQueuedViews() const { return _nbQueuedViews; }
+
+private:
+
+  struct ViewScore
+  {
+    IndexT viewId = UndefinedIndexT;
+    /// precomputed pyramid cell of each track (trackId * depth + level)
+    const stl::flat_map<std::size_t, std::size_t>* tracksPyramid = nullptr;
+    /// number of reconstructed tracks in each pyramid cell (allocated with the first reconstructed track)
+    std::vector<std::uint32_t> cellCounts;
+    std::size_t nbTracks = 0;
+    std::size_t score = 0;
+    /// incremented at each change, to invalidate the previous queue entries
+    std::uint32_t version = 0;
+    bool isQueued = false;
+  };
+
+  struct QueueEntry
+  {
+    std::size_t score;
+    IndexT viewId;
+    std::uint32_t version;
+    std::size_t viewIndex;
+
+    bool operator<(const QueueEntry& other) const
+    {
+      // best score first, then lowest view id
+      if(score != other.score)
+        return score < other.score;
+      return viewId > other.viewId;
+    }
+  };
+
+  /// return the index of the view in _views (or _views.size() if unknown)
+  std::size_t getViewIndex(IndexT viewId) const;
+
+  /// rebuild the queue without the outdated entries
+  void compactQueue();
+
+  std::size_t _pyramidDepth = 0;
+  std::size_t _nbCells = 0;
+  std::vector<int> _pyramidWeights;
+  const track::TracksMap* _tracks = nullptr;
+
+  /// view scores sorted by view id
+  std::vector<ViewScore> _views;
+  /// changed tracks per view, only used during the update
+  std::vector<std::vector<std::size_t>> _addedTracksPerView;
+  std::vector<std::vector<std::size_t>> _removedTracksPerView;
+  /// reconstructed tracks at the last update
+  track::TrackIdBitset _reconstructedTracks;
+
+  std::priority_queue<QueueEntry> _queue;
+  std::size_t _nbQueuedViews = 0;
+};
+
+} // namespace sfm
+} // namespace aliceVision
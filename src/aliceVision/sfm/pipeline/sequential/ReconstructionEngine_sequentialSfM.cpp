@@ -10,9 +10,11 @@
 #include <aliceVision/sfm/utils/statistics.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/sfm/bundle/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/bundle/BundleAdjustmentSchur.hpp>
 #include <aliceVision/sfm/bundle/BundleAdjustmentSymbolicCeres.hpp>
 #include <aliceVision/sfm/sfmFilters.hpp>
 #include <aliceVision/sfm/sfmStatistics.hpp>
+#include <aliceVision/sfm/BatchTriangulation.hpp>
 
 #include <aliceVision/feature/FeaturesPerView.hpp>
 #include <aliceVision/graph/connectedComponent.hpp>
@@ -167,6 +169,13 @@ bool ReconstructionEngine_sequentialSfM::process()
     throw std::runtime_error("No valid tracks.");
   }
 
+#ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
+  // the score of a view is its number of reconstructed tracks
+  _nextBestViewScoring.initialize(_map_tracks, _map_featsPyramidPerView, _params.pyramidBase, {});
+#else
+  _nextBestViewScoring.initialize(_map_tracks, _map_featsPyramidPerView, _params.pyramidBase, _pyramidWeights);
+#endif
+
   if (!_sfmData.getLandmarks().empty())
   {
       if (_sfmData.getPoses().empty())
@@ -265,6 +274,7 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
         _map_tracksPerView[viewIt.first];
     }
     track::computeTracksPerView(_map_tracks, _map_tracksPerView);
+    _tracksPerViewIndex.build(_map_tracksPerView);
     ALICEVISION_LOG_DEBUG("Build tracks pyramid per view");
     computeTracksPyramidPerView(
             _map_tracksPerView, _map_tracks, _sfmData.getViews(), *_featuresPerView, _params.pyramidBase, _params.pyramidDepth, _map_featsPyramidPerView);
@@ -493,6 +503,8 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
     std::size_t nbValidPoses = 0;
     std::size_t globalIteration = 0;
 
+    _resectionGroupSize = _params.maxImagesPerGroup;
+
     do
     {
         // Compute intersection of available views and views with potential changes
@@ -535,7 +547,17 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
             }
 
             //Return the difference between reconstructed views and prevReconstructedViews
-            std::set<IndexT> newReconstructedViews = resection(resectionId, bestViewCandidates, prevReconstructedViews);
+            std::set<IndexT> newReconstructedViews;
+            if(_params.useSpeculativeResection)
+            {
+                // deferred and rejected views are visited again in the next global iteration
+                newReconstructedViews = speculativeResection(resectionId, bestViewCandidates, prevReconstructedViews, potentials);
+            }
+            else
+            {
+                newReconstructedViews = resection(resectionId, bestViewCandidates, prevReconstructedViews);
+            }
+
             if(newReconstructedViews.empty())
             {
                 continue;
@@ -562,6 +584,7 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
             }
 
             triangulate(prevReconstructedViews, newReconstructedViews);
+
             bundleAdjustment(newReconstructedViews);
 
             //Only update prevReconstructedViews after the resectioned views have been refined
@@ -638,38 +661,9 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
   for(int i = 0; i < bestViewIds.size(); ++i)
   {
     const IndexT viewId = bestViewIds.at(i);
-    const View& view = *_sfmData.getViews().at(viewId);
-
-    if(view.isPartOfRig())
-    {
-      // some views can become indirectly localized when the sub-pose becomes defined
-      if(_sfmData.isPoseAndIntrinsicDefined(view.getViewId()))
-      {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " was skipped." << std::endl
-          << "View indirectly localized, sub-pose and pose already defined." << std::endl
-          << "\t- view id: " << viewId << std::endl
-          << "\t- rig id: " << view.getRigId() << std::endl
-          << "\t- sub-pose id: " << view.getSubPoseId());
-
-        continue;
-      }
-
-      // we cannot localize a view if it is part of an initialized rig with unknown rig pose and unknown sub-pose
-      const bool knownPose = _sfmData.existsPose(view);
-      const Rig& rig = _sfmData.getRig(view);
-      const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
 
-      if(rig.isInitialized() && !knownPose && (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
-      {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " was skipped." << std::endl
-          << "Rig initialized but unkown pose and sub-pose." << std::endl
-          << "\t- view id: " << viewId << std::endl
-          << "\t- rig id: " << view.getRigId() << std::endl
-          << "\t- sub-pose id: " << view.getSubPoseId());
-
-        continue;
-      }
-    }
+    if(!isResectionPossible(viewId))
+      continue;
 
     ResectionData newResectionData;
     newResectionData.error_max = _params.localizerEstimatorError;
@@ -710,6 +704,216 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
   return newReconstructedViews;
 }
 
+bool ReconstructionEngine_sequentialSfM::isResectionPossible(IndexT viewId) const
+{
+  const View& view = *_sfmData.getViews().at(viewId);
+
+  if(!view.isPartOfRig())
+    return true;
+
+  // some views can become indirectly localized when the sub-pose becomes defined
+  if(_sfmData.isPoseAndIntrinsicDefined(view.getViewId()))
+  {
+    ALICEVISION_LOG_DEBUG("Resection of image " << viewId << " was skipped." << std::endl
+      << "View indirectly localized, sub-pose and pose already defined." << std::endl
+      << "\t- view id: " << viewId << std::endl
+      << "\t- rig id: " << view.getRigId() << std::endl
+      << "\t- sub-pose id: " << view.getSubPoseId());
+
+    return false;
+  }
+
+  // we cannot localize a view if it is part of an initialized rig with unknown rig pose and unknown sub-pose
+  const bool knownPose = _sfmData.existsPose(view);
+  const Rig& rig = _sfmData.getRig(view);
+  const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
+
+  if(rig.isInitialized() && !knownPose && (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
+  {
+    ALICEVISION_LOG_DEBUG("Resection of image " << viewId << " was skipped." << std::endl
+      << "Rig initialized but unkown pose and sub-pose." << std::endl
+      << "\t- view id: " << viewId << std::endl
+      << "\t- rig id: " << view.getRigId() << std::endl
+      << "\t- sub-pose id: " << view.getSubPoseId());
+
+    return false;
+  }
+
+  return true;
+}
+
+std::set<IndexT> ReconstructionEngine_sequentialSfM::speculativeResection(IndexT resectionId,
+                                                                          const std::vector<IndexT>& bestViewIds,
+                                                                          const std::set<IndexT>& prevReconstructedViews,
+                                                                          std::set<IndexT>& deferredViewIds)
+{
+  auto chrono_start = std::chrono::steady_clock::now();
+
+  std::vector<ResectionData> resectionsData(bestViewIds.size());
+  std::vector<char> hasResected(bestViewIds.size(), 0);
+  std::vector<char> hadPose(bestViewIds.size(), 0);
+
+  // speculative resection of all the views against the current scene,
+  // the scene is only read until all the resections are done
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < bestViewIds.size(); ++i)
+  {
+    const IndexT viewId = bestViewIds.at(i);
+
+    if(!isResectionPossible(viewId))
+      continue;
+
+    hadPose[i] = _sfmData.existsPose(*_sfmData.getViews().at(viewId));
+
+    ResectionData& resectionData = resectionsData[i];
+    resectionData.error_max = _params.localizerEstimatorError;
+    resectionData.max_iteration = _params.localizerEstimatorMaxIterations;
+    hasResected[i] = computeResection(viewId, resectionData);
+  }
+
+  // commit the successful resections in the order of the candidates (best score first)
+  std::map<IndexT, const ResectionData*> committedResectionsData;
+  std::map<IndexT, CameraPose> previousPoses;
+  std::size_t nbDeferredViews = 0;
+  for(std::size_t i = 0; i < bestViewIds.size(); ++i)
+  {
+    const IndexT viewId = bestViewIds.at(i);
+
+    if(!hasResected[i])
+    {
+      ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was not possible.");
+      continue;
+    }
+
+    // the rig pose has been defined by an other view of the group since the speculative resection
+    const View& view = *_sfmData.getViews().at(viewId);
+    if(view.isPartOfRig() && !hadPose[i] && _sfmData.existsPose(view))
+    {
+      ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) deferred, "
+                            "rig pose defined by an other view of the resection group.");
+      deferredViewIds.insert(viewId);
+      ++nbDeferredViews;
+      continue;
+    }
+
+    // a view of a rig with a known rig pose and an uninitialized sub-pose overwrites the rig pose
+    if(hadPose[i])
+      previousPoses.emplace(view.getPoseId(), _sfmData.getAbsolutePose(view.getPoseId()));
+
+    updateScene(viewId, resectionsData[i]);
+    ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
+    _sfmData.getViews().at(viewId)->setResectionId(resectionId);
+    committedResectionsData.emplace(viewId, &resectionsData[i]);
+  }
+
+  // check the committed views against the scene before they are used for the triangulation
+  const std::set<IndexT> rejectedViews = rejectInconsistentViews(committedResectionsData, previousPoses);
+  deferredViewIds.insert(rejectedViews.begin(), rejectedViews.end());
+  updateResectionGroupSize(committedResectionsData.size(), rejectedViews.size());
+
+  ALICEVISION_LOG_DEBUG("Speculative resection of " << bestViewIds.size() << " new images (" << nbDeferredViews << " deferred, " << rejectedViews.size() << " rejected) took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
+
+  // get new reconstructed views
+  std::set<IndexT> newReconstructedViews;
+  {
+    // get reconstructed views after resection
+    const std::set<IndexT> reconstructedViews = _sfmData.getValidViews();
+
+    std::set_difference(
+          reconstructedViews.begin(),
+          reconstructedViews.end(),
+          prevReconstructedViews.begin(),
+          prevReconstructedViews.end(),
+          std::inserter(newReconstructedViews, newReconstructedViews.end()));
+  }
+
+  return newReconstructedViews;
+}
+
+std::set<IndexT> ReconstructionEngine_sequentialSfM::rejectInconsistentViews(const std::map<IndexT, const ResectionData*>& resectionsData,
+                                                                             const std::map<IndexT, CameraPose>& previousPoses)
+{
+  const std::vector<std::pair<IndexT, const ResectionData*>> resections(resectionsData.begin(), resectionsData.end());
+  std::vector<std::size_t> nbConsistentInliers(resections.size(), 0);
+
+  // reproject the landmarks of the resection inliers with the committed pose of each view,
+  // these landmarks have not been modified since the resection
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < resections.size(); ++i)
+  {
+    const ResectionData& resectionData = *resections.at(i).second;
+    const View& view = *_sfmData.getViews().at(resections.at(i).first);
+    const Pose3 pose = _sfmData.getPose(view).getTransform();
+    const camera::IntrinsicBase* intrinsic = _sfmData.getIntrinsicPtr(view.getIntrinsicId());
+
+    for(const std::size_t inlier : resectionData.vec_inliers)
+    {
+      const Vec3 X = resectionData.pt3D.col(inlier);
+      const Vec2 residual = intrinsic->residual(pose, X.homogeneous(), resectionData.pt2D.col(inlier));
+
+      if(pose.depth(X) > 0 && residual.norm() < _params.maxReprojectionError)
+        ++nbConsistentInliers[i];
+    }
+  }
+
+  std::set<IndexT> rejectedViews;
+  for(std::size_t i = 0; i < resections.size(); ++i)
+  {
+    const IndexT viewId = resections.at(i).first;
+    const ResectionData& resectionData = *resections.at(i).second;
+    const std::size_t nbInliers = resectionData.vec_inliers.size();
+
+    if(nbInliers > 0 && nbConsistentInliers.at(i) >= _params.speculativeResectionMinConsistency * nbInliers)
+      continue;
+
+    ALICEVISION_LOG_DEBUG("Speculative resection of view " << viewId << " rejected: "
+                          << nbConsistentInliers.at(i) << " / " << nbInliers << " consistent resection inliers.");
+    rejectedViews.insert(viewId);
+
+    // remove the observations added by updateScene, the landmarks keep the observations of the previous views
+    Landmarks& landmarks = _sfmData.getLandmarks();
+    for(const std::size_t trackId : resectionData.tracksId)
+    {
+      auto landmarkIt = landmarks.find(trackId);
+      if(landmarkIt != landmarks.end())
+        landmarkIt->second.observations.erase(viewId);
+    }
+
+    View& view = *_sfmData.getViews().at(viewId);
+    const auto previousPoseIt = previousPoses.find(view.getPoseId());
+    if(previousPoseIt != previousPoses.end())
+      _sfmData.getPoses()[view.getPoseId()] = previousPoseIt->second;
+    else
+      _sfmData.erasePose(view.getPoseId(), true);
+
+    view.setResectionId(UndefinedIndexT);
+    _map_ACThreshold.erase(viewId);
+  }
+
+  if(!rejectedViews.empty())
+    ALICEVISION_LOG_INFO("Speculative resection: " << rejectedViews.size() << " inconsistent views rejected.");
+
+  return rejectedViews;
+}
+
+void ReconstructionEngine_sequentialSfM::updateResectionGroupSize(std::size_t nbResectedViews, std::size_t nbRejectedViews)
+{
+  // no limit on the number of views added at once
+  if(_params.maxImagesPerGroup == 0 || nbResectedViews == 0)
+    return;
+
+  const double rejectedRatio = nbRejectedViews / static_cast<double>(nbResectedViews);
+
+  // grow the groups while the speculative resections are reliable, go back to smaller groups otherwise
+  if(rejectedRatio < 0.05 && nbResectedViews >= _resectionGroupSize)
+    _resectionGroupSize = std::min(2 * _resectionGroupSize, std::max(_params.maxImagesPerGroup, _params.speculativeResectionMaxImagesPerGroup));
+  else if(rejectedRatio > 0.2)
+    _resectionGroupSize = std::max(_resectionGroupSize / 2, _params.maxImagesPerGroup);
+
+  ALICEVISION_LOG_DEBUG("Speculative resection: " << nbRejectedViews << " / " << nbResectedViews << " views rejected, "
+                        "next resection group size: " << _resectionGroupSize);
+}
+
 void ReconstructionEngine_sequentialSfM::triangulate(const std::set<IndexT>& prevReconstructedViews, const std::set<IndexT>& newReconstructedViews)
 {
   auto chrono_start = std::chrono::steady_clock::now();
@@ -728,7 +932,17 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
   ALICEVISION_LOG_INFO("Bundle adjustment start.");
   auto chronoStart = std::chrono::steady_clock::now();
 
-  BundleAdjustmentCeres::CeresOptions options;
+  const bool useCeres = (_params.bundleAdjustmentSolver == EBundleAdjustmentSolver::CERES);
+
+  // reuse the problem of the previous bundle adjustments
+  if(useCeres && _params.usePersistentBundleAdjustment && _bundleAdjustment == nullptr)
+  {
+    BundleAdjustmentCeres::CeresOptions persistentOptions;
+    persistentOptions.persistentProblem = true;
+    _bundleAdjustment = std::make_shared<BundleAdjustmentCeres>(persistentOptions, _params.minNbCamerasToRefinePrincipalPoint);
+  }
+
+  BundleAdjustmentCeres::CeresOptions options = (_bundleAdjustment != nullptr) ? _bundleAdjustment->getCeresOptions() : BundleAdjustmentCeres::CeresOptions();
   BundleAdjustment::ERefineOptions refineOptions = BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE;
 
   if(!isInitialPair && !_params.lockAllIntrinsics)
@@ -783,11 +997,31 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
     }
   }
 
-  BundleAdjustmentCeres BA(options, _params.minNbCamerasToRefinePrincipalPoint);
+  std::shared_ptr<BundleAdjustmentCeres> ceresBA;
+  std::shared_ptr<BundleAdjustmentSchur> schurBA;
+  std::shared_ptr<BundleAdjustment> BA;
 
-  // give the local strategy graph is local strategy is enable
-  if(enableLocalStrategy)
-    BA.useLocalStrategyGraph(_localStrategyGraph);
+  if(useCeres)
+  {
+    ceresBA = _bundleAdjustment;
+
+    if(ceresBA != nullptr)
+      ceresBA->setCeresOptions(options);
+    else
+      ceresBA = std::make_shared<BundleAdjustmentCeres>(options, _params.minNbCamerasToRefinePrincipalPoint);
+
+    // give the local strategy graph is local strategy is enable
+    ceresBA->useLocalStrategyGraph(enableLocalStrategy ? _localStrategyGraph : nullptr);
+    BA = ceresBA;
+  }
+  else
+  {
+    schurBA = std::make_shared<BundleAdjustmentSchur>(BundleAdjustmentSchur::SchurOptions(), _params.minNbCamerasToRefinePrincipalPoint);
+
+    // give the local strategy graph is local strategy is enable
+    schurBA->useLocalStrategyGraph(enableLocalStrategy ? _localStrategyGraph : nullptr);
+    BA = schurBA;
+  }
 
   // perform BA until all point are under the given precision
   do
@@ -797,7 +1031,7 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
 
     // bundle adjustment iteration
     {
-      const bool success = BA.adjust(_sfmData, refineOptions);
+      const bool success = BA->adjust(_sfmData, refineOptions);
 
       if(!success)
         return false; // not usable solution
@@ -807,9 +1041,16 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
         _localStrategyGraph->saveIntrinsicsToHistory(_sfmData);
 
       // export and print information about the refinement
-      const BundleAdjustmentCeres::Statistics& statistics = BA.getStatistics();
-      statistics.exportToFile(_outputFolder, "bundle_adjustment.csv");
-      statistics.show();
+      if(ceresBA != nullptr)
+      {
+        const BundleAdjustmentCeres::Statistics& statistics = ceresBA->getStatistics();
+        statistics.exportToFile(_outputFolder, "bundle_adjustment.csv");
+        statistics.show();
+      }
+      else
+      {
+        schurBA->getStatistics().show();
+      }
     }
 
     nbOutliers = removeOutliers();
@@ -981,10 +1222,8 @@ bool ReconstructionEngine_sequentialSfM::findConnectedViews(
     return false;
 
   // Collect tracksIds
-  std::set<size_t> reconstructed_trackId;
-  std::transform(_sfmData.getLandmarks().begin(), _sfmData.getLandmarks().end(),
-                 std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
-                 stl::RetrieveKey());
+  track::TrackIdBitset reconstructed_trackId;
+  getReconstructedTracks(reconstructed_trackId);
 
   const std::set<IndexT> reconstructedIntrinsics = _sfmData.getReconstructedIntrinsics();
 
@@ -998,8 +1237,7 @@ bool ReconstructionEngine_sequentialSfM::findConnectedViews(
     const bool isIntrinsicsReconstructed = reconstructedIntrinsics.count(intrinsicId);
 
     // Compute 2D - 3D possible content
-    const aliceVision::track::TrackIdSet& set_tracksIds = _map_tracksPerView.at(viewId);
-    if (set_tracksIds.empty())
+    if (_tracksPerViewIndex.getTracks(viewId).empty())
       continue;
 
     // Check if the view is part of a rig
@@ -1031,11 +1269,7 @@ bool ReconstructionEngine_sequentialSfM::findConnectedViews(
     // Count the common possible putative point
     //  with the already 3D reconstructed trackId
     std::vector<std::size_t> vec_trackIdForResection;
-    vec_trackIdForResection.reserve(set_tracksIds.size());
-    std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
-                          reconstructed_trackId.begin(),
-                          reconstructed_trackId.end(),
-                          std::back_inserter(vec_trackIdForResection));
+    _tracksPerViewIndex.getCommonTracks(viewId, reconstructed_trackId, vec_trackIdForResection);
     // Compute an image score based on the number of matches to the 3D scene
     // and the repartition of these features in the image.
     std::size_t score = computeCandidateImageScore(viewId, vec_trackIdForResection);
@@ -1055,102 +1289,121 @@ bool ReconstructionEngine_sequentialSfM::findConnectedViews(
 
 bool ReconstructionEngine_sequentialSfM::findNextBestViews(
   std::vector<IndexT> & out_selectedViewIds,
-  const std::set<IndexT>& remainingViewIds) const
+  const std::set<IndexT>& remainingViewIds)
 {
   out_selectedViewIds.clear();
   auto chrono_start = std::chrono::steady_clock::now();
-  std::vector<ViewConnectionScore> vec_viewsScore;
-  if(!findConnectedViews(vec_viewsScore, remainingViewIds))
+
+  if(remainingViewIds.empty() || _sfmData.getLandmarks().empty())
   {
     ALICEVISION_LOG_DEBUG("FindConnectedViews does not find connected new views ");
     return false;
   }
 
+  // update the scores with the tracks reconstructed (or removed) since the last selection
+  track::TrackIdBitset reconstructedTracks;
+  getReconstructedTracks(reconstructedTracks);
+  const std::size_t nbChangedTracks = _nextBestViewScoring.update(reconstructedTracks);
+
+  // views which become remaining again (e.g. rejected resections) go back to the queue,
+  // the views already in the queue keep their place
+  for(const IndexT viewId : remainingViewIds)
+    _nextBestViewScoring.pushView(viewId);
+
+  const std::set<IndexT> reconstructedIntrinsics = _sfmData.getReconstructedIntrinsics();
+
   // Impose a minimal number of points to ensure that it makes sense to try the pose estimation.
   static const std::size_t minPointsThreshold = 30;
 
-  ALICEVISION_LOG_DEBUG("findNextBestViews -- Scores (features): ");
-  // print the 30 best scores
-  for(std::size_t i = 0; i < vec_viewsScore.size() && i < 30; ++i)
+  // If the number of cameras is less than nbFirstUnstableCameras, then the bundle adjustment should be performed
+  // every time a new camera is added: it is not expensive as there is very little data and it gives more stable results.
+  // No more than maxImagesPerGroup cameras should be added at once without performing the bundle adjustment (if set to
+  // 0, then there is no limit on the number of views that can be added at once).
+  // With the speculative resection, the group size adapts to the ratio of rejected views.
+  const bool isUnstable = _sfmData.getPoses().size() < _params.nbFirstUnstableCameras;
+  const std::size_t maxImagesPerGroup = isUnstable ? 1 : (_params.useSpeculativeResection ? _resectionGroupSize : _params.maxImagesPerGroup);
+
+  std::size_t scoreThreshold = _pyramidThreshold;
+  std::vector<ViewConnectionScore> selectedViewsScore;
+  // candidates not selected in this iteration, put back in the queue
+  std::vector<IndexT> skippedViewIds;
+
+  // get the candidates by decreasing score
+  NextBestViewScoring::Candidate candidate;
+  while(_nextBestViewScoring.popBestView(candidate))
   {
-    ALICEVISION_LOG_DEBUG_OBJ << std::get<2>(vec_viewsScore[i]) << "(" << std::get<1>(vec_viewsScore[i]) << "), ";
-  }
-  ALICEVISION_LOG_DEBUG_OBJ << std::endl;
+    // reconstructed views leave the queue
+    if(remainingViewIds.count(candidate.viewId) == 0)
+      continue;
 
-  // If the list is empty or if the list contains images with no correspondences
-  // -> (no resection will be possible)
-  if (vec_viewsScore.empty() || std::get<1>(vec_viewsScore[0]) == 0)
-  {
-    ALICEVISION_LOG_DEBUG("Failed to find next best views :");
-    if(vec_viewsScore.empty())
-    {
-      ALICEVISION_LOG_DEBUG("No putative image.");
-    }
-    else
+    // some views of a rig cannot be localized yet
+    if(!isResectionPossible(candidate.viewId))
     {
-      ALICEVISION_LOG_DEBUG_OBJ << "Not enough point in the putative images: ";
-      for(auto v: vec_viewsScore)
-        ALICEVISION_LOG_DEBUG_OBJ << std::get<1>(v) << ", ";
+      skippedViewIds.push_back(candidate.viewId);
+      continue;
     }
-    ALICEVISION_LOG_DEBUG_OBJ << std::endl;
-    // All remaining images cannot be used for pose estimation
-    return false;
-  }
 
-  // Add the image view index with the best score
-  out_selectedViewIds.push_back(std::get<0>(vec_viewsScore[0]));
+    const IndexT intrinsicId = _sfmData.getViews().at(candidate.viewId)->getIntrinsicId();
+    const bool isIntrinsicsReconstructed = reconstructedIntrinsics.count(intrinsicId);
 
   #ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
     static const float dThresholdGroup = 0.75f;
-    // Number of 2D-3D correspondences for the best view.
-    const IndexT bestScore = std::get<2>(vec_viewsScore[0]);
     // Add all the image view indexes that have at least N% of the score of the best image.
-    const size_t scoreThreshold = dThresholdGroup * bestScore;
-  #else
-    const std::size_t scoreThreshold = _pyramidThreshold;
+    if(selectedViewsScore.empty())
+      scoreThreshold = dThresholdGroup * candidate.score;
   #endif
 
-  for (std::size_t i = 1;
-       i < vec_viewsScore.size() &&
-       std::get<1>(vec_viewsScore[i]) > minPointsThreshold && // ensure min number of points
-       std::get<2>(vec_viewsScore[i]) > scoreThreshold; // ensure score level
-       ++i)
-  {
-    out_selectedViewIds.push_back(std::get<0>(vec_viewsScore[i]));
-    if(!std::get<3>(vec_viewsScore[i]))
+    // The image view index with the best score is always added
+    if(!selectedViewsScore.empty() &&
+       (candidate.nbTracks <= minPointsThreshold || // ensure min number of points
+        candidate.score <= scoreThreshold)) // ensure score level
     {
-      // If we add a new intrinsic, it is a sensitive stage in the process,
-      // so it is better to perform a Bundle Adjustment just after.
+      skippedViewIds.push_back(candidate.viewId);
       break;
     }
+
+    selectedViewsScore.emplace_back(candidate.viewId, candidate.nbTracks, candidate.score, isIntrinsicsReconstructed);
+
+    // If we add a new intrinsic, it is a sensitive stage in the process,
+    // so it is better to perform a Bundle Adjustment just after.
+    if(selectedViewsScore.size() > 1 && !isIntrinsicsReconstructed)
+      break;
+
+    if(maxImagesPerGroup > 0 && selectedViewsScore.size() >= maxImagesPerGroup)
+      break;
   }
 
-  // If the number of cameras is less than nbFirstUnstableCameras, then the bundle adjustment should be performed
-  // every time a new camera is added: it is not expensive as there is very little data and it gives more stable results.
-  if(_sfmData.getPoses().size() < _params.nbFirstUnstableCameras &&
-     !out_selectedViewIds.empty())
+  for(const IndexT viewId : skippedViewIds)
+    _nextBestViewScoring.pushView(viewId);
+
+  if(selectedViewsScore.empty())
+  {
+    ALICEVISION_LOG_DEBUG("Failed to find next best views :");
+    ALICEVISION_LOG_DEBUG("No putative image.");
+    // All remaining images cannot be used for pose estimation
+    return false;
+  }
+
+  if(isUnstable)
   {
     // add images one by one to reconstruct the first cameras
     ALICEVISION_LOG_DEBUG("findNextBestViews: beginning of the incremental SfM" << std::endl
       << "Only the first image of the resection group is used." << std::endl
-      << "\t- image view id : " << out_selectedViewIds.front() << std::endl
+      << "\t- image view id : " << std::get<0>(selectedViewsScore.front()) << std::endl
       << "\t- # unstable poses : " << _sfmData.getPoses().size() << " / " << _params.nbFirstUnstableCameras << std::endl);
-
-    out_selectedViewIds.resize(1);
   }
 
-  // No more than maxImagesPerGroup cameras should be added at once without performing the bundle adjustment (if set to
-  // 0, then there is no limit on the number of views that can be added at once)
-  if(_params.maxImagesPerGroup > 0 && out_selectedViewIds.size() > _params.maxImagesPerGroup)
-    out_selectedViewIds.resize(_params.maxImagesPerGroup);
+  for(const ViewConnectionScore& viewScore : selectedViewsScore)
+    out_selectedViewIds.push_back(std::get<0>(viewScore));
 
   ALICEVISION_LOG_DEBUG(
     "Find next best views took: " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec\n"
     "\t# images : " << out_selectedViewIds.size() << "\n"
-    "\t- scores: from " << std::get<2>(vec_viewsScore.front()) << " to " << std::get<2>(vec_viewsScore[out_selectedViewIds.size()-1]) << " (threshold was " << scoreThreshold << ")\n"
-    "\t- features: from " << std::get<1>(vec_viewsScore.front()) << " to " << std::get<1>(vec_viewsScore[out_selectedViewIds.size()-1]) << " (threshold was " << minPointsThreshold << ")");
+    "\t# changed tracks : " << nbChangedTracks << "\n"
+    "\t- scores: from " << std::get<2>(selectedViewsScore.front()) << " to " << std::get<2>(selectedViewsScore.back()) << " (threshold was " << scoreThreshold << ")\n"
+    "\t- features: from " << std::get<1>(selectedViewsScore.front()) << " to " << std::get<1>(selectedViewsScore.back()) << " (threshold was " << minPointsThreshold << ")");
 
-  return (!out_selectedViewIds.empty());
+  return true;
 }
 
 bool ReconstructionEngine_sequentialSfM::makeInitialPair3D(const Pair& currentPair)
@@ -1189,7 +1442,7 @@ bool ReconstructionEngine_sequentialSfM::makeInitialPair3D(const Pair& currentPa
   // b. get common features between the two views
   // use the track to have a more dense match correspondence set
   aliceVision::track::TracksMap commonTracks;
-  track::getCommonTracksInImagesFast({I, J}, _map_tracks, _map_tracksPerView, commonTracks);
+  track::getCommonTracksInImagesFast({I, J}, _map_tracks, _tracksPerViewIndex, commonTracks);
 
   // copy point to arrays
   const std::size_t n = commonTracks.size();
@@ -1381,7 +1634,7 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
 
     aliceVision::track::TracksMap map_tracksCommon;
     const std::set<size_t> set_imageIndex= {I, J};
-    track::getCommonTracksInImagesFast(set_imageIndex, _map_tracks, _map_tracksPerView, map_tracksCommon);
+    track::getCommonTracksInImagesFast(set_imageIndex, _map_tracks, _tracksPerViewIndex, map_tracksCommon);
 
     // Copy points correspondences to arrays for relative pose estimation
     const size_t n = map_tracksCommon.size();
@@ -1485,6 +1738,17 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
   return true;
 }
 
+void ReconstructionEngine_sequentialSfM::getReconstructedTracks(track::TrackIdBitset& out_tracksIds) const
+{
+  out_tracksIds.resize(_tracksPerViewIndex.nbTracks());
+  for(const auto& landmarkIt : _sfmData.getLandmarks())
+  {
+    // landmarks outside of the index are not visible in any putative track
+    if(landmarkIt.first < out_tracksIds.size())
+      out_tracksIds.set(landmarkIt.first);
+  }
+}
+
 std::size_t ReconstructionEngine_sequentialSfM::computeCandidateImageScore(IndexT viewId, const std::vector<std::size_t>& trackIds) const
 {
 #ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
@@ -1523,20 +1787,17 @@ std::size_t ReconstructionEngine_sequentialSfM::computeCandidateImageScore(Index
 bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewId, ResectionData& resectionData)
 {
   // A. Compute 2D/3D matches
-  // A1. list tracks ids used by the view
-  const aliceVision::track::TrackIdSet& set_tracksIds = _map_tracksPerView.at(viewId);
-
-  // A2. intersects the track list with the reconstructed
-  std::set<std::size_t> reconstructed_trackId;
-  std::transform(_sfmData.getLandmarks().begin(), _sfmData.getLandmarks().end(),
-                 std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
-                 stl::RetrieveKey());
-  
-  // Get the ids of the already reconstructed tracks
-  std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
-                        reconstructed_trackId.begin(),
-                        reconstructed_trackId.end(),
-                        std::inserter(resectionData.tracksId, resectionData.tracksId.begin()));
+  // A1. list tracks ids already reconstructed
+  track::TrackIdBitset reconstructed_trackId;
+  getReconstructedTracks(reconstructed_trackId);
+
+  // A2. intersects the track list of the view with the reconstructed
+  std::vector<std::size_t> vec_tracksIds;
+  _tracksPerViewIndex.getCommonTracks(viewId, reconstructed_trackId, vec_tracksIds);
+
+  // Get the ids of the already reconstructed tracks (sorted)
+  for(const std::size_t trackId : vec_tracksIds)
+    resectionData.tracksId.insert(resectionData.tracksId.end(), trackId);
   
   if (resectionData.tracksId.empty())
   {
@@ -1668,41 +1929,6 @@ void ReconstructionEngine_sequentialSfM::updateScene(const IndexT viewIndex, con
   }
 }
 
-bool ReconstructionEngine_sequentialSfM::checkChieralities(
-  const Vec3& pt3D, 
-  const std::set<IndexT> & viewsId, 
-  const SfMData& scene)
-{
-  for (const IndexT & viewId : viewsId)
-  {
-    const View* view = scene.getViews().at(viewId).get();
-    const Pose3 pose = scene.getPose(*view).getTransform();
-    // Check that the point is in front of all the cameras.
-    if (pose.depth(pt3D) < 0) 
-      return false;
-  }
-  return true;
-}
-
-bool ReconstructionEngine_sequentialSfM::checkAngles(const Vec3 &pt3D, const std::set<IndexT> &viewsId, const SfMData &scene, const double &kMinAngle)
-{ 
-  for (const std::size_t & viewIdA : viewsId)
-  {
-    for (const std::size_t & viewIdB : viewsId)
-    {
-      if (viewIdA < viewIdB)
-      {
-        double angle_deg = angleBetweenRays(scene.getPose(*scene.getViews().at(viewIdA).get()).getTransform(),
-                                           scene.getPose(*scene.getViews().at(viewIdB).get()).getTransform(),
-                                           pt3D);
-        if (angle_deg >= kMinAngle)
-          return true;
-      }
-    }
-  }
-  return false;
-}
-
 void ReconstructionEngine_sequentialSfM::getTracksToTriangulate(const std::set<IndexT>& previousReconstructedViews, 
                                                                 const std::set<IndexT>& newReconstructedViews, 
                                                                 std::map<IndexT, std::set<IndexT>> & mapTracksToTriangulate) const
@@ -1712,7 +1938,7 @@ void ReconstructionEngine_sequentialSfM::getTracksToTriangulate(const std::set<I
   allReconstructedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
   
   std::set<IndexT> allTracksInNewViews;
-  track::getTracksInImagesFast(newReconstructedViews, _map_tracksPerView, allTracksInNewViews);
+  track::getTracksInImagesFast(newReconstructedViews, _tracksPerViewIndex, allTracksInNewViews);
   
   std::set<IndexT>::iterator it;
 #pragma omp parallel private(it)
@@ -1745,45 +1971,6 @@ void ReconstructionEngine_sequentialSfM::getTracksToTriangulate(const std::set<I
   }
 }
 
-namespace {
-
-struct ObservationData
-{
-    std::shared_ptr<camera::Pinhole> cam;
-    Pose3 pose;
-    Mat34 P;
-    Vec2 x;
-    Vec2 xUd;
-
-    bool isEmpty() const { return cam == nullptr; }
-};
-
-ObservationData getObservationData(const SfMData& scene,
-                                   feature::FeaturesPerView* featuresPerView,
-                                   IndexT viewId, const track::Track& track)
-{
-    const View* view = scene.getViews().at(viewId).get();
-
-    std::shared_ptr<camera::IntrinsicBase> cam = scene.getIntrinsics().at(view->getIntrinsicId());
-    std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
-
-    if (!camPinHole) {
-        ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
-        return {nullptr, {}, {}, {}, {}};
-    }
-
-    Pose3 pose = scene.getPose(*view).getTransform();
-    Mat34 P = camPinHole->getProjectiveEquivalent(pose);
-
-    const auto& feature = featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)];
-    Vec2 x = feature.coords().cast<double>();
-    Vec2 xUd = cam->get_ud_pixel(x); // undistorted 2D point
-
-    return {camPinHole, pose, P, x, xUd};
-}
-
-} // namespace
-
 void ReconstructionEngine_sequentialSfM::triangulate_multiViewsLORANSAC(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
 {
   ALICEVISION_LOG_DEBUG("Triangulating (mode: multi-view LO-RANSAC)... ");
@@ -1793,142 +1980,70 @@ void ReconstructionEngine_sequentialSfM::triangulate_multiViewsLORANSAC(SfMData&
   // These tracks are seen by at least one new reconstructed view.  
   std::map<IndexT, std::set<IndexT>> mapTracksToTriangulate; // <trackId, observations> 
   getTracksToTriangulate(previousReconstructedViews, newReconstructedViews, mapTracksToTriangulate);
-  
-  std::vector<IndexT> setTracksId; // <trackId>
-  std::transform(mapTracksToTriangulate.begin(), mapTracksToTriangulate.end(),
-                 std::inserter(setTracksId, setTracksId.begin()),
-                 stl::RetrieveKey());
-
-#pragma omp parallel for 
-  for (int i = 0; i < setTracksId.size(); i++) // each track (already reconstructed or not)
-  {
-    const IndexT trackId = setTracksId.at(i);
-    bool isValidTrack = true;
-    const track::Track& track = _map_tracks.at(trackId);
-    std::set<IndexT>& observations = mapTracksToTriangulate.at(trackId); // all the posed views possessing the track
-    
-    // The track needs to be seen by a min. number of views to be triangulated
-    if (observations.size() < _params.minNbObservationsForTriangulation)
-      continue;
-    
-    Vec3 X_euclidean = Vec3::Zero();
-    std::set<IndexT> inliers;
-    
-    if (observations.size() == 2) 
-    {
-      /* --------------------------------------------
-       *    2 observations : triangulation using DLT
-       * -------------------------------------------- */ 
-       
-      inliers = observations;
-      
-      // -- Prepare:
-      IndexT I =  *(observations.begin());
-      IndexT J =  *(observations.rbegin());
 
-      const auto oi = getObservationData(scene, _featuresPerView, I, track);
-      const auto oj = getObservationData(scene, _featuresPerView, J, track);
+  // -- Gather all the tracks in the batch buffers:
+  //  - 2 observations: DLT, checked with the AContrario threshold of each view
+  //  - N observations (N>2): RANSAC on the pairs of observations refined on the inliers
+  BatchTriangulation::Params params;
+  params.minNbObservations = _params.minNbObservationsForTriangulation;
+  params.minAngle = _params.minAngleForTriangulation;
+  params.maxResidualError = 8.0;
+  params.robust = true;
 
-      if (oi.isEmpty() || oj.isEmpty()) {
-        continue;
-      }
+  BatchTriangulation batch(scene, params);
 
-      // -- Triangulate:
-      multiview::TriangulateDLT(oi.P, oi.xUd, oj.P, oj.xUd, X_euclidean);
-
-      // -- Check:
-      //  - angle (small angle leads imprecise triangulation)
-      //  - positive depth
-      //  - residual values
-      // TODO assert(acThresholdIt != _map_ACThreshold.end());
-      const auto& acThresholdItI = _map_ACThreshold.find(I);
-      const auto& acThresholdItJ = _map_ACThreshold.find(J);
-      const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
-      const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
-      
-      if (angleBetweenRays(oi.pose, oi.cam.get(), oj.pose, oj.cam.get(), oi.x, oj.x) < _params.minAngleForTriangulation ||
-          oi.pose.depth(X_euclidean) < 0 ||
-          oj.pose.depth(X_euclidean) < 0 ||
-          oi.cam->residual(oi.pose, X_euclidean.homogeneous(), oi.x).norm() > acThresholdI ||
-          oj.cam->residual(oj.pose, X_euclidean.homogeneous(), oj.x).norm() > acThresholdJ)
-        isValidTrack = false;
-    }
-    else 
-    {
-      /* -------------------------------------------------------
-       *    N obsevations (N>2) : triangulation using LORANSAC 
-       * ------------------------------------------------------- */ 
-     
-      // -- Prepare:
-      std::vector<Vec2> features; // undistorted 2D features (one per pose)
-      std::vector<Mat34> Ps; // projective matrices (one per pose)
-      {
-        const track::Track& track = _map_tracks.at(trackId);
-        
-        int i = 0;
-        for (const IndexT& viewId : observations)
-        {
-          const auto o = getObservationData(scene, _featuresPerView, viewId, track);
+  std::size_t nbObservations = 0;
+  for(const auto& trackPair : mapTracksToTriangulate)
+    nbObservations += trackPair.second.size();
 
-          if (o.isEmpty()) {
-            continue;
-          }
+  batch.reserve(mapTracksToTriangulate.size(), nbObservations);
 
-          features.push_back(o.xUd);
-          Ps.push_back(o.P);
-          i++;
-        }
-      }
-      
-      // -- Triangulate: 
-      Vec4 X_homogeneous = Vec4::Zero();
-      std::vector<std::size_t> inliersIndex;
-      
-      multiview::TriangulateNViewLORANSAC(features, Ps, _randomNumberGenerator, X_homogeneous, &inliersIndex, 8.0);
-      
-      homogeneousToEuclidean(X_homogeneous, X_euclidean);     
-      
-      // observations = {350, 380, 442} | inliersIndex = [0, 1] | inliers = {350, 380}
-      for (const auto & id : inliersIndex)
-        inliers.insert(*std::next(observations.begin(), id));
-
-      // -- Check:
-      //  - nb of cameras validing the track 
-      //  - angle (small angle leads imprecise triangulation)
-      //  - positive depth (chierality)
-      if (inliers.size() < _params.minNbObservationsForTriangulation ||
-          !checkAngles(X_euclidean, inliers, scene, _params.minAngleForTriangulation) ||
-          !checkChieralities(X_euclidean, inliers, scene))
-        isValidTrack = false;
-    }  
-
-    // -- Add the tringulated point to the scene
-    if (isValidTrack)
+  std::set<IndexT> views;
+  for(const auto& trackPair : mapTracksToTriangulate)
+  {
+    const track::Track& track = _map_tracks.at(trackPair.first);
+
+    batch.addTrack(trackPair.first, track.descType);
+
+    for(const IndexT viewId : trackPair.second)
     {
-      Landmark landmark;
-      landmark.X = X_euclidean;
-      landmark.descType = track.descType;
-      for (const IndexT & viewId : inliers) // add inliers as observations
-      {
-        const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
-        const feature::PointFeature& p = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)];
-        const double scale = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : p.scale();
-        landmark.observations[viewId] = Observation(x, track.featPerView.at(viewId), scale);
-      }
-#pragma omp critical
-      {
-        scene.getLandmarks()[trackId] = landmark;
-      }      
+      const IndexT featureId = track.featPerView.at(viewId);
+      const feature::PointFeature& p = _featuresPerView->getFeatures(viewId, track.descType)[featureId];
+      const double scale = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : p.scale();
+
+      if(!batch.addObservation(viewId, p.coords().cast<double>(), featureId, scale))
+        ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
+
+      views.insert(viewId);
     }
+  }
+
+  // TODO assert(acThresholdIt != _map_ACThreshold.end());
+  for(const IndexT viewId : views)
+  {
+    const auto acThresholdIt = _map_ACThreshold.find(viewId);
+    batch.setViewMaxResidualError(viewId, (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0);
+  }
+
+  // -- Triangulate and check:
+  //  - nb of cameras validing the track
+  //  - angle (small angle leads imprecise triangulation)
+  //  - positive depth (chierality)
+  //  - residual values
+  batch.triangulate(_randomNumberGenerator);
+
+  // -- Add the tringulated point to the scene
+  Landmarks& landmarks = scene.getLandmarks();
+
+  for(std::size_t i = 0; i < batch.size(); ++i)
+  {
+    const IndexT trackId = batch.getTrackId(i);
+
+    if(batch.isValid(i))
+      batch.getLandmark(i, landmarks[trackId]);
     else
-    {
-#pragma omp critical
-      {
-        if (scene.getLandmarks().find(trackId) != scene.getLandmarks().end()) 
-          scene.getLandmarks().erase(trackId);
-      }
-    }
-  } // for all shared tracks 
+      landmarks.erase(trackId);
+  }
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
@@ -1967,7 +2082,7 @@ void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, cons
       // Find track correspondences between I and J
       const std::set<std::size_t> set_viewIndex = { I, J };
       track::TracksMap map_tracksCommonIJ;
-      track::getCommonTracksInImagesFast(set_viewIndex, _map_tracks, _map_tracksPerView, map_tracksCommonIJ);
+      track::getCommonTracksInImagesFast(set_viewIndex, _map_tracks, _tracksPerViewIndex, map_tracksCommonIJ);
 
       const View* viewI = scene.getViews().at(I).get();
       const View* viewJ = scene.getViews().at(J).get();
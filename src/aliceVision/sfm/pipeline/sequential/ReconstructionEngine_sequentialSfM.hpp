@@ -12,9 +12,11 @@
 #include <aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp>
 #include <aliceVision/sfm/pipeline/pairwiseMatchesIO.hpp>
 #include <aliceVision/sfm/pipeline/RigSequence.hpp>
+#include <aliceVision/sfm/pipeline/sequential/NextBestViewScoring.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
 #include <aliceVision/track/TracksBuilder.hpp>
+#include <aliceVision/track/TracksPerViewIndex.hpp>
 #include <dependencies/htmlDoc/htmlDoc.hpp>
 #include <aliceVision/utils/Histogram.hpp>
 
@@ -27,6 +29,8 @@ namespace pt = boost::property_tree;
 namespace aliceVision {
 namespace sfm {
 
+class BundleAdjustmentCeres;
+
 /// Image score contains <ImageId, NbPutativeCommonPoint, score, isIntrinsicsReconstructed>
 typedef std::tuple<IndexT, std::size_t, std::size_t, bool> ViewConnectionScore;
 
@@ -93,6 +97,25 @@ public:
     /// Using a negative value for this threshold will disable BA iterations.
     int bundleAdjustmentMaxOutliers = 50;
 
+    /// Bundle adjustment engine
+    EBundleAdjustmentSolver bundleAdjustmentSolver = EBundleAdjustmentSolver::CERES;
+
+    /// Keep the bundle adjustment problem between the resection steps
+    /// and only update the parameters and observations of the changed views and landmarks (ceres solver only).
+    bool usePersistentBundleAdjustment = true;
+
+    // Speculative resection
+
+    /// Resect each group of candidate views in parallel against a snapshot of the scene,
+    /// commit the views consistent with the already reconstructed landmarks and run a single bundle adjustment per group.
+    /// The group size starts at maxImagesPerGroup and grows while the speculative views are consistent.
+    bool useSpeculativeResection = false;
+    /// Upper bound of the adaptive group size of the speculative resection
+    std::size_t speculativeResectionMaxImagesPerGroup = 480;
+    /// Minimum ratio of the resection inliers of a speculative view below maxReprojectionError
+    /// with its committed pose to keep it in the reconstruction
+    double speculativeResectionMinConsistency = 0.8;
+
     // Local Bundle Adjustment data
 
     /// The minimum number of shared matches to create an edge between two views (nodes)
@@ -225,13 +248,15 @@ public:
    * @brief Estimate the best images on which we can compute the resectioning safely.
    * The images are sorted by a score based on the number of features id shared with
    * the reconstruction and the repartition of these points in the image.
+   * The scores are updated incrementally with the tracks reconstructed since the previous call
+   * (see NextBestViewScoring).
    *
    * @param[out] out_selectedViewIds: output list of view IDs we can use for resectioning.
    * @param[in] remainingViewIds: input list of remaining view IDs in which we will search for the best ones for resectioning.
    * @return False if there is no possible resection.
    */
   bool findNextBestViews(std::vector<IndexT>& out_selectedViewIds,
-                         const std::set<IndexT>& remainingViewIds) const;
+                         const std::set<IndexT>& remainingViewIds);
 
 private:
 
@@ -280,6 +305,12 @@ private:
    */
   std::size_t computeCandidateImageScore(IndexT viewId, const std::vector<std::size_t>& trackIds) const;
 
+  /**
+   * @brief Get the ids of the tracks already reconstructed (landmarks) as a bitset.
+   * @param[out] out_tracksIds the reconstructed track ids
+   */
+  void getReconstructedTracks(track::TrackIdBitset& out_tracksIds) const;
+
   /**
    * @brief Apply the resection on a single view.
    * @param[in] viewIndex: image index to add to the reconstruction.
@@ -295,6 +326,53 @@ private:
    * @param[in] resectionData: contains the camera pose and all data used during the resection.
    */
   void updateScene(const IndexT viewIndex, const ResectionData& resectionData);
+
+  /**
+   * @brief Check if a view can be resected in the current scene:
+   * views of a rig are skipped if they are already localized through their rig or
+   * if their rig is initialized with unknown pose and sub-pose.
+   * @param[in] viewId: image index to add to the reconstruction.
+   * @return false if the resection of the view should be skipped
+   */
+  bool isResectionPossible(IndexT viewId) const;
+
+  /**
+   * @brief Speculative resection of a group of views.
+   * All the views are resected in parallel against the current scene, which is not modified
+   * during the resection, then the successful resections are committed sequentially.
+   * Views of a rig whose pose has been defined by an other view of the group are deferred.
+   * Committed views that are not consistent with the scene are rejected before the triangulation (see rejectInconsistentViews)
+   * and deferred.
+   * @param[in] resectionId: the resection group id
+   * @param[in] bestViewIds: the candidate views
+   * @param[in] prevReconstructedViews: the views reconstructed before this group
+   * @param[out] deferredViewIds: views that should be visited again in the next iteration
+   * @return the new reconstructed views
+   */
+  std::set<IndexT> speculativeResection(IndexT resectionId,
+                                        const std::vector<IndexT>& bestViewIds,
+                                        const std::set<IndexT>& prevReconstructedViews,
+                                        std::set<IndexT>& deferredViewIds);
+
+  /**
+   * @brief Remove from the scene the committed speculative views that are not consistent with the landmarks
+   * reconstructed before their group: the landmarks of the resection inliers are reprojected with the committed pose
+   * of the view (rig pose and sub-pose for the views of a rig) and compared with the features of the view.
+   * Views with less than speculativeResectionMinConsistency of their resection inliers below maxReprojectionError are rejected:
+   * their observations are removed and their pose is restored to its state before the resection.
+   * @param[in] resectionsData: the resection data of the committed views
+   * @param[in] previousPoses: the poses that existed before the commit of the views (rig poses)
+   * @return the rejected views
+   */
+  std::set<IndexT> rejectInconsistentViews(const std::map<IndexT, const ResectionData*>& resectionsData,
+                                           const std::map<IndexT, sfmData::CameraPose>& previousPoses);
+
+  /**
+   * @brief Update the size of the speculative resection groups from the ratio of rejected views.
+   * @param[in] nbResectedViews: number of committed views in the last group
+   * @param[in] nbRejectedViews: number of rejected views in the last group
+   */
+  void updateResectionGroupSize(std::size_t nbResectedViews, std::size_t nbRejectedViews);
                    
   /**
    * @brief  Triangulate new possible 2D tracks
@@ -313,25 +391,6 @@ private:
    */
   void triangulate_multiViewsLORANSAC(sfmData::SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews);
 
-  /**
-   * @brief Check if a 3D points is well located in front of a set of views.
-   * @param[in] pt3D A 3D point (euclidian coordinates)
-   * @param[in] viewsId A set of views index
-   * @param[in] scene All the data about the 3D reconstruction. 
-   * @return false if the 3D points is located behind one view (or more), else \c true.
-   */
-  bool checkChieralities(const Vec3& pt3D, const std::set<IndexT>& viewsId, const sfmData::SfMData& scene);
-  
-  /**
-   * @brief Check if the maximal angle formed by a 3D points and 2 views exceeds a min. angle, among a set of views.
-   * @param[in] pt3D A 3D point (euclidian coordinates)
-   * @param[in] viewsId A set of views index   
-   * @param[in] scene All the data about the 3D reconstruction. 
-   * @param[in] kMinAngle The angle limit.
-   * @return false if the maximal angle does not exceed the limit, else \c true.
-   */
-  bool checkAngles(const Vec3& pt3D, const std::set<IndexT>& viewsId, const sfmData::SfMData& scene, const double& kMinAngle);
-
   /**
    * @brief Select the candidate tracks for the next triangulation step. 
    * @details A track is considered as triangulable if it is visible by at least one new reconsutructed 
@@ -379,6 +438,8 @@ private:
   /// internal cache of precomputed values for the weighting of the pyramid levels
   std::vector<int> _pyramidWeights;
   int _pyramidThreshold;
+  /// incremental scores of the candidate views for the next best view selection
+  NextBestViewScoring _nextBestViewScoring;
 
   // Temporary data
 
@@ -386,16 +447,25 @@ private:
   track::TracksMap _map_tracks;
   /// Putative tracks per view
   track::TracksPerView _map_tracksPerView;
+  /// Immutable index of the putative tracks per view for fast intersection queries
+  track::TracksPerViewIndex _tracksPerViewIndex;
   /// Precomputed pyramid index for each trackId of each viewId.
   track::TracksPyramidPerView _map_featsPyramidPerView;
   /// Per camera confidence (A contrario estimated threshold error)
   HashMap<IndexT, double> _map_ACThreshold;
+  /// Current size of the speculative resection groups (see Params::useSpeculativeResection)
+  std::size_t _resectionGroupSize = 0;
 
   // Local Bundle Adjustment data
 
   /// Contains all the data used by the Local BA approach
   std::shared_ptr<LocalBundleAdjustmentGraph> _localStrategyGraph;
 
+  // Bundle Adjustment data
+
+  /// Bundle adjustment kept between the resection steps (see Params::usePersistentBundleAdjustment)
+  std::shared_ptr<BundleAdjustmentCeres> _bundleAdjustment;
+
   // Log
 
   /// sfm intermediate reconstruction files
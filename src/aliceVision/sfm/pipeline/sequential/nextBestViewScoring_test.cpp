@@ -0,0 +1,191 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/pipeline/sequential/NextBestViewScoring.hpp>
+
+#include <random>
+#include <set>
+
+#define BOOST_TEST_MODULE nextBestViewScoring
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+namespace {
+
+const std::size_t pyramidBase = 2;
+const std::size_t pyramidDepth = 3;
+const std::vector<int> pyramidWeights = {4, 2, 1};
+
+/**
+ * @brief Create random tracks with a random feature position in each view
+ */
+void createRandomTracks(std::size_t nbViews, std::size_t nbTracks, std::mt19937& generator,
+                        track::TracksMap& out_tracks, track::TracksPyramidPerView& out_tracksPyramidPerView)
+{
+  std::uniform_real_distribution<double> positionDistribution(0.0, 1.0);
+  std::bernoulli_distribution visibilityDistribution(0.3);
+
+  for(std::size_t viewId = 0; viewId < nbViews; ++viewId)
+    out_tracksPyramidPerView[viewId];
+
+  for(std::size_t trackId = 0; trackId < nbTracks; ++trackId)
+  {
+    track::Track& track = out_tracks[trackId];
+    for(std::size_t viewId = 0; viewId < nbViews; ++viewId)
+    {
+      if(!visibilityDistribution(generator))
+        continue;
+
+      track.featPerView[viewId] = trackId;
+
+      const double x = positionDistribution(generator);
+      const double y = positionDistribution(generator);
+      std::size_t start = 0;
+      std::size_t width = 1;
+      for(std::size_t level = 0; level < pyramidDepth; ++level)
+      {
+        width *= pyramidBase;
+        const std::size_t xCell = std::min(static_cast<std::size_t>(x * width), width - 1);
+        const std::size_t yCell = std::min(static_cast<std::size_t>(y * width), width - 1);
+        out_tracksPyramidPerView[viewId][trackId * pyramidDepth + level] = start + xCell + yCell * width;
+        start += width * width;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Compute the score of a view from scratch
+ */
+std::size_t computeScore(std::size_t viewId, const track::TracksMap& tracks,
+                         const track::TracksPyramidPerView& tracksPyramidPerView,
+                         const std::set<std::size_t>& reconstructedTracks, std::size_t& out_nbTracks)
+{
+  std::vector<std::set<std::size_t>> cellsPerLevel(pyramidDepth);
+  out_nbTracks = 0;
+
+  for(const std::size_t trackId : reconstructedTracks)
+  {
+    if(tracks.at(trackId).featPerView.count(viewId) == 0)
+      continue;
+
+    ++out_nbTracks;
+    for(std::size_t level = 0; level < pyramidDepth; ++level)
+      cellsPerLevel[level].insert(tracksPyramidPerView.at(viewId).at(trackId * pyramidDepth + level));
+  }
+
+  std::size_t score = 0;
+  for(std::size_t level = 0; level < pyramidDepth; ++level)
+    score += cellsPerLevel[level].size() * pyramidWeights[level];
+  return score;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(NextBestViewScoring_incrementalScores)
+{
+  std::mt19937 generator(42);
+  const std::size_t nbViews = 12;
+  const std::size_t nbTracks = 500;
+
+  track::TracksMap tracks;
+  track::TracksPyramidPerView tracksPyramidPerView;
+  createRandomTracks(nbViews, nbTracks, generator, tracks, tracksPyramidPerView);
+
+  NextBestViewScoring scoring;
+  scoring.initialize(tracks, tracksPyramidPerView, pyramidBase, pyramidWeights);
+
+  std::set<std::size_t> reconstructedTracks;
+  std::uniform_int_distribution<std::size_t> trackDistribution(0, nbTracks - 1);
+
+  for(int iteration = 0; iteration < 20; ++iteration)
+  {
+    // add new tracks and remove some of the reconstructed ones
+    for(int i = 0; i < 40; ++i)
+      reconstructedTracks.insert(trackDistribution(generator));
+    for(int i = 0; i < 10 && !reconstructedTracks.empty(); ++i)
+    {
+      auto it = reconstructedTracks.begin();
+      std::advance(it, trackDistribution(generator) % reconstructedTracks.size());
+      reconstructedTracks.erase(it);
+    }
+
+    track::TrackIdBitset bitset(nbTracks);
+    for(const std::size_t trackId : reconstructedTracks)
+      bitset.set(trackId);
+
+    scoring.update(bitset);
+
+    for(std::size_t viewId = 0; viewId < nbViews; ++viewId)
+    {
+      std::size_t expectedNbTracks = 0;
+      const std::size_t expectedScore = computeScore(viewId, tracks, tracksPyramidPerView, reconstructedTracks, expectedNbTracks);
+      const NextBestViewScoring::Candidate candidate = scoring.getCandidate(viewId);
+
+      BOOST_CHECK_EQUAL(candidate.nbTracks, expectedNbTracks);
+      BOOST_CHECK_EQUAL(candidate.score, expectedScore);
+    }
+  }
+
+  // no change
+  track::TrackIdBitset bitset(nbTracks);
+  for(const std::size_t trackId : reconstructedTracks)
+    bitset.set(trackId);
+  BOOST_CHECK_EQUAL(scoring.update(bitset), 0);
+}
+
+BOOST_AUTO_TEST_CASE(NextBestViewScoring_queueOrder)
+{
+  std::mt19937 generator(7);
+  const std::size_t nbViews = 30;
+  const std::size_t nbTracks = 300;
+
+  track::TracksMap tracks;
+  track::TracksPyramidPerView tracksPyramidPerView;
+  createRandomTracks(nbViews, nbTracks, generator, tracks, tracksPyramidPerView);
+
+  NextBestViewScoring scoring;
+  scoring.initialize(tracks, tracksPyramidPerView, pyramidBase, pyramidWeights);
+
+  track::TrackIdBitset bitset(nbTracks);
+  for(std::size_t trackId = 0; trackId < nbTracks; trackId += 3)
+    bitset.set(trackId);
+  scoring.update(bitset);
+
+  for(std::size_t viewId = 0; viewId < nbViews; ++viewId)
+    scoring.pushView(viewId);
+
+  // update the scores of the queued views
+  for(std::size_t trackId = 1; trackId < nbTracks; trackId += 3)
+    bitset.set(trackId);
+  scoring.update(bitset);
+
+  // views already in the queue are not duplicated
+  for(std::size_t viewId = 0; viewId < nbViews; ++viewId)
+    scoring.pushView(viewId);
+  BOOST_CHECK_EQUAL(scoring.nbQueuedViews(), nbViews);
+
+  NextBestViewScoring::Candidate previous;
+  NextBestViewScoring::Candidate candidate;
+  std::set<IndexT> poppedViews;
+  while(scoring.popBestView(candidate))
+  {
+    BOOST_CHECK_EQUAL(candidate.score, scoring.getCandidate(candidate.viewId).score);
+    if(!poppedViews.empty())
+    {
+      BOOST_CHECK(candidate.score <= previous.score);
+      if(candidate.score == previous.score)
+        BOOST_CHECK(candidate.viewId > previous.viewId);
+    }
+    BOOST_CHECK(poppedViews.insert(candidate.viewId).second);
+    previous = candidate;
+  }
+  BOOST_CHECK_EQUAL(poppedViews.size(), nbViews);
+  BOOST_CHECK_EQUAL(scoring.nbQueuedViews(), 0);
+}
@@ -13,6 +13,8 @@
 #include <cmath>
 #include <cstdio>
 #include <iostream>
+#include <random>
+#include <set>
 
 #define BOOST_TEST_MODULE SEQUENTIAL_SFM
 
@@ -83,6 +85,51 @@ BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Known_Intrinsics)
   BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), npoints);
 }
 
+// Test a scene where all the camera intrinsics are known, refined with the Schur complement solver
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Schur_Solver)
+{
+  const int nviews = 6;
+  const int npoints = 128;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  const SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+  SfMData sfmData2 = sfmData;
+  sfmData2.getPoses().clear();
+  sfmData2.getLandmarks().clear();
+
+  ReconstructionEngine_sequentialSfM::Params sfmParams;
+  sfmParams.userInitialImagePair = Pair(0, 1);
+  sfmParams.lockAllIntrinsics = true;
+  sfmParams.bundleAdjustmentSolver = EBundleAdjustmentSolver::SCHUR;
+
+  ReconstructionEngine_sequentialSfM sfmEngine(
+    sfmData2,
+    sfmParams,
+    "./",
+    "./Reconstruction_Report.html");
+
+  std::normal_distribution<double> distribution(0.0,0.5);
+
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, distribution);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  sfmEngine.setFeatures(&featuresPerView);
+  sfmEngine.setMatches(&pairwiseMatches);
+
+  BOOST_CHECK (sfmEngine.process());
+
+  const double residual = RMSE(sfmEngine.getSfMData());
+  ALICEVISION_LOG_DEBUG("RMSE residual: " << residual);
+  BOOST_CHECK_LT(residual, 0.5);
+  BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getPoses().size(), nviews);
+  BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), npoints);
+}
+
 // Test a scene where only the two first camera have known intrinsics
 BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Partially_Known_Intrinsics)
 {
@@ -195,3 +242,146 @@ BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Known_Rig)
   BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), nbPoints);
 }
 
+
+namespace {
+
+/**
+ * @brief Reconstruct a synthetic ring of views and return the views with a valid pose.
+ * @param[in] useSpeculativeResection use the speculative group resection
+ */
+std::set<IndexT> reconstructRing(bool useSpeculativeResection)
+{
+  const int nviews = 12;
+  const int npoints = 128;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  const SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+  SfMData sfmData2 = sfmData;
+  sfmData2.getPoses().clear();
+  sfmData2.getLandmarks().clear();
+
+  ReconstructionEngine_sequentialSfM::Params sfmParams;
+  sfmParams.userInitialImagePair = Pair(0, 1);
+  sfmParams.lockAllIntrinsics = true;
+  // small groups, so that several speculative groups are resected
+  sfmParams.maxImagesPerGroup = 2;
+  sfmParams.useSpeculativeResection = useSpeculativeResection;
+
+  ReconstructionEngine_sequentialSfM sfmEngine(
+    sfmData2,
+    sfmParams,
+    "./",
+    "./Reconstruction_Report.html");
+
+  std::normal_distribution<double> distribution(0.0, 0.5);
+
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, distribution);
+
+  // the last view is not matched, it cannot be localized
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+  for(auto it = pairwiseMatches.begin(); it != pairwiseMatches.end();)
+  {
+    if(it->first.first == IndexT(nviews - 1) || it->first.second == IndexT(nviews - 1))
+      it = pairwiseMatches.erase(it);
+    else
+      ++it;
+  }
+
+  sfmEngine.setFeatures(&featuresPerView);
+  sfmEngine.setMatches(&pairwiseMatches);
+
+  BOOST_CHECK(sfmEngine.process());
+  BOOST_CHECK_LT(RMSE(sfmEngine.getSfMData()), 0.5);
+
+  std::set<IndexT> reconstructedViews;
+  for(const auto& viewPair : sfmEngine.getSfMData().getViews())
+  {
+    if(sfmEngine.getSfMData().isPoseAndIntrinsicDefined(viewPair.second.get()))
+      reconstructedViews.insert(viewPair.first);
+  }
+  return reconstructedViews;
+}
+
+} // namespace
+
+// The speculative group resection localizes the same views as the sequential one
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Speculative_Resection)
+{
+  const std::set<IndexT> sequentialViews = reconstructRing(false);
+  const std::set<IndexT> speculativeViews = reconstructRing(true);
+
+  BOOST_CHECK_EQUAL(sequentialViews.size(), 11);
+  BOOST_CHECK(speculativeViews == sequentialViews);
+}
+
+// A speculative view whose resection inliers do not agree with its pose is rejected before the triangulation
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Speculative_Resection_Rejection)
+{
+  const int nviews = 12;
+  const int npoints = 128;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  const SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+  SfMData sfmData2 = sfmData;
+  sfmData2.getPoses().clear();
+  sfmData2.getLandmarks().clear();
+
+  ReconstructionEngine_sequentialSfM::Params sfmParams;
+  sfmParams.userInitialImagePair = Pair(0, 1);
+  sfmParams.lockAllIntrinsics = true;
+  sfmParams.maxImagesPerGroup = 2;
+  sfmParams.useSpeculativeResection = true;
+
+  ReconstructionEngine_sequentialSfM sfmEngine(
+    sfmData2,
+    sfmParams,
+    "./",
+    "./Reconstruction_Report.html");
+
+  // the features of one view have a large noise: its resection succeeds with a large AC threshold,
+  // but most of its resection inliers are above maxReprojectionError with the estimated pose
+  const IndexT noisyViewId = nviews / 2;
+  SfMData noisySfmData = sfmData;
+  {
+    std::mt19937 generator(42);
+    std::normal_distribution<double> noise(0.0, 5.0);
+    for(auto& landmarkPair : noisySfmData.getLandmarks())
+    {
+      auto observationIt = landmarkPair.second.observations.find(noisyViewId);
+      if(observationIt != landmarkPair.second.observations.end())
+        observationIt->second.x += Vec2(noise(generator), noise(generator));
+    }
+  }
+
+  std::normal_distribution<double> distribution(0.0, 0.5);
+
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, noisySfmData, distribution);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  sfmEngine.setFeatures(&featuresPerView);
+  sfmEngine.setMatches(&pairwiseMatches);
+
+  BOOST_CHECK(sfmEngine.process());
+
+  const SfMData& result = sfmEngine.getSfMData();
+  for(const auto& viewPair : result.getViews())
+  {
+    const bool isReconstructed = result.isPoseAndIntrinsicDefined(viewPair.second.get());
+    BOOST_CHECK_EQUAL(isReconstructed, viewPair.first != noisyViewId);
+  }
+
+  // the rejected view leaves no observation in the scene
+  for(const auto& landmarkPair : result.getLandmarks())
+    BOOST_CHECK_EQUAL(landmarkPair.second.observations.count(noisyViewId), 0);
+
+  BOOST_CHECK_LT(RMSE(result), 0.5);
+}
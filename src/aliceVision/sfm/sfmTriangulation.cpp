@@ -6,8 +6,8 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "sfmTriangulation.hpp"
+#include <aliceVision/sfm/BatchTriangulation.hpp>
 #include <aliceVision/multiview/triangulation/Triangulation.hpp>
-#include <aliceVision/robustEstimation/randSampling.hpp>
 #include <aliceVision/system/ProgressDisplay.hpp>
 #include <aliceVision/config.hpp>
 
@@ -100,8 +100,12 @@ void StructureComputation_blind::triangulate(sfmData::SfMData& sfmData, std::mt1
   }
 }
 
-StructureComputation_robust::StructureComputation_robust(bool verbose)
+StructureComputation_robust::StructureComputation_robust(bool verbose,
+                                                         std::size_t minNbObservations,
+                                                         double maxResidualError)
   : StructureComputation_basis(verbose)
+  , _minNbObservations(minNbObservations)
+  , _maxResidualError(maxResidualError)
 {}
 
 void StructureComputation_robust::triangulate(sfmData::SfMData& sfmData, std::mt19937 & randomNumberGenerator) const
@@ -114,158 +118,46 @@ void StructureComputation_robust::triangulate(sfmData::SfMData& sfmData, std::mt
 /// Invalid landmark are removed.
 void StructureComputation_robust::robust_triangulation(sfmData::SfMData& sfmData, std::mt19937 & randomNumberGenerator) const
 {
-  std::deque<IndexT> rejectedId;
+  sfmData::Landmarks& landmarks = sfmData.getLandmarks();
 
-  system::ProgressDisplay progressDisplay;
-  if (_bConsoleVerbose)
-    progressDisplay = system::createConsoleProgressDisplay(sfmData.getLandmarks().size(), std::cout,
-                                                           "Robust triangulation progress:\n");
+  // gather all the tracks in the batch buffers
+  BatchTriangulation::Params params;
+  params.minNbObservations = _minNbObservations;
+  params.maxResidualError = _maxResidualError;
+  params.robust = true;
 
-  #pragma omp parallel
-  for(sfmData::Landmarks::iterator iterTracks = sfmData.getLandmarks().begin();
-    iterTracks != sfmData.getLandmarks().end();
-    ++iterTracks)
-  {
-    #pragma omp single nowait
-    {
-      if (_bConsoleVerbose)
-      {
-        ++(progressDisplay);
-      }
-      Vec3 X;
-      if (robust_triangulation(sfmData, iterTracks->second.observations, randomNumberGenerator, X)) {
-        iterTracks->second.X = X;
-      }
-      else {
-        iterTracks->second.X = Vec3::Zero();
-        #pragma omp critical
-        {
-          rejectedId.push_front(iterTracks->first);
-        }
-      }
-    }
-  }
-  // Erase the unsuccessful triangulated tracks
-  for(auto& it : rejectedId)
-  {
-    sfmData.getLandmarks().erase(it);
-  }
-}
+  BatchTriangulation batch(sfmData, params);
 
-/// Robustly try to estimate the best 3D point using a ransac Scheme
-/// A point must be seen in at least 3 views
-/// Return true for a successful triangulation
-bool StructureComputation_robust::robust_triangulation(const sfmData::SfMData& sfmData,
-                                                       const sfmData::Observations& observations,
-                                                       std::mt19937 & randomNumberGenerator,
-                                                       Vec3& X,
-                                                       const IndexT min_required_inliers,
-                                                       const IndexT min_sample_index) const
-{
-  if (observations.size() < 3)
-  {
-    return false;
-  }
-
-  const double dThresholdPixel = 4.0; // TODO: make this parameter customizable
+  std::size_t nbObservations = 0;
+  for(const auto& landmarkPair : landmarks)
+    nbObservations += landmarkPair.second.observations.size();
 
-  const IndexT nbIter = observations.size(); // TODO: automatic computation of the number of iterations?
+  batch.reserve(landmarks.size(), nbObservations);
 
-  // - Ransac variables
-  Vec3 best_model;
-  std::set<IndexT> best_inlier_set;
-  double best_error = std::numeric_limits<double>::max();
-
-  // - Ransac loop
-  for(IndexT i = 0; i < nbIter; ++i)
+  for(const auto& landmarkPair : landmarks)
   {
-    std::set<IndexT> samples;
-    robustEstimation::uniformSample(randomNumberGenerator, std::min(std::size_t(min_sample_index), observations.size()), observations.size(), samples);
-
-    // Hypothesis generation.
-    const Vec3 current_model = track_sample_triangulation(sfmData, observations, samples);
-
-    // Test validity of the hypothesis
-    // - chierality (for the samples)
-    // - residual error
+    batch.addTrack(landmarkPair.first, landmarkPair.second.descType);
 
-    // Chierality (Check the point is in front of the sampled cameras)
-    bool bChierality = true;
-
-    for(auto& it : samples)
+    for(const auto& observationPair : landmarkPair.second.observations)
     {
-      sfmData::Observations::const_iterator itObs = observations.begin();
-      std::advance(itObs, it);
-      const sfmData::View * view = sfmData.getViews().at(itObs->first).get();
-      const IntrinsicBase * cam = sfmData.getIntrinsics().at(view->getIntrinsicId()).get();
-      const Pose3 pose = sfmData.getPose(*view).getTransform();
-      const double z = pose.depth(current_model); // TODO: cam->depth(pose(X));
-      bChierality &= z > 0;
-    }
-
-    if (!bChierality)
-      continue;
-
-    std::set<IndexT> inlier_set;
-    double current_error = 0.0;
-    
-    // Classification as inlier/outlier according pixel residual errors.
-    for (const auto& itObs : observations)
-    {
-      const sfmData::View * view = sfmData.getViews().at(itObs.first).get();
-      const IntrinsicBase * intrinsic = sfmData.getIntrinsics().at(view->getIntrinsicId()).get();
-      const Pose3 pose = sfmData.getPose(*view).getTransform();
-      const Vec2 residual = intrinsic->residual(pose, current_model.homogeneous(), itObs.second.x);
-      const double residual_d = residual.norm();
-
-      if (residual_d < dThresholdPixel)
-      {
-        inlier_set.insert(itObs.first);
-        current_error += residual_d;
-      }
-      else
-      {
-        current_error += dThresholdPixel;
-      }
-    }
-    // Does the hypothesis is the best one we have seen and have sufficient inliers.
-    if (current_error < best_error && inlier_set.size() >= min_required_inliers)
-    {
-      X = best_model = current_model;
-      best_inlier_set = inlier_set;
-      best_error = current_error;
+      const sfmData::Observation& observation = observationPair.second;
+      batch.addObservation(observationPair.first, observation.x, observation.id_feat, observation.scale);
     }
   }
-  return !best_inlier_set.empty();
-}
 
+  if(_bConsoleVerbose)
+    ALICEVISION_LOG_INFO("Robust triangulation of " << batch.size() << " tracks (" << nbObservations << " observations).");
 
-/// Triangulate a given track from a selection of observations
-Vec3 StructureComputation_robust::track_sample_triangulation(const sfmData::SfMData& sfmData,
-                                                             const sfmData::Observations& observations,
-                                                             const std::set<IndexT>& samples) const
-{
-  multiview::Triangulation trianObj;
-  for (const IndexT idx : samples)
-  {
-    assert(idx < observations.size());
-    sfmData::Observations::const_iterator itObs = observations.begin();
-    std::advance(itObs, idx);
-    const sfmData::View * view = sfmData.getViews().at(itObs->first).get();
-
-    std::shared_ptr<camera::IntrinsicBase> cam = sfmData.getIntrinsics().at(view->getIntrinsicId());
-    std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
-    if (!camPinHole) {
-      ALICEVISION_LOG_ERROR("Camera is not pinhole in filter");
-      return Vec3();
-    }
+  batch.triangulate(randomNumberGenerator);
 
-    const Pose3 pose = sfmData.getPose(*view).getTransform();
-    trianObj.add(
-      camPinHole->getProjectiveEquivalent(pose),
-      cam->get_ud_pixel(itObs->second.x));
+  // Erase the unsuccessful triangulated tracks
+  for(std::size_t i = 0; i < batch.size(); ++i)
+  {
+    if(batch.isValid(i))
+      landmarks.at(batch.getTrackId(i)).X = batch.getPoint(i);
+    else
+      landmarks.erase(batch.getTrackId(i));
   }
-  return trianObj.compute();
 }
 
 } // namespace sfm
@@ -39,10 +39,17 @@ struct StructureComputation_blind: public StructureComputation_basis
 /// Triangulation of track data contained in the structure of a SfMData scene.
 // Use a robust estimation:
 // - Triangulate tracks using a RANSAC scheme
-// - Check cheirality and a pixel residual error (TODO: make it a parameter)
+// - Check cheirality and a pixel residual error
 struct StructureComputation_robust: public StructureComputation_basis
 {
-  StructureComputation_robust(bool verbose = false);
+  /**
+   * @param[in] verbose log the progress
+   * @param[in] minNbObservations the minimum number of inlier observations of a valid landmark
+   * @param[in] maxResidualError the maximum reprojection error of an inlier observation (in pixels)
+   */
+  StructureComputation_robust(bool verbose = false,
+                              std::size_t minNbObservations = 3,
+                              double maxResidualError = 4.0);
 
   virtual void triangulate(sfmData::SfMData& sfmData, std::mt19937 & randomNumberGenerator) const;
 
@@ -51,20 +58,9 @@ struct StructureComputation_robust: public StructureComputation_basis
   /// Invalid landmark are removed.
   void robust_triangulation(sfmData::SfMData& sfmData, std::mt19937 & randomNumberGenerator) const;
 
-  /// Robustly try to estimate the best 3D point using a ransac Scheme
-  /// Return true for a successful triangulation
-  bool robust_triangulation(const sfmData::SfMData& sfmData,
-                            const sfmData::Observations& observations,
-                            std::mt19937 & randomNumberGenerator,
-                            Vec3& X,
-                            const IndexT min_required_inliers = 3,
-                            const IndexT min_sample_index = 3) const;
-
 private:
-  /// Triangulate a given track from a selection of observations
-  Vec3 track_sample_triangulation(const sfmData::SfMData& sfmData,
-                                  const sfmData::Observations& observations,
-                                  const std::set<IndexT>& samples) const;
+  std::size_t _minNbObservations;
+  double _maxResidualError;
 };
 
 } // namespace sfm
@@ -0,0 +1,210 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CompactLandmarks.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfmData {
+
+constexpr std::size_t CompactLandmarks::npos;
+
+void CompactLandmarks::build(const Landmarks& landmarks)
+{
+  clear();
+
+  // sort the ids, so the storage does not depend on the hash map order
+  std::vector<IndexT> landmarkIds;
+  landmarkIds.reserve(landmarks.size());
+
+  std::size_t nbObservations = 0;
+  for(const auto& landmarkPair : landmarks)
+  {
+    landmarkIds.push_back(landmarkPair.first);
+    nbObservations += landmarkPair.second.observations.size();
+  }
+  std::sort(landmarkIds.begin(), landmarkIds.end());
+
+  reserve(landmarkIds.size(), nbObservations);
+
+  for(const IndexT landmarkId : landmarkIds)
+  {
+    const Landmark& landmark = landmarks.at(landmarkId);
+    addLandmark(landmarkId, landmark.X, landmark.descType, landmark.rgb);
+
+    // Observations is a flat_map, already sorted by view id
+    for(const auto& observationPair : landmark.observations)
+      addObservation(observationPair.first, observationPair.second);
+  }
+}
+
+void CompactLandmarks::clear()
+{
+  _ids.clear();
+  _positions.clear();
+  _colors.clear();
+  _descTypes.clear();
+  _indexes.clear();
+
+  _observationOffsets.assign(1, 0);
+  _observationViewIds.clear();
+  _observationFeatureIds.clear();
+  _observationPixels.clear();
+  _observationScales.clear();
+}
+
+void CompactLandmarks::reserve(std::size_t nbLandmarks, std::size_t nbObservations)
+{
+  _ids.reserve(nbLandmarks);
+  _positions.reserve(nbLandmarks);
+  _colors.reserve(nbLandmarks);
+  _descTypes.reserve(nbLandmarks);
+
+  _observationOffsets.reserve(nbLandmarks + 1);
+  _observationViewIds.reserve(nbObservations);
+  _observationFeatureIds.reserve(nbObservations);
+  _observationPixels.reserve(nbObservations);
+  _observationScales.reserve(nbObservations);
+}
+
+std::size_t CompactLandmarks::addLandmark(IndexT landmarkId,
+                                          const Vec3& X,
+                                          feature::EImageDescriberType descType,
+                                          const image::RGBColor& rgb)
+{
+  const std::size_t index = _ids.size();
+
+  if(!_indexes.emplace(landmarkId, index).second)
+    throw std::runtime_error("CompactLandmarks: landmark " + std::to_string(landmarkId) + " is already stored.");
+
+  _ids.push_back(landmarkId);
+  _positions.push_back(X);
+  _colors.push_back(rgb);
+  _descTypes.push_back(descType);
+  _observationOffsets.push_back(_observationOffsets.back());
+
+  return index;
+}
+
+void CompactLandmarks::addObservation(IndexT viewId, const Observation& observation)
+{
+  if(_ids.empty())
+    throw std::runtime_error("CompactLandmarks: cannot add an observation without landmark.");
+
+  const std::size_t begin = _observationOffsets[_observationOffsets.size() - 2];
+
+  if(_observationViewIds.size() > begin && _observationViewIds.back() >= viewId)
+    throw std::runtime_error("CompactLandmarks: the observations of landmark " + std::to_string(_ids.back()) +
+                             " must be added by increasing view id.");
+
+  _observationViewIds.push_back(viewId);
+  _observationFeatureIds.push_back(observation.id_feat);
+  _observationPixels.push_back(observation.x);
+  _observationScales.push_back(observation.scale);
+  ++_observationOffsets.back();
+}
+
+std::size_t CompactLandmarks::findObservation(std::size_t index, IndexT viewId) const
+{
+  const auto begin = _observationViewIds.begin() + _observationOffsets[index];
+  const auto end = _observationViewIds.begin() + _observationOffsets[index + 1];
+  const auto it = std::lower_bound(begin, end, viewId);
+
+  if(it == end || *it != viewId)
+    return npos;
+
+  return static_cast<std::size_t>(it - _observationViewIds.begin());
+}
+
+void CompactLandmarks::getLandmark(std::size_t index, Landmark& out_landmark) const
+{
+  out_landmark.X = _positions.at(index);
+  out_landmark.descType = _descTypes.at(index);
+  out_landmark.rgb = _colors.at(index);
+  out_landmark.observations.clear();
+  out_landmark.observations.reserve(getNbObservations(index));
+
+  for(std::size_t i = observationsBegin(index); i < observationsEnd(index); ++i)
+    out_landmark.observations.emplace_hint(out_landmark.observations.end(), _observationViewIds[i], getObservation(i));
+}
+
+void CompactLandmarks::exportLandmarks(Landmarks& out_landmarks) const
+{
+  out_landmarks.clear();
+
+  for(std::size_t i = 0; i < size(); ++i)
+    getLandmark(i, out_landmarks[_ids[i]]);
+}
+
+void CompactLandmarks::updateLandmarks(Landmarks& landmarks) const
+{
+  for(std::size_t i = 0; i < size(); ++i)
+  {
+    Landmark& landmark = landmarks.at(_ids[i]);
+    landmark.X = _positions[i];
+    landmark.rgb = _colors[i];
+  }
+}
+
+std::size_t CompactLandmarks::removeLandmarks(const std::vector<char>& toRemove)
+{
+  if(toRemove.size() != size())
+    throw std::runtime_error("CompactLandmarks: invalid number of landmark flags.");
+
+  std::size_t nbLandmarks = 0;
+  std::size_t nbObservations = 0;
+
+  // move the kept landmarks and their observations to the front, in place
+  for(std::size_t i = 0; i < toRemove.size(); ++i)
+  {
+    const std::size_t begin = _observationOffsets[i];
+    const std::size_t end = _observationOffsets[i + 1];
+
+    if(toRemove[i])
+    {
+      _indexes.erase(_ids[i]);
+      continue;
+    }
+
+    _ids[nbLandmarks] = _ids[i];
+    _positions[nbLandmarks] = _positions[i];
+    _colors[nbLandmarks] = _colors[i];
+    _descTypes[nbLandmarks] = _descTypes[i];
+    _indexes[_ids[i]] = nbLandmarks;
+
+    // begin and end have been read, the offset of this landmark can be overwritten
+    _observationOffsets[nbLandmarks] = nbObservations;
+
+    for(std::size_t j = begin; j < end; ++j, ++nbObservations)
+    {
+      _observationViewIds[nbObservations] = _observationViewIds[j];
+      _observationFeatureIds[nbObservations] = _observationFeatureIds[j];
+      _observationPixels[nbObservations] = _observationPixels[j];
+      _observationScales[nbObservations] = _observationScales[j];
+    }
+    ++nbLandmarks;
+  }
+
+  const std::size_t nbRemoved = size() - nbLandmarks;
+
+  _ids.resize(nbLandmarks);
+  _positions.resize(nbLandmarks);
+  _colors.resize(nbLandmarks);
+  _descTypes.resize(nbLandmarks);
+  _observationOffsets.resize(nbLandmarks + 1);
+  _observationOffsets.back() = nbObservations;
+  _observationViewIds.resize(nbObservations);
+  _observationFeatureIds.resize(nbObservations);
+  _observationPixels.resize(nbObservations);
+  _observationScales.resize(nbObservations);
+
+  return nbRemoved;
+}
+
+} // namespace sfmData
+} // namespace aliceVision
@@ -0,0 +1,239 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/types.hpp>
+
+#include <limits>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmData {
+
+/**
+ * @brief Compact landmark storage in structure of arrays.
+ *
+ * Positions, colors and describer types are stored contiguously, one element per landmark.
+ * Observations are stored in compressed sparse rows: the observations of the landmark i are
+ * in the range [observationsBegin(i), observationsEnd(i)) of the observation arrays,
+ * sorted by view id like in the Observations of a Landmark.
+ * A landmark is referenced by its index in the storage, the id to index map gives the index of an id.
+ *
+ * It can be built from and exported to the Landmarks of a SfMData,
+ * so the code can be migrated incrementally and the hot loops can iterate over dense arrays.
+ */
+class CompactLandmarks
+{
+public:
+
+  /// returned by find() for an unknown landmark id or by findObservation() for an unknown view id
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+  CompactLandmarks() = default;
+
+  /**
+   * @brief CompactLandmarks constructor
+   * @param[in] landmarks The landmarks to store
+   */
+  explicit CompactLandmarks(const Landmarks& landmarks)
+  {
+    build(landmarks);
+  }
+
+  /**
+   * @brief Replace the storage with the given landmarks, sorted by id
+   * @param[in] landmarks The landmarks to store
+   */
+  void build(const Landmarks& landmarks);
+
+  /**
+   * @brief Remove all the landmarks
+   */
+  void clear();
+
+  /**
+   * @brief Reserve the buffers
+   * @param[in] nbLandmarks The expected number of landmarks
+   * @param[in] nbObservations The expected total number of observations
+   */
+  void reserve(std::size_t nbLandmarks, std::size_t nbObservations);
+
+  /**
+   * @brief Add a landmark without observation, the next observations are added to this landmark
+   * @param[in] landmarkId The landmark id, must not already be stored
+   * @param[in] X The landmark position
+   * @param[in] descType The describer type
+   * @param[in] rgb The landmark color
+   * @return the landmark index
+   */
+  std::size_t addLandmark(IndexT landmarkId,
+                          const Vec3& X,
+                          feature::EImageDescriberType descType = feature::EImageDescriberType::UNINITIALIZED,
+                          const image::RGBColor& rgb = image::WHITE);
+
+  /**
+   * @brief Add an observation to the last landmark
+   * @note the observations of a landmark must be added by increasing view id
+   * @param[in] viewId The view id
+   * @param[in] observation The observation
+   */
+  void addObservation(IndexT viewId, const Observation& observation);
+
+  /**
+   * @brief Get the number of landmarks
+   */
+  std::size_t size() const
+  {
+    return _ids.size();
+  }
+
+  /**
+   * @brief Return true if there is no landmark
+   */
+  bool empty() const
+  {
+    return _ids.empty();
+  }
+
+  /**
+   * @brief Get the total number of observations
+   */
+  std::size_t getNbObservations() const
+  {
+    return _observationViewIds.size();
+  }
+
+  /**
+   * @brief Get the index of a landmark id
+   * @param[in] landmarkId The landmark id
+   * @return the landmark index or npos if the landmark is not stored
+   */
+  std::size_t find(IndexT landmarkId) const
+  {
+    const auto it = _indexes.find(landmarkId);
+    return (it == _indexes.end()) ? npos : it->second;
+  }
+
+  /**
+   * @brief Get the index of a landmark id
+   * @param[in] landmarkId The landmark id, must be stored
+   */
+  std::size_t getIndex(IndexT landmarkId) const
+  {
+    return _indexes.at(landmarkId);
+  }
+
+  IndexT getId(std::size_t index) const { return _ids[index]; }
+
+  const Vec3& getX(std::size_t index) const { return _positions[index]; }
+  Vec3& getX(std::size_t index) { return _positions[index]; }
+
+  const image::RGBColor& getColor(std::size_t index) const { return _colors[index]; }
+  image::RGBColor& getColor(std::size_t index) { return _colors[index]; }
+
+  feature::EImageDescriberType getDescType(std::size_t index) const { return _descTypes[index]; }
+
+  const std::vector<IndexT>& getIds() const { return _ids; }
+  const std::vector<Vec3>& getPositions() const { return _positions; }
+  std::vector<Vec3>& getPositions() { return _positions; }
+  const std::vector<image::RGBColor>& getColors() const { return _colors; }
+  std::vector<image::RGBColor>& getColors() { return _colors; }
+
+  /**
+   * @brief Get the first observation of a landmark
+   */
+  std::size_t observationsBegin(std::size_t index) const
+  {
+    return _observationOffsets[index];
+  }
+
+  /**
+   * @brief Get the end of the observations of a landmark
+   */
+  std::size_t observationsEnd(std::size_t index) const
+  {
+    return _observationOffsets[index + 1];
+  }
+
+  /**
+   * @brief Get the number of observations of a landmark
+   */
+  std::size_t getNbObservations(std::size_t index) const
+  {
+    return _observationOffsets[index + 1] - _observationOffsets[index];
+  }
+
+  IndexT getObservationViewId(std::size_t observationIndex) const { return _observationViewIds[observationIndex]; }
+  IndexT getObservationFeatureId(std::size_t observationIndex) const { return _observationFeatureIds[observationIndex]; }
+  const Vec2& getObservationX(std::size_t observationIndex) const { return _observationPixels[observationIndex]; }
+  Vec2& getObservationX(std::size_t observationIndex) { return _observationPixels[observationIndex]; }
+  double getObservationScale(std::size_t observationIndex) const { return _observationScales[observationIndex]; }
+
+  /**
+   * @brief Get the observation of a landmark in a view
+   * @param[in] index The landmark index
+   * @param[in] viewId The view id
+   * @return the observation index or npos if the landmark is not observed by the view
+   */
+  std::size_t findObservation(std::size_t index, IndexT viewId) const;
+
+  /**
+   * @brief Get an observation as an Observation structure
+   * @param[in] observationIndex The observation index
+   */
+  Observation getObservation(std::size_t observationIndex) const
+  {
+    return Observation(_observationPixels[observationIndex], _observationFeatureIds[observationIndex], _observationScales[observationIndex]);
+  }
+
+  /**
+   * @brief Get a landmark as a Landmark structure, with its observations
+   * @param[in] index The landmark index
+   * @param[out] out_landmark The landmark
+   */
+  void getLandmark(std::size_t index, Landmark& out_landmark) const;
+
+  /**
+   * @brief Export all the landmarks, the previous content of the given landmarks is replaced
+   * @param[out] out_landmarks The landmarks
+   */
+  void exportLandmarks(Landmarks& out_landmarks) const;
+
+  /**
+   * @brief Write the positions and colors back to the landmarks with the same id,
+   * without touching the observations
+   * @param[in,out] landmarks The landmarks, must contain all the stored ids
+   */
+  void updateLandmarks(Landmarks& landmarks) const;
+
+  /**
+   * @brief Remove the landmarks with a non-zero flag and compact the storage
+   * @param[in] toRemove One flag per landmark
+   * @return the number of removed landmarks
+   */
+  std::size_t removeLandmarks(const std::vector<char>& toRemove);
+
+private:
+  // landmarks
+  std::vector<IndexT> _ids;
+  std::vector<Vec3> _positions;
+  std::vector<image::RGBColor> _colors;
+  std::vector<feature::EImageDescriberType> _descTypes;
+  HashMap<IndexT, std::size_t> _indexes;
+
+  // observations
+  /// first observation of each landmark, the last element is the total number of observations
+  std::vector<std::size_t> _observationOffsets = {0};
+  std::vector<IndexT> _observationViewIds;
+  std::vector<IndexT> _observationFeatureIds;
+  std::vector<Vec2> _observationPixels;
+  std::vector<double> _observationScales;
+};
+
+} // namespace sfmData
+} // namespace aliceVision
@@ -13,6 +13,7 @@
 #include <aliceVision/image/io.hpp>
 #include <aliceVision/system/ProgressDisplay.hpp>
 
+#include <algorithm>
 #include <map>
 #include <random>
 #include <vector>
@@ -25,12 +26,6 @@ void colorizeTracks(SfMData& sfmData)
   auto progressDisplay = system::createConsoleProgressDisplay(sfmData.getLandmarks().size(), std::cout,
                                                               "\nCompute scene structure color\n");
 
-  std::vector<std::reference_wrapper<Landmark>> remainingLandmarksToColor;
-  remainingLandmarksToColor.reserve(sfmData.getLandmarks().size());
-
-  for(auto& landmarkPair : sfmData.getLandmarks())
-    remainingLandmarksToColor.push_back(landmarkPair.second);
-
   struct ViewInfo
   {
     ViewInfo(IndexT viewId, std::size_t cardinal)
@@ -60,34 +55,30 @@ void colorizeTracks(SfMData& sfmData)
       sortedViewsCardinal.push_back(ViewInfo(cardinalPair.first, cardinalPair.second));
 
     // sort the vector, biggest cardinality first
-    std::sort(sortedViewsCardinal.begin(),
-              sortedViewsCardinal.end(),
-              [] (const ViewInfo& l, const ViewInfo& r) { return l.cardinal > r.cardinal; });
+    std::stable_sort(sortedViewsCardinal.begin(),
+                     sortedViewsCardinal.end(),
+                     [] (const ViewInfo& l, const ViewInfo& r) { return l.cardinal > r.cardinal; });
   }
 
-  // assign each landmark to a view
-  for(ViewInfo& viewCardinal : sortedViewsCardinal)
+  // assign each landmark to its observing view with the biggest cardinality
   {
-    std::vector<std::reference_wrapper<Landmark>> toKeep;
-    const IndexT viewId = viewCardinal.viewId;
+    std::map<IndexT, std::size_t> viewsRankMap; // <ViewId, Rank>
+    for(std::size_t rank = 0; rank < sortedViewsCardinal.size(); ++rank)
+      viewsRankMap[sortedViewsCardinal[rank].viewId] = rank;
 
-    for(int i = 0; i < remainingLandmarksToColor.size(); ++i)
+    for(auto& landmarkPair : sfmData.getLandmarks())
     {
-      Landmark& landmark = remainingLandmarksToColor.at(i);
-      auto it = landmark.observations.find(viewId);
-      if(it != landmark.observations.end())
-      {
-        viewCardinal.landmarks.push_back(landmark);
-      }
-      else
-      {
-        toKeep.push_back(landmark);
-      }
-    }
-    std::swap(toKeep, remainingLandmarksToColor);
+      Landmark& landmark = landmarkPair.second;
+
+      if(landmark.observations.empty())
+        continue;
 
-    if(remainingLandmarksToColor.empty())
-      break;
+      std::size_t bestRank = sortedViewsCardinal.size();
+      for(const auto& observationPair : landmark.observations)
+        bestRank = std::min(bestRank, viewsRankMap.at(observationPair.first));
+
+      sortedViewsCardinal[bestRank].landmarks.push_back(landmark);
+    }
   }
 
   std::random_device randomDevice;
@@ -1,6 +1,7 @@
 
 #include <boost/filesystem.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmData/CompactLandmarks.hpp>
 
 #define BOOST_TEST_MODULE sfmData
 
@@ -51,3 +52,59 @@ BOOST_AUTO_TEST_CASE(SfMData_InternalFolders)
   BOOST_CHECK_EQUAL(sfmData.getRelativeMatchesFolders()[0], fs::relative(refFolder, otherFolder));
 }
 
+
+BOOST_AUTO_TEST_CASE(SfMData_CompactLandmarks)
+{
+  sfmData::Landmarks landmarks;
+  for(IndexT landmarkId = 0; landmarkId < 10; ++landmarkId)
+  {
+    sfmData::Landmark& landmark = landmarks[landmarkId * 3];
+    landmark.X = Vec3(landmarkId, 2.0 * landmarkId, -1.0);
+    landmark.descType = feature::EImageDescriberType::SIFT;
+    landmark.rgb = image::RGBColor(static_cast<unsigned char>(landmarkId), 0, 0);
+    for(IndexT viewId = landmarkId % 3; viewId < 8; viewId += 2)
+      landmark.observations[viewId] = sfmData::Observation(Vec2(viewId, landmarkId), landmarkId * 10 + viewId, 1.5);
+  }
+
+  sfmData::CompactLandmarks compactLandmarks(landmarks);
+  BOOST_CHECK_EQUAL(compactLandmarks.size(), landmarks.size());
+
+  // round trip
+  sfmData::Landmarks exportedLandmarks;
+  compactLandmarks.exportLandmarks(exportedLandmarks);
+  BOOST_CHECK(exportedLandmarks == landmarks);
+
+  // dense access
+  const std::size_t index = compactLandmarks.getIndex(9);
+  BOOST_CHECK_EQUAL(compactLandmarks.getId(index), 9);
+  BOOST_CHECK_EQUAL(compactLandmarks.find(10), sfmData::CompactLandmarks::npos);
+  BOOST_CHECK_EQUAL(compactLandmarks.getNbObservations(index), landmarks.at(9).observations.size());
+  BOOST_CHECK_EQUAL(compactLandmarks.findObservation(index, 1), sfmData::CompactLandmarks::npos);
+
+  const std::size_t observationIndex = compactLandmarks.findObservation(index, 4);
+  BOOST_REQUIRE(observationIndex != sfmData::CompactLandmarks::npos);
+  BOOST_CHECK_EQUAL(compactLandmarks.getObservationFeatureId(observationIndex), 94);
+  BOOST_CHECK(compactLandmarks.getObservation(observationIndex) == landmarks.at(9).observations.at(4));
+
+  // update positions and colors
+  compactLandmarks.getX(index) = Vec3(1.0, 1.0, 1.0);
+  compactLandmarks.getColor(index) = image::BLUE;
+  compactLandmarks.updateLandmarks(landmarks);
+  BOOST_CHECK_EQUAL(landmarks.at(9).X, Vec3(1.0, 1.0, 1.0));
+  BOOST_CHECK(landmarks.at(9).rgb == image::BLUE);
+
+  // remove the landmarks with an even id
+  std::vector<char> toRemove(compactLandmarks.size());
+  for(std::size_t i = 0; i < toRemove.size(); ++i)
+    toRemove[i] = (compactLandmarks.getId(i) % 2 == 0);
+
+  BOOST_CHECK_EQUAL(compactLandmarks.removeLandmarks(toRemove), 5);
+  BOOST_CHECK_EQUAL(compactLandmarks.size(), 5);
+
+  for(auto it = landmarks.begin(); it != landmarks.end();)
+    it = (it->first % 2 == 0) ? landmarks.erase(it) : std::next(it);
+
+  compactLandmarks.exportLandmarks(exportedLandmarks);
+  BOOST_CHECK(exportedLandmarks == landmarks);
+  BOOST_CHECK_EQUAL(compactLandmarks.getId(compactLandmarks.getIndex(9)), 9);
+}
@@ -0,0 +1,937 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "binaryIO.hpp"
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace {
+
+const char sfmDataBinaryMagic[8] = {'A', 'V', 'S', 'F', 'M', 'B', 'I', 'N'};
+
+inline std::uint64_t alignOffset(std::uint64_t offset)
+{
+  return (offset + sfmDataBinarySectionAlignment - 1) / sfmDataBinarySectionAlignment * sfmDataBinarySectionAlignment;
+}
+
+inline void writePadding(std::ofstream& file, std::uint64_t currentOffset, std::uint64_t targetOffset)
+{
+  static const char zeros[sfmDataBinarySectionAlignment] = {0};
+  file.write(zeros, static_cast<std::streamsize>(targetOffset - currentOffset));
+}
+
+/**
+ * @brief Serialize the records of a section in a memory buffer
+ */
+class RecordWriter
+{
+public:
+  template<typename T>
+  void write(const T& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "RecordWriter: only trivially copyable values can be written.");
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  void write(const std::string& value)
+  {
+    write(static_cast<std::uint32_t>(value.size()));
+    _buffer.insert(_buffer.end(), value.begin(), value.end());
+  }
+
+  void write(const std::vector<double>& values)
+  {
+    write(static_cast<std::uint32_t>(values.size()));
+    for(const double value : values)
+      write(value);
+  }
+
+  template<typename Derived>
+  void writeMatrix(const Eigen::MatrixBase<Derived>& matrix)
+  {
+    for(int i = 0; i < matrix.size(); ++i)
+      write(static_cast<double>(matrix(i)));
+  }
+
+  void writePose(const geometry::Pose3& pose)
+  {
+    writeMatrix(pose.rotation());
+    writeMatrix(pose.center());
+  }
+
+  std::size_t size() const { return _buffer.size(); }
+  const std::vector<char>& buffer() const { return _buffer; }
+
+  /// overwrite an already written value
+  template<typename T>
+  void overwrite(std::size_t offset, const T& value)
+  {
+    std::memcpy(_buffer.data() + offset, &value, sizeof(T));
+  }
+
+private:
+  std::vector<char> _buffer;
+};
+
+/**
+ * @brief Deserialize the records of a memory-mapped section, with bounds checking
+ */
+class RecordReader
+{
+public:
+  RecordReader(const char* begin, const char* end, const std::string& filename)
+    : _current(begin)
+    , _end(end)
+    , _filename(filename)
+  {}
+
+  template<typename T>
+  T read()
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "RecordReader: only trivially copyable values can be read.");
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string readString()
+  {
+    const std::uint32_t size = read<std::uint32_t>();
+    const char* data = take(size);
+    return std::string(data, size);
+  }
+
+  std::vector<double> readVector()
+  {
+    const std::uint32_t size = read<std::uint32_t>();
+    std::vector<double> values(size);
+    for(double& value : values)
+      value = read<double>();
+    return values;
+  }
+
+  template<typename Derived>
+  void readMatrix(Eigen::MatrixBase<Derived>& matrix)
+  {
+    for(int i = 0; i < matrix.size(); ++i)
+      matrix(i) = static_cast<typename Derived::Scalar>(read<double>());
+  }
+
+  geometry::Pose3 readPose()
+  {
+    Mat3 rotation;
+    Vec3 center;
+    readMatrix(rotation);
+    readMatrix(center);
+    return geometry::Pose3(rotation, center);
+  }
+
+private:
+  const char* take(std::size_t size)
+  {
+    if(static_cast<std::size_t>(_end - _current) < size)
+      throw std::runtime_error("Can't load binary SfMData file, '" + _filename + "' has a corrupted section!");
+
+    const char* data = _current;
+    _current += size;
+    return data;
+  }
+
+  const char* _current;
+  const char* _end;
+  const std::string& _filename;
+};
+
+void writeView(const sfmData::View& view, RecordWriter& writer)
+{
+  writer.write(static_cast<std::uint32_t>(view.getViewId()));
+  writer.write(static_cast<std::uint32_t>(view.getPoseId()));
+  writer.write(static_cast<std::uint32_t>(view.getRigId()));
+  writer.write(static_cast<std::uint32_t>(view.getSubPoseId()));
+  writer.write(static_cast<std::uint32_t>(view.getFrameId()));
+  writer.write(static_cast<std::uint32_t>(view.getIntrinsicId()));
+  writer.write(static_cast<std::uint32_t>(view.getResectionId()));
+  writer.write(static_cast<std::uint8_t>(view.isPoseIndependant()));
+  writer.write(view.getImage().getImagePath());
+  writer.write(static_cast<std::uint64_t>(view.getImage().getWidth()));
+  writer.write(static_cast<std::uint64_t>(view.getImage().getHeight()));
+
+  const std::map<std::string, std::string>& metadata = view.getImage().getMetadata();
+  writer.write(static_cast<std::uint32_t>(metadata.size()));
+  for(const auto& metadataPair : metadata)
+  {
+    writer.write(metadataPair.first);
+    writer.write(metadataPair.second);
+  }
+
+  writer.write(static_cast<std::uint32_t>(view.getAncestors().size()));
+  for(const IndexT ancestor : view.getAncestors())
+    writer.write(static_cast<std::uint32_t>(ancestor));
+}
+
+void readView(sfmData::View& view, RecordReader& reader)
+{
+  view.setViewId(reader.read<std::uint32_t>());
+  view.setPoseId(reader.read<std::uint32_t>());
+  const IndexT rigId = reader.read<std::uint32_t>();
+  const IndexT subPoseId = reader.read<std::uint32_t>();
+  if(rigId != UndefinedIndexT)
+    view.setRigAndSubPoseId(rigId, subPoseId);
+  view.setFrameId(reader.read<std::uint32_t>());
+  view.setIntrinsicId(reader.read<std::uint32_t>());
+  view.setResectionId(reader.read<std::uint32_t>());
+  view.setIndependantPose(reader.read<std::uint8_t>() != 0);
+  view.getImage().setImagePath(reader.readString());
+  view.getImage().setWidth(static_cast<std::size_t>(reader.read<std::uint64_t>()));
+  view.getImage().setHeight(static_cast<std::size_t>(reader.read<std::uint64_t>()));
+
+  const std::uint32_t nbMetadata = reader.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbMetadata; ++i)
+  {
+    const std::string key = reader.readString();
+    view.getImage().addMetadata(key, reader.readString());
+  }
+
+  const std::uint32_t nbAncestors = reader.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbAncestors; ++i)
+    view.addAncestor(reader.read<std::uint32_t>());
+}
+
+void writeIntrinsic(IndexT intrinsicId, const camera::IntrinsicBase& intrinsic, RecordWriter& writer)
+{
+  writer.write(static_cast<std::uint32_t>(intrinsicId));
+  writer.write(static_cast<std::uint32_t>(intrinsic.getType()));
+  writer.write(static_cast<std::uint32_t>(intrinsic.w()));
+  writer.write(static_cast<std::uint32_t>(intrinsic.h()));
+  writer.write(intrinsic.sensorWidth());
+  writer.write(intrinsic.sensorHeight());
+  writer.write(intrinsic.serialNumber());
+  writer.write(static_cast<std::uint8_t>(intrinsic.getInitializationMode()));
+  writer.write(static_cast<std::uint8_t>(intrinsic.isLocked()));
+
+  // the focal length is stored in pixels, without conversion to millimeters
+  const camera::IntrinsicScaleOffset* intrinsicScaleOffset = dynamic_cast<const camera::IntrinsicScaleOffset*>(&intrinsic);
+  if(intrinsicScaleOffset)
+  {
+    writer.writeMatrix(intrinsicScaleOffset->getScale());
+    writer.writeMatrix(intrinsicScaleOffset->getOffset());
+    writer.writeMatrix(intrinsicScaleOffset->getInitialScale());
+    writer.write(static_cast<std::uint8_t>(intrinsicScaleOffset->isRatioLocked()));
+  }
+
+  const camera::IntrinsicScaleOffsetDisto* intrinsicScaleOffsetDisto = dynamic_cast<const camera::IntrinsicScaleOffsetDisto*>(&intrinsic);
+  if(intrinsicScaleOffsetDisto)
+  {
+    writer.write(static_cast<std::uint8_t>(intrinsicScaleOffsetDisto->getDistortionInitializationMode()));
+
+    std::shared_ptr<camera::Distortion> distortionObject = intrinsicScaleOffsetDisto->getDistortion();
+    writer.write(static_cast<std::uint8_t>(distortionObject != nullptr));
+    if(distortionObject)
+      writer.write(distortionObject->getParameters());
+
+    std::shared_ptr<camera::Undistortion> undistortionObject = intrinsicScaleOffsetDisto->getUndistortion();
+    writer.write(static_cast<std::uint8_t>(undistortionObject != nullptr));
+    if(undistortionObject)
+    {
+      writer.writeMatrix(undistortionObject->getOffset());
+      writer.write(undistortionObject->getParameters());
+    }
+  }
+
+  const camera::Equidistant* intrinsicEquidistant = dynamic_cast<const camera::Equidistant*>(&intrinsic);
+  if(intrinsicEquidistant)
+  {
+    writer.write(intrinsicEquidistant->getCircleCenterX());
+    writer.write(intrinsicEquidistant->getCircleCenterY());
+    writer.write(intrinsicEquidistant->getCircleRadius());
+  }
+}
+
+void readIntrinsic(IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic, RecordReader& reader)
+{
+  intrinsicId = reader.read<std::uint32_t>();
+  const camera::EINTRINSIC intrinsicType = static_cast<camera::EINTRINSIC>(reader.read<std::uint32_t>());
+  const unsigned int width = reader.read<std::uint32_t>();
+  const unsigned int height = reader.read<std::uint32_t>();
+  const double sensorWidth = reader.read<double>();
+  const double sensorHeight = reader.read<double>();
+  const std::string serialNumber = reader.readString();
+  const camera::EInitMode initializationMode = static_cast<camera::EInitMode>(reader.read<std::uint8_t>());
+  const bool locked = reader.read<std::uint8_t>() != 0;
+
+  intrinsic = camera::createIntrinsic(intrinsicType, width, height);
+
+  if(intrinsic == nullptr)
+    throw std::runtime_error("Can't load binary SfMData file, intrinsic " + std::to_string(intrinsicId) + " has an unknown type!");
+
+  intrinsic->setSerialNumber(serialNumber);
+  intrinsic->setInitializationMode(initializationMode);
+  intrinsic->setSensorWidth(sensorWidth);
+  intrinsic->setSensorHeight(sensorHeight);
+
+  if(locked)
+    intrinsic->lock();
+  else
+    intrinsic->unlock();
+
+  std::shared_ptr<camera::IntrinsicScaleOffset> intrinsicScaleOffset = std::dynamic_pointer_cast<camera::IntrinsicScaleOffset>(intrinsic);
+  if(intrinsicScaleOffset)
+  {
+    Vec2 scale, offset, initialScale;
+    reader.readMatrix(scale);
+    reader.readMatrix(offset);
+    reader.readMatrix(initialScale);
+
+    intrinsicScaleOffset->setScale(scale);
+    intrinsicScaleOffset->setOffset(offset);
+    intrinsicScaleOffset->setInitialScale(initialScale);
+    intrinsicScaleOffset->setRatioLocked(reader.read<std::uint8_t>() != 0);
+  }
+
+  std::shared_ptr<camera::IntrinsicScaleOffsetDisto> intrinsicScaleOffsetDisto = std::dynamic_pointer_cast<camera::IntrinsicScaleOffsetDisto>(intrinsic);
+  if(intrinsicScaleOffsetDisto)
+  {
+    intrinsicScaleOffsetDisto->setDistortionInitializationMode(static_cast<camera::EInitMode>(reader.read<std::uint8_t>()));
+
+    // ensure that we have the right number of params, as in the JSON loader
+    std::shared_ptr<camera::Distortion> distortionObject = intrinsicScaleOffsetDisto->getDistortion();
+    const bool hasDistortion = reader.read<std::uint8_t>() != 0;
+    const std::vector<double> distortionParams = hasDistortion ? reader.readVector() : std::vector<double>();
+
+    if(distortionObject && hasDistortion && distortionParams.size() == distortionObject->getParameters().size())
+      distortionObject->setParameters(distortionParams);
+    else
+      intrinsicScaleOffsetDisto->setDistortionObject(nullptr);
+
+    std::shared_ptr<camera::Undistortion> undistortionObject = intrinsicScaleOffsetDisto->getUndistortion();
+    const bool hasUndistortion = reader.read<std::uint8_t>() != 0;
+    Vec2 undistortionOffset = Vec2::Zero();
+    std::vector<double> undistortionParams;
+    if(hasUndistortion)
+    {
+      reader.readMatrix(undistortionOffset);
+      undistortionParams = reader.readVector();
+    }
+
+    if(undistortionObject && hasUndistortion && undistortionParams.size() == undistortionObject->getParameters().size())
+    {
+      undistortionObject->setParameters(undistortionParams);
+      undistortionObject->setOffset(undistortionOffset);
+    }
+    else
+    {
+      intrinsicScaleOffsetDisto->setUndistortionObject(nullptr);
+    }
+  }
+
+  std::shared_ptr<camera::Equidistant> intrinsicEquidistant = std::dynamic_pointer_cast<camera::Equidistant>(intrinsic);
+  if(intrinsicEquidistant)
+  {
+    intrinsicEquidistant->setCircleCenterX(reader.read<double>());
+    intrinsicEquidistant->setCircleCenterY(reader.read<double>());
+    intrinsicEquidistant->setCircleRadius(reader.read<double>());
+  }
+}
+
+/**
+ * @brief Write a landmark SoA array by chunks, without copying all the landmarks
+ * @param[in] file The output file
+ * @param[in] landmarks The landmarks
+ * @param[in] getValues Append the values of a landmark to the chunk
+ */
+template<typename T, typename GetValuesFunc>
+void writeLandmarkArray(std::ofstream& file, const sfmData::Landmarks& landmarks, GetValuesFunc getValues)
+{
+  constexpr std::size_t chunkSize = 1 << 16;
+  std::vector<T> chunk;
+  chunk.reserve(chunkSize + 32);
+
+  for(const auto& landmarkPair : landmarks)
+  {
+    getValues(landmarkPair.first, landmarkPair.second, chunk);
+
+    if(chunk.size() >= chunkSize)
+    {
+      file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size() * sizeof(T)));
+      chunk.clear();
+    }
+  }
+  file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size() * sizeof(T)));
+}
+
+} // namespace
+
+struct MappedSfMDataFile::MappingImpl
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+MappedSfMDataFile::MappedSfMDataFile(const std::string& filename)
+  : _filename(filename)
+{
+  try
+  {
+    _mapping.reset(new MappingImpl);
+    _mapping->file = boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+    _mapping->region = boost::interprocess::mapped_region(_mapping->file, boost::interprocess::read_only);
+  }
+  catch(const boost::interprocess::interprocess_exception& e)
+  {
+    throw std::runtime_error("Can't load binary SfMData file, can't open '" + filename + "' (" + e.what() + ")!");
+  }
+
+  const std::size_t fileSize = _mapping->region.get_size();
+  _data = static_cast<const char*>(_mapping->region.get_address());
+
+  if(fileSize < sizeof(SfMDataBinaryHeader))
+    throw std::runtime_error("Can't load binary SfMData file, '" + filename + "' is too small!");
+
+  _header = reinterpret_cast<const SfMDataBinaryHeader*>(_data);
+
+  if(std::memcmp(_header->magic, sfmDataBinaryMagic, sizeof(sfmDataBinaryMagic)) != 0)
+    throw std::runtime_error("Can't load binary SfMData file, '" + filename + "' is not a binary SfMData file!");
+
+  if(_header->version != sfmDataBinaryFormatVersion)
+    throw std::runtime_error("Can't load binary SfMData file, '" + filename + "' has an unsupported version (" +
+                             std::to_string(_header->version) + ")!");
+
+  // check that all sections are inside the file
+  for(const SfMDataBinarySection& section : _header->sections)
+  {
+    if(section.size != 0 && (section.offset > fileSize || section.size > fileSize - section.offset))
+      throw std::runtime_error("Can't load binary SfMData file, '" + filename + "' is truncated!");
+  }
+
+  // check the size of the landmark arrays
+  const std::uint64_t nbLandmarks = _header->nbLandmarks;
+  const std::uint64_t nbObservations = _header->nbObservations;
+
+  const auto checkArraySize = [&](ESfMDataBinarySection section, std::uint64_t expectedSize) {
+    if(hasSection(section) && _header->sections[section].size != expectedSize)
+      throw std::runtime_error("Can't load binary SfMData file, '" + filename + "' has an invalid landmark array!");
+  };
+
+  checkArraySize(SFMDATA_BINARY_LANDMARK_IDS, nbLandmarks * sizeof(std::uint32_t));
+  checkArraySize(SFMDATA_BINARY_LANDMARK_POSITIONS, nbLandmarks * 3 * sizeof(double));
+  checkArraySize(SFMDATA_BINARY_LANDMARK_COLORS, nbLandmarks * 3 * sizeof(std::uint8_t));
+  checkArraySize(SFMDATA_BINARY_LANDMARK_DESC_TYPES, nbLandmarks * sizeof(std::uint8_t));
+  checkArraySize(SFMDATA_BINARY_OBSERVATION_OFFSETS, (nbLandmarks + 1) * sizeof(std::uint64_t));
+  checkArraySize(SFMDATA_BINARY_OBSERVATION_VIEW_IDS, nbObservations * sizeof(std::uint32_t));
+  checkArraySize(SFMDATA_BINARY_OBSERVATION_FEATURE_IDS, nbObservations * sizeof(std::uint32_t));
+  checkArraySize(SFMDATA_BINARY_OBSERVATION_PIXELS, nbObservations * 2 * sizeof(double));
+  checkArraySize(SFMDATA_BINARY_OBSERVATION_SCALES, nbObservations * sizeof(double));
+
+  // the observation ranges of the landmarks are used without bound checks
+  if(hasSection(SFMDATA_BINARY_OBSERVATION_OFFSETS))
+  {
+    const std::uint64_t* offsets = getObservationOffsets();
+    bool validOffsets = (offsets[nbLandmarks] == nbObservations);
+    for(std::uint64_t i = 0; validOffsets && i < nbLandmarks; ++i)
+      validOffsets = (offsets[i] <= offsets[i + 1]);
+
+    if(!validOffsets)
+      throw std::runtime_error("Can't load binary SfMData file, '" + filename + "' has invalid observation offsets!");
+  }
+}
+
+MappedSfMDataFile::~MappedSfMDataFile() = default;
+
+void MappedSfMDataFile::loadFolders(sfmData::SfMData& sfmData) const
+{
+  if(!hasSection(SFMDATA_BINARY_FOLDERS))
+    return;
+
+  const SfMDataBinarySection& section = _header->sections[SFMDATA_BINARY_FOLDERS];
+  RecordReader reader(_data + section.offset, _data + section.offset + section.size, _filename);
+
+  const std::uint32_t nbFeaturesFolders = reader.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbFeaturesFolders; ++i)
+    sfmData.addFeaturesFolder(reader.readString());
+
+  const std::uint32_t nbMatchesFolders = reader.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbMatchesFolders; ++i)
+    sfmData.addMatchesFolder(reader.readString());
+}
+
+void MappedSfMDataFile::loadViews(sfmData::SfMData& sfmData) const
+{
+  if(!hasSection(SFMDATA_BINARY_VIEWS))
+    return;
+
+  const SfMDataBinarySection& section = _header->sections[SFMDATA_BINARY_VIEWS];
+  const char* sectionBegin = _data + section.offset;
+  const char* sectionEnd = sectionBegin + section.size;
+
+  RecordReader tableReader(sectionBegin, sectionEnd, _filename);
+  const std::uint64_t nbViews = tableReader.read<std::uint64_t>();
+
+  if(nbViews > (section.size - sizeof(std::uint64_t)) / sizeof(std::uint64_t))
+    throw std::runtime_error("Can't load binary SfMData file, '" + _filename + "' has a corrupted views section!");
+
+  std::vector<std::uint64_t> recordOffsets(nbViews + 1);
+  for(std::uint64_t i = 0; i < nbViews; ++i)
+    recordOffsets[i] = tableReader.read<std::uint64_t>();
+  recordOffsets[nbViews] = section.size;
+
+  for(std::uint64_t i = 0; i < nbViews; ++i)
+  {
+    if(recordOffsets[i] > recordOffsets[i + 1])
+      throw std::runtime_error("Can't load binary SfMData file, '" + _filename + "' has a corrupted views section!");
+  }
+
+  std::vector<std::shared_ptr<sfmData::View>> views(nbViews);
+  bool isValid = true;
+
+  // each view record is parsed independently
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(nbViews); ++i)
+  {
+    try
+    {
+      RecordReader reader(sectionBegin + recordOffsets[i], sectionBegin + recordOffsets[i + 1], _filename);
+      std::shared_ptr<sfmData::View> view = std::make_shared<sfmData::View>();
+      readView(*view, reader);
+      views[i] = view;
+    }
+    catch(const std::exception&)
+    {
+      #pragma omp critical
+      isValid = false;
+    }
+  }
+
+  if(!isValid)
+    throw std::runtime_error("Can't load binary SfMData file, '" + _filename + "' has a corrupted views section!");
+
+  for(const std::shared_ptr<sfmData::View>& view : views)
+    sfmData.getViews().emplace(view->getViewId(), view);
+}
+
+void MappedSfMDataFile::loadIntrinsics(sfmData::SfMData& sfmData) const
+{
+  if(!hasSection(SFMDATA_BINARY_INTRINSICS))
+    return;
+
+  const SfMDataBinarySection& section = _header->sections[SFMDATA_BINARY_INTRINSICS];
+  RecordReader reader(_data + section.offset, _data + section.offset + section.size, _filename);
+
+  const std::uint32_t nbIntrinsics = reader.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbIntrinsics; ++i)
+  {
+    IndexT intrinsicId;
+    std::shared_ptr<camera::IntrinsicBase> intrinsic;
+
+    readIntrinsic(intrinsicId, intrinsic, reader);
+
+    sfmData.getIntrinsics().emplace(intrinsicId, intrinsic);
+  }
+}
+
+void MappedSfMDataFile::loadExtrinsics(sfmData::SfMData& sfmData) const
+{
+  if(!hasSection(SFMDATA_BINARY_EXTRINSICS))
+    return;
+
+  const SfMDataBinarySection& section = _header->sections[SFMDATA_BINARY_EXTRINSICS];
+  RecordReader reader(_data + section.offset, _data + section.offset + section.size, _filename);
+
+  // poses
+  const std::uint32_t nbPoses = reader.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbPoses; ++i)
+  {
+    const IndexT poseId = reader.read<std::uint32_t>();
+    const geometry::Pose3 transform = reader.readPose();
+    const bool locked = reader.read<std::uint8_t>() != 0;
+
+    sfmData.getPoses().emplace(poseId, sfmData::CameraPose(transform, locked));
+  }
+
+  // rigs
+  const std::uint32_t nbRigs = reader.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbRigs; ++i)
+  {
+    const IndexT rigId = reader.read<std::uint32_t>();
+    const std::uint32_t nbSubPoses = reader.read<std::uint32_t>();
+    sfmData::Rig rig(nbSubPoses);
+
+    for(std::uint32_t subPoseId = 0; subPoseId < nbSubPoses; ++subPoseId)
+    {
+      sfmData::RigSubPose subPose;
+      subPose.status = static_cast<sfmData::ERigSubPoseStatus>(reader.read<std::uint8_t>());
+      subPose.pose = reader.readPose();
+      rig.setSubPose(subPoseId, subPose);
+    }
+
+    sfmData.getRigs().emplace(rigId, rig);
+  }
+}
+
+void MappedSfMDataFile::loadLandmarks(sfmData::SfMData& sfmData, bool loadObservations, bool loadFeatures) const
+{
+  if(!hasSection(SFMDATA_BINARY_LANDMARK_IDS))
+    return;
+
+  loadObservations = loadObservations && hasSection(SFMDATA_BINARY_OBSERVATION_VIEW_IDS);
+  loadFeatures = loadFeatures && loadObservations && hasSection(SFMDATA_BINARY_OBSERVATION_FEATURE_IDS);
+
+  const std::uint32_t* ids = getLandmarkIds();
+  const double* positions = getLandmarkPositions();
+  const std::uint8_t* colors = getLandmarkColors();
+  const std::uint8_t* descTypes = getLandmarkDescTypes();
+  const std::uint64_t* offsets = getObservationOffsets();
+  const std::uint32_t* viewIds = getObservationViewIds();
+  const std::uint32_t* featureIds = getObservationFeatureIds();
+  const double* pixels = getObservationPixels();
+  const double* scales = getObservationScales();
+
+  sfmData::Landmarks& landmarks = sfmData.getLandmarks();
+
+  for(std::size_t i = 0; i < getNbLandmarks(); ++i)
+  {
+    sfmData::Landmark& landmark = landmarks[ids[i]];
+
+    landmark.X = Vec3(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+    landmark.rgb = image::RGBColor(colors[3 * i], colors[3 * i + 1], colors[3 * i + 2]);
+    landmark.descType = static_cast<feature::EImageDescriberType>(descTypes[i]);
+
+    if(!loadObservations)
+      continue;
+
+    landmark.observations.reserve(offsets[i + 1] - offsets[i]);
+
+    for(std::uint64_t j = offsets[i]; j < offsets[i + 1]; ++j)
+    {
+      sfmData::Observation observation;
+
+      if(loadFeatures)
+      {
+        observation.id_feat = featureIds[j];
+        observation.x = Vec2(pixels[2 * j], pixels[2 * j + 1]);
+        observation.scale = scales[j];
+      }
+
+      // observations are sorted by view id
+      landmark.observations.emplace_hint(landmark.observations.end(), viewIds[j], observation);
+    }
+  }
+}
+
+void MappedSfMDataFile::loadLandmarks(sfmData::CompactLandmarks& out_landmarks, bool loadObservations) const
+{
+  out_landmarks.clear();
+
+  if(!hasSection(SFMDATA_BINARY_LANDMARK_IDS))
+    return;
+
+  loadObservations = loadObservations && hasSection(SFMDATA_BINARY_OBSERVATION_VIEW_IDS);
+  const bool loadFeatures = loadObservations && hasSection(SFMDATA_BINARY_OBSERVATION_FEATURE_IDS);
+
+  const std::uint32_t* ids = getLandmarkIds();
+  const double* positions = getLandmarkPositions();
+  const std::uint8_t* colors = getLandmarkColors();
+  const std::uint8_t* descTypes = getLandmarkDescTypes();
+  const std::uint64_t* offsets = getObservationOffsets();
+  const std::uint32_t* viewIds = getObservationViewIds();
+  const std::uint32_t* featureIds = getObservationFeatureIds();
+  const double* pixels = getObservationPixels();
+  const double* scales = getObservationScales();
+
+  out_landmarks.reserve(getNbLandmarks(), loadObservations ? getNbObservations() : 0);
+
+  for(std::size_t i = 0; i < getNbLandmarks(); ++i)
+  {
+    out_landmarks.addLandmark(ids[i],
+                              Vec3(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]),
+                              static_cast<feature::EImageDescriberType>(descTypes[i]),
+                              image::RGBColor(colors[3 * i], colors[3 * i + 1], colors[3 * i + 2]));
+
+    if(!loadObservations)
+      continue;
+
+    for(std::uint64_t j = offsets[i]; j < offsets[i + 1]; ++j)
+    {
+      const sfmData::Observation observation = loadFeatures ? sfmData::Observation(Vec2(pixels[2 * j], pixels[2 * j + 1]), featureIds[j], scales[j])
+                                                            : sfmData::Observation();
+      out_landmarks.addObservation(viewIds[j], observation);
+    }
+  }
+}
+
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
+  const bool saveObservations = saveFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
+
+  const sfmData::Landmarks& landmarks = sfmData.getLandmarks();
+
+  // serialized sections
+
+  RecordWriter foldersWriter;
+  {
+    foldersWriter.write(static_cast<std::uint32_t>(sfmData.getRelativeFeaturesFolders().size()));
+    for(const std::string& featuresFolder : sfmData.getRelativeFeaturesFolders())
+      foldersWriter.write(featuresFolder);
+
+    foldersWriter.write(static_cast<std::uint32_t>(sfmData.getRelativeMatchesFolders().size()));
+    for(const std::string& matchesFolder : sfmData.getRelativeMatchesFolders())
+      foldersWriter.write(matchesFolder);
+  }
+
+  RecordWriter viewsWriter;
+  if(saveViews && !sfmData.getViews().empty())
+  {
+    // offset table, filled once the records are written
+    const std::size_t nbViews = sfmData.getViews().size();
+    viewsWriter.write(static_cast<std::uint64_t>(nbViews));
+    for(std::size_t i = 0; i < nbViews; ++i)
+      viewsWriter.write(std::uint64_t(0));
+
+    std::size_t i = 0;
+    for(const auto& viewPair : sfmData.getViews())
+    {
+      viewsWriter.overwrite(sizeof(std::uint64_t) * (i + 1), static_cast<std::uint64_t>(viewsWriter.size()));
+      writeView(*viewPair.second, viewsWriter);
+      ++i;
+    }
+  }
+
+  RecordWriter intrinsicsWriter;
+  if(saveIntrinsics && !sfmData.getIntrinsics().empty())
+  {
+    intrinsicsWriter.write(static_cast<std::uint32_t>(sfmData.getIntrinsics().size()));
+    for(const auto& intrinsicPair : sfmData.getIntrinsics())
+      writeIntrinsic(intrinsicPair.first, *intrinsicPair.second, intrinsicsWriter);
+  }
+
+  RecordWriter extrinsicsWriter;
+  if(saveExtrinsics)
+  {
+    extrinsicsWriter.write(static_cast<std::uint32_t>(sfmData.getPoses().size()));
+    for(const auto& posePair : sfmData.getPoses())
+    {
+      extrinsicsWriter.write(static_cast<std::uint32_t>(posePair.first));
+      extrinsicsWriter.writePose(posePair.second.getTransform());
+      extrinsicsWriter.write(static_cast<std::uint8_t>(posePair.second.isLocked()));
+    }
+
+    extrinsicsWriter.write(static_cast<std::uint32_t>(sfmData.getRigs().size()));
+    for(const auto& rigPair : sfmData.getRigs())
+    {
+      extrinsicsWriter.write(static_cast<std::uint32_t>(rigPair.first));
+      extrinsicsWriter.write(static_cast<std::uint32_t>(rigPair.second.getSubPoses().size()));
+      for(const sfmData::RigSubPose& subPose : rigPair.second.getSubPoses())
+      {
+        extrinsicsWriter.write(static_cast<std::uint8_t>(subPose.status));
+        extrinsicsWriter.writePose(subPose.pose);
+      }
+    }
+  }
+
+  // build header
+
+  SfMDataBinaryHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, sfmDataBinaryMagic, sizeof(sfmDataBinaryMagic));
+  header.version = sfmDataBinaryFormatVersion;
+  header.partFlag = static_cast<std::uint32_t>(partFlag);
+
+  if(saveStructure)
+  {
+    header.nbLandmarks = landmarks.size();
+    if(saveObservations)
+      for(const auto& landmarkPair : landmarks)
+        header.nbObservations += landmarkPair.second.observations.size();
+  }
+
+  const std::uint64_t nbLandmarks = header.nbLandmarks;
+  const std::uint64_t nbObservations = header.nbObservations;
+
+  header.sections[SFMDATA_BINARY_FOLDERS].size = foldersWriter.size();
+  header.sections[SFMDATA_BINARY_VIEWS].size = viewsWriter.size();
+  header.sections[SFMDATA_BINARY_INTRINSICS].size = intrinsicsWriter.size();
+  header.sections[SFMDATA_BINARY_EXTRINSICS].size = extrinsicsWriter.size();
+
+  if(nbLandmarks > 0)
+  {
+    header.sections[SFMDATA_BINARY_LANDMARK_IDS].size = nbLandmarks * sizeof(std::uint32_t);
+    header.sections[SFMDATA_BINARY_LANDMARK_POSITIONS].size = nbLandmarks * 3 * sizeof(double);
+    header.sections[SFMDATA_BINARY_LANDMARK_COLORS].size = nbLandmarks * 3 * sizeof(std::uint8_t);
+    header.sections[SFMDATA_BINARY_LANDMARK_DESC_TYPES].size = nbLandmarks * sizeof(std::uint8_t);
+
+    if(saveObservations)
+    {
+      header.sections[SFMDATA_BINARY_OBSERVATION_OFFSETS].size = (nbLandmarks + 1) * sizeof(std::uint64_t);
+      header.sections[SFMDATA_BINARY_OBSERVATION_VIEW_IDS].size = nbObservations * sizeof(std::uint32_t);
+    }
+
+    if(saveFeatures)
+    {
+      header.sections[SFMDATA_BINARY_OBSERVATION_FEATURE_IDS].size = nbObservations * sizeof(std::uint32_t);
+      header.sections[SFMDATA_BINARY_OBSERVATION_PIXELS].size = nbObservations * 2 * sizeof(double);
+      header.sections[SFMDATA_BINARY_OBSERVATION_SCALES].size = nbObservations * sizeof(double);
+    }
+  }
+
+  // empty sections are not stored, the offsets follow the sections order
+  std::uint64_t endOffset = sizeof(SfMDataBinaryHeader);
+  for(SfMDataBinarySection& section : header.sections)
+  {
+    if(section.size == 0)
+      continue;
+    section.offset = alignOffset(endOffset);
+    endOffset = section.offset + section.size;
+  }
+
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+
+  if(!file.is_open())
+    throw std::runtime_error("Can't save binary SfMData file, can't open '" + filename + "' !");
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  std::uint64_t offset = sizeof(header);
+
+  // write each non-empty section after its padding
+  const auto writeSection = [&](ESfMDataBinarySection sectionId, const std::function<void()>& writeContent) {
+    const SfMDataBinarySection& section = header.sections[sectionId];
+    if(section.size == 0)
+      return;
+    writePadding(file, offset, section.offset);
+    writeContent();
+    offset = section.offset + section.size;
+  };
+
+  const auto writeRecords = [&](const RecordWriter& writer) {
+    file.write(writer.buffer().data(), static_cast<std::streamsize>(writer.size()));
+  };
+
+  writeSection(SFMDATA_BINARY_FOLDERS, [&]() { writeRecords(foldersWriter); });
+  writeSection(SFMDATA_BINARY_VIEWS, [&]() { writeRecords(viewsWriter); });
+  writeSection(SFMDATA_BINARY_INTRINSICS, [&]() { writeRecords(intrinsicsWriter); });
+  writeSection(SFMDATA_BINARY_EXTRINSICS, [&]() { writeRecords(extrinsicsWriter); });
+
+  // landmark arrays, streamed from the landmarks
+
+  writeSection(SFMDATA_BINARY_LANDMARK_IDS, [&]() {
+    writeLandmarkArray<std::uint32_t>(file, landmarks, [](IndexT landmarkId, const sfmData::Landmark&, std::vector<std::uint32_t>& chunk) {
+      chunk.push_back(landmarkId);
+    });
+  });
+
+  writeSection(SFMDATA_BINARY_LANDMARK_POSITIONS, [&]() {
+    writeLandmarkArray<double>(file, landmarks, [](IndexT, const sfmData::Landmark& landmark, std::vector<double>& chunk) {
+      chunk.insert(chunk.end(), landmark.X.data(), landmark.X.data() + 3);
+    });
+  });
+
+  writeSection(SFMDATA_BINARY_LANDMARK_COLORS, [&]() {
+    writeLandmarkArray<std::uint8_t>(file, landmarks, [](IndexT, const sfmData::Landmark& landmark, std::vector<std::uint8_t>& chunk) {
+      chunk.insert(chunk.end(), {landmark.rgb.r(), landmark.rgb.g(), landmark.rgb.b()});
+    });
+  });
+
+  writeSection(SFMDATA_BINARY_LANDMARK_DESC_TYPES, [&]() {
+    writeLandmarkArray<std::uint8_t>(file, landmarks, [](IndexT, const sfmData::Landmark& landmark, std::vector<std::uint8_t>& chunk) {
+      chunk.push_back(static_cast<std::uint8_t>(landmark.descType));
+    });
+  });
+
+  writeSection(SFMDATA_BINARY_OBSERVATION_OFFSETS, [&]() {
+    std::uint64_t observationOffset = 0;
+    file.write(reinterpret_cast<const char*>(&observationOffset), sizeof(observationOffset));
+    writeLandmarkArray<std::uint64_t>(file, landmarks, [&](IndexT, const sfmData::Landmark& landmark, std::vector<std::uint64_t>& chunk) {
+      observationOffset += landmark.observations.size();
+      chunk.push_back(observationOffset);
+    });
+  });
+
+  writeSection(SFMDATA_BINARY_OBSERVATION_VIEW_IDS, [&]() {
+    writeLandmarkArray<std::uint32_t>(file, landmarks, [](IndexT, const sfmData::Landmark& landmark, std::vector<std::uint32_t>& chunk) {
+      for(const auto& observationPair : landmark.observations)
+        chunk.push_back(observationPair.first);
+    });
+  });
+
+  writeSection(SFMDATA_BINARY_OBSERVATION_FEATURE_IDS, [&]() {
+    writeLandmarkArray<std::uint32_t>(file, landmarks, [](IndexT, const sfmData::Landmark& landmark, std::vector<std::uint32_t>& chunk) {
+      for(const auto& observationPair : landmark.observations)
+        chunk.push_back(observationPair.second.id_feat);
+    });
+  });
+
+  writeSection(SFMDATA_BINARY_OBSERVATION_PIXELS, [&]() {
+    writeLandmarkArray<double>(file, landmarks, [](IndexT, const sfmData::Landmark& landmark, std::vector<double>& chunk) {
+      for(const auto& observationPair : landmark.observations)
+        chunk.insert(chunk.end(), {observationPair.second.x(0), observationPair.second.x(1)});
+    });
+  });
+
+  writeSection(SFMDATA_BINARY_OBSERVATION_SCALES, [&]() {
+    writeLandmarkArray<double>(file, landmarks, [](IndexT, const sfmData::Landmark& landmark, std::vector<double>& chunk) {
+      for(const auto& observationPair : landmark.observations)
+        chunk.push_back(observationPair.second.scale);
+    });
+  });
+
+  if(!file.good())
+    throw std::runtime_error("Can't save binary SfMData file, '" + filename + "' is incorrect !");
+
+  file.close();
+  return true;
+}
+
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // load flags
+  const bool loadViews = (partFlag & VIEWS) == VIEWS;
+  const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool loadExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool loadFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
+  const bool loadObservations = loadFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
+
+  const MappedSfMDataFile file(filename);
+
+  // only the requested sections are read, the other pages of the file are never touched
+  file.loadFolders(sfmData);
+
+  if(loadIntrinsics)
+    file.loadIntrinsics(sfmData);
+
+  if(loadViews)
+    file.loadViews(sfmData);
+
+  if(loadExtrinsics)
+    file.loadExtrinsics(sfmData);
+
+  if(loadStructure)
+    file.loadLandmarks(sfmData, loadObservations, loadFeatures);
+
+  return true;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
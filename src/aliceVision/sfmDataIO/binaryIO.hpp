@@ -0,0 +1,194 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfmData/CompactLandmarks.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+/// Binary SfMData file extension
+const std::string sfmDataBinaryFileExtension = ".sfmb";
+
+/// Binary SfMData file format version
+constexpr std::uint32_t sfmDataBinaryFormatVersion = 1;
+
+/// Alignment (in bytes) of each section in the binary SfMData file
+constexpr std::size_t sfmDataBinarySectionAlignment = 64;
+
+/**
+ * @brief Binary SfMData file sections.
+ *
+ * The first sections are serialized records, the landmark sections are SoA arrays
+ * that can be accessed in place: observations are stored in compressed sparse rows,
+ * the observations of the landmark i are in [observationOffsets[i], observationOffsets[i+1]).
+ */
+enum ESfMDataBinarySection : std::uint32_t
+{
+  SFMDATA_BINARY_FOLDERS = 0,                 //< relative features and matches folders
+  SFMDATA_BINARY_VIEWS,                       //< view records, with an offset table for parallel parsing
+  SFMDATA_BINARY_INTRINSICS,                  //< intrinsic records
+  SFMDATA_BINARY_EXTRINSICS,                  //< pose and rig records
+  SFMDATA_BINARY_LANDMARK_IDS,                //< uint32 [nbLandmarks]
+  SFMDATA_BINARY_LANDMARK_POSITIONS,          //< float64 [nbLandmarks * 3]
+  SFMDATA_BINARY_LANDMARK_COLORS,             //< uint8 [nbLandmarks * 3]
+  SFMDATA_BINARY_LANDMARK_DESC_TYPES,         //< uint8 [nbLandmarks]
+  SFMDATA_BINARY_OBSERVATION_OFFSETS,         //< uint64 [nbLandmarks + 1]
+  SFMDATA_BINARY_OBSERVATION_VIEW_IDS,        //< uint32 [nbObservations]
+  SFMDATA_BINARY_OBSERVATION_FEATURE_IDS,     //< uint32 [nbObservations]
+  SFMDATA_BINARY_OBSERVATION_PIXELS,          //< float64 [nbObservations * 2]
+  SFMDATA_BINARY_OBSERVATION_SCALES,          //< float64 [nbObservations]
+
+  SFMDATA_BINARY_NB_SECTIONS
+};
+
+/**
+ * @brief Binary SfMData file section, a section of size 0 is not stored
+ */
+struct SfMDataBinarySection
+{
+  std::uint64_t offset;                    //< byte offset of the section
+  std::uint64_t size;                      //< size in bytes of the section
+};
+
+/**
+ * @brief Binary SfMData file header.
+ *
+ * The header is followed by the aligned sections.
+ * Values are stored in the native byte order (little-endian on all supported platforms).
+ */
+struct SfMDataBinaryHeader
+{
+  char magic[8];                           //< "AVSFMBIN"
+  std::uint32_t version;                   //< file format version
+  std::uint32_t partFlag;                  //< ESfMData parts saved in the file
+  std::uint64_t nbLandmarks;               //< number of landmarks
+  std::uint64_t nbObservations;            //< total number of observations
+  SfMDataBinarySection sections[SFMDATA_BINARY_NB_SECTIONS];
+};
+
+static_assert(sizeof(SfMDataBinaryHeader) == 32 + 16 * SFMDATA_BINARY_NB_SECTIONS, "Unexpected binary SfMData header size.");
+
+/**
+ * @brief Read-only memory-mapped binary SfMData file.
+ *
+ * Each part of the scene is loaded independently, on demand.
+ * The landmark arrays can be accessed in place, without any parsing or copy.
+ */
+class MappedSfMDataFile
+{
+public:
+
+  /**
+   * @brief Map the given binary SfMData file in memory.
+   * @param[in] filename the binary SfMData file path
+   * @note throw if the file cannot be opened or is invalid
+   */
+  explicit MappedSfMDataFile(const std::string& filename);
+
+  ~MappedSfMDataFile();
+
+  // no copy
+  MappedSfMDataFile(const MappedSfMDataFile&) = delete;
+  MappedSfMDataFile& operator=(const MappedSfMDataFile&) = delete;
+
+  inline const SfMDataBinaryHeader& getHeader() const { return *_header; }
+  inline ESfMData getPartFlag() const { return static_cast<ESfMData>(_header->partFlag); }
+  inline bool hasSection(ESfMDataBinarySection section) const { return _header->sections[section].size != 0; }
+
+  inline std::size_t getNbLandmarks() const { return static_cast<std::size_t>(_header->nbLandmarks); }
+  inline std::size_t getNbObservations() const { return static_cast<std::size_t>(_header->nbObservations); }
+
+  inline const std::uint32_t* getLandmarkIds() const { return getSection<std::uint32_t>(SFMDATA_BINARY_LANDMARK_IDS); }
+  inline const double* getLandmarkPositions() const { return getSection<double>(SFMDATA_BINARY_LANDMARK_POSITIONS); }
+  inline const std::uint8_t* getLandmarkColors() const { return getSection<std::uint8_t>(SFMDATA_BINARY_LANDMARK_COLORS); }
+  inline const std::uint8_t* getLandmarkDescTypes() const { return getSection<std::uint8_t>(SFMDATA_BINARY_LANDMARK_DESC_TYPES); }
+  inline const std::uint64_t* getObservationOffsets() const { return getSection<std::uint64_t>(SFMDATA_BINARY_OBSERVATION_OFFSETS); }
+  inline const std::uint32_t* getObservationViewIds() const { return getSection<std::uint32_t>(SFMDATA_BINARY_OBSERVATION_VIEW_IDS); }
+  inline const std::uint32_t* getObservationFeatureIds() const { return getSection<std::uint32_t>(SFMDATA_BINARY_OBSERVATION_FEATURE_IDS); }
+  inline const double* getObservationPixels() const { return getSection<double>(SFMDATA_BINARY_OBSERVATION_PIXELS); }
+  inline const double* getObservationScales() const { return getSection<double>(SFMDATA_BINARY_OBSERVATION_SCALES); }
+
+  /**
+   * @brief Load the relative features and matches folders.
+   * @param[in,out] sfmData The SfMData
+   */
+  void loadFolders(sfmData::SfMData& sfmData) const;
+
+  /**
+   * @brief Load the views, parsed in parallel.
+   * @param[in,out] sfmData The SfMData
+   */
+  void loadViews(sfmData::SfMData& sfmData) const;
+
+  /**
+   * @brief Load the intrinsics.
+   * @param[in,out] sfmData The SfMData
+   */
+  void loadIntrinsics(sfmData::SfMData& sfmData) const;
+
+  /**
+   * @brief Load the poses and the rigs.
+   * @param[in,out] sfmData The SfMData
+   */
+  void loadExtrinsics(sfmData::SfMData& sfmData) const;
+
+  /**
+   * @brief Load the landmarks.
+   * @param[in,out] sfmData The SfMData
+   * @param[in] loadObservations Load the landmark observations
+   * @param[in] loadFeatures Load the features (feature id, pixel, scale) of the observations
+   */
+  void loadLandmarks(sfmData::SfMData& sfmData, bool loadObservations = true, bool loadFeatures = true) const;
+
+  /**
+   * @brief Load the landmarks in a compact storage, with array copies only.
+   * @param[out] out_landmarks The compact landmarks
+   * @param[in] loadObservations Load the landmark observations
+   */
+  void loadLandmarks(sfmData::CompactLandmarks& out_landmarks, bool loadObservations = true) const;
+
+private:
+  template<typename T>
+  inline const T* getSection(ESfMDataBinarySection section) const
+  {
+    return hasSection(section) ? reinterpret_cast<const T*>(_data + _header->sections[section].offset) : nullptr;
+  }
+
+  struct MappingImpl;
+  std::unique_ptr<MappingImpl> _mapping;
+  const char* _data = nullptr;
+  const SfMDataBinaryHeader* _header = nullptr;
+  std::string _filename;
+};
+
+/**
+ * @brief Save an SfMData in a binary SfMData file.
+ * @param[in] sfmData The input SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData save flag
+ * @return true if completed
+ */
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+/**
+ * @brief Load a binary SfMData file.
+ * @param[out] sfmData The output SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData load flag
+ * @return true if completed
+ */
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+} // namespace sfmDataIO
+} // namespace aliceVision
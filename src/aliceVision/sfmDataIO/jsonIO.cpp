@@ -5,12 +5,17 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "jsonIO.hpp"
+#include <aliceVision/sfmDataIO/jsonStream.hpp>
 #include <aliceVision/camera/camera.hpp>
 #include <aliceVision/sfmDataIO/viewIO.hpp>
 
 #include <boost/property_tree/json_parser.hpp>
 
+#include <fstream>
 #include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
 #include <cassert>
 
 namespace aliceVision {
@@ -199,20 +204,65 @@ void saveIntrinsic(const std::string& name, IndexT intrinsicId, const std::share
  
 }
 
-void loadIntrinsic(const Version & version, IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic,
-                   bpt::ptree& intrinsicTree)
+namespace {
+
+/**
+ * @brief Intrinsic fields read from a file, all the file versions are supported
+ */
+struct IntrinsicDesc
 {
-  intrinsicId = intrinsicTree.get<IndexT>("intrinsicId");
-  const unsigned int width = intrinsicTree.get<unsigned int>("width");
-  const unsigned int height = intrinsicTree.get<unsigned int>("height");
-  const double sensorWidth = intrinsicTree.get<double>("sensorWidth", 36.0);
-  const double sensorHeight = intrinsicTree.get<double>("sensorHeight", 24.0);
-  const camera::EINTRINSIC intrinsicType = camera::EINTRINSIC_stringToEnum(intrinsicTree.get<std::string>("type"));
-  const camera::EInitMode initializationMode = camera::EInitMode_stringToEnum(intrinsicTree.get<std::string>("initializationMode", camera::EInitMode_enumToString(camera::EInitMode::CALIBRATED)));
+  std::optional<IndexT> intrinsicId;
+  std::optional<unsigned int> width;
+  std::optional<unsigned int> height;
+  double sensorWidth = 36.0;
+  double sensorHeight = 24.0;
+  std::optional<std::string> serialNumber;
+  std::optional<std::string> type;
+  std::string initializationMode = camera::EInitMode_enumToString(camera::EInitMode::CALIBRATED);
+  std::optional<Vec2> principalPoint;
+  std::optional<Vec2> pxFocalLength;           //< version < 1.2.2
+  double focalLength = 1.0;
+  double pixelRatio = 1.0;
+  std::optional<double> pxInitialFocalLength;  //< version < 1.2.2
+  std::optional<double> initialFocalLength;
+  std::optional<bool> pixelRatioLocked;
+  std::string distortionInitializationMode = camera::EInitMode_enumToString(camera::EInitMode::NONE);
+  std::optional<std::vector<double>> distortionParams;
+  std::optional<Vec2> undistortionOffset;
+  std::optional<std::vector<double>> undistortionParams;
+  double fisheyeCircleCenterX = 0.0;
+  double fisheyeCircleCenterY = 0.0;
+  double fisheyeCircleRadius = 1.0;
+  bool locked = false;
+};
+
+template<typename T>
+const T& getRequired(const std::optional<T>& value, const std::string& name)
+{
+  if(!value)
+    throw std::runtime_error("Invalid intrinsic, the field '" + name + "' is missing.");
+  return *value;
+}
+
+/**
+ * @brief Create an intrinsic from the fields read in a file.
+ * @param[in] version File versioning for dealing with compatibility
+ * @param[in] desc The intrinsic fields
+ * @param[out] intrinsicId The output Intrinsic Id
+ * @param[out] intrinsic The output Intrinsic
+ */
+void createIntrinsicFromDesc(const Version& version, const IntrinsicDesc& desc, IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic)
+{
+  intrinsicId = getRequired(desc.intrinsicId, "intrinsicId");
+  const unsigned int width = getRequired(desc.width, "width");
+  const unsigned int height = getRequired(desc.height, "height");
+  const double sensorWidth = desc.sensorWidth;
+  const double sensorHeight = desc.sensorHeight;
+  const camera::EINTRINSIC intrinsicType = camera::EINTRINSIC_stringToEnum(getRequired(desc.type, "type"));
+  const camera::EInitMode initializationMode = camera::EInitMode_stringToEnum(desc.initializationMode);
 
   // principal point
-  Vec2 principalPoint;
-  loadMatrix("principalPoint", principalPoint, intrinsicTree);
+  Vec2 principalPoint = getRequired(desc.principalPoint, "principalPoint");
 
   if (version < Version(1,2,1))
   {
@@ -222,21 +272,15 @@ void loadIntrinsic(const Version & version, IndexT& intrinsicId, std::shared_ptr
 
   // Focal length
   Vec2 pxFocalLength;
-  if (version < Version(1,2,0))
-  {
-      pxFocalLength(0) = intrinsicTree.get<double>("pxFocalLength", -1);
-      // Only one focal value for X and Y in previous versions
-      pxFocalLength(1) = pxFocalLength(0);
-  }
-  else if (version < Version(1,2,2)) // version >= 1.2
+  if (version < Version(1,2,2)) // pxFocalLength: one focal value for X and Y before version 1.2
   {
-    loadMatrix("pxFocalLength", pxFocalLength, intrinsicTree);
+    pxFocalLength = getRequired(desc.pxFocalLength, "pxFocalLength");
   }
   else if (version < Version(1,2,5))
   {
-    const double fmm = intrinsicTree.get<double>("focalLength", 1.0);
+    const double fmm = desc.focalLength;
     // pixelRatio field was actually storing the focalRatio before version 1.2.5
-    const double focalRatio = intrinsicTree.get<double>("pixelRatio", 1.0);
+    const double focalRatio = desc.pixelRatio;
 
     const double fx = (fmm / sensorWidth) * double(width);
     const double fy = fx / focalRatio;
@@ -246,8 +290,8 @@ void loadIntrinsic(const Version & version, IndexT& intrinsicId, std::shared_ptr
   }
   else
   {
-    const double fmm = intrinsicTree.get<double>("focalLength", 1.0);
-    const double pixelAspectRatio = intrinsicTree.get<double>("pixelRatio", 1.0);
+    const double fmm = desc.focalLength;
+    const double pixelAspectRatio = desc.pixelRatio;
 
     const double focalRatio = 1.0 / pixelAspectRatio;
     const double fx = (fmm / sensorWidth) * double(width);
@@ -260,13 +304,13 @@ void loadIntrinsic(const Version & version, IndexT& intrinsicId, std::shared_ptr
   // pinhole parameters
   intrinsic = camera::createIntrinsic(intrinsicType, width, height, pxFocalLength(0), pxFocalLength(1), principalPoint(0), principalPoint(1));  
   
-  intrinsic->setSerialNumber(intrinsicTree.get<std::string>("serialNumber"));
+  intrinsic->setSerialNumber(getRequired(desc.serialNumber, "serialNumber"));
   intrinsic->setInitializationMode(initializationMode);
   intrinsic->setSensorWidth(sensorWidth);
   intrinsic->setSensorHeight(sensorHeight);
 
   // intrinsic lock
-  if(intrinsicTree.get<bool>("locked", false)) {
+  if(desc.locked) {
     intrinsic->lock();
   }
   else {
@@ -279,20 +323,20 @@ void loadIntrinsic(const Version & version, IndexT& intrinsicId, std::shared_ptr
     if (version < Version(1, 2, 2))
     {
       Vec2 initialFocalLengthPx;
-      initialFocalLengthPx(0) = intrinsicTree.get<double>("pxInitialFocalLength");
+      initialFocalLengthPx(0) = getRequired(desc.pxInitialFocalLength, "pxInitialFocalLength");
       initialFocalLengthPx(1) = (initialFocalLengthPx(0) > 0)?initialFocalLengthPx(0) * pxFocalLength(1) / pxFocalLength(0):-1;
       intrinsicWithScale->setInitialScale(initialFocalLengthPx);
     }
     else 
     {
-      double initialFocalLengthMM = intrinsicTree.get<double>("initialFocalLength");
+      double initialFocalLengthMM = getRequired(desc.initialFocalLength, "initialFocalLength");
       
       Vec2 initialFocalLengthPx;
       initialFocalLengthPx(0) = (initialFocalLengthMM / sensorWidth) * double(width);
       initialFocalLengthPx(1) = (initialFocalLengthPx(0) > 0)?initialFocalLengthPx(0) * pxFocalLength(1) / pxFocalLength(0):-1;
 
       intrinsicWithScale->setInitialScale(initialFocalLengthPx);
-      intrinsicWithScale->setRatioLocked(intrinsicTree.get<bool>("pixelRatioLocked"));
+      intrinsicWithScale->setRatioLocked(getRequired(desc.pixelRatioLocked, "pixelRatioLocked"));
     }
   }
 
@@ -300,20 +344,14 @@ void loadIntrinsic(const Version & version, IndexT& intrinsicId, std::shared_ptr
   std::shared_ptr<camera::IntrinsicScaleOffsetDisto> intrinsicWithDistoEnabled = std::dynamic_pointer_cast<camera::IntrinsicScaleOffsetDisto>(intrinsic);
   if (intrinsicWithDistoEnabled != nullptr)
   {
-    const camera::EInitMode distortionInitializationMode =
-        camera::EInitMode_stringToEnum(
-            intrinsicTree.get<std::string>("distortionInitializationMode", camera::EInitMode_enumToString(camera::EInitMode::NONE)));
+    const camera::EInitMode distortionInitializationMode = camera::EInitMode_stringToEnum(desc.distortionInitializationMode);
 
     intrinsicWithDistoEnabled->setDistortionInitializationMode(distortionInitializationMode);
 
     std::shared_ptr<camera::Distortion> distortionObject = intrinsicWithDistoEnabled->getDistortion();
     if (distortionObject)
     {
-        std::vector<double> distortionParams;
-        for (bpt::ptree::value_type &paramNode : intrinsicTree.get_child("distortionParams"))
-        {
-            distortionParams.emplace_back(paramNode.second.get_value<double>());
-        }
+        const std::vector<double>& distortionParams = getRequired(desc.distortionParams, "distortionParams");
 
         // ensure that we have the right number of params
         if (distortionParams.size() == distortionObject->getParameters().size())
@@ -329,19 +367,13 @@ void loadIntrinsic(const Version & version, IndexT& intrinsicId, std::shared_ptr
     std::shared_ptr<camera::Undistortion> undistortionObject = intrinsicWithDistoEnabled->getUndistortion();
     if (undistortionObject)
     {
-        std::vector<double> undistortionParams;
-        for (bpt::ptree::value_type &paramNode : intrinsicTree.get_child("undistortionParams"))
-        {
-            undistortionParams.emplace_back(paramNode.second.get_value<double>());
-        }
+        const std::vector<double>& undistortionParams = getRequired(desc.undistortionParams, "undistortionParams");
 
         // ensure that we have the right number of params
         if (undistortionParams.size() == undistortionObject->getParameters().size())
         {
             undistortionObject->setParameters(undistortionParams);
-            Vec2 offset;
-            loadMatrix("undistortionOffset", offset, intrinsicTree);
-            undistortionObject->setOffset(offset);
+            undistortionObject->setOffset(getRequired(desc.undistortionOffset, "undistortionOffset"));
         }
         else
         {
@@ -354,10 +386,83 @@ void loadIntrinsic(const Version & version, IndexT& intrinsicId, std::shared_ptr
   std::shared_ptr<camera::Equidistant> intrinsicEquidistant = std::dynamic_pointer_cast<camera::Equidistant>(intrinsic);
   if (intrinsicEquidistant != nullptr)
   {
-    intrinsicEquidistant->setCircleCenterX(intrinsicTree.get<double>("fisheyeCircleCenterX", 0.0));
-    intrinsicEquidistant->setCircleCenterY(intrinsicTree.get<double>("fisheyeCircleCenterY", 0.0));
-    intrinsicEquidistant->setCircleRadius(intrinsicTree.get<double>("fisheyeCircleRadius", 1.0));
+    intrinsicEquidistant->setCircleCenterX(desc.fisheyeCircleCenterX);
+    intrinsicEquidistant->setCircleCenterY(desc.fisheyeCircleCenterY);
+    intrinsicEquidistant->setCircleRadius(desc.fisheyeCircleRadius);
+  }
+}
+
+template<typename T>
+void getOptional(const bpt::ptree& tree, const std::string& name, std::optional<T>& value)
+{
+  const boost::optional<T> treeValue = tree.get_optional<T>(name);
+  if(treeValue)
+    value = *treeValue;
+}
+
+void getOptionalVector(const bpt::ptree& tree, const std::string& name, std::optional<std::vector<double>>& values)
+{
+  const boost::optional<const bpt::ptree&> vectorTree = tree.get_child_optional(name);
+  if(!vectorTree)
+    return;
+
+  values.emplace();
+  for(const bpt::ptree::value_type& paramNode : *vectorTree)
+    values->emplace_back(paramNode.second.get_value<double>());
+}
+
+void getOptionalMatrix(bpt::ptree& tree, const std::string& name, std::optional<Vec2>& matrix)
+{
+  if(!tree.get_child_optional(name))
+    return;
+
+  Vec2 value;
+  loadMatrix(name, value, tree);
+  matrix = value;
+}
+
+} // namespace
+
+void loadIntrinsic(const Version & version, IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic,
+                   bpt::ptree& intrinsicTree)
+{
+  IntrinsicDesc desc;
+
+  getOptional(intrinsicTree, "intrinsicId", desc.intrinsicId);
+  getOptional(intrinsicTree, "width", desc.width);
+  getOptional(intrinsicTree, "height", desc.height);
+  desc.sensorWidth = intrinsicTree.get<double>("sensorWidth", desc.sensorWidth);
+  desc.sensorHeight = intrinsicTree.get<double>("sensorHeight", desc.sensorHeight);
+  getOptional(intrinsicTree, "serialNumber", desc.serialNumber);
+  getOptional(intrinsicTree, "type", desc.type);
+  desc.initializationMode = intrinsicTree.get<std::string>("initializationMode", desc.initializationMode);
+  getOptionalMatrix(intrinsicTree, "principalPoint", desc.principalPoint);
+
+  if (version < Version(1,2,0))
+  {
+    const double pxFocalLength = intrinsicTree.get<double>("pxFocalLength", -1);
+    desc.pxFocalLength = Vec2(pxFocalLength, pxFocalLength);
   }
+  else
+  {
+    getOptionalMatrix(intrinsicTree, "pxFocalLength", desc.pxFocalLength);
+  }
+
+  desc.focalLength = intrinsicTree.get<double>("focalLength", desc.focalLength);
+  desc.pixelRatio = intrinsicTree.get<double>("pixelRatio", desc.pixelRatio);
+  getOptional(intrinsicTree, "pxInitialFocalLength", desc.pxInitialFocalLength);
+  getOptional(intrinsicTree, "initialFocalLength", desc.initialFocalLength);
+  getOptional(intrinsicTree, "pixelRatioLocked", desc.pixelRatioLocked);
+  desc.distortionInitializationMode = intrinsicTree.get<std::string>("distortionInitializationMode", desc.distortionInitializationMode);
+  getOptionalVector(intrinsicTree, "distortionParams", desc.distortionParams);
+  getOptionalMatrix(intrinsicTree, "undistortionOffset", desc.undistortionOffset);
+  getOptionalVector(intrinsicTree, "undistortionParams", desc.undistortionParams);
+  desc.fisheyeCircleCenterX = intrinsicTree.get<double>("fisheyeCircleCenterX", desc.fisheyeCircleCenterX);
+  desc.fisheyeCircleCenterY = intrinsicTree.get<double>("fisheyeCircleCenterY", desc.fisheyeCircleCenterY);
+  desc.fisheyeCircleRadius = intrinsicTree.get<double>("fisheyeCircleRadius", desc.fisheyeCircleRadius);
+  desc.locked = intrinsicTree.get<bool>("locked", desc.locked);
+
+  createIntrinsicFromDesc(version, desc, intrinsicId, intrinsic);
 }
 
 void saveRig(const std::string& name, IndexT rigId, const sfmData::Rig& rig, bpt::ptree& parentTree)
@@ -472,121 +577,634 @@ void loadLandmark(IndexT& landmarkId, sfmData::Landmark& landmark, bpt::ptree& l
 }
 
 
-bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+namespace {
+
+/// range of a JSON value in the document
+using JsonRange = std::pair<const char*, const char*>;
+
+void writeView(JsonWriter& writer, const sfmData::View& view)
 {
-  const Vec3i version = {ALICEVISION_SFMDATAIO_VERSION_MAJOR, ALICEVISION_SFMDATAIO_VERSION_MINOR, ALICEVISION_SFMDATAIO_VERSION_REVISION};
+  writer.beginObject();
 
-  // save flags
-  const bool saveViews = (partFlag & VIEWS) == VIEWS;
-  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
-  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
-  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
-  const bool saveFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
-  const bool saveObservations = saveFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
+  if(view.getViewId() != UndefinedIndexT)
+    writer.key("viewId").value(view.getViewId());
 
-  // main tree
-  bpt::ptree fileTree;
+  if(view.getPoseId() != UndefinedIndexT)
+    writer.key("poseId").value(view.getPoseId());
 
-  // file version
-  saveMatrix("version", version, fileTree);
+  if(view.isPartOfRig())
+  {
+    writer.key("rigId").value(view.getRigId());
+    writer.key("subPoseId").value(view.getSubPoseId());
+  }
 
-  // folders
-  if(!sfmData.getRelativeFeaturesFolders().empty())
+  if(view.getFrameId() != UndefinedIndexT)
+    writer.key("frameId").value(view.getFrameId());
+
+  if(view.getIntrinsicId() != UndefinedIndexT)
+    writer.key("intrinsicId").value(view.getIntrinsicId());
+
+  if(view.getResectionId() != UndefinedIndexT)
+    writer.key("resectionId").value(view.getResectionId());
+
+  if(view.isPoseIndependant() == false)
+    writer.key("isPoseIndependant").value(view.isPoseIndependant());
+
+  writer.key("path").value(view.getImage().getImagePath());
+  writer.key("width").value(view.getImage().getWidth());
+  writer.key("height").value(view.getImage().getHeight());
+
+  // metadata
+  writer.key("metadata").beginObject();
+  for(const auto& metadataPair : view.getImage().getMetadata())
+    writer.key(metadataPair.first).value(metadataPair.second);
+  writer.endObject();
+
+  // ancestors
+  if(!view.getAncestors().empty())
   {
-    bpt::ptree featureFoldersTree;
+    writer.key("ancestors").beginArray();
+    for(const IndexT ancestor : view.getAncestors())
+      writer.value(ancestor);
+    writer.endArray();
+  }
+
+  writer.endObject();
+}
 
-    for(const std::string& featuresFolder : sfmData.getRelativeFeaturesFolders())
+void readView(JsonReader& reader, sfmData::View& view)
+{
+  IndexT rigId = UndefinedIndexT;
+  std::optional<IndexT> subPoseId;
+  std::optional<std::string> path;
+
+  view.setViewId(UndefinedIndexT);
+  view.setPoseId(UndefinedIndexT);
+  view.setFrameId(UndefinedIndexT);
+  view.setIntrinsicId(UndefinedIndexT);
+  view.setResectionId(UndefinedIndexT);
+  view.setIndependantPose(true);
+
+  std::string_view key;
+  reader.beginObject();
+  while(reader.nextKey(key))
+  {
+    if(key == "viewId")
+      view.setViewId(reader.readInteger<IndexT>());
+    else if(key == "poseId")
+      view.setPoseId(reader.readInteger<IndexT>());
+    else if(key == "rigId")
+      rigId = reader.readInteger<IndexT>();
+    else if(key == "subPoseId")
+      subPoseId = reader.readInteger<IndexT>();
+    else if(key == "frameId")
+      view.setFrameId(reader.readInteger<IndexT>());
+    else if(key == "intrinsicId")
+      view.setIntrinsicId(reader.readInteger<IndexT>());
+    else if(key == "resectionId")
+      view.setResectionId(reader.readInteger<IndexT>());
+    else if(key == "isPoseIndependant")
+      view.setIndependantPose(reader.readBool());
+    else if(key == "path")
+      path = reader.readString();
+    else if(key == "width")
+      view.getImage().setWidth(reader.readInteger<std::size_t>());
+    else if(key == "height")
+      view.getImage().setHeight(reader.readInteger<std::size_t>());
+    else if(key == "ancestors")
     {
-      bpt::ptree featureFolderTree;
-      featureFolderTree.put("", featuresFolder);
-      featureFoldersTree.push_back(std::make_pair("", featureFolderTree));
+      reader.beginArray();
+      while(reader.nextElement())
+        view.addAncestor(reader.readInteger<IndexT>());
     }
+    else if(key == "metadata")
+    {
+      std::string_view metadataKey;
+      reader.beginObject();
+      while(reader.nextKey(metadataKey))
+      {
+        const std::string metadataName(metadataKey);
+        view.getImage().addMetadata(metadataName, reader.readString());
+      }
+    }
+    else
+      reader.skipValue();
+  }
+
+  if(!path)
+    reader.error("the view path is missing");
 
-    fileTree.add_child("featuresFolders", featureFoldersTree);
+  view.getImage().setImagePath(*path);
+
+  if(rigId != UndefinedIndexT)
+  {
+    if(!subPoseId)
+      reader.error("the view sub-pose id is missing");
+    view.setRigAndSubPoseId(rigId, *subPoseId);
   }
+}
+
+void writeIntrinsic(JsonWriter& writer, IndexT intrinsicId, const std::shared_ptr<camera::IntrinsicBase>& intrinsic)
+{
+  writer.beginObject();
 
-  if(!sfmData.getRelativeMatchesFolders().empty())
+  writer.key("intrinsicId").value(intrinsicId);
+  writer.key("width").value(intrinsic->w());
+  writer.key("height").value(intrinsic->h());
+  writer.key("sensorWidth").value(intrinsic->sensorWidth());
+  writer.key("sensorHeight").value(intrinsic->sensorHeight());
+  writer.key("serialNumber").value(intrinsic->serialNumber());
+  writer.key("type").value(camera::EINTRINSIC_enumToString(intrinsic->getType()));
+  writer.key("initializationMode").value(camera::EInitMode_enumToString(intrinsic->getInitializationMode()));
+
+  std::shared_ptr<camera::IntrinsicScaleOffset> intrinsicScaleOffset = std::dynamic_pointer_cast<camera::IntrinsicScaleOffset>(intrinsic);
+  if(intrinsicScaleOffset)
   {
-    bpt::ptree matchingFoldersTree;
+    const double initialFocalLengthMM = (intrinsicScaleOffset->getInitialScale().x() > 0) ? intrinsicScaleOffset->sensorWidth() * intrinsicScaleOffset->getInitialScale().x() / double(intrinsic->w()): -1;
+    const double focalLengthMM = intrinsicScaleOffset->sensorWidth() * intrinsicScaleOffset->getScale().x() / double(intrinsic->w());
+    const double focalRatio = intrinsicScaleOffset->getScale().x() / intrinsicScaleOffset->getScale().y();
+    const double pixelAspectRatio = 1.0 / focalRatio;
+
+    writer.key("initialFocalLength").value(initialFocalLengthMM);
+    writer.key("focalLength").value(focalLengthMM);
+    writer.key("pixelRatio").value(pixelAspectRatio);
+    writer.key("pixelRatioLocked").value(intrinsicScaleOffset->isRatioLocked());
+    writer.key("principalPoint").matrix(intrinsicScaleOffset->getOffset());
+  }
+
+  std::shared_ptr<camera::IntrinsicScaleOffsetDisto> intrinsicScaleOffsetDisto = std::dynamic_pointer_cast<camera::IntrinsicScaleOffsetDisto>(intrinsic);
+  if(intrinsicScaleOffsetDisto)
+  {
+    std::shared_ptr<camera::Distortion> distortionObject = intrinsicScaleOffsetDisto->getDistortion();
+    std::shared_ptr<camera::Undistortion> undistortionObject = intrinsicScaleOffsetDisto->getUndistortion();
 
-    for(const std::string& matchesFolder : sfmData.getRelativeMatchesFolders())
+    writer.key("distortionInitializationMode").value(camera::EInitMode_enumToString(intrinsicScaleOffsetDisto->getDistortionInitializationMode()));
+    writer.key("distortionParams").array(distortionObject ? distortionObject->getParameters() : std::vector<double>());
+    writer.key("undistortionOffset").matrix(undistortionObject ? undistortionObject->getOffset() : Vec2(0.0, 0.0));
+    writer.key("undistortionParams").array(undistortionObject ? undistortionObject->getParameters() : std::vector<double>());
+  }
+
+  std::shared_ptr<camera::Equidistant> intrinsicEquidistant = std::dynamic_pointer_cast<camera::Equidistant>(intrinsic);
+  if(intrinsicEquidistant)
+  {
+    writer.key("fisheyeCircleCenterX").value(intrinsicEquidistant->getCircleCenterX());
+    writer.key("fisheyeCircleCenterY").value(intrinsicEquidistant->getCircleCenterY());
+    writer.key("fisheyeCircleRadius").value(intrinsicEquidistant->getCircleRadius());
+  }
+
+  writer.key("locked").value(intrinsic->isLocked());
+
+  writer.endObject();
+}
+
+void readIntrinsic(JsonReader& reader, const Version& version, IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic)
+{
+  IntrinsicDesc desc;
+
+  const auto readVec2 = [&reader]() {
+    Vec2 value;
+    reader.readMatrix(value);
+    return value;
+  };
+
+  std::string_view key;
+  reader.beginObject();
+  while(reader.nextKey(key))
+  {
+    if(key == "intrinsicId")
+      desc.intrinsicId = reader.readInteger<IndexT>();
+    else if(key == "width")
+      desc.width = reader.readInteger<unsigned int>();
+    else if(key == "height")
+      desc.height = reader.readInteger<unsigned int>();
+    else if(key == "sensorWidth")
+      desc.sensorWidth = reader.readDouble();
+    else if(key == "sensorHeight")
+      desc.sensorHeight = reader.readDouble();
+    else if(key == "serialNumber")
+      desc.serialNumber = reader.readString();
+    else if(key == "type")
+      desc.type = reader.readString();
+    else if(key == "initializationMode")
+      desc.initializationMode = reader.readString();
+    else if(key == "principalPoint")
+      desc.principalPoint = readVec2();
+    else if(key == "pxFocalLength")
     {
-      bpt::ptree matchingFolderTree;
-      matchingFolderTree.put("", matchesFolder);
-      matchingFoldersTree.push_back(std::make_pair("", matchingFolderTree));
+      if(version < Version(1,2,0))
+      {
+        const double pxFocalLength = reader.readDouble();
+        desc.pxFocalLength = Vec2(pxFocalLength, pxFocalLength);
+      }
+      else
+        desc.pxFocalLength = readVec2();
     }
-
-    fileTree.add_child("matchesFolders", matchingFoldersTree);
+    else if(key == "focalLength")
+      desc.focalLength = reader.readDouble();
+    else if(key == "pixelRatio")
+      desc.pixelRatio = reader.readDouble();
+    else if(key == "pxInitialFocalLength")
+      desc.pxInitialFocalLength = reader.readDouble();
+    else if(key == "initialFocalLength")
+      desc.initialFocalLength = reader.readDouble();
+    else if(key == "pixelRatioLocked")
+      desc.pixelRatioLocked = reader.readBool();
+    else if(key == "distortionInitializationMode")
+      desc.distortionInitializationMode = reader.readString();
+    else if(key == "distortionParams")
+      desc.distortionParams = reader.readDoubleArray();
+    else if(key == "undistortionOffset")
+      desc.undistortionOffset = readVec2();
+    else if(key == "undistortionParams")
+      desc.undistortionParams = reader.readDoubleArray();
+    else if(key == "fisheyeCircleCenterX")
+      desc.fisheyeCircleCenterX = reader.readDouble();
+    else if(key == "fisheyeCircleCenterY")
+      desc.fisheyeCircleCenterY = reader.readDouble();
+    else if(key == "fisheyeCircleRadius")
+      desc.fisheyeCircleRadius = reader.readDouble();
+    else if(key == "locked")
+      desc.locked = reader.readBool();
+    else
+      reader.skipValue();
   }
 
-  // views
-  if(saveViews && !sfmData.getViews().empty())
+  // before version 1.2, a missing pxFocalLength is -1
+  if(version < Version(1,2,0) && !desc.pxFocalLength)
+    desc.pxFocalLength = Vec2(-1.0, -1.0);
+
+  createIntrinsicFromDesc(version, desc, intrinsicId, intrinsic);
+}
+
+void writePose3(JsonWriter& writer, const geometry::Pose3& pose)
+{
+  writer.beginObject();
+  writer.key("rotation").matrix(pose.rotation());
+  writer.key("center").matrix(pose.center());
+  writer.endObject();
+}
+
+void readPose3(JsonReader& reader, geometry::Pose3& pose)
+{
+  Mat3 rotation;
+  Vec3 center;
+  bool hasRotation = false;
+  bool hasCenter = false;
+
+  std::string_view key;
+  reader.beginObject();
+  while(reader.nextKey(key))
   {
-    bpt::ptree viewsTree;
+    if(key == "rotation")
+    {
+      reader.readMatrix(rotation);
+      hasRotation = true;
+    }
+    else if(key == "center")
+    {
+      reader.readMatrix(center);
+      hasCenter = true;
+    }
+    else
+      reader.skipValue();
+  }
 
-    for(const auto& viewPair : sfmData.getViews())
-      saveView("", *(viewPair.second), viewsTree);
+  if(!hasRotation || !hasCenter)
+    reader.error("invalid pose");
 
-    fileTree.add_child("views", viewsTree);
+  pose = geometry::Pose3(rotation, center);
+}
+
+void writeCameraPose(JsonWriter& writer, IndexT poseId, const sfmData::CameraPose& cameraPose)
+{
+  writer.beginObject();
+  writer.key("poseId").value(poseId);
+  writer.key("pose").beginObject();
+  writer.key("transform");
+  writePose3(writer, cameraPose.getTransform());
+  writer.key("locked").value(static_cast<int>(cameraPose.isLocked())); // convert bool to integer to avoid using "true/false" in exported file instead of "1/0".
+  writer.endObject();
+  writer.endObject();
+}
+
+void readCameraPose(JsonReader& reader, IndexT& poseId, sfmData::CameraPose& cameraPose)
+{
+  std::optional<IndexT> id;
+  geometry::Pose3 transform;
+  bool locked = false;
+
+  std::string_view key;
+  reader.beginObject();
+  while(reader.nextKey(key))
+  {
+    if(key == "poseId")
+      id = reader.readInteger<IndexT>();
+    else if(key == "pose")
+    {
+      std::string_view poseKey;
+      reader.beginObject();
+      while(reader.nextKey(poseKey))
+      {
+        if(poseKey == "transform")
+          readPose3(reader, transform);
+        else if(poseKey == "locked")
+          locked = reader.readBool();
+        else
+          reader.skipValue();
+      }
+    }
+    else
+      reader.skipValue();
   }
 
-  // intrinsics
-  if(saveIntrinsics && !sfmData.getIntrinsics().empty())
+  if(!id)
+    reader.error("the pose id is missing");
+
+  poseId = *id;
+  cameraPose.setTransform(transform);
+
+  if(locked)
+    cameraPose.lock();
+  else
+    cameraPose.unlock();
+}
+
+void writeRig(JsonWriter& writer, IndexT rigId, const sfmData::Rig& rig)
+{
+  writer.beginObject();
+  writer.key("rigId").value(rigId);
+  writer.key("subPoses").beginArray();
+
+  for(const auto& rigSubPose : rig.getSubPoses())
   {
-    bpt::ptree intrinsicsTree;
+    writer.beginObject();
+    writer.key("status").value(sfmData::ERigSubPoseStatus_enumToString(rigSubPose.status));
+    writer.key("pose");
+    writePose3(writer, rigSubPose.pose);
+    writer.endObject();
+  }
 
-    for(const auto& intrinsicPair : sfmData.getIntrinsics())
-      saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
+  writer.endArray();
+  writer.endObject();
+}
+
+void readRig(JsonReader& reader, IndexT& rigId, sfmData::Rig& rig)
+{
+  std::optional<IndexT> id;
+  std::vector<sfmData::RigSubPose> subPoses;
 
-    fileTree.add_child("intrinsics", intrinsicsTree);
+  std::string_view key;
+  reader.beginObject();
+  while(reader.nextKey(key))
+  {
+    if(key == "rigId")
+      id = reader.readInteger<IndexT>();
+    else if(key == "subPoses")
+    {
+      reader.beginArray();
+      while(reader.nextElement())
+      {
+        sfmData::RigSubPose subPose;
+        std::string_view subPoseKey;
+        reader.beginObject();
+        while(reader.nextKey(subPoseKey))
+        {
+          if(subPoseKey == "status")
+            subPose.status = sfmData::ERigSubPoseStatus_stringToEnum(reader.readString());
+          else if(subPoseKey == "pose")
+            readPose3(reader, subPose.pose);
+          else
+            reader.skipValue();
+        }
+        subPoses.push_back(subPose);
+      }
+    }
+    else
+      reader.skipValue();
   }
 
-  //extrinsics
-  if(saveExtrinsics)
+  if(!id)
+    reader.error("the rig id is missing");
+
+  rigId = *id;
+  rig = sfmData::Rig(subPoses.size());
+  for(std::size_t subPoseId = 0; subPoseId < subPoses.size(); ++subPoseId)
+    rig.setSubPose(subPoseId, subPoses.at(subPoseId));
+}
+
+void writeLandmark(JsonWriter& writer, IndexT landmarkId, const sfmData::Landmark& landmark, bool saveObservations, bool saveFeatures)
+{
+  writer.beginObject();
+
+  writer.key("landmarkId").value(landmarkId);
+  writer.key("descType").value(feature::EImageDescriberType_enumToString(landmark.descType));
+  writer.key("color").matrix(landmark.rgb);
+  writer.key("X").matrix(landmark.X);
+
+  // observations
+  if(saveObservations)
   {
-    // poses
-    if(!sfmData.getPoses().empty())
+    writer.key("observations").beginArray();
+    for(const auto& obsPair : landmark.observations)
     {
-      bpt::ptree posesTree;
+      const sfmData::Observation& observation = obsPair.second;
 
-      for(const auto& posePair : sfmData.getPoses())
-      {
-        bpt::ptree poseTree;
+      writer.beginObject();
+      writer.key("observationId").value(obsPair.first);
 
-        poseTree.put("poseId", posePair.first);
-        saveCameraPose("pose", posePair.second, poseTree);
-        posesTree.push_back(std::make_pair("", poseTree));
+      // features
+      if(saveFeatures)
+      {
+        writer.key("featureId").value(observation.id_feat);
+        writer.key("x").matrix(observation.x);
+        writer.key("scale").value(observation.scale);
       }
 
-      fileTree.add_child("poses", posesTree);
+      writer.endObject();
     }
+    writer.endArray();
+  }
 
-    // rigs
-    if(!sfmData.getRigs().empty())
+  writer.endObject();
+}
+
+void readLandmark(JsonReader& reader, IndexT& landmarkId, sfmData::Landmark& landmark, bool loadObservations, bool loadFeatures)
+{
+  std::optional<IndexT> id;
+
+  std::string_view key;
+  reader.beginObject();
+  while(reader.nextKey(key))
+  {
+    if(key == "landmarkId")
+      id = reader.readInteger<IndexT>();
+    else if(key == "descType")
+      landmark.descType = feature::EImageDescriberType_stringToEnum(reader.readString());
+    else if(key == "color")
+      reader.readMatrix(landmark.rgb);
+    else if(key == "X")
+      reader.readMatrix(landmark.X);
+    else if(key == "observations" && loadObservations)
     {
-      bpt::ptree rigsTree;
+      reader.beginArray();
+      while(reader.nextElement())
+      {
+        std::optional<IndexT> observationId;
+        sfmData::Observation observation;
 
-      for(const auto& rigPair : sfmData.getRigs())
-        saveRig("", rigPair.first, rigPair.second, rigsTree);
+        std::string_view observationKey;
+        reader.beginObject();
+        while(reader.nextKey(observationKey))
+        {
+          if(observationKey == "observationId")
+            observationId = reader.readInteger<IndexT>();
+          else if(loadFeatures && observationKey == "featureId")
+            observation.id_feat = reader.readInteger<IndexT>();
+          else if(loadFeatures && observationKey == "x")
+            reader.readMatrix(observation.x);
+          else if(loadFeatures && observationKey == "scale")
+            observation.scale = reader.readDouble();
+          else
+            reader.skipValue();
+        }
+
+        if(!observationId)
+          reader.error("the observation id is missing");
 
-      fileTree.add_child("rigs", rigsTree);
+        // observations are saved sorted by view id
+        landmark.observations.emplace_hint(landmark.observations.end(), *observationId, observation);
+      }
     }
+    else
+      reader.skipValue();
   }
 
-  // structure
-  if(saveStructure && !sfmData.getLandmarks().empty())
-  {
-    bpt::ptree structureTree;
+  if(!id)
+    reader.error("the landmark id is missing");
+
+  landmarkId = *id;
+}
 
-    for(const auto& structurePair : sfmData.getLandmarks())
-      saveLandmark("", structurePair.first, structurePair.second, structureTree, saveObservations, saveFeatures);
+/**
+ * @brief Parse the elements of a JSON array in parallel.
+ * @param[in] ranges The element ranges
+ * @param[out] out_elements The parsed elements, in the same order
+ * @param[in] parseElement The element parsing function
+ */
+template<typename T, typename ParseFunc>
+void parseElements(const std::vector<JsonRange>& ranges, std::vector<T>& out_elements, ParseFunc parseElement)
+{
+  out_elements.resize(ranges.size());
+  std::string errorMessage;
 
-    fileTree.add_child("structure", structureTree);
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(ranges.size()); ++i)
+  {
+    try
+    {
+      JsonReader reader(ranges.at(i));
+      parseElement(reader, out_elements.at(i));
+    }
+    catch(const std::exception& e)
+    {
+      #pragma omp critical
+      errorMessage = e.what();
+    }
   }
 
-  // write the json file with the tree
+  if(!errorMessage.empty())
+    throw std::runtime_error(errorMessage);
+}
+
+} // namespace
+
+bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  const Vec3i version = {ALICEVISION_SFMDATAIO_VERSION_MAJOR, ALICEVISION_SFMDATAIO_VERSION_MINOR, ALICEVISION_SFMDATAIO_VERSION_REVISION};
+
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
+  const bool saveObservations = saveFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
+
+  std::ofstream file(filename);
+
+  if(!file.is_open())
+    throw std::runtime_error("Can't save JSON SfMData file, can't open '" + filename + "'!");
+
+  // the file is written directly, without an intermediate tree
+  {
+    JsonWriter writer(file);
+
+    writer.beginObject();
+
+    // file version
+    writer.key("version").matrix(version);
+
+    // folders
+    if(!sfmData.getRelativeFeaturesFolders().empty())
+      writer.key("featuresFolders").array(sfmData.getRelativeFeaturesFolders());
 
-  bpt::write_json(filename, fileTree);
+    if(!sfmData.getRelativeMatchesFolders().empty())
+      writer.key("matchesFolders").array(sfmData.getRelativeMatchesFolders());
+
+    // views
+    if(saveViews && !sfmData.getViews().empty())
+    {
+      writer.key("views").beginArray();
+      for(const auto& viewPair : sfmData.getViews())
+        writeView(writer, *(viewPair.second));
+      writer.endArray();
+    }
+
+    // intrinsics
+    if(saveIntrinsics && !sfmData.getIntrinsics().empty())
+    {
+      writer.key("intrinsics").beginArray();
+      for(const auto& intrinsicPair : sfmData.getIntrinsics())
+        writeIntrinsic(writer, intrinsicPair.first, intrinsicPair.second);
+      writer.endArray();
+    }
+
+    // extrinsics
+    if(saveExtrinsics)
+    {
+      // poses
+      if(!sfmData.getPoses().empty())
+      {
+        writer.key("poses").beginArray();
+        for(const auto& posePair : sfmData.getPoses())
+          writeCameraPose(writer, posePair.first, posePair.second);
+        writer.endArray();
+      }
+
+      // rigs
+      if(!sfmData.getRigs().empty())
+      {
+        writer.key("rigs").beginArray();
+        for(const auto& rigPair : sfmData.getRigs())
+          writeRig(writer, rigPair.first, rigPair.second);
+        writer.endArray();
+      }
+    }
+
+    // structure
+    if(saveStructure && !sfmData.getLandmarks().empty())
+    {
+      writer.key("structure").beginArray();
+      for(const auto& structurePair : sfmData.getLandmarks())
+        writeLandmark(writer, structurePair.first, structurePair.second, saveObservations, saveFeatures);
+      writer.endArray();
+    }
+
+    writer.endObject();
+  }
+
+  if(!file.good())
+    throw std::runtime_error("Can't save JSON SfMData file, '" + filename + "' is incorrect!");
 
   return true;
 }
@@ -594,8 +1212,6 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
 bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews,
               EViewIdMethod viewIdMethod, const std::string& viewIdRegex)
 {
-  Version version;
-
   // load flags
   const bool loadViews = (partFlag & VIEWS) == VIEWS;
   const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
@@ -604,65 +1220,118 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
   const bool loadFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
   const bool loadObservations = loadFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
 
-  // main tree
-  bpt::ptree fileTree;
+  // read the whole document, no tree is built
+  std::string document;
+  {
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+    if(!file.is_open())
+      throw std::runtime_error("Can't load JSON SfMData file, can't open '" + filename + "'!");
 
-  // read the json file and initialize the tree
-  bpt::read_json(filename, fileTree);
+    file.seekg(0, std::ios::end);
+    document.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    file.read(&document[0], static_cast<std::streamsize>(document.size()));
 
-  // version
-  {
-    Vec3i v;
-    loadMatrix("version", v, fileTree);
-    version = v;
+    if(!file)
+      throw std::runtime_error("Can't load JSON SfMData file, can't read '" + filename + "'!");
   }
 
-  // folders
-  if(fileTree.count("featuresFolders"))
-    for(bpt::ptree::value_type& featureFolderNode : fileTree.get_child("featuresFolders"))
-      sfmData.addFeaturesFolder(featureFolderNode.second.get_value<std::string>());
+  // first pass: get the range of the needed sections, the others are only skipped
+  std::optional<JsonRange> versionRange, featuresFoldersRange, matchesFoldersRange, viewsRange, intrinsicsRange, posesRange, rigsRange, structureRange;
 
-  if(fileTree.count("matchesFolders"))
-    for(bpt::ptree::value_type& matchingFolderNode : fileTree.get_child("matchesFolders"))
-      sfmData.addMatchesFolder(matchingFolderNode.second.get_value<std::string>());
-
-  // intrinsics
-  if(loadIntrinsics && fileTree.count("intrinsics"))
+  try
   {
-    sfmData::Intrinsics& intrinsics = sfmData.getIntrinsics();
+    JsonReader reader(document.data(), document.data() + document.size());
+    std::string_view key;
 
-    for(bpt::ptree::value_type &intrinsicNode : fileTree.get_child("intrinsics"))
+    reader.beginObject();
+    while(reader.nextKey(key))
     {
-      IndexT intrinsicId;
-      std::shared_ptr<camera::IntrinsicBase> intrinsic;
+      if(key == "version")
+        versionRange = reader.skipValueRange();
+      else if(key == "featuresFolders")
+        featuresFoldersRange = reader.skipValueRange();
+      else if(key == "matchesFolders")
+        matchesFoldersRange = reader.skipValueRange();
+      else if(key == "views" && loadViews)
+        viewsRange = reader.skipValueRange();
+      else if(key == "intrinsics" && loadIntrinsics)
+        intrinsicsRange = reader.skipValueRange();
+      else if(key == "poses" && loadExtrinsics)
+        posesRange = reader.skipValueRange();
+      else if(key == "rigs" && loadExtrinsics)
+        rigsRange = reader.skipValueRange();
+      else if(key == "structure" && loadStructure)
+        structureRange = reader.skipValueRange();
+      else
+        reader.skipValue();
+    }
 
-      loadIntrinsic(version, intrinsicId, intrinsic, intrinsicNode.second);
+    // version
+    if(!versionRange)
+      throw std::runtime_error("the file version is missing.");
 
-      intrinsics.emplace(intrinsicId, intrinsic);
+    Version version;
+    {
+      Vec3i v;
+      JsonReader(*versionRange).readMatrix(v);
+      version = v;
     }
-  }
 
-  // views
-  if(loadViews && fileTree.count("views"))
-  {
-    sfmData::Views& views = sfmData.getViews();
+    // folders
+    if(featuresFoldersRange)
+    {
+      JsonReader foldersReader(*featuresFoldersRange);
+      foldersReader.beginArray();
+      while(foldersReader.nextElement())
+        sfmData.addFeaturesFolder(foldersReader.readString());
+    }
 
-    if(incompleteViews)
+    if(matchesFoldersRange)
     {
-      auto children = fileTree.get_child("views");
-    // update incomplete views
-      #pragma omp parallel for
-      for(int index = 0; index < children.size(); index++)
+      JsonReader foldersReader(*matchesFoldersRange);
+      foldersReader.beginArray();
+      while(foldersReader.nextElement())
+        sfmData.addMatchesFolder(foldersReader.readString());
+    }
+
+    // intrinsics
+    if(intrinsicsRange)
+    {
+      sfmData::Intrinsics& intrinsics = sfmData.getIntrinsics();
+
+      JsonReader intrinsicsReader(*intrinsicsRange);
+      intrinsicsReader.beginArray();
+      while(intrinsicsReader.nextElement())
       {
-        auto it = children.begin();
-        std::advance(it, index);
+        IndexT intrinsicId;
+        std::shared_ptr<camera::IntrinsicBase> intrinsic;
+
+        readIntrinsic(intrinsicsReader, version, intrinsicId, intrinsic);
+
+        intrinsics.emplace(intrinsicId, intrinsic);
+      }
+    }
+
+    // views, parsed in parallel
+    if(viewsRange)
+    {
+      std::vector<JsonRange> viewRanges;
+      JsonReader(*viewsRange).skipArrayRanges(viewRanges);
+
+      std::vector<std::shared_ptr<sfmData::View>> views;
+
+      parseElements(viewRanges, views, [&](JsonReader& viewReader, std::shared_ptr<sfmData::View>& view) {
+        view = std::make_shared<sfmData::View>();
+        readView(viewReader, *view);
 
-        auto view = std::make_shared<sfmData::View>();
-        loadView(*view, it->second);
+        if(!incompleteViews)
+          return;
 
         // if we have the intrinsics and the view has an valid associated intrinsics
         // update the width and height field of View (they are mirrored)
-        if (loadIntrinsics && view->getIntrinsicId() != UndefinedIndexT)
+        if(loadIntrinsics && view->getIntrinsicId() != UndefinedIndexT)
         {
           const auto intrinsics = sfmData.getIntrinsicPtr(view->getIntrinsicId());
 
@@ -678,76 +1347,70 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
           view->getImage().setHeight(intrinsics->h());
         }
         updateIncompleteView(*view, viewIdMethod, viewIdRegex);
+      });
 
-        #pragma omp critical
-        {
-            views.emplace(view->getViewId(), view);
-        }
-      }
+      // store in the SfMData views map in the file order
+      for(std::shared_ptr<sfmData::View>& view : views)
+        sfmData.getViews().emplace(view->getViewId(), std::move(view));
     }
-    else
-    {
-      // store directly in the SfMData views map
-      for(bpt::ptree::value_type &viewNode : fileTree.get_child("views"))
-      {
-        auto view = std::make_shared<sfmData::View>();
-        loadView(*view, viewNode.second);
-        views.emplace(view->getViewId(), view);
-      }
-    }
-  }
 
-  // extrinsics
-  if(loadExtrinsics)
-  {
-    // poses
-    if(fileTree.count("poses"))
+    // extrinsics
+    if(posesRange)
     {
       sfmData::Poses& poses = sfmData.getPoses();
 
-      for(bpt::ptree::value_type &poseNode : fileTree.get_child("poses"))
+      JsonReader posesReader(*posesRange);
+      posesReader.beginArray();
+      while(posesReader.nextElement())
       {
-        bpt::ptree& poseTree = poseNode.second;
+        IndexT poseId;
         sfmData::CameraPose pose;
 
-        loadCameraPose("pose", pose, poseTree);
+        readCameraPose(posesReader, poseId, pose);
 
-        poses.emplace(poseTree.get<IndexT>("poseId"), pose);
+        poses.emplace(poseId, pose);
       }
     }
 
-    // rigs
-    if(fileTree.count("rigs"))
+    if(rigsRange)
     {
       sfmData::Rigs& rigs = sfmData.getRigs();
 
-      for(bpt::ptree::value_type &rigNode : fileTree.get_child("rigs"))
+      JsonReader rigsReader(*rigsRange);
+      rigsReader.beginArray();
+      while(rigsReader.nextElement())
       {
         IndexT rigId;
         sfmData::Rig rig;
 
-        loadRig(rigId, rig, rigNode.second);
+        readRig(rigsReader, rigId, rig);
 
         rigs.emplace(rigId, rig);
       }
     }
-  }
-
-  // structure
-  if(loadStructure && fileTree.count("structure"))
-  {
-    sfmData::Landmarks& structure = sfmData.getLandmarks();
 
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("structure"))
+    // structure, parsed in parallel
+    if(structureRange)
     {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
+      std::vector<JsonRange> landmarkRanges;
+      JsonReader(*structureRange).skipArrayRanges(landmarkRanges);
 
-      loadLandmark(landmarkId, landmark, landmarkNode.second, loadObservations, loadFeatures);
+      std::vector<std::pair<IndexT, sfmData::Landmark>> landmarks;
 
-      structure.emplace(landmarkId, landmark);
+      parseElements(landmarkRanges, landmarks, [&](JsonReader& landmarkReader, std::pair<IndexT, sfmData::Landmark>& landmark) {
+        readLandmark(landmarkReader, landmark.first, landmark.second, loadObservations, loadFeatures);
+      });
+
+      sfmData::Landmarks& structure = sfmData.getLandmarks();
+
+      for(std::pair<IndexT, sfmData::Landmark>& landmark : landmarks)
+        structure.emplace(landmark.first, std::move(landmark.second));
     }
   }
+  catch(const std::runtime_error& e)
+  {
+    throw std::runtime_error("Can't load JSON SfMData file '" + filename + "': " + e.what());
+  }
 
   return true;
 }
@@ -0,0 +1,599 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "jsonStream.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace {
+
+/// buffered output size before writing to the stream
+constexpr std::size_t jsonWriterBufferSize = 1 << 20;
+
+inline bool isWhitespace(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isDelimiter(char c)
+{
+  return c == ',' || c == '}' || c == ']' || c == ':' || isWhitespace(c);
+}
+
+inline void appendUtf8(std::string& out, std::uint32_t codePoint)
+{
+  if(codePoint < 0x80)
+  {
+    out.push_back(static_cast<char>(codePoint));
+  }
+  else if(codePoint < 0x800)
+  {
+    out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+    out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  }
+  else if(codePoint < 0x10000)
+  {
+    out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  }
+  else
+  {
+    out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  }
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(std::ostream& stream)
+  : _stream(stream)
+{
+  _buffer.reserve(jsonWriterBufferSize + 4096);
+}
+
+JsonWriter::~JsonWriter()
+{
+  flush();
+}
+
+JsonWriter& JsonWriter::key(std::string_view key)
+{
+  _key.assign(key.data(), key.size());
+  return *this;
+}
+
+void JsonWriter::beginObject()
+{
+  beginScope(false);
+}
+
+void JsonWriter::endObject()
+{
+  endScope();
+}
+
+void JsonWriter::beginArray()
+{
+  beginScope(true);
+}
+
+void JsonWriter::endArray()
+{
+  endScope();
+}
+
+void JsonWriter::value(std::string_view value)
+{
+  beginValue();
+  writeString(value);
+}
+
+void JsonWriter::value(bool value)
+{
+  this->value(std::string_view(value ? "true" : "false"));
+}
+
+void JsonWriter::value(double value)
+{
+  // same precision as boost::property_tree
+  char str[32];
+  const int size = std::snprintf(str, sizeof(str), "%.17g", value);
+  this->value(std::string_view(str, static_cast<std::size_t>(size)));
+}
+
+void JsonWriter::valueInteger(std::int64_t value)
+{
+  char str[24];
+  const std::to_chars_result result = std::to_chars(str, str + sizeof(str), value);
+  this->value(std::string_view(str, static_cast<std::size_t>(result.ptr - str)));
+}
+
+void JsonWriter::valueUnsigned(std::uint64_t value)
+{
+  char str[24];
+  const std::to_chars_result result = std::to_chars(str, str + sizeof(str), value);
+  this->value(std::string_view(str, static_cast<std::size_t>(result.ptr - str)));
+}
+
+void JsonWriter::flush()
+{
+  _stream.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+  _buffer.clear();
+}
+
+void JsonWriter::beginValue()
+{
+  if(_scopes.empty())
+    return;
+
+  Scope& parent = _scopes.back();
+
+  if(!parent.isOpened)
+    openScope(parent);
+  else
+    _buffer.append(",\n");
+
+  indent(_scopes.size());
+
+  if(!parent.isArray)
+  {
+    writeString(_key);
+    _buffer.append(": ");
+  }
+
+  ++parent.nbElements;
+
+  if(_buffer.size() > jsonWriterBufferSize)
+    flush();
+}
+
+void JsonWriter::beginScope(bool isArray)
+{
+  beginValue();
+  _scopes.push_back({isArray, false, 0});
+}
+
+void JsonWriter::endScope()
+{
+  if(_scopes.empty())
+    throw std::logic_error("JsonWriter: no scope to end.");
+
+  const Scope scope = _scopes.back();
+  _scopes.pop_back();
+
+  if(!scope.isOpened)
+  {
+    // empty containers are written as an empty string, like boost::property_tree
+    _buffer.append("\"\"");
+  }
+  else
+  {
+    _buffer.push_back('\n');
+    indent(_scopes.size());
+    _buffer.push_back(scope.isArray ? ']' : '}');
+  }
+
+  if(_scopes.empty())
+    _buffer.push_back('\n');
+}
+
+void JsonWriter::openScope(Scope& scope)
+{
+  _buffer.push_back(scope.isArray ? '[' : '{');
+  _buffer.push_back('\n');
+  scope.isOpened = true;
+}
+
+void JsonWriter::writeString(std::string_view value)
+{
+  static const char hexDigits[] = "0123456789ABCDEF";
+
+  _buffer.push_back('"');
+
+  for(const char c : value)
+  {
+    switch(c)
+    {
+      case '"':  _buffer.append("\\\""); break;
+      case '\\': _buffer.append("\\\\"); break;
+      case '/':  _buffer.append("\\/"); break;
+      case '\b': _buffer.append("\\b"); break;
+      case '\f': _buffer.append("\\f"); break;
+      case '\n': _buffer.append("\\n"); break;
+      case '\r': _buffer.append("\\r"); break;
+      case '\t': _buffer.append("\\t"); break;
+      default:
+      {
+        const unsigned char uc = static_cast<unsigned char>(c);
+        if(uc < 0x20)
+        {
+          _buffer.append("\\u00");
+          _buffer.push_back(hexDigits[uc >> 4]);
+          _buffer.push_back(hexDigits[uc & 0xF]);
+        }
+        else
+        {
+          _buffer.push_back(c);
+        }
+      }
+    }
+  }
+
+  _buffer.push_back('"');
+}
+
+void JsonWriter::indent(std::size_t depth)
+{
+  _buffer.append(4 * depth, ' ');
+}
+
+JsonReader::JsonReader(const char* begin, const char* end)
+  : _begin(begin)
+  , _current(begin)
+  , _end(end)
+{}
+
+void JsonReader::beginObject()
+{
+  _isEmpty = consumeEmptyString();
+  if(!_isEmpty)
+    expect('{');
+  _isFirst = true;
+}
+
+bool JsonReader::nextKey(std::string_view& key)
+{
+  if(_isEmpty)
+  {
+    _isEmpty = false;
+    _isFirst = false;
+    return false;
+  }
+
+  if(peek() == '}')
+  {
+    ++_current;
+    _isFirst = false;
+    return false;
+  }
+
+  if(!_isFirst)
+    expect(',');
+  _isFirst = false;
+
+  if(peek() != '"')
+    error("expected a key");
+
+  parseString(_keyBuffer);
+  expect(':');
+
+  key = _keyBuffer;
+  return true;
+}
+
+void JsonReader::beginArray()
+{
+  _isEmpty = consumeEmptyString();
+  if(!_isEmpty)
+    expect('[');
+  _isFirst = true;
+}
+
+bool JsonReader::nextElement()
+{
+  if(_isEmpty)
+  {
+    _isEmpty = false;
+    _isFirst = false;
+    return false;
+  }
+
+  if(peek() == ']')
+  {
+    ++_current;
+    _isFirst = false;
+    return false;
+  }
+
+  if(!_isFirst)
+    expect(',');
+  _isFirst = false;
+
+  return true;
+}
+
+std::string JsonReader::readString()
+{
+  std::string value;
+
+  if(peek() == '"')
+  {
+    parseString(value);
+  }
+  else
+  {
+    // number or literal
+    bool isString;
+    const std::string_view raw = readRawScalar(isString);
+    value.assign(raw.data(), raw.size());
+  }
+
+  return value;
+}
+
+double JsonReader::readDouble()
+{
+  bool isString;
+  const std::string_view raw = readRawScalar(isString);
+
+  // copy in a null-terminated buffer for strtod
+  char str[64];
+  if(raw.empty() || raw.size() >= sizeof(str))
+    error("invalid number");
+
+  std::copy(raw.begin(), raw.end(), str);
+  str[raw.size()] = '\0';
+
+  char* strEnd = nullptr;
+  const double value = std::strtod(str, &strEnd);
+
+  if(strEnd != str + raw.size())
+    error("invalid number '" + std::string(raw) + "'");
+
+  return value;
+}
+
+bool JsonReader::readBool()
+{
+  bool isString;
+  const std::string_view raw = readRawScalar(isString);
+
+  if(raw == "true" || raw == "1")
+    return true;
+  if(raw == "false" || raw == "0")
+    return false;
+
+  error("invalid boolean '" + std::string(raw) + "'");
+}
+
+std::int64_t JsonReader::readInteger64()
+{
+  bool isString;
+  const std::string_view raw = readRawScalar(isString);
+
+  std::int64_t value = 0;
+  const std::from_chars_result result = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+
+  if(raw.empty() || result.ec != std::errc() || result.ptr != raw.data() + raw.size())
+    error("invalid integer '" + std::string(raw) + "'");
+
+  return value;
+}
+
+std::vector<double> JsonReader::readDoubleArray()
+{
+  std::vector<double> values;
+  beginArray();
+  while(nextElement())
+    values.push_back(readDouble());
+  return values;
+}
+
+void JsonReader::skipValue()
+{
+  const char c = peek();
+
+  if(c == '"')
+  {
+    // strings: find the closing quote
+    ++_current;
+    while(_current < _end && *_current != '"')
+      _current += (*_current == '\\') ? 2 : 1;
+    if(_current >= _end)
+      error("unterminated string");
+    ++_current;
+  }
+  else if(c == '{' || c == '[')
+  {
+    // containers: count the brackets, outside of the strings
+    std::size_t depth = 0;
+    do
+    {
+      if(_current >= _end)
+        error("unterminated container");
+
+      const char current = *_current;
+
+      if(current == '"')
+      {
+        ++_current;
+        while(_current < _end && *_current != '"')
+          _current += (*_current == '\\') ? 2 : 1;
+      }
+      else if(current == '{' || current == '[')
+      {
+        ++depth;
+      }
+      else if(current == '}' || current == ']')
+      {
+        --depth;
+      }
+      ++_current;
+    }
+    while(depth > 0);
+  }
+  else
+  {
+    bool isString;
+    readRawScalar(isString);
+  }
+}
+
+std::pair<const char*, const char*> JsonReader::skipValueRange()
+{
+  skipWhitespaces();
+  const char* begin = _current;
+  skipValue();
+  return {begin, _current};
+}
+
+void JsonReader::skipArrayRanges(std::vector<std::pair<const char*, const char*>>& out_ranges)
+{
+  out_ranges.clear();
+  beginArray();
+  while(nextElement())
+    out_ranges.push_back(skipValueRange());
+}
+
+void JsonReader::error(const std::string& message) const
+{
+  throw std::runtime_error("Invalid JSON at offset " + std::to_string(_current - _begin) + ": " + message + ".");
+}
+
+void JsonReader::skipWhitespaces()
+{
+  while(_current < _end && isWhitespace(*_current))
+    ++_current;
+}
+
+bool JsonReader::consumeEmptyString()
+{
+  skipWhitespaces();
+
+  if(_end - _current >= 2 && _current[0] == '"' && _current[1] == '"')
+  {
+    _current += 2;
+    return true;
+  }
+  return false;
+}
+
+char JsonReader::peek()
+{
+  skipWhitespaces();
+
+  if(_current >= _end)
+    error("unexpected end of document");
+
+  return *_current;
+}
+
+void JsonReader::expect(char c)
+{
+  if(peek() != c)
+    error(std::string("expected '") + c + "'");
+  ++_current;
+}
+
+std::string_view JsonReader::readRawScalar(bool& isString)
+{
+  isString = (peek() == '"');
+
+  if(isString)
+  {
+    // numbers and literals stored as strings do not contain escape sequences
+    const char* begin = ++_current;
+    while(_current < _end && *_current != '"')
+    {
+      if(*_current == '\\')
+        error("unexpected escape sequence");
+      ++_current;
+    }
+    if(_current >= _end)
+      error("unterminated string");
+    return std::string_view(begin, static_cast<std::size_t>(_current++ - begin));
+  }
+
+  const char* begin = _current;
+  while(_current < _end && !isDelimiter(*_current))
+    ++_current;
+
+  if(_current == begin)
+    error("expected a value");
+
+  return std::string_view(begin, static_cast<std::size_t>(_current - begin));
+}
+
+void JsonReader::parseString(std::string& out)
+{
+  out.clear();
+  expect('"');
+
+  while(true)
+  {
+    // copy the unescaped characters by block
+    const char* begin = _current;
+    while(_current < _end && *_current != '"' && *_current != '\\')
+      ++_current;
+    out.append(begin, _current);
+
+    if(_current >= _end)
+      error("unterminated string");
+
+    if(*_current == '"')
+    {
+      ++_current;
+      return;
+    }
+
+    // escape sequence
+    if(++_current >= _end)
+      error("unterminated string");
+
+    switch(*_current++)
+    {
+      case '"':  out.push_back('"'); break;
+      case '\\': out.push_back('\\'); break;
+      case '/':  out.push_back('/'); break;
+      case 'b':  out.push_back('\b'); break;
+      case 'f':  out.push_back('\f'); break;
+      case 'n':  out.push_back('\n'); break;
+      case 'r':  out.push_back('\r'); break;
+      case 't':  out.push_back('\t'); break;
+      case 'u':
+      {
+        const auto readCodeUnit = [this]() {
+          std::uint32_t codeUnit = 0;
+          if(_end - _current < 4)
+            error("invalid unicode escape sequence");
+          const std::from_chars_result result = std::from_chars(_current, _current + 4, codeUnit, 16);
+          if(result.ec != std::errc() || result.ptr != _current + 4)
+            error("invalid unicode escape sequence");
+          _current += 4;
+          return codeUnit;
+        };
+
+        std::uint32_t codePoint = readCodeUnit();
+
+        // surrogate pair
+        if(codePoint >= 0xD800 && codePoint < 0xDC00 && _end - _current >= 2 && _current[0] == '\\' && _current[1] == 'u')
+        {
+          _current += 2;
+          const std::uint32_t lowSurrogate = readCodeUnit();
+          codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+        }
+
+        appendUtf8(out, codePoint);
+        break;
+      }
+      default:
+        error("invalid escape sequence");
+    }
+  }
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -0,0 +1,249 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+/**
+ * @brief Streaming JSON writer.
+ *
+ * Values are written directly to the output stream, without any intermediate tree.
+ * The output has the same layout as boost::property_tree::write_json:
+ * 4 spaces indentation, all values written as strings and empty containers written as "".
+ */
+class JsonWriter
+{
+public:
+
+  /**
+   * @brief JsonWriter constructor
+   * @param[in] stream The output stream
+   */
+  explicit JsonWriter(std::ostream& stream);
+
+  /**
+   * @brief Flush the remaining buffered output
+   */
+  ~JsonWriter();
+
+  /**
+   * @brief Set the key of the next value, in an object
+   * @param[in] key The key
+   */
+  JsonWriter& key(std::string_view key);
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+
+  void value(std::string_view value);
+  void value(const std::string& value) { this->value(std::string_view(value)); }
+  void value(const char* value) { this->value(std::string_view(value)); }
+  void value(bool value);
+  void value(double value);
+  void value(float value) { this->value(static_cast<double>(value)); }
+  void value(int value) { valueInteger(static_cast<std::int64_t>(value)); }
+  void value(long value) { valueInteger(static_cast<std::int64_t>(value)); }
+  void value(long long value) { valueInteger(static_cast<std::int64_t>(value)); }
+  void value(unsigned char value) { valueUnsigned(value); }
+  void value(unsigned int value) { valueUnsigned(value); }
+  void value(unsigned long value) { valueUnsigned(value); }
+  void value(unsigned long long value) { valueUnsigned(value); }
+
+  /**
+   * @brief Write an Eigen Matrix (or Vector) as an array
+   * @param[in] matrix The input matrix
+   */
+  template<typename Derived>
+  void matrix(const Eigen::MatrixBase<Derived>& matrix)
+  {
+    beginArray();
+    for(int i = 0; i < matrix.size(); ++i)
+      value(matrix(i));
+    endArray();
+  }
+
+  /**
+   * @brief Write a list of values as an array
+   * @param[in] values The input values
+   */
+  template<typename T>
+  void array(const std::vector<T>& values)
+  {
+    beginArray();
+    for(const T& v : values)
+      value(v);
+    endArray();
+  }
+
+  /**
+   * @brief Flush the buffered output to the stream
+   */
+  void flush();
+
+private:
+  struct Scope
+  {
+    bool isArray;
+    bool isOpened;   //< the opening bracket has been written
+    std::size_t nbElements;
+  };
+
+  void valueInteger(std::int64_t value);
+  void valueUnsigned(std::uint64_t value);
+  void beginValue();
+  void beginScope(bool isArray);
+  void endScope();
+  void openScope(Scope& scope);
+  void writeString(std::string_view value);
+  void indent(std::size_t depth);
+
+  std::ostream& _stream;
+  std::string _buffer;
+  std::string _key;
+  std::vector<Scope> _scopes;
+};
+
+/**
+ * @brief Pull JSON reader on an in-memory document.
+ *
+ * The document is read sequentially, without building any tree.
+ * Values that are not needed are skipped, and the range of any value can be retrieved
+ * to be parsed later by another reader (e.g. the elements of an array in parallel).
+ * Scalar values can be read either from JSON strings (boost::property_tree::write_json output)
+ * or from JSON numbers / literals, and "" is accepted as an empty array or object.
+ */
+class JsonReader
+{
+public:
+
+  /**
+   * @brief JsonReader constructor
+   * @param[in] begin The beginning of the document
+   * @param[in] end The end of the document
+   */
+  JsonReader(const char* begin, const char* end);
+
+  /**
+   * @brief JsonReader constructor on a value range
+   * @param[in] range The value range
+   */
+  explicit JsonReader(const std::pair<const char*, const char*>& range)
+    : JsonReader(range.first, range.second)
+  {}
+
+  /**
+   * @brief Begin reading an object (or "")
+   */
+  void beginObject();
+
+  /**
+   * @brief Read the next key of the current object
+   * @param[out] key The next key, only valid until the next call
+   * @return false at the end of the object
+   */
+  bool nextKey(std::string_view& key);
+
+  /**
+   * @brief Begin reading an array (or "")
+   */
+  void beginArray();
+
+  /**
+   * @brief Move to the next element of the current array
+   * @return false at the end of the array
+   */
+  bool nextElement();
+
+  std::string readString();
+  double readDouble();
+  bool readBool();
+
+  template<typename T>
+  T readInteger()
+  {
+    return static_cast<T>(readInteger64());
+  }
+
+  /**
+   * @brief Read an Eigen Matrix (or Vector) from an array
+   * @param[out] matrix The output matrix
+   */
+  template<typename Derived>
+  void readMatrix(Eigen::MatrixBase<Derived>& matrix)
+  {
+    int i = 0;
+    beginArray();
+    while(nextElement())
+    {
+      if(i >= matrix.size())
+        error("invalid matrix / vector size");
+      matrix(i++) = static_cast<typename Derived::Scalar>(readDouble());
+    }
+  }
+
+  /**
+   * @brief Read an array of numbers
+   * @return the values
+   */
+  std::vector<double> readDoubleArray();
+
+  /**
+   * @brief Skip the next value
+   */
+  void skipValue();
+
+  /**
+   * @brief Skip the next value and get its range
+   * @return the range of the value in the document
+   */
+  std::pair<const char*, const char*> skipValueRange();
+
+  /**
+   * @brief Skip the elements of an array and get their ranges
+   * @param[out] out_ranges The ranges of the elements in the document
+   */
+  void skipArrayRanges(std::vector<std::pair<const char*, const char*>>& out_ranges);
+
+  /**
+   * @brief Throw a runtime_error with the current position
+   * @param[in] message The error message
+   */
+  [[noreturn]] void error(const std::string& message) const;
+
+private:
+  void skipWhitespaces();
+  bool consumeEmptyString();
+  char peek();
+  void expect(char c);
+  std::string_view readRawScalar(bool& isString);
+  std::int64_t readInteger64();
+  void parseString(std::string& out);
+
+  const char* _begin;
+  const char* _current;
+  const char* _end;
+  std::string _keyBuffer;
+  /// true after beginObject/beginArray until the first key/element
+  bool _isFirst = false;
+  /// true after beginObject/beginArray on "", until the end is read
+  bool _isEmpty = false;
+};
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -8,10 +8,12 @@
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfmDataIO/binaryIO.hpp>
 #include <aliceVision/config.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <fstream>
 #include <sstream>
 
 #define BOOST_TEST_MODULE sfmDataIO
@@ -71,7 +73,7 @@ sfmData::SfMData createTestScene(std::size_t viewsCount = 2, std::size_t observa
 
 BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD)
 {
-    std::vector<std::string> ext_Type = {"sfm", "json"};
+    std::vector<std::string> ext_Type = {"sfm", "json", "sfmb"};
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
     ext_Type.push_back("abc");
@@ -173,6 +175,131 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD)
     }
 }
 
+BOOST_AUTO_TEST_CASE(SfMData_IO_BINARY_LANDMARKS)
+{
+  const std::string filename = "SAVE_LOAD_LANDMARKS" + sfmDataBinaryFileExtension;
+  const sfmData::SfMData sfmData = createTestScene(4, 4, true);
+  BOOST_CHECK(Save(sfmData, filename, ALL));
+
+  const MappedSfMDataFile file(filename);
+  BOOST_CHECK_EQUAL(file.getNbLandmarks(), 1);
+  BOOST_CHECK_EQUAL(file.getNbObservations(), 4);
+
+  // landmark arrays are accessed in place
+  const double* positions = file.getLandmarkPositions();
+  BOOST_CHECK_EQUAL(file.getLandmarkIds()[0], 0);
+  BOOST_CHECK_EQUAL(positions[0], 11.0);
+  BOOST_CHECK_EQUAL(positions[1], 22.0);
+  BOOST_CHECK_EQUAL(positions[2], 33.0);
+  BOOST_CHECK_EQUAL(file.getObservationOffsets()[1], 4);
+
+  sfmData::CompactLandmarks landmarks;
+  file.loadLandmarks(landmarks);
+  BOOST_CHECK_EQUAL(landmarks.size(), 1);
+  BOOST_CHECK_EQUAL(landmarks.getNbObservations(), 4);
+  BOOST_CHECK(landmarks.getDescType(0) == feature::EImageDescriberType::SIFT);
+
+  for(std::size_t i = landmarks.observationsBegin(0); i < landmarks.observationsEnd(0); ++i)
+  {
+    BOOST_CHECK_EQUAL(landmarks.getObservationViewId(i), i);
+    BOOST_CHECK_EQUAL(landmarks.getObservationFeatureId(i), i);
+    BOOST_CHECK_EQUAL(landmarks.getObservationX(i), Vec2(i, i));
+  }
+
+  // the observations without features are not saved
+  BOOST_CHECK(Save(sfmData, filename, ESfMData(ALL & ~OBSERVATIONS_WITH_FEATURES)));
+  const MappedSfMDataFile fileWithoutFeatures(filename);
+  BOOST_CHECK(fileWithoutFeatures.hasSection(SFMDATA_BINARY_OBSERVATION_VIEW_IDS));
+  BOOST_CHECK(!fileWithoutFeatures.hasSection(SFMDATA_BINARY_OBSERVATION_PIXELS));
+  BOOST_CHECK(fileWithoutFeatures.getObservationPixels() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_BINARY_INVALID_OFFSETS)
+{
+  const std::string filename = "SAVE_LOAD_INVALID_OFFSETS" + sfmDataBinaryFileExtension;
+  const sfmData::SfMData sfmData = createTestScene(4, 4, true);
+  BOOST_CHECK(Save(sfmData, filename, ALL));
+  BOOST_CHECK_NO_THROW(MappedSfMDataFile{filename});
+
+  // decreasing offsets, the last one is still the number of observations
+  {
+    std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+    SfMDataBinaryHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    const std::uint64_t firstOffset = 5;
+    file.seekp(header.sections[SFMDATA_BINARY_OBSERVATION_OFFSETS].offset);
+    file.write(reinterpret_cast<const char*>(&firstOffset), sizeof(firstOffset));
+  }
+  BOOST_CHECK_THROW(MappedSfMDataFile{filename}, std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_COMPATIBILITY)
+{
+  // values written as JSON numbers, empty containers written as "" and unknown fields
+  const std::string filename = "LOAD_COMPATIBILITY.sfm";
+  {
+    std::ofstream file(filename);
+    file << R"({
+      "version": [1, 2, 5],
+      "unknownSection": {"a": [1, {"b": "]"}]},
+      "views": [
+        {"viewId": 10, "poseId": "10", "intrinsicId": 0, "path": "dataset\/0.jpg", "width": 1500, "height": 1000, "metadata": "", "unknownField": [1, 2]},
+        {"viewId": "11", "poseId": 11, "intrinsicId": "0", "path": "dataset/1.jpg", "width": "1500", "height": "1000", "metadata": {"Make": "Canon \"EOS\""}}
+      ],
+      "intrinsics": [
+        {"intrinsicId": "0", "width": "1500", "height": "1000", "sensorWidth": "36", "sensorHeight": "24", "serialNumber": "",
+         "type": "radial3", "initializationMode": "unknown", "initialFocalLength": "-1", "focalLength": "24", "pixelRatio": "1",
+         "pixelRatioLocked": true, "principalPoint": ["10", "-20"], "distortionInitializationMode": "none",
+         "distortionParams": [0.1, 0, 0], "undistortionOffset": [0, 0], "undistortionParams": "", "locked": false}
+      ],
+      "poses": [
+        {"poseId": 10, "pose": {"transform": {"rotation": [1, 0, 0, 0, 1, 0, 0, 0, 1], "center": [1, 2, 3]}, "locked": 1}}
+      ],
+      "structure": [
+        {"landmarkId": 0, "descType": "sift", "color": [255, 0, 0], "X": [11, 22, 33],
+         "observations": [{"observationId": 10, "featureId": 4, "x": [1.5, 2.5], "scale": 2}, {"observationId": 11, "featureId": 5, "x": [3, 4]}]}
+      ]
+    })";
+  }
+
+  sfmData::SfMData sfmDataLoad;
+  BOOST_CHECK(Load(sfmDataLoad, filename, ALL));
+
+  BOOST_CHECK_EQUAL(sfmDataLoad.getViews().size(), 2);
+  BOOST_CHECK_EQUAL(sfmDataLoad.getView(10).getImage().getImagePath(), "dataset/0.jpg");
+  BOOST_CHECK_EQUAL(sfmDataLoad.getView(11).getImage().getMetadata().at("Make"), "Canon \"EOS\"");
+  BOOST_CHECK_EQUAL(sfmDataLoad.getView(11).getImage().getWidth(), 1500);
+
+  BOOST_CHECK_EQUAL(sfmDataLoad.getIntrinsics().size(), 1);
+  const auto intrinsic = std::dynamic_pointer_cast<camera::IntrinsicScaleOffsetDisto>(sfmDataLoad.getIntrinsics().at(0));
+  BOOST_REQUIRE(intrinsic != nullptr);
+  BOOST_CHECK_CLOSE(intrinsic->getScale()(0), 1000.0, 1e-6);
+  BOOST_CHECK_EQUAL(intrinsic->getOffset(), Vec2(10.0, -20.0));
+  BOOST_CHECK_EQUAL(intrinsic->getDistortionParams().at(0), 0.1);
+  BOOST_CHECK(intrinsic->isRatioLocked());
+
+  BOOST_CHECK_EQUAL(sfmDataLoad.getPoses().size(), 1);
+  BOOST_CHECK(sfmDataLoad.getPoses().at(10).isLocked());
+  BOOST_CHECK_EQUAL(sfmDataLoad.getPoses().at(10).getTransform().center(), Vec3(1.0, 2.0, 3.0));
+
+  BOOST_CHECK_EQUAL(sfmDataLoad.getLandmarks().size(), 1);
+  const sfmData::Landmark& landmark = sfmDataLoad.getLandmarks().at(0);
+  BOOST_CHECK_EQUAL(landmark.X, Vec3(11.0, 22.0, 33.0));
+  BOOST_CHECK_EQUAL(landmark.observations.size(), 2);
+  BOOST_CHECK_EQUAL(landmark.observations.at(10).id_feat, 4);
+  BOOST_CHECK_EQUAL(landmark.observations.at(10).scale, 2.0);
+  BOOST_CHECK_EQUAL(landmark.observations.at(11).scale, 0.0);
+
+  // the skipped sections are not loaded
+  sfmData::SfMData sfmDataPartial;
+  BOOST_CHECK(Load(sfmDataPartial, filename, ESfMData(STRUCTURE)));
+  BOOST_CHECK_EQUAL(sfmDataPartial.getViews().size(), 0);
+  BOOST_CHECK_EQUAL(sfmDataPartial.getIntrinsics().size(), 0);
+  BOOST_CHECK_EQUAL(sfmDataPartial.getLandmarks().size(), 1);
+  BOOST_CHECK(sfmDataPartial.getLandmarks().at(0).observations.empty());
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
   const int nbViews = 1000;
@@ -8,7 +8,12 @@
 #ifndef ALICEVISION_STL_HASH_H
 #define ALICEVISION_STL_HASH_H
 
+#include <cstdint>
+#include <fstream>
 #include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace stl
 {
@@ -22,6 +27,45 @@ inline void hash_combine(std::size_t& seed, const T& v)
   seed ^= hasher(v) + 0x9e3779b9 + (seed<<6) + (seed>>2);
 }
 
+/// 64 bits FNV-1a offset basis, the hash of an empty buffer
+constexpr std::uint64_t fnv1aOffsetBasis = 14695981039346656037ULL;
+
+/**
+ * @brief 64 bits FNV-1a hash of a buffer.
+ * @param[in] data the buffer
+ * @param[in] size the buffer size in bytes
+ * @param[in] hash the hash of the previous buffers, to hash several buffers as one
+ * @return the hash
+ */
+inline std::uint64_t hashBytes(const void* data, std::size_t size, std::uint64_t hash = fnv1aOffsetBasis)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for(std::size_t i = 0; i < size; ++i)
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  return hash;
+}
+
+/**
+ * @brief 64 bits FNV-1a hash of a file content.
+ * @param[in] filename the file path
+ * @param[in] hash the hash of the previous buffers, to hash several buffers as one
+ * @return the hash
+ */
+inline std::uint64_t hashFile(const std::string& filename, std::uint64_t hash = fnv1aOffsetBasis)
+{
+  std::ifstream in(filename, std::ios_base::binary);
+  if(!in.is_open())
+    throw std::runtime_error("Unable to read the file: " + filename);
+
+  std::vector<char> buffer(1 << 16);
+  while(in)
+  {
+    in.read(buffer.data(), buffer.size());
+    hash = hashBytes(buffer.data(), static_cast<std::size_t>(in.gcount()), hash);
+  }
+  return hash;
+}
+
 } // namespace stl
 
 #endif  // ALICEVISION_STL_HASH_H
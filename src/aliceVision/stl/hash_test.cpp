@@ -0,0 +1,48 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "hash.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <string>
+
+#define BOOST_TEST_MODULE stlHash
+
+#include <boost/test/unit_test.hpp>
+
+namespace fs = boost::filesystem;
+
+BOOST_AUTO_TEST_CASE(HASH_FNV1a_Bytes)
+{
+  // reference values of the 64 bits FNV-1a
+  BOOST_CHECK_EQUAL(stl::hashBytes("", 0), 0xcbf29ce484222325ULL);
+  BOOST_CHECK_EQUAL(stl::hashBytes("a", 1), 0xaf63dc4c8601ec8cULL);
+  BOOST_CHECK_EQUAL(stl::hashBytes("foobar", 6), 0x85944171f73967e8ULL);
+
+  // several buffers are hashed as one
+  BOOST_CHECK_EQUAL(stl::hashBytes("bar", 3, stl::hashBytes("foo", 3)), stl::hashBytes("foobar", 6));
+}
+
+BOOST_AUTO_TEST_CASE(HASH_FNV1a_File)
+{
+  // bigger than the read buffer
+  std::string content;
+  for(int i = 0; i < 100000; ++i)
+    content.push_back(static_cast<char>(i % 251));
+
+  const fs::path filename = fs::temp_directory_path() / fs::unique_path("hash_%%%%%%.bin");
+  {
+    std::ofstream out(filename.string(), std::ios_base::binary);
+    out.write(content.data(), content.size());
+  }
+
+  BOOST_CHECK_EQUAL(stl::hashFile(filename.string()), stl::hashBytes(content.data(), content.size()));
+  fs::remove(filename);
+
+  BOOST_CHECK_THROW(stl::hashFile(filename.string()), std::runtime_error);
+}
@@ -0,0 +1,319 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "FlatTracksBuilder.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+
+namespace aliceVision {
+namespace track {
+
+namespace {
+
+/// dense id of a feature in the union-find, 32 bits to halve the memory of the per-node arrays
+using NodeId = std::uint32_t;
+
+/// (viewId, descType) of a group of features
+using FeaturesSlot = std::pair<IndexT, feature::EImageDescriberType>;
+
+/// matches of one pair for one describer type
+struct PairMatches
+{
+  IndexT I;
+  IndexT J;
+  feature::EImageDescriberType descType;
+  const IndMatches* matches;
+};
+
+/**
+ * @brief Lock-free union-find over dense node ids.
+ * The root of a set is always its smallest node id.
+ */
+class ConcurrentUnionFind
+{
+public:
+  explicit ConcurrentUnionFind(std::size_t size, bool multithreaded)
+    : _size(size)
+    , _parent(new std::atomic<NodeId>[size])
+  {
+#pragma omp parallel for if(multithreaded)
+    for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(size); ++i)
+      _parent[i].store(static_cast<NodeId>(i), std::memory_order_relaxed);
+  }
+
+  NodeId find(NodeId x)
+  {
+    while(true)
+    {
+      NodeId p = _parent[x].load(std::memory_order_relaxed);
+      if(p == x)
+        return x;
+      const NodeId gp = _parent[p].load(std::memory_order_relaxed);
+      if(p != gp)
+      {
+        // path halving
+        _parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+      }
+      x = gp;
+    }
+  }
+
+  void unite(NodeId a, NodeId b)
+  {
+    while(true)
+    {
+      a = find(a);
+      b = find(b);
+      if(a == b)
+        return;
+      // link the largest root under the smallest one
+      if(a < b)
+        std::swap(a, b);
+      NodeId expected = a;
+      if(_parent[a].compare_exchange_strong(expected, b))
+        return;
+    }
+  }
+
+  inline std::size_t size() const { return _size; }
+
+private:
+  std::size_t _size;
+  std::unique_ptr<std::atomic<NodeId>[]> _parent;
+};
+
+} // namespace
+
+void FlatTracksBuilder::build(const PairwiseMatches& pairwiseMatches, bool multithreaded)
+{
+  _tracks.clear();
+
+  // flatten the matches and list the features slots (viewId, descType)
+  std::vector<PairMatches> allPairMatches;
+  std::vector<FeaturesSlot> slots;
+
+  for(const auto& matchesPerDescIt : pairwiseMatches)
+  {
+    const IndexT I = matchesPerDescIt.first.first;
+    const IndexT J = matchesPerDescIt.first.second;
+
+    for(const auto& matchesIt : matchesPerDescIt.second)
+    {
+      if(matchesIt.second.empty())
+        continue;
+      allPairMatches.push_back({I, J, matchesIt.first, &matchesIt.second});
+      slots.emplace_back(I, matchesIt.first);
+      slots.emplace_back(J, matchesIt.first);
+    }
+  }
+
+  std::sort(slots.begin(), slots.end());
+  slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+  const auto getSlotIndex = [&slots](IndexT viewId, feature::EImageDescriberType descType) {
+    return static_cast<std::size_t>(std::lower_bound(slots.begin(), slots.end(), FeaturesSlot(viewId, descType)) - slots.begin());
+  };
+
+  // number of features referenced per slot
+  std::vector<NodeId> slotSizes(slots.size(), 0);
+
+#pragma omp parallel for if(multithreaded)
+  for(std::ptrdiff_t p = 0; p < static_cast<std::ptrdiff_t>(allPairMatches.size()); ++p)
+  {
+    const PairMatches& pairMatches = allPairMatches.at(p);
+    NodeId maxI = 0;
+    NodeId maxJ = 0;
+    for(const IndMatch& m : *pairMatches.matches)
+    {
+      maxI = std::max(maxI, static_cast<NodeId>(m._i + 1));
+      maxJ = std::max(maxJ, static_cast<NodeId>(m._j + 1));
+    }
+    const std::size_t slotI = getSlotIndex(pairMatches.I, pairMatches.descType);
+    const std::size_t slotJ = getSlotIndex(pairMatches.J, pairMatches.descType);
+
+#pragma omp critical
+    {
+      slotSizes[slotI] = std::max(slotSizes[slotI], maxI);
+      slotSizes[slotJ] = std::max(slotSizes[slotJ], maxJ);
+    }
+  }
+
+  // dense node id: slotOffsets[slot] + featIndex
+  std::vector<NodeId> slotOffsets(slots.size() + 1, 0);
+  std::uint64_t totalNbNodes = 0;
+  for(std::size_t s = 0; s < slots.size(); ++s)
+  {
+    totalNbNodes += slotSizes[s];
+    // the node ids must fit in 32 bits (the largest value is kept for the invalid track id)
+    if(totalNbNodes >= std::numeric_limits<NodeId>::max())
+      throw std::runtime_error("Too many matched features to build the tracks (" + std::to_string(totalNbNodes) + "), the limit is 2^32.");
+    slotOffsets[s + 1] = static_cast<NodeId>(totalNbNodes);
+  }
+
+  const std::size_t nbNodes = slotOffsets.back();
+
+  // make the union according the pair matches
+  ConcurrentUnionFind unionFind(nbNodes, multithreaded);
+
+#pragma omp parallel for schedule(dynamic) if(multithreaded)
+  for(std::ptrdiff_t p = 0; p < static_cast<std::ptrdiff_t>(allPairMatches.size()); ++p)
+  {
+    const PairMatches& pairMatches = allPairMatches.at(p);
+    const NodeId offsetI = slotOffsets[getSlotIndex(pairMatches.I, pairMatches.descType)];
+    const NodeId offsetJ = slotOffsets[getSlotIndex(pairMatches.J, pairMatches.descType)];
+
+    for(const IndMatch& m : *pairMatches.matches)
+      unionFind.unite(offsetI + m._i, offsetJ + m._j);
+  }
+
+  // node roots
+  std::vector<NodeId> roots(nbNodes);
+
+#pragma omp parallel for if(multithreaded)
+  for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(nbNodes); ++i)
+    roots[i] = unionFind.find(static_cast<NodeId>(i));
+
+  // number of observations per root, then track id of each root
+  std::vector<NodeId> rootTrack(nbNodes, 0);
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    ++rootTrack[roots[i]];
+
+  // a track is a set of at least 2 observations (features not referenced by a match are singletons)
+  // roots are the smallest node ids, so tracks are ordered by their first observation
+  constexpr NodeId invalidTrack = std::numeric_limits<NodeId>::max();
+  std::size_t slot = 0;
+
+  for(std::size_t i = 0; i < nbNodes; ++i)
+  {
+    if(roots[i] != i)
+      continue;
+
+    const std::size_t nbObservations = rootTrack[i];
+    if(nbObservations < 2)
+    {
+      rootTrack[i] = invalidTrack;
+      continue;
+    }
+
+    while(slotOffsets[slot + 1] <= i)
+      ++slot;
+
+    rootTrack[i] = static_cast<NodeId>(_tracks.descTypes.size());
+    _tracks.descTypes.push_back(slots[slot].second);
+    _tracks.offsets.push_back(_tracks.offsets.back() + nbObservations);
+  }
+
+  // fill observations, nodes are sorted by (viewId, descType, featIndex)
+  const std::size_t nbObservations = _tracks.offsets.back();
+  _tracks.viewIds.resize(nbObservations);
+  _tracks.featIds.resize(nbObservations);
+
+  std::vector<std::size_t> cursors(_tracks.offsets.begin(), _tracks.offsets.end() - 1);
+
+  for(std::size_t s = 0; s < slots.size(); ++s)
+  {
+    for(std::size_t i = slotOffsets[s]; i < slotOffsets[s + 1]; ++i)
+    {
+      const NodeId trackId = rootTrack[roots[i]];
+      if(trackId == invalidTrack)
+        continue;
+
+      const std::size_t pos = cursors[trackId]++;
+      _tracks.viewIds[pos] = slots[s].first;
+      _tracks.featIds[pos] = static_cast<IndexT>(i - slotOffsets[s]);
+    }
+  }
+}
+
+void FlatTracksBuilder::filter(bool clearForks, std::size_t minTrackLength, bool multithreaded)
+{
+  // remove bad tracks:
+  // - track that are too short,
+  // - track with id conflicts (many times the same image index)
+  if(!clearForks && minTrackLength == 0)
+      return;
+
+  const std::size_t nbTracks = _tracks.nbTracks();
+  std::vector<unsigned char> keepTrack(nbTracks, 1);
+
+#pragma omp parallel for if(multithreaded)
+  for(std::ptrdiff_t t = 0; t < static_cast<std::ptrdiff_t>(nbTracks); ++t)
+  {
+    const std::size_t begin = _tracks.offsets[t];
+    const std::size_t end = _tracks.offsets[t + 1];
+
+    // observations are sorted by view id
+    std::size_t nbViews = (end > begin) ? 1 : 0;
+    for(std::size_t i = begin + 1; i < end; ++i)
+    {
+      if(_tracks.viewIds[i] != _tracks.viewIds[i - 1])
+        ++nbViews;
+    }
+
+    if((clearForks && nbViews != (end - begin)) || nbViews < minTrackLength)
+      keepTrack[t] = 0;
+  }
+
+  // compact the CSR arrays
+  std::size_t outTrack = 0;
+  std::size_t outObservation = 0;
+
+  for(std::size_t t = 0; t < nbTracks; ++t)
+  {
+    if(!keepTrack[t])
+      continue;
+
+    const std::size_t begin = _tracks.offsets[t];
+    const std::size_t end = _tracks.offsets[t + 1];
+
+    std::copy(_tracks.viewIds.begin() + begin, _tracks.viewIds.begin() + end, _tracks.viewIds.begin() + outObservation);
+    std::copy(_tracks.featIds.begin() + begin, _tracks.featIds.begin() + end, _tracks.featIds.begin() + outObservation);
+    _tracks.descTypes[outTrack] = _tracks.descTypes[t];
+
+    outObservation += end - begin;
+    ++outTrack;
+    _tracks.offsets[outTrack] = outObservation;
+  }
+
+  _tracks.offsets.resize(outTrack + 1);
+  _tracks.descTypes.resize(outTrack);
+  _tracks.viewIds.resize(outObservation);
+  _tracks.featIds.resize(outObservation);
+}
+
+void FlatTracksBuilder::exportToSTL(TracksMap& allTracks) const
+{
+  allTracks.clear();
+  allTracks.reserve(_tracks.nbTracks());
+
+  for(std::size_t t = 0; t < _tracks.nbTracks(); ++t)
+  {
+    Track track;
+    track.descType = _tracks.descTypes[t];
+    track.featPerView.reserve(_tracks.trackLength(t));
+
+    for(std::size_t i = _tracks.offsets[t]; i < _tracks.offsets[t + 1]; ++i)
+    {
+      // observations are sorted by view id, keep the last one in case of forks
+      if(!track.featPerView.empty() && (track.featPerView.end() - 1)->first == _tracks.viewIds[i])
+        (track.featPerView.end() - 1)->second = _tracks.featIds[i];
+      else
+        track.featPerView.emplace_hint(track.featPerView.end(), _tracks.viewIds[i], _tracks.featIds[i]);
+    }
+
+    allTracks.emplace_hint(allTracks.end(), t, std::move(track));
+  }
+}
+
+} // namespace track
+} // namespace aliceVision
@@ -0,0 +1,112 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/track/Track.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace track {
+
+/**
+ * @brief Tracks stored in CSR (Compressed Sparse Row) layout.
+ *
+ * The observations of the track t are stored in [offsets[t], offsets[t+1])
+ * of the viewIds / featIds arrays, sorted by view id.
+ */
+struct FlatTracks
+{
+  /// observations offset per track (size: nbTracks + 1)
+  std::vector<std::size_t> offsets = {0};
+  /// view id per observation
+  std::vector<IndexT> viewIds;
+  /// feature index per observation
+  std::vector<IndexT> featIds;
+  /// describer type per track
+  std::vector<feature::EImageDescriberType> descTypes;
+
+  inline std::size_t nbTracks() const { return descTypes.size(); }
+  inline std::size_t nbObservations() const { return viewIds.size(); }
+  inline std::size_t trackLength(std::size_t trackId) const { return offsets[trackId + 1] - offsets[trackId]; }
+
+  void clear()
+  {
+    offsets.assign(1, 0);
+    viewIds.clear();
+    featIds.clear();
+    descTypes.clear();
+  }
+};
+
+/**
+ * @brief Allows to create Tracks from a set of Matches across Views.
+ *
+ * Same algorithm as TracksBuilder [1] with flat data structures:
+ * - each observation (viewId, descType, featIndex) is mapped to a dense integer id
+ *   using per view (and describer type) feature offsets,
+ * - the union of the matches is computed in parallel with a lock-free union-find,
+ * - the tracks are exported in CSR layout (FlatTracks).
+ *
+ * The tracks are ordered by their first observation, and their observations by view id.
+ *
+ * [1] "Unordered feature tracking made fast and easy"
+ *     Pierre Moulon and Pascal Monasse. CVMP 2012
+ *
+ * Usage:
+ * @code{.cpp}
+ *  FlatTracksBuilder tracksBuilder;
+ *  tracksBuilder.build(matches);     // build: Efficient fusion of correspondences
+ *  tracksBuilder.filter();           // filter: Remove track that have conflict
+ *  tracksBuilder.exportToSTL(tracks); // export to the legacy TracksMap structure
+ * @endcode
+ */
+class FlatTracksBuilder
+{
+public:
+    FlatTracksBuilder() = default;
+
+    /**
+    * @brief Build tracks for a given series of pairWise matches
+    * @param[in] pairwiseMatches PairWise matches
+    * @param[in] multithreaded Is multithreaded
+    */
+    void build(const PairwiseMatches& pairwiseMatches, bool multithreaded = true);
+
+    /**
+    * @brief Remove bad tracks (too short or track with ids collision)
+    * @param[in] clearForks: remove tracks with multiple observation in a single image
+    * @param[in] minTrackLength: minimal number of observations to keep the track
+    * @param[in] multithreaded Is multithreaded
+    */
+    void filter(bool clearForks = true, std::size_t minTrackLength = 2, bool multithreaded = true);
+
+    /**
+    * @brief Export tracks as a map (each entry is a sequence of imageId and keypointId):
+    *        {TrackIndex => {(imageIndex, keypointId), ... ,(imageIndex, keypointId)}
+    * @note In case of forks (if not filtered), only the last observation per view is kept.
+    */
+    void exportToSTL(TracksMap& allTracks) const;
+
+    /**
+    * @brief Get the tracks in CSR layout.
+    */
+    inline const FlatTracks& getTracks() const { return _tracks; }
+
+    /**
+    * @brief Return the number of tracks
+    */
+    inline std::size_t nbTracks() const { return _tracks.nbTracks(); }
+
+private:
+    FlatTracks _tracks;
+};
+
+} // namespace track
+} // namespace aliceVision
@@ -0,0 +1,283 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TracksPerViewIndex.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace aliceVision {
+namespace track {
+
+namespace {
+
+/// size ratio from which the galloping search is faster than the linear merge
+constexpr std::size_t gallopingRatio = 32;
+
+/**
+ * @brief Find the first element >= value in [first, last) with an exponential search.
+ */
+inline const std::size_t* gallop(const std::size_t* first, const std::size_t* last, std::size_t value)
+{
+  std::size_t step = 1;
+  const std::size_t* lo = first;
+  const std::size_t* hi = first;
+
+  while(hi < last && *hi < value)
+  {
+    lo = hi + 1;
+    hi = (static_cast<std::size_t>(last - hi) > step) ? hi + step : last;
+    step <<= 1;
+  }
+  return std::lower_bound(lo, hi, value);
+}
+
+} // namespace
+
+void intersectSortedTrackIds(const TrackIdRange& a, const TrackIdRange& b, std::vector<std::size_t>& out_tracksIds)
+{
+  const TrackIdRange& smallRange = (a.size() <= b.size()) ? a : b;
+  const TrackIdRange& largeRange = (a.size() <= b.size()) ? b : a;
+
+  if(smallRange.empty())
+    return;
+
+  if(largeRange.size() / smallRange.size() >= gallopingRatio)
+  {
+    // galloping search of each element of the small range in the large one
+    const std::size_t* it = largeRange.begin();
+    for(const std::size_t trackId : smallRange)
+    {
+      it = gallop(it, largeRange.end(), trackId);
+      if(it == largeRange.end())
+        break;
+      if(*it == trackId)
+        out_tracksIds.push_back(trackId);
+    }
+    return;
+  }
+
+  // linear merge
+  const std::size_t* itA = smallRange.begin();
+  const std::size_t* itB = largeRange.begin();
+  while(itA != smallRange.end() && itB != largeRange.end())
+  {
+    const std::size_t valueA = *itA;
+    const std::size_t valueB = *itB;
+    if(valueA == valueB)
+      out_tracksIds.push_back(valueA);
+    itA += (valueA <= valueB);
+    itB += (valueB <= valueA);
+  }
+}
+
+void TracksPerViewIndex::build(const TracksPerView& tracksPerView, double denseViewRatio)
+{
+  clear();
+
+  std::size_t nbObservations = 0;
+  for(const auto& viewTracks : tracksPerView)
+  {
+    nbObservations += viewTracks.second.size();
+    if(!viewTracks.second.empty())
+      _nbTracks = std::max(_nbTracks, viewTracks.second.back() + 1);
+  }
+
+  _viewIds.reserve(tracksPerView.size());
+  _offsets.reserve(tracksPerView.size() + 1);
+  _trackIds.reserve(nbObservations);
+  _bitsetIndexes.reserve(tracksPerView.size());
+
+  // TracksPerView is sorted by view id
+  for(const auto& viewTracks : tracksPerView)
+  {
+    const TrackIdSet& trackIds = viewTracks.second;
+    assert(std::is_sorted(trackIds.begin(), trackIds.end()));
+
+    _viewIds.push_back(viewTracks.first);
+    _trackIds.insert(_trackIds.end(), trackIds.begin(), trackIds.end());
+    _offsets.push_back(_trackIds.size());
+
+    if(!trackIds.empty() && static_cast<double>(trackIds.size()) >= denseViewRatio * static_cast<double>(_nbTracks))
+    {
+      _bitsetIndexes.push_back(static_cast<int>(_bitsets.size()));
+      _bitsets.emplace_back(_nbTracks);
+      TrackIdBitset& bitset = _bitsets.back();
+      for(const std::size_t trackId : trackIds)
+        bitset.set(trackId);
+    }
+    else
+    {
+      _bitsetIndexes.push_back(-1);
+    }
+  }
+}
+
+void TracksPerViewIndex::clear()
+{
+  _nbTracks = 0;
+  _viewIds.clear();
+  _offsets.assign(1, 0);
+  _trackIds.clear();
+  _bitsetIndexes.clear();
+  _bitsets.clear();
+}
+
+std::size_t TracksPerViewIndex::getViewIndex(std::size_t viewId) const
+{
+  const auto it = std::lower_bound(_viewIds.begin(), _viewIds.end(), viewId);
+  if(it == _viewIds.end() || *it != viewId)
+    return _viewIds.size();
+  return static_cast<std::size_t>(it - _viewIds.begin());
+}
+
+bool TracksPerViewIndex::hasView(std::size_t viewId) const
+{
+  return getViewIndex(viewId) != _viewIds.size();
+}
+
+TrackIdRange TracksPerViewIndex::getTracks(std::size_t viewId) const
+{
+  TrackIdRange range;
+  const std::size_t viewIndex = getViewIndex(viewId);
+  if(viewIndex == _viewIds.size())
+    return range;
+
+  range.first = _trackIds.data() + _offsets[viewIndex];
+  range.last = _trackIds.data() + _offsets[viewIndex + 1];
+  return range;
+}
+
+bool TracksPerViewIndex::isDenseView(std::size_t viewId) const
+{
+  const std::size_t viewIndex = getViewIndex(viewId);
+  return (viewIndex != _viewIds.size()) && (_bitsetIndexes[viewIndex] >= 0);
+}
+
+void TracksPerViewIndex::intersect(const TrackIdRange& range, std::size_t viewIndex, std::vector<std::size_t>& out_tracksIds) const
+{
+  const TrackIdRange viewRange = {_trackIds.data() + _offsets[viewIndex], _trackIds.data() + _offsets[viewIndex + 1]};
+  const int bitsetIndex = _bitsetIndexes[viewIndex];
+
+  // dense view: test each element of the other range in the bitset
+  if(bitsetIndex >= 0 && range.size() < viewRange.size())
+  {
+    const TrackIdBitset& bitset = _bitsets[bitsetIndex];
+    for(const std::size_t trackId : range)
+    {
+      if(bitset.test(trackId))
+        out_tracksIds.push_back(trackId);
+    }
+    return;
+  }
+
+  intersectSortedTrackIds(range, viewRange, out_tracksIds);
+}
+
+std::size_t TracksPerViewIndex::countCommonTracks(std::size_t viewIdA, std::size_t viewIdB) const
+{
+  const std::size_t viewIndexA = getViewIndex(viewIdA);
+  const std::size_t viewIndexB = getViewIndex(viewIdB);
+
+  if(viewIndexA == _viewIds.size() || viewIndexB == _viewIds.size())
+    return 0;
+
+  const int bitsetIndexA = _bitsetIndexes[viewIndexA];
+  const int bitsetIndexB = _bitsetIndexes[viewIndexB];
+
+  // both views are dense: bitwise and
+  if(bitsetIndexA >= 0 && bitsetIndexB >= 0)
+  {
+    const std::vector<std::uint64_t>& wordsA = _bitsets[bitsetIndexA].getWords();
+    const std::vector<std::uint64_t>& wordsB = _bitsets[bitsetIndexB].getWords();
+    std::size_t count = 0;
+    for(std::size_t i = 0; i < wordsA.size(); ++i)
+      count += TrackIdBitset::popcount(wordsA[i] & wordsB[i]);
+    return count;
+  }
+
+  std::vector<std::size_t> commonTracks;
+  const TrackIdRange rangeA = {_trackIds.data() + _offsets[viewIndexA], _trackIds.data() + _offsets[viewIndexA + 1]};
+  intersect(rangeA, viewIndexB, commonTracks);
+  return commonTracks.size();
+}
+
+void TracksPerViewIndex::getCommonTracks(const std::set<std::size_t>& viewIds, std::vector<std::size_t>& out_tracksIds) const
+{
+  out_tracksIds.clear();
+
+  if(viewIds.empty())
+    return;
+
+  // start from the smallest views
+  std::vector<std::pair<std::size_t, std::size_t>> viewsBySize; // <nbTracks, viewIndex>
+  viewsBySize.reserve(viewIds.size());
+  for(const std::size_t viewId : viewIds)
+  {
+    const std::size_t viewIndex = getViewIndex(viewId);
+    // one image is not indexed, so there is no track in common
+    if(viewIndex == _viewIds.size())
+      return;
+    viewsBySize.emplace_back(_offsets[viewIndex + 1] - _offsets[viewIndex], viewIndex);
+  }
+  std::sort(viewsBySize.begin(), viewsBySize.end());
+
+  const std::size_t firstViewIndex = viewsBySize.front().second;
+  out_tracksIds.assign(_trackIds.begin() + _offsets[firstViewIndex], _trackIds.begin() + _offsets[firstViewIndex + 1]);
+
+  std::vector<std::size_t> tmp;
+  for(std::size_t i = 1; i < viewsBySize.size() && !out_tracksIds.empty(); ++i)
+  {
+    tmp.clear();
+    const TrackIdRange range = {out_tracksIds.data(), out_tracksIds.data() + out_tracksIds.size()};
+    intersect(range, viewsBySize[i].second, tmp);
+    out_tracksIds.swap(tmp);
+  }
+}
+
+void TracksPerViewIndex::getCommonTracks(std::size_t viewId, const TrackIdBitset& tracksIds, std::vector<std::size_t>& out_tracksIds) const
+{
+  out_tracksIds.clear();
+
+  for(const std::size_t trackId : getTracks(viewId))
+  {
+    if(tracksIds.test(trackId))
+      out_tracksIds.push_back(trackId);
+  }
+}
+
+void TracksPerViewIndex::getTracksInViews(const std::set<IndexT>& viewIds, std::vector<std::size_t>& out_tracksIds) const
+{
+  out_tracksIds.clear();
+
+  // mark the visible tracks in a bitset, output is sorted
+  TrackIdBitset visibleTracks(_nbTracks);
+  std::size_t nbObservations = 0;
+  for(const IndexT viewId : viewIds)
+  {
+    for(const std::size_t trackId : getTracks(viewId))
+    {
+      visibleTracks.set(trackId);
+      ++nbObservations;
+    }
+  }
+
+  out_tracksIds.reserve(nbObservations);
+  const std::vector<std::uint64_t>& words = visibleTracks.getWords();
+  for(std::size_t w = 0; w < words.size(); ++w)
+  {
+    std::uint64_t word = words[w];
+    while(word)
+    {
+      const int bit = TrackIdBitset::lowestBit(word);
+      out_tracksIds.push_back(w * 64 + bit);
+      word &= word - 1;
+    }
+  }
+}
+
+} // namespace track
+} // namespace aliceVision
@@ -0,0 +1,195 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/track/Track.hpp>
+#include <aliceVision/feature/Hamming.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace aliceVision {
+namespace track {
+
+/**
+ * @brief Dense set of track ids stored as a bitset.
+ */
+class TrackIdBitset
+{
+public:
+  TrackIdBitset() = default;
+
+  explicit TrackIdBitset(std::size_t nbTracks)
+  {
+    resize(nbTracks);
+  }
+
+  inline void resize(std::size_t nbTracks)
+  {
+    _nbTracks = nbTracks;
+    _words.assign((nbTracks + 63) / 64, 0);
+  }
+
+  inline std::size_t size() const { return _nbTracks; }
+
+  inline void set(std::size_t trackId)
+  {
+    _words[trackId >> 6] |= (std::uint64_t(1) << (trackId & 63));
+  }
+
+  inline bool test(std::size_t trackId) const
+  {
+    return (trackId < _nbTracks) && ((_words[trackId >> 6] >> (trackId & 63)) & 1);
+  }
+
+  inline const std::vector<std::uint64_t>& getWords() const { return _words; }
+
+  /// number of set bits of a word
+  static inline std::size_t popcount(std::uint64_t word)
+  {
+    return feature::Hamming<unsigned char>::popcnt64(word);
+  }
+
+  /// index of the lowest set bit of a non-zero word
+  static inline int lowestBit(std::uint64_t word)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while(((word >> bit) & 1) == 0)
+      ++bit;
+    return bit;
+#endif
+  }
+
+private:
+  std::size_t _nbTracks = 0;
+  std::vector<std::uint64_t> _words;
+};
+
+/**
+ * @brief Contiguous range of sorted track ids.
+ */
+struct TrackIdRange
+{
+  const std::size_t* first = nullptr;
+  const std::size_t* last = nullptr;
+
+  inline const std::size_t* begin() const { return first; }
+  inline const std::size_t* end() const { return last; }
+  inline std::size_t size() const { return static_cast<std::size_t>(last - first); }
+  inline bool empty() const { return first == last; }
+};
+
+/**
+ * @brief Immutable index of the visible track ids per view.
+ *
+ * Track ids of all views are stored sorted in a single contiguous array (CSR layout).
+ * Views with a large number of tracks (dense views) also get a bitset
+ * to answer intersection queries in linear time of the other set.
+ * Sorted lists are intersected with a linear merge or a galloping search
+ * when the sizes are very different.
+ */
+class TracksPerViewIndex
+{
+public:
+
+  TracksPerViewIndex() = default;
+
+  /**
+   * @brief Build the index.
+   * @param[in] tracksPerView for each view the sorted ids of the visible tracks
+   * @param[in] denseViewRatio ratio of visible tracks (over all the tracks) from which a view gets a bitset
+   */
+  void build(const TracksPerView& tracksPerView, double denseViewRatio = 1.0 / 64.0);
+
+  /**
+   * @brief Clear the index.
+   */
+  void clear();
+
+  /**
+   * @brief Get the number of indexed tracks (maximum track id + 1).
+   */
+  inline std::size_t nbTracks() const { return _nbTracks; }
+
+  /**
+   * @brief Return true if the view is indexed.
+   */
+  bool hasView(std::size_t viewId) const;
+
+  /**
+   * @brief Get the sorted track ids visible in a view (empty if the view is not indexed).
+   */
+  TrackIdRange getTracks(std::size_t viewId) const;
+
+  /**
+   * @brief Return true if the view has a bitset.
+   */
+  bool isDenseView(std::size_t viewId) const;
+
+  /**
+   * @brief Count the tracks visible in both views.
+   */
+  std::size_t countCommonTracks(std::size_t viewIdA, std::size_t viewIdB) const;
+
+  /**
+   * @brief Get the tracks visible in all the given views.
+   * @param[in] viewIds the views
+   * @param[out] out_tracksIds the sorted common track ids
+   */
+  void getCommonTracks(const std::set<std::size_t>& viewIds, std::vector<std::size_t>& out_tracksIds) const;
+
+  /**
+   * @brief Get the tracks of a view which are in the given track set.
+   * @param[in] viewId the view
+   * @param[in] tracksIds the track set
+   * @param[out] out_tracksIds the sorted common track ids
+   */
+  void getCommonTracks(std::size_t viewId, const TrackIdBitset& tracksIds, std::vector<std::size_t>& out_tracksIds) const;
+
+  /**
+   * @brief Get all the tracks visible in at least one of the given views.
+   * @param[in] viewIds the views
+   * @param[out] out_tracksIds the sorted track ids
+   */
+  void getTracksInViews(const std::set<IndexT>& viewIds, std::vector<std::size_t>& out_tracksIds) const;
+
+private:
+
+  /// return the index of the view in _viewIds (or _viewIds.size() if not indexed)
+  std::size_t getViewIndex(std::size_t viewId) const;
+
+  /// intersect the sorted track ids of a range with the tracks of an indexed view
+  void intersect(const TrackIdRange& range, std::size_t viewIndex, std::vector<std::size_t>& out_tracksIds) const;
+
+  std::size_t _nbTracks = 0;
+  /// sorted view ids
+  std::vector<std::size_t> _viewIds;
+  /// track ids offset per view (size: nbViews + 1)
+  std::vector<std::size_t> _offsets;
+  /// sorted track ids of all views
+  std::vector<std::size_t> _trackIds;
+  /// bitset index per view in _bitsets (or -1 if not dense)
+  std::vector<int> _bitsetIndexes;
+  std::vector<TrackIdBitset> _bitsets;
+};
+
+/**
+ * @brief Intersect two sorted lists of track ids
+ *        (linear merge or galloping search when the sizes are very different).
+ * @param[in] a first sorted range
+ * @param[in] b second sorted range
+ * @param[out] out_tracksIds the sorted common track ids (appended)
+ */
+void intersectSortedTrackIds(const TrackIdRange& a, const TrackIdRange& b, std::vector<std::size_t>& out_tracksIds);
+
+} // namespace track
+} // namespace aliceVision
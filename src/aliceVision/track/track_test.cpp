@@ -6,17 +6,21 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/track/TracksBuilder.hpp"
+#include "aliceVision/track/FlatTracksBuilder.hpp"
+#include "aliceVision/track/TracksPerViewIndex.hpp"
 #include "aliceVision/track/tracksUtils.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
 
 #include <vector>
 #include <utility>
+#include <random>
 
 #define BOOST_TEST_MODULE Track
 
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 
+using namespace aliceVision;
 using namespace aliceVision::feature;
 using namespace aliceVision::track;
 using namespace aliceVision::matching;
@@ -180,6 +184,127 @@ BOOST_AUTO_TEST_CASE(Track_Conflict) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(FlatTrack_Conflict) {
+
+  //
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //{2 -> 3 -> 2
+  //      3 -> 8 } This track must be deleted, index 3 appears two times
+  //
+
+  // Create the input pairwise correspondences
+  PairwiseMatches map_pairwisematches;
+
+  const IndMatch testAB[] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+  const IndMatch testBC[] = {IndMatch(0,0), IndMatch(1,6), IndMatch(3,2), IndMatch(3,8)};
+
+  std::vector<IndMatch> ab(testAB, testAB+3);
+  std::vector<IndMatch> bc(testBC, testBC+4);
+  const int A = 0;
+  const int B = 1;
+  const int C = 2;
+  map_pairwisematches[ std::make_pair(A,B) ][EImageDescriberType::UNKNOWN] = ab;
+  map_pairwisematches[ std::make_pair(B,C) ][EImageDescriberType::UNKNOWN] = bc;
+
+  //-- Build tracks using the flat tracks builder
+  FlatTracksBuilder trackBuilder;
+  trackBuilder.build( map_pairwisematches );
+
+  BOOST_CHECK_EQUAL(3, trackBuilder.nbTracks());
+  trackBuilder.filter(true, 2); // Key feature tested here to kill the conflicted track
+  BOOST_CHECK_EQUAL(2, trackBuilder.nbTracks());
+
+  // CSR layout
+  const FlatTracks& flatTracks = trackBuilder.getTracks();
+  BOOST_CHECK_EQUAL(6, flatTracks.nbObservations());
+  BOOST_CHECK_EQUAL(3, flatTracks.trackLength(0));
+  BOOST_CHECK_EQUAL(3, flatTracks.trackLength(1));
+
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+
+  //-------------------
+  // Unit Test check
+  //-------------------
+
+  //0, {(0,0) (1,0) (2,0)}
+  //1, {(0,1) (1,1) (2,6)}
+  const std::pair<std::size_t,std::size_t> GT_Tracks[] =
+    {std::make_pair(0,0), std::make_pair(1,0), std::make_pair(2,0),
+     std::make_pair(0,1), std::make_pair(1,1), std::make_pair(2,6)};
+
+  BOOST_CHECK_EQUAL(2,  map_tracks.size());
+  std::size_t cpt = 0, i = 0;
+  for (TracksMap::const_iterator iterT = map_tracks.begin();
+    iterT != map_tracks.end();
+    ++iterT, ++i)
+  {
+    BOOST_CHECK_EQUAL(i, iterT->first);
+    for (auto iter = iterT->second.featPerView.begin();
+      iter != iterT->second.featPerView.end();
+      ++iter)
+    {
+      BOOST_CHECK( GT_Tracks[cpt] == std::make_pair(iter->first, iter->second));
+      ++cpt;
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FlatTrack_SameAsTracksBuilder) {
+
+  // random matches between 10 views with 2 describer types
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<IndexT> featDistribution(0, 200);
+
+  PairwiseMatches map_pairwisematches;
+  for(IndexT I = 0; I < 10; ++I)
+  {
+    for(IndexT J = I + 1; J < 10; ++J)
+    {
+      for(EImageDescriberType descType : {EImageDescriberType::SIFT, EImageDescriberType::AKAZE})
+      {
+        IndMatches& matches = map_pairwisematches[std::make_pair(I, J)][descType];
+        for(int m = 0; m < 50; ++m)
+          matches.emplace_back(featDistribution(randomNumberGenerator), featDistribution(randomNumberGenerator));
+      }
+    }
+  }
+
+  for(const bool clearForks : {true, false})
+  {
+    TracksBuilder trackBuilder;
+    trackBuilder.build(map_pairwisematches);
+    trackBuilder.filter(clearForks, 3);
+
+    FlatTracksBuilder flatTrackBuilder;
+    flatTrackBuilder.build(map_pairwisematches);
+    flatTrackBuilder.filter(clearForks, 3);
+
+    BOOST_CHECK_EQUAL(trackBuilder.nbTracks(), flatTrackBuilder.nbTracks());
+
+    TracksMap map_tracks;
+    TracksMap map_flatTracks;
+    trackBuilder.exportToSTL(map_tracks);
+    flatTrackBuilder.exportToSTL(map_flatTracks);
+
+    // tracks ids may differ, compare the sets of tracks
+    std::set<std::pair<EImageDescriberType, std::vector<std::pair<std::size_t, std::size_t>>>> tracks;
+    std::set<std::pair<EImageDescriberType, std::vector<std::pair<std::size_t, std::size_t>>>> flatTracks;
+
+    if(clearForks)
+    {
+      for(const auto& trackIt : map_tracks)
+        tracks.emplace(trackIt.second.descType, std::vector<std::pair<std::size_t, std::size_t>>(trackIt.second.featPerView.begin(), trackIt.second.featPerView.end()));
+      for(const auto& trackIt : map_flatTracks)
+        flatTracks.emplace(trackIt.second.descType, std::vector<std::pair<std::size_t, std::size_t>>(trackIt.second.featPerView.begin(), trackIt.second.featPerView.end()));
+
+      BOOST_CHECK(tracks == flatTracks);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
 {
   {
@@ -228,3 +353,104 @@ BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
     BOOST_CHECK_EQUAL(base.size(), set_visibleTracks.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(TracksPerViewIndex_SameAsTracksPerView)
+{
+  std::mt19937 randomNumberGenerator(42);
+  const std::size_t nbTracks = 5000;
+
+  // views with different densities (sparse views use merge / galloping, dense views use bitsets)
+  TracksPerView map_tracksPerView;
+  const std::vector<double> densities = {0.001, 0.005, 0.05, 0.3, 0.6, 0.9};
+  for(std::size_t viewId = 0; viewId < densities.size(); ++viewId)
+  {
+    std::bernoulli_distribution visible(densities[viewId]);
+    TrackIdSet& tracksIds = map_tracksPerView[viewId * 10];
+    for(std::size_t trackId = 0; trackId < nbTracks; ++trackId)
+    {
+      if(visible(randomNumberGenerator))
+        tracksIds.push_back(trackId);
+    }
+  }
+  // view without tracks
+  map_tracksPerView[100];
+
+  TracksPerViewIndex index;
+  index.build(map_tracksPerView);
+  TracksPerViewIndex sparseIndex;
+  sparseIndex.build(map_tracksPerView, 2.0);
+
+  BOOST_CHECK(index.hasView(100));
+  BOOST_CHECK(!index.hasView(7));
+  BOOST_CHECK(index.getTracks(7).empty());
+  BOOST_CHECK(index.getTracks(100).empty());
+  BOOST_CHECK(!index.isDenseView(0));
+  BOOST_CHECK(index.isDenseView(50));
+
+  for(const auto& viewTracks : map_tracksPerView)
+  {
+    const TrackIdRange range = index.getTracks(viewTracks.first);
+    BOOST_CHECK(std::equal(range.begin(), range.end(), viewTracks.second.begin(), viewTracks.second.end()));
+  }
+
+  // pairs and triplets of views
+  std::vector<std::set<std::size_t>> viewSets;
+  for(const auto& a : map_tracksPerView)
+  {
+    for(const auto& b : map_tracksPerView)
+    {
+      if(a.first < b.first)
+        viewSets.push_back({a.first, b.first});
+    }
+  }
+  viewSets.push_back({0, 20, 50});
+  viewSets.push_back({30, 40, 50});
+  viewSets.push_back({10, 40, 7});
+
+  for(const std::set<std::size_t>& viewIds : viewSets)
+  {
+    std::set<std::size_t> expected;
+    getCommonTracksInImages(viewIds, map_tracksPerView, expected);
+
+    std::vector<std::size_t> commonTracks;
+    index.getCommonTracks(viewIds, commonTracks);
+    BOOST_CHECK(std::equal(commonTracks.begin(), commonTracks.end(), expected.begin(), expected.end()));
+
+    if(viewIds.size() == 2)
+      BOOST_CHECK_EQUAL(index.countCommonTracks(*viewIds.begin(), *viewIds.rbegin()), expected.size());
+
+    // without bitsets: sorted lists intersection only
+    std::vector<std::size_t> sparseCommonTracks;
+    sparseIndex.getCommonTracks(viewIds, sparseCommonTracks);
+    BOOST_CHECK(sparseCommonTracks == commonTracks);
+  }
+
+  // intersection with a set of tracks
+  TrackIdBitset reconstructedTracks(nbTracks);
+  std::set<std::size_t> reconstructedTracksSet;
+  for(std::size_t trackId = 0; trackId < nbTracks; trackId += 3)
+  {
+    reconstructedTracks.set(trackId);
+    reconstructedTracksSet.insert(trackId);
+  }
+  for(const auto& viewTracks : map_tracksPerView)
+  {
+    std::vector<std::size_t> expected;
+    std::set_intersection(viewTracks.second.begin(), viewTracks.second.end(),
+                          reconstructedTracksSet.begin(), reconstructedTracksSet.end(),
+                          std::back_inserter(expected));
+    std::vector<std::size_t> commonTracks;
+    index.getCommonTracks(viewTracks.first, reconstructedTracks, commonTracks);
+    BOOST_CHECK(commonTracks == expected);
+  }
+
+  // union of views
+  {
+    const std::set<aliceVision::IndexT> viewIds = {0, 10, 20, 7};
+    std::set<aliceVision::IndexT> expected;
+    getTracksInImagesFast(viewIds, map_tracksPerView, expected);
+    std::set<aliceVision::IndexT> tracksIds;
+    getTracksInImagesFast(viewIds, index, tracksIds);
+    BOOST_CHECK(tracksIds == expected);
+  }
+}
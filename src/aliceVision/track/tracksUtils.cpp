@@ -120,6 +120,39 @@ bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
   return !tracksOut.empty();
 }
 
+bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
+                                 const TracksMap& tracksIn,
+                                 const TracksPerViewIndex& tracksPerViewIndex,
+                                 TracksMap& tracksOut)
+{
+  assert(!imageIndexes.empty());
+  tracksOut.clear();
+
+  std::vector<std::size_t> visibleTracks;
+  tracksPerViewIndex.getCommonTracks(imageIndexes, visibleTracks);
+  tracksOut.reserve(visibleTracks.size());
+
+  // go along the tracks (sorted by id)
+  for(std::size_t visibleTrack: visibleTracks)
+  {
+    TracksMap::const_iterator itTrackIn = tracksIn.find(visibleTrack);
+    if(itTrackIn == tracksIn.end())
+      continue;
+    const Track& trackFeatsIn = itTrackIn->second;
+    Track& trackFeatsOut = tracksOut.emplace_hint(tracksOut.end(), visibleTrack, Track())->second;
+    trackFeatsOut.descType = trackFeatsIn.descType;
+    trackFeatsOut.featPerView.reserve(imageIndexes.size());
+    for(std::size_t imageIndex: imageIndexes)
+    {
+      const auto trackFeatsInIt = trackFeatsIn.featPerView.find(imageIndex);
+      if(trackFeatsInIt != trackFeatsIn.featPerView.end())
+        trackFeatsOut.featPerView.emplace_hint(trackFeatsOut.featPerView.end(), imageIndex, trackFeatsInIt->second);
+    }
+    assert(trackFeatsOut.featPerView.size() == imageIndexes.size());
+  }
+  return !tracksOut.empty();
+}
+
 void getTracksInImages(const std::set<std::size_t>& imagesId,
                        const TracksMap& tracks,
                        std::set<std::size_t>& tracksId)
@@ -146,6 +179,19 @@ void getTracksInImagesFast(const std::set<IndexT>& imagesId,
   }
 }
 
+void getTracksInImagesFast(const std::set<IndexT>& imagesId,
+                           const TracksPerViewIndex& tracksPerViewIndex,
+                           std::set<IndexT>& tracksIds)
+{
+  std::vector<std::size_t> visibleTracks;
+  tracksPerViewIndex.getTracksInViews(imagesId, visibleTracks);
+
+  tracksIds.clear();
+  // sorted input: constant time insertion at the end
+  for(const std::size_t trackId : visibleTracks)
+    tracksIds.insert(tracksIds.end(), static_cast<IndexT>(trackId));
+}
+
 void getTracksInImage(const std::size_t& imageIndex,
                              const TracksMap& tracks,
                              std::set<std::size_t>& tracksIds)
@@ -7,6 +7,7 @@
 
 #pragma once
 #include <aliceVision/track/Track.hpp>
+#include <aliceVision/track/TracksPerViewIndex.hpp>
 
 
 namespace aliceVision {
@@ -43,6 +44,18 @@ bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
                                           const TracksMap& tracksIn,
                                           const TracksPerView& tracksPerView,
                                           TracksMap& tracksOut);
+
+/**
+ * @brief Find common tracks among images.
+ * @param[in] imageIndexes: set of images we are looking for common tracks.
+ * @param[in] tracksIn: all tracks of the scene.
+ * @param[in] tracksPerViewIndex: index of the visible tracks per view.
+ * @param[out] tracksOut: output with only the common tracks.
+ */
+bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
+                                 const TracksMap& tracksIn,
+                                 const TracksPerViewIndex& tracksPerViewIndex,
+                                 TracksMap& tracksOut);
   
 /**
  * @brief Find all the visible tracks from a set of images.
@@ -64,6 +77,16 @@ void getTracksInImagesFast(const std::set<IndexT>& imagesId,
                                   const TracksPerView& tracksPerView,
                                   std::set<IndexT>& tracksIds);
 
+/**
+ * @brief Find all the visible tracks from a set of images.
+ * @param[in] imagesId set of images we are looking for tracks.
+ * @param[in] tracksPerViewIndex index of the visible tracks per view.
+ * @param[out] tracksId the tracks in the images
+ */
+void getTracksInImagesFast(const std::set<IndexT>& imagesId,
+                           const TracksPerViewIndex& tracksPerViewIndex,
+                           std::set<IndexT>& tracksIds);
+
 /**
  * @brief Find all the visible tracks from a single image.
  * @param[in] imageIndex of the image we are looking for tracks.
@@ -5,9 +5,9 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Database.hpp"
-#include <aliceVision/system/ProgressDisplay.hpp>
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/tail.hpp>
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <stdexcept>
@@ -46,17 +46,25 @@ DocId Database::insert(DocId doc_id, const SparseHistogram& document)
   // Ensure that the new document to insert is not already there.
   assert(database_.find(doc_id) == database_.end());
 
+  // documents are indexed by insertion order, so the inverted files stay sorted
+  const uint32_t docIndex = static_cast<uint32_t>(doc_ids_.size());
+  uint32_t nbFeatures = 0;
+
   // For each word, retrieve its inverted file and increment the count for doc_id.
   for(SparseHistogram::const_iterator it = document.begin(), end = document.end(); it != end; ++it)
   {
     Word word = it->first;
     InvertedFile& file = word_files_[word];
-    if(file.empty() || file.back().id != doc_id)
-      file.push_back(WordFrequency(doc_id, it->second.size()));
+    if(file.empty() || file.back().docIndex != docIndex)
+      file.push_back(WordFrequency(docIndex, it->second.size()));
     else
       file.back().count += it->second.size();
+    nbFeatures += it->second.size();
   }
 
+  doc_ids_.push_back(doc_id);
+  doc_nb_features_.push_back(nbFeatures);
+  doc_indexes_[doc_id] = docIndex;
   database_[doc_id] = document;
 
   return doc_id;
@@ -78,19 +86,18 @@ void Database::sanityCheck(std::size_t N, std::map<std::size_t, DocMatches>& mat
   }
 
   matches.clear();
-  // since we already know the size of the vectors, in order to parallelize the 
-  // query allocate the whole memory
-  auto display = system::createConsoleProgressDisplay(database_.size(), std::cout);
-  
-  //#pragma omp parallel for default(none) shared(database_)
+
+  std::vector<const SparseHistogram*> queries;
+  queries.reserve(database_.size());
   for(const auto &doc : database_)
-  {
-    std::vector<DocMatch> m;
-    find(doc.second, N, m);
-    //		matches.emplace_back( m );
-    matches[doc.first] = m;
-    ++display;
-  }
+    queries.push_back(&doc.second);
+
+  std::vector<DocMatches> queriesMatches;
+  find(queries, N, queriesMatches);
+
+  std::size_t i = 0;
+  for(const auto &doc : database_)
+    matches[doc.first] = std::move(queriesMatches[i++]);
 }
 
 /**
@@ -121,18 +128,186 @@ void Database::find(const std::vector<Word>& document, std::size_t N, std::vecto
  */
 void Database::find( const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
 {
-    matches.clear();
-    matches.reserve(database_.size());
-    for(const auto& document : database_)
+  QueryScores queryScores;
+  find(query, N, matches, parseDistanceMethod(distanceMethod), queryScores);
+}
+
+/**
+ * @brief Find the top N matches in the database for several query documents, in parallel.
+ *
+ * @param[in]  queries The query documents, sets of quantized words.
+ * @param[in]  N        The number of matches to return for each query.
+ * @param[out] matches  IDs and scores for the top N matching database documents of each query.
+ * @param[in] distanceMethod the method used to compute distance between histograms.
+ */
+void Database::find(const std::vector<const SparseHistogram*>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod) const
+{
+  const EDistanceMethod method = parseDistanceMethod(distanceMethod);
+
+  matches.clear();
+  matches.resize(queries.size());
+
+  #pragma omp parallel
+  {
+    // scores buffer of the thread, reused for all its queries
+    QueryScores queryScores;
+
+    #pragma omp for schedule(dynamic)
+    for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(queries.size()); ++i)
     {
-        // for each document/image in the database compute the distance between the
-        // histograms of the query image and the others
-        const float distance = sparseDistance(query, document.second, distanceMethod, word_weights_);
-        matches.emplace_back(document.first, distance);
+      find(*queries[i], N, matches[i], method, queryScores);
     }
-    const std::size_t nMatches = std::min(N, matches.size());
-    std::partial_sort(matches.begin(), matches.begin() + nMatches, matches.end());
+  }
+}
+
+Database::EDistanceMethod Database::parseDistanceMethod(const std::string& distanceMethod)
+{
+  if(distanceMethod == "classic")
+    return EDistanceMethod::CLASSIC;
+  if(distanceMethod == "commonPoints")
+    return EDistanceMethod::COMMON_POINTS;
+  if(distanceMethod == "strongCommonPoints")
+    return EDistanceMethod::STRONG_COMMON_POINTS;
+  if(distanceMethod == "weightedStrongCommonPoints")
+    return EDistanceMethod::WEIGHTED_STRONG_COMMON_POINTS;
+  if(distanceMethod == "inversedWeightedCommonPoints")
+    return EDistanceMethod::INVERSED_WEIGHTED_COMMON_POINTS;
+  throw std::invalid_argument("distanceMethod: " + distanceMethod + " is not valid.");
+}
+
+/**
+ * @brief Find the top N matches in the database for the query document, with the inverted files.
+ *
+ * The scores are accumulated only for the documents in the inverted files of the query words,
+ * the other documents have no common word with the query.
+ * Matches with the same score are sorted by document id.
+ *
+ * @param[in] query The query document
+ * @param[in] N The number of matches to return.
+ * @param[out] matches IDs and scores for the top N matching database documents.
+ * @param[in] distanceMethod the method used to compute distance between histograms.
+ * @param[in,out] queryScores temporary scores buffer, left cleared
+ */
+void Database::find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, EDistanceMethod distanceMethod, QueryScores& queryScores) const
+{
+  matches.clear();
+
+  const std::size_t nbDocuments = doc_ids_.size();
+  const std::size_t nMatches = std::min(N, nbDocuments);
+
+  const auto sortMatches = [&]()
+  {
+    std::partial_sort(matches.begin(), matches.begin() + nMatches, matches.end(), [](const DocMatch& a, const DocMatch& b) {
+      return (a.score != b.score) ? (a.score < b.score) : (a.id < b.id);
+    });
     matches.resize(nMatches);
+  };
+
+  if(nMatches == 0)
+    return;
+
+  if(distanceMethod == EDistanceMethod::WEIGHTED_STRONG_COMMON_POINTS)
+  {
+    // not expressed with the inverted files, compare to all the documents
+    matches.reserve(nbDocuments);
+    for(const auto& document : database_)
+      matches.emplace_back(document.first, sparseDistance(query, document.second, "weightedStrongCommonPoints", word_weights_));
+    sortMatches();
+    return;
+  }
+
+  std::vector<float>& scores = queryScores.scores;
+  std::vector<uint8_t>& isTouched = queryScores.isTouched;
+  std::vector<uint32_t>& touched = queryScores.touched;
+
+  if(scores.size() != nbDocuments)
+  {
+    scores.assign(nbDocuments, 0.0f);
+    isTouched.assign(nbDocuments, 0);
+  }
+
+  // accumulate the scores of the documents in the inverted files of the query words
+  std::size_t nbQueryFeatures = 0;
+
+  for(const auto& word : query)
+  {
+    const std::size_t queryCount = word.second.size();
+    nbQueryFeatures += queryCount;
+
+    if(word.first >= word_files_.size())
+      continue;
+
+    // only the words seen once in both documents
+    if(distanceMethod == EDistanceMethod::STRONG_COMMON_POINTS && queryCount != 1)
+      continue;
+
+    const float weight = word_weights_[word.first];
+
+    for(const WordFrequency& posting : word_files_[word.first])
+    {
+      if(!isTouched[posting.docIndex])
+      {
+        isTouched[posting.docIndex] = 1;
+        touched.push_back(posting.docIndex);
+      }
+
+      const std::size_t minCount = std::min<std::size_t>(queryCount, posting.count);
+
+      switch(distanceMethod)
+      {
+        case EDistanceMethod::CLASSIC:
+        case EDistanceMethod::COMMON_POINTS:
+          scores[posting.docIndex] += minCount;
+          break;
+        case EDistanceMethod::STRONG_COMMON_POINTS:
+          if(posting.count == 1)
+            scores[posting.docIndex] += 1.0f;
+          break;
+        case EDistanceMethod::INVERSED_WEIGHTED_COMMON_POINTS:
+          scores[posting.docIndex] += (1.f / minCount) * weight;
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  if(distanceMethod == EDistanceMethod::CLASSIC)
+  {
+    // L1 distance: |Q| + |D| - 2 * sum(min), depends on the size of all the documents
+    matches.reserve(nbDocuments);
+    for(const auto& docIndex : doc_indexes_)
+    {
+      const float distance = static_cast<float>(nbQueryFeatures + doc_nb_features_[docIndex.second]) - 2.0f * scores[docIndex.second];
+      matches.emplace_back(docIndex.first, distance);
+    }
+  }
+  else
+  {
+    matches.reserve(touched.size() + nMatches);
+    for(const uint32_t docIndex : touched)
+    {
+      if(scores[docIndex] > 0.0f)
+        matches.emplace_back(doc_ids_[docIndex], -scores[docIndex]);
+    }
+
+    // complete with the documents without score, by increasing id
+    for(auto it = doc_indexes_.begin(); matches.size() < nMatches && it != doc_indexes_.end(); ++it)
+    {
+      if(!(scores[it->second] > 0.0f))
+        matches.emplace_back(it->first, -0.0f);
+    }
+  }
+
+  // reset the scores of the touched documents for the next query
+  for(const uint32_t docIndex : touched)
+  {
+    scores[docIndex] = 0.0f;
+    isTouched[docIndex] = 0;
+  }
+  touched.clear();
+
+  sortMatches();
 }
 
 /**
@@ -183,6 +358,92 @@ void Database::loadWeights(const std::string& file)
   }
 }
 
+void Database::save(const std::string& file) const
+{
+  std::ofstream out(file, std::ios_base::binary);
+  if(!out.is_open())
+    throw std::runtime_error((boost::format("Failed to open vocabulary database file '%s' for writing") % file).str());
+  save(out);
+  if(!out.good())
+    throw std::runtime_error((boost::format("Failed to write vocabulary database file '%s'") % file).str());
+}
+
+void Database::load(const std::string& file)
+{
+  std::ifstream in;
+  in.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
+
+  try
+  {
+    in.open(file, std::ios_base::binary);
+    load(in);
+  }
+  catch(std::ifstream::failure& e)
+  {
+    throw std::runtime_error((boost::format("Failed to load vocabulary database file '%s'") % file).str());
+  }
+}
+
+void Database::save(std::ostream& out) const
+{
+  const uint32_t num_words = word_weights_.size();
+  out.write((const char*) (&num_words), sizeof (uint32_t));
+  out.write((const char*) (word_weights_.data()), num_words * sizeof (float));
+
+  // documents in insertion order
+  const uint32_t num_documents = doc_ids_.size();
+  out.write((const char*) (&num_documents), sizeof (uint32_t));
+  for(const DocId doc_id : doc_ids_)
+  {
+    const SparseHistogram& document = database_.at(doc_id);
+    const uint32_t doc_words = document.size();
+    out.write((const char*) (&doc_id), sizeof (DocId));
+    out.write((const char*) (&doc_words), sizeof (uint32_t));
+    for(const auto& word : document)
+    {
+      const uint32_t num_features = word.second.size();
+      out.write((const char*) (&word.first), sizeof (Word));
+      out.write((const char*) (&num_features), sizeof (uint32_t));
+      out.write((const char*) (word.second.data()), num_features * sizeof (IndexT));
+    }
+  }
+}
+
+void Database::load(std::istream& in)
+{
+  uint32_t num_words = 0;
+  in.read((char*) (&num_words), sizeof (uint32_t));
+
+  *this = Database(num_words);
+  in.read((char*) (word_weights_.data()), num_words * sizeof (float));
+
+  uint32_t num_documents = 0;
+  in.read((char*) (&num_documents), sizeof (uint32_t));
+  for(uint32_t i = 0; i < num_documents; ++i)
+  {
+    DocId doc_id = UndefinedIndexT;
+    uint32_t doc_words = 0;
+    in.read((char*) (&doc_id), sizeof (DocId));
+    in.read((char*) (&doc_words), sizeof (uint32_t));
+
+    SparseHistogram document;
+    for(uint32_t w = 0; w < doc_words; ++w)
+    {
+      Word word = 0;
+      uint32_t num_features = 0;
+      in.read((char*) (&word), sizeof (Word));
+      in.read((char*) (&num_features), sizeof (uint32_t));
+      if(!in || word < 0 || static_cast<uint32_t>(word) >= num_words)
+        throw std::runtime_error("Invalid vocabulary database: word out of range.");
+
+      std::vector<IndexT>& features = document[word];
+      features.resize(num_features);
+      in.read((char*) (features.data()), num_features * sizeof (IndexT));
+    }
+    insert(doc_id, document);
+  }
+}
+
 ///**
 // * Normalize a document vector representing the histogram of visual words for a given image
 // * 
@@ -11,6 +11,7 @@
 
 #include <map>
 #include <cstddef>
+#include <iosfwd>
 #include <string>
 
 namespace aliceVision{
@@ -56,6 +57,10 @@ std::ostream& operator<<(std::ostream& os, const DocMatches& matches);
 /**
  * @brief Class for efficiently matching a bag-of-words representation of a document (image) against
  * a database of known documents.
+ *
+ * The documents are indexed in an inverted file: for each word, the sorted list of the documents
+ * containing it, with the number of occurrences. A query only visits the documents which have
+ * at least one word in common with it (posting list traversal), instead of all the documents.
  */
 class Database
 {
@@ -106,6 +111,16 @@ public:
    */
   void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
 
+  /**
+   * @brief Find the top N matches in the database for several query documents, in parallel.
+   *
+   * @param[in] queries The query documents, sets of quantized words.
+   * @param[in] N        The number of matches to return for each query.
+   * @param[out] matches  IDs and scores for the top N matching database documents of each query.
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void find(const std::vector<const SparseHistogram*>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
    * training examples into the database.
@@ -125,32 +140,67 @@ public:
   /// Load the vocabulary word weights from a file.
   void loadWeights(const std::string& file);
 
-  // Save weights and documents
-  //void save(const std::string& file) const;
-  //void load(const std::string& file);
+  /**
+   * @brief Save the word weights and all the documents to a binary file.
+   *        Documents are saved in insertion order, so a loaded database gives the same query results.
+   */
+  void save(const std::string& file) const;
+  /// Load the word weights and the documents saved with save(), replacing the current content.
+  void load(const std::string& file);
+
+  /// Save the word weights and all the documents to a binary stream.
+  void save(std::ostream& out) const;
+  /// Load the word weights and the documents from a binary stream, replacing the current content.
+  void load(std::istream& in);
 
   const SparseHistogramPerImage& getSparseHistogramPerImage() const
   {
     return database_;
   }
+
+  const std::vector<float>& getWeights() const
+  {
+    return word_weights_;
+  }
   
 private:
 
   struct WordFrequency
   {
-    DocId id;
+    uint32_t docIndex;
     uint32_t count;
 
     WordFrequency() = default;
-    WordFrequency(DocId _id, uint32_t _count)
-      : id(_id)
+    WordFrequency(uint32_t _docIndex, uint32_t _count)
+      : docIndex(_docIndex)
       , count(_count)
     {}
   };
 
-  // Stored in increasing order by DocId
+  // Stored in increasing order by document index (insertion order)
   typedef std::vector<WordFrequency> InvertedFile;
 
+  enum class EDistanceMethod
+  {
+    CLASSIC,
+    COMMON_POINTS,
+    STRONG_COMMON_POINTS,
+    WEIGHTED_STRONG_COMMON_POINTS,
+    INVERSED_WEIGHTED_COMMON_POINTS
+  };
+
+  static EDistanceMethod parseDistanceMethod(const std::string& distanceMethod);
+
+  /// Temporary scores of the documents for a query, reused between the queries
+  struct QueryScores
+  {
+    std::vector<float> scores;
+    std::vector<uint8_t> isTouched;
+    std::vector<uint32_t> touched;
+  };
+
+  void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, EDistanceMethod distanceMethod, QueryScores& queryScores) const;
+
   /// @todo Use sorted vector?
   // typedef std::vector< std::pair<Word, float> > DocumentVector;
   
@@ -160,6 +210,13 @@ private:
   std::vector<float> word_weights_;
   SparseHistogramPerImage database_; // Precomputed for inserted documents
 
+  /// document ids, by document index
+  std::vector<DocId> doc_ids_;
+  /// number of features of each document, by document index
+  std::vector<uint32_t> doc_nb_features_;
+  /// document index of each document id
+  std::map<DocId, uint32_t> doc_indexes_;
+
   /**
    * Normalize a document vector representing the histogram of visual words for a given image
    * @param[in/out] v the unnormalized histogram of visual words
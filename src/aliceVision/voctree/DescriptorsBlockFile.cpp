@@ -0,0 +1,98 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DescriptorsBlockFile.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace voctree {
+
+namespace {
+
+/// descriptors block file signature
+const char blockFileSignature[] = "AVDESCB1";
+
+} // namespace
+
+DescriptorsBlockFile::DescriptorsBlockFile(const std::string& filename)
+  : _filename(filename)
+{
+  _stream.open(filename, std::ios::binary);
+  if(!_stream.is_open())
+    throw std::runtime_error("Unable to open the descriptors block file: " + filename);
+
+  char signature[sizeof(blockFileSignature)];
+  std::uint32_t dimension = 0;
+  std::uint64_t nbImages = 0;
+  _stream.read(signature, sizeof(signature));
+  _stream.read(reinterpret_cast<char*>(&dimension), sizeof(dimension));
+  _stream.read(reinterpret_cast<char*>(&nbImages), sizeof(nbImages));
+
+  if(!_stream || !std::equal(signature, signature + sizeof(signature), blockFileSignature) || dimension == 0)
+    throw std::runtime_error("Invalid descriptors block file: " + filename);
+
+  _dimension = dimension;
+  _imageIds.resize(nbImages);
+  _nbDescriptorsPerImage.resize(nbImages);
+  for(std::size_t i = 0; i < nbImages; ++i)
+  {
+    std::uint32_t imageId = 0;
+    std::uint64_t nbDescriptors = 0;
+    _stream.read(reinterpret_cast<char*>(&imageId), sizeof(imageId));
+    _stream.read(reinterpret_cast<char*>(&nbDescriptors), sizeof(nbDescriptors));
+    _imageIds[i] = imageId;
+    _nbDescriptorsPerImage[i] = nbDescriptors;
+    _size += nbDescriptors;
+  }
+  if(!_stream)
+    throw std::runtime_error("Invalid descriptors block file: " + filename);
+
+  _dataOffset = static_cast<std::size_t>(_stream.tellg());
+
+  const std::size_t expectedSize = _dataOffset + _size * _dimension;
+  if(boost::filesystem::file_size(filename) != expectedSize)
+    throw std::runtime_error("Invalid descriptors block file (truncated): " + filename);
+}
+
+void DescriptorsBlockFile::read(std::size_t first, std::size_t count, unsigned char* out_descriptors)
+{
+  if(first + count > _size)
+    throw std::out_of_range("Read out of the descriptors block file: " + _filename);
+
+  _stream.seekg(_dataOffset + first * _dimension);
+  _stream.read(reinterpret_cast<char*>(out_descriptors), count * _dimension);
+  if(!_stream)
+    throw std::runtime_error("Unable to read the descriptors block file: " + _filename);
+}
+
+void DescriptorsBlockFile::writeHeader(std::ostream& out, std::size_t dimension, const std::vector<IndexT>& imageIds,
+                                       const std::vector<std::size_t>& nbDescriptorsPerImage)
+{
+  const std::uint32_t dim = static_cast<std::uint32_t>(dimension);
+  const std::uint64_t nbImages = imageIds.size();
+  out.write(blockFileSignature, sizeof(blockFileSignature));
+  out.write(reinterpret_cast<const char*>(&dim), sizeof(dim));
+  out.write(reinterpret_cast<const char*>(&nbImages), sizeof(nbImages));
+  for(std::size_t i = 0; i < imageIds.size(); ++i)
+  {
+    const std::uint32_t imageId = imageIds[i];
+    const std::uint64_t nbDescriptors = nbDescriptorsPerImage[i];
+    out.write(reinterpret_cast<const char*>(&imageId), sizeof(imageId));
+    out.write(reinterpret_cast<const char*>(&nbDescriptors), sizeof(nbDescriptors));
+  }
+}
+
+void DescriptorsBlockFile::commit(const std::string& tmpFilename, const std::string& filename)
+{
+  boost::filesystem::rename(tmpFilename, filename);
+}
+
+} // namespace voctree
+} // namespace aliceVision
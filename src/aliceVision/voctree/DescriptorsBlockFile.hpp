@@ -0,0 +1,129 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace aliceVision {
+namespace voctree {
+
+/**
+ * @brief Contiguous file of the unsigned char descriptors of several images, read by blocks.
+ *
+ * Layout: signature, dimension, number of images, id and number of descriptors of each image,
+ * then all the descriptors (row-major, one byte per element).
+ * It allows to stream large training sets from disk instead of loading scattered descriptors in memory.
+ */
+class DescriptorsBlockFile
+{
+public:
+
+  /**
+   * @brief Open a descriptors block file.
+   * @param[in] filename the file path
+   * @note throw if the file cannot be read
+   */
+  explicit DescriptorsBlockFile(const std::string& filename);
+
+  /**
+   * @brief Concatenate the descriptors of each image (.desc files) in a descriptors block file.
+   *        The file is written under a temporary name and then renamed, so an existing file is always complete.
+   * @param[in] filename the output file path
+   * @param[in] descriptorsFiles the .desc file of each image
+   * @return the total number of descriptors
+   */
+  template<class FileDescriptorT>
+  static std::size_t write(const std::string& filename, const std::map<IndexT, std::string>& descriptorsFiles);
+
+  /// path of the file
+  inline const std::string& filename() const { return _filename; }
+  /// number of elements of a descriptor
+  inline std::size_t dimension() const { return _dimension; }
+  /// total number of descriptors
+  inline std::size_t size() const { return _size; }
+  /// id of each image
+  inline const std::vector<IndexT>& imageIds() const { return _imageIds; }
+  /// number of descriptors of each image (in file order)
+  inline const std::vector<std::size_t>& nbDescriptorsPerImage() const { return _nbDescriptorsPerImage; }
+  /// offset of the first descriptor in the file
+  inline std::size_t dataOffset() const { return _dataOffset; }
+
+  /**
+   * @brief Read contiguous descriptors.
+   * @param[in] first index of the first descriptor
+   * @param[in] count number of descriptors to read
+   * @param[out] out_descriptors buffer of count * dimension elements
+   */
+  void read(std::size_t first, std::size_t count, unsigned char* out_descriptors);
+
+private:
+
+  static void writeHeader(std::ostream& out, std::size_t dimension, const std::vector<IndexT>& imageIds,
+                          const std::vector<std::size_t>& nbDescriptorsPerImage);
+
+  static void commit(const std::string& tmpFilename, const std::string& filename);
+
+  std::string _filename;
+  std::ifstream _stream;
+  std::size_t _dimension = 0;
+  std::size_t _size = 0;
+  std::size_t _dataOffset = 0;
+  std::vector<IndexT> _imageIds;
+  std::vector<std::size_t> _nbDescriptorsPerImage;
+};
+
+template<class FileDescriptorT>
+std::size_t DescriptorsBlockFile::write(const std::string& filename, const std::map<IndexT, std::string>& descriptorsFiles)
+{
+  static_assert(std::is_same<typename FileDescriptorT::bin_type, unsigned char>::value, "Only unsigned char descriptors can be stored in a descriptors block file.");
+
+  const std::string tmpFilename = filename + ".tmp";
+  std::ofstream out(tmpFilename, std::ios::binary);
+  if(!out.is_open())
+    throw std::runtime_error("Unable to write the descriptors block file: " + tmpFilename);
+
+  // the number of descriptors per image is updated once all the descriptors are written
+  std::vector<IndexT> imageIds;
+  std::vector<std::size_t> nbDescriptorsPerImage(descriptorsFiles.size(), 0);
+  for(const auto& descriptorsFile : descriptorsFiles)
+    imageIds.push_back(descriptorsFile.first);
+
+  writeHeader(out, FileDescriptorT::static_size, imageIds, nbDescriptorsPerImage);
+
+  std::size_t nbDescriptors = 0;
+  std::vector<FileDescriptorT> descriptors;
+  std::size_t i = 0;
+  for(const auto& descriptorsFile : descriptorsFiles)
+  {
+    feature::loadDescsFromBinFile<FileDescriptorT, FileDescriptorT>(descriptorsFile.second, descriptors, false);
+    for(const FileDescriptorT& descriptor : descriptors)
+      out.write(reinterpret_cast<const char*>(descriptor.getData()), FileDescriptorT::static_size);
+    nbDescriptorsPerImage[i++] = descriptors.size();
+    nbDescriptors += descriptors.size();
+  }
+
+  out.seekp(0);
+  writeHeader(out, FileDescriptorT::static_size, imageIds, nbDescriptorsPerImage);
+  if(!out.good())
+    throw std::runtime_error("Unable to write the descriptors block file: " + tmpFilename);
+  out.close();
+
+  commit(tmpFilename, filename);
+  return nbDescriptors;
+}
+
+} // namespace voctree
+} // namespace aliceVision
@@ -0,0 +1,181 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "FlatVocabularyTree.hpp"
+
+#include <aliceVision/feature/distanceKernels.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace aliceVision {
+namespace voctree {
+
+namespace {
+
+/// number of descriptors quantized together
+const std::size_t quantizationBatchSize = 512;
+
+/**
+ * @brief Quantize a batch of descriptors, level by level.
+ * @param[in] tree the flat vocabulary tree
+ * @param[in] descriptors the batch of descriptors
+ * @param[in] nbDescriptors number of descriptors in the batch (<= quantizationBatchSize)
+ * @param[out] out_nodes the index of the leaf node of each descriptor
+ * @param[in,out] order, queries, distances temporary buffers
+ */
+template<typename Scalar>
+void quantizeBatch(const FlatVocabularyTree<Scalar>& tree, const Scalar* descriptors, std::size_t nbDescriptors, std::int32_t* out_nodes,
+                   std::vector<std::uint32_t>& order, std::vector<Scalar>& queries, std::vector<float>& distances)
+{
+  const std::size_t k = tree.splits;
+  const std::size_t dimension = tree.dimension;
+
+  order.resize(nbDescriptors);
+  queries.resize(nbDescriptors * dimension);
+  distances.resize(nbDescriptors * k);
+
+  for(std::size_t i = 0; i < nbDescriptors; ++i)
+  {
+    out_nodes[i] = -1; // virtual "root" index, which has no associated center.
+    order[i] = static_cast<std::uint32_t>(i);
+  }
+
+  for(std::uint32_t level = 0; level < tree.levels; ++level)
+  {
+    // group the descriptors by current node
+    if(level > 0)
+    {
+      std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return (out_nodes[a] != out_nodes[b]) ? (out_nodes[a] < out_nodes[b]) : (a < b);
+      });
+    }
+
+    for(std::size_t begin = 0; begin < nbDescriptors;)
+    {
+      const std::int32_t node = out_nodes[order[begin]];
+      std::size_t end = begin + 1;
+      while(end < nbDescriptors && out_nodes[order[end]] == node)
+        ++end;
+
+      const std::size_t nbQueries = end - begin;
+      const std::size_t firstChild = static_cast<std::size_t>(node + 1) * k;
+
+      // fewer than splits children
+      std::size_t nbChildren = 0;
+      while(nbChildren < k && tree.validCenters[firstChild + nbChildren])
+        ++nbChildren;
+
+      const Scalar* children = tree.centers + firstChild * dimension;
+
+      if(nbChildren == 0)
+      {
+        // keep the first child (as VocabularyTree::quantize)
+      }
+      else if(nbQueries == 1)
+      {
+        feature::squaredL2Distances(descriptors + order[begin] * dimension, children, nbChildren, dimension, distances.data());
+      }
+      else
+      {
+        for(std::size_t q = 0; q < nbQueries; ++q)
+          std::memcpy(queries.data() + q * dimension, descriptors + order[begin + q] * dimension, dimension * sizeof(Scalar));
+
+        feature::squaredL2DistancesBlock(queries.data(), nbQueries, children, nbChildren, dimension, distances.data());
+      }
+
+      for(std::size_t q = 0; q < nbQueries; ++q)
+      {
+        std::size_t bestChild = 0;
+        if(nbChildren > 0)
+        {
+          const float* queryDistances = distances.data() + q * nbChildren;
+          for(std::size_t c = 1; c < nbChildren; ++c)
+          {
+            if(queryDistances[c] < queryDistances[bestChild])
+              bestChild = c;
+          }
+        }
+        out_nodes[order[begin + q]] = static_cast<std::int32_t>(firstChild + bestChild);
+      }
+
+      begin = end;
+    }
+  }
+}
+
+template<typename Scalar>
+void quantizeFlatImpl(const FlatVocabularyTree<Scalar>& tree, const Scalar* descriptors, std::size_t nbDescriptors, std::int32_t* out_nodes)
+{
+  const std::ptrdiff_t nbBatches = static_cast<std::ptrdiff_t>((nbDescriptors + quantizationBatchSize - 1) / quantizationBatchSize);
+
+  #pragma omp parallel if(nbBatches > 1)
+  {
+    std::vector<std::uint32_t> order;
+    std::vector<Scalar> queries;
+    std::vector<float> distances;
+
+    #pragma omp for schedule(dynamic)
+    for(std::ptrdiff_t b = 0; b < nbBatches; ++b)
+    {
+      const std::size_t first = b * quantizationBatchSize;
+      const std::size_t size = std::min(quantizationBatchSize, nbDescriptors - first);
+      quantizeBatch(tree, descriptors + first * tree.dimension, size, out_nodes + first, order, queries, distances);
+    }
+  }
+}
+
+} // namespace
+
+void quantizeFlat(const FlatVocabularyTree<unsigned char>& tree, const unsigned char* descriptors, std::size_t nbDescriptors, std::int32_t* out_nodes)
+{
+  quantizeFlatImpl(tree, descriptors, nbDescriptors, out_nodes);
+}
+
+void quantizeFlat(const FlatVocabularyTree<float>& tree, const float* descriptors, std::size_t nbDescriptors, std::int32_t* out_nodes)
+{
+  quantizeFlatImpl(tree, descriptors, nbDescriptors, out_nodes);
+}
+
+struct TreeFileMapping::MappingImpl
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+TreeFileMapping::TreeFileMapping(const std::string& filename)
+  : mapping_(new MappingImpl)
+{
+  try
+  {
+    mapping_->file = boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+    mapping_->region = boost::interprocess::mapped_region(mapping_->file, boost::interprocess::read_only);
+  }
+  catch(const boost::interprocess::interprocess_exception& e)
+  {
+    throw std::runtime_error("Failed to map vocabulary tree file " + filename + ": " + e.what());
+  }
+}
+
+TreeFileMapping::~TreeFileMapping() = default;
+
+const char* TreeFileMapping::data() const
+{
+  return static_cast<const char*>(mapping_->region.get_address());
+}
+
+std::size_t TreeFileMapping::size() const
+{
+  return mapping_->region.get_size();
+}
+
+}
+}
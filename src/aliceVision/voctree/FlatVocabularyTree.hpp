@@ -0,0 +1,103 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/Descriptor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace aliceVision {
+namespace voctree {
+
+/**
+ * @brief Read-only flat layout of a vocabulary tree.
+ *
+ * The centers of all the nodes are stored contiguously, level by level, so the children
+ * of a node are a contiguous block of splits descriptors: the children of the node i
+ * (i = -1 for the virtual root) are the nodes [(i + 1) * splits, (i + 2) * splits).
+ * Children after the first invalid one are ignored (node with fewer than splits children).
+ */
+template<typename Scalar>
+struct FlatVocabularyTree
+{
+  /// centers of all the nodes (row-major, nbNodes x dimension)
+  const Scalar* centers = nullptr;
+  /// validity of all the nodes
+  const std::uint8_t* validCenters = nullptr;
+  std::size_t dimension = 0;
+  std::uint32_t splits = 0;
+  std::uint32_t levels = 0;
+};
+
+/**
+ * @brief Quantize descriptors into the leaves of a flat vocabulary tree, with the L2 distance.
+ *
+ * Descriptors are processed by batches (in parallel): at each level, the descriptors of a batch
+ * which reached the same node are compared to all its children at once with the SIMD distance kernels
+ * (see feature::squaredL2DistancesBlock), so the children are loaded only once for the whole group.
+ *
+ * @param[in] tree the flat vocabulary tree
+ * @param[in] descriptors the descriptors (row-major, nbDescriptors x dimension)
+ * @param[in] nbDescriptors number of descriptors
+ * @param[out] out_nodes the index of the leaf node of each descriptor
+ */
+void quantizeFlat(const FlatVocabularyTree<unsigned char>& tree, const unsigned char* descriptors, std::size_t nbDescriptors, std::int32_t* out_nodes);
+void quantizeFlat(const FlatVocabularyTree<float>& tree, const float* descriptors, std::size_t nbDescriptors, std::int32_t* out_nodes);
+
+/**
+ * @brief Traits of the descriptor types that can be used in place in a flat vocabulary tree:
+ *        unsigned char and float feature::Descriptor, without any padding.
+ */
+template<class Feature>
+struct FlatDescriptorTraits
+{
+  static constexpr bool value = false;
+};
+
+template<typename T, std::size_t N>
+struct FlatDescriptorTraits<feature::Descriptor<T, N>>
+{
+  using Scalar = T;
+  static constexpr std::size_t dimension = N;
+  static constexpr bool value = (std::is_same<T, unsigned char>::value || std::is_same<T, float>::value) &&
+                                (sizeof(feature::Descriptor<T, N>) == N * sizeof(T));
+};
+
+/**
+ * @brief Read-only memory mapping of a vocabulary tree file.
+ */
+class TreeFileMapping
+{
+public:
+
+  /**
+   * @brief Map the given file in memory.
+   * @param[in] filename the vocabulary tree file path
+   * @note throw if the file cannot be mapped
+   */
+  explicit TreeFileMapping(const std::string& filename);
+
+  ~TreeFileMapping();
+
+  // no copy
+  TreeFileMapping(const TreeFileMapping&) = delete;
+  TreeFileMapping& operator=(const TreeFileMapping&) = delete;
+
+  const char* data() const;
+  std::size_t size() const;
+
+private:
+  struct MappingImpl;
+  std::unique_ptr<MappingImpl> mapping_;
+};
+
+}
+}
@@ -0,0 +1,556 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MiniBatchTreeBuilder.hpp"
+#include "DescriptorsBlockFile.hpp"
+
+#include <aliceVision/feature/distanceKernels.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace voctree {
+
+namespace {
+
+namespace bfs = boost::filesystem;
+
+/// number of descriptors assigned together with the blocked distance kernel
+const std::size_t assignmentBlockSize = 256;
+
+/// number of contiguous descriptors read at each random position of a file
+const std::size_t samplingChunkSize = 64;
+
+/// index of the first child of a node (-1 for the root)
+inline std::int64_t firstChild(std::int64_t node, std::uint32_t k)
+{
+  return (node + 1) * static_cast<std::int64_t>(k);
+}
+
+/// round the float centers to unsigned char for the distance kernels
+void roundCenters(const float* centers, std::size_t size, unsigned char* out_centers)
+{
+  for(std::size_t i = 0; i < size; ++i)
+    out_centers[i] = static_cast<unsigned char>(std::min(255.f, std::max(0.f, std::round(centers[i]))));
+}
+
+/**
+ * @brief Assign each descriptor to its nearest center, by blocks of descriptors.
+ * @param[in] parallel parallelize over the blocks
+ */
+void assignToCenters(const unsigned char* descriptors, std::size_t nbDescriptors,
+                     const unsigned char* centers, std::size_t nbCenters, std::size_t dimension,
+                     std::uint32_t* out_assignments, bool parallel)
+{
+  const std::ptrdiff_t nbBlocks = static_cast<std::ptrdiff_t>((nbDescriptors + assignmentBlockSize - 1) / assignmentBlockSize);
+
+  #pragma omp parallel if(parallel && nbBlocks > 1)
+  {
+    std::vector<float> distances(assignmentBlockSize * nbCenters);
+
+    #pragma omp for schedule(static)
+    for(std::ptrdiff_t b = 0; b < nbBlocks; ++b)
+    {
+      const std::size_t first = b * assignmentBlockSize;
+      const std::size_t count = std::min(assignmentBlockSize, nbDescriptors - first);
+      feature::squaredL2DistancesBlock(descriptors + first * dimension, count, centers, nbCenters, dimension, distances.data());
+
+      for(std::size_t i = 0; i < count; ++i)
+      {
+        const float* descriptorDistances = distances.data() + i * nbCenters;
+        std::uint32_t nearest = 0;
+        for(std::size_t c = 1; c < nbCenters; ++c)
+        {
+          if(descriptorDistances[c] < descriptorDistances[nearest])
+            nearest = static_cast<std::uint32_t>(c);
+        }
+        out_assignments[first + i] = nearest;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Mini-batch k-means, initialized with k-means++ on a first sample.
+ * @param[in] drawSamples the sampler of the descriptors to cluster
+ * @param[out] out_centers the k centers (row-major, k x dimension)
+ */
+void miniBatchKmeans(const std::function<void(std::mt19937&, std::size_t, unsigned char*)>& drawSamples, std::size_t dimension, std::size_t k, const MiniBatchKmeansParams& params,
+                     std::mt19937& generator, bool parallel, float* out_centers)
+{
+  std::vector<unsigned char> centers(k * dimension);
+
+  // k-means++ initialization
+  {
+    const std::size_t nbSamples = std::max(params.batchSize, 4 * k);
+    std::vector<unsigned char> samples(nbSamples * dimension);
+    std::vector<float> minDistances(nbSamples, std::numeric_limits<float>::max());
+    std::vector<float> distances(nbSamples);
+    drawSamples(generator, nbSamples, samples.data());
+
+    std::size_t chosen = std::uniform_int_distribution<std::size_t>(0, nbSamples - 1)(generator);
+    for(std::size_t c = 0; c < k; ++c)
+    {
+      std::memcpy(centers.data() + c * dimension, samples.data() + chosen * dimension, dimension);
+      if(c + 1 == k)
+        break;
+
+      feature::squaredL2Distances(centers.data() + c * dimension, samples.data(), nbSamples, dimension, distances.data());
+      double sum = 0.0;
+      for(std::size_t i = 0; i < nbSamples; ++i)
+      {
+        minDistances[i] = std::min(minDistances[i], distances[i]);
+        sum += minDistances[i];
+      }
+
+      // next center with a probability proportional to the squared distance to the nearest center
+      if(sum <= 0.0)
+      {
+        chosen = std::uniform_int_distribution<std::size_t>(0, nbSamples - 1)(generator);
+        continue;
+      }
+      const double threshold = std::uniform_real_distribution<double>(0.0, sum)(generator);
+      double partialSum = 0.0;
+      chosen = nbSamples - 1;
+      for(std::size_t i = 0; i < nbSamples; ++i)
+      {
+        partialSum += minDistances[i];
+        if(partialSum >= threshold && minDistances[i] > 0.f)
+        {
+          chosen = i;
+          break;
+        }
+      }
+    }
+    std::copy(centers.begin(), centers.end(), out_centers);
+  }
+
+  // mini-batch iterations, with a per-center learning rate
+  std::vector<std::size_t> counts(k, 0);
+  std::vector<unsigned char> batch(params.batchSize * dimension);
+  std::vector<std::uint32_t> assignments(params.batchSize);
+
+  for(std::size_t iteration = 0; iteration < params.nbIterations; ++iteration)
+  {
+    drawSamples(generator, params.batchSize, batch.data());
+    roundCenters(out_centers, k * dimension, centers.data());
+    assignToCenters(batch.data(), params.batchSize, centers.data(), k, dimension, assignments.data(), parallel);
+
+    for(std::size_t i = 0; i < params.batchSize; ++i)
+    {
+      const std::uint32_t c = assignments[i];
+      const float learningRate = 1.f / static_cast<float>(++counts[c]);
+      float* center = out_centers + c * dimension;
+      const unsigned char* descriptor = batch.data() + i * dimension;
+      for(std::size_t d = 0; d < dimension; ++d)
+        center[d] += learningRate * (static_cast<float>(descriptor[d]) - center[d]);
+    }
+  }
+}
+
+/// random generator of a node, independent of the processing order
+std::mt19937 nodeGenerator(unsigned int seed, std::int64_t node)
+{
+  const std::uint64_t index = static_cast<std::uint64_t>(node + 1);
+  std::seed_seq seq{seed, static_cast<unsigned int>(index & 0xFFFFFFFF), static_cast<unsigned int>(index >> 32)};
+  return std::mt19937(seq);
+}
+
+std::string nodeName(std::int64_t node)
+{
+  return (node < 0) ? std::string("root") : std::to_string(node);
+}
+
+std::string partitionFilename(const std::string& workingFolder, std::int64_t node)
+{
+  return (bfs::path(workingFolder) / ("node_" + nodeName(node) + ".desc")).string();
+}
+
+} // namespace
+
+MiniBatchTreeBuilder::MiniBatchTreeBuilder(const MiniBatchKmeansParams& params)
+  : _params(params)
+{
+  if(_params.batchSize == 0 || _params.streamBlockSize == 0)
+    throw std::invalid_argument("Invalid mini-batch k-means parameters: the batch and block sizes must be positive.");
+}
+
+void MiniBatchTreeBuilder::initialize(std::size_t dimension, std::uint32_t k, std::uint32_t levels)
+{
+  if(k < 2 || levels == 0)
+    throw std::invalid_argument("Invalid vocabulary tree size: k = " + std::to_string(k) + ", levels = " + std::to_string(levels));
+
+  _dimension = dimension;
+  _k = k;
+  _levels = levels;
+
+  std::size_t nbNodes = 0;
+  std::size_t levelNodes = 1;
+  for(std::uint32_t level = 0; level < levels; ++level)
+  {
+    levelNodes *= k;
+    nbNodes += levelNodes;
+  }
+
+  // Mark non-existent centers as invalid.
+  _centers.assign(nbNodes * dimension, 0.f);
+  _validCenters.assign(nbNodes, 0);
+}
+
+void MiniBatchTreeBuilder::build(const unsigned char* descriptors, std::size_t nbDescriptors, std::size_t dimension, std::uint32_t k, std::uint32_t levels)
+{
+  initialize(dimension, k, levels);
+
+  std::vector<unsigned char> data(descriptors, descriptors + nbDescriptors * dimension);
+  buildInMemory(-1, 0, data);
+}
+
+void MiniBatchTreeBuilder::build(const std::string& descriptorsFilename, std::uint32_t k, std::uint32_t levels, const std::string& workingFolder)
+{
+  DescriptorsBlockFile descriptorsFile(descriptorsFilename);
+  initialize(descriptorsFile.dimension(), k, levels);
+
+  if(!bfs::exists(workingFolder))
+    bfs::create_directories(workingFolder);
+
+  // the checkpoints are only valid for the same input and parameters
+  {
+    std::ostringstream ss;
+    ss << descriptorsFile.size() << " " << _dimension << " " << _k << " " << _levels << " " << _params.batchSize << " "
+       << _params.nbIterations << " " << _params.maxInMemoryDescriptors << " " << _params.streamBlockSize << " " << _params.randomSeed;
+
+    const std::string paramsFilename = (bfs::path(workingFolder) / "miniBatchTreeBuilder.params").string();
+    if(bfs::exists(paramsFilename))
+    {
+      std::ifstream in(paramsFilename);
+      std::string previousParams;
+      std::getline(in, previousParams);
+      if(previousParams != ss.str())
+        throw std::runtime_error("The working folder '" + workingFolder + "' contains the checkpoints of a build with other parameters.");
+      ALICEVISION_LOG_INFO("Resuming the vocabulary tree build from the checkpoints of: " << workingFolder);
+    }
+    else
+    {
+      std::ofstream out(paramsFilename);
+      out << ss.str() << std::endl;
+    }
+  }
+
+  // the nodes too large to be built in memory are partitioned on disk, from the root
+  const std::size_t maxInMemoryDescriptors = std::max<std::size_t>(_params.maxInMemoryDescriptors, _k);
+  std::deque<DiskNode> diskNodes;
+  std::vector<DiskNode> inMemoryNodes;
+  diskNodes.push_back({-1, 0, descriptorsFilename, descriptorsFile.dataOffset(), descriptorsFile.size()});
+
+  const auto removePartition = [&](const DiskNode& diskNode)
+  {
+    if(diskNode.filename != descriptorsFilename)
+      bfs::remove(diskNode.filename);
+  };
+
+  while(!diskNodes.empty())
+  {
+    const DiskNode diskNode = diskNodes.front();
+    diskNodes.pop_front();
+
+    if(diskNode.depth >= _levels || diskNode.size == 0)
+    {
+      removePartition(diskNode);
+      continue;
+    }
+
+    if(diskNode.size <= maxInMemoryDescriptors)
+    {
+      inMemoryNodes.push_back(diskNode);
+      continue;
+    }
+
+    std::vector<std::size_t> childrenSizes;
+    if(!loadCheckpoint(checkpointFilename(workingFolder, "node", diskNode.node), childrenSizes))
+    {
+      ALICEVISION_LOG_INFO("Clustering node " << nodeName(diskNode.node) << " (level " << diskNode.depth << ") from disk: " << diskNode.size << " descriptors");
+      processDiskNode(diskNode, workingFolder, childrenSizes);
+    }
+    removePartition(diskNode);
+
+    if(diskNode.depth + 1 >= _levels)
+      continue;
+
+    for(std::uint32_t c = 0; c < _k; ++c)
+    {
+      const std::int64_t child = firstChild(diskNode.node, _k) + c;
+      diskNodes.push_back({child, diskNode.depth + 1, partitionFilename(workingFolder, child), 0, childrenSizes[c]});
+    }
+  }
+
+  // subtrees in memory, each one built in parallel
+  for(std::size_t i = 0; i < inMemoryNodes.size(); ++i)
+  {
+    const DiskNode& diskNode = inMemoryNodes[i];
+    const std::string filename = checkpointFilename(workingFolder, "subtree", diskNode.node);
+
+    std::vector<std::size_t> childrenSizes;
+    if(!loadCheckpoint(filename, childrenSizes))
+    {
+      ALICEVISION_LOG_INFO("Building subtree " << i + 1 << "/" << inMemoryNodes.size() << " of node " << nodeName(diskNode.node)
+                           << " (level " << diskNode.depth << ") in memory: " << diskNode.size << " descriptors");
+
+      std::vector<unsigned char> data(diskNode.size * _dimension);
+      std::ifstream in(diskNode.filename, std::ios::binary);
+      in.seekg(diskNode.offset);
+      in.read(reinterpret_cast<char*>(data.data()), data.size());
+      if(!in)
+        throw std::runtime_error("Unable to read the descriptors of node " + nodeName(diskNode.node) + " from: " + diskNode.filename);
+
+      const std::vector<std::int64_t> nodes = buildInMemory(diskNode.node, diskNode.depth, data);
+      saveCheckpoint(filename, nodes, childrenSizes);
+    }
+    removePartition(diskNode);
+  }
+}
+
+void MiniBatchTreeBuilder::clusterNode(std::int64_t node, const Sampler& drawSamples, bool parallel)
+{
+  std::mt19937 generator = nodeGenerator(_params.randomSeed, node);
+  const std::int64_t first = firstChild(node, _k);
+
+  miniBatchKmeans(drawSamples, _dimension, _k, _params, generator, parallel, _centers.data() + first * _dimension);
+  std::fill(_validCenters.begin() + first, _validCenters.begin() + first + _k, 1);
+}
+
+std::vector<std::int64_t> MiniBatchTreeBuilder::buildInMemory(std::int64_t node, std::uint32_t depth, std::vector<unsigned char>& descriptors)
+{
+  std::vector<std::int64_t> processedNodes;
+  if(depth >= _levels)
+    return processedNodes;
+
+  // the descriptors of each node are contiguous, they are partitioned between the children through this buffer
+  std::vector<unsigned char> buffer(descriptors.size());
+  std::vector<NodeRange> levelNodes = {{node, depth, 0, descriptors.size() / _dimension}};
+
+  while(!levelNodes.empty())
+  {
+    std::vector<std::vector<NodeRange>> childrenPerNode(levelNodes.size());
+
+    // parallelize over the nodes, or inside the node when it is alone
+    const bool parallelNodes = levelNodes.size() > 1;
+
+    #pragma omp parallel for schedule(dynamic) if(parallelNodes)
+    for(std::ptrdiff_t i = 0; i < static_cast<std::ptrdiff_t>(levelNodes.size()); ++i)
+    {
+      const NodeRange& range = levelNodes[i];
+      const std::size_t nbDescriptors = range.end - range.begin;
+      unsigned char* data = descriptors.data() + range.begin * _dimension;
+      const std::int64_t first = firstChild(range.node, _k);
+
+      // If the node already has k or fewer descriptors, just use those as the centers.
+      if(nbDescriptors <= _k)
+      {
+        for(std::size_t j = 0; j < nbDescriptors * _dimension; ++j)
+          _centers[first * _dimension + j] = data[j];
+        std::fill(_validCenters.begin() + first, _validCenters.begin() + first + nbDescriptors, 1);
+        continue;
+      }
+
+      clusterNode(range.node, [&](std::mt19937& generator, std::size_t count, unsigned char* out_descriptors) {
+        std::uniform_int_distribution<std::size_t> distribution(0, nbDescriptors - 1);
+        for(std::size_t j = 0; j < count; ++j)
+          std::memcpy(out_descriptors + j * _dimension, data + distribution(generator) * _dimension, _dimension);
+      }, !parallelNodes);
+
+      if(range.depth + 1 >= _levels)
+        continue;
+
+      // partition the descriptors of the node between its children
+      std::vector<unsigned char> centers(_k * _dimension);
+      std::vector<std::uint32_t> assignments(nbDescriptors);
+      roundCenters(_centers.data() + first * _dimension, centers.size(), centers.data());
+      assignToCenters(data, nbDescriptors, centers.data(), _k, _dimension, assignments.data(), !parallelNodes);
+
+      std::vector<std::size_t> offsets(_k + 1, 0);
+      for(const std::uint32_t c : assignments)
+        ++offsets[c + 1];
+      for(std::uint32_t c = 0; c < _k; ++c)
+        offsets[c + 1] += offsets[c];
+
+      for(std::uint32_t c = 0; c < _k; ++c)
+      {
+        if(offsets[c + 1] > offsets[c])
+          childrenPerNode[i].push_back({first + c, range.depth + 1, range.begin + offsets[c], range.begin + offsets[c + 1]});
+      }
+
+      unsigned char* nodeBuffer = buffer.data() + range.begin * _dimension;
+      for(std::size_t j = 0; j < nbDescriptors; ++j)
+        std::memcpy(nodeBuffer + (offsets[assignments[j]]++) * _dimension, data + j * _dimension, _dimension);
+      std::memcpy(data, nodeBuffer, nbDescriptors * _dimension);
+    }
+
+    std::vector<NodeRange> nextLevelNodes;
+    for(std::size_t i = 0; i < levelNodes.size(); ++i)
+    {
+      processedNodes.push_back(levelNodes[i].node);
+      nextLevelNodes.insert(nextLevelNodes.end(), childrenPerNode[i].begin(), childrenPerNode[i].end());
+    }
+    levelNodes.swap(nextLevelNodes);
+  }
+
+  return processedNodes;
+}
+
+void MiniBatchTreeBuilder::processDiskNode(const DiskNode& diskNode, const std::string& workingFolder, std::vector<std::size_t>& out_childrenSizes)
+{
+  std::ifstream in(diskNode.filename, std::ios::binary);
+  if(!in.is_open())
+    throw std::runtime_error("Unable to read the descriptors of node " + nodeName(diskNode.node) + " from: " + diskNode.filename);
+
+  // random contiguous chunks of the file
+  clusterNode(diskNode.node, [&](std::mt19937& generator, std::size_t count, unsigned char* out_descriptors) {
+    const std::size_t chunkSize = std::min(samplingChunkSize, diskNode.size);
+    std::uniform_int_distribution<std::size_t> distribution(0, diskNode.size - chunkSize);
+    for(std::size_t j = 0; j < count; j += chunkSize)
+    {
+      const std::size_t position = distribution(generator);
+      in.seekg(diskNode.offset + position * _dimension);
+      in.read(reinterpret_cast<char*>(out_descriptors + j * _dimension), std::min(chunkSize, count - j) * _dimension);
+    }
+    if(!in)
+      throw std::runtime_error("Unable to read the descriptors of node " + nodeName(diskNode.node) + " from: " + diskNode.filename);
+  }, true);
+
+  const std::int64_t first = firstChild(diskNode.node, _k);
+  out_childrenSizes.assign(_k, 0);
+
+  // partition the descriptors of the node in one file per child, by contiguous blocks
+  if(diskNode.depth + 1 < _levels)
+  {
+    std::vector<std::ofstream> childrenFiles(_k);
+    for(std::uint32_t c = 0; c < _k; ++c)
+    {
+      childrenFiles[c].open(partitionFilename(workingFolder, first + c), std::ios::binary | std::ios::trunc);
+      if(!childrenFiles[c].is_open())
+        throw std::runtime_error("Unable to write the partition of node " + nodeName(first + c) + " in: " + workingFolder);
+    }
+
+    std::vector<unsigned char> centers(_k * _dimension);
+    roundCenters(_centers.data() + first * _dimension, centers.size(), centers.data());
+
+    std::vector<unsigned char> block(_params.streamBlockSize * _dimension);
+    std::vector<std::uint32_t> assignments(_params.streamBlockSize);
+    in.seekg(diskNode.offset);
+
+    for(std::size_t blockStart = 0; blockStart < diskNode.size; blockStart += _params.streamBlockSize)
+    {
+      const std::size_t count = std::min(_params.streamBlockSize, diskNode.size - blockStart);
+      in.read(reinterpret_cast<char*>(block.data()), count * _dimension);
+      if(!in)
+        throw std::runtime_error("Unable to read the descriptors of node " + nodeName(diskNode.node) + " from: " + diskNode.filename);
+
+      assignToCenters(block.data(), count, centers.data(), _k, _dimension, assignments.data(), true);
+
+      for(std::size_t j = 0; j < count; ++j)
+      {
+        childrenFiles[assignments[j]].write(reinterpret_cast<const char*>(block.data() + j * _dimension), _dimension);
+        ++out_childrenSizes[assignments[j]];
+      }
+    }
+
+    for(std::uint32_t c = 0; c < _k; ++c)
+    {
+      childrenFiles[c].close();
+      if(childrenFiles[c].fail())
+        throw std::runtime_error("Unable to write the partition of node " + nodeName(first + c) + " in: " + workingFolder);
+    }
+  }
+
+  saveCheckpoint(checkpointFilename(workingFolder, "node", diskNode.node), {diskNode.node}, out_childrenSizes);
+}
+
+std::string MiniBatchTreeBuilder::checkpointFilename(const std::string& workingFolder, const std::string& prefix, std::int64_t node) const
+{
+  return (bfs::path(workingFolder) / (prefix + "_" + nodeName(node) + ".checkpoint")).string();
+}
+
+void MiniBatchTreeBuilder::saveCheckpoint(const std::string& filename, const std::vector<std::int64_t>& nodes, const std::vector<std::size_t>& childrenSizes) const
+{
+  // written under a temporary name, an existing checkpoint is always complete
+  const std::string tmpFilename = filename + ".tmp";
+  {
+    std::ofstream out(tmpFilename, std::ios::binary);
+
+    const std::uint64_t nbNodes = nodes.size();
+    out.write(reinterpret_cast<const char*>(&nbNodes), sizeof(nbNodes));
+    for(const std::int64_t node : nodes)
+    {
+      const std::int64_t first = firstChild(node, _k);
+      out.write(reinterpret_cast<const char*>(&node), sizeof(node));
+      out.write(reinterpret_cast<const char*>(_centers.data() + first * _dimension), _k * _dimension * sizeof(float));
+      out.write(reinterpret_cast<const char*>(_validCenters.data() + first), _k);
+    }
+
+    const std::uint64_t nbChildren = childrenSizes.size();
+    out.write(reinterpret_cast<const char*>(&nbChildren), sizeof(nbChildren));
+    for(const std::size_t size : childrenSizes)
+    {
+      const std::uint64_t childSize = size;
+      out.write(reinterpret_cast<const char*>(&childSize), sizeof(childSize));
+    }
+
+    if(!out.good())
+      throw std::runtime_error("Unable to write the checkpoint: " + tmpFilename);
+  }
+  bfs::rename(tmpFilename, filename);
+}
+
+bool MiniBatchTreeBuilder::loadCheckpoint(const std::string& filename, std::vector<std::size_t>& out_childrenSizes)
+{
+  if(!bfs::exists(filename))
+    return false;
+
+  std::ifstream in(filename, std::ios::binary);
+  std::uint64_t nbNodes = 0;
+  in.read(reinterpret_cast<char*>(&nbNodes), sizeof(nbNodes));
+  for(std::uint64_t i = 0; i < nbNodes && in; ++i)
+  {
+    std::int64_t node = 0;
+    in.read(reinterpret_cast<char*>(&node), sizeof(node));
+    const std::int64_t first = firstChild(node, _k);
+    if(node < -1 || static_cast<std::size_t>(first + _k) > _validCenters.size())
+      throw std::runtime_error("Invalid checkpoint: " + filename);
+
+    in.read(reinterpret_cast<char*>(_centers.data() + first * _dimension), _k * _dimension * sizeof(float));
+    in.read(reinterpret_cast<char*>(_validCenters.data() + first), _k);
+  }
+
+  std::uint64_t nbChildren = 0;
+  in.read(reinterpret_cast<char*>(&nbChildren), sizeof(nbChildren));
+  out_childrenSizes.resize(nbChildren);
+  for(std::size_t& size : out_childrenSizes)
+  {
+    std::uint64_t childSize = 0;
+    in.read(reinterpret_cast<char*>(&childSize), sizeof(childSize));
+    size = childSize;
+  }
+
+  if(!in)
+    throw std::runtime_error("Invalid checkpoint: " + filename);
+
+  return true;
+}
+
+} // namespace voctree
+} // namespace aliceVision
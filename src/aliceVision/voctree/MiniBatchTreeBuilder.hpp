@@ -0,0 +1,163 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "MutableVocabularyTree.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace voctree {
+
+/**
+ * @brief Parameters of the mini-batch k-means used to build a vocabulary tree.
+ */
+struct MiniBatchKmeansParams
+{
+  /// number of descriptors drawn at each iteration
+  std::size_t batchSize = 2048;
+  /// number of iterations to cluster the descriptors of a node
+  std::size_t nbIterations = 100;
+  /// maximum number of descriptors of a subtree built in memory, larger subtrees are partitioned on disk
+  std::size_t maxInMemoryDescriptors = 20000000;
+  /// number of descriptors read at once when streaming a file
+  std::size_t streamBlockSize = 65536;
+  /// seed of the random generators (each node has its own generator derived from this seed)
+  unsigned int randomSeed = 0;
+};
+
+/**
+ * @brief Build a vocabulary tree by hierarchical mini-batch k-means on unsigned char descriptors.
+ *
+ * The descriptors of a node are clustered with a mini-batch k-means (Sculley, "Web-scale k-means clustering", 2010):
+ * at each iteration a random batch is assigned to the nearest centers with the blocked unsigned char
+ * distance kernels (see feature::squaredL2DistancesBlock) and the centers are updated with a per-center learning rate.
+ *
+ * Nodes with more than maxInMemoryDescriptors descriptors are streamed from disk by contiguous blocks
+ * and partitioned into one file per child. Smaller subtrees are loaded contiguously in memory and built
+ * level by level, the nodes of a level being clustered in parallel.
+ *
+ * Each finished node or subtree is checkpointed in the working folder, so an interrupted build
+ * restarted with the same working folder and parameters only computes the remaining nodes,
+ * with the same result as an uninterrupted build.
+ *
+ * The tree has the layout of MutableVocabularyTree: the children of the node i (-1 for the root)
+ * are the nodes [(i + 1) * k, (i + 2) * k). Like TreeBuilder, a node with at most k descriptors
+ * uses them as children centers, the other children are invalid.
+ */
+class MiniBatchTreeBuilder
+{
+public:
+
+  explicit MiniBatchTreeBuilder(const MiniBatchKmeansParams& params = MiniBatchKmeansParams());
+
+  /**
+   * @brief Build a vocabulary tree from a descriptors block file (see DescriptorsBlockFile).
+   *
+   * @param[in] descriptorsFilename The training descriptors
+   * @param[in] k The branching factor, or max children of any node
+   * @param[in] levels The number of levels in the tree
+   * @param[in] workingFolder The folder of the partition files and of the checkpoints
+   * @note throw if the working folder contains the checkpoints of a build with other parameters
+   */
+  void build(const std::string& descriptorsFilename, std::uint32_t k, std::uint32_t levels, const std::string& workingFolder);
+
+  /**
+   * @brief Build a vocabulary tree from descriptors in memory, without checkpoint.
+   *
+   * @param[in] descriptors The training descriptors (row-major, nbDescriptors x dimension)
+   * @param[in] nbDescriptors The number of descriptors
+   * @param[in] dimension The number of elements of a descriptor
+   * @param[in] k The branching factor, or max children of any node
+   * @param[in] levels The number of levels in the tree
+   */
+  void build(const unsigned char* descriptors, std::size_t nbDescriptors, std::size_t dimension, std::uint32_t k, std::uint32_t levels);
+
+  /// centers of all the nodes (row-major, nbNodes x dimension)
+  inline const std::vector<float>& centers() const { return _centers; }
+  /// validity of all the nodes
+  inline const std::vector<std::uint8_t>& validCenters() const { return _validCenters; }
+
+  /**
+   * @brief Copy the built tree in a vocabulary tree.
+   * @param[out] tree The vocabulary tree, Feature must have the dimension of the descriptors
+   */
+  template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+  void getTree(MutableVocabularyTree<Feature, Distance, FeatureAllocator>& tree) const;
+
+private:
+
+  struct NodeRange
+  {
+    /// node index (-1 for the root)
+    std::int64_t node;
+    /// depth of the node (0 for the root)
+    std::uint32_t depth;
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  struct DiskNode
+  {
+    std::int64_t node;
+    std::uint32_t depth;
+    /// file of the descriptors of the node
+    std::string filename;
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  void initialize(std::size_t dimension, std::uint32_t k, std::uint32_t levels);
+
+  /// draw random descriptors of a node
+  using Sampler = std::function<void(std::mt19937& generator, std::size_t count, unsigned char* out_descriptors)>;
+
+  /// cluster the descriptors of a node into its children centers
+  void clusterNode(std::int64_t node, const Sampler& drawSamples, bool parallel);
+
+  /// build the subtree of a node whose descriptors are in memory, return the processed nodes
+  std::vector<std::int64_t> buildInMemory(std::int64_t node, std::uint32_t depth, std::vector<unsigned char>& descriptors);
+
+  /// cluster a node streamed from disk and partition its descriptors in one file per child
+  void processDiskNode(const DiskNode& diskNode, const std::string& workingFolder, std::vector<std::size_t>& out_childrenSizes);
+
+  std::string checkpointFilename(const std::string& workingFolder, const std::string& prefix, std::int64_t node) const;
+  void saveCheckpoint(const std::string& filename, const std::vector<std::int64_t>& nodes, const std::vector<std::size_t>& childrenSizes) const;
+  bool loadCheckpoint(const std::string& filename, std::vector<std::size_t>& out_childrenSizes);
+
+  MiniBatchKmeansParams _params;
+  std::size_t _dimension = 0;
+  std::uint32_t _k = 0;
+  std::uint32_t _levels = 0;
+  std::vector<float> _centers;
+  std::vector<std::uint8_t> _validCenters;
+};
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void MiniBatchTreeBuilder::getTree(MutableVocabularyTree<Feature, Distance, FeatureAllocator>& tree) const
+{
+  tree.clear();
+  tree.setSize(_levels, _k);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters() = _validCenters;
+
+  for(std::size_t i = 0; i < tree.centers().size(); ++i)
+  {
+    Feature& center = tree.centers()[i];
+    const float* values = _centers.data() + i * _dimension;
+    for(std::size_t d = 0; d < _dimension; ++d)
+      center[d] = values[d];
+  }
+}
+
+} // namespace voctree
+} // namespace aliceVision
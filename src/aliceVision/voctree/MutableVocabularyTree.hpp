@@ -28,6 +28,12 @@ public:
   {
   }
 
+  /// Load vocabulary from a file, always in memory to be modified.
+  void load(const std::string& file) override
+  {
+    this->loadFile(file, false);
+  }
+
   void setSize(uint32_t levels, uint32_t splits)
   {
     this->levels_ = levels;
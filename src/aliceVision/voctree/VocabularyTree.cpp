@@ -49,7 +49,8 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
       }
       else
       {
-        const auto val = std::minmax(i1->second.size(), i2->second.size());
+        // minmax of values: avoid a pair of references to temporaries
+        const std::pair<std::size_t, std::size_t> val = std::minmax(i1->second.size(), i2->second.size());
         distance += static_cast<float>(val.second - val.first);
         ++i1;
         ++i2;
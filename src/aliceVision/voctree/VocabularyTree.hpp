@@ -9,6 +9,7 @@
 #include <aliceVision/config.hpp>
 #include "distance.hpp"
 #include "DefaultAllocator.hpp"
+#include "FlatVocabularyTree.hpp"
 
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/regionsFactory.hpp>
@@ -20,10 +21,13 @@
 #include <vector>
 #include <map>
 #include <cassert>
+#include <cstring>
 #include <limits>
 #include <fstream>
+#include <memory>
 #include <stdexcept>
 #include <iostream>
+#include <type_traits>
 
 
 namespace aliceVision {
@@ -101,6 +105,10 @@ inline IVocabularyTree::~IVocabularyTree() {}
  * a metric; distances simply need to be comparable.
  *
  * \c FeatureAllocator is an STL-compatible allocator used to allocate Features internally.
+ *
+ * For unsigned char and float feature::Descriptor with the L2 distance, the tree file is memory-mapped
+ * on load (the centers are used in place, without any copy) and the features are quantized
+ * by batches with the SIMD distance kernels (see FlatVocabularyTree).
  */
 template<class Feature, template<typename, typename> class Distance = L2, // TODO: rename Feature into Descriptor
 class FeatureAllocator = typename DefaultAllocator<Feature>::type>
@@ -145,13 +153,20 @@ public:
 
   /// Save vocabulary to a file.
   void save(const std::string& file) const override;
-  /// Load vocabulary from a file.
+  /// Load vocabulary from a file (memory-mapped if the feature type allows it).
   void load(const std::string& file) override;
 
+  /// Return true if the centers are used in place from the memory-mapped tree file.
+  bool isMapped() const
+  {
+    return mapping_ != nullptr;
+  }
+
   bool operator==(const VocabularyTree& other) const
   {
-    return (centers_ == other.centers_) &&
-        (valid_centers_ == other.valid_centers_) &&
+    return (nbCenters() == other.nbCenters()) &&
+        std::equal(centersData(), centersData() + nbCenters(), other.centersData()) &&
+        std::equal(validCentersData(), validCentersData() + nbCenters(), other.validCentersData()) &&
         (k_ == other.k_) &&
         (levels_ == other.levels_) &&
         (num_words_ == other.num_words_) &&
@@ -159,9 +174,19 @@ public:
   }
 
 protected:
+  /// The features can be used in place from a flat layout (in memory or memory-mapped)
+  static constexpr bool isFlatFeature = FlatDescriptorTraits<Feature>::value &&
+                                        std::is_same<Distance<Feature, Feature>, L2<Feature, Feature>>::value;
+
   std::vector<Feature, FeatureAllocator> centers_;
   std::vector<uint8_t> valid_centers_; /// @todo Consider bit-vector
 
+  /// memory-mapped tree file, centers_ and valid_centers_ are empty when the tree is mapped
+  std::shared_ptr<TreeFileMapping> mapping_;
+  const Feature* mapped_centers_ = nullptr;
+  const uint8_t* mapped_valid_centers_ = nullptr;
+  uint32_t mapped_size_ = 0;
+
   uint32_t k_; // splits, or branching factor
   uint32_t levels_;
   uint32_t num_words_; // number of leaf nodes
@@ -172,6 +197,28 @@ protected:
     return num_words_ != 0;
   }
 
+  const Feature* centersData() const
+  {
+    return isMapped() ? mapped_centers_ : centers_.data();
+  }
+
+  const uint8_t* validCentersData() const
+  {
+    return isMapped() ? mapped_valid_centers_ : valid_centers_.data();
+  }
+
+  std::size_t nbCenters() const
+  {
+    return isMapped() ? mapped_size_ : centers_.size();
+  }
+
+  /**
+   * @brief Load vocabulary from a file.
+   * @param[in] file the vocabulary tree file
+   * @param[in] allowMapping map the file instead of reading it, if the feature type allows it
+   */
+  void loadFile(const std::string& file, bool allowMapping);
+
   void setNodeCounts();
 };
 
@@ -197,6 +244,8 @@ Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const Descrip
   //	printf("asserting\n");
   assert(initialized());
   //	printf("initialized\n");
+  const Feature* centers = centersData();
+  const uint8_t* valid_centers = validCentersData();
   int32_t index = -1; // virtual "root" index, which has no associated center.
   for(unsigned level = 0; level < levels_; ++level)
   {
@@ -207,9 +256,9 @@ Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const Descrip
     distance_type best_distance = std::numeric_limits<distance_type>::max();
     for(int32_t child = first_child; child < first_child + (int32_t) splits(); ++child)
     {
-      if(!valid_centers_[child])
+      if(!valid_centers[child])
         break; // Fewer than splits() children.
-      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers_[child]);
+      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers[child]);
       if(child_distance < best_distance)
       {
         best_child = child;
@@ -229,6 +278,27 @@ std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(
   // ALICEVISION_LOG_DEBUG("VocabularyTree quantize: " << features.size());
   std::vector<Word> imgVisualWords(features.size(), 0);
 
+  if constexpr(isFlatFeature && std::is_same<DescriptorT, Feature>::value)
+  {
+    // batched quantization on the flat layout of the tree
+    assert(initialized());
+    using Scalar = typename FlatDescriptorTraits<Feature>::Scalar;
+
+    FlatVocabularyTree<Scalar> flatTree;
+    flatTree.centers = reinterpret_cast<const Scalar*>(centersData());
+    flatTree.validCenters = validCentersData();
+    flatTree.dimension = FlatDescriptorTraits<Feature>::dimension;
+    flatTree.splits = k_;
+    flatTree.levels = levels_;
+
+    quantizeFlat(flatTree, reinterpret_cast<const Scalar*>(features.data()), features.size(), imgVisualWords.data());
+
+    for(Word& word : imgVisualWords)
+      word -= word_start_;
+
+    return imgVisualWords;
+  }
+
   // quantize the features
   #pragma omp parallel for
   for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(features.size()); ++j)
@@ -274,6 +344,10 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::clear()
 {
   centers_.clear();
   valid_centers_.clear();
+  mapping_.reset();
+  mapped_centers_ = nullptr;
+  mapped_valid_centers_ = nullptr;
+  mapped_size_ = 0;
   k_ = levels_ = num_words_ = word_start_ = 0;
 }
 
@@ -287,17 +361,60 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::save(const std::string
   std::ofstream out(file, std::ios_base::binary);
   out.write((char*) (&k_), sizeof (uint32_t));
   out.write((char*) (&levels_), sizeof (uint32_t));
-  uint32_t size = centers_.size();
+  uint32_t size = nbCenters();
   out.write((char*) (&size), sizeof (uint32_t));
-  out.write((char*) (&centers_[0]), centers_.size() * sizeof (Feature));
-  out.write((char*) (&valid_centers_[0]), valid_centers_.size());
+  out.write((const char*) (centersData()), size * sizeof (Feature));
+  out.write((const char*) (validCentersData()), size);
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 void VocabularyTree<Feature, Distance, FeatureAllocator>::load(const std::string& file)
+{
+  loadFile(file, true);
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::loadFile(const std::string& file, bool allowMapping)
 {
   clear();
 
+  if constexpr(isFlatFeature)
+  {
+    if(allowMapping)
+    {
+      // use the centers in place from the file: <k, levels, size, centers[size], valid_centers[size]>
+      std::shared_ptr<TreeFileMapping> mapping = std::make_shared<TreeFileMapping>(file);
+      const std::size_t headerSize = 3 * sizeof(uint32_t);
+      if(mapping->size() < headerSize)
+        throw std::runtime_error("Failed to load vocabulary tree file" + file);
+
+      uint32_t header[3];
+      std::memcpy(header, mapping->data(), headerSize);
+      k_ = header[0];
+      levels_ = header[1];
+      const uint32_t size = header[2];
+
+      if(mapping->size() < headerSize + std::size_t(size) * (sizeof(Feature) + 1) || k_ == 0 || levels_ == 0)
+      {
+        k_ = levels_ = 0;
+        throw std::runtime_error("Failed to load vocabulary tree file" + file);
+      }
+
+      setNodeCounts();
+      if(size != num_words_ + word_start_)
+      {
+        k_ = levels_ = num_words_ = word_start_ = 0;
+        throw std::runtime_error("Failed to load vocabulary tree file" + file + " (invalid number of nodes)");
+      }
+
+      mapped_centers_ = reinterpret_cast<const Feature*>(mapping->data() + headerSize);
+      mapped_valid_centers_ = reinterpret_cast<const uint8_t*>(mapping->data() + headerSize + std::size_t(size) * sizeof(Feature));
+      mapped_size_ = size;
+      mapping_ = std::move(mapping);
+      return;
+    }
+  }
+
   std::ifstream in;
   in.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
 
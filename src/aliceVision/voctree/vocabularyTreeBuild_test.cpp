@@ -5,12 +5,20 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/TreeBuilder.hpp>
+#include <aliceVision/voctree/MiniBatchTreeBuilder.hpp>
+#include <aliceVision/voctree/DescriptorsBlockFile.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #include <Eigen/Core>
 
+#include <boost/filesystem.hpp>
+
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <random>
+#include <set>
 #include <vector>
 
 #define BOOST_TEST_MODULE voctreeBuilder
@@ -86,3 +94,130 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
   }
 //  voctree::printFeatVector( features ); 
 }
+
+BOOST_AUTO_TEST_CASE(voctreeMiniBatchBuilder)
+{
+  using namespace aliceVision;
+  namespace fs = boost::filesystem;
+
+  const std::size_t DIMENSION = 16;
+  const std::size_t FEATURENUMBER = 200;
+  const std::uint32_t K = 4;
+  const std::uint32_t LEVELS = 2;
+
+  typedef feature::Descriptor<unsigned char, DIMENSION> DescriptorUChar;
+  typedef feature::Descriptor<float, DIMENSION> DescriptorFloat;
+
+  // K groups of K clusters: each level of the tree separates well separated clusters
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> noise(-4, 4);
+  std::vector<DescriptorFloat> clusterCenters;
+  std::vector<std::vector<DescriptorUChar>> imagesDescriptors(K);
+
+  for(std::uint32_t group = 0; group < K; ++group)
+  {
+    for(std::uint32_t cluster = 0; cluster < K; ++cluster)
+    {
+      DescriptorFloat center;
+      for(std::size_t d = 0; d < DIMENSION; ++d)
+        center[d] = 20.f + ((d % K == group) ? 160.f : 0.f) + ((d / K == cluster) ? 60.f : 0.f);
+      clusterCenters.push_back(center);
+
+      for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+      {
+        DescriptorUChar descriptor;
+        for(std::size_t d = 0; d < DIMENSION; ++d)
+          descriptor[d] = static_cast<unsigned char>(center[d] + noise(generator));
+        imagesDescriptors[cluster].push_back(descriptor);
+      }
+    }
+  }
+
+  std::vector<unsigned char> descriptors;
+  std::map<IndexT, std::string> descriptorsFiles;
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path();
+  fs::create_directories(folder);
+  for(std::uint32_t i = 0; i < K; ++i)
+  {
+    descriptorsFiles[i] = (folder / (std::to_string(i) + ".desc")).string();
+    feature::saveDescsToBinFile(descriptorsFiles[i], imagesDescriptors[i]);
+    for(const DescriptorUChar& descriptor : imagesDescriptors[i])
+      descriptors.insert(descriptors.end(), descriptor.getData(), descriptor.getData() + DIMENSION);
+  }
+  const std::size_t nbDescriptors = descriptors.size() / DIMENSION;
+
+  const std::string blockFilename = (folder / "descriptors.bin").string();
+  BOOST_CHECK_EQUAL(voctree::DescriptorsBlockFile::write<DescriptorUChar>(blockFilename, descriptorsFiles), nbDescriptors);
+  {
+    voctree::DescriptorsBlockFile blockFile(blockFilename);
+    BOOST_CHECK_EQUAL(blockFile.dimension(), DIMENSION);
+    BOOST_CHECK_EQUAL(blockFile.size(), nbDescriptors);
+    BOOST_CHECK_EQUAL(blockFile.nbDescriptorsPerImage().size(), K);
+
+    std::vector<unsigned char> read(nbDescriptors * DIMENSION);
+    blockFile.read(0, nbDescriptors, read.data());
+    BOOST_CHECK(read == descriptors);
+  }
+
+  const auto checkTree = [&](const voctree::MiniBatchTreeBuilder& builder)
+  {
+    voctree::MutableVocabularyTree<DescriptorFloat> tree;
+    builder.getTree(tree);
+    BOOST_CHECK_EQUAL(tree.levels(), LEVELS);
+    BOOST_CHECK_EQUAL(tree.splits(), K);
+    BOOST_CHECK_EQUAL(tree.centers().size(), K + K * K);
+
+    for(const std::uint8_t valid : tree.validCenters())
+      BOOST_CHECK(valid != 0);
+
+    // each cluster has its own leaf, centered on the cluster
+    std::set<voctree::Word> words;
+    for(const DescriptorFloat& center : clusterCenters)
+    {
+      const voctree::Word word = tree.quantize(center);
+      words.insert(word);
+      const DescriptorFloat& leafCenter = tree.centers()[K + word];
+      float distance = 0.f;
+      for(std::size_t d = 0; d < DIMENSION; ++d)
+        distance += (leafCenter[d] - center[d]) * (leafCenter[d] - center[d]);
+      BOOST_CHECK_LT(distance, 4.f * DIMENSION);
+    }
+    BOOST_CHECK_EQUAL(words.size(), clusterCenters.size());
+  };
+
+  voctree::MiniBatchKmeansParams params;
+  params.batchSize = 256;
+  params.nbIterations = 20;
+
+  // in memory
+  voctree::MiniBatchTreeBuilder inMemoryBuilder(params);
+  inMemoryBuilder.build(descriptors.data(), nbDescriptors, DIMENSION, K, LEVELS);
+  checkTree(inMemoryBuilder);
+
+  // from the block file, the whole tree fits in memory
+  voctree::MiniBatchTreeBuilder fileBuilder(params);
+  fileBuilder.build(blockFilename, K, LEVELS, (folder / "inMemory").string());
+  BOOST_CHECK(fileBuilder.centers() == inMemoryBuilder.centers());
+
+  // the root is partitioned on disk
+  params.maxInMemoryDescriptors = nbDescriptors / 2;
+  params.streamBlockSize = 100;
+  voctree::MiniBatchTreeBuilder diskBuilder(params);
+  diskBuilder.build(blockFilename, K, LEVELS, (folder / "disk").string());
+  checkTree(diskBuilder);
+  BOOST_CHECK(fs::exists(folder / "disk" / "node_root.checkpoint"));
+  BOOST_CHECK(fs::exists(blockFilename));
+
+  // resumed from the checkpoints
+  voctree::MiniBatchTreeBuilder resumedBuilder(params);
+  resumedBuilder.build(blockFilename, K, LEVELS, (folder / "disk").string());
+  BOOST_CHECK(resumedBuilder.centers() == diskBuilder.centers());
+  BOOST_CHECK(resumedBuilder.validCenters() == diskBuilder.validCenters());
+
+  // the checkpoints of other parameters are not reused
+  params.nbIterations = 10;
+  voctree::MiniBatchTreeBuilder otherBuilder(params);
+  BOOST_CHECK_THROW(otherBuilder.build(blockFilename, K, LEVELS, (folder / "disk").string()), std::runtime_error);
+
+  fs::remove_all(folder);
+}
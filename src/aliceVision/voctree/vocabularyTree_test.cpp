@@ -5,9 +5,12 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/MutableVocabularyTree.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
 
 #include <iostream>
 #include <fstream>
+#include <random>
 #include <vector>
 
 #define BOOST_TEST_MODULE vocabularyTree
@@ -57,3 +60,143 @@ BOOST_AUTO_TEST_CASE(database)
     BOOST_CHECK_SMALL(static_cast<double>(match[0].score), 0.001);
   }
 }
+
+template<typename DescriptorT>
+void checkFlatQuantization(const std::string& treeName)
+{
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> valueDistribution(0, 255);
+
+  const uint32_t levels = 3;
+  const uint32_t splits = 6;
+
+  // random tree, with some nodes having fewer than splits children
+  MutableVocabularyTree<DescriptorT> tree;
+  tree.setSize(levels, splits);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters().resize(tree.nodes());
+  for(uint32_t i = 0; i < tree.nodes(); ++i)
+  {
+    for(std::size_t j = 0; j < DescriptorT::static_size; ++j)
+      tree.centers()[i][j] = valueDistribution(generator);
+    tree.validCenters()[i] = (i % splits) < ((i / splits) % 3 == 0 ? splits / 2 : splits);
+  }
+  tree.save(treeName);
+
+  // the centers are used in place from the file
+  VocabularyTree<DescriptorT> loadedTree(treeName);
+  BOOST_CHECK(loadedTree.isMapped());
+  BOOST_CHECK(loadedTree == tree);
+
+  std::vector<DescriptorT> features(2000);
+  for(DescriptorT& feature : features)
+  {
+    for(std::size_t j = 0; j < DescriptorT::static_size; ++j)
+      feature[j] = valueDistribution(generator);
+  }
+
+  // batched quantization vs quantization of each feature
+  const std::vector<Word> words = loadedTree.quantize(features);
+  BOOST_CHECK_EQUAL(words.size(), features.size());
+  for(std::size_t i = 0; i < features.size(); ++i)
+  {
+    BOOST_CHECK_EQUAL(words[i], loadedTree.quantize(features[i]));
+    BOOST_CHECK_EQUAL(words[i], tree.quantize(features[i]));
+  }
+
+  // saving a mapped tree gives the same file
+  loadedTree.save(treeName + ".copy");
+  MutableVocabularyTree<DescriptorT> reloadedTree;
+  reloadedTree.load(treeName + ".copy");
+  BOOST_CHECK(!reloadedTree.isMapped());
+  BOOST_CHECK(reloadedTree == tree);
+}
+
+BOOST_AUTO_TEST_CASE(databaseInvertedFiles)
+{
+  const int nbDocuments = 60;
+  const int nbWords = 200;
+  const std::vector<std::string> distanceMethods = {"classic", "commonPoints", "strongCommonPoints", "inversedWeightedCommonPoints"};
+
+  std::mt19937 generator(3);
+  std::uniform_int_distribution<Word> wordDistribution(0, nbWords - 1);
+  std::uniform_int_distribution<int> sizeDistribution(5, 40);
+
+  // random documents, with repeated words
+  std::vector<SparseHistogram> histograms(nbDocuments);
+  Database db(nbWords);
+  for(int i = 0; i < nbDocuments; ++i)
+  {
+    std::vector<Word> document(sizeDistribution(generator));
+    for(Word& word : document)
+      word = wordDistribution(generator);
+    computeSparseHistogram(document, histograms[i]);
+    // insert in a different order than the ids
+    const DocId docId = (i * 7) % nbDocuments;
+    db.insert(docId, histograms[i]);
+  }
+  db.computeTfIdfWeights();
+
+  const SparseHistogramPerImage& documents = db.getSparseHistogramPerImage();
+  std::vector<const SparseHistogram*> queries;
+  for(const SparseHistogram& histogram : histograms)
+    queries.push_back(&histogram);
+
+  for(const std::string& distanceMethod : distanceMethods)
+  {
+    for(const std::size_t N : {std::size_t(1), std::size_t(10), std::size_t(nbDocuments), std::size_t(nbDocuments + 5)})
+    {
+      std::vector<DocMatches> queriesMatches;
+      db.find(queries, N, queriesMatches, distanceMethod);
+      BOOST_CHECK_EQUAL(queriesMatches.size(), queries.size());
+
+      for(std::size_t q = 0; q < queries.size(); ++q)
+      {
+        DocMatches matches;
+        db.find(*queries[q], N, matches, distanceMethod);
+
+        // brute force distances to all the documents
+        std::vector<float> expectedScores;
+        for(const auto& document : documents)
+          expectedScores.push_back(sparseDistance(*queries[q], document.second, distanceMethod, db.getWeights()));
+        std::sort(expectedScores.begin(), expectedScores.end());
+
+        BOOST_REQUIRE_EQUAL(matches.size(), std::min<std::size_t>(N, nbDocuments));
+        BOOST_REQUIRE_EQUAL(queriesMatches[q].size(), matches.size());
+        for(std::size_t m = 0; m < matches.size(); ++m)
+        {
+          BOOST_CHECK_CLOSE(matches[m].score, expectedScores[m], 1e-4);
+          BOOST_CHECK_CLOSE(matches[m].score, sparseDistance(*queries[q], documents.at(matches[m].id), distanceMethod, db.getWeights()), 1e-4);
+          BOOST_CHECK_EQUAL(queriesMatches[q][m].id, matches[m].id);
+          if(m > 0 && matches[m].score == matches[m - 1].score)
+            BOOST_CHECK(matches[m - 1].id < matches[m].id);
+        }
+      }
+    }
+  }
+
+  DocMatches matches;
+  BOOST_CHECK_THROW(db.find(histograms[0], 1, matches, "unknown"), std::invalid_argument);
+
+  // a saved database gives the same results
+  db.save("test_database.db");
+  Database loadedDb;
+  loadedDb.load("test_database.db");
+  BOOST_CHECK_EQUAL(loadedDb.size(), db.size());
+  BOOST_CHECK(loadedDb.getWeights() == db.getWeights());
+  BOOST_CHECK(loadedDb.getSparseHistogramPerImage() == documents);
+  for(const std::string& distanceMethod : distanceMethods)
+  {
+    std::vector<DocMatches> expectedMatches;
+    std::vector<DocMatches> loadedMatches;
+    db.find(queries, 10, expectedMatches, distanceMethod);
+    loadedDb.find(queries, 10, loadedMatches, distanceMethod);
+    BOOST_CHECK(loadedMatches == expectedMatches);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(flatQuantization)
+{
+  checkFlatQuantization<aliceVision::feature::Descriptor<unsigned char, 128>>("flatQuantization_uchar.tree");
+  checkFlatQuantization<aliceVision::feature::Descriptor<float, 128>>("flatQuantization_float.tree");
+}
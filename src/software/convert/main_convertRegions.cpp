@@ -0,0 +1,131 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfm/pipeline/regionsIO.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/regionsBinaryIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/ProgressDisplay.hpp>
+#include <aliceVision/cmdline/cmdline.hpp>
+#include <aliceVision/system/main.hpp>
+#include <aliceVision/config.hpp>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+// convert .feat / .desc regions files to memory-mapped binary regions files
+int aliceVision_main(int argc, char **argv)
+{
+  // command-line parameters
+  std::string sfmDataFilename;
+  std::vector<std::string> featuresFolders;
+  std::string outputFolder;
+
+  // user optional parameters
+  std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  bool sortByScale = false;
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
+      "SfMData file.")
+    ("featuresFolders,f", po::value<std::vector<std::string>>(&featuresFolders)->multitoken()->required(),
+      "Path to folder(s) containing the extracted features.")
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output folder for the binary regions files.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
+      feature::EImageDescriberType_informations().c_str())
+    ("sortByScale", po::value<bool>(&sortByScale)->default_value(sortByScale),
+      "Sort regions by decreasing scale. "
+      "Warning: regions indexes are changed, the converted regions cannot be used for matching / SfM.");
+
+  CmdLine cmdline("AliceVision convertRegions");
+  cmdline.add(requiredParams);
+  cmdline.add(optionalParams);
+  if (!cmdline.execute(argc, argv))
+  {
+      return EXIT_FAILURE;
+  }
+
+  // load input SfMData scene
+  sfmData::SfMData sfmData;
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData(sfmDataIO::VIEWS)))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" << sfmDataFilename << "' cannot be read");
+    return EXIT_FAILURE;
+  }
+
+  if(!fs::exists(outputFolder))
+    fs::create_directory(outputFolder);
+
+  std::vector<std::string> allFeaturesFolders = sfmData.getFeaturesFolders();
+  allFeaturesFolders.insert(allFeaturesFolders.end(), featuresFolders.begin(), featuresFolders.end());
+
+  const std::vector<feature::EImageDescriberType> imageDescriberTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
+
+  std::vector<IndexT> viewIds;
+  viewIds.reserve(sfmData.getViews().size());
+  for(const auto& viewPair : sfmData.getViews())
+    viewIds.push_back(viewPair.first);
+
+  auto progressDisplay = system::createConsoleProgressDisplay(viewIds.size() * imageDescriberTypes.size(),
+                                                              std::cout, "Converting regions\n");
+  std::atomic_bool success(true);
+
+  for(const feature::EImageDescriberType imageDescriberType : imageDescriberTypes)
+  {
+    const std::unique_ptr<feature::ImageDescriber> imageDescriber = feature::createImageDescriber(imageDescriberType);
+    const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
+
+#pragma omp parallel for
+    for(int i = 0; i < viewIds.size(); ++i)
+    {
+      const IndexT viewId = viewIds.at(i);
+
+      try
+      {
+        const std::unique_ptr<feature::Regions> regions = sfm::loadRegions(allFeaturesFolders, viewId, *imageDescriber);
+        const fs::path regionsPath = fs::path(outputFolder) / std::string(std::to_string(viewId) + "." + imageDescriberTypeName + feature::regionsBinaryFileExtension);
+        regions->SaveBinary(regionsPath.string(), sortByScale);
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_ERROR("Cannot convert " << imageDescriberTypeName << " regions of view " << viewId << ": " << e.what());
+        success = false;
+      }
+
+      ++progressDisplay;
+    }
+  }
+
+  if(!success)
+  {
+    ALICEVISION_LOG_ERROR("Some regions files cannot be converted.");
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_LOG_INFO("Binary regions files saved in '" << outputFolder << "'.");
+  return EXIT_SUCCESS;
+}
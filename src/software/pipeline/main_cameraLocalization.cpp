@@ -46,7 +46,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -99,6 +99,10 @@ int aliceVision_main(int argc, char** argv)
   std::string weightsFilepath;
   /// Number of previous frame of the sequence to use for matching
   std::size_t nbFrameBufferMatching = 10;
+  /// the localization map folder
+  std::string localizationMapFolder;
+  /// the memory budget of the reconstructed regions loaded from the localization map (in MB)
+  std::size_t localizationMapCacheMemory = 2048;
   /// enable/disable the robust matching (geometric validation) when matching query image
   /// and databases images
   bool robustMatching = true;
@@ -190,6 +194,11 @@ int aliceVision_main(int argc, char** argv)
       ("robustMatching", po::value<bool>(&robustMatching)->default_value(robustMatching), 
           "[voctree] Enable/Disable the robust matching between query and database images, "
           "all putative matches will be considered.")
+      ("localizationMap", po::value<std::string>(&localizationMapFolder)->default_value(localizationMapFolder),
+          "[voctree] Folder of the localization map. If it exists, the database and the "
+          "reconstructed regions are loaded on demand from it, otherwise it is created.")
+      ("localizationMapCacheMemory", po::value<std::size_t>(&localizationMapCacheMemory)->default_value(localizationMapCacheMemory),
+          "[voctree] Memory budget (in MB) of the reconstructed regions loaded from the localization map.")
 // cctag specific options
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
       ("nNearestKeyFrames", po::value<size_t>(&nNearestKeyFrames)->default_value(nNearestKeyFrames), 
@@ -321,7 +330,9 @@ int aliceVision_main(int argc, char** argv)
                                                    descriptorsFolder,
                                                    vocTreeFilepath,
                                                    weightsFilepath,
-                                                   matchDescTypes);
+                                                   matchDescTypes,
+                                                   localizationMapFolder,
+                                                   localizationMapCacheMemory * 1024 * 1024);
 
     localizer.reset(tmpLoc);
     
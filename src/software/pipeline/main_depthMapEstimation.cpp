@@ -87,7 +87,7 @@ int aliceVision_main(int argc, char* argv[])
     bool exportIntermediateTopographicCutVolumes = false;
     bool exportIntermediateVolume9pCsv = false;
 
-    // number of GPUs to use (0 means use all GPUs)
+    // number of GPUs to use (0 means use all GPUs, -1 means CPU only)
     int nbGPUs = 0;
 
     po::options_description requiredParams("Required parameters");
@@ -215,7 +215,7 @@ int aliceVision_main(int argc, char* argv[])
         ("exportTilePattern", po::value<bool>(&depthMapParams.exportTilePattern)->default_value(depthMapParams.exportTilePattern),
             "Export workflow tile pattern.")
         ("nbGPUs", po::value<int>(&nbGPUs)->default_value(nbGPUs),
-            "Number of GPUs to use (0 means use all GPUs).");
+            "Number of GPUs to use (0 means use all GPUs, -1 means use the CPU backend only).");
 
     CmdLine cmdline("Dense Reconstruction.\n"
                     "This program estimate a depth map for each input calibrated camera using Plane Sweeping, a multi-view stereo algorithm notable for its efficiency on modern graphics hardware (GPU).\n"
@@ -245,10 +245,11 @@ int aliceVision_main(int argc, char* argv[])
     ALICEVISION_LOG_INFO(gpu::gpuInformationCUDA());
 
     // check if the gpu suppport CUDA compute capability 2.0
-    if(!gpu::gpuSupportCUDA(2,0))
+    // otherwise, fall back to the CPU backend
+    if(nbGPUs >= 0 && !gpu::gpuSupportCUDA(2,0))
     {
-      ALICEVISION_LOG_ERROR("This program needs a CUDA-Enabled GPU (with at least compute capability 2.0).");
-      return EXIT_FAILURE;
+      ALICEVISION_LOG_WARNING("No CUDA-Enabled GPU (with at least compute capability 2.0) found, use the CPU backend.");
+      nbGPUs = -1;
     }
 
     // check if the scale is correct
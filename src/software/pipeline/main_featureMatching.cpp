@@ -13,6 +13,7 @@
 #include <aliceVision/matching/matchesFiltering.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/feature/RegionsCache.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/matchingImageCollection/matchingCommon.hpp>
@@ -43,7 +44,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -115,8 +116,11 @@ int aliceVision_main(int argc, char **argv)
   bool useGridSort = true;
   bool exportDebugFiles = false;
   bool matchFromKnownCameraPoses = false;
-  const std::string fileExtension = "txt";
+  std::string fileExtension = "txt";
   int randomSeed = std::mt19937::default_seed;
+  std::string cascadeHashingCacheFolder;
+  bool streamingGeometricFiltering = false;
+  double streamingMemoryRatio = 0.5;
   double minRequired2DMotion = -1.0;
 
   po::options_description requiredParams("Required parameters");
@@ -143,8 +147,13 @@ int aliceVision_main(int argc, char **argv)
       "* CASCADE_HASHING_L2: L2 Cascade Hashing matching\n"
       "* FAST_CASCADE_HASHING_L2: L2 Cascade Hashing with precomputed hashed regions\n"
       "(faster than CASCADE_HASHING_L2 but use more memory)\n"
+      "* BRUTE_FORCE_BLOCKED_L2: L2 BruteForce matching computing the distance matrix by blocks\n"
+      "(faster than BRUTE_FORCE_L2 for exhaustive matching of small image sets)\n"
       "For Binary based descriptor:\n"
       "* BRUTE_FORCE_HAMMING: BruteForce Hamming matching")
+    ("cascadeHashingCacheFolder", po::value<std::string>(&cascadeHashingCacheFolder)->default_value(cascadeHashingCacheFolder),
+      "Folder of a persistent cache of the hashed descriptions used by FAST_CASCADE_HASHING_L2, "
+      "shared by the range iterations using the same random seed (disabled if empty).")
     ("geometricEstimator", po::value<robustEstimation::ERobustEstimator>(&geometricEstimator)->default_value(geometricEstimator),
       "Geometric estimator:\n"
       "* acransac: A-Contrario Ransac\n"
@@ -166,6 +175,11 @@ int aliceVision_main(int argc, char **argv)
       "Make sure that the matching process is symmetric (same matches for I->J than fo J->I).")
     ("matchFilePerImage", po::value<bool>(&matchFilePerImage)->default_value(matchFilePerImage),
       "Save matches in a separate file per image.")
+    ("matchesFileFormat", po::value<std::string>(&fileExtension)->default_value(fileExtension),
+      "Matches file format:\n"
+      "* txt: text file(s)\n"
+      "* bin: indexed binary file(s), all the range iterations append into the same file(s), "
+      "the first range iteration (rangeStart 0) replaces the file(s) of a previous run and should start before the other ones")
     ("distanceRatio", po::value<float>(&distRatio)->default_value(distRatio),
       "Distance ratio to discard non meaningful matches.")
     ("maxIteration", po::value<int>(&maxIteration)->default_value(maxIteration),
@@ -174,6 +188,11 @@ int aliceVision_main(int argc, char **argv)
       "Use matching grid sort.")
     ("minRequired2DMotion", po::value<double>(&minRequired2DMotion)->default_value(minRequired2DMotion),
       "A match is invalid if the 2d motion between the 2 points is less than a threshold (or -1 to disable this filter).")
+    ("streamingGeometricFiltering", po::value<bool>(&streamingGeometricFiltering)->default_value(streamingGeometricFiltering),
+      "Release the regions after the putative matching and reload them on demand during the geometric filtering, "
+      "with a bounded memory. The geometric matches are processed by batches of views.")
+    ("streamingMemoryRatio", po::value<double>(&streamingMemoryRatio)->default_value(streamingMemoryRatio),
+      "Ratio of the available memory used to cache the regions in streaming geometric filtering.")
     ("exportDebugFiles", po::value<bool>(&exportDebugFiles)->default_value(exportDebugFiles),
       "Export debug files (svg, dot).")
     ("maxMatches", po::value<std::size_t>(&numMatchesToKeep)->default_value(numMatchesToKeep),
@@ -199,11 +218,19 @@ int aliceVision_main(int argc, char **argv)
       return EXIT_FAILURE;
   }
 
+  if(fileExtension != "txt" && fileExtension != "bin")
+  {
+    ALICEVISION_LOG_ERROR("Invalid matches file format: " << fileExtension);
+    return EXIT_FAILURE;
+  }
+
   const double defaultLoRansacMatchingError = 20.0;
   if(!adjustRobustEstimatorThreshold(geometricEstimator, geometricErrorMax, defaultLoRansacMatchingError))
     return EXIT_FAILURE;
 
 
+  HardwareContext hwc = cmdline.getHardwareContext();
+
   std::mt19937 randomNumberGenerator(randomSeed == -1 ? std::random_device()() : randomSeed);
 
   // check and set input options
@@ -212,6 +239,14 @@ int aliceVision_main(int argc, char **argv)
     ALICEVISION_LOG_ERROR("Invalid output matches folder: " + matchesFolder);
     return EXIT_FAILURE;
   }
+
+  // binary matches files: the range chunks of a run append into the same file(s),
+  // the first chunk removes the files of a previous run before any chunk writes its matches
+  if(fileExtension == "bin" && rangeSize > 0 && rangeStart == 0)
+  {
+    removeMatchesFiles(matchesFolder, "matches.bin", matchFilePerImage);
+    removeMatchesFiles((fs::path(matchesFolder) / "putativeMatches").string(), "matches.bin", matchFilePerImage);
+  }
   
 
   const matchingImageCollection::EGeometricFilterType geometricFilterType = matchingImageCollection::EGeometricFilterType_stringToEnum(geometricFilterTypeName);
@@ -281,7 +316,7 @@ int aliceVision_main(int argc, char **argv)
 
   // allocate the right Matcher according the Matching requested method
   EMatcherType collectionMatcherType = EMatcherType_stringToEnum(nearestMatchingMethod);
-  std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(collectionMatcherType, distRatio, crossMatching);
+  std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(collectionMatcherType, distRatio, crossMatching, cascadeHashingCacheFolder);
 
   const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
 
@@ -377,7 +412,11 @@ int aliceVision_main(int argc, char **argv)
   // when a range is specified, generate a file prefix to reflect the current iteration (rangeStart/rangeSize)
   // => with matchFilePerImage: avoids overwriting files if a view is present in several iterations
   // => without matchFilePerImage: avoids overwriting the unique resulting file
-  const std::string filePrefix = rangeSize > 0 ? std::to_string(rangeStart/rangeSize) + "." : "";
+  // => with binary matches files: the range iterations append into the same file(s), no prefix needed
+  const std::string filePrefix = (rangeSize > 0 && fileExtension != "bin") ? std::to_string(rangeStart/rangeSize) + "." : "";
+  // binary matches files are replaced by a run without range, the range iterations append to them
+  // (the files of a previous run are removed by the first range iteration)
+  const bool appendMatches = (rangeSize > 0);
 
   ALICEVISION_LOG_INFO(std::to_string(mapPutativesMatches.size()) << " putative image pair matches");
 
@@ -386,7 +425,7 @@ int aliceVision_main(int argc, char **argv)
 
   // export putative matches
   if(savePutativeMatches)
-    Save(mapPutativesMatches, (fs::path(matchesFolder) / "putativeMatches").string(), fileExtension, matchFilePerImage, filePrefix);
+    Save(mapPutativesMatches, (fs::path(matchesFolder) / "putativeMatches").string(), fileExtension, matchFilePerImage, filePrefix, appendMatches);
 
   ALICEVISION_LOG_INFO("Task (Regions Matching) done in (s): " + std::to_string(timer.elapsed()));
 
@@ -429,9 +468,73 @@ int aliceVision_main(int argc, char **argv)
   
 
   matching::PairwiseMatches geometricMatches;
+  PairwiseMatches finalMatches;
+
+  // streaming mode: the regions are released and reloaded on demand by the geometric filtering,
+  // the filtered matches are written batch by batch
+  const bool streaming = streamingGeometricFiltering && (geometricFilterType != EGeometricFilterType::NO_FILTERING);
+  std::unique_ptr<feature::RegionsCache> regionsCache;
+
+  if(streaming)
+  {
+    regionPerView = RegionsPerView();
+
+    const std::size_t maxMemory = static_cast<std::size_t>(hwc.getMaxMemory() * streamingMemoryRatio);
+    ALICEVISION_LOG_INFO("Streaming geometric filtering with a regions memory budget of " << maxMemory / (1024 * 1024) << " MB.");
+    regionsCache.reset(new feature::RegionsCache(sfm::createRegionsLoader(sfmData, featuresFolders, describerTypes), maxMemory));
+  }
+
+  // grid filtering and export of the geometric matches of a batch of image pairs
+  bool firstBatch = true;
+  const auto processBatch = [&](PairwiseMatches& batchGeometricMatches, const feature::RegionsPerView& batchRegionsPerView)
+  {
+    if(geometricFilterType == EGeometricFilterType::ESSENTIAL_MATRIX)
+      removePoorlyOverlappingImagePairs(batchGeometricMatches, mapPutativesMatches, 0.3f, 50);
+
+    PairwiseMatches batchFinalMatches;
+    matchesGridFilteringForAllPairs(batchGeometricMatches, sfmData, batchRegionsPerView, useGridSort,
+                                    numMatchesToKeep, batchFinalMatches);
+
+    // binary matches files are appended batch by batch
+    if(fileExtension == "bin")
+    {
+      Save(batchFinalMatches, matchesFolder, fileExtension, matchFilePerImage, filePrefix, appendMatches || !firstBatch);
+      firstBatch = false;
+    }
+
+    geometricMatches.insert(std::make_move_iterator(batchGeometricMatches.begin()), std::make_move_iterator(batchGeometricMatches.end()));
+    finalMatches.insert(std::make_move_iterator(batchFinalMatches.begin()), std::make_move_iterator(batchFinalMatches.end()));
+  };
+
+  // robust model estimation of all the putative matches
+  const auto robustEstimation = [&](const auto& geometricFilter, double distanceRatio)
+  {
+    if(!streaming)
+    {
+      matchingImageCollection::robustModelEstimation(geometricMatches,
+        &sfmData,
+        regionPerView,
+        geometricFilter,
+        mapPutativesMatches,
+        randomNumberGenerator,
+        guidedMatching,
+        distanceRatio);
+      return true;
+    }
+    return matchingImageCollection::robustModelEstimationStreaming(*regionsCache,
+      &sfmData,
+      geometricFilter,
+      mapPutativesMatches,
+      randomNumberGenerator,
+      processBatch,
+      guidedMatching,
+      distanceRatio);
+  };
 
   ALICEVISION_LOG_INFO("Geometric filtering: using " << matchingImageCollection::EGeometricFilterType_enumToString(geometricFilterType));
 
+  bool geometricFilteringSuccess = true;
+
   switch(geometricFilterType)
   {
 
@@ -441,77 +544,58 @@ int aliceVision_main(int argc, char **argv)
 
     case EGeometricFilterType::FUNDAMENTAL_MATRIX:
     {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator),
-        mapPutativesMatches,
-        randomNumberGenerator,
-        guidedMatching);
+      geometricFilteringSuccess = robustEstimation(GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator), 0.6);
     }
     break;
 
   case EGeometricFilterType::FUNDAMENTAL_WITH_DISTORTION:
   {
-    matchingImageCollection::robustModelEstimation(geometricMatches,
-      &sfmData,
-      regionPerView,
-      GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator, true),
-      mapPutativesMatches,
-      randomNumberGenerator,
-      guidedMatching);
+    geometricFilteringSuccess = robustEstimation(GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator, true), 0.6);
   }
   break;
 
     case EGeometricFilterType::ESSENTIAL_MATRIX:
     {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_E_AC(geometricErrorMax, maxIteration),
-        mapPutativesMatches,
-        randomNumberGenerator,
-        guidedMatching);
+      geometricFilteringSuccess = robustEstimation(GeometricFilterMatrix_E_AC(geometricErrorMax, maxIteration), 0.6);
 
-      removePoorlyOverlappingImagePairs(geometricMatches, mapPutativesMatches, 0.3f, 50);
+      if(!streaming)
+        removePoorlyOverlappingImagePairs(geometricMatches, mapPutativesMatches, 0.3f, 50);
     }
     break;
 
     case EGeometricFilterType::HOMOGRAPHY_MATRIX:
     {
       const bool onlyGuidedMatching = true;
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_H_AC(geometricErrorMax, maxIteration),
-        mapPutativesMatches, randomNumberGenerator, guidedMatching,
+      geometricFilteringSuccess = robustEstimation(GeometricFilterMatrix_H_AC(geometricErrorMax, maxIteration),
         onlyGuidedMatching ? -1.0 : 0.6);
     }
     break;
 
     case EGeometricFilterType::HOMOGRAPHY_GROWING:
     {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_HGrowing(geometricErrorMax, maxIteration),
-        mapPutativesMatches,
-        randomNumberGenerator,
-        guidedMatching);
+      geometricFilteringSuccess = robustEstimation(GeometricFilterMatrix_HGrowing(geometricErrorMax, maxIteration), 0.6);
     }
     break;
   }
 
+  if(!geometricFilteringSuccess)
+  {
+    ALICEVISION_LOG_ERROR("Geometric filtering failed: cannot load the regions.");
+    return EXIT_FAILURE;
+  }
+
   ALICEVISION_LOG_INFO(std::to_string(geometricMatches.size()) + " geometric image pair matches:");
   for(const auto& matchGeo: geometricMatches)
     ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGeo.first.first) + ", " + std::to_string(matchGeo.first.second) + ") contains " + std::to_string(matchGeo.second.getNbAllMatches()) + " geometric matches.");
 
-  // grid filtering
-  ALICEVISION_LOG_INFO("Grid filtering");
+  // grid filtering (already done batch by batch in streaming mode)
+  if(!streaming)
+  {
+    ALICEVISION_LOG_INFO("Grid filtering");
 
-  PairwiseMatches finalMatches;
-  matchesGridFilteringForAllPairs(geometricMatches, sfmData, regionPerView, useGridSort,
-                                  numMatchesToKeep, finalMatches);
+    matchesGridFilteringForAllPairs(geometricMatches, sfmData, regionPerView, useGridSort,
+                                    numMatchesToKeep, finalMatches);
+  }
 
     ALICEVISION_LOG_INFO("After grid filtering:");
     for (const auto& matchGridFiltering: finalMatches)
@@ -523,8 +607,12 @@ int aliceVision_main(int argc, char **argv)
     }
 
   // export geometric filtered matches
-  ALICEVISION_LOG_INFO("Save geometric matches.");
-  Save(finalMatches, matchesFolder, fileExtension, matchFilePerImage, filePrefix);
+  // in streaming mode, binary matches files are already written
+  if(!streaming || fileExtension != "bin")
+  {
+    ALICEVISION_LOG_INFO("Save geometric matches.");
+    Save(finalMatches, matchesFolder, fileExtension, matchFilePerImage, filePrefix, appendMatches);
+  }
   ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
 
   // d. Export some statistics
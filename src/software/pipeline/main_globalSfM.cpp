@@ -46,6 +46,7 @@ int aliceVision_main(int argc, char **argv)
   sfm::ERotationAveragingMethod rotationAveragingMethod = sfm::ROTATION_AVERAGING_L2;
   sfm::ETranslationAveragingMethod translationAveragingMethod = sfm::TRANSLATION_AVERAGING_SOFTL1;
   bool lockAllIntrinsics = false;
+  sfm::EBundleAdjustmentSolver bundleAdjustmentSolver = sfm::EBundleAdjustmentSolver::CERES;
   int randomSeed = std::mt19937::default_seed;
 
   po::options_description requiredParams("Required parameters");
@@ -77,6 +78,8 @@ int aliceVision_main(int argc, char **argv)
       "* 3: L1 soft minimization")
     ("lockAllIntrinsics", po::value<bool>(&lockAllIntrinsics)->default_value(lockAllIntrinsics),
       "Force lock of all camera intrinsic parameters, so they will not be refined during Bundle Adjustment.")
+    ("bundleAdjustmentSolver", po::value<sfm::EBundleAdjustmentSolver>(&bundleAdjustmentSolver)->default_value(bundleAdjustmentSolver),
+      sfm::EBundleAdjustmentSolver_informations().c_str())
     ("randomSeed", po::value<int>(&randomSeed)->default_value(randomSeed),
       "This seed value will generate a sequence using a linear random generator. Set -1 to use a random seed.")
     ;
@@ -169,6 +172,7 @@ int aliceVision_main(int argc, char **argv)
 
   // configure reconstruction parameters
   sfmEngine.setLockAllIntrinsics(lockAllIntrinsics); // TODO: rename param
+  sfmEngine.setBundleAdjustmentSolver(bundleAdjustmentSolver);
 
   // configure motion averaging method
   sfmEngine.SetRotationAveragingMethod(sfm::ERotationAveragingMethod(rotationAveragingMethod));
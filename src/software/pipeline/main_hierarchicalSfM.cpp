@@ -0,0 +1,368 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2023 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/pipeline/regionsIO.hpp>
+#include <aliceVision/sfm/pipeline/hierarchical/ReconstructionEngine_hierarchical.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/main.hpp>
+#include <aliceVision/cmdline/cmdline.hpp>
+#include <aliceVision/types.hpp>
+#include <aliceVision/config.hpp>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Get the path of the input SfMData file of a cluster
+ */
+std::string getClusterInputPath(const std::string& clustersFolder, std::size_t clusterIndex)
+{
+  return (fs::path(clustersFolder) / (sfm::getClusterName(clusterIndex) + ".sfm")).string();
+}
+
+/**
+ * @brief Get the folder of the reconstruction of a cluster
+ */
+std::string getClusterFolder(const std::string& clustersFolder, std::size_t clusterIndex)
+{
+  return (fs::path(clustersFolder) / sfm::getClusterName(clusterIndex)).string();
+}
+
+/**
+ * @brief Get the number of clusters exported in the clusters folder
+ */
+std::size_t getNbClusters(const std::string& clustersFolder)
+{
+  std::size_t nbClusters = 0;
+  while(fs::exists(getClusterInputPath(clustersFolder, nbClusters)))
+    ++nbClusters;
+  return nbClusters;
+}
+
+int aliceVision_main(int argc, char **argv)
+{
+  // command-line parameters
+  std::string sfmDataFilename;
+  std::vector<std::string> featuresFolders;
+  std::vector<std::string> matchesFolders;
+  std::string outputSfM;
+
+  // user optional parameters
+  std::string step = "all";
+  std::string clustersFolder;
+  std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  int rangeStart = -1;
+  int rangeSize = 1;
+  int maxNbMatches = 0;
+  int minNbMatches = 0;
+  bool useOnlyMatchesFromInputFolder = false;
+  bool computeStructureColor = true;
+  int randomSeed = std::mt19937::default_seed;
+
+  sfm::ReconstructionEngine_hierarchical::Params params;
+  sfm::ReconstructionEngine_sequentialSfM::Params& sfmParams = params.sequentialParams;
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
+      "SfMData file.")
+    ("output,o", po::value<std::string>(&outputSfM)->required(),
+      "Path to the output SfMData file.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("step", po::value<std::string>(&step)->default_value(step),
+      "Step(s) of the reconstruction to run:\n"
+      "* all: partition, reconstruction of the clusters and merge in the same process\n"
+      "* partition: export the SfMData file of each cluster in the clusters folder\n"
+      "* reconstruct: reconstruct the clusters [rangeStart, rangeStart + rangeSize) exported in the clusters folder\n"
+      "* merge: merge the cluster reconstructions of the clusters folder in the output SfMData file")
+    ("clustersFolder", po::value<std::string>(&clustersFolder)->default_value(clustersFolder),
+      "Folder of the cluster files and reconstructions (default: 'clusters' folder next to the output SfMData file).")
+    ("featuresFolders,f", po::value<std::vector<std::string>>(&featuresFolders)->multitoken(),
+      "Path to folder(s) containing the extracted features.")
+    ("matchesFolders,m", po::value<std::vector<std::string>>(&matchesFolders)->multitoken(),
+      "Path to folder(s) in which computed matches are stored.")
+    ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
+      feature::EImageDescriberType_informations().c_str())
+    ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
+      "Range of clusters to reconstruct with the 'reconstruct' step: first cluster index (-1 for all the clusters).")
+    ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
+      "Range of clusters to reconstruct with the 'reconstruct' step: number of clusters.")
+    ("maxClusterSize", po::value<std::size_t>(&params.maxClusterSize)->default_value(params.maxClusterSize),
+      "Maximum number of images of a cluster before its extension with the overlapping images.")
+    ("clusterOverlap", po::value<double>(&params.clusterOverlap)->default_value(params.clusterOverlap),
+      "Ratio of images added to each cluster from its neighbour clusters to align the cluster reconstructions.")
+    ("minNbCommonViews", po::value<std::size_t>(&params.minNbCommonViews)->default_value(params.minNbCommonViews),
+      "Minimum number of common cameras to merge a cluster reconstruction.")
+    ("nbParallelClusters", po::value<int>(&params.nbParallelClusters)->default_value(params.nbParallelClusters),
+      "Number of clusters reconstructed at the same time with the 'all' step.")
+    ("maxNumberOfMatches", po::value<int>(&maxNbMatches)->default_value(maxNbMatches),
+      "Maximum number of matches per image pair (and per feature type). 0 means no limit.")
+    ("minNumberOfMatches", po::value<int>(&minNbMatches)->default_value(minNbMatches),
+      "Minimum number of matches per image pair (and per feature type). 0 means no limit.")
+    ("useOnlyMatchesFromInputFolder", po::value<bool>(&useOnlyMatchesFromInputFolder)->default_value(useOnlyMatchesFromInputFolder),
+      "Use only matches from the input matchesFolder parameter.\n"
+      "Matches folders previously added to the SfMData file will be ignored.")
+    ("minInputTrackLength", po::value<int>(&sfmParams.minInputTrackLength)->default_value(sfmParams.minInputTrackLength),
+      "Minimum track length in input of SfM.")
+    ("minAngleForTriangulation", po::value<double>(&sfmParams.minAngleForTriangulation)->default_value(sfmParams.minAngleForTriangulation),
+      "Minimum angle for triangulation.")
+    ("minAngleForLandmark", po::value<double>(&sfmParams.minAngleForLandmark)->default_value(sfmParams.minAngleForLandmark),
+      "Minimum angle for landmark.")
+    ("maxReprojectionError", po::value<double>(&sfmParams.maxReprojectionError)->default_value(sfmParams.maxReprojectionError),
+      "Maximum reprojection error.")
+    ("lockAllIntrinsics", po::value<bool>(&sfmParams.lockAllIntrinsics)->default_value(sfmParams.lockAllIntrinsics),
+      "Force lock of all camera intrinsic parameters, so they will not be refined during Bundle Adjustment.")
+    ("useLocalBA,l", po::value<bool>(&sfmParams.useLocalBundleAdjustment)->default_value(sfmParams.useLocalBundleAdjustment),
+      "Enable/Disable the Local bundle adjustment strategy in the reconstruction of the clusters.")
+    ("observationConstraint", po::value<EFeatureConstraint>(&sfmParams.featureConstraint)->default_value(sfmParams.featureConstraint),
+      "Use of an observation constraint : basic, scale the observation or use of the covariance.\n")
+    ("computeStructureColor", po::value<bool>(&computeStructureColor)->default_value(computeStructureColor),
+      "Compute each 3D point color.\n")
+    ("randomSeed", po::value<int>(&randomSeed)->default_value(randomSeed),
+      "This seed value will generate a sequence using a linear random generator. Set -1 to use a random seed.")
+    ;
+
+  CmdLine cmdline("Hierarchical reconstruction.\n"
+                  "This program partitions the scene in overlapping clusters, reconstructs each cluster with the incremental SfM "
+                  "and merges the cluster reconstructions with a final global bundle adjustment.\n"
+                  "AliceVision hierarchicalSfM");
+
+  cmdline.add(requiredParams);
+  cmdline.add(optionalParams);
+  if (!cmdline.execute(argc, argv))
+  {
+      return EXIT_FAILURE;
+  }
+
+  // set maxThreads
+  HardwareContext hwc = cmdline.getHardwareContext();
+  omp_set_num_threads(hwc.getMaxThreads());
+
+  if(step != "all" && step != "partition" && step != "reconstruct" && step != "merge")
+  {
+    ALICEVISION_LOG_ERROR("Invalid step: " << step);
+    return EXIT_FAILURE;
+  }
+
+  if(sfmParams.minNbObservationsForTriangulation < 2)
+    sfmParams.minNbObservationsForTriangulation = 0;
+
+  if(clustersFolder.empty())
+    clustersFolder = (fs::path(outputSfM).parent_path() / "clusters").string();
+
+  if(!fs::exists(clustersFolder))
+    fs::create_directories(clustersFolder);
+
+  // get imageDescriber type
+  const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
+
+  aliceVision::system::Timer timer;
+
+  // reconstruction of the exported clusters, each cluster is a standalone job
+  if(step == "reconstruct")
+  {
+    const std::size_t nbClusters = getNbClusters(clustersFolder);
+    std::size_t first = 0;
+    std::size_t last = nbClusters;
+
+    if(rangeStart != -1)
+    {
+      if(rangeStart < 0 || rangeSize < 0 || rangeStart >= nbClusters)
+      {
+        ALICEVISION_LOG_ERROR("Range is incorrect");
+        return EXIT_FAILURE;
+      }
+      first = rangeStart;
+      last = std::min(nbClusters, static_cast<std::size_t>(rangeStart + rangeSize));
+    }
+
+    // same base seed as the --step all reconstruction (see ReconstructionEngine::initRandomSeed)
+    std::mt19937 randomNumberGenerator(randomSeed == -1 ? std::random_device()() : randomSeed);
+    const std::uint32_t baseSeed = randomNumberGenerator();
+
+    for(std::size_t clusterIndex = first; clusterIndex < last; ++clusterIndex)
+    {
+      const std::string clusterFolder = getClusterFolder(clustersFolder, clusterIndex);
+      const std::string clusterOutputPath = (fs::path(clusterFolder) / "sfm.sfm").string();
+
+      // the merge must not use the reconstruction of a previous run if this one fails
+      fs::remove(clusterOutputPath);
+
+      sfmData::SfMData clusterSfMData;
+      if(!sfmDataIO::Load(clusterSfMData, getClusterInputPath(clustersFolder, clusterIndex), sfmDataIO::ESfMData::ALL))
+      {
+        ALICEVISION_LOG_ERROR("The cluster SfMData file '" << getClusterInputPath(clustersFolder, clusterIndex) << "' cannot be read.");
+        return EXIT_FAILURE;
+      }
+
+      feature::FeaturesPerView featuresPerView;
+      if(!sfm::loadFeaturesPerView(featuresPerView, clusterSfMData, featuresFolders, describerTypes))
+      {
+        ALICEVISION_LOG_ERROR("Invalid features.");
+        return EXIT_FAILURE;
+      }
+
+      matching::PairwiseMatches pairwiseMatches;
+      if(!sfm::loadPairwiseMatches(pairwiseMatches, clusterSfMData, matchesFolders, describerTypes, maxNbMatches, minNbMatches, useOnlyMatchesFromInputFolder))
+      {
+        ALICEVISION_LOG_ERROR("Unable to load matches.");
+        return EXIT_FAILURE;
+      }
+
+      sfmData::SfMData clusterReconstruction;
+
+      // the seed only depends on the cluster index, whatever the range of the job
+      if(!sfm::reconstructCluster(clusterSfMData, featuresPerView, pairwiseMatches, sfmParams, clusterFolder,
+                                  sfm::getClusterRandomSeed(baseSeed, clusterIndex), clusterReconstruction))
+      {
+        ALICEVISION_LOG_WARNING("The reconstruction of the cluster " << clusterIndex << " failed.");
+        continue;
+      }
+
+      sfmDataIO::Save(clusterReconstruction, clusterOutputPath, sfmDataIO::ESfMData::ALL);
+    }
+
+    ALICEVISION_LOG_INFO("Reconstruction of the clusters took (s): " + std::to_string(timer.elapsed()));
+    return EXIT_SUCCESS;
+  }
+
+  // load input SfMData scene
+  sfmData::SfMData sfmData;
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmDataFilename + "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  sfm::ReconstructionEngine_hierarchical sfmEngine(sfmData, params, clustersFolder);
+  sfmEngine.initRandomSeed(randomSeed);
+
+  feature::FeaturesPerView featuresPerView;
+  matching::PairwiseMatches pairwiseMatches;
+
+  if(step != "merge")
+  {
+    // features are only needed to reconstruct the clusters
+    if(step == "all" && !sfm::loadFeaturesPerView(featuresPerView, sfmData, featuresFolders, describerTypes))
+    {
+      ALICEVISION_LOG_ERROR("Invalid features.");
+      return EXIT_FAILURE;
+    }
+
+    if(!sfm::loadPairwiseMatches(pairwiseMatches, sfmData, matchesFolders, describerTypes, maxNbMatches, minNbMatches, useOnlyMatchesFromInputFolder))
+    {
+      ALICEVISION_LOG_ERROR("Unable to load matches.");
+      return EXIT_FAILURE;
+    }
+
+    sfmEngine.setFeatures(&featuresPerView);
+    sfmEngine.setMatches(&pairwiseMatches);
+  }
+
+  if(step == "partition")
+  {
+    const std::size_t nbClusters = sfmEngine.partition();
+
+    for(std::size_t clusterIndex = 0; clusterIndex < nbClusters; ++clusterIndex)
+    {
+      sfmData::SfMData clusterSfMData;
+      sfmEngine.getClusterSfMData(clusterIndex, clusterSfMData);
+      sfmDataIO::Save(clusterSfMData, getClusterInputPath(clustersFolder, clusterIndex), sfmDataIO::ESfMData::ALL);
+
+      // the reconstruction of a previous partition does not match the new cluster
+      fs::remove(fs::path(getClusterFolder(clustersFolder, clusterIndex)) / "sfm.sfm");
+    }
+
+    // remove the cluster files of a previous partition
+    for(std::size_t clusterIndex = nbClusters; fs::exists(getClusterInputPath(clustersFolder, clusterIndex)); ++clusterIndex)
+    {
+      fs::remove(getClusterInputPath(clustersFolder, clusterIndex));
+      fs::remove_all(getClusterFolder(clustersFolder, clusterIndex));
+    }
+
+    ALICEVISION_LOG_INFO("Partition in " << nbClusters << " clusters took (s): " + std::to_string(timer.elapsed()));
+    return EXIT_SUCCESS;
+  }
+
+  if(step == "merge")
+  {
+    const std::size_t nbClusters = getNbClusters(clustersFolder);
+    std::vector<sfmData::SfMData> clustersSfMData;
+
+    for(std::size_t clusterIndex = 0; clusterIndex < nbClusters; ++clusterIndex)
+    {
+      const std::string clusterPath = (fs::path(getClusterFolder(clustersFolder, clusterIndex)) / "sfm.sfm").string();
+
+      if(!fs::exists(clusterPath))
+      {
+        ALICEVISION_LOG_WARNING("No reconstruction for the cluster " << clusterIndex << ".");
+        continue;
+      }
+
+      clustersSfMData.emplace_back();
+      if(!sfmDataIO::Load(clustersSfMData.back(), clusterPath, sfmDataIO::ESfMData::ALL))
+      {
+        ALICEVISION_LOG_ERROR("The cluster SfMData file '" << clusterPath << "' cannot be read.");
+        return EXIT_FAILURE;
+      }
+    }
+
+    if(!sfmEngine.mergeClusters(clustersSfMData))
+      return EXIT_FAILURE;
+  }
+  else if(!sfmEngine.process())
+  {
+    return EXIT_FAILURE;
+  }
+
+  // set featuresFolders and matchesFolders relative paths
+  {
+    sfmEngine.getSfMData().addFeaturesFolders(featuresFolders);
+    sfmEngine.getSfMData().addMatchesFolders(matchesFolders);
+    sfmEngine.getSfMData().setAbsolutePath(outputSfM);
+  }
+
+  // get the color for the 3D points
+  if(computeStructureColor)
+    sfmEngine.colorize();
+
+  sfmEngine.retrieveMarkersId();
+
+  ALICEVISION_LOG_INFO("Structure from motion took (s): " + std::to_string(timer.elapsed()));
+
+  // export to disk computed scene
+  ALICEVISION_LOG_INFO("Export SfMData to disk: " + outputSfM);
+  sfmDataIO::Save(sfmEngine.getSfMData(), outputSfM, sfmDataIO::ESfMData::ALL);
+
+  ALICEVISION_LOG_INFO("Structure from Motion results:" << std::endl
+    << "\t- # input images: " << sfmEngine.getSfMData().getViews().size() << std::endl
+    << "\t- # cameras calibrated: " << sfmEngine.getSfMData().getValidViews().size() << std::endl
+    << "\t- # poses: " << sfmEngine.getSfMData().getPoses().size() << std::endl
+    << "\t- # landmarks: " << sfmEngine.getSfMData().getLandmarks().size());
+
+  return EXIT_SUCCESS;
+}
@@ -30,7 +30,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::voctree;
@@ -65,6 +65,13 @@ int aliceVision_main(int argc, char** argv)
   std::string weightsFilepath;
   /// flag for the optional weights file
   bool withWeights = false;
+  /// the filename of the persisted vocabulary tree databases
+  std::string databaseFilepath;
+  /// range of images to query
+  int rangeStart = -1;
+  int rangeSize = 0;
+  /// the partial pair lists of the ranges to merge
+  std::vector<std::string> partialPairLists;
 
 
   // multiple SfM parameters
@@ -109,7 +116,18 @@ int aliceVision_main(int argc, char** argv)
       "Input file path of the vocabulary tree. This file can be generated by 'createVoctree'. "
       "This software is intended to be used with a generic, pre-trained vocabulary tree.")
     ("weights,w", po::value<std::string>(&weightsFilepath)->default_value(weightsFilepath),
-      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.");
+      "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.")
+    ("databaseFile", po::value<std::string>(&databaseFilepath)->default_value(databaseFilepath),
+      "File path of the vocabulary tree databases. If the file exists, the databases are loaded from it, "
+      "otherwise they are built from the descriptors and saved to it. It allows to share the databases between "
+      "jobs querying different ranges of images (a job with an empty range only builds the databases).")
+    ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
+      "Range image index start. If set, only the images of the range are queried in the vocabulary tree "
+      "and the output file contains their partial pair list, to be merged with 'partialPairLists'.")
+    ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
+      "Range size.")
+    ("partialPairLists", po::value<std::vector<std::string>>(&partialPairLists)->multitoken(),
+      "Partial pair list files of all the ranges, merged instead of querying the vocabulary tree.");
 
   po::options_description multiSfMParams("Multiple SfM");
   multiSfMParams.add_options()
@@ -185,6 +203,59 @@ int aliceVision_main(int argc, char** argv)
           aliceVision::voctree::getListOfDescriptorFiles(sfmDataB, featuresFolders, descriptorsFilesB);
   }
 
+  // check if the output folder exists
+  const auto basePath = fs::path(outputFile).parent_path();
+  if(!basePath.empty() && !fs::exists(basePath))
+  {
+    // then create the missing folder
+    if(!fs::create_directories(basePath))
+    {
+      ALICEVISION_LOG_ERROR("Unable to create folders: " << basePath);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // query a range of the images in the vocabulary tree, the partial pair lists are merged by another job
+  if(rangeStart != -1)
+  {
+    if(rangeStart < 0 || rangeSize < 0)
+    {
+      ALICEVISION_LOG_ERROR("Range is incorrect");
+      return EXIT_FAILURE;
+    }
+
+    PairList allMatches;
+
+    if((method == EImageMatchingMethod::VOCABULARYTREE) ||
+       (method == EImageMatchingMethod::SEQUENTIAL_AND_VOCABULARYTREE))
+    {
+      if(databaseFilepath.empty())
+      {
+        ALICEVISION_LOG_ERROR("A database file is required to query a range of images.");
+        return EXIT_FAILURE;
+      }
+
+      std::map<IndexT, std::string> rangeDescriptorsFiles;
+      auto itBegin = descriptorsFilesA.begin();
+      std::advance(itBegin, std::min<std::size_t>(rangeStart, descriptorsFilesA.size()));
+      auto itEnd = itBegin;
+      std::advance(itEnd, std::min<std::size_t>(rangeSize, std::distance(itBegin, descriptorsFilesA.end())));
+      rangeDescriptorsFiles.insert(itBegin, itEnd);
+
+      ALICEVISION_LOG_INFO("Use VOCABULARYTREE matching on images [" << rangeStart << ", " << rangeStart + rangeDescriptorsFiles.size() << ").");
+      queryVocTree(allMatches, treeFilepath, withWeights, weightsFilepath, matchingMode, featuresFolders, sfmDataA, nbMaxDescriptors, sfmDataFilenameA, sfmDataB,
+                   sfmDataFilenameB, useMultiSfM, rangeDescriptorsFiles, numImageQuery, databaseFilepath);
+    }
+    else
+    {
+      ALICEVISION_LOG_INFO("The vocabulary tree is not used with the " << method << " method, nothing to query.");
+    }
+
+    savePairList(outputFile, allMatches);
+    ALICEVISION_LOG_INFO("Partial pair list exported in: " << outputFile);
+    return EXIT_SUCCESS;
+  }
+
   OrderedPairList selectedPairs;
 
   switch(method)
@@ -206,8 +277,11 @@ int aliceVision_main(int argc, char** argv)
     case EImageMatchingMethod::VOCABULARYTREE:
     {
       ALICEVISION_LOG_INFO("Use VOCABULARYTREE matching.");
-      conditionVocTree(treeFilepath, withWeights, weightsFilepath, matchingMode,featuresFolders, sfmDataA, nbMaxDescriptors, sfmDataFilenameA, sfmDataB,
-                       sfmDataFilenameB, useMultiSfM, descriptorsFilesA,  numImageQuery, selectedPairs);
+      if(!partialPairLists.empty())
+        mergePartialPairLists(partialPairLists, numImageQuery, selectedPairs);
+      else
+        conditionVocTree(treeFilepath, withWeights, weightsFilepath, matchingMode,featuresFolders, sfmDataA, nbMaxDescriptors, sfmDataFilenameA, sfmDataB,
+                         sfmDataFilenameB, useMultiSfM, descriptorsFilesA,  numImageQuery, selectedPairs, databaseFilepath);
       break;
     }
     case EImageMatchingMethod::SEQUENTIAL:
@@ -220,8 +294,11 @@ int aliceVision_main(int argc, char** argv)
     {
       ALICEVISION_LOG_INFO("Use SEQUENTIAL and VOCABULARYTREE matching.");
       generateSequentialMatches(sfmDataA, numImageQuerySequential, selectedPairs);
-      conditionVocTree(treeFilepath, withWeights, weightsFilepath, matchingMode,featuresFolders, sfmDataA, nbMaxDescriptors, sfmDataFilenameA, sfmDataB,
-                       sfmDataFilenameB, useMultiSfM, descriptorsFilesA,  numImageQuery, selectedPairs);
+      if(!partialPairLists.empty())
+        mergePartialPairLists(partialPairLists, numImageQuery, selectedPairs);
+      else
+        conditionVocTree(treeFilepath, withWeights, weightsFilepath, matchingMode,featuresFolders, sfmDataA, nbMaxDescriptors, sfmDataFilenameA, sfmDataB,
+                         sfmDataFilenameB, useMultiSfM, descriptorsFilesA,  numImageQuery, selectedPairs, databaseFilepath);
       break;
     }
     case EImageMatchingMethod::FRUSTUM:
@@ -246,18 +323,6 @@ int aliceVision_main(int argc, char** argv)
     }
   }
 
-  // check if the output folder exists
-  const auto basePath = fs::path(outputFile).parent_path();
-  if(!basePath.empty() && !fs::exists(basePath))
-  {
-    // then create the missing folder
-    if(!fs::create_directories(basePath))
-    {
-      ALICEVISION_LOG_ERROR("Unable to create folders: " << basePath);
-      return EXIT_FAILURE;
-    }
-  }
-
   {
     std::size_t nbImagePairs = 0;
     for(auto& it : selectedPairs)
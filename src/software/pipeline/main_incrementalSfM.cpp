@@ -166,6 +166,19 @@ int aliceVision_main(int argc, char **argv)
     ("bundleAdjustmentMaxOutliers", po::value<int>(&sfmParams.bundleAdjustmentMaxOutliers)->default_value(sfmParams.bundleAdjustmentMaxOutliers),
       "Threshold for the maximum number of outliers allowed at the end of a bundle adjustment iteration."
       "Using a negative value for this threshold will disable BA iterations.")
+    ("bundleAdjustmentSolver", po::value<EBundleAdjustmentSolver>(&sfmParams.bundleAdjustmentSolver)->default_value(sfmParams.bundleAdjustmentSolver),
+      EBundleAdjustmentSolver_informations().c_str())
+    ("usePersistentBundleAdjustment", po::value<bool>(&sfmParams.usePersistentBundleAdjustment)->default_value(sfmParams.usePersistentBundleAdjustment),
+      "Keep the bundle adjustment problem between the resection steps and only update the changed views and landmarks, "
+      "instead of rebuilding the whole problem at each bundle adjustment (ceres solver only).")
+    ("useSpeculativeResection", po::value<bool>(&sfmParams.useSpeculativeResection)->default_value(sfmParams.useSpeculativeResection),
+      "Resect each group of cameras in parallel against a snapshot of the scene, keep only the cameras consistent with the "
+      "already reconstructed points and perform a single bundle adjustment per group. The group size grows while the cameras are consistent.")
+    ("speculativeResectionMaxImagesPerGroup", po::value<std::size_t>(&sfmParams.speculativeResectionMaxImagesPerGroup)->default_value(sfmParams.speculativeResectionMaxImagesPerGroup),
+      "Maximum size of the adaptive groups of cameras of the speculative resection.")
+    ("speculativeResectionMinConsistency", po::value<double>(&sfmParams.speculativeResectionMinConsistency)->default_value(sfmParams.speculativeResectionMinConsistency),
+      "Minimum ratio of the resection inliers of a camera below the max reprojection error with its committed pose "
+      "to keep it in the reconstruction with the speculative resection.")
     ("localizerEstimator", po::value<robustEstimation::ERobustEstimator>(&sfmParams.localizerEstimator)->default_value(sfmParams.localizerEstimator),
       "Estimator type used to localize cameras (acransac (default), ransac, lsmeds, loransac, maxconsensus)")
     ("localizerEstimatorError", po::value<double>(&sfmParams.localizerEstimatorError)->default_value(0.0),
@@ -17,7 +17,7 @@
 #include <aliceVision/types.hpp>
 #include <aliceVision/config.hpp>
 
-#include <aliceVision/track/TracksBuilder.hpp>
+#include <aliceVision/track/FlatTracksBuilder.hpp>
 #include <aliceVision/track/trackIO.hpp>
 
 #include <boost/program_options.hpp>
@@ -112,7 +112,7 @@ int aliceVision_main(int argc, char** argv)
     }
 
     //Create tracks
-    track::TracksBuilder tracksBuilder;
+    track::FlatTracksBuilder tracksBuilder;
     ALICEVISION_LOG_INFO("Track building");
     tracksBuilder.build(pairwiseMatches);
 
@@ -7,6 +7,8 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/voctree/TreeBuilder.hpp>
+#include <aliceVision/voctree/MiniBatchTreeBuilder.hpp>
+#include <aliceVision/voctree/DescriptorsBlockFile.hpp>
 #include <aliceVision/voctree/Database.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
 #include <aliceVision/voctree/descriptorLoader.hpp>
@@ -18,16 +20,18 @@
 #include <Eigen/Core>
 
 #include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <chrono>
+#include <memory>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 static const int DIMENSION = 128;
 
@@ -35,6 +39,7 @@ using namespace aliceVision;
 
 //using namespace boost::accumulators;
 namespace po = boost::program_options;
+namespace fs = boost::filesystem;
 
 typedef aliceVision::feature::Descriptor<float, DIMENSION> DescriptorFloat;
 typedef aliceVision::feature::Descriptor<unsigned char, DIMENSION> DescriptorUChar;
@@ -53,6 +58,9 @@ int aliceVision_main(int argc, char** argv)
   std::uint32_t restart = 5;
   std::uint32_t LEVELS = 6;
   bool sanityCheck = true;
+  voctree::MiniBatchKmeansParams miniBatchParams;
+  miniBatchParams.batchSize = 0;
+  std::string workingFolder;
 
   po::options_description requiredParams("Required parameters");
   requiredParams.add_options()
@@ -67,7 +75,19 @@ int aliceVision_main(int argc, char** argv)
     (",k", po::value<uint32_t>(&K)->default_value(10), "The branching factor of the tree")
     ("restart,r", po::value<uint32_t>(&restart)->default_value(5), "Number of times that the kmean is launched for each cluster, the best solution is kept")
     (",L", po::value<uint32_t>(&LEVELS)->default_value(6), "Number of levels of the tree")
-    ("sanitycheck,s", po::value<bool>(&sanityCheck)->default_value(sanityCheck), "Perform a sanity check at the end of the creation of the vocabulary tree. The sanity check is a query to the database with the same documents/images useed to train the vocabulary tree");
+    ("sanitycheck,s", po::value<bool>(&sanityCheck)->default_value(sanityCheck), "Perform a sanity check at the end of the creation of the vocabulary tree. The sanity check is a query to the database with the same documents/images useed to train the vocabulary tree")
+    ("miniBatchSize", po::value<std::size_t>(&miniBatchParams.batchSize)->default_value(miniBatchParams.batchSize),
+      "Number of descriptors drawn at each iteration of a mini-batch k-means. "
+      "If 0, the tree is built in memory with the Lloyd k-means (see restart), "
+      "otherwise the descriptors are streamed from a block file and the tree is built by hierarchical mini-batch k-means.")
+    ("miniBatchIterations", po::value<std::size_t>(&miniBatchParams.nbIterations)->default_value(miniBatchParams.nbIterations),
+      "Number of mini-batch k-means iterations for each node of the tree.")
+    ("maxInMemoryDescriptors", po::value<std::size_t>(&miniBatchParams.maxInMemoryDescriptors)->default_value(miniBatchParams.maxInMemoryDescriptors),
+      "Mini-batch k-means: maximum number of descriptors of a subtree built in memory, larger nodes are partitioned on disk.")
+    ("workingFolder", po::value<std::string>(&workingFolder)->default_value(workingFolder),
+      "Mini-batch k-means: folder of the descriptors block file, of the partitions and of the checkpoints. "
+      "An interrupted build restarted with the same working folder resumes from its checkpoints. "
+      "By default, a folder next to the output tree file.");
 
   CmdLine cmdline("This program is used to load the sift descriptors from a SfMData file and create a vocabulary tree.\n"
                   "It takes as input either a list.txt file containing a simple list of images (bundler format and older AliceVision version format)\n"
@@ -88,15 +108,39 @@ int aliceVision_main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  const bool useMiniBatch = (miniBatchParams.batchSize > 0);
+  if(useMiniBatch && workingFolder.empty())
+    workingFolder = treeName + "_build";
+
   std::vector<DescriptorFloat> descriptors;
+  std::unique_ptr<voctree::DescriptorsBlockFile> descriptorsBlockFile;
 
   std::vector<size_t> descRead;
   ALICEVISION_COUT("Reading descriptors from " << sfmDataFilename);
   auto detect_start = std::chrono::steady_clock::now();
-  size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
+  size_t numTotDescriptors = 0;
+  if(useMiniBatch)
+  {
+    // the descriptors are concatenated in a block file once, and streamed from it
+    const std::string blockFilename = (fs::path(workingFolder) / "descriptors.bin").string();
+    if(!fs::exists(blockFilename))
+    {
+      std::map<IndexT, std::string> descriptorsFiles;
+      voctree::getListOfDescriptorFiles(sfmData, featuresFolders, descriptorsFiles);
+      fs::create_directories(workingFolder);
+      voctree::DescriptorsBlockFile::write<DescriptorUChar>(blockFilename, descriptorsFiles);
+    }
+    descriptorsBlockFile.reset(new voctree::DescriptorsBlockFile(blockFilename));
+    descRead = descriptorsBlockFile->nbDescriptorsPerImage();
+    numTotDescriptors = descriptorsBlockFile->size();
+  }
+  else
+  {
+    numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
+  }
   auto detect_end = std::chrono::steady_clock::now();
   auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-  if(descriptors.empty())
+  if(numTotDescriptors == 0)
   {
     ALICEVISION_CERR("No descriptors loaded!!");
     return EXIT_FAILURE;
@@ -107,21 +151,34 @@ int aliceVision_main(int argc, char** argv)
 
   // Create tree
   aliceVision::voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
+  aliceVision::voctree::TreeBuilder<DescriptorFloat>::Tree miniBatchTree;
   builder.setVerbose(tbVerbosity);
   builder.kmeans().setRestarts(restart);
   ALICEVISION_COUT("Building a tree of L=" << LEVELS << " levels with a branching factor of k=" << K);
   detect_start = std::chrono::steady_clock::now();
-  builder.build(descriptors, K, LEVELS);
+  if(useMiniBatch)
+  {
+    voctree::MiniBatchTreeBuilder miniBatchBuilder(miniBatchParams);
+    miniBatchBuilder.build(descriptorsBlockFile->filename(), K, LEVELS, workingFolder);
+    miniBatchBuilder.getTree(miniBatchTree);
+  }
+  else
+  {
+    builder.build(descriptors, K, LEVELS);
+  }
+  const auto& tree = useMiniBatch ? miniBatchTree : builder.tree();
   detect_end = std::chrono::steady_clock::now();
   detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
   ALICEVISION_COUT("Tree created in " << ((float) detect_elapsed.count()) / 1000 << " sec");
-  ALICEVISION_COUT(builder.tree().centers().size() << " centers");
+  ALICEVISION_COUT(tree.centers().size() << " centers");
   ALICEVISION_COUT("Saving vocabulary tree as " << treeName);
-  builder.tree().save(treeName);
+  tree.save(treeName);
 
   aliceVision::voctree::SparseHistogramPerImage allSparseHistograms;
   // temporary vector used to save all the visual word for each image before adding them to documents
   std::vector<aliceVision::voctree::Word> imgVisualWords;
+  // descriptors of the current image, in mini-batch mode
+  std::vector<DescriptorUChar> imageDescriptors;
   ALICEVISION_COUT("Quantizing the features");
   size_t offset = 0; ///< this is used to align to the features of a given image in 'feature'
   detect_start = std::chrono::steady_clock::now();
@@ -135,11 +192,18 @@ int aliceVision_main(int argc, char** argv)
     // allocate as many visual words as the number of the features in the image
     imgVisualWords.resize(descRead[i], 0);
 
+    if(useMiniBatch)
+    {
+      imageDescriptors.resize(descRead[i]);
+      if(!imageDescriptors.empty())
+        descriptorsBlockFile->read(offset, descRead[i], imageDescriptors.front().getData());
+    }
+
     #pragma omp parallel for
     for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(descRead[i]); ++j)
     {
       //	store the visual word associated to the feature in the temporary list
-      imgVisualWords[j] = builder.tree().quantize(descriptors[ j + offset ]);
+      imgVisualWords[j] = useMiniBatch ? tree.quantize(imageDescriptors[j]) : tree.quantize(descriptors[ j + offset ]);
     }
     aliceVision::voctree::SparseHistogram histo;
     aliceVision::voctree::computeSparseHistogram(imgVisualWords, histo);
@@ -156,7 +220,7 @@ int aliceVision_main(int argc, char** argv)
 
   ALICEVISION_COUT("Creating the database...");
   // Add each object (document) to the database
-  aliceVision::voctree::Database db(builder.tree().words());
+  aliceVision::voctree::Database db(tree.words());
   ALICEVISION_COUT("\tfound " << allSparseHistograms.size() << " documents");
   for(const auto &doc : allSparseHistograms)
   {